@@ -0,0 +1,191 @@
+/**
+ * @file auth_session.c
+ * @brief Session tokens, cookie parsing and constant-time checks (host-testable)
+ */
+
+#include "auth_session.h"
+#include "mbedtls/md.h"
+#include <stdio.h>
+#include <string.h>
+
+bool auth_equal(const void *a, const void *b, size_t len)
+{
+    const volatile uint8_t *pa = a;
+    const volatile uint8_t *pb = b;
+    uint8_t diff = 0;
+    for (size_t i = 0; i < len; i++) {
+        diff |= pa[i] ^ pb[i];
+    }
+    return diff == 0;
+}
+
+bool auth_secret_equal(const char *given, const char *secret)
+{
+    size_t secret_len = strlen(secret);
+    size_t given_len = strnlen(given, secret_len + 1);
+    if (secret_len == 0) {
+        return false;
+    }
+
+    /* Always scan the whole secret; bytes past the end of a short input
+       compare against its terminator and the length check fails anyway */
+    uint8_t diff = given_len != secret_len;
+    for (size_t i = 0; i < secret_len; i++) {
+        char c = i < given_len ? given[i] : '\0';
+        diff |= (uint8_t)(c ^ secret[i]);
+    }
+    return diff == 0;
+}
+
+int auth_cookie_value(const char *header, const char *name, char *out, size_t size)
+{
+    size_t name_len = strlen(name);
+    const char *pos = header;
+
+    while (*pos != '\0') {
+        while (*pos == ' ' || *pos == ';') {
+            pos++;
+        }
+        const char *end = strchr(pos, ';');
+        size_t pair_len = end ? (size_t)(end - pos) : strlen(pos);
+
+        if (pair_len > name_len && pos[name_len] == '=' && strncmp(pos, name, name_len) == 0) {
+            size_t value_len = pair_len - name_len - 1;
+            while (value_len > 0 && pos[name_len + value_len] == ' ') {
+                value_len--;
+            }
+            if (value_len >= size) {
+                return -1;
+            }
+            memcpy(out, pos + name_len + 1, value_len);
+            out[value_len] = '\0';
+            return (int)value_len;
+        }
+        pos += pair_len;
+    }
+    return -1;
+}
+
+/**
+ * @brief Bucket of a token (FNV-1a; tokens are random, so any mix will do)
+ */
+static auth_session_t *bucket_of(auth_sessions_t *table, const char *token)
+{
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < AUTH_TOKEN_LEN && token[i] != '\0'; i++) {
+        hash = (hash ^ (uint8_t)token[i]) * 16777619u;
+    }
+    return table->ways[hash % AUTH_SESSION_BUCKETS];
+}
+
+/**
+ * @brief Find a token in its bucket, comparing every way in constant time
+ */
+static auth_session_t *find(auth_sessions_t *table, const char *token)
+{
+    if (strnlen(token, AUTH_TOKEN_LEN + 1) != AUTH_TOKEN_LEN) {
+        return NULL;
+    }
+    auth_session_t *ways = bucket_of(table, token);
+    auth_session_t *match = NULL;
+    for (int i = 0; i < AUTH_SESSION_WAYS; i++) {
+        if (auth_equal(ways[i].token, token, AUTH_TOKEN_LEN)) {
+            match = &ways[i];
+        }
+    }
+    return match;
+}
+
+void auth_sessions_clear(auth_sessions_t *table)
+{
+    memset(table, 0, sizeof(*table));
+}
+
+void auth_sessions_add(auth_sessions_t *table, const char *token, int64_t expiry, int64_t now)
+{
+    auth_session_t *ways = bucket_of(table, token);
+    auth_session_t *slot = &ways[0];
+    for (int i = 0; i < AUTH_SESSION_WAYS; i++) {
+        if (ways[i].token[0] == '\0' || now > ways[i].expiry) {
+            slot = &ways[i];
+            break;
+        }
+        if (ways[i].expiry < slot->expiry) {
+            slot = &ways[i];
+        }
+    }
+    memcpy(slot->token, token, AUTH_TOKEN_LEN);
+    slot->token[AUTH_TOKEN_LEN] = '\0';
+    slot->expiry = expiry;
+}
+
+bool auth_sessions_check(auth_sessions_t *table, const char *token, int64_t now)
+{
+    auth_session_t *session = find(table, token);
+    if (session == NULL) {
+        return false;
+    }
+    if (now > session->expiry) {
+        session->token[0] = '\0';
+        return false;
+    }
+    return true;
+}
+
+bool auth_sessions_remove(auth_sessions_t *table, const char *token)
+{
+    auth_session_t *session = find(table, token);
+    if (session == NULL) {
+        return false;
+    }
+    session->token[0] = '\0';
+    return true;
+}
+
+/**
+ * @brief Hex tag over the expiry field (first 8 characters of the token)
+ */
+static void token_tag(const uint8_t key[AUTH_SIGNING_KEY_SIZE], const char *expiry_hex, char *out)
+{
+    uint8_t mac[32];    /* HMAC-SHA256 */
+    mbedtls_md_hmac(mbedtls_md_info_from_type(MBEDTLS_MD_SHA256), key, AUTH_SIGNING_KEY_SIZE,
+                    (const unsigned char *)expiry_hex, 8, mac);
+
+    static const char hex[] = "0123456789abcdef";
+    for (int i = 0; i < (AUTH_SIGNED_TOKEN_LEN - 8) / 2; i++) {
+        out[i * 2] = hex[mac[i] >> 4];
+        out[i * 2 + 1] = hex[mac[i] & 0x0F];
+    }
+}
+
+void auth_token_sign(const uint8_t key[AUTH_SIGNING_KEY_SIZE], uint32_t expiry, char *out)
+{
+    snprintf(out, AUTH_TOKEN_BUF_SIZE, "%08lx", (unsigned long)expiry);
+    token_tag(key, out, out + 8);
+    out[AUTH_SIGNED_TOKEN_LEN] = '\0';
+}
+
+bool auth_token_verify(const uint8_t key[AUTH_SIGNING_KEY_SIZE], const char *token, uint32_t now)
+{
+    if (strnlen(token, AUTH_SIGNED_TOKEN_LEN + 1) != AUTH_SIGNED_TOKEN_LEN) {
+        return false;
+    }
+
+    uint32_t expiry = 0;
+    for (int i = 0; i < 8; i++) {
+        char c = token[i];
+        uint32_t digit;
+        if (c >= '0' && c <= '9') {
+            digit = c - '0';
+        } else if (c >= 'a' && c <= 'f') {
+            digit = c - 'a' + 10;
+        } else {
+            return false;
+        }
+        expiry = (expiry << 4) | digit;
+    }
+
+    char tag[AUTH_SIGNED_TOKEN_LEN - 8];
+    token_tag(key, token, tag);
+    return auth_equal(tag, token + 8, sizeof(tag)) && now <= expiry;
+}
@@ -0,0 +1,97 @@
+/**
+ * @file auth_session.h
+ * @brief Session tokens, cookie parsing and constant-time checks (host-testable)
+ *
+ * Sessions live in a small set-associative table: a token hashes to one
+ * bucket and only that bucket's ways are compared, so a lookup costs the
+ * same however many sessions exist. Expired entries are dropped lazily
+ * when they are looked up or their slot is needed.
+ *
+ * Signed tokens carry their own expiry and an HMAC-SHA256 tag over it,
+ * so they are validated without any table at all.
+ */
+
+#ifndef AUTH_SESSION_H
+#define AUTH_SESSION_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define AUTH_SESSION_BUCKETS 8
+#define AUTH_SESSION_WAYS 4
+
+/** @brief Random session token: 128 bits as hex */
+#define AUTH_TOKEN_LEN 32
+
+/** @brief Signed token: 8 hex digits of expiry + 128-bit tag as hex */
+#define AUTH_SIGNED_TOKEN_LEN 40
+
+/** @brief Buffer size for any token */
+#define AUTH_TOKEN_BUF_SIZE (AUTH_SIGNED_TOKEN_LEN + 1)
+
+#define AUTH_SIGNING_KEY_SIZE 32
+
+typedef struct {
+    char token[AUTH_TOKEN_LEN + 1];     /**< Empty when the way is free */
+    int64_t expiry;                     /**< Same clock as "now" arguments */
+} auth_session_t;
+
+typedef struct {
+    auth_session_t ways[AUTH_SESSION_BUCKETS][AUTH_SESSION_WAYS];
+} auth_sessions_t;
+
+/**
+ * @brief Compare two buffers in time independent of their contents
+ */
+bool auth_equal(const void *a, const void *b, size_t len);
+
+/**
+ * @brief Check a presented secret against the configured one
+ *
+ * Runs in time that depends only on the configured secret's length.
+ * An empty configured secret never matches.
+ */
+bool auth_secret_equal(const char *given, const char *secret);
+
+/**
+ * @brief Extract a cookie value from a Cookie header
+ *
+ * @return Value length, or -1 if the cookie is absent or does not fit
+ */
+int auth_cookie_value(const char *header, const char *name, char *out, size_t size);
+
+void auth_sessions_clear(auth_sessions_t *table);
+
+/**
+ * @brief Store a session token (AUTH_TOKEN_LEN chars)
+ *
+ * Uses a free or expired way of the token's bucket, otherwise replaces
+ * the session there that expires first.
+ */
+void auth_sessions_add(auth_sessions_t *table, const char *token, int64_t expiry, int64_t now);
+
+/**
+ * @brief Check a token; an expired match is removed
+ */
+bool auth_sessions_check(auth_sessions_t *table, const char *token, int64_t now);
+
+/**
+ * @brief Remove a token (logout)
+ * @return true if it was present
+ */
+bool auth_sessions_remove(auth_sessions_t *table, const char *token);
+
+/**
+ * @brief Build a signed token valid until expiry
+ * @param out Buffer of at least AUTH_TOKEN_BUF_SIZE bytes
+ */
+void auth_token_sign(const uint8_t key[AUTH_SIGNING_KEY_SIZE], uint32_t expiry, char *out);
+
+/**
+ * @brief Validate a signed token
+ * @return true if the tag matches and now has not passed its expiry
+ */
+bool auth_token_verify(const uint8_t key[AUTH_SIGNING_KEY_SIZE], const char *token, uint32_t now);
+
+#endif /* AUTH_SESSION_H */
@@ -0,0 +1,147 @@
+/**
+ * @file boot_health.c
+ * @brief Post-update boot health check and per-version boot metrics (host-testable)
+ */
+
+#include "boot_health.h"
+#include <string.h>
+
+/* 0 means "not reached", so a milestone at power-on is stored as 1 ms */
+static void mark(uint32_t *milestone, uint32_t now_ms)
+{
+    if (*milestone == 0) {
+        *milestone = now_ms ? now_ms : 1;
+    }
+}
+
+void boot_health_init(boot_health_t *h, uint32_t budget_ms, uint16_t expected_sensors,
+                      uint8_t min_sensor_pct, bool require_mqtt)
+{
+    memset(h, 0, sizeof(*h));
+    h->budget_ms = budget_ms;
+    h->expected_sensors = expected_sensors;
+    h->min_sensor_pct = min_sensor_pct > 100 ? 100 : min_sensor_pct;
+    h->require_mqtt = require_mqtt;
+}
+
+uint16_t boot_health_required_sensors(const boot_health_t *h)
+{
+    if (h->expected_sensors == 0) {
+        return 0;
+    }
+    /* One unplugged or flaky sensor must not roll back every update */
+    uint32_t required = ((uint32_t)h->expected_sensors * h->min_sensor_pct + 99) / 100;
+    return required > 0 ? (uint16_t)required : 1;
+}
+
+void boot_health_scanned(boot_health_t *h, uint32_t now_ms, uint16_t sensors_found)
+{
+    if (h->scan_ms == 0) {
+        h->sensors_found = sensors_found;
+        mark(&h->scan_ms, now_ms);
+    }
+}
+
+void boot_health_cycle(boot_health_t *h, uint32_t now_ms, uint16_t valid)
+{
+    if (valid > 0 || (h->scan_ms != 0 && h->sensors_found == 0)) {
+        mark(&h->first_cycle_ms, now_ms);
+    }
+}
+
+void boot_health_network_up(boot_health_t *h, uint32_t now_ms)
+{
+    mark(&h->network_ms, now_ms);
+}
+
+void boot_health_mqtt_connected(boot_health_t *h, uint32_t now_ms)
+{
+    mark(&h->mqtt_ms, now_ms);
+}
+
+void boot_health_published(boot_health_t *h, uint32_t now_ms)
+{
+    mark(&h->first_publish_ms, now_ms);
+}
+
+const char *boot_health_missing(const boot_health_t *h)
+{
+    if (h->scan_ms == 0 || h->sensors_found < boot_health_required_sensors(h)) {
+        return "sensors";
+    }
+    if (h->first_cycle_ms == 0) {
+        return "reading";
+    }
+    if (h->network_ms == 0) {
+        return "network";
+    }
+    if (h->require_mqtt && h->mqtt_ms == 0) {
+        return "mqtt";
+    }
+    return NULL;
+}
+
+boot_health_verdict_t boot_health_evaluate(const boot_health_t *h, uint32_t now_ms)
+{
+    if (boot_health_missing(h) == NULL) {
+        return BOOT_HEALTH_PASSED;
+    }
+    return (now_ms >= h->budget_ms) ? BOOT_HEALTH_FAILED : BOOT_HEALTH_PENDING;
+}
+
+/* ===== Metrics ===== */
+
+uint16_t boot_metrics_expected_sensors(const boot_metrics_t *m)
+{
+    return (m->entries[0].boots > 0) ? m->entries[0].sensors : 0;
+}
+
+const boot_metrics_entry_t *boot_metrics_find(const boot_metrics_t *m, const char *version)
+{
+    for (int i = 0; i < BOOT_METRICS_VERSIONS; i++) {
+        const boot_metrics_entry_t *e = &m->entries[i];
+        if (e->boots > 0 && strncmp(e->version, version, sizeof(e->version) - 1) == 0) {
+            return e;
+        }
+    }
+    return NULL;
+}
+
+static void average(uint32_t *avg_ms, uint16_t *count, uint32_t sample_ms)
+{
+    if (sample_ms == 0) {
+        return;
+    }
+    if (*count < UINT16_MAX) {
+        (*count)++;
+    }
+    *avg_ms = (uint32_t)((int64_t)*avg_ms + ((int64_t)sample_ms - *avg_ms) / *count);
+}
+
+void boot_metrics_record(boot_metrics_t *m, const char *version, const boot_health_t *h, bool healthy)
+{
+    /* Take the version's slot (or the oldest) out and shift the newer ones down */
+    const boot_metrics_entry_t *found = boot_metrics_find(m, version);
+    int slot = found ? (int)(found - m->entries) : BOOT_METRICS_VERSIONS - 1;
+    boot_metrics_entry_t e = m->entries[slot];
+    memmove(&m->entries[1], &m->entries[0], (size_t)slot * sizeof(e));
+    if (found == NULL) {
+        memset(&e, 0, sizeof(e));
+        strncpy(e.version, version, sizeof(e.version) - 1);
+    }
+
+    if (e.boots < UINT16_MAX) {
+        e.boots++;
+    }
+    if (!healthy && e.failed < UINT16_MAX) {
+        e.failed++;
+    }
+    if (h->scan_ms != 0) {
+        e.sensors = h->sensors_found;
+    }
+    e.last_reading_ms = h->first_cycle_ms;
+    e.last_publish_ms = h->first_publish_ms;
+    average(&e.reading_avg_ms, &e.reading_count, h->first_cycle_ms);
+    average(&e.publish_avg_ms, &e.publish_count, h->first_publish_ms);
+    m->entries[0] = e;
+}
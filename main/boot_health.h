@@ -0,0 +1,118 @@
+/**
+ * @file boot_health.h
+ * @brief Post-update boot health check and per-version boot metrics (host-testable)
+ *
+ * A freshly installed image has to prove itself before it is marked valid:
+ * the bus scan must find a share of the sensors the previous boot found
+ * (at least one if it found any), one acquisition cycle must complete
+ * (with a valid reading if there are sensors), the network must come up and, unless disabled,
+ * MQTT must connect, all within a time budget from power-on. Milestones
+ * are fed in as they happen; the verdict is PASSED as soon as all are
+ * met and FAILED once the budget runs out.
+ *
+ * The metrics table keeps boot counts and time to first reading / first
+ * publish for the last few image versions, newest first. Not thread-safe.
+ */
+
+#ifndef BOOT_HEALTH_H
+#define BOOT_HEALTH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define BOOT_METRICS_VERSIONS 4
+#define BOOT_METRICS_VERSION_MAX 16     /**< Including the terminator */
+
+typedef enum {
+    BOOT_HEALTH_PENDING = 0,
+    BOOT_HEALTH_PASSED,
+    BOOT_HEALTH_FAILED,
+} boot_health_verdict_t;
+
+/**
+ * @brief Milestones of one boot, in ms since power-on (0 = not reached)
+ */
+typedef struct {
+    uint32_t budget_ms;
+    uint16_t expected_sensors;  /**< Found by the previous boot */
+    uint8_t min_sensor_pct;     /**< Share of expected_sensors the scan must find */
+    bool require_mqtt;
+    uint16_t sensors_found;
+    uint32_t scan_ms;
+    uint32_t first_cycle_ms;    /**< First acquisition cycle that counts */
+    uint32_t network_ms;
+    uint32_t mqtt_ms;
+    uint32_t first_publish_ms;
+} boot_health_t;
+
+typedef struct {
+    char version[BOOT_METRICS_VERSION_MAX];
+    uint16_t boots;
+    uint16_t failed;            /**< Boots that failed the health check */
+    uint16_t sensors;           /**< Found on the last counted boot */
+    uint16_t reading_count;     /**< Boots that reached a first reading */
+    uint16_t publish_count;     /**< Boots that reached a first publish */
+    uint32_t reading_avg_ms;    /**< Running mean over reading_count boots */
+    uint32_t publish_avg_ms;
+    uint32_t last_reading_ms;   /**< 0 = not reached on the last boot */
+    uint32_t last_publish_ms;
+} boot_metrics_entry_t;
+
+/**
+ * @brief Metrics per image version, newest first (stored as a blob)
+ */
+typedef struct {
+    boot_metrics_entry_t entries[BOOT_METRICS_VERSIONS];
+} boot_metrics_t;
+
+/**
+ * @param min_sensor_pct Percentage of expected_sensors the scan must find,
+ *                       rounded up; at least one sensor is always required
+ *                       when expected_sensors is non-zero
+ */
+void boot_health_init(boot_health_t *h, uint32_t budget_ms, uint16_t expected_sensors,
+                      uint8_t min_sensor_pct, bool require_mqtt);
+
+/**
+ * @brief Sensors the scan must find for the check to pass
+ */
+uint16_t boot_health_required_sensors(const boot_health_t *h);
+
+/* Milestones; only the first call of each is kept */
+void boot_health_scanned(boot_health_t *h, uint32_t now_ms, uint16_t sensors_found);
+
+/**
+ * @brief An acquisition cycle completed
+ * @param valid Sensors that returned a valid reading; the cycle only counts
+ *              if this is non-zero or no sensors were found
+ */
+void boot_health_cycle(boot_health_t *h, uint32_t now_ms, uint16_t valid);
+void boot_health_network_up(boot_health_t *h, uint32_t now_ms);
+void boot_health_mqtt_connected(boot_health_t *h, uint32_t now_ms);
+void boot_health_published(boot_health_t *h, uint32_t now_ms);
+
+boot_health_verdict_t boot_health_evaluate(const boot_health_t *h, uint32_t now_ms);
+
+/**
+ * @brief First requirement not met, for logs ("sensors", "reading", "network", "mqtt"), or NULL
+ */
+const char *boot_health_missing(const boot_health_t *h);
+
+/**
+ * @brief Sensor count the next boot must reach: what the most recently recorded boot found
+ */
+uint16_t boot_metrics_expected_sensors(const boot_metrics_t *m);
+
+/**
+ * @brief Count one boot of a version, moving it to the front (the oldest version is dropped)
+ *
+ * @param healthy false if the boot failed the health check
+ */
+void boot_metrics_record(boot_metrics_t *m, const char *version, const boot_health_t *h, bool healthy);
+
+/**
+ * @brief Look up a version, NULL if not in the table
+ */
+const boot_metrics_entry_t *boot_metrics_find(const boot_metrics_t *m, const char *version);
+
+#endif /* BOOT_HEALTH_H */
@@ -0,0 +1,213 @@
+/**
+ * @file boot_monitor.c
+ * @brief Boot health check after an update: mark the image valid or roll back
+ */
+
+#include "boot_monitor.h"
+#include "nvs_storage.h"
+#include "mqtt_client_ha.h"
+#include "esp_log.h"
+#include "esp_ota_ops.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include <stdio.h>
+#include <string.h>
+
+static const char *TAG = "boot_monitor";
+
+extern const char *APP_VERSION;
+
+#define POLL_MS 500
+
+#if CONFIG_BOOT_HEALTH_REQUIRE_MQTT
+#define REQUIRE_MQTT true
+#else
+#define REQUIRE_MQTT false
+#endif
+
+/* Milestones are set from several tasks, read by the monitor and the web server */
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static boot_health_t s_health;
+static boot_health_verdict_t s_verdict = BOOT_HEALTH_PENDING;
+static boot_metrics_t s_metrics;
+static bool s_on_trial = false;
+static char s_rolled_back_from[BOOT_METRICS_VERSION_MAX];
+
+static uint32_t now_ms(void)
+{
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+/**
+ * @brief Count this boot in the per-version metrics and save them
+ */
+static void record_boot(const boot_health_t *health, bool healthy)
+{
+    boot_metrics_t metrics;
+    portENTER_CRITICAL(&s_lock);
+    boot_metrics_record(&s_metrics, APP_VERSION, health, healthy);
+    metrics = s_metrics;
+    portEXIT_CRITICAL(&s_lock);
+
+    esp_err_t err = nvs_storage_save_boot_metrics(&metrics, sizeof(metrics));
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to save boot metrics: %s", esp_err_to_name(err));
+    }
+}
+
+static void decide(boot_health_verdict_t verdict, const boot_health_t *health)
+{
+    if (verdict == BOOT_HEALTH_PASSED) {
+        ESP_LOGI(TAG, "Boot healthy: first reading after %lu ms, %u sensors",
+                 (unsigned long)health->first_cycle_ms, health->sensors_found);
+        if (health->sensors_found < health->expected_sensors) {
+            ESP_LOGW(TAG, "Found %u of the %u sensors seen on the previous boot",
+                     health->sensors_found, health->expected_sensors);
+        }
+        if (s_on_trial) {
+            esp_err_t err = esp_ota_mark_app_valid_cancel_rollback();
+            if (err == ESP_OK) {
+                ESP_LOGI(TAG, "Image %s confirmed", APP_VERSION);
+            } else {
+                ESP_LOGE(TAG, "Failed to confirm image: %s", esp_err_to_name(err));
+            }
+        }
+        return;
+    }
+
+    const char *missing = boot_health_missing(health);
+    if (!s_on_trial) {
+        ESP_LOGW(TAG, "Boot health check failed: no %s within %lu s",
+                 missing, (unsigned long)(health->budget_ms / 1000));
+        return;
+    }
+
+    ESP_LOGE(TAG, "Image %s failed the boot health check (no %s within %lu s), rolling back",
+             APP_VERSION, missing, (unsigned long)(health->budget_ms / 1000));
+    record_boot(health, false);
+    esp_err_t err = esp_ota_mark_app_invalid_rollback_and_reboot();
+    /* Only returns if there is no valid image to go back to */
+    ESP_LOGE(TAG, "Rollback failed: %s", esp_err_to_name(err));
+}
+
+static void boot_monitor_task(void *pvParameters)
+{
+    bool decided = false;
+
+    while (1) {
+        vTaskDelay(pdMS_TO_TICKS(POLL_MS));
+        uint32_t now = now_ms();
+        bool mqtt = mqtt_ha_is_connected();
+
+        portENTER_CRITICAL(&s_lock);
+        if (mqtt) {
+            boot_health_mqtt_connected(&s_health, now);
+        }
+        s_verdict = boot_health_evaluate(&s_health, now);
+        boot_health_verdict_t verdict = s_verdict;
+        boot_health_t health = s_health;
+        portEXIT_CRITICAL(&s_lock);
+
+        if (verdict == BOOT_HEALTH_PENDING) {
+            continue;
+        }
+        if (!decided) {
+            decided = true;
+            decide(verdict, &health);
+        }
+        /* Give the first publish until the end of the budget to make it into the metrics */
+        if (health.first_publish_ms != 0 || now >= health.budget_ms) {
+            record_boot(&health, verdict == BOOT_HEALTH_PASSED);
+            break;
+        }
+    }
+
+    ESP_LOGD(TAG, "Boot monitor done");
+    vTaskDelete(NULL);
+}
+
+esp_err_t boot_monitor_start(void)
+{
+    esp_err_t err = nvs_storage_load_boot_metrics(&s_metrics, sizeof(s_metrics));
+    if (err != ESP_OK) {
+        memset(&s_metrics, 0, sizeof(s_metrics));
+    }
+
+    esp_ota_img_states_t state;
+    s_on_trial = esp_ota_get_state_partition(esp_ota_get_running_partition(), &state) == ESP_OK &&
+                 state == ESP_OTA_IMG_PENDING_VERIFY;
+
+    const esp_partition_t *invalid = esp_ota_get_last_invalid_partition();
+    esp_app_desc_t desc;
+    if (invalid != NULL && esp_ota_get_partition_description(invalid, &desc) == ESP_OK) {
+        snprintf(s_rolled_back_from, sizeof(s_rolled_back_from), "%s", desc.version);
+    }
+
+    boot_health_init(&s_health, CONFIG_BOOT_HEALTH_BUDGET_S * 1000,
+                     boot_metrics_expected_sensors(&s_metrics),
+                     CONFIG_BOOT_HEALTH_MIN_SENSORS_PCT, REQUIRE_MQTT);
+
+    if (s_on_trial) {
+        ESP_LOGI(TAG, "Image %s is on trial: %d s to pass the boot health check (%u of %u sensors required)",
+                 APP_VERSION, CONFIG_BOOT_HEALTH_BUDGET_S,
+                 boot_health_required_sensors(&s_health), s_health.expected_sensors);
+    }
+    if (s_rolled_back_from[0] != '\0') {
+        ESP_LOGW(TAG, "Image %s was rolled back", s_rolled_back_from);
+    }
+
+    if (xTaskCreate(boot_monitor_task, "boot_monitor", 3072, NULL, 3, NULL) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+void boot_monitor_sensors_scanned(int count)
+{
+    uint32_t now = now_ms();
+    portENTER_CRITICAL(&s_lock);
+    boot_health_scanned(&s_health, now, (uint16_t)count);
+    portEXIT_CRITICAL(&s_lock);
+}
+
+void boot_monitor_cycle_done(int valid)
+{
+    uint32_t now = now_ms();
+    portENTER_CRITICAL(&s_lock);
+    boot_health_cycle(&s_health, now, (uint16_t)valid);
+    portEXIT_CRITICAL(&s_lock);
+}
+
+void boot_monitor_network_up(void)
+{
+    uint32_t now = now_ms();
+    portENTER_CRITICAL(&s_lock);
+    boot_health_network_up(&s_health, now);
+    portEXIT_CRITICAL(&s_lock);
+}
+
+void boot_monitor_published(void)
+{
+    uint32_t now = now_ms();
+    portENTER_CRITICAL(&s_lock);
+    boot_health_published(&s_health, now);
+    portEXIT_CRITICAL(&s_lock);
+}
+
+void boot_monitor_get_status(boot_monitor_status_t *status)
+{
+    portENTER_CRITICAL(&s_lock);
+    status->health = s_health;
+    status->verdict = s_verdict;
+    portEXIT_CRITICAL(&s_lock);
+    status->on_trial = s_on_trial;
+    memcpy(status->rolled_back_from, s_rolled_back_from, sizeof(status->rolled_back_from));
+}
+
+void boot_monitor_get_metrics(boot_metrics_t *metrics)
+{
+    portENTER_CRITICAL(&s_lock);
+    *metrics = s_metrics;
+    portEXIT_CRITICAL(&s_lock);
+}
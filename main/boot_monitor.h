@@ -0,0 +1,50 @@
+/**
+ * @file boot_monitor.h
+ * @brief Boot health check after an update: mark the image valid or roll back
+ *
+ * With app rollback enabled the bootloader starts a new image in the
+ * "pending verify" state. The monitor runs the boot_health check against
+ * it and confirms the image once it passes. If the budget runs out first
+ * it marks the image invalid and reboots into the previous one; a crash
+ * before that point rolls back too, because an unconfirmed image is not
+ * started twice. Boots of an already confirmed image are checked and
+ * measured the same way, without the rollback.
+ *
+ * Time to first reading and first publish are recorded per image version
+ * in NVS.
+ */
+
+#ifndef BOOT_MONITOR_H
+#define BOOT_MONITOR_H
+
+#include "boot_health.h"
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct {
+    boot_health_t health;
+    boot_health_verdict_t verdict;
+    bool on_trial;              /**< This boot decides whether the image is kept */
+    char rolled_back_from[BOOT_METRICS_VERSION_MAX];   /**< Version of the last rejected image, "" if none */
+} boot_monitor_status_t;
+
+/**
+ * @brief Load the metrics and start the monitor task (call before waiting for the network)
+ */
+esp_err_t boot_monitor_start(void);
+
+/* Milestones, called from the code that reaches them */
+void boot_monitor_sensors_scanned(int count);
+void boot_monitor_cycle_done(int valid);
+void boot_monitor_network_up(void);
+void boot_monitor_published(void);
+
+void boot_monitor_get_status(boot_monitor_status_t *status);
+
+/**
+ * @brief Copy the per-version boot metrics, newest first
+ */
+void boot_monitor_get_metrics(boot_metrics_t *metrics);
+
+#endif /* BOOT_MONITOR_H */
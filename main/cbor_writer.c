@@ -0,0 +1,127 @@
+/**
+ * @file cbor_writer.c
+ * @brief Minimal CBOR (RFC 8949) encoder into a fixed buffer (host-testable)
+ */
+
+#include "cbor_writer.h"
+#include <string.h>
+
+#define CBOR_MAJOR_UINT   0
+#define CBOR_MAJOR_NINT   1
+#define CBOR_MAJOR_BYTES  2
+#define CBOR_MAJOR_TEXT   3
+#define CBOR_MAJOR_ARRAY  4
+#define CBOR_MAJOR_MAP    5
+#define CBOR_MAJOR_SIMPLE 7
+
+/* Additional information marking an indefinite length (or, major 7, a break) */
+#define CBOR_INDEFINITE   31
+
+void cbor_writer_init(cbor_writer_t *w, uint8_t *buf, size_t size)
+{
+    w->buf = buf;
+    w->size = size;
+    w->len = 0;
+    w->error = false;
+}
+
+static void put(cbor_writer_t *w, const uint8_t *data, size_t len)
+{
+    if (w->error) {
+        return;
+    }
+    if (len > w->size - w->len) {
+        w->error = true;
+        return;
+    }
+    memcpy(w->buf + w->len, data, len);
+    w->len += len;
+}
+
+/**
+ * @brief Write an item head using the shortest argument encoding
+ */
+static void put_head(cbor_writer_t *w, uint8_t major, uint64_t arg)
+{
+    uint8_t head[CBOR_MAX_HEAD_SIZE];
+    size_t n;
+
+    if (arg < 24) {
+        head[0] = (uint8_t)((major << 5) | arg);
+        n = 1;
+    } else if (arg <= UINT8_MAX) {
+        head[0] = (uint8_t)((major << 5) | 24);
+        n = 2;
+    } else if (arg <= UINT16_MAX) {
+        head[0] = (uint8_t)((major << 5) | 25);
+        n = 3;
+    } else if (arg <= UINT32_MAX) {
+        head[0] = (uint8_t)((major << 5) | 26);
+        n = 5;
+    } else {
+        head[0] = (uint8_t)((major << 5) | 27);
+        n = 9;
+    }
+
+    /* Argument follows the initial byte, big-endian */
+    for (size_t i = n - 1; i >= 1; i--) {
+        head[i] = (uint8_t)arg;
+        arg >>= 8;
+    }
+    put(w, head, n);
+}
+
+void cbor_writer_uint(cbor_writer_t *w, uint64_t value)
+{
+    put_head(w, CBOR_MAJOR_UINT, value);
+}
+
+void cbor_writer_int(cbor_writer_t *w, int64_t value)
+{
+    if (value >= 0) {
+        put_head(w, CBOR_MAJOR_UINT, (uint64_t)value);
+    } else {
+        /* -1 - n, computed without overflowing INT64_MIN */
+        put_head(w, CBOR_MAJOR_NINT, ~(uint64_t)value);
+    }
+}
+
+void cbor_writer_bytes(cbor_writer_t *w, const uint8_t *data, size_t len)
+{
+    put_head(w, CBOR_MAJOR_BYTES, len);
+    put(w, data, len);
+}
+
+void cbor_writer_text(cbor_writer_t *w, const char *str)
+{
+    size_t len = strlen(str);
+    put_head(w, CBOR_MAJOR_TEXT, len);
+    put(w, (const uint8_t *)str, len);
+}
+
+void cbor_writer_array(cbor_writer_t *w, size_t count)
+{
+    put_head(w, CBOR_MAJOR_ARRAY, count);
+}
+
+void cbor_writer_array_indefinite(cbor_writer_t *w)
+{
+    uint8_t initial = (CBOR_MAJOR_ARRAY << 5) | CBOR_INDEFINITE;
+    put(w, &initial, 1);
+}
+
+void cbor_writer_break(cbor_writer_t *w)
+{
+    uint8_t initial = (CBOR_MAJOR_SIMPLE << 5) | CBOR_INDEFINITE;
+    put(w, &initial, 1);
+}
+
+void cbor_writer_map(cbor_writer_t *w, size_t count)
+{
+    put_head(w, CBOR_MAJOR_MAP, count);
+}
+
+int cbor_writer_finish(cbor_writer_t *w)
+{
+    return w->error ? -1 : (int)w->len;
+}
@@ -0,0 +1,70 @@
+/**
+ * @file cbor_writer.h
+ * @brief Minimal CBOR (RFC 8949) encoder into a fixed buffer (host-testable)
+ *
+ * Items are unsigned/negative integers, byte and text strings, arrays and
+ * maps. Containers are written as a header with the item count followed
+ * by the items themselves; only an array being streamed before its length
+ * is known may be indefinite-length, closed with a break. Errors
+ * (overflow) are sticky and reported by cbor_writer_finish().
+ */
+
+#ifndef CBOR_WRITER_H
+#define CBOR_WRITER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/** @brief Largest encoded integer or container header */
+#define CBOR_MAX_HEAD_SIZE 9
+
+/**
+ * @brief Writer state (stack-allocate, initialize with cbor_writer_init)
+ */
+typedef struct {
+    uint8_t *buf;       /**< Output buffer */
+    size_t size;        /**< Output buffer size */
+    size_t len;         /**< Bytes written */
+    bool error;         /**< Sticky overflow flag */
+} cbor_writer_t;
+
+void cbor_writer_init(cbor_writer_t *w, uint8_t *buf, size_t size);
+
+void cbor_writer_uint(cbor_writer_t *w, uint64_t value);
+
+/**
+ * @brief Write a signed integer (major type 0 or 1)
+ */
+void cbor_writer_int(cbor_writer_t *w, int64_t value);
+
+void cbor_writer_bytes(cbor_writer_t *w, const uint8_t *data, size_t len);
+void cbor_writer_text(cbor_writer_t *w, const char *str);
+
+/**
+ * @brief Start an array of count items
+ */
+void cbor_writer_array(cbor_writer_t *w, size_t count);
+
+/**
+ * @brief Start an array of unknown length; close it with cbor_writer_break()
+ */
+void cbor_writer_array_indefinite(cbor_writer_t *w);
+
+/**
+ * @brief End an indefinite-length array
+ */
+void cbor_writer_break(cbor_writer_t *w);
+
+/**
+ * @brief Start a map of count key/value pairs
+ */
+void cbor_writer_map(cbor_writer_t *w, size_t count);
+
+/**
+ * @brief Finish the document
+ * @return Encoded length, or -1 if the buffer overflowed
+ */
+int cbor_writer_finish(cbor_writer_t *w);
+
+#endif /* CBOR_WRITER_H */
@@ -0,0 +1,180 @@
+/**
+ * @file dashboard.c
+ * @brief Sensor and status documents with field projection (host-testable)
+ */
+
+#include "dashboard.h"
+#include <string.h>
+
+static const struct {
+    const char *name;
+    uint32_t mask;
+} s_fields[] = {
+    { "address",            DASHBOARD_F_ADDRESS },
+    { "temperature",        DASHBOARD_F_TEMPERATURE },
+    { "valid",              DASHBOARD_F_VALID },
+    { "friendly_name",      DASHBOARD_F_FRIENDLY_NAME },
+    { "total_reads",        DASHBOARD_F_TOTAL_READS },
+    { "failed_reads",       DASHBOARD_F_FAILED_READS },
+    { "version",            DASHBOARD_F_VERSION },
+    { "sensor_count",       DASHBOARD_F_SENSOR_COUNT },
+    { "max_sensors",        DASHBOARD_F_MAX_SENSORS },
+    { "uptime_seconds",     DASHBOARD_F_UPTIME },
+    { "free_heap",          DASHBOARD_F_FREE_HEAP },
+    { "mqtt_connected",     DASHBOARD_F_MQTT_CONNECTED },
+    { "ethernet_connected", DASHBOARD_F_ETH_CONNECTED },
+    { "wifi_connected",     DASHBOARD_F_WIFI_CONNECTED },
+    { "ethernet_ip",        DASHBOARD_F_ETH_IP },
+    { "wifi_ip",            DASHBOARD_F_WIFI_IP },
+    { "bus_stats",          DASHBOARD_F_BUS_STATS },
+    { "mqtt_buffer",        DASHBOARD_F_MQTT_BUFFER },
+    { "rate_limit",         DASHBOARD_F_RATE_LIMIT },
+    { "sensors",            DASHBOARD_SENSOR_FIELDS },
+    { "status",             DASHBOARD_STATUS_FIELDS },
+};
+
+#define FIELD_COUNT (sizeof(s_fields) / sizeof(s_fields[0]))
+
+/**
+ * @brief Length of the separator at pos (',' or "%2C"), 0 if none
+ */
+static size_t separator_len(const char *pos)
+{
+    if (pos[0] == ',') {
+        return 1;
+    }
+    if (pos[0] == '%' && pos[1] == '2' && (pos[2] == 'C' || pos[2] == 'c')) {
+        return 3;
+    }
+    return 0;
+}
+
+int dashboard_parse_fields(const char *list, uint32_t *mask)
+{
+    *mask = 0;
+    const char *pos = list;
+
+    while (*pos != '\0') {
+        const char *name = pos;
+        while (*pos != '\0' && separator_len(pos) == 0) {
+            pos++;
+        }
+        size_t len = (size_t)(pos - name);
+        pos += separator_len(pos);
+        if (len == 0) {
+            continue;
+        }
+
+        size_t i;
+        for (i = 0; i < FIELD_COUNT; i++) {
+            if (strlen(s_fields[i].name) == len && strncmp(s_fields[i].name, name, len) == 0) {
+                break;
+            }
+        }
+        if (i == FIELD_COUNT) {
+            return -1;
+        }
+        *mask |= s_fields[i].mask;
+    }
+    return *mask != 0 ? 0 : -1;
+}
+
+void dashboard_write_sensor(json_writer_t *w, const dashboard_sensor_t *sensor, uint32_t mask)
+{
+    json_writer_begin_object(w);
+    if (mask & DASHBOARD_F_ADDRESS) {
+        json_writer_kv_string(w, "address", sensor->address);
+    }
+    if (mask & DASHBOARD_F_TEMPERATURE) {
+        json_writer_kv_double(w, "temperature", sensor->temperature);
+    }
+    if (mask & DASHBOARD_F_VALID) {
+        json_writer_kv_bool(w, "valid", sensor->valid);
+    }
+    if (mask & DASHBOARD_F_FRIENDLY_NAME) {
+        json_writer_kv_string(w, "friendly_name", sensor->friendly_name);
+    }
+    if (mask & DASHBOARD_F_TOTAL_READS) {
+        json_writer_kv_uint(w, "total_reads", sensor->total_reads);
+    }
+    if (mask & DASHBOARD_F_FAILED_READS) {
+        json_writer_kv_uint(w, "failed_reads", sensor->failed_reads);
+    }
+    json_writer_end_object(w);
+}
+
+void dashboard_write_status(json_writer_t *w, const dashboard_status_t *status, uint32_t mask)
+{
+    json_writer_begin_object(w);
+    if (mask & DASHBOARD_F_VERSION) {
+        json_writer_kv_string(w, "version", status->version);
+    }
+    if (mask & DASHBOARD_F_SENSOR_COUNT) {
+        json_writer_kv_int(w, "sensor_count", status->sensor_count);
+    }
+    if (mask & DASHBOARD_F_MAX_SENSORS) {
+        json_writer_kv_int(w, "max_sensors", status->max_sensors);
+    }
+    if (mask & DASHBOARD_F_UPTIME) {
+        json_writer_kv_uint(w, "uptime_seconds", status->uptime_seconds);
+    }
+    if (mask & DASHBOARD_F_FREE_HEAP) {
+        json_writer_kv_uint(w, "free_heap", status->free_heap);
+    }
+    if (mask & DASHBOARD_F_MQTT_CONNECTED) {
+        json_writer_kv_bool(w, "mqtt_connected", status->mqtt_connected);
+    }
+
+    /* Network connection status */
+    if (mask & DASHBOARD_F_ETH_CONNECTED) {
+        json_writer_kv_bool(w, "ethernet_connected", status->eth_connected);
+    }
+    if (mask & DASHBOARD_F_WIFI_CONNECTED) {
+        json_writer_kv_bool(w, "wifi_connected", status->wifi_connected);
+    }
+    if (mask & DASHBOARD_F_ETH_IP) {
+        json_writer_kv_string(w, "ethernet_ip", status->ethernet_ip);
+    }
+    if (mask & DASHBOARD_F_WIFI_IP) {
+        json_writer_kv_string(w, "wifi_ip", status->wifi_ip);
+    }
+
+    /* Bus error statistics */
+    if (mask & DASHBOARD_F_BUS_STATS) {
+        json_writer_key(w, "bus_stats");
+        json_writer_begin_object(w);
+        json_writer_kv_uint(w, "total_reads", status->total_reads);
+        json_writer_kv_uint(w, "failed_reads", status->failed_reads);
+        json_writer_kv_double(w, "error_rate", status->total_reads > 0 ?
+                              (double)status->failed_reads / status->total_reads * 100.0 : 0.0);
+        json_writer_end_object(w);
+    }
+
+    /* MQTT offline buffer */
+    if (mask & DASHBOARD_F_MQTT_BUFFER) {
+        json_writer_key(w, "mqtt_buffer");
+        json_writer_begin_object(w);
+        json_writer_kv_uint(w, "depth", status->buffer.depth);
+        json_writer_kv_uint(w, "flash_depth", status->buffer.flash_depth);
+        json_writer_kv_uint(w, "captured", status->buffer.captured);
+        json_writer_kv_uint(w, "dropped", status->buffer.dropped);
+        json_writer_kv_uint(w, "replayed", status->buffer.replayed);
+        json_writer_kv_double(w, "replay_rate", status->buffer.replay_rate);
+        json_writer_end_object(w);
+    }
+
+    /* HTTP rate limiting */
+    if (mask & DASHBOARD_F_RATE_LIMIT) {
+        json_writer_key(w, "rate_limit");
+        json_writer_begin_object(w);
+        json_writer_key(w, "rejected");
+        json_writer_begin_object(w);
+        json_writer_kv_uint(w, "read", status->rate_limit.rejected_read);
+        json_writer_kv_uint(w, "write", status->rate_limit.rejected_write);
+        json_writer_kv_uint(w, "scan", status->rate_limit.rejected_scan);
+        json_writer_end_object(w);
+        json_writer_kv_uint(w, "rescans_coalesced", status->rate_limit.rescans_coalesced);
+        json_writer_end_object(w);
+    }
+    json_writer_end_object(w);
+}
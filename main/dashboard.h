@@ -0,0 +1,110 @@
+/**
+ * @file dashboard.h
+ * @brief Sensor and status documents with field projection (host-testable)
+ *
+ * Serializes the /api/sensors, /api/status and combined /api/dashboard
+ * documents straight into a json_writer. A field mask selects which
+ * members are written; unselected fields are never formatted.
+ */
+
+#ifndef DASHBOARD_H
+#define DASHBOARD_H
+
+#include "json_writer.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Sensor fields */
+#define DASHBOARD_F_ADDRESS         (1u << 0)
+#define DASHBOARD_F_TEMPERATURE     (1u << 1)
+#define DASHBOARD_F_VALID           (1u << 2)
+#define DASHBOARD_F_FRIENDLY_NAME   (1u << 3)
+#define DASHBOARD_F_TOTAL_READS     (1u << 4)
+#define DASHBOARD_F_FAILED_READS    (1u << 5)
+
+/* Status fields */
+#define DASHBOARD_F_VERSION         (1u << 8)
+#define DASHBOARD_F_SENSOR_COUNT    (1u << 9)
+#define DASHBOARD_F_MAX_SENSORS     (1u << 10)
+#define DASHBOARD_F_UPTIME          (1u << 11)
+#define DASHBOARD_F_FREE_HEAP       (1u << 12)
+#define DASHBOARD_F_MQTT_CONNECTED  (1u << 13)
+#define DASHBOARD_F_ETH_CONNECTED   (1u << 14)
+#define DASHBOARD_F_WIFI_CONNECTED  (1u << 15)
+#define DASHBOARD_F_ETH_IP          (1u << 16)
+#define DASHBOARD_F_WIFI_IP         (1u << 17)
+#define DASHBOARD_F_BUS_STATS       (1u << 18)
+#define DASHBOARD_F_MQTT_BUFFER     (1u << 19)
+#define DASHBOARD_F_RATE_LIMIT      (1u << 20)
+
+#define DASHBOARD_SENSOR_FIELDS     0x000000FFu
+#define DASHBOARD_STATUS_FIELDS     0x00FFFF00u
+#define DASHBOARD_ALL_FIELDS        (DASHBOARD_SENSOR_FIELDS | DASHBOARD_STATUS_FIELDS)
+
+/**
+ * @brief Sensor as reported by the API
+ */
+typedef struct {
+    const char *address;        /**< Address string */
+    float temperature;          /**< Celsius */
+    bool valid;                 /**< Last read succeeded */
+    const char *friendly_name;  /**< NULL if not set */
+    uint32_t total_reads;
+    uint32_t failed_reads;
+} dashboard_sensor_t;
+
+/**
+ * @brief Device status as reported by the API
+ */
+typedef struct {
+    const char *version;
+    int sensor_count;
+    int max_sensors;
+    uint32_t uptime_seconds;
+    uint32_t free_heap;
+    bool mqtt_connected;
+    bool eth_connected;
+    bool wifi_connected;
+    char ethernet_ip[16];       /**< Empty when disconnected */
+    char wifi_ip[16];           /**< Empty when disconnected */
+    uint32_t total_reads;       /**< Bus-wide */
+    uint32_t failed_reads;      /**< Bus-wide */
+    struct {
+        uint32_t depth;
+        uint32_t flash_depth;
+        uint32_t captured;
+        uint32_t dropped;
+        uint32_t replayed;
+        float replay_rate;
+    } buffer;                   /**< MQTT offline buffer */
+    struct {
+        uint32_t rejected_read;
+        uint32_t rejected_write;
+        uint32_t rejected_scan;
+        uint32_t rescans_coalesced;
+    } rate_limit;               /**< HTTP requests answered with 429 */
+} dashboard_status_t;
+
+/**
+ * @brief Parse a fields= list into a mask
+ *
+ * Names are the JSON member names, comma-separated (also accepted
+ * URL-encoded as %2C). "sensors" and "status" select a whole group.
+ *
+ * @param list Field list as taken from the query string
+ * @param mask Output: selected fields
+ * @return 0 on success, -1 on an unknown or empty field list
+ */
+int dashboard_parse_fields(const char *list, uint32_t *mask);
+
+/**
+ * @brief Write one sensor object with the selected fields
+ */
+void dashboard_write_sensor(json_writer_t *w, const dashboard_sensor_t *sensor, uint32_t mask);
+
+/**
+ * @brief Write the status object with the selected fields
+ */
+void dashboard_write_status(json_writer_t *w, const dashboard_status_t *status, uint32_t mask);
+
+#endif /* DASHBOARD_H */
@@ -0,0 +1,268 @@
+/**
+ * @file delta_patch.c
+ * @brief Streaming binary patch applier for delta OTA (host-testable)
+ */
+
+#include "delta_patch.h"
+#include <string.h>
+
+enum {
+    ST_HEADER,
+    ST_RECORD,
+    ST_DIFF,
+    ST_EXTRA,
+    ST_DONE,
+};
+
+static uint32_t get_le32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+void delta_patch_init(delta_patch_t *d, const delta_io_t *io)
+{
+    memset(d, 0, sizeof(*d));
+    d->io = *io;
+    d->state = ST_HEADER;
+    mbedtls_sha256_init(&d->sha);
+}
+
+void delta_patch_free(delta_patch_t *d)
+{
+    mbedtls_sha256_free(&d->sha);
+}
+
+bool delta_patch_has_header(const delta_patch_t *d)
+{
+    return d->state != ST_HEADER;
+}
+
+/**
+ * @brief Collect up to want bytes of a header or record into pending
+ */
+static size_t take(delta_patch_t *d, const uint8_t *p, size_t len, size_t want)
+{
+    size_t n = want - d->pending_len;
+    if (n > len) {
+        n = len;
+    }
+    memcpy(d->pending + d->pending_len, p, n);
+    d->pending_len += n;
+    return n;
+}
+
+static int emit(delta_patch_t *d, const void *data, size_t len)
+{
+    mbedtls_sha256_update(&d->sha, data, len);
+    if (d->io.write(d->io.ctx, data, len) != 0) {
+        return DELTA_ERR_IO;
+    }
+    d->out_total += (uint32_t)len;
+    return DELTA_OK;
+}
+
+/**
+ * @brief Hash the source image and compare with the header
+ */
+static int check_source(delta_patch_t *d)
+{
+    mbedtls_sha256_context sha;
+    uint8_t digest[SHA256_DIGEST_SIZE];
+    int result = DELTA_OK;
+
+    mbedtls_sha256_init(&sha);
+    mbedtls_sha256_starts(&sha, 0);
+    for (uint32_t off = 0; off < d->header.source_size; off += DELTA_CHUNK) {
+        uint32_t n = d->header.source_size - off;
+        if (n > DELTA_CHUNK) {
+            n = DELTA_CHUNK;
+        }
+        if (d->io.read_source(d->io.ctx, off, d->buf, n) != 0) {
+            result = DELTA_ERR_IO;
+            break;
+        }
+        mbedtls_sha256_update(&sha, d->buf, n);
+    }
+    if (result == DELTA_OK) {
+        mbedtls_sha256_finish(&sha, digest);
+        if (memcmp(digest, d->header.source_sha256, SHA256_DIGEST_SIZE) != 0) {
+            result = DELTA_ERR_SOURCE;
+        }
+    }
+    mbedtls_sha256_free(&sha);
+    return result;
+}
+
+static int parse_header(delta_patch_t *d)
+{
+    const uint8_t *h = d->pending;
+    if (memcmp(h, DELTA_MAGIC, 4) != 0 || get_le32(h + 12) != 0) {
+        return DELTA_ERR_HEADER;
+    }
+    d->header.source_size = get_le32(h + 4);
+    d->header.target_size = get_le32(h + 8);
+    memcpy(d->header.source_sha256, h + 16, SHA256_DIGEST_SIZE);
+    memcpy(d->header.target_sha256, h + 48, SHA256_DIGEST_SIZE);
+    if (d->header.target_size == 0) {
+        return DELTA_ERR_HEADER;
+    }
+
+    int r = check_source(d);
+    if (r != DELTA_OK) {
+        return r;
+    }
+    mbedtls_sha256_starts(&d->sha, 0);
+    d->pending_len = 0;
+    d->state = ST_RECORD;
+    return DELTA_OK;
+}
+
+/**
+ * @brief Apply the seek of a finished record and move on
+ */
+static int end_record(delta_patch_t *d)
+{
+    int64_t pos = (int64_t)d->source_pos + d->seek;
+    if (pos < 0 || pos > d->header.source_size) {
+        return DELTA_ERR_DATA;
+    }
+    d->source_pos = (uint32_t)pos;
+    d->state = (d->out_total == d->header.target_size) ? ST_DONE : ST_RECORD;
+    return DELTA_OK;
+}
+
+static int parse_record(delta_patch_t *d)
+{
+    d->diff_left = get_le32(d->pending);
+    d->extra_left = get_le32(d->pending + 4);
+    d->seek = (int32_t)get_le32(d->pending + 8);
+    d->pending_len = 0;
+
+    if ((uint64_t)d->out_total + d->diff_left + d->extra_left > d->header.target_size ||
+        (uint64_t)d->source_pos + d->diff_left > d->header.source_size) {
+        return DELTA_ERR_DATA;
+    }
+    if (d->diff_left > 0) {
+        d->state = ST_DIFF;
+    } else if (d->extra_left > 0) {
+        d->state = ST_EXTRA;
+    } else {
+        return end_record(d);
+    }
+    return DELTA_OK;
+}
+
+static int apply_diff(delta_patch_t *d, const uint8_t *p, size_t n)
+{
+    if (d->io.read_source(d->io.ctx, d->source_pos, d->buf, n) != 0) {
+        return DELTA_ERR_IO;
+    }
+    for (size_t i = 0; i < n; i++) {
+        d->buf[i] += p[i];
+    }
+    int r = emit(d, d->buf, n);
+    if (r != DELTA_OK) {
+        return r;
+    }
+    d->source_pos += (uint32_t)n;
+    d->diff_left -= (uint32_t)n;
+    if (d->diff_left == 0) {
+        if (d->extra_left > 0) {
+            d->state = ST_EXTRA;
+        } else {
+            return end_record(d);
+        }
+    }
+    return DELTA_OK;
+}
+
+static int apply_extra(delta_patch_t *d, const uint8_t *p, size_t n)
+{
+    int r = emit(d, p, n);
+    if (r != DELTA_OK) {
+        return r;
+    }
+    d->extra_left -= (uint32_t)n;
+    return d->extra_left == 0 ? end_record(d) : DELTA_OK;
+}
+
+int delta_patch_feed(delta_patch_t *d, const void *data, size_t len)
+{
+    const uint8_t *p = data;
+    if (d->error != DELTA_OK) {
+        return d->error;
+    }
+
+    while (len > 0) {
+        size_t used = 0;
+        int r = DELTA_OK;
+        switch (d->state) {
+        case ST_HEADER:
+            used = take(d, p, len, DELTA_HEADER_SIZE);
+            if (d->pending_len == DELTA_HEADER_SIZE) {
+                r = parse_header(d);
+            }
+            break;
+        case ST_RECORD:
+            used = take(d, p, len, DELTA_RECORD_SIZE);
+            if (d->pending_len == DELTA_RECORD_SIZE) {
+                r = parse_record(d);
+            }
+            break;
+        case ST_DIFF:
+            used = len;
+            if (used > d->diff_left) {
+                used = d->diff_left;
+            }
+            if (used > DELTA_CHUNK) {
+                used = DELTA_CHUNK;
+            }
+            r = apply_diff(d, p, used);
+            break;
+        case ST_EXTRA:
+            used = len < d->extra_left ? len : d->extra_left;
+            r = apply_extra(d, p, used);
+            break;
+        default:
+            r = DELTA_ERR_DATA;     /* Bytes after the end */
+            break;
+        }
+        if (r != DELTA_OK) {
+            d->error = r;
+            return r;
+        }
+        p += used;
+        len -= used;
+    }
+    return DELTA_OK;
+}
+
+int delta_patch_finish(delta_patch_t *d)
+{
+    if (d->error != DELTA_OK) {
+        return d->error;
+    }
+    if (d->state != ST_DONE) {
+        return DELTA_ERR_TRUNCATED;
+    }
+    uint8_t digest[SHA256_DIGEST_SIZE];
+    mbedtls_sha256_finish(&d->sha, digest);
+    if (memcmp(digest, d->header.target_sha256, SHA256_DIGEST_SIZE) != 0) {
+        return DELTA_ERR_HASH;
+    }
+    return DELTA_OK;
+}
+
+const char *delta_patch_strerror(int result)
+{
+    switch (result) {
+    case DELTA_OK:              return "ok";
+    case DELTA_ERR_HEADER:      return "not a delta patch";
+    case DELTA_ERR_SOURCE:      return "patch is for a different running image";
+    case DELTA_ERR_DATA:        return "corrupt patch";
+    case DELTA_ERR_TRUNCATED:   return "patch truncated";
+    case DELTA_ERR_HASH:        return "result hash mismatch";
+    case DELTA_ERR_IO:          return "read or write error";
+    default:                    return "unknown error";
+    }
+}
@@ -0,0 +1,110 @@
+/**
+ * @file delta_patch.h
+ * @brief Streaming binary patch applier for delta OTA (host-testable)
+ *
+ * A patch rebuilds a new image from the running one. It is a header
+ * followed by bsdiff-style records, each of which:
+ *   - adds diff_len patch bytes to source bytes at the source position
+ *     (so unchanged code yields runs of zeros, which compress well),
+ *   - appends extra_len literal bytes,
+ *   - moves the source position by seek.
+ *
+ * Patch bytes are pushed in pieces of any size, source bytes are read
+ * through a callback, and output goes out through another, so RAM use is
+ * a few hundred bytes whatever the image size. The source is checked
+ * against the header's SHA-256 before any output is produced, and the
+ * result against the target SHA-256 at the end. Patches are made by
+ * scripts/make_delta.py and shipped gzip-compressed.
+ */
+
+#ifndef DELTA_PATCH_H
+#define DELTA_PATCH_H
+
+#include "mbedtls/sha256.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef SHA256_DIGEST_SIZE
+#define SHA256_DIGEST_SIZE 32
+#endif
+
+#define DELTA_MAGIC "TXD1"
+#define DELTA_HEADER_SIZE 80    /**< magic, source/target size, flags, two SHA-256 */
+#define DELTA_RECORD_SIZE 12    /**< diff_len, extra_len, seek (little-endian) */
+#define DELTA_CHUNK 256         /**< Source bytes read per callback */
+
+/**
+ * @brief Result of delta_patch_feed() / delta_patch_finish()
+ */
+typedef enum {
+    DELTA_OK = 0,
+    DELTA_ERR_HEADER = -1,      /**< Bad magic or sizes */
+    DELTA_ERR_SOURCE = -2,      /**< Running image is not the one the patch was made from */
+    DELTA_ERR_DATA = -3,        /**< Record out of bounds, or data after the end */
+    DELTA_ERR_TRUNCATED = -4,   /**< Patch ended before the target was complete */
+    DELTA_ERR_HASH = -5,        /**< Result does not match the target SHA-256 */
+    DELTA_ERR_IO = -6,          /**< A callback failed */
+} delta_result_t;
+
+/**
+ * @brief Source and sink; callbacks return 0 on success
+ */
+typedef struct {
+    int (*read_source)(void *ctx, uint32_t offset, void *buf, size_t len);
+    int (*write)(void *ctx, const void *data, size_t len);
+    void *ctx;
+} delta_io_t;
+
+typedef struct {
+    uint32_t source_size;
+    uint32_t target_size;
+    uint8_t source_sha256[SHA256_DIGEST_SIZE];
+    uint8_t target_sha256[SHA256_DIGEST_SIZE];
+} delta_header_t;
+
+typedef struct {
+    delta_io_t io;
+    delta_header_t header;
+    int state;
+    int error;                  /**< Sticky: the first error returned */
+    uint8_t pending[DELTA_HEADER_SIZE];     /**< Partial header or record */
+    size_t pending_len;
+    uint32_t diff_left;
+    uint32_t extra_left;
+    int32_t seek;
+    uint32_t source_pos;
+    uint32_t out_total;
+    mbedtls_sha256_context sha;
+    uint8_t buf[DELTA_CHUNK];
+} delta_patch_t;
+
+void delta_patch_init(delta_patch_t *d, const delta_io_t *io);
+
+/**
+ * @brief Release the hash state (after delta_patch_finish() or a failure)
+ */
+void delta_patch_free(delta_patch_t *d);
+
+/**
+ * @brief Apply the next piece of the patch
+ * @return DELTA_OK or a negative delta_result_t (repeated on later calls)
+ */
+int delta_patch_feed(delta_patch_t *d, const void *data, size_t len);
+
+/**
+ * @brief Check that the target is complete and matches its SHA-256
+ */
+int delta_patch_finish(delta_patch_t *d);
+
+/**
+ * @brief Whether the header has been read (d->header is valid)
+ */
+bool delta_patch_has_header(const delta_patch_t *d);
+
+/**
+ * @brief Short description of a delta_result_t for logs
+ */
+const char *delta_patch_strerror(int result);
+
+#endif /* DELTA_PATCH_H */
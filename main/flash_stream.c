@@ -0,0 +1,93 @@
+/**
+ * @file flash_stream.c
+ * @brief Sequential flash writer with erase-ahead (host-testable)
+ */
+
+#include "flash_stream.h"
+
+void flash_stream_init(flash_stream_t *fs, const flash_stream_ops_t *ops, uint32_t sector_size,
+                       uint32_t limit, uint32_t expected)
+{
+    fs->ops = *ops;
+    fs->sector_size = sector_size;
+    fs->limit = limit;
+    fs->expected = expected < limit ? expected : limit;
+    fs->written = 0;
+    fs->erased = 0;
+    fs->erased_ahead = 0;
+}
+
+static uint32_t round_up(const flash_stream_t *fs, uint32_t len)
+{
+    return (len + fs->sector_size - 1) & ~(fs->sector_size - 1);
+}
+
+/**
+ * @brief Erase from the current erase position up to end (sector-aligned, <= limit)
+ */
+static int erase_to(flash_stream_t *fs, uint32_t end)
+{
+    if (end <= fs->erased) {
+        return 0;
+    }
+    if (fs->ops.erase(fs->ops.ctx, fs->erased, end - fs->erased) != 0) {
+        return -1;
+    }
+    fs->erased = end;
+    return 0;
+}
+
+int flash_stream_resume(flash_stream_t *fs, uint32_t offset)
+{
+    if ((offset & (fs->sector_size - 1)) != 0 || offset > fs->limit) {
+        return -1;
+    }
+    fs->written = offset;
+    fs->erased = offset;
+    return 0;
+}
+
+int flash_stream_write(flash_stream_t *fs, const void *data, size_t len)
+{
+    if (len > fs->limit - fs->written) {
+        return -1;
+    }
+    uint32_t end = round_up(fs, fs->written + (uint32_t)len);
+    if (end > fs->limit) {
+        end = fs->limit;
+    }
+    if (erase_to(fs, end) != 0) {
+        return -1;
+    }
+    if (len > 0 && fs->ops.write(fs->ops.ctx, fs->written, data, len) != 0) {
+        return -1;
+    }
+    fs->written += (uint32_t)len;
+    return 0;
+}
+
+int flash_stream_erase_ahead(flash_stream_t *fs, uint32_t max_sectors)
+{
+    uint32_t target = round_up(fs, fs->expected);
+    if (target > fs->limit) {
+        target = fs->limit;
+    }
+    if (fs->erased >= target) {
+        return 0;
+    }
+
+    uint32_t sectors = (target - fs->erased + fs->sector_size - 1) / fs->sector_size;
+    if (sectors > max_sectors) {
+        sectors = max_sectors;
+    }
+    uint32_t end = fs->erased + sectors * fs->sector_size;
+    if (end > target) {
+        end = target;
+    }
+    uint32_t before = fs->erased;
+    if (erase_to(fs, end) != 0) {
+        return -1;
+    }
+    fs->erased_ahead += fs->erased - before;
+    return (int)sectors;
+}
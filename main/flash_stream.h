@@ -0,0 +1,64 @@
+/**
+ * @file flash_stream.h
+ * @brief Sequential flash writer with erase-ahead (host-testable)
+ *
+ * Writes an image front to back into a region through a storage backend.
+ * Sectors are erased either on demand, just before a write reaches them,
+ * or ahead of time with flash_stream_erase_ahead() while the writer would
+ * otherwise wait for data. Every sector is erased exactly once. Not
+ * thread-safe.
+ */
+
+#ifndef FLASH_STREAM_H
+#define FLASH_STREAM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Flash backend; offsets are relative to the region, callbacks return 0 on success
+ */
+typedef struct {
+    int (*erase)(void *ctx, uint32_t offset, uint32_t len);
+    int (*write)(void *ctx, uint32_t offset, const void *data, size_t len);
+    void *ctx;
+} flash_stream_ops_t;
+
+typedef struct {
+    flash_stream_ops_t ops;
+    uint32_t sector_size;
+    uint32_t limit;         /**< Region size */
+    uint32_t expected;      /**< Image size for erase-ahead, 0 if unknown */
+    uint32_t written;       /**< Bytes written */
+    uint32_t erased;        /**< Bytes erased from the start (sector multiple) */
+    uint32_t erased_ahead;  /**< Bytes erased by flash_stream_erase_ahead() */
+} flash_stream_t;
+
+/**
+ * @param sector_size Erase unit (power of two)
+ * @param limit Region size; writes past it fail
+ * @param expected Image size, bounds erase-ahead (0 = unknown: only erase on demand)
+ */
+void flash_stream_init(flash_stream_t *fs, const flash_stream_ops_t *ops, uint32_t sector_size,
+                       uint32_t limit, uint32_t expected);
+
+/**
+ * @brief Continue an interrupted image: the region up to offset is kept as written
+ * @param offset Bytes already on flash (a multiple of the sector size)
+ * @return 0, or -1 if offset is misaligned or past the region
+ */
+int flash_stream_resume(flash_stream_t *fs, uint32_t offset);
+
+/**
+ * @brief Append data, erasing the sectors it reaches first
+ * @return 0 on success, -1 on a backend error or if the region would overflow
+ */
+int flash_stream_write(flash_stream_t *fs, const void *data, size_t len);
+
+/**
+ * @brief Erase up to max_sectors not yet erased sectors of the expected image
+ * @return Sectors erased (0 when nothing is left to erase), -1 on a backend error
+ */
+int flash_stream_erase_ahead(flash_stream_t *fs, uint32_t max_sectors);
+
+#endif /* FLASH_STREAM_H */
@@ -0,0 +1,526 @@
+/**
+ * @file gunzip.c
+ * @brief Streaming gzip decoder with a small fixed window (host-testable)
+ *
+ * Inflate (RFC 1951) follows the canonical-Huffman approach of zlib's
+ * puff: codes are decoded a bit at a time from per-length counts, which
+ * needs no lookup tables beyond the symbol lists. gzip framing per
+ * RFC 1952.
+ */
+
+#include "gunzip.h"
+#include <string.h>
+
+#define WINDOW_MASK (GUNZIP_WINDOW_SIZE - 1)
+#define MAXBITS 15
+
+/* Evaluate expr; return its value from the calling function if it is an error */
+#define GET(var, expr) do { (var) = (expr); if ((var) < 0) return (var); } while (0)
+
+static const uint16_t LEN_BASE[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258,
+};
+static const uint8_t LEN_EXTRA[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0,
+};
+static const uint16_t DIST_BASE[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577,
+};
+static const uint8_t DIST_EXTRA[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13,
+};
+
+/* CRC-32 (reflected 0xEDB88320), four bits per step */
+static const uint32_t CRC_NIBBLE[16] = {
+    0x00000000, 0x1db71064, 0x3b6e20c8, 0x26d930ac, 0x76dc4190, 0x6b6b51f4, 0x4db26158, 0x5005713c,
+    0xedb88320, 0xf00f9344, 0xd6d6a3e8, 0xcb61b38c, 0x9b64c2b0, 0x86d3d2d4, 0xa00ae278, 0xbdbdf21c,
+};
+
+static uint32_t crc32_update(uint32_t crc, const uint8_t *data, size_t len)
+{
+    crc = ~crc;
+    while (len--) {
+        crc ^= *data++;
+        crc = (crc >> 4) ^ CRC_NIBBLE[crc & 15];
+        crc = (crc >> 4) ^ CRC_NIBBLE[crc & 15];
+    }
+    return ~crc;
+}
+
+void gunzip_init(gunzip_t *g, const gunzip_io_t *io)
+{
+    memset(g, 0, sizeof(*g));
+    g->io = *io;
+    g->lencode.symbol = g->lensym;
+    g->distcode.symbol = g->distsym;
+}
+
+int gunzip_is_gzip(const uint8_t *data, size_t len)
+{
+    return len >= 2 && data[0] == 0x1f && data[1] == 0x8b;
+}
+
+/* ===== Input ===== */
+
+static int next_byte(gunzip_t *g)
+{
+    if (g->in_pos == g->in_len) {
+        int n = g->io.read(g->io.ctx, g->in, sizeof(g->in));
+        if (n < 0) {
+            return GUNZIP_ERR_READ;
+        }
+        if (n == 0) {
+            return GUNZIP_ERR_TRUNCATED;
+        }
+        g->in_len = (size_t)n;
+        g->in_pos = 0;
+        g->in_total += (uint32_t)n;
+    }
+    return g->in[g->in_pos++];
+}
+
+/**
+ * @brief Take need (<= 16) bits, LSB first; leaves fewer than 8 bits buffered
+ */
+static int bits(gunzip_t *g, int need)
+{
+    uint32_t val = g->bitbuf;
+    while (g->bitcnt < need) {
+        int b;
+        GET(b, next_byte(g));
+        val |= (uint32_t)b << g->bitcnt;
+        g->bitcnt += 8;
+    }
+    g->bitbuf = val >> need;
+    g->bitcnt -= need;
+    return (int)(val & ((1u << need) - 1));
+}
+
+/* ===== Output ===== */
+
+/**
+ * @brief Pass everything not yet written to the sink
+ *
+ * Called whenever the window fills, so the unflushed bytes never wrap.
+ */
+static int flush(gunzip_t *g)
+{
+    size_t len = g->out_total - g->out_flushed;
+    if (len == 0) {
+        return GUNZIP_OK;
+    }
+    const uint8_t *data = g->window + (g->out_flushed & WINDOW_MASK);
+    g->crc = crc32_update(g->crc, data, len);
+    if (g->io.write(g->io.ctx, data, len) != 0) {
+        return GUNZIP_ERR_WRITE;
+    }
+    g->out_flushed = g->out_total;
+    return GUNZIP_OK;
+}
+
+static inline int put(gunzip_t *g, uint8_t b)
+{
+    g->window[g->out_total & WINDOW_MASK] = b;
+    g->out_total++;
+    if ((g->out_total & WINDOW_MASK) == 0) {
+        return flush(g);
+    }
+    return GUNZIP_OK;
+}
+
+/* ===== Huffman Codes ===== */
+
+/**
+ * @brief Build a code from code lengths
+ * @return 0 if complete, >0 if incomplete, <0 if over-subscribed
+ */
+static int construct(gunzip_huffman_t *h, const uint16_t *length, int n)
+{
+    uint16_t offs[MAXBITS + 1];
+
+    memset(h->count, 0, sizeof(h->count));
+    for (int sym = 0; sym < n; sym++) {
+        h->count[length[sym]]++;
+    }
+    if (h->count[0] == n) {
+        return 0;   /* No codes: complete, but decoding will fail */
+    }
+
+    int left = 1;
+    for (int len = 1; len <= MAXBITS; len++) {
+        left <<= 1;
+        left -= h->count[len];
+        if (left < 0) {
+            return left;
+        }
+    }
+
+    offs[1] = 0;
+    for (int len = 1; len < MAXBITS; len++) {
+        offs[len + 1] = offs[len] + h->count[len];
+    }
+    for (int sym = 0; sym < n; sym++) {
+        if (length[sym] != 0) {
+            h->symbol[offs[length[sym]]++] = (uint16_t)sym;
+        }
+    }
+    return left;
+}
+
+/**
+ * @brief Decode one symbol, reading the bits inline instead of through bits()
+ */
+static int decode(gunzip_t *g, const gunzip_huffman_t *h)
+{
+    int code = 0;
+    int first = 0;
+    int index = 0;
+    int len = 1;
+    uint32_t bitbuf = g->bitbuf;
+    int left = g->bitcnt;
+    const uint16_t *next = h->count + 1;
+
+    for (;;) {
+        while (left--) {
+            code |= bitbuf & 1;
+            bitbuf >>= 1;
+            int count = *next++;
+            if (code - count < first) {
+                g->bitbuf = bitbuf;
+                g->bitcnt = (g->bitcnt - len) & 7;
+                return h->symbol[index + (code - first)];
+            }
+            index += count;
+            first += count;
+            first <<= 1;
+            code <<= 1;
+            len++;
+        }
+        left = (MAXBITS + 1) - len;
+        if (left == 0) {
+            break;
+        }
+        int b;
+        GET(b, next_byte(g));
+        bitbuf = (uint32_t)b;
+        if (left > 8) {
+            left = 8;
+        }
+    }
+    return GUNZIP_ERR_DATA;   /* Ran out of codes */
+}
+
+/* ===== Blocks ===== */
+
+static int stored(gunzip_t *g)
+{
+    /* Discard the rest of the current byte */
+    g->bitbuf = 0;
+    g->bitcnt = 0;
+
+    int b0, b1, b2, b3;
+    GET(b0, next_byte(g));
+    GET(b1, next_byte(g));
+    GET(b2, next_byte(g));
+    GET(b3, next_byte(g));
+    unsigned len = (unsigned)b0 | ((unsigned)b1 << 8);
+    if (len != (~((unsigned)b2 | ((unsigned)b3 << 8)) & 0xffff)) {
+        return GUNZIP_ERR_DATA;
+    }
+
+    /* An empty stored block marks a flush point */
+    if (len == 0 && g->io.sync != NULL) {
+        int r;
+        GET(r, flush(g));
+        g->io.sync(g->io.ctx, g->in_total - (uint32_t)(g->in_len - g->in_pos), g->out_total, g->crc);
+        return GUNZIP_OK;
+    }
+
+    while (len--) {
+        int b, r;
+        GET(b, next_byte(g));
+        GET(r, put(g, (uint8_t)b));
+    }
+    return GUNZIP_OK;
+}
+
+static int codes(gunzip_t *g)
+{
+    for (;;) {
+        int sym, r;
+        GET(sym, decode(g, &g->lencode));
+        if (sym < 256) {
+            GET(r, put(g, (uint8_t)sym));
+            continue;
+        }
+        if (sym == 256) {
+            return GUNZIP_OK;
+        }
+
+        sym -= 257;
+        if (sym >= 29) {
+            return GUNZIP_ERR_DATA;
+        }
+        int extra;
+        GET(extra, bits(g, LEN_EXTRA[sym]));
+        int len = LEN_BASE[sym] + extra;
+
+        GET(sym, decode(g, &g->distcode));
+        if (sym >= 30) {
+            return GUNZIP_ERR_DATA;
+        }
+        GET(extra, bits(g, DIST_EXTRA[sym]));
+        uint32_t dist = DIST_BASE[sym] + (uint32_t)extra;
+        if (dist > g->out_total - g->window_start) {
+            return GUNZIP_ERR_DATA;     /* Before the start, or before a resume point */
+        }
+        if (dist > GUNZIP_WINDOW_SIZE) {
+            return GUNZIP_ERR_WINDOW;
+        }
+
+        while (len--) {
+            GET(r, put(g, g->window[(g->out_total - dist) & WINDOW_MASK]));
+        }
+    }
+}
+
+static int fixed(gunzip_t *g)
+{
+    int sym = 0;
+    for (; sym < 144; sym++) {
+        g->lengths[sym] = 8;
+    }
+    for (; sym < 256; sym++) {
+        g->lengths[sym] = 9;
+    }
+    for (; sym < 280; sym++) {
+        g->lengths[sym] = 7;
+    }
+    for (; sym < 288; sym++) {
+        g->lengths[sym] = 8;
+    }
+    construct(&g->lencode, g->lengths, 288);
+
+    for (sym = 0; sym < 30; sym++) {
+        g->lengths[sym] = 5;
+    }
+    construct(&g->distcode, g->lengths, 30);
+
+    return codes(g);
+}
+
+static int dynamic(gunzip_t *g)
+{
+    static const uint8_t ORDER[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+    int nlen, ndist, ncode;
+
+    GET(nlen, bits(g, 5));
+    GET(ndist, bits(g, 5));
+    GET(ncode, bits(g, 4));
+    nlen += 257;
+    ndist += 1;
+    ncode += 4;
+    if (nlen > 286 || ndist > 30) {
+        return GUNZIP_ERR_DATA;
+    }
+
+    /* Code length code, which must be complete */
+    int index = 0;
+    for (; index < ncode; index++) {
+        int len;
+        GET(len, bits(g, 3));
+        g->lengths[ORDER[index]] = (uint16_t)len;
+    }
+    for (; index < 19; index++) {
+        g->lengths[ORDER[index]] = 0;
+    }
+    if (construct(&g->lencode, g->lengths, 19) != 0) {
+        return GUNZIP_ERR_DATA;
+    }
+
+    /* Literal/length and distance code lengths */
+    index = 0;
+    while (index < nlen + ndist) {
+        int sym;
+        GET(sym, decode(g, &g->lencode));
+        if (sym < 16) {
+            g->lengths[index++] = (uint16_t)sym;
+            continue;
+        }
+        int len = 0;
+        int repeat;
+        if (sym == 16) {
+            if (index == 0) {
+                return GUNZIP_ERR_DATA;
+            }
+            len = g->lengths[index - 1];
+            GET(repeat, bits(g, 2));
+            repeat += 3;
+        } else if (sym == 17) {
+            GET(repeat, bits(g, 3));
+            repeat += 3;
+        } else {
+            GET(repeat, bits(g, 7));
+            repeat += 11;
+        }
+        if (index + repeat > nlen + ndist) {
+            return GUNZIP_ERR_DATA;
+        }
+        while (repeat--) {
+            g->lengths[index++] = (uint16_t)len;
+        }
+    }
+
+    if (g->lengths[256] == 0) {
+        return GUNZIP_ERR_DATA;   /* No end-of-block code */
+    }
+
+    /* Incomplete codes are only allowed for a single length */
+    int err = construct(&g->lencode, g->lengths, nlen);
+    if (err < 0 || (err > 0 && nlen - g->lencode.count[0] != 1)) {
+        return GUNZIP_ERR_DATA;
+    }
+    err = construct(&g->distcode, g->lengths + nlen, ndist);
+    if (err < 0 || (err > 0 && ndist - g->distcode.count[0] != 1)) {
+        return GUNZIP_ERR_DATA;
+    }
+
+    return codes(g);
+}
+
+/* ===== gzip Framing ===== */
+
+#define GZ_FHCRC    0x02
+#define GZ_FEXTRA   0x04
+#define GZ_FNAME    0x08
+#define GZ_FCOMMENT 0x10
+#define GZ_RESERVED 0xE0
+
+static int skip_string(gunzip_t *g)
+{
+    int b;
+    do {
+        GET(b, next_byte(g));
+    } while (b != 0);
+    return GUNZIP_OK;
+}
+
+static int header(gunzip_t *g)
+{
+    uint8_t h[10];
+    for (int i = 0; i < 10; i++) {
+        int b;
+        GET(b, next_byte(g));
+        h[i] = (uint8_t)b;
+    }
+    if (!gunzip_is_gzip(h, sizeof(h)) || h[2] != 8 || (h[3] & GZ_RESERVED)) {
+        return GUNZIP_ERR_HEADER;
+    }
+
+    int r;
+    if (h[3] & GZ_FEXTRA) {
+        int lo, hi;
+        GET(lo, next_byte(g));
+        GET(hi, next_byte(g));
+        for (int n = lo | (hi << 8); n > 0; n--) {
+            GET(r, next_byte(g));
+        }
+    }
+    if (h[3] & GZ_FNAME) {
+        GET(r, skip_string(g));
+    }
+    if (h[3] & GZ_FCOMMENT) {
+        GET(r, skip_string(g));
+    }
+    if (h[3] & GZ_FHCRC) {
+        GET(r, next_byte(g));
+        GET(r, next_byte(g));
+    }
+    return GUNZIP_OK;
+}
+
+static int read_le32(gunzip_t *g, uint32_t *out)
+{
+    uint32_t v = 0;
+    for (int i = 0; i < 4; i++) {
+        int b;
+        GET(b, next_byte(g));
+        v |= (uint32_t)b << (8 * i);
+    }
+    *out = v;
+    return GUNZIP_OK;
+}
+
+void gunzip_resume(gunzip_t *g, uint32_t in_offset, uint32_t out_offset, uint32_t crc)
+{
+    g->in_total = in_offset;
+    g->out_total = out_offset;
+    g->out_flushed = out_offset;
+    g->window_start = out_offset;
+    g->crc = crc;
+    g->resumed = 1;
+}
+
+int gunzip_run(gunzip_t *g)
+{
+    int r;
+    if (!g->resumed) {
+        GET(r, header(g));
+    }
+
+    int last;
+    do {
+        int type;
+        GET(last, bits(g, 1));
+        GET(type, bits(g, 2));
+        switch (type) {
+        case 0:
+            r = stored(g);
+            break;
+        case 1:
+            r = fixed(g);
+            break;
+        case 2:
+            r = dynamic(g);
+            break;
+        default:
+            r = GUNZIP_ERR_DATA;
+            break;
+        }
+        if (r < 0) {
+            return r;
+        }
+    } while (!last);
+
+    GET(r, flush(g));
+
+    /* Trailer starts at the next byte boundary */
+    g->bitbuf = 0;
+    g->bitcnt = 0;
+    uint32_t crc, isize;
+    GET(r, read_le32(g, &crc));
+    GET(r, read_le32(g, &isize));
+    if (crc != g->crc || isize != g->out_total) {
+        return GUNZIP_ERR_CHECK;
+    }
+    return GUNZIP_OK;
+}
+
+const char *gunzip_strerror(int result)
+{
+    switch (result) {
+    case GUNZIP_OK:             return "ok";
+    case GUNZIP_ERR_HEADER:     return "not a gzip stream";
+    case GUNZIP_ERR_DATA:       return "corrupt data";
+    case GUNZIP_ERR_WINDOW:     return "window too large";
+    case GUNZIP_ERR_TRUNCATED:  return "truncated";
+    case GUNZIP_ERR_READ:       return "read error";
+    case GUNZIP_ERR_WRITE:      return "write error";
+    case GUNZIP_ERR_CHECK:      return "checksum mismatch";
+    default:                    return "unknown error";
+    }
+}
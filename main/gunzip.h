@@ -0,0 +1,113 @@
+/**
+ * @file gunzip.h
+ * @brief Streaming gzip decoder with a small fixed window (host-testable)
+ *
+ * Pulls compressed bytes through a read callback and pushes the output
+ * through a write callback in window-sized pieces, so neither the
+ * compressed nor the decompressed image is ever held in RAM. The window
+ * is GUNZIP_WINDOW_SIZE bytes instead of deflate's usual 32 KB: streams
+ * must be compressed with a matching window (scripts/compress_firmware.py
+ * does), and a back-reference further than the window is rejected.
+ * The gzip CRC-32 and length are checked at the end.
+ *
+ * Decoding can restart part way through a stream at a flush point: an
+ * empty stored block, which the compressor emits on a full flush. After
+ * it no data refers back, so gunzip_resume() needs only the input and
+ * output offsets and the CRC so far, which the sync callback reports.
+ */
+
+#ifndef GUNZIP_H
+#define GUNZIP_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define GUNZIP_WINDOW_BITS 12   /**< Must match the compressor's wbits */
+#define GUNZIP_WINDOW_SIZE (1u << GUNZIP_WINDOW_BITS)
+#define GUNZIP_INPUT_SIZE 512
+
+/**
+ * @brief Result of gunzip_run()
+ */
+typedef enum {
+    GUNZIP_OK = 0,
+    GUNZIP_ERR_HEADER = -1,     /**< Not a gzip stream, or unsupported method/flags */
+    GUNZIP_ERR_DATA = -2,       /**< Corrupt deflate data */
+    GUNZIP_ERR_WINDOW = -3,     /**< Back-reference beyond GUNZIP_WINDOW_SIZE */
+    GUNZIP_ERR_TRUNCATED = -4,  /**< Input ended early */
+    GUNZIP_ERR_READ = -5,       /**< Read callback failed */
+    GUNZIP_ERR_WRITE = -6,      /**< Write callback failed */
+    GUNZIP_ERR_CHECK = -7,      /**< CRC-32 or length mismatch */
+} gunzip_result_t;
+
+/**
+ * @brief Stream endpoints
+ */
+typedef struct {
+    int (*read)(void *ctx, uint8_t *buf, size_t len);           /**< Bytes read, 0 at end of input, <0 on error */
+    int (*write)(void *ctx, const uint8_t *data, size_t len);   /**< 0 on success */
+    /** Optional: at a flush point, after all output so far has been written */
+    void (*sync)(void *ctx, uint32_t in_offset, uint32_t out_offset, uint32_t crc);
+    void *ctx;
+} gunzip_io_t;
+
+/**
+ * @brief Canonical Huffman code: codes per length, then symbols in code order
+ */
+typedef struct {
+    uint16_t count[16];
+    uint16_t *symbol;
+} gunzip_huffman_t;
+
+/**
+ * @brief Decoder state, about 5.5 KB (allocate it, don't put it on a task stack)
+ */
+typedef struct {
+    gunzip_io_t io;
+    uint8_t window[GUNZIP_WINDOW_SIZE];
+    uint8_t in[GUNZIP_INPUT_SIZE];
+    size_t in_len;
+    size_t in_pos;
+    uint32_t bitbuf;
+    int bitcnt;
+    int err;
+    uint32_t out_total;         /**< Bytes decompressed */
+    uint32_t out_flushed;       /**< Bytes passed to write */
+    uint32_t in_total;          /**< Bytes read */
+    uint32_t window_start;      /**< Output offset the window history starts at */
+    int resumed;                /**< Started mid-stream: no header to parse */
+    uint32_t crc;
+    gunzip_huffman_t lencode;
+    gunzip_huffman_t distcode;
+    uint16_t lensym[288];
+    uint16_t distsym[30];
+    uint16_t lengths[320];
+} gunzip_t;
+
+void gunzip_init(gunzip_t *g, const gunzip_io_t *io);
+
+/**
+ * @brief Continue a stream from a flush point reported by the sync callback
+ *
+ * Call after gunzip_init(); the read callback must then deliver input
+ * starting at in_offset.
+ */
+void gunzip_resume(gunzip_t *g, uint32_t in_offset, uint32_t out_offset, uint32_t crc);
+
+/**
+ * @brief Decode one gzip member to completion
+ * @return GUNZIP_OK or a negative gunzip_result_t
+ */
+int gunzip_run(gunzip_t *g);
+
+/**
+ * @brief Check for the gzip magic (1f 8b)
+ */
+int gunzip_is_gzip(const uint8_t *data, size_t len);
+
+/**
+ * @brief Short description of a gunzip_result_t for logs
+ */
+const char *gunzip_strerror(int result);
+
+#endif /* GUNZIP_H */
@@ -0,0 +1,237 @@
+/**
+ * @file ha_discovery.c
+ * @brief Home Assistant MQTT discovery payloads (host-testable)
+ */
+
+#include "ha_discovery.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+#define ORIGIN_NAME "Thermux"
+#define ORIGIN_URL  "https://github.com/sslivins/thermux"
+
+const ha_diag_entity_t ha_diag_entities[] = {
+    { "binary_sensor", "ethernet", "Ethernet", "ethernet", "connectivity", NULL, NULL, NULL },
+    { "binary_sensor", "wifi", "WiFi", "wifi", "connectivity", NULL, NULL, NULL },
+    { "sensor", "ip_address", "IP Address", "ip", NULL, "mdi:ip-network", NULL, NULL },
+    { "sensor", "bus_error_rate", "Bus Error Rate", "bus_error_rate", NULL,
+      "mdi:alert-circle-outline", "%", "measurement" },
+    { "sensor", "bus_total_reads", "Bus Total Reads", "bus_total_reads", NULL,
+      "mdi:counter", NULL, "total_increasing" },
+    { "sensor", "bus_failed_reads", "Bus Failed Reads", "bus_failed_reads", NULL,
+      "mdi:alert-circle", NULL, "total_increasing" },
+    { "sensor", "buffer_depth", "Buffered Readings", "buffer_depth", NULL,
+      "mdi:tray-full", NULL, "measurement" },
+    { "sensor", "buffer_dropped", "Dropped Readings", "buffer_dropped", NULL,
+      "mdi:tray-remove", NULL, "total_increasing" },
+    { "sensor", "replay_rate", "Replay Rate", "replay_rate", NULL,
+      "mdi:tray-arrow-up", "readings/s", "measurement" },
+};
+
+const size_t ha_diag_entity_count = sizeof(ha_diag_entities) / sizeof(ha_diag_entities[0]);
+
+/**
+ * @brief Full or abbreviated discovery keys
+ *
+ * Legacy payloads keep the long keys they have always used; the device
+ * payload uses HA's abbreviations since it carries every component.
+ */
+typedef struct {
+    const char *name;
+    const char *unique_id;
+    const char *state_topic;
+    const char *availability_topic;
+    const char *device_class;
+    const char *icon;
+    const char *entity_category;
+    const char *unit;
+    const char *state_class;
+    const char *payload_on;
+    const char *payload_off;
+} keys_t;
+
+static const keys_t s_full_keys = {
+    "name", "unique_id", "state_topic", "availability_topic", "device_class", "icon",
+    "entity_category", "unit_of_measurement", "state_class", "payload_on", "payload_off",
+};
+
+static const keys_t s_short_keys = {
+    "name", "uniq_id", "stat_t", "avty_t", "dev_cla", "ic",
+    "ent_cat", "unit_of_meas", "stat_cla", "pl_on", "pl_off",
+};
+
+/**
+ * @brief Result of the snprintf that wrote a topic: its length, -1 if it did not fit
+ */
+static int topic_length(size_t size, int len)
+{
+    return (len < 0 || (size_t)len >= size) ? -1 : len;
+}
+
+int ha_discovery_entity_topic(char *buf, size_t size, const ha_node_t *node,
+                              const char *component, const char *object_id)
+{
+    return topic_length(size, snprintf(buf, size, "%s/%s/%s_%s/config",
+                                       node->discovery_prefix, component,
+                                       node->base_topic, object_id));
+}
+
+int ha_discovery_device_topic(char *buf, size_t size, const ha_node_t *node)
+{
+    return topic_length(size, snprintf(buf, size, "%s/device/%s/config",
+                                       node->discovery_prefix, node->base_topic));
+}
+
+/**
+ * @brief Write a formatted string value (topics and unique_ids)
+ */
+static void write_format(json_writer_t *w, const char *fmt, ...)
+{
+    char value[160];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(value, sizeof(value), fmt, args);
+    va_end(args);
+    json_writer_string(w, value);
+}
+
+static void write_sensor_fields(json_writer_t *w, const keys_t *k, const ha_node_t *node,
+                                const ha_sensor_t *sensor)
+{
+    json_writer_kv_string(w, k->name, sensor->name);
+    json_writer_key(w, k->unique_id);
+    write_format(w, "%s_%s", node->base_topic, sensor->id);
+    json_writer_key(w, k->state_topic);
+    write_format(w, "%s/sensor/%s/state", node->base_topic, sensor->id);
+}
+
+static void write_diag_fields(json_writer_t *w, const keys_t *k, const ha_node_t *node,
+                              const ha_diag_entity_t *e)
+{
+    json_writer_kv_string(w, k->name, e->name);
+    json_writer_key(w, k->unique_id);
+    write_format(w, "%s_%s", node->base_topic, e->object_id);
+    json_writer_key(w, k->state_topic);
+    write_format(w, "%s/diagnostic/%s", node->base_topic, e->state_suffix);
+}
+
+static void write_diag_attributes(json_writer_t *w, const keys_t *k, const ha_diag_entity_t *e)
+{
+    if (e->device_class) {
+        json_writer_kv_string(w, k->device_class, e->device_class);
+    }
+    if (e->icon) {
+        json_writer_kv_string(w, k->icon, e->icon);
+    }
+    json_writer_kv_string(w, k->entity_category, "diagnostic");
+    if (e->unit) {
+        json_writer_kv_string(w, k->unit, e->unit);
+    }
+    if (e->state_class) {
+        json_writer_kv_string(w, k->state_class, e->state_class);
+    }
+    if (strcmp(e->component, "binary_sensor") == 0) {
+        json_writer_kv_string(w, k->payload_on, "ON");
+        json_writer_kv_string(w, k->payload_off, "OFF");
+    }
+}
+
+static void write_temperature_attributes(json_writer_t *w, const keys_t *k)
+{
+    json_writer_kv_string(w, k->device_class, "temperature");
+    json_writer_kv_string(w, k->unit, "°C");
+    json_writer_kv_string(w, k->state_class, "measurement");
+}
+
+void ha_discovery_write_device(json_writer_t *w, const ha_node_t *node)
+{
+    json_writer_begin_object(w);
+    json_writer_kv_string(w, "name", "Thermux");
+    json_writer_kv_string(w, "manufacturer", "Custom");
+    json_writer_kv_string(w, "model", "ESP32-POE-ISO");
+    json_writer_kv_string(w, "sw_version", node->sw_version);
+    json_writer_key(w, "identifiers");
+    json_writer_begin_array(w);
+    json_writer_string(w, node->base_topic);
+    json_writer_end_array(w);
+    json_writer_end_object(w);
+}
+
+void ha_discovery_write_sensor_config(json_writer_t *w, const ha_node_t *node, const ha_sensor_t *sensor)
+{
+    json_writer_begin_object(w);
+    write_sensor_fields(w, &s_full_keys, node, sensor);
+    json_writer_key(w, s_full_keys.availability_topic);
+    write_format(w, "%s/status", node->base_topic);
+    write_temperature_attributes(w, &s_full_keys);
+    json_writer_key(w, "device");
+    ha_discovery_write_device(w, node);
+    json_writer_end_object(w);
+}
+
+void ha_discovery_write_diag_config(json_writer_t *w, const ha_node_t *node, const ha_diag_entity_t *entity)
+{
+    json_writer_begin_object(w);
+    write_diag_fields(w, &s_full_keys, node, entity);
+    json_writer_key(w, s_full_keys.availability_topic);
+    write_format(w, "%s/status", node->base_topic);
+    write_diag_attributes(w, &s_full_keys, entity);
+    json_writer_key(w, "device");
+    ha_discovery_write_device(w, node);
+    json_writer_end_object(w);
+}
+
+void ha_discovery_write_device_config(json_writer_t *w, const ha_node_t *node,
+                                      const ha_sensor_t *sensors, size_t sensor_count)
+{
+    json_writer_begin_object(w);
+
+    json_writer_key(w, "dev");
+    json_writer_begin_object(w);
+    json_writer_key(w, "ids");
+    json_writer_begin_array(w);
+    json_writer_string(w, node->base_topic);
+    json_writer_end_array(w);
+    json_writer_kv_string(w, "name", "Thermux");
+    json_writer_kv_string(w, "mf", "Custom");
+    json_writer_kv_string(w, "mdl", "ESP32-POE-ISO");
+    json_writer_kv_string(w, "sw", node->sw_version);
+    json_writer_end_object(w);
+
+    json_writer_key(w, "o");
+    json_writer_begin_object(w);
+    json_writer_kv_string(w, "name", ORIGIN_NAME);
+    json_writer_kv_string(w, "sw", node->sw_version);
+    json_writer_kv_string(w, "url", ORIGIN_URL);
+    json_writer_end_object(w);
+
+    /* Shared by every component */
+    json_writer_key(w, s_short_keys.availability_topic);
+    write_format(w, "%s/status", node->base_topic);
+
+    json_writer_key(w, "cmps");
+    json_writer_begin_object(w);
+
+    for (size_t i = 0; i < sensor_count; i++) {
+        json_writer_key(w, sensors[i].id);
+        json_writer_begin_object(w);
+        json_writer_kv_string(w, "p", "sensor");
+        write_sensor_fields(w, &s_short_keys, node, &sensors[i]);
+        write_temperature_attributes(w, &s_short_keys);
+        json_writer_end_object(w);
+    }
+
+    for (size_t i = 0; i < ha_diag_entity_count; i++) {
+        const ha_diag_entity_t *e = &ha_diag_entities[i];
+        json_writer_key(w, e->object_id);
+        json_writer_begin_object(w);
+        json_writer_kv_string(w, "p", e->component);
+        write_diag_fields(w, &s_short_keys, node, e);
+        write_diag_attributes(w, &s_short_keys, e);
+        json_writer_end_object(w);
+    }
+
+    json_writer_end_object(w);
+    json_writer_end_object(w);
+}
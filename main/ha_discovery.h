@@ -0,0 +1,92 @@
+/**
+ * @file ha_discovery.h
+ * @brief Home Assistant MQTT discovery payloads (host-testable)
+ *
+ * Supports both the legacy per-entity format (one retained config message
+ * per entity, each repeating the device block) and the device-based format
+ * (HA 2024.11+), where a single retained message on
+ * <prefix>/device/<base_topic>/config describes every component.
+ */
+
+#ifndef HA_DISCOVERY_H
+#define HA_DISCOVERY_H
+
+#include "json_writer.h"
+#include <stddef.h>
+
+/**
+ * @brief Diagnostic entity description
+ */
+typedef struct {
+    const char *component;     /**< HA component: "sensor" or "binary_sensor" */
+    const char *object_id;     /**< Suffix for unique_id and discovery topic */
+    const char *name;          /**< Entity name shown in HA */
+    const char *state_suffix;  /**< State topic: base_topic/diagnostic/<suffix> */
+    const char *device_class;  /**< Optional */
+    const char *icon;          /**< Optional */
+    const char *unit;          /**< Optional */
+    const char *state_class;   /**< Optional */
+} ha_diag_entity_t;
+
+/** @brief Diagnostic entities published by every node */
+extern const ha_diag_entity_t ha_diag_entities[];
+extern const size_t ha_diag_entity_count;
+
+/**
+ * @brief Temperature sensor as seen by discovery
+ */
+typedef struct {
+    const char *id;     /**< Address string */
+    const char *name;   /**< Display name */
+} ha_sensor_t;
+
+/**
+ * @brief Node identity shared by all entities
+ */
+typedef struct {
+    const char *discovery_prefix;  /**< HA discovery prefix ("homeassistant") */
+    const char *base_topic;        /**< MQTT base topic, also the device identifier */
+    const char *sw_version;        /**< Firmware version */
+} ha_node_t;
+
+/**
+ * @brief Legacy per-entity discovery topic
+ *
+ * <prefix>/<component>/<base_topic>_<object_id>/config
+ *
+ * @return Topic length, or -1 if it does not fit
+ */
+int ha_discovery_entity_topic(char *buf, size_t size, const ha_node_t *node,
+                              const char *component, const char *object_id);
+
+/**
+ * @brief Device-based discovery topic: <prefix>/device/<base_topic>/config
+ * @return Topic length, or -1 if it does not fit
+ */
+int ha_discovery_device_topic(char *buf, size_t size, const ha_node_t *node);
+
+/**
+ * @brief Write the device info object
+ */
+void ha_discovery_write_device(json_writer_t *w, const ha_node_t *node);
+
+/**
+ * @brief Write a legacy per-entity config for a temperature sensor
+ */
+void ha_discovery_write_sensor_config(json_writer_t *w, const ha_node_t *node, const ha_sensor_t *sensor);
+
+/**
+ * @brief Write a legacy per-entity config for a diagnostic entity
+ */
+void ha_discovery_write_diag_config(json_writer_t *w, const ha_node_t *node, const ha_diag_entity_t *entity);
+
+/**
+ * @brief Write the device-based config describing all sensors and diagnostics
+ *
+ * Component configs use HA's abbreviated keys. Components keep the same
+ * unique_ids as the legacy format, so entities migrate in place.
+ */
+void ha_discovery_write_device_config(json_writer_t *w, const ha_node_t *node,
+                                      const ha_sensor_t *sensors, size_t sensor_count);
+
+#endif /* HA_DISCOVERY_H */
@@ -0,0 +1,52 @@
+/**
+ * @file history.c
+ * @brief Fixed-size ring of past readings with sequence cursors (host-testable)
+ */
+
+#include "history.h"
+#include <string.h>
+
+void history_init(history_t *h, history_record_t *records, size_t capacity)
+{
+    h->records = records;
+    h->capacity = capacity;
+    h->head = 0;
+    h->count = 0;
+    h->written = 0;
+}
+
+void history_push(history_t *h, const history_record_t *rec)
+{
+    if (h->capacity == 0) {
+        return;
+    }
+    h->records[h->head] = *rec;
+    h->head = (h->head + 1) % h->capacity;
+    if (h->count < h->capacity) {
+        h->count++;
+    }
+    h->written++;
+}
+
+size_t history_read(const history_t *h, uint32_t *cursor, history_record_t *out, size_t max)
+{
+    uint32_t oldest = h->written - (uint32_t)h->count;
+    uint32_t behind = h->written - *cursor;
+    if (behind > h->count) {
+        *cursor = oldest;   /* Overwritten or from the future */
+        behind = (uint32_t)h->count;
+    }
+
+    size_t n = behind < max ? behind : max;
+    /* Index of the record at *cursor; head is one past the newest */
+    size_t start = (h->head + h->capacity - behind) % (h->capacity ? h->capacity : 1);
+    size_t first = h->capacity - start;
+    if (first > n) {
+        first = n;
+    }
+    memcpy(out, &h->records[start], first * sizeof(*out));
+    memcpy(out + first, h->records, (n - first) * sizeof(*out));
+
+    *cursor += (uint32_t)n;
+    return n;
+}
@@ -0,0 +1,56 @@
+/**
+ * @file history.h
+ * @brief Fixed-size ring of past readings with sequence cursors (host-testable)
+ *
+ * Every record pushed gets a sequence number (a 32-bit count since boot), so
+ * readers can walk the ring in pieces without holding a lock between them
+ * and still notice records overwritten in the meantime. Not thread-safe;
+ * sensor_manager serializes access.
+ */
+
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Stored reading
+ */
+typedef struct {
+    uint32_t timestamp;     /**< Unix time in seconds, 0 if the clock was not set */
+    uint32_t uptime_s;      /**< Seconds since boot when sampled */
+    uint8_t address[8];     /**< Sensor ROM address */
+    int16_t temp_centi;     /**< Temperature in 1/100 °C */
+} history_record_t;
+
+typedef struct {
+    history_record_t *records;  /**< Storage */
+    size_t capacity;            /**< Records in storage */
+    size_t head;                /**< Next write index */
+    size_t count;               /**< Records currently held */
+    uint32_t written;           /**< Records pushed since init - cursor space */
+} history_t;
+
+void history_init(history_t *h, history_record_t *records, size_t capacity);
+
+/**
+ * @brief Append a record, overwriting the oldest when full
+ */
+void history_push(history_t *h, const history_record_t *rec);
+
+/**
+ * @brief Copy records from a cursor position, oldest first
+ *
+ * A cursor older than the oldest held record skips ahead to it; a cursor
+ * ahead of the write position restarts at the oldest record. Cursor 0
+ * therefore always starts at the beginning.
+ *
+ * @param cursor In: sequence to read from, out: sequence after the copied records
+ * @param out Destination
+ * @param max Maximum records to copy
+ * @return Number of records copied
+ */
+size_t history_read(const history_t *h, uint32_t *cursor, history_record_t *out, size_t max);
+
+#endif /* HISTORY_H */
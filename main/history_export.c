@@ -0,0 +1,269 @@
+/**
+ * @file history_export.c
+ * @brief CSV/NDJSON/CBOR rows and filters for history export (host-testable)
+ */
+
+#include "history_export.h"
+#include "telemetry_cbor.h"
+#include <string.h>
+
+static const char s_hex[] = "0123456789ABCDEF";
+
+int history_export_parse_format(const char *name, history_export_format_t *format)
+{
+    if (strcmp(name, "csv") == 0) {
+        *format = HISTORY_EXPORT_CSV;
+    } else if (strcmp(name, "ndjson") == 0) {
+        *format = HISTORY_EXPORT_NDJSON;
+    } else if (strcmp(name, "cbor") == 0) {
+        *format = HISTORY_EXPORT_CBOR;
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+static int hex_value(char c)
+{
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    return -1;
+}
+
+/**
+ * @brief Length of the separator at pos (',' or "%2C"), 0 if none
+ */
+static size_t separator_len(const char *pos)
+{
+    if (pos[0] == ',') {
+        return 1;
+    }
+    if (pos[0] == '%' && pos[1] == '2' && (pos[2] == 'C' || pos[2] == 'c')) {
+        return 3;
+    }
+    return 0;
+}
+
+int history_export_parse_sensors(const char *list, history_export_filter_t *filter)
+{
+    filter->address_count = 0;
+    const char *pos = list;
+
+    while (*pos != '\0') {
+        if (filter->address_count >= HISTORY_EXPORT_MAX_SENSORS) {
+            return -1;
+        }
+        uint8_t *addr = filter->addresses[filter->address_count];
+        for (int i = 0; i < 8; i++) {
+            int hi = hex_value(pos[0]);
+            int lo = hi < 0 ? -1 : hex_value(pos[1]);
+            if (lo < 0) {
+                return -1;
+            }
+            addr[i] = (uint8_t)(hi << 4 | lo);
+            pos += 2;
+        }
+        filter->address_count++;
+
+        size_t sep = separator_len(pos);
+        if (sep == 0 && *pos != '\0') {
+            return -1;
+        }
+        pos += sep;
+        if (sep != 0 && *pos == '\0') {
+            return -1;  /* Trailing separator */
+        }
+    }
+    return filter->address_count > 0 ? 0 : -1;
+}
+
+bool history_export_match(const history_export_filter_t *filter, const history_record_t *rec)
+{
+    if (filter->from != 0 || filter->to != 0) {
+        if (rec->timestamp == 0 ||
+            (filter->from != 0 && rec->timestamp < filter->from) ||
+            (filter->to != 0 && rec->timestamp > filter->to)) {
+            return false;
+        }
+    }
+    if (filter->address_count == 0) {
+        return true;
+    }
+    for (size_t i = 0; i < filter->address_count; i++) {
+        if (memcmp(filter->addresses[i], rec->address, sizeof(rec->address)) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+const char *history_export_content_type(history_export_format_t format)
+{
+    switch (format) {
+    case HISTORY_EXPORT_NDJSON:
+        return "application/x-ndjson";
+    case HISTORY_EXPORT_CBOR:
+        return "application/cbor";
+    default:
+        return "text/csv";
+    }
+}
+
+const char *history_export_extension(history_export_format_t format)
+{
+    switch (format) {
+    case HISTORY_EXPORT_NDJSON:
+        return "ndjson";
+    case HISTORY_EXPORT_CBOR:
+        return "cbor";
+    default:
+        return "csv";
+    }
+}
+
+static char *put_str(char *p, const char *s)
+{
+    size_t len = strlen(s);
+    memcpy(p, s, len);
+    return p + len;
+}
+
+static char *put_uint(char *p, uint32_t v)
+{
+    char tmp[10];
+    int n = 0;
+    do {
+        tmp[n++] = (char)('0' + v % 10);
+        v /= 10;
+    } while (v != 0);
+    while (n > 0) {
+        *p++ = tmp[--n];
+    }
+    return p;
+}
+
+static char *put_address(char *p, const uint8_t *address)
+{
+    for (int i = 0; i < 8; i++) {
+        *p++ = s_hex[address[i] >> 4];
+        *p++ = s_hex[address[i] & 0x0F];
+    }
+    return p;
+}
+
+/**
+ * @brief Centidegrees as a decimal without trailing zeros ("21.5", "-0.06", "20")
+ */
+static char *put_centi(char *p, int16_t centi)
+{
+    int32_t v = centi;
+    if (v < 0) {
+        *p++ = '-';
+        v = -v;
+    }
+    p = put_uint(p, (uint32_t)(v / 100));
+    int frac = v % 100;
+    if (frac != 0) {
+        *p++ = '.';
+        *p++ = (char)('0' + frac / 10);
+        if (frac % 10 != 0) {
+            *p++ = (char)('0' + frac % 10);
+        }
+    }
+    return p;
+}
+
+/**
+ * @brief Bytes a CBOR writer produced, 0 if it overflowed
+ */
+static size_t cbor_result(cbor_writer_t *w)
+{
+    int len = cbor_writer_finish(w);
+    return len > 0 ? (size_t)len : 0;
+}
+
+size_t history_export_header(history_export_format_t format, uint32_t now, char *buf, size_t size)
+{
+    if (format == HISTORY_EXPORT_CBOR) {
+        cbor_writer_t w;
+        cbor_writer_init(&w, (uint8_t *)buf, size);
+        telemetry_cbor_begin_stream(&w, now);
+        return cbor_result(&w);
+    }
+    if (format != HISTORY_EXPORT_CSV) {
+        return 0;
+    }
+    static const char header[] = "timestamp,uptime_s,address,temperature\n";
+    if (size < sizeof(header) - 1) {
+        return 0;
+    }
+    memcpy(buf, header, sizeof(header) - 1);
+    return sizeof(header) - 1;
+}
+
+size_t history_export_footer(history_export_format_t format, char *buf, size_t size)
+{
+    if (format != HISTORY_EXPORT_CBOR) {
+        return 0;
+    }
+    cbor_writer_t w;
+    cbor_writer_init(&w, (uint8_t *)buf, size);
+    telemetry_cbor_end_stream(&w);
+    return cbor_result(&w);
+}
+
+size_t history_export_row(history_export_format_t format, const history_record_t *rec,
+                          char *buf, size_t size)
+{
+    if (size < HISTORY_EXPORT_ROW_MAX) {
+        return 0;
+    }
+
+    if (format == HISTORY_EXPORT_CBOR) {
+        telemetry_reading_t reading = {
+            .temp_centi = rec->temp_centi,
+            .timestamp = rec->timestamp,
+        };
+        memcpy(reading.rom, rec->address, sizeof(reading.rom));
+        cbor_writer_t w;
+        cbor_writer_init(&w, (uint8_t *)buf, size);
+        telemetry_cbor_add(&w, &reading);
+        return cbor_result(&w);
+    }
+
+    char *p = buf;
+    if (format == HISTORY_EXPORT_CSV) {
+        if (rec->timestamp != 0) {
+            p = put_uint(p, rec->timestamp);
+        }
+        *p++ = ',';
+        p = put_uint(p, rec->uptime_s);
+        *p++ = ',';
+        p = put_address(p, rec->address);
+        *p++ = ',';
+        p = put_centi(p, rec->temp_centi);
+    } else {
+        *p++ = '{';
+        if (rec->timestamp != 0) {
+            p = put_str(p, "\"timestamp\":");
+            p = put_uint(p, rec->timestamp);
+            *p++ = ',';
+        }
+        p = put_str(p, "\"uptime_s\":");
+        p = put_uint(p, rec->uptime_s);
+        p = put_str(p, ",\"address\":\"");
+        p = put_address(p, rec->address);
+        p = put_str(p, "\",\"temperature\":");
+        p = put_centi(p, rec->temp_centi);
+        *p++ = '}';
+    }
+    *p++ = '\n';
+    return (size_t)(p - buf);
+}
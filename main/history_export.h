@@ -0,0 +1,106 @@
+/**
+ * @file history_export.h
+ * @brief CSV/NDJSON/CBOR rows and filters for history export (host-testable)
+ *
+ * Rows are formatted one at a time into a caller buffer with hand-rolled
+ * integer formatting, so an export streams through a fixed small buffer
+ * regardless of how much history is held.
+ *
+ * A CBOR export is one telemetry batch (telemetry_cbor.h) whose readings
+ * array is streamed with an indefinite length: the header opens it, each
+ * row is one reading and the footer closes it. The batch time is the
+ * time of the export; uptime is not part of that schema.
+ */
+
+#ifndef HISTORY_EXPORT_H
+#define HISTORY_EXPORT_H
+
+#include "history.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/** @brief Longest row any format produces, including the newline */
+#define HISTORY_EXPORT_ROW_MAX 112
+
+/** @brief Largest document footer */
+#define HISTORY_EXPORT_FOOTER_MAX 1
+
+/** @brief Sensors accepted in one sensors= list */
+#define HISTORY_EXPORT_MAX_SENSORS 16
+
+typedef enum {
+    HISTORY_EXPORT_CSV = 0,
+    HISTORY_EXPORT_NDJSON,
+    HISTORY_EXPORT_CBOR,
+} history_export_format_t;
+
+/**
+ * @brief Record filter; empty address list and zero bounds match everything
+ */
+typedef struct {
+    uint8_t addresses[HISTORY_EXPORT_MAX_SENSORS][8];
+    size_t address_count;
+    uint32_t from;          /**< Earliest Unix time (inclusive), 0 = unbounded */
+    uint32_t to;            /**< Latest Unix time (inclusive), 0 = unbounded */
+} history_export_filter_t;
+
+/**
+ * @brief Parse a format= value ("csv", "ndjson" or "cbor")
+ * @return 0 on success, -1 if unknown
+ */
+int history_export_parse_format(const char *name, history_export_format_t *format);
+
+/**
+ * @brief Parse a sensors= list of 16-digit hex addresses
+ *
+ * Separated by ',' (also accepted URL-encoded as %2C).
+ *
+ * @return 0 on success, -1 on a malformed address or too many sensors
+ */
+int history_export_parse_sensors(const char *list, history_export_filter_t *filter);
+
+/**
+ * @brief Whether a record passes the filter
+ *
+ * Records without a Unix time only match when neither bound is set.
+ */
+bool history_export_match(const history_export_filter_t *filter, const history_record_t *rec);
+
+/**
+ * @brief MIME type of a format
+ */
+const char *history_export_content_type(history_export_format_t format);
+
+/**
+ * @brief File name extension of a format ("csv", "ndjson", "cbor")
+ */
+const char *history_export_extension(history_export_format_t format);
+
+/**
+ * @brief Write the document header
+ *
+ * CSV column names, the batch header for CBOR, nothing for NDJSON.
+ *
+ * @param now Unix time of the export (CBOR batch time), 0 if unknown
+ * @return Bytes written (not NUL-terminated), 0 if nothing or it does not fit
+ */
+size_t history_export_header(history_export_format_t format, uint32_t now, char *buf, size_t size);
+
+/**
+ * @brief Write what ends the document (the CBOR break; nothing otherwise)
+ * @return Bytes written, 0 if nothing or it does not fit
+ */
+size_t history_export_footer(history_export_format_t format, char *buf, size_t size);
+
+/**
+ * @brief Write one record as a row ending in '\n', or as one CBOR reading
+ *
+ * An unknown timestamp is left empty in CSV, omitted in NDJSON and 0 in CBOR.
+ *
+ * @return Bytes written (not NUL-terminated), 0 if it does not fit
+ */
+size_t history_export_row(history_export_format_t format, const history_record_t *rec,
+                          char *buf, size_t size);
+
+#endif /* HISTORY_EXPORT_H */
@@ -0,0 +1,79 @@
+/**
+ * @file http_etag.c
+ * @brief ETag formatting and If-None-Match matching (host-testable)
+ */
+
+#include "http_etag.h"
+#include <stdio.h>
+#include <string.h>
+
+int http_etag_format(char *buf, size_t size, bool weak, const char *prefix, uint32_t value)
+{
+    int len = snprintf(buf, size, "%s\"%s-%lx\"", weak ? "W/" : "", prefix, (unsigned long)value);
+    if (len < 0 || (size_t)len >= size) {
+        return -1;
+    }
+    return len;
+}
+
+/**
+ * @brief Strip the weak indicator from an entity tag
+ */
+static const char *opaque_tag(const char *tag, size_t *len)
+{
+    if (*len >= 2 && tag[0] == 'W' && tag[1] == '/') {
+        *len -= 2;
+        return tag + 2;
+    }
+    return tag;
+}
+
+bool http_etag_match(const char *if_none_match, const char *etag)
+{
+    size_t etag_len = strlen(etag);
+    const char *current = opaque_tag(etag, &etag_len);
+    const char *pos = if_none_match;
+
+    while (*pos != '\0') {
+        while (*pos == ' ' || *pos == '\t' || *pos == ',') {
+            pos++;
+        }
+        if (*pos == '\0') {
+            break;
+        }
+        if (*pos == '*') {
+            return true;
+        }
+
+        /* Entity tags are quoted and may contain commas */
+        const char *start = pos;
+        if (pos[0] == 'W' && pos[1] == '/') {
+            pos += 2;
+        }
+        if (*pos == '"') {
+            const char *close = strchr(pos + 1, '"');
+            pos = close != NULL ? close + 1 : pos + strlen(pos);
+        } else {
+            while (*pos != '\0' && *pos != ',') {
+                pos++;
+            }
+        }
+
+        size_t len = (size_t)(pos - start);
+        const char *candidate = opaque_tag(start, &len);
+        if (len == etag_len && strncmp(candidate, current, len) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+uint32_t http_etag_hash(uint32_t hash, const void *data, size_t len)
+{
+    const uint8_t *bytes = data;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= bytes[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
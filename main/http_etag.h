@@ -0,0 +1,45 @@
+/**
+ * @file http_etag.h
+ * @brief ETag formatting and If-None-Match matching (host-testable)
+ */
+
+#ifndef HTTP_ETAG_H
+#define HTTP_ETAG_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/** @brief Buffer size that fits any ETag built from a prefix of up to 24 chars */
+#define HTTP_ETAG_MAX_LEN 40
+
+/** @brief Initial value for http_etag_hash() */
+#define HTTP_ETAG_HASH_INIT 2166136261u
+
+/**
+ * @brief Format an entity tag: "<prefix>-<value in hex>", or W/"..." if weak
+ *
+ * @return Length written, or -1 if it does not fit
+ */
+int http_etag_format(char *buf, size_t size, bool weak, const char *prefix, uint32_t value);
+
+/**
+ * @brief Check an If-None-Match header against the current entity tag
+ *
+ * Uses the weak comparison required for If-None-Match: W/ prefixes are
+ * ignored on both sides. Handles "*" and comma-separated lists.
+ *
+ * @param if_none_match Header value
+ * @param etag Current entity tag as sent in the ETag header
+ * @return true if the client's copy is current (answer 304)
+ */
+bool http_etag_match(const char *if_none_match, const char *etag);
+
+/**
+ * @brief Fold bytes into a 32-bit FNV-1a hash
+ *
+ * Start from HTTP_ETAG_HASH_INIT and chain calls to hash several fields.
+ */
+uint32_t http_etag_hash(uint32_t hash, const void *data, size_t len);
+
+#endif /* HTTP_ETAG_H */
@@ -0,0 +1,282 @@
+/**
+ * @file json_scan.c
+ * @brief Incremental JSON scanner that reports string values (host-testable)
+ */
+
+#include "json_scan.h"
+#include <string.h>
+
+enum {
+    ST_VALUE,           /* A value must follow */
+    ST_VALUE_OR_END,    /* First array element, or ] */
+    ST_KEY,             /* A member name must follow */
+    ST_KEY_OR_END,      /* First member name, or } */
+    ST_COLON,
+    ST_AFTER,           /* After a value: , or a closing bracket */
+    ST_STRING,
+    ST_ESCAPE,
+    ST_UNICODE,
+    ST_LITERAL,         /* Number, true, false, null */
+    ST_DONE,
+};
+
+void json_scan_init(json_scan_t *s, json_scan_string_cb on_string, json_scan_close_cb on_close, void *ctx)
+{
+    memset(s, 0, sizeof(*s));
+    s->on_string = on_string;
+    s->on_close = on_close;
+    s->ctx = ctx;
+    s->state = ST_VALUE;
+}
+
+static bool is_space(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+static bool is_literal(char c)
+{
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+           c == '-' || c == '+' || c == '.';
+}
+
+static bool top_is_object(const json_scan_t *s)
+{
+    return (s->objects >> (s->depth - 1)) & 1u;
+}
+
+/* ===== Strings ===== */
+
+static void begin_string(json_scan_t *s, bool key, uint8_t ret_state)
+{
+    s->in_key = key;
+    s->len = 0;
+    s->truncated = false;
+    s->ret_state = ret_state;
+    s->state = ST_STRING;
+}
+
+static void append(json_scan_t *s, char c)
+{
+    char *buf = s->in_key ? s->key : s->value;
+    size_t max = s->in_key ? JSON_SCAN_KEY_MAX : JSON_SCAN_VALUE_MAX;
+    if (s->len + 1u < max) {
+        buf[s->len++] = c;
+    } else {
+        s->truncated = true;
+    }
+}
+
+static void append_codepoint(json_scan_t *s, uint16_t cp)
+{
+    if (cp < 0x80) {
+        append(s, (char)cp);
+    } else if (cp < 0x800) {
+        append(s, (char)(0xC0 | (cp >> 6)));
+        append(s, (char)(0x80 | (cp & 0x3F)));
+    } else {
+        append(s, (char)(0xE0 | (cp >> 12)));
+        append(s, (char)(0x80 | ((cp >> 6) & 0x3F)));
+        append(s, (char)(0x80 | (cp & 0x3F)));
+    }
+}
+
+static void end_string(json_scan_t *s)
+{
+    if (s->in_key) {
+        s->key[s->len] = '\0';
+        if (s->depth == 1) {
+            memcpy(s->root_key, s->key, s->len + 1u);
+        }
+    } else {
+        s->value[s->len] = '\0';
+        s->on_string(s->ctx, s, s->value, s->len);
+    }
+    s->state = s->ret_state;
+}
+
+static int escape(json_scan_t *s, char c)
+{
+    static const char FROM[] = "\"\\/bfnrt";
+    static const char TO[] = "\"\\/\b\f\n\r\t";
+    if (c == 'u') {
+        s->codepoint = 0;
+        s->hex_left = 4;
+        s->state = ST_UNICODE;
+        return JSON_SCAN_OK;
+    }
+    const char *p = strchr(FROM, c);
+    if (c == '\0' || p == NULL) {
+        return JSON_SCAN_ERR_SYNTAX;
+    }
+    append(s, TO[p - FROM]);
+    s->state = ST_STRING;
+    return JSON_SCAN_OK;
+}
+
+static int unicode_digit(json_scan_t *s, char c)
+{
+    int v;
+    if (c >= '0' && c <= '9') {
+        v = c - '0';
+    } else if (c >= 'a' && c <= 'f') {
+        v = c - 'a' + 10;
+    } else if (c >= 'A' && c <= 'F') {
+        v = c - 'A' + 10;
+    } else {
+        return JSON_SCAN_ERR_SYNTAX;
+    }
+    s->codepoint = (uint16_t)((s->codepoint << 4) | v);
+    if (--s->hex_left == 0) {
+        append_codepoint(s, s->codepoint);  /* Surrogate halves are passed through as-is */
+        s->state = ST_STRING;
+    }
+    return JSON_SCAN_OK;
+}
+
+/* ===== Structure ===== */
+
+static int open_container(json_scan_t *s, bool object)
+{
+    if (s->depth == JSON_SCAN_MAX_DEPTH) {
+        return JSON_SCAN_ERR_DEPTH;
+    }
+    if (object) {
+        s->objects |= 1u << s->depth;
+    } else {
+        s->objects &= ~(1u << s->depth);
+    }
+    s->depth++;
+    s->key[0] = '\0';
+    s->state = object ? ST_KEY_OR_END : ST_VALUE_OR_END;
+    return JSON_SCAN_OK;
+}
+
+static int close_container(json_scan_t *s, char c)
+{
+    if (s->depth == 0 || top_is_object(s) != (c == '}')) {
+        return JSON_SCAN_ERR_SYNTAX;
+    }
+    if (s->on_close != NULL) {
+        s->on_close(s->ctx, s);
+    }
+    s->depth--;
+    s->key[0] = '\0';
+    s->state = (s->depth == 0) ? ST_DONE : ST_AFTER;
+    return JSON_SCAN_OK;
+}
+
+/**
+ * @brief Start a value in ST_VALUE / ST_VALUE_OR_END
+ */
+static int value(json_scan_t *s, char c)
+{
+    uint8_t after = (s->depth == 0) ? ST_DONE : ST_AFTER;
+    if (c == '{' || c == '[') {
+        return open_container(s, c == '{');
+    }
+    if (c == '"') {
+        begin_string(s, false, after);
+        return JSON_SCAN_OK;
+    }
+    if (is_literal(c)) {
+        s->state = ST_LITERAL;
+        return JSON_SCAN_OK;
+    }
+    return JSON_SCAN_ERR_SYNTAX;
+}
+
+static int step(json_scan_t *s, char c)
+{
+    switch (s->state) {
+    case ST_STRING:
+        if (c == '"') {
+            end_string(s);
+        } else if (c == '\\') {
+            s->state = ST_ESCAPE;
+        } else if ((unsigned char)c < 0x20) {
+            return JSON_SCAN_ERR_SYNTAX;
+        } else {
+            append(s, c);
+        }
+        return JSON_SCAN_OK;
+    case ST_ESCAPE:
+        return escape(s, c);
+    case ST_UNICODE:
+        return unicode_digit(s, c);
+    case ST_LITERAL:
+        if (is_literal(c)) {
+            return JSON_SCAN_OK;
+        }
+        s->state = (s->depth == 0) ? ST_DONE : ST_AFTER;
+        return step(s, c);
+    default:
+        break;
+    }
+
+    if (is_space(c)) {
+        return JSON_SCAN_OK;
+    }
+    switch (s->state) {
+    case ST_VALUE_OR_END:
+        if (c == ']') {
+            return close_container(s, c);
+        }
+        return value(s, c);
+    case ST_VALUE:
+        return value(s, c);
+    case ST_KEY_OR_END:
+        if (c == '}') {
+            return close_container(s, c);
+        }
+        /* fall through */
+    case ST_KEY:
+        if (c != '"') {
+            return JSON_SCAN_ERR_SYNTAX;
+        }
+        begin_string(s, true, ST_COLON);
+        return JSON_SCAN_OK;
+    case ST_COLON:
+        if (c != ':') {
+            return JSON_SCAN_ERR_SYNTAX;
+        }
+        s->state = ST_VALUE;
+        return JSON_SCAN_OK;
+    case ST_AFTER:
+        if (c == ',') {
+            if (top_is_object(s)) {
+                s->state = ST_KEY;
+            } else {
+                s->key[0] = '\0';
+                s->state = ST_VALUE;
+            }
+            return JSON_SCAN_OK;
+        }
+        if (c == '}' || c == ']') {
+            return close_container(s, c);
+        }
+        return JSON_SCAN_ERR_SYNTAX;
+    default:
+        return JSON_SCAN_ERR_SYNTAX;    /* Anything but whitespace after the document */
+    }
+}
+
+int json_scan_feed(json_scan_t *s, const char *data, size_t len)
+{
+    for (size_t i = 0; i < len && s->error == JSON_SCAN_OK; i++) {
+        s->error = step(s, data[i]);
+    }
+    return s->error;
+}
+
+int json_scan_finish(const json_scan_t *s)
+{
+    if (s->error != JSON_SCAN_OK) {
+        return s->error;
+    }
+    /* A bare number at the root has no terminator of its own */
+    if (s->state == ST_DONE || (s->state == ST_LITERAL && s->depth == 0)) {
+        return JSON_SCAN_OK;
+    }
+    return JSON_SCAN_ERR_INCOMPLETE;
+}
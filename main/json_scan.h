@@ -0,0 +1,90 @@
+/**
+ * @file json_scan.h
+ * @brief Incremental JSON scanner that reports string values (host-testable)
+ *
+ * Takes a document in arbitrary pieces, as they arrive from the network,
+ * and calls back for every string value with the key it belongs to, the
+ * nesting depth and the key it sits under in the root object. Nothing
+ * else is kept: no tree, no copy of the document, just the current key
+ * and up to JSON_SCAN_VALUE_MAX bytes of the current value. Longer values
+ * are cut short and flagged. Numbers, booleans and null are skipped.
+ *
+ * The scanner checks structure (nesting, separators) but not every detail
+ * of the grammar; a malformed document may be reported as an error late
+ * or not at all, so callers must still validate what they extract.
+ */
+
+#ifndef JSON_SCAN_H
+#define JSON_SCAN_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define JSON_SCAN_MAX_DEPTH 32      /**< One bit per level in json_scan_t.objects */
+#define JSON_SCAN_KEY_MAX 32        /**< Including the terminator; longer keys are cut */
+#define JSON_SCAN_VALUE_MAX 256     /**< Including the terminator; longer values are cut */
+
+/**
+ * @brief Result of json_scan_feed() / json_scan_finish()
+ */
+typedef enum {
+    JSON_SCAN_OK = 0,
+    JSON_SCAN_ERR_SYNTAX = -1,      /**< Unexpected character */
+    JSON_SCAN_ERR_DEPTH = -2,       /**< Nested deeper than JSON_SCAN_MAX_DEPTH */
+    JSON_SCAN_ERR_INCOMPLETE = -3,  /**< Document ended early */
+} json_scan_result_t;
+
+typedef struct json_scan json_scan_t;
+
+/**
+ * @brief Called for each string value (object members and array elements)
+ *
+ * s->key is the member name ("" in an array), s->depth the number of open
+ * containers and s->root_key the root object member the value is nested
+ * in. value is NUL-terminated; s->truncated is set if it was cut short.
+ */
+typedef void (*json_scan_string_cb)(void *ctx, const json_scan_t *s, const char *value, size_t len);
+
+/**
+ * @brief Called when an object or array closes; s->depth still counts it
+ */
+typedef void (*json_scan_close_cb)(void *ctx, const json_scan_t *s);
+
+/**
+ * @brief Scanner state, a few hundred bytes (stack-allocate, initialize with json_scan_init)
+ */
+struct json_scan {
+    json_scan_string_cb on_string;
+    json_scan_close_cb on_close;    /**< Can be NULL */
+    void *ctx;
+    uint32_t objects;       /**< Bit per depth: 1 = object, 0 = array */
+    uint8_t depth;
+    uint8_t state;
+    uint8_t ret_state;      /**< State to return to after a string */
+    uint8_t hex_left;       /**< Hex digits still to read in a \u escape */
+    bool in_key;            /**< The string being read is a member name */
+    bool truncated;
+    int error;              /**< Sticky */
+    uint16_t codepoint;
+    uint16_t len;
+    char key[JSON_SCAN_KEY_MAX];
+    char root_key[JSON_SCAN_KEY_MAX];
+    char value[JSON_SCAN_VALUE_MAX];
+};
+
+void json_scan_init(json_scan_t *s, json_scan_string_cb on_string, json_scan_close_cb on_close, void *ctx);
+
+/**
+ * @brief Scan the next piece of the document
+ * @return JSON_SCAN_OK or a negative json_scan_result_t (sticky)
+ */
+int json_scan_feed(json_scan_t *s, const char *data, size_t len);
+
+/**
+ * @brief Check that one complete value was scanned
+ * @return JSON_SCAN_OK, the sticky error, or JSON_SCAN_ERR_INCOMPLETE
+ */
+int json_scan_finish(const json_scan_t *s);
+
+#endif /* JSON_SCAN_H */
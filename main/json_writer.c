@@ -0,0 +1,324 @@
+/**
+ * @file json_writer.c
+ * @brief Streaming JSON writer with fixed buffer or chunked sink (host-testable)
+ */
+
+#include "json_writer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+
+/**
+ * @brief Hand pending bytes to the sink
+ */
+static void flush(json_writer_t *w)
+{
+    if (w->len == 0 || w->error) {
+        return;
+    }
+    if (w->sink(w->sink_ctx, w->buf, w->len) != 0) {
+        w->error = true;
+        return;
+    }
+    w->flushed += w->len;
+    w->len = 0;
+}
+
+static void put(json_writer_t *w, const char *data, size_t len)
+{
+    if (w->error) {
+        return;
+    }
+
+    if (w->sink == NULL) {
+        /* Fixed-buffer mode: keep one byte for the terminator */
+        if (w->len + len >= w->buf_size) {
+            w->error = true;
+            return;
+        }
+        memcpy(w->buf + w->len, data, len);
+        w->len += len;
+        return;
+    }
+
+    while (len > 0 && !w->error) {
+        size_t room = w->buf_size - w->len;
+        if (room == 0) {
+            flush(w);
+            continue;
+        }
+        size_t n = len < room ? len : room;
+        memcpy(w->buf + w->len, data, n);
+        w->len += n;
+        data += n;
+        len -= n;
+    }
+}
+
+static void put_char(json_writer_t *w, char c)
+{
+    if (!w->error && w->len + 1 < w->buf_size) {
+        w->buf[w->len++] = c;  /* Fast path, never reaches the last byte */
+        return;
+    }
+    put(w, &c, 1);
+}
+
+/**
+ * @brief Emit a separating comma if the current container already has members
+ */
+static void begin_value(json_writer_t *w)
+{
+    if (w->after_key) {
+        w->after_key = false;
+        return;
+    }
+    uint32_t bit = 1u << w->depth;
+    if (w->has_items & bit) {
+        put_char(w, ',');
+    }
+    w->has_items |= bit;
+}
+
+static void put_escaped(json_writer_t *w, const char *str)
+{
+    static const char hex[] = "0123456789abcdef";
+    const char *run = str;
+
+    put_char(w, '"');
+    for (const char *p = str; *p; p++) {
+        unsigned char c = (unsigned char)*p;
+        if (c >= 0x20 && c != '"' && c != '\\') {
+            continue;
+        }
+
+        /* Copy the unescaped run in one go, then the escape sequence */
+        put(w, run, p - run);
+        run = p + 1;
+
+        char esc[6] = {'\\', 0};
+        size_t esc_len = 2;
+        switch (c) {
+        case '"':  esc[1] = '"';  break;
+        case '\\': esc[1] = '\\'; break;
+        case '\b': esc[1] = 'b';  break;
+        case '\f': esc[1] = 'f';  break;
+        case '\n': esc[1] = 'n';  break;
+        case '\r': esc[1] = 'r';  break;
+        case '\t': esc[1] = 't';  break;
+        default:
+            esc[1] = 'u';
+            esc[2] = '0';
+            esc[3] = '0';
+            esc[4] = hex[c >> 4];
+            esc[5] = hex[c & 0x0f];
+            esc_len = 6;
+            break;
+        }
+        put(w, esc, esc_len);
+    }
+    put(w, run, strlen(run));
+    put_char(w, '"');
+}
+
+static void put_uint(json_writer_t *w, uint64_t value)
+{
+    char digits[20];
+    int n = 0;
+    do {
+        digits[sizeof(digits) - 1 - n++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value);
+    put(w, &digits[sizeof(digits) - n], n);
+}
+
+void json_writer_init(json_writer_t *w, char *buf, size_t buf_size,
+                      json_writer_sink_t sink, void *sink_ctx)
+{
+    memset(w, 0, sizeof(*w));
+    w->buf = buf;
+    w->buf_size = buf_size;
+    w->sink = sink;
+    w->sink_ctx = sink_ctx;
+    w->error = (buf == NULL || buf_size == 0);
+}
+
+static void begin_container(json_writer_t *w, char open)
+{
+    begin_value(w);
+    if (w->depth + 1 >= JSON_WRITER_MAX_DEPTH) {
+        w->error = true;
+        return;
+    }
+    put_char(w, open);
+    w->depth++;
+    w->has_items &= ~(1u << w->depth);
+}
+
+static void end_container(json_writer_t *w, char close)
+{
+    if (w->depth == 0 || w->after_key) {
+        w->error = true;
+        return;
+    }
+    w->depth--;
+    put_char(w, close);
+}
+
+void json_writer_begin_object(json_writer_t *w) { begin_container(w, '{'); }
+void json_writer_end_object(json_writer_t *w)   { end_container(w, '}'); }
+void json_writer_begin_array(json_writer_t *w)  { begin_container(w, '['); }
+void json_writer_end_array(json_writer_t *w)    { end_container(w, ']'); }
+
+void json_writer_key(json_writer_t *w, const char *key)
+{
+    if (w->after_key) {
+        w->error = true;
+        return;
+    }
+    begin_value(w);
+    put_escaped(w, key ? key : "");
+    put_char(w, ':');
+    w->after_key = true;
+}
+
+void json_writer_string(json_writer_t *w, const char *str)
+{
+    begin_value(w);
+    if (str == NULL) {
+        put(w, "null", 4);
+        return;
+    }
+    put_escaped(w, str);
+}
+
+void json_writer_int(json_writer_t *w, int64_t value)
+{
+    begin_value(w);
+    if (value < 0) {
+        put_char(w, '-');
+        put_uint(w, (uint64_t)(-(value + 1)) + 1);
+    } else {
+        put_uint(w, (uint64_t)value);
+    }
+}
+
+void json_writer_uint(json_writer_t *w, uint64_t value)
+{
+    begin_value(w);
+    put_uint(w, value);
+}
+
+void json_writer_double(json_writer_t *w, double value)
+{
+    begin_value(w);
+    if (!isfinite(value)) {
+        put(w, "null", 4);
+        return;
+    }
+
+    /* Integral values print without exponent or fraction (range checked
+       first: converting a double outside int64_t is undefined) */
+    if (fabs(value) < 1e15 && value == (double)(int64_t)value) {
+        int64_t iv = (int64_t)value;
+        if (iv < 0) {
+            put_char(w, '-');
+            put_uint(w, (uint64_t)(-iv));
+        } else {
+            put_uint(w, (uint64_t)iv);
+        }
+        return;
+    }
+
+    /* Same approach as cJSON: 15 significant digits unless that loses precision */
+    char num[32];
+    int n = snprintf(num, sizeof(num), "%1.15g", value);
+    double parsed = strtod(num, NULL);
+    double max_mag = fabs(parsed) > fabs(value) ? fabs(parsed) : fabs(value);
+    if (fabs(parsed - value) > max_mag * DBL_EPSILON) {
+        n = snprintf(num, sizeof(num), "%1.17g", value);
+    }
+    if (n < 0 || n >= (int)sizeof(num)) {
+        w->error = true;
+        return;
+    }
+    put(w, num, n);
+}
+
+void json_writer_bool(json_writer_t *w, bool value)
+{
+    begin_value(w);
+    if (value) {
+        put(w, "true", 4);
+    } else {
+        put(w, "false", 5);
+    }
+}
+
+void json_writer_null(json_writer_t *w)
+{
+    begin_value(w);
+    put(w, "null", 4);
+}
+
+void json_writer_raw(json_writer_t *w, const char *json, size_t len)
+{
+    begin_value(w);
+    put(w, json, len);
+}
+
+void json_writer_kv_string(json_writer_t *w, const char *key, const char *value)
+{
+    json_writer_key(w, key);
+    json_writer_string(w, value);
+}
+
+void json_writer_kv_int(json_writer_t *w, const char *key, int64_t value)
+{
+    json_writer_key(w, key);
+    json_writer_int(w, value);
+}
+
+void json_writer_kv_uint(json_writer_t *w, const char *key, uint64_t value)
+{
+    json_writer_key(w, key);
+    json_writer_uint(w, value);
+}
+
+void json_writer_kv_double(json_writer_t *w, const char *key, double value)
+{
+    json_writer_key(w, key);
+    json_writer_double(w, value);
+}
+
+void json_writer_kv_bool(json_writer_t *w, const char *key, bool value)
+{
+    json_writer_key(w, key);
+    json_writer_bool(w, value);
+}
+
+void json_writer_kv_null(json_writer_t *w, const char *key)
+{
+    json_writer_key(w, key);
+    json_writer_null(w);
+}
+
+int json_writer_finish(json_writer_t *w)
+{
+    if (w->depth != 0 || w->after_key) {
+        w->error = true;
+    }
+
+    if (w->sink != NULL) {
+        flush(w);
+    } else if (!w->error) {
+        w->buf[w->len] = '\0';
+    }
+
+    if (w->error) {
+        return -1;
+    }
+    return (int)(w->flushed + w->len);
+}
@@ -0,0 +1,113 @@
+/**
+ * @file json_writer.h
+ * @brief Streaming JSON writer with fixed buffer or chunked sink (host-testable)
+ *
+ * Serializes JSON directly into a caller-provided buffer without building a
+ * tree or allocating. In buffer mode (sink == NULL) the whole document must
+ * fit; in sink mode the buffer is flushed to the sink whenever it fills, so
+ * arbitrarily large documents can be streamed through a small buffer.
+ *
+ * Commas and nesting are tracked by the writer. Errors (overflow, sink
+ * failure, nesting too deep) are sticky and reported by json_writer_finish().
+ */
+
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/** @brief Maximum nesting depth of objects/arrays */
+#define JSON_WRITER_MAX_DEPTH 16
+
+/**
+ * @brief Output sink for streamed JSON
+ * @param ctx Sink context passed to json_writer_init()
+ * @param data Bytes to emit
+ * @param len Number of bytes
+ * @return 0 on success, non-zero to abort the document
+ */
+typedef int (*json_writer_sink_t)(void *ctx, const char *data, size_t len);
+
+/**
+ * @brief Writer state (stack-allocate, initialize with json_writer_init)
+ */
+typedef struct {
+    char *buf;                  /**< Output buffer */
+    size_t buf_size;            /**< Output buffer size */
+    size_t len;                 /**< Bytes pending in buffer */
+    size_t flushed;             /**< Bytes already handed to the sink */
+    json_writer_sink_t sink;    /**< Sink, or NULL for fixed-buffer mode */
+    void *sink_ctx;             /**< Sink context */
+    uint32_t has_items;         /**< Bit per depth: container already has a member */
+    uint8_t depth;              /**< Current nesting depth */
+    bool after_key;             /**< A key was written, value expected next */
+    bool error;                 /**< Sticky error flag */
+} json_writer_t;
+
+/**
+ * @brief Initialize a writer
+ * @param w Writer
+ * @param buf Output buffer
+ * @param buf_size Output buffer size (one byte is reserved for the terminator
+ *                 in fixed-buffer mode)
+ * @param sink Sink to flush into, or NULL for fixed-buffer mode
+ * @param sink_ctx Context passed to sink
+ */
+void json_writer_init(json_writer_t *w, char *buf, size_t buf_size,
+                      json_writer_sink_t sink, void *sink_ctx);
+
+void json_writer_begin_object(json_writer_t *w);
+void json_writer_end_object(json_writer_t *w);
+void json_writer_begin_array(json_writer_t *w);
+void json_writer_end_array(json_writer_t *w);
+
+/**
+ * @brief Write an object key (must be followed by exactly one value)
+ */
+void json_writer_key(json_writer_t *w, const char *key);
+
+/**
+ * @brief Write an escaped string value (NULL is written as null)
+ */
+void json_writer_string(json_writer_t *w, const char *str);
+
+void json_writer_int(json_writer_t *w, int64_t value);
+void json_writer_uint(json_writer_t *w, uint64_t value);
+
+/**
+ * @brief Write a number using the same shortest round-trip format as cJSON
+ *
+ * NaN and infinity are written as null.
+ */
+void json_writer_double(json_writer_t *w, double value);
+
+void json_writer_bool(json_writer_t *w, bool value);
+void json_writer_null(json_writer_t *w);
+
+/**
+ * @brief Write a pre-encoded JSON value verbatim
+ */
+void json_writer_raw(json_writer_t *w, const char *json, size_t len);
+
+/* Key/value convenience helpers for object members */
+void json_writer_kv_string(json_writer_t *w, const char *key, const char *value);
+void json_writer_kv_int(json_writer_t *w, const char *key, int64_t value);
+void json_writer_kv_uint(json_writer_t *w, const char *key, uint64_t value);
+void json_writer_kv_double(json_writer_t *w, const char *key, double value);
+void json_writer_kv_bool(json_writer_t *w, const char *key, bool value);
+void json_writer_kv_null(json_writer_t *w, const char *key);
+
+/**
+ * @brief Finish the document
+ *
+ * In fixed-buffer mode the buffer is NUL-terminated. In sink mode any
+ * pending bytes are flushed to the sink.
+ *
+ * @return Total document length in bytes, or -1 on error (overflow, sink
+ *         failure, unbalanced nesting)
+ */
+int json_writer_finish(json_writer_t *w);
+
+#endif /* JSON_WRITER_H */
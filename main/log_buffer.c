@@ -4,77 +4,163 @@
  */
 
 #include "log_buffer.h"
+#include "log_ring.h"
+#include "log_record.h"
+#include "log_filter.h"
 #include "esp_log.h"
-#include "freertos/FreeRTOS.h"
-#include "freertos/semphr.h"
+#if CONFIG_LOG_BUFFER_BINARY
+#include "esp_memory_utils.h"
+#endif
+#include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
 #include <stdarg.h>
 
+/* Longer lines are cut */
+#define LOG_LINE_MAX 256
+
 static char *s_buffer = NULL;
-static size_t s_buffer_size = 0;
-static size_t s_head = 0;  /* Write position */
-static size_t s_used = 0;  /* Bytes used */
-static SemaphoreHandle_t s_mutex = NULL;
+static log_ring_t s_ring;
 static vprintf_like_t s_original_vprintf = NULL;
+static log_buffer_listener_t s_listener = NULL;
+
+/* Capture levels by tag; lines above them are never formatted */
+static log_filter_t s_filter;
+
+/* Lines above this are not printed, although esp_log may pass them for capture */
+static volatile int s_serial_level = ESP_LOG_VERBOSE;
+
+/* HTTP/network internals that flood the buffer */
+static const struct {
+    const char *tag;
+    esp_log_level_t level;
+} DEFAULT_TAG_LEVELS[] = {
+    { "httpd_parse", ESP_LOG_NONE },
+    { "httpd_txrx", ESP_LOG_NONE },
+    { "httpd_uri", ESP_LOG_NONE },
+    { "httpd_sess", ESP_LOG_NONE },
+    { "httpd_ws", ESP_LOG_NONE },
+    { "esp_netif_lwip", ESP_LOG_NONE },
+    { "esp.emac", ESP_LOG_INFO },
+};
+
+#if CONFIG_LOG_BUFFER_BINARY
+/* One record buffer per ring writer slot: static so small-stack tasks can log,
+   and never shared between two lines being recorded at once */
+static uint32_t s_scratch[LOG_RING_WRITERS][LOG_RECORD_MAX / 4];
+
+/* Constant data in flash outlives every record; anything in RAM is copied */
+static bool in_flash(const void *ptr)
+{
+    return esp_ptr_in_drom(ptr);
+}
+
+/**
+ * @brief Record a line into a claimed slot
+ *
+ * Arguments are copied as they are; formatting waits until someone reads
+ * the log. Lines that cannot be kept that way are stored as text.
+ *
+ * @return false if the line was not captured
+ */
+static bool capture_line(int slot, const char *fmt, va_list args)
+{
+    uint32_t *rec = s_scratch[slot];
+    va_list args_copy;
+    va_copy(args_copy, args);
+    size_t len = log_record_encode(rec, LOG_RECORD_MAX, fmt, args_copy, in_flash);
+    va_end(args_copy);
+
+    if (len == 0) {
+        char *text = (char *)rec + LOG_RECORD_HEADER;
+        int text_len = vsnprintf(text, LOG_LINE_MAX, fmt, args);
+        if (text_len <= 0) {
+            log_ring_cancel(&s_ring, slot);
+            return false;
+        }
+        if (text_len >= LOG_LINE_MAX) {
+            text_len = LOG_LINE_MAX - 1;
+        }
+        len = log_record_text(rec, LOG_RECORD_MAX, text, text_len);
+    }
+    log_ring_commit(&s_ring, slot, (const char *)rec, len);
+    return true;
+}
+#else
+/* One line buffer per ring writer slot: static so small-stack tasks can log,
+   and never shared between two lines being formatted at once */
+static char s_scratch[LOG_RING_WRITERS][LOG_LINE_MAX];
+
+/**
+ * @brief Format a line into a claimed slot
+ * @return false if the line was not captured
+ */
+static bool capture_line(int slot, const char *fmt, va_list args)
+{
+    char *line = s_scratch[slot];
+    
+    int len = vsnprintf(line, LOG_LINE_MAX, fmt, args);
+    if (len <= 0) {
+        log_ring_cancel(&s_ring, slot);
+        return false;
+    }
+    if (len >= LOG_LINE_MAX) {
+        len = LOG_LINE_MAX - 1;
+    }
+    
+    log_ring_commit(&s_ring, slot, line, len);
+    return true;
+}
+#endif
 
 /**
  * @brief Custom vprintf that writes to both serial and ring buffer
+ *
+ * Lock-free: a task that logs while another is in the middle of a line
+ * formats into its own scratch buffer and reserves its own part of the
+ * ring, so neither waits for the other.
+ *
+ * The level and tag come from the line prefix, so lines are filtered for
+ * serial and for capture separately before either formats anything.
  */
 static int log_vprintf(const char *fmt, va_list args)
 {
+    bool to_serial = true;
+    bool to_buffer = s_buffer != NULL;
+
+    va_list prefix_args;
+    va_copy(prefix_args, args);
+    char letter = 0;
+    const char *tag = log_record_tag(fmt, prefix_args, &letter, NULL);
+    va_end(prefix_args);
+    if (tag != NULL) {
+        int level = log_filter_level_of(letter);
+        to_serial = level <= s_serial_level;
+        to_buffer = to_buffer && level <= log_filter_level(&s_filter, tag);
+    }
+
     /* First, call original to output to serial */
     int ret = 0;
-    if (s_original_vprintf) {
+    if (s_original_vprintf && to_serial) {
         va_list args_copy;
         va_copy(args_copy, args);
         ret = s_original_vprintf(fmt, args_copy);
         va_end(args_copy);
     }
     
-    /* Then write to ring buffer - use static buffer to avoid stack overflow */
-    if (s_buffer && s_mutex) {
-        static char temp[256];  /* Static to avoid stack issues in small-stack tasks */
-        static SemaphoreHandle_t print_mutex = NULL;
-        
-        /* Create print mutex on first use */
-        if (!print_mutex) {
-            print_mutex = xSemaphoreCreateMutex();
-            if (!print_mutex) return ret;
+    /* Then write to ring buffer */
+    if (to_buffer) {
+        int slot = log_ring_begin(&s_ring);
+        if (slot < 0) {
+            return ret;  /* Counted as dropped */
         }
-        
-        /* Serialize access to static temp buffer */
-        if (xSemaphoreTake(print_mutex, pdMS_TO_TICKS(5)) != pdTRUE) {
+        if (!capture_line(slot, fmt, args)) {
             return ret;
         }
-        
-        int len = vsnprintf(temp, sizeof(temp), fmt, args);
-        if (len > 0) {
-            if (len >= sizeof(temp)) {
-                len = sizeof(temp) - 1;
-            }
-            
-            /* Filter out noisy HTTP/network debug logs that flood the buffer */
-            if (strstr(temp, "httpd_parse:") || strstr(temp, "httpd_txrx:") ||
-                strstr(temp, "httpd_uri:") || strstr(temp, "httpd_sess:") ||
-                strstr(temp, "esp.emac: receive") || strstr(temp, "esp_netif_lwip:")) {
-                xSemaphoreGive(print_mutex);
-                return ret;
-            }
-            
-            if (xSemaphoreTake(s_mutex, pdMS_TO_TICKS(5)) == pdTRUE) {
-                for (int i = 0; i < len; i++) {
-                    s_buffer[s_head] = temp[i];
-                    s_head = (s_head + 1) % s_buffer_size;
-                    if (s_used < s_buffer_size) {
-                        s_used++;
-                    }
-                }
-                xSemaphoreGive(s_mutex);
-            }
+
+        if (s_listener) {
+            s_listener();
         }
-        
-        xSemaphoreGive(print_mutex);
     }
     
     return ret;
@@ -86,21 +172,17 @@ esp_err_t log_buffer_init(size_t buffer_size)
         buffer_size = LOG_BUFFER_SIZE;
     }
     
-    s_buffer = malloc(buffer_size);
-    if (!s_buffer) {
+    char *buffer = malloc(buffer_size);
+    if (!buffer) {
         return ESP_ERR_NO_MEM;
     }
     
-    s_mutex = xSemaphoreCreateMutex();
-    if (!s_mutex) {
-        free(s_buffer);
-        s_buffer = NULL;
-        return ESP_ERR_NO_MEM;
+    log_ring_init(&s_ring, buffer, buffer_size);
+    log_filter_init(&s_filter, ESP_LOG_VERBOSE);
+    for (size_t i = 0; i < sizeof(DEFAULT_TAG_LEVELS) / sizeof(DEFAULT_TAG_LEVELS[0]); i++) {
+        log_filter_set(&s_filter, DEFAULT_TAG_LEVELS[i].tag, DEFAULT_TAG_LEVELS[i].level);
     }
-    
-    s_buffer_size = buffer_size;
-    s_head = 0;
-    s_used = 0;
+    s_buffer = buffer;
     
     /* Hook into ESP logging */
     s_original_vprintf = esp_log_set_vprintf(log_vprintf);
@@ -110,57 +192,158 @@ esp_err_t log_buffer_init(size_t buffer_size)
 
 size_t log_buffer_get(char *out_buffer, size_t buffer_size)
 {
-    if (!s_buffer || !s_mutex || !out_buffer || buffer_size == 0) {
+    if (!s_buffer || !out_buffer || buffer_size == 0) {
         return 0;
     }
     
+#if CONFIG_LOG_BUFFER_BINARY
+    /* Newest lines that fit: format from the oldest, dropping the older half when full */
+    uint32_t end = log_ring_cursor(&s_ring);
+    uint32_t cursor = end - (uint32_t)log_ring_used(&s_ring);
     size_t copied = 0;
-    
-    if (xSemaphoreTake(s_mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
-        if (s_used > 0) {
-            /* Calculate start position (oldest data) */
-            size_t start;
-            size_t to_copy = s_used;
-            
-            if (s_used >= s_buffer_size) {
-                /* Buffer is full, start is at head */
-                start = s_head;
-            } else {
-                /* Buffer not full, start is at beginning */
-                start = (s_head + s_buffer_size - s_used) % s_buffer_size;
-            }
-            
-            /* Limit to output buffer size (leave room for null) */
-            if (to_copy >= buffer_size) {
-                /* Skip oldest data to fit */
-                size_t skip = to_copy - buffer_size + 1;
-                start = (start + skip) % s_buffer_size;
-                to_copy = buffer_size - 1;
-            }
-            
-            /* Copy from ring buffer to output */
-            for (size_t i = 0; i < to_copy; i++) {
-                out_buffer[copied++] = s_buffer[(start + i) % s_buffer_size];
-            }
+    for (;;) {
+        size_t n = log_record_read(&s_ring, &cursor, end, out_buffer + copied,
+                                   buffer_size - copied, NULL, in_flash);
+        copied += n;
+        if (n == 0 || cursor == end) {
+            break;
         }
-        xSemaphoreGive(s_mutex);
+        char *cut = memchr(out_buffer + copied / 2, '\n', copied - copied / 2);
+        if (cut == NULL) {
+            break;
+        }
+        cut++;
+        copied -= (size_t)(cut - out_buffer);
+        memmove(out_buffer, cut, copied);
     }
+#else
+    /* Newest data that fits, leaving room for the NUL */
+    size_t used = log_ring_used(&s_ring);
+    size_t to_copy = used < buffer_size ? used : buffer_size - 1;
+    uint32_t cursor = log_ring_cursor(&s_ring) - to_copy;
+    size_t copied = log_ring_read(&s_ring, &cursor, out_buffer, to_copy, NULL);
+#endif
     
     out_buffer[copied] = '\0';
     return copied;
 }
 
+size_t log_buffer_read(uint32_t *cursor, char *out_buffer, size_t buffer_size, uint32_t *lost)
+{
+    return log_buffer_read_to(cursor, log_buffer_cursor(), out_buffer, buffer_size, lost);
+}
+
+size_t log_buffer_read_to(uint32_t *cursor, uint32_t end, char *out_buffer, size_t buffer_size, uint32_t *lost)
+{
+    if (lost) *lost = 0;
+
+    if (!s_buffer || !cursor || !out_buffer || buffer_size == 0) {
+        return 0;
+    }
+
+#if CONFIG_LOG_BUFFER_BINARY
+    return log_record_read(&s_ring, cursor, end, out_buffer, buffer_size, lost, in_flash);
+#else
+    uint32_t pending = end - *cursor;
+    return log_ring_read(&s_ring, cursor, out_buffer, pending < buffer_size ? pending : buffer_size, lost);
+#endif
+}
+
+uint32_t log_buffer_cursor(void)
+{
+    return s_buffer ? log_ring_cursor(&s_ring) : 0;
+}
+
+uint32_t log_buffer_dropped(void)
+{
+    return s_buffer ? atomic_load(&s_ring.dropped) : 0;
+}
+
+void log_buffer_set_listener(log_buffer_listener_t listener)
+{
+    s_listener = listener;
+}
+
 void log_buffer_clear(void)
 {
-    if (s_mutex && xSemaphoreTake(s_mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
-        s_head = 0;
-        s_used = 0;
-        xSemaphoreGive(s_mutex);
+    if (s_buffer) {
+        log_ring_clear(&s_ring);
     }
 }
 
 void log_buffer_get_info(size_t *used, size_t *total)
 {
-    if (used) *used = s_used;
-    if (total) *total = s_buffer_size;
+    if (used) *used = s_buffer ? log_ring_used(&s_ring) : 0;
+    if (total) *total = s_ring.size;
+}
+
+/**
+ * @brief Let esp_log pass everything that is printed or captured
+ *
+ * Setting "*" also drops the levels set for single tags, as it always has.
+ */
+static void apply_levels(void)
+{
+    int level = log_filter_max(&s_filter);
+    if (level < s_serial_level) {
+        level = s_serial_level;
+    }
+    esp_log_level_set("*", (esp_log_level_t)level);
+}
+
+void log_buffer_set_level(esp_log_level_t level)
+{
+    s_serial_level = level;
+    log_filter_set_default(&s_filter, level);
+    apply_levels();
+}
+
+void log_buffer_set_serial_level(esp_log_level_t level)
+{
+    s_serial_level = level;
+    apply_levels();
+}
+
+esp_log_level_t log_buffer_get_serial_level(void)
+{
+    return (esp_log_level_t)s_serial_level;
+}
+
+void log_buffer_set_capture_level(esp_log_level_t level)
+{
+    log_filter_set_default(&s_filter, level);
+    apply_levels();
+}
+
+esp_log_level_t log_buffer_get_capture_level(void)
+{
+    return (esp_log_level_t)log_filter_get_default(&s_filter);
+}
+
+esp_err_t log_buffer_set_tag_level(const char *tag, esp_log_level_t level)
+{
+    if (tag == NULL || tag[0] == '\0' || strlen(tag) >= LOG_FILTER_TAG_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!log_filter_set(&s_filter, tag, level)) {
+        return ESP_ERR_NO_MEM;
+    }
+    apply_levels();
+    return ESP_OK;
+}
+
+void log_buffer_clear_tag_level(const char *tag)
+{
+    log_filter_remove(&s_filter, tag);
+    apply_levels();
+}
+
+int log_buffer_next_tag_level(int index, const char **tag, esp_log_level_t *level)
+{
+    int value;
+    index = log_filter_next(&s_filter, index, tag, &value);
+    if (index >= 0) {
+        *level = (esp_log_level_t)value;
+    }
+    return index;
 }
@@ -1,13 +1,30 @@
 /**
  * @file log_buffer.h
  * @brief Circular buffer for capturing ESP-IDF logs for web display
+ *
+ * Capture never blocks the logging task: lines from several tasks go into
+ * the ring at once (see log_ring.h). A line is only dropped when more
+ * tasks than the ring has writer slots are mid-line together.
+ *
+ * With CONFIG_LOG_BUFFER_BINARY the ring holds binary records (see
+ * log_record.h) instead of text: a line is captured by copying its
+ * arguments, and formatted when it is read. Cursors and byte counts then
+ * refer to records, not to the text returned.
+ *
+ * What is printed and what is captured are filtered separately: lines
+ * above the serial level are not printed and lines above their tag's
+ * capture level are not captured, both decided from the line prefix
+ * before any formatting. Levels set for single tags with
+ * esp_log_level_set() still limit both.
  */
 
 #ifndef LOG_BUFFER_H
 #define LOG_BUFFER_H
 
 #include "esp_err.h"
+#include "esp_log.h"
 #include <stddef.h>
+#include <stdint.h>
 
 /** @brief Default log buffer size (16KB) */
 #define LOG_BUFFER_SIZE 16384
@@ -26,11 +43,96 @@ esp_err_t log_buffer_init(size_t buffer_size);
  */
 size_t log_buffer_get(char *out_buffer, size_t buffer_size);
 
+/**
+ * @brief Called after new log output is captured
+ *
+ * Runs in the logging task's context; must not log and should only
+ * signal another task.
+ */
+typedef void (*log_buffer_listener_t)(void);
+
+/**
+ * @brief Read log output written since a cursor
+ *
+ * Cursors count bytes written since boot. Start from log_buffer_cursor()
+ * (or 0 for everything still buffered) and pass the same variable back to
+ * continue where the previous read stopped.
+ *
+ * @param cursor In: position to read from, out: position after the copied bytes
+ * @param out_buffer Buffer to copy logs into (not NUL-terminated)
+ * @param buffer_size Size of output buffer
+ * @param lost Output: bytes overwritten before they could be read (can be NULL)
+ * @return Number of bytes copied
+ */
+size_t log_buffer_read(uint32_t *cursor, char *out_buffer, size_t buffer_size, uint32_t *lost);
+
+/**
+ * @brief log_buffer_read() that stops at a position
+ *
+ * For readers that copy out in several pieces and must not chase output
+ * written meanwhile.
+ *
+ * @param end Position to stop at, from log_buffer_cursor()
+ */
+size_t log_buffer_read_to(uint32_t *cursor, uint32_t end, char *out_buffer, size_t buffer_size, uint32_t *lost);
+
+/**
+ * @brief Current write position (cursor for "only new output")
+ */
+uint32_t log_buffer_cursor(void);
+
+/**
+ * @brief Lines not captured since boot because every ring writer slot was taken
+ */
+uint32_t log_buffer_dropped(void);
+
+/**
+ * @brief Register a listener for new log output (NULL to remove)
+ */
+void log_buffer_set_listener(log_buffer_listener_t listener);
+
 /**
  * @brief Clear the log buffer
  */
 void log_buffer_clear(void);
 
+/**
+ * @brief Set the serial level and the default capture level together
+ */
+void log_buffer_set_level(esp_log_level_t level);
+
+/**
+ * @brief Set the level up to which lines are printed
+ */
+void log_buffer_set_serial_level(esp_log_level_t level);
+
+esp_log_level_t log_buffer_get_serial_level(void);
+
+/**
+ * @brief Set the level up to which lines are captured, for tags without their own
+ */
+void log_buffer_set_capture_level(esp_log_level_t level);
+
+esp_log_level_t log_buffer_get_capture_level(void);
+
+/**
+ * @brief Give a tag its own capture level (ESP_LOG_NONE to suppress it)
+ * @return ESP_ERR_INVALID_ARG if the tag is empty or too long, ESP_ERR_NO_MEM if too many tags have one
+ */
+esp_err_t log_buffer_set_tag_level(const char *tag, esp_log_level_t level);
+
+/**
+ * @brief Return a tag to the default capture level
+ */
+void log_buffer_clear_tag_level(const char *tag);
+
+/**
+ * @brief List the tags with their own capture level
+ * @param index 0 to start, then the previous return value
+ * @return Index to continue from, -1 when there are no more
+ */
+int log_buffer_next_tag_level(int index, const char **tag, esp_log_level_t *level);
+
 /**
  * @brief Get buffer usage info
  * @param used Pointer to store bytes used
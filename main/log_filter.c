@@ -0,0 +1,149 @@
+/**
+ * @file log_filter.c
+ * @brief Per-tag log capture levels in a lock-free hash set (host-testable)
+ */
+
+#include "log_filter.h"
+#include <string.h>
+
+#define LEVEL_MASK 0xFu
+#define TOMBSTONE  LEVEL_MASK       /* Removed: lookups go on past it */
+#define MASK       (LOG_FILTER_SLOTS - 1)
+
+/* FNV-1a, with the low bits cleared for the level */
+static uint32_t tag_hash(const char *tag)
+{
+    uint32_t h = 2166136261u;
+    while (*tag) {
+        h = (h ^ (uint8_t)*tag++) * 16777619u;
+    }
+    h &= ~LEVEL_MASK;
+    return h ? h : LEVEL_MASK + 1;
+}
+
+/**
+ * @brief Slot holding a hash
+ * @param free Output: first slot a new entry could take, -1 if none (can be NULL)
+ * @return Slot index, -1 if not found
+ */
+static int find(const log_filter_t *f, uint32_t h, int *free)
+{
+    if (free) *free = -1;
+    int i = (int)((h >> 4) & MASK);
+    for (int n = 0; n < LOG_FILTER_SLOTS; n++, i = (i + 1) & MASK) {
+        uint32_t w = atomic_load_explicit(&f->slot[i], memory_order_relaxed);
+        if (w == 0 || w == TOMBSTONE) {
+            if (free && *free < 0) {
+                *free = i;
+            }
+            if (w == 0) {
+                break;
+            }
+            continue;
+        }
+        if ((w & ~LEVEL_MASK) == h) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void log_filter_init(log_filter_t *f, int default_level)
+{
+    for (int i = 0; i < LOG_FILTER_SLOTS; i++) {
+        atomic_init(&f->slot[i], 0);
+        f->tag[i][0] = '\0';
+    }
+    atomic_init(&f->default_level, default_level);
+    f->count = 0;
+}
+
+void log_filter_set_default(log_filter_t *f, int level)
+{
+    atomic_store(&f->default_level, level);
+}
+
+int log_filter_get_default(const log_filter_t *f)
+{
+    return atomic_load(&f->default_level);
+}
+
+bool log_filter_set(log_filter_t *f, const char *tag, int level)
+{
+    if (strlen(tag) >= LOG_FILTER_TAG_MAX) {
+        return false;
+    }
+    uint32_t h = tag_hash(tag);
+    int free;
+    int i = find(f, h, &free);
+    if (i >= 0) {
+        if (strcmp(f->tag[i], tag) != 0) {
+            return false;   /* Another tag with the same hash */
+        }
+    } else {
+        if (f->count >= LOG_FILTER_TAGS || free < 0) {
+            return false;
+        }
+        i = free;
+        strcpy(f->tag[i], tag);
+        f->count++;
+    }
+    atomic_store(&f->slot[i], h | ((uint32_t)level & LEVEL_MASK));
+    return true;
+}
+
+void log_filter_remove(log_filter_t *f, const char *tag)
+{
+    int i = find(f, tag_hash(tag), NULL);
+    if (i >= 0 && strcmp(f->tag[i], tag) == 0) {
+        atomic_store(&f->slot[i], TOMBSTONE);
+        f->tag[i][0] = '\0';
+        f->count--;
+    }
+}
+
+int log_filter_level(const log_filter_t *f, const char *tag)
+{
+    int i = find(f, tag_hash(tag), NULL);
+    if (i < 0) {
+        return atomic_load_explicit(&f->default_level, memory_order_relaxed);
+    }
+    return (int)(atomic_load_explicit(&f->slot[i], memory_order_relaxed) & LEVEL_MASK);
+}
+
+int log_filter_max(const log_filter_t *f)
+{
+    int max = log_filter_get_default(f);
+    for (int i = 0; i < LOG_FILTER_SLOTS; i++) {
+        uint32_t w = atomic_load(&f->slot[i]);
+        if (w != 0 && w != TOMBSTONE && (int)(w & LEVEL_MASK) > max) {
+            max = (int)(w & LEVEL_MASK);
+        }
+    }
+    return max;
+}
+
+int log_filter_next(const log_filter_t *f, int index, const char **tag, int *level)
+{
+    for (int i = index; i < LOG_FILTER_SLOTS; i++) {
+        uint32_t w = atomic_load(&f->slot[i]);
+        if (w != 0 && w != TOMBSTONE) {
+            *tag = f->tag[i];
+            *level = (int)(w & LEVEL_MASK);
+            return i + 1;
+        }
+    }
+    return -1;
+}
+
+int log_filter_level_of(char letter)
+{
+    switch (letter) {
+    case 'E': return 1;
+    case 'W': return 2;
+    case 'I': return 3;
+    case 'D': return 4;
+    case 'V': return 5;
+    default: return -1;
+    }
+}
@@ -0,0 +1,76 @@
+/**
+ * @file log_filter.h
+ * @brief Per-tag log capture levels in a lock-free hash set (host-testable)
+ *
+ * Decides from a line's tag and level alone whether it is captured, before
+ * anything is formatted. Tags are kept by hash in an open-addressing table
+ * of single words (hash and level together), so logging tasks look up
+ * without locking while the table is being changed. Changes must come from
+ * one task at a time.
+ *
+ * Levels are esp_log_level_t values: 0 none, 1 error ... 5 verbose.
+ */
+
+#ifndef LOG_FILTER_H
+#define LOG_FILTER_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/** @brief Tags that can have their own level */
+#define LOG_FILTER_TAGS 24
+
+/** @brief Table size: a power of two, kept a quarter empty so lookups end early */
+#define LOG_FILTER_SLOTS 32
+
+/** @brief Longest tag + 1 */
+#define LOG_FILTER_TAG_MAX 16
+
+typedef struct {
+    _Atomic uint32_t slot[LOG_FILTER_SLOTS];        /**< Tag hash | level, 0 if empty */
+    char tag[LOG_FILTER_SLOTS][LOG_FILTER_TAG_MAX]; /**< Names, for listing */
+    _Atomic int default_level;                      /**< For tags not in the table */
+    int count;
+} log_filter_t;
+
+void log_filter_init(log_filter_t *f, int default_level);
+
+void log_filter_set_default(log_filter_t *f, int level);
+
+int log_filter_get_default(const log_filter_t *f);
+
+/**
+ * @brief Give a tag its own level
+ * @return false if the tag is too long or the table is full
+ */
+bool log_filter_set(log_filter_t *f, const char *tag, int level);
+
+/**
+ * @brief Return a tag to the default level
+ */
+void log_filter_remove(log_filter_t *f, const char *tag);
+
+/**
+ * @brief Capture level of a tag (called for every line)
+ */
+int log_filter_level(const log_filter_t *f, const char *tag);
+
+/**
+ * @brief Highest level anything is captured at
+ */
+int log_filter_max(const log_filter_t *f);
+
+/**
+ * @brief List the tags with their own level
+ * @param index 0 to start, then the previous return value
+ * @return Index to continue from, -1 when there are no more
+ */
+int log_filter_next(const log_filter_t *f, int index, const char **tag, int *level);
+
+/**
+ * @brief Level of an esp_log level letter ('E' ... 'V'), -1 if unknown
+ */
+int log_filter_level_of(char letter);
+
+#endif /* LOG_FILTER_H */
@@ -0,0 +1,528 @@
+/**
+ * @file log_record.c
+ * @brief Binary log records, formatted only when they are read (host-testable)
+ */
+
+#include "log_record.h"
+#include <inttypes.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#define KIND_FORMAT 'F'
+#define KIND_TEXT   'T'
+
+/* Longest conversion recorded, e.g. "%-+#012.*llx" */
+#define SPEC_TEXT_MAX 12
+
+/* Room for it with both '*' filled in */
+#define SPEC_MAX (SPEC_TEXT_MAX + 2 * 11 + 1)
+
+/* A string argument kept by pointer instead of copied */
+#define STR_POINTER 0xFF
+
+typedef struct {
+    uint16_t check;     /* Of the other fields, so random data is not taken for a header */
+    uint8_t words;      /* Record length / 4 */
+    uint8_t kind;
+    uint32_t aux;       /* Text: length, format: low bits of the format pointer */
+} header_t;
+
+typedef enum {
+    ARG_NONE,           /* %% */
+    ARG_INT,
+    ARG_LONG,
+    ARG_LLONG,
+    ARG_INTMAX,
+    ARG_SIZE,
+    ARG_PTRDIFF,
+    ARG_DOUBLE,
+    ARG_PTR,
+    ARG_STR,
+    ARG_UNSUPPORTED,
+} arg_type_t;
+
+/* One conversion of a format string */
+typedef struct {
+    const char *start;  /* The '%' */
+    const char *end;    /* After the conversion character */
+    arg_type_t type;
+    bool star_width;
+    bool star_prec;
+    int prec;           /* -1 if not given as a number */
+} spec_t;
+
+static bool before(uint32_t a, uint32_t b)
+{
+    return (int32_t)(a - b) < 0;
+}
+
+static uint16_t header_check(const header_t *h)
+{
+    uint32_t x = h->aux ^ ((uint32_t)h->words << 8 | h->kind) * 0x9E3779B1u;
+    x ^= x >> 16;
+    x *= 0x85EBCA6Bu;
+    x ^= x >> 13;
+    return (uint16_t)(x ^ (x >> 16));
+}
+
+static void put_header(void *rec, size_t len, uint8_t kind, uint32_t aux)
+{
+    header_t h = {
+        .words = (uint8_t)(len / 4),
+        .kind = kind,
+        .aux = aux,
+    };
+    h.check = header_check(&h);
+    memcpy(rec, &h, sizeof(h));
+}
+
+/**
+ * @brief Find the next conversion
+ * @return false at the end of the format
+ */
+static bool next_spec(const char *p, spec_t *s)
+{
+    p = strchr(p, '%');
+    if (p == NULL) {
+        return false;
+    }
+    s->start = p++;
+    s->star_width = false;
+    s->star_prec = false;
+    s->prec = -1;
+
+    while (*p && strchr("-+ #0", *p)) {
+        p++;
+    }
+    if (*p == '*') {
+        s->star_width = true;
+        p++;
+    }
+    while (*p >= '0' && *p <= '9') {
+        p++;
+    }
+    if (*p == '.') {
+        p++;
+        if (*p == '*') {
+            s->star_prec = true;
+            p++;
+        } else {
+            s->prec = 0;
+            while (*p >= '0' && *p <= '9') {
+                s->prec = s->prec * 10 + (*p++ - '0');
+            }
+        }
+    }
+
+    char length = 0;
+    if (*p == 'h' || *p == 'l') {
+        length = *p++;
+        if (*p == length) {
+            length = (length == 'l') ? 'q' : 'H';
+            p++;
+        }
+    } else if (*p && strchr("jztL", *p)) {
+        length = *p++;
+    }
+
+    char conv = *p;
+    s->end = conv ? p + 1 : p;
+    if (conv == '%') {
+        s->type = ARG_NONE;
+    } else if (conv && strchr("diouxX", conv)) {
+        switch (length) {
+        case 'l': s->type = ARG_LONG; break;
+        case 'q': s->type = ARG_LLONG; break;
+        case 'j': s->type = ARG_INTMAX; break;
+        case 'z': s->type = ARG_SIZE; break;
+        case 't': s->type = ARG_PTRDIFF; break;
+        case 'L': s->type = ARG_UNSUPPORTED; break;
+        default: s->type = ARG_INT; break;
+        }
+    } else if (conv == 'c') {
+        s->type = ARG_INT;
+    } else if (conv && strchr("feEgGaA", conv)) {
+        s->type = (length == 'L') ? ARG_UNSUPPORTED : ARG_DOUBLE;
+    } else if (conv == 'p') {
+        s->type = ARG_PTR;
+    } else if (conv == 's' && length == 0) {
+        s->type = ARG_STR;
+    } else {
+        /* %n, wide strings, unknown */
+        s->type = ARG_UNSUPPORTED;
+    }
+    if (s->end - s->start > SPEC_TEXT_MAX) {
+        s->type = ARG_UNSUPPORTED;
+    }
+    return true;
+}
+
+/* ===== Encoding ===== */
+
+typedef struct {
+    uint8_t *p;
+    uint8_t *end;
+    bool ok;
+} writer_t;
+
+static void put(writer_t *w, const void *data, size_t len)
+{
+    if (!w->ok || (size_t)(w->end - w->p) < len) {
+        w->ok = false;
+        return;
+    }
+    memcpy(w->p, data, len);
+    w->p += len;
+}
+
+#define PUT_ARG(w, args, type) do { type v_ = va_arg(args, type); put(w, &v_, sizeof(v_)); } while (0)
+
+static void put_string(writer_t *w, const char *str, int prec, log_record_static_t is_static)
+{
+    if (str != NULL && is_static(str)) {
+        uint8_t marker = STR_POINTER;
+        put(w, &marker, 1);
+        put(w, &str, sizeof(str));
+        return;
+    }
+    if (str == NULL) {
+        str = "(null)";
+    }
+    /* The precision may be all that bounds it */
+    size_t len = prec >= 0 ? strnlen(str, (size_t)prec) : strlen(str);
+    if (len >= STR_POINTER) {
+        w->ok = false;
+        return;
+    }
+    uint8_t len8 = (uint8_t)len;
+    put(w, &len8, 1);
+    put(w, str, len);
+    put(w, "", 1);
+}
+
+size_t log_record_encode(void *rec, size_t size, const char *fmt, va_list args, log_record_static_t is_static)
+{
+    if (size > LOG_RECORD_MAX) {
+        size = LOG_RECORD_MAX;
+    }
+    if (fmt == NULL || !is_static(fmt) || size < LOG_RECORD_HEADER) {
+        return 0;
+    }
+
+    writer_t w = {
+        .p = (uint8_t *)rec + LOG_RECORD_HEADER,
+        .end = (uint8_t *)rec + (size & ~(size_t)3),
+        .ok = true,
+    };
+    put(&w, &fmt, sizeof(fmt));
+
+    spec_t s;
+    for (const char *p = fmt; w.ok && next_spec(p, &s); p = s.end) {
+        if (s.type == ARG_UNSUPPORTED) {
+            return 0;
+        }
+        if (s.star_width) {
+            PUT_ARG(&w, args, int);
+        }
+        if (s.star_prec) {
+            int prec = va_arg(args, int);
+            put(&w, &prec, sizeof(prec));
+            s.prec = prec;
+        }
+        switch (s.type) {
+        case ARG_INT: PUT_ARG(&w, args, int); break;
+        case ARG_LONG: PUT_ARG(&w, args, long); break;
+        case ARG_LLONG: PUT_ARG(&w, args, long long); break;
+        case ARG_INTMAX: PUT_ARG(&w, args, intmax_t); break;
+        case ARG_SIZE: PUT_ARG(&w, args, size_t); break;
+        case ARG_PTRDIFF: PUT_ARG(&w, args, ptrdiff_t); break;
+        case ARG_DOUBLE: PUT_ARG(&w, args, double); break;
+        case ARG_PTR: PUT_ARG(&w, args, void *); break;
+        case ARG_STR: put_string(&w, va_arg(args, const char *), s.prec, is_static); break;
+        default: break;
+        }
+    }
+    if (!w.ok) {
+        return 0;
+    }
+
+    size_t len = (size_t)(w.p - (uint8_t *)rec);
+    while (len & 3) {
+        ((uint8_t *)rec)[len++] = 0;
+    }
+    put_header(rec, len, KIND_FORMAT, (uint32_t)(uintptr_t)fmt);
+    return len;
+}
+
+size_t log_record_text(void *rec, size_t size, const char *text, size_t len)
+{
+    size_t rec_len = (LOG_RECORD_HEADER + len + 3) & ~(size_t)3;
+    if (rec_len > size || rec_len > LOG_RECORD_MAX) {
+        return 0;
+    }
+    memmove((uint8_t *)rec + LOG_RECORD_HEADER, text, len);
+    memset((uint8_t *)rec + LOG_RECORD_HEADER + len, 0, rec_len - LOG_RECORD_HEADER - len);
+    put_header(rec, rec_len, KIND_TEXT, (uint32_t)len);
+    return rec_len;
+}
+
+size_t log_record_size(const void *head)
+{
+    header_t h;
+    memcpy(&h, head, sizeof(h));
+    size_t len = (size_t)h.words * 4;
+    if (h.check != header_check(&h) || len > LOG_RECORD_MAX) {
+        return 0;
+    }
+    if (h.kind == KIND_TEXT) {
+        return len == ((LOG_RECORD_HEADER + h.aux + 3) & ~(size_t)3) ? len : 0;
+    }
+    if (h.kind == KIND_FORMAT) {
+        return len >= LOG_RECORD_HEADER + sizeof(const char *) ? len : 0;
+    }
+    return 0;
+}
+
+/* ===== Formatting ===== */
+
+typedef struct {
+    const uint8_t *p;
+    const uint8_t *end;
+    bool ok;
+} reader_t;
+
+static void get(reader_t *r, void *data, size_t len)
+{
+    if (!r->ok || (size_t)(r->end - r->p) < len) {
+        r->ok = false;
+        memset(data, 0, len);
+        return;
+    }
+    memcpy(data, r->p, len);
+    r->p += len;
+}
+
+typedef struct {
+    char *buf;
+    size_t size;
+    size_t len;         /* Of the full line, may exceed size */
+} out_t;
+
+static void out_text(out_t *o, const char *text, size_t len)
+{
+    if (o->len < o->size) {
+        size_t room = o->size - o->len - 1;
+        size_t n = len < room ? len : room;
+        memcpy(o->buf + o->len, text, n);
+        o->buf[o->len + n] = '\0';
+    }
+    o->len += len;
+}
+
+#define OUT_ARG(o, spec, r, type) do {                                          \
+        type v_;                                                                \
+        get(r, &v_, sizeof(v_));                                                \
+        int n_ = snprintf((o)->len < (o)->size ? (o)->buf + (o)->len : NULL,    \
+                          (o)->len < (o)->size ? (o)->size - (o)->len : 0,      \
+                          spec, v_);                                            \
+        (o)->len += n_ > 0 ? (size_t)n_ : 0;                                    \
+    } while (0)
+
+/**
+ * @brief Get a string argument
+ * @return NULL if the record is invalid
+ */
+static const char *get_string(reader_t *r, log_record_static_t is_static)
+{
+    uint8_t len = 0;
+    get(r, &len, 1);
+    if (len == STR_POINTER) {
+        const char *str = NULL;
+        get(r, &str, sizeof(str));
+        return r->ok && is_static(str) ? str : NULL;
+    }
+    const char *str = (const char *)r->p;
+    if (!r->ok || (size_t)(r->end - r->p) < (size_t)len + 1 || str[len] != '\0') {
+        r->ok = false;
+        return NULL;
+    }
+    r->p += len + 1;
+    return str;
+}
+
+int log_record_format(const void *rec, size_t len, char *out, size_t size, log_record_static_t is_static)
+{
+    if (len < LOG_RECORD_HEADER || log_record_size(rec) != len) {
+        return -1;
+    }
+    header_t h;
+    memcpy(&h, rec, sizeof(h));
+    out_t o = { .buf = out, .size = size, .len = 0 };
+    if (size > 0) {
+        out[0] = '\0';
+    }
+    if (h.kind == KIND_TEXT) {
+        out_text(&o, (const char *)rec + LOG_RECORD_HEADER, h.aux);
+        return (int)o.len;
+    }
+
+    reader_t r = {
+        .p = (const uint8_t *)rec + LOG_RECORD_HEADER,
+        .end = (const uint8_t *)rec + len,
+        .ok = true,
+    };
+    const char *fmt = NULL;
+    get(&r, &fmt, sizeof(fmt));
+    if ((uint32_t)(uintptr_t)fmt != h.aux || !is_static(fmt)) {
+        return -1;
+    }
+
+    spec_t s;
+    const char *p = fmt;
+    while (r.ok && next_spec(p, &s)) {
+        out_text(&o, p, (size_t)(s.start - p));
+        p = s.end;
+        if (s.type == ARG_UNSUPPORTED) {
+            return -1;
+        }
+        if (s.type == ARG_NONE) {
+            out_text(&o, "%", 1);
+            continue;
+        }
+
+        /* Rebuild the conversion with the '*' values filled in */
+        char spec[SPEC_MAX];
+        size_t n = 0;
+        for (const char *c = s.start; c < s.end; c++) {
+            if (*c == '*') {
+                int v;
+                get(&r, &v, sizeof(v));
+                n += (size_t)snprintf(spec + n, sizeof(spec) - n, "%d", v);
+            } else {
+                spec[n++] = *c;
+            }
+        }
+        spec[n] = '\0';
+
+        switch (s.type) {
+        case ARG_INT: OUT_ARG(&o, spec, &r, int); break;
+        case ARG_LONG: OUT_ARG(&o, spec, &r, long); break;
+        case ARG_LLONG: OUT_ARG(&o, spec, &r, long long); break;
+        case ARG_INTMAX: OUT_ARG(&o, spec, &r, intmax_t); break;
+        case ARG_SIZE: OUT_ARG(&o, spec, &r, size_t); break;
+        case ARG_PTRDIFF: OUT_ARG(&o, spec, &r, ptrdiff_t); break;
+        case ARG_DOUBLE: OUT_ARG(&o, spec, &r, double); break;
+        case ARG_PTR: OUT_ARG(&o, spec, &r, void *); break;
+        case ARG_STR: {
+            const char *str = get_string(&r, is_static);
+            if (str == NULL) {
+                return -1;
+            }
+            int n_str = snprintf(o.len < o.size ? o.buf + o.len : NULL,
+                                 o.len < o.size ? o.size - o.len : 0, spec, str);
+            o.len += n_str > 0 ? (size_t)n_str : 0;
+            break;
+        }
+        default:
+            break;
+        }
+    }
+    if (!r.ok) {
+        return -1;
+    }
+    out_text(&o, p, strlen(p));
+    return (int)o.len;
+}
+
+/* ===== Line Prefix ===== */
+
+/* What esp_log puts between the level letter and the message */
+static const char PREFIX_TICKS[] = " (%" PRIu32 ") %s: ";
+static const char PREFIX_TIME[] = " (%s) %s: ";
+
+const char *log_record_tag(const char *fmt, va_list args, char *level, const char **msg)
+{
+    /* Skip the color, if any */
+    if (fmt[0] == '\033') {
+        const char *m = strchr(fmt, 'm');
+        if (m == NULL) {
+            return NULL;
+        }
+        fmt = m + 1;
+    }
+    if (fmt[0] == '\0' || strchr("EWIDV", fmt[0]) == NULL) {
+        return NULL;
+    }
+
+    const char *rest = fmt + 1;
+    if (strncmp(rest, PREFIX_TICKS, sizeof(PREFIX_TICKS) - 1) == 0) {
+        (void)va_arg(args, uint32_t);
+        rest += sizeof(PREFIX_TICKS) - 1;
+    } else if (strncmp(rest, PREFIX_TIME, sizeof(PREFIX_TIME) - 1) == 0) {
+        (void)va_arg(args, const char *);
+        rest += sizeof(PREFIX_TIME) - 1;
+    } else {
+        return NULL;
+    }
+
+    if (level) *level = fmt[0];
+    if (msg) *msg = rest;
+    return va_arg(args, const char *);
+}
+
+/* ===== Reading a Ring ===== */
+
+size_t log_record_read(const log_ring_t *ring, uint32_t *cursor, uint32_t end,
+                       char *out, size_t size, uint32_t *lost, log_record_static_t is_static)
+{
+    uint32_t rec[LOG_RECORD_MAX / 4];
+    size_t n = 0;
+    uint32_t skipped = 0;
+
+    while (size - n > 1 && *cursor != end) {
+        uint32_t pos = *cursor;
+        uint32_t gap = 0;
+        size_t got = log_ring_read(ring, &pos, (char *)rec, LOG_RECORD_HEADER, &gap);
+        skipped += gap;
+        uint32_t start = pos - (uint32_t)got;
+        *cursor = start;
+        if (got < LOG_RECORD_HEADER || !before(start, end)) {
+            break;
+        }
+
+        size_t len = log_record_size(rec);
+        if (len > LOG_RECORD_HEADER) {
+            got = log_ring_read(ring, &pos, (char *)rec + LOG_RECORD_HEADER, len - LOG_RECORD_HEADER, &gap);
+            if (gap > 0) {
+                /* Overwritten while we read it: start over at what is held */
+                skipped += LOG_RECORD_HEADER + gap;
+                *cursor = start + LOG_RECORD_HEADER + gap;
+                continue;
+            }
+            if (got < len - LOG_RECORD_HEADER) {
+                break;
+            }
+        }
+
+        int text = len > 0 ? log_record_format(rec, len, out + n, size - n, is_static) : -1;
+        if (text < 0) {
+            /* Not at a record, e.g. after a gap: look for the next header */
+            uint32_t next = (start + 4) & ~3u;
+            skipped += next - start;
+            *cursor = next;
+            continue;
+        }
+        if ((size_t)text >= size - n) {
+            if (n > 0) {
+                break;  /* Whole on the next read */
+            }
+            text = (int)(size - n - 1);
+        }
+        n += (size_t)text;
+        *cursor = start + (uint32_t)len;
+    }
+
+    if (lost) *lost = skipped;
+    return n;
+}
@@ -0,0 +1,98 @@
+/**
+ * @file log_record.h
+ * @brief Binary log records, formatted only when they are read (host-testable)
+ *
+ * A record keeps the printf format string by pointer and its arguments in
+ * binary form, so capturing a line is a walk over the format and a copy of
+ * the arguments instead of a vsnprintf. ESP-IDF puts the level letter in
+ * the format and passes the timestamp and tag as the first arguments, so a
+ * record holds them like any other argument: the tag (a constant string)
+ * by pointer, which makes it a tag id, and the timestamp as a raw 32-bit
+ * value.
+ *
+ * Pointers are only kept to data that lives as long as the firmware
+ * (constant strings in flash); the caller says which those are. Other
+ * strings are copied into the record. Lines that cannot be recorded this
+ * way (format string in RAM, %n, long double, too long) are stored as text
+ * records instead.
+ *
+ * Records are a multiple of 4 bytes and start with a self-checking header,
+ * so a reader that lost its place to overwritten data finds the next record
+ * by looking for a valid header.
+ */
+
+#ifndef LOG_RECORD_H
+#define LOG_RECORD_H
+
+#include "log_ring.h"
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/** @brief Largest record, header included */
+#define LOG_RECORD_MAX 264
+
+/** @brief Header size: a text record's text starts this far in */
+#define LOG_RECORD_HEADER 8
+
+/**
+ * @brief Says whether a pointer stays valid for as long as records are kept
+ */
+typedef bool (*log_record_static_t)(const void *ptr);
+
+/**
+ * @brief Record a line from its format and arguments
+ * @param rec Destination, 4-byte aligned
+ * @param size Destination size
+ * @param args Consumed; va_copy() first if the caller still needs them
+ * @param is_static Pointer check for the format and string arguments
+ * @return Record length, 0 if the line has to be stored as text
+ */
+size_t log_record_encode(void *rec, size_t size, const char *fmt, va_list args, log_record_static_t is_static);
+
+/**
+ * @brief Record a line that is already formatted
+ * @param text May already be at rec + LOG_RECORD_HEADER
+ * @return Record length, 0 if it does not fit
+ */
+size_t log_record_text(void *rec, size_t size, const char *text, size_t len);
+
+/**
+ * @brief Length of the record starting with a header
+ * @param head LOG_RECORD_HEADER bytes
+ * @return Record length, 0 if this is not a record header
+ */
+size_t log_record_size(const void *head);
+
+/**
+ * @brief Format a record
+ * @param is_static Checked again for every pointer before it is followed
+ * @return Length of the full line (as snprintf), -1 if the record is invalid
+ */
+int log_record_format(const void *rec, size_t len, char *out, size_t size, log_record_static_t is_static);
+
+/**
+ * @brief Level and tag of a line in ESP-IDF's "L (time) tag: " format
+ * @param args Consumed; va_copy() first if the caller still needs them
+ * @param level Output: level letter (can be NULL)
+ * @param msg Output: the rest of the format (can be NULL)
+ * @return Tag, NULL if the line does not start that way
+ */
+const char *log_record_tag(const char *fmt, va_list args, char *level, const char **msg);
+
+/**
+ * @brief Format the records of a ring from a cursor
+ *
+ * Like log_ring_read(), but cursors point at records and the output is
+ * text. Only whole lines are returned, unless the first one alone does not
+ * fit; the output is not NUL-terminated but needs room for one.
+ *
+ * @param end Stop at the first record starting at or after this position
+ * @param lost Output: record bytes overwritten before they could be read (can be NULL)
+ * @return Number of text bytes written
+ */
+size_t log_record_read(const log_ring_t *ring, uint32_t *cursor, uint32_t end,
+                       char *out, size_t size, uint32_t *lost, log_record_static_t is_static);
+
+#endif /* LOG_RECORD_H */
@@ -0,0 +1,200 @@
+/**
+ * @file log_ring.c
+ * @brief Lock-free multi-writer byte ring with monotonic read cursors (host-testable)
+ */
+
+#include "log_ring.h"
+#include <string.h>
+
+#define ALL_WRITERS ((1u << LOG_RING_WRITERS) - 1)
+
+/* A clear mark this far behind is moved up before distances to it become ambiguous */
+#define CLEARED_STALE (1u << 30)
+
+/* Positions wrap at 2^32: compare by distance */
+static bool before(uint32_t a, uint32_t b)
+{
+    return (int32_t)(a - b) < 0;
+}
+
+void log_ring_init(log_ring_t *ring, char *buf, size_t size)
+{
+    /* Positions map to indexes by masking, which stays continuous across the 2^32 wrap */
+    while (size & (size - 1)) {
+        size &= size - 1;
+    }
+    ring->buf = buf;
+    ring->size = size;
+    atomic_init(&ring->written, 0);
+    atomic_init(&ring->cleared, 0);
+    atomic_init(&ring->busy, 0);
+    for (int i = 0; i < LOG_RING_WRITERS; i++) {
+        atomic_init(&ring->floor[i], 0);
+    }
+    atomic_init(&ring->dropped, 0);
+}
+
+int log_ring_begin(log_ring_t *ring)
+{
+    uint32_t busy = atomic_load(&ring->busy);
+    int slot;
+    do {
+        uint32_t idle = ~busy & ALL_WRITERS;
+        if (idle == 0) {
+            atomic_fetch_add(&ring->dropped, 1);
+            return -1;
+        }
+        slot = __builtin_ctz(idle);
+    } while (!atomic_compare_exchange_weak(&ring->busy, &busy, busy | (1u << slot)));
+
+    /* Our bytes will land at or after this; readers stop here until we are done */
+    atomic_store(&ring->floor[slot], atomic_load(&ring->written));
+    return slot;
+}
+
+static void release(log_ring_t *ring, int slot, uint32_t end)
+{
+    /* Seen by readers until the next claimant stores its own: no higher than anything it writes */
+    atomic_store(&ring->floor[slot], end);
+    atomic_fetch_and(&ring->busy, ~(1u << slot));
+}
+
+void log_ring_commit(log_ring_t *ring, int slot, const char *data, size_t len)
+{
+    uint32_t pos = atomic_fetch_add(&ring->written, (uint32_t)len);
+    uint32_t end = pos + (uint32_t)len;
+    /* Where the line really starts: staleness counts from here */
+    atomic_store(&ring->floor[slot], pos);
+    if (len >= ring->size) {
+        /* Only the tail survives */
+        data += len - ring->size;
+        pos += (uint32_t)(len - ring->size);
+        len = ring->size;
+    }
+
+    size_t start = pos & (ring->size - 1);
+    size_t first = ring->size - start;
+    if (first > len) {
+        first = len;
+    }
+    memcpy(ring->buf + start, data, first);
+    memcpy(ring->buf, data + first, len - first);
+
+    uint32_t cleared = atomic_load(&ring->cleared);
+    if (end - cleared > CLEARED_STALE) {
+        atomic_compare_exchange_strong(&ring->cleared, &cleared, end - (uint32_t)ring->size);
+    }
+    release(ring, slot, end);
+}
+
+void log_ring_cancel(log_ring_t *ring, int slot)
+{
+    release(ring, slot, atomic_load(&ring->written));
+}
+
+bool log_ring_write(log_ring_t *ring, const char *data, size_t len)
+{
+    int slot = log_ring_begin(ring);
+    if (slot < 0) {
+        return false;
+    }
+    log_ring_commit(ring, slot, data, len);
+    return true;
+}
+
+/**
+ * @brief Complete data ends where the oldest writer in flight started
+ * @param written Output: write position seen, loaded before the slots
+ */
+static uint32_t complete_end(const log_ring_t *ring, uint32_t *written)
+{
+    /*
+     * A writer that claims its slot after the busy mask is read also
+     * reserves after the write position was read, so it cannot be below end.
+     * One a whole ring behind is ignored: the start of its line is
+     * overwritten already, and it may never finish (deleted task).
+     */
+    uint32_t end = atomic_load(&ring->written);
+    *written = end;
+    uint32_t busy = atomic_load(&ring->busy);
+    for (int i = 0; busy != 0; i++, busy >>= 1) {
+        uint32_t floor = atomic_load(&ring->floor[i]);
+        if ((busy & 1) && before(floor, end) && *written - floor < ring->size) {
+            end = floor;
+        }
+    }
+    return end;
+}
+
+/**
+ * @brief Oldest position still held, as of a write position
+ */
+static uint32_t oldest(const log_ring_t *ring, uint32_t written)
+{
+    uint32_t held = written - atomic_load(&ring->cleared);
+    return written - (held < ring->size ? held : (uint32_t)ring->size);
+}
+
+size_t log_ring_read(const log_ring_t *ring, uint32_t *cursor, char *out, size_t out_size, uint32_t *lost)
+{
+    uint32_t written;
+    uint32_t end = complete_end(ring, &written);
+    uint32_t first_held = oldest(ring, written);
+    uint32_t held = before(first_held, end) ? end - first_held : 0;
+    uint32_t pending = end - *cursor;
+    uint32_t skipped = 0;
+
+    if ((int32_t)pending < 0) {
+        /* Cursor from the future - start over with what is held */
+        pending = held;
+    } else if (pending > held) {
+        /* Overwritten (or cleared) before it was read */
+        skipped = pending - held;
+        pending = held;
+    }
+
+    size_t to_copy = pending < out_size ? pending : out_size;
+    uint32_t pos = end - pending;
+    size_t start = pos & (ring->size - 1);
+    size_t first = ring->size - start;
+    if (first > to_copy) {
+        first = to_copy;
+    }
+    memcpy(out, ring->buf + start, first);
+    memcpy(out + first, ring->buf, to_copy - first);
+
+    /* Writers may have lapped the start of the copy meanwhile: drop what they reached */
+    atomic_thread_fence(memory_order_acquire);
+    uint32_t valid_from = atomic_load(&ring->written) - (uint32_t)ring->size;
+    if (before(pos, valid_from)) {
+        uint32_t gone = valid_from - pos;
+        if (gone > to_copy) {
+            gone = (uint32_t)to_copy;
+        }
+        memmove(out, out + gone, to_copy - gone);
+        to_copy -= gone;
+        skipped += gone;
+        pos += gone;
+    }
+
+    if (lost) *lost = skipped;
+    *cursor = pos + (uint32_t)to_copy;
+    return to_copy;
+}
+
+uint32_t log_ring_cursor(const log_ring_t *ring)
+{
+    uint32_t written;
+    return complete_end(ring, &written);
+}
+
+size_t log_ring_used(const log_ring_t *ring)
+{
+    uint32_t written = atomic_load(&ring->written);
+    return written - oldest(ring, written);
+}
+
+void log_ring_clear(log_ring_t *ring)
+{
+    atomic_store(&ring->cleared, atomic_load(&ring->written));
+}
@@ -0,0 +1,102 @@
+/**
+ * @file log_ring.h
+ * @brief Lock-free multi-writer byte ring with monotonic read cursors (host-testable)
+ *
+ * Backing store of the log buffer. Every byte ever written has a position
+ * (a 32-bit count since boot), so readers keep their own cursor and can
+ * tell how much was overwritten before they got to it.
+ *
+ * Writers never wait for each other or for readers. A writer first claims
+ * one of LOG_RING_WRITERS slots, which holds readers back at the write
+ * position of that moment, then reserves its bytes with an atomic add on
+ * the write position, copies them in (at most two memcpy) and releases the
+ * slot. A line that finds every slot taken is dropped and counted. Readers
+ * copy without locking and then discard whatever a writer overwrote while
+ * they were copying, so any number of them can read at once.
+ *
+ * A writer stops holding readers back once a whole ring of output has gone
+ * past the start of its line, so one preempted for long or deleted in the
+ * middle of a line cannot stall them for good. Such a line may come out
+ * garbled, and a deleted writer's slot is not given back.
+ */
+
+#ifndef LOG_RING_H
+#define LOG_RING_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/** @brief Lines that can be in flight at once (one per logging task) */
+#define LOG_RING_WRITERS 8
+
+typedef struct {
+    char *buf;                  /**< Storage */
+    size_t size;                /**< Storage size, a power of two */
+    _Atomic uint32_t written;   /**< Bytes reserved since init - cursor space */
+    _Atomic uint32_t cleared;   /**< Position of the last clear */
+    _Atomic uint32_t busy;      /**< Claimed writer slots, one bit each */
+    _Atomic uint32_t floor[LOG_RING_WRITERS];   /**< Write position when each slot was claimed */
+    _Atomic uint32_t dropped;   /**< Lines dropped with every slot taken */
+} log_ring_t;
+
+/**
+ * @param size Storage size; only the largest power of two that fits is used
+ */
+void log_ring_init(log_ring_t *ring, char *buf, size_t size);
+
+/**
+ * @brief Claim a writer slot before producing a line
+ * @return Slot to pass to log_ring_commit()/log_ring_cancel(), -1 if all are taken (line dropped)
+ */
+int log_ring_begin(log_ring_t *ring);
+
+/**
+ * @brief Append bytes, overwriting the oldest data when full, and release the slot
+ */
+void log_ring_commit(log_ring_t *ring, int slot, const char *data, size_t len);
+
+/**
+ * @brief Release a slot without writing
+ */
+void log_ring_cancel(log_ring_t *ring, int slot);
+
+/**
+ * @brief log_ring_begin() and log_ring_commit() in one
+ * @return false if the data was dropped
+ */
+bool log_ring_write(log_ring_t *ring, const char *data, size_t len);
+
+/**
+ * @brief Copy data from a cursor position
+ *
+ * A cursor older than the oldest held byte skips ahead and reports the gap
+ * in lost. A cursor ahead of the write position (e.g. from before a reboot)
+ * restarts at the oldest held byte. Lines still being written, and those
+ * after them, are not returned until they are complete.
+ *
+ * @param cursor In: position to read from, out: position after the copied bytes
+ * @param out Destination (not NUL-terminated)
+ * @param out_size Maximum bytes to copy
+ * @param lost Output: bytes skipped because they were overwritten (can be NULL)
+ * @return Number of bytes copied
+ */
+size_t log_ring_read(const log_ring_t *ring, uint32_t *cursor, char *out, size_t out_size, uint32_t *lost);
+
+/**
+ * @brief Position up to which all data is complete (cursor for "only new output")
+ */
+uint32_t log_ring_cursor(const log_ring_t *ring);
+
+/**
+ * @brief Bytes currently held
+ */
+size_t log_ring_used(const log_ring_t *ring);
+
+/**
+ * @brief Drop all held data; cursors stay valid
+ */
+void log_ring_clear(log_ring_t *ring);
+
+#endif /* LOG_RING_H */
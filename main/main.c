@@ -17,6 +17,7 @@
 #include "esp_event.h"
 #include "nvs_flash.h"
 #include "esp_netif.h"
+#include "esp_netif_sntp.h"
 #include "mdns.h"
 
 #include "nvs_storage.h"
@@ -28,6 +29,7 @@
 #include "web_server.h"
 #include "ota_updater.h"
 #include "log_buffer.h"
+#include "boot_monitor.h"
 
 static const char *TAG = "main";
 
@@ -42,6 +44,13 @@ const char *APP_VERSION = "2.7.0";
 static uint32_t s_read_interval_ms = CONFIG_SENSOR_READ_INTERVAL_MS;
 static uint32_t s_publish_interval_ms = CONFIG_SENSOR_PUBLISH_INTERVAL_MS;
 
+/* Temperature task handle, notified to request an immediate reading or rescan */
+static TaskHandle_t s_temperature_task = NULL;
+
+/* Notification bits for the temperature task */
+#define SENSOR_REQUEST_READ_NOW BIT0
+#define SENSOR_REQUEST_RESCAN   BIT1
+
 /* Accessor functions for sensor settings */
 uint32_t get_sensor_read_interval(void) { return s_read_interval_ms; }
 uint32_t get_sensor_publish_interval(void) { return s_publish_interval_ms; }
@@ -56,6 +65,20 @@ void set_sensor_publish_interval(uint32_t ms) {
     ESP_LOGD(TAG, "Publish interval set to %lu ms", ms);
 }
 
+void request_sensor_read_now(void)
+{
+    if (s_temperature_task != NULL) {
+        xTaskNotify(s_temperature_task, SENSOR_REQUEST_READ_NOW, eSetBits);
+    }
+}
+
+void request_sensor_rescan(void)
+{
+    if (s_temperature_task != NULL) {
+        xTaskNotify(s_temperature_task, SENSOR_REQUEST_RESCAN, eSetBits);
+    }
+}
+
 /**
  * @brief Initialize mDNS service for device discovery
  * 
@@ -86,7 +109,15 @@ static esp_err_t init_mdns(void)
     mdns_service_add("Thermux", "_http", "_tcp", CONFIG_WEB_SERVER_PORT, http_txt, 2);
     
     /* Add custom service type for easy discovery of all Thermux devices */
-    mdns_service_add("Thermux", "_thermux", "_tcp", CONFIG_WEB_SERVER_PORT, http_txt, 2);
+    mdns_txt_item_t thermux_txt[] = {
+        {"version", APP_VERSION},
+        {"type", "temperature"},
+#if CONFIG_OTA_PEER_CACHE
+        {"ota", "/api/ota/image"},      /* Where peers fetch this version's image */
+#endif
+    };
+    mdns_service_add("Thermux", "_thermux", "_tcp", CONFIG_WEB_SERVER_PORT,
+                     thermux_txt, sizeof(thermux_txt) / sizeof(thermux_txt[0]));
     
     ESP_LOGD(TAG, "mDNS hostname: %s.local", hostname);
     ESP_LOGD(TAG, "mDNS services: _http._tcp, _thermux._tcp");
@@ -116,12 +147,27 @@ static void network_event_handler(void *arg, esp_event_base_t event_base,
 static void temperature_task(void *pvParameters)
 {
     ESP_LOGD(TAG, "Temperature task started");
+    uint32_t requests = 0;
     
     while (1) {
+        /* Rescans requested via MQTT run here, off the MQTT task; requests
+           arriving while one is pending share its result */
+        if (requests & SENSOR_REQUEST_RESCAN) {
+            mqtt_ha_rescan_done(sensor_manager_rescan());
+        }
+
         /* Read all connected sensors */
         sensor_manager_read_all();
+        web_server_notify_readings();
         
-        vTaskDelay(pdMS_TO_TICKS(s_read_interval_ms));
+        /* Readings requested via MQTT go out right away */
+        if (requests & SENSOR_REQUEST_READ_NOW) {
+            sensor_manager_publish_all();
+        }
+        
+        /* Sleep for the read interval unless a request comes in */
+        requests = 0;
+        xTaskNotifyWait(0, UINT32_MAX, &requests, pdMS_TO_TICKS(s_read_interval_ms));
     }
 }
 
@@ -136,7 +182,10 @@ static void mqtt_publish_task(void *pvParameters)
     vTaskDelay(pdMS_TO_TICKS(5000));
     
     while (1) {
-        if (mqtt_ha_is_connected()) {
+        /* Publishes when connected, otherwise buffers for replay - but
+           only once a broker has been reached, so an unconfigured or
+           unreachable one does not keep spilling readings to flash */
+        if (mqtt_ha_was_connected()) {
             sensor_manager_publish_all();
         }
         
@@ -183,8 +232,9 @@ void app_main(void)
     /* Initialize log buffer first to capture all logs */
     log_buffer_init(LOG_BUFFER_SIZE);
     
-    /* Set default runtime log level to INFO (compile-time is DEBUG to allow switching) */
-    esp_log_level_set("*", ESP_LOG_INFO);
+    /* Set default runtime log level to INFO (compile-time is DEBUG to allow switching),
+       for serial and the web log alike */
+    log_buffer_set_level(ESP_LOG_INFO);
     
     /* Quiet down noisy ESP-IDF components - set to WARN level
        This reduces startup spam while keeping important messages */
@@ -194,7 +244,6 @@ void app_main(void)
     esp_log_level_set("esp_netif_lwip", ESP_LOG_WARN);
     esp_log_level_set("esp-tls", ESP_LOG_WARN);
     esp_log_level_set("esp-tls-mbedtls", ESP_LOG_WARN);
-    esp_log_level_set("esp_https_ota", ESP_LOG_WARN);
     esp_log_level_set("HTTP_CLIENT", ESP_LOG_WARN);
     esp_log_level_set("esp-x509-crt-bundle", ESP_LOG_WARN);
     /* HTTP server internals - extremely verbose, rarely useful */
@@ -236,6 +285,9 @@ void app_main(void)
     /* Initialize NVS storage for our app data */
     ESP_ERROR_CHECK(nvs_storage_init());
 
+    /* Start timing the boot; after an update this decides between keeping the image and rolling back */
+    ESP_ERROR_CHECK(boot_monitor_start());
+
     /* Load sensor settings from NVS (or use defaults) */
     {
         uint32_t read_ms, publish_ms;
@@ -267,6 +319,7 @@ void app_main(void)
     
     /* Initialize sensor manager */
     ESP_ERROR_CHECK(sensor_manager_init());
+    boot_monitor_sensors_scanned(sensor_manager_get_count());
 
 #if CONFIG_USE_ETHERNET
     /* Initialize Ethernet (primary connection for POE) */
@@ -289,10 +342,15 @@ void app_main(void)
     xEventGroupWaitBits(network_event_group, NETWORK_CONNECTED_BIT,
                         pdFALSE, pdTRUE, portMAX_DELAY);
     ESP_LOGI(TAG, "Network connected!");
+    boot_monitor_network_up();
 
     /* Initialize mDNS */
     init_mdns();
 
+    /* Sync wall clock so buffered readings carry their sample time */
+    esp_sntp_config_t sntp_config = ESP_NETIF_SNTP_DEFAULT_CONFIG("pool.ntp.org");
+    esp_netif_sntp_init(&sntp_config);
+
     /* Initialize MQTT client */
     ESP_ERROR_CHECK(mqtt_ha_init());
 
@@ -306,7 +364,7 @@ void app_main(void)
 #endif
 
     /* Create application tasks */
-    xTaskCreate(temperature_task, "temp_task", 4096, NULL, 5, NULL);
+    xTaskCreate(temperature_task, "temp_task", 4096, NULL, 5, &s_temperature_task);
     xTaskCreate(mqtt_publish_task, "mqtt_pub_task", 4096, NULL, 4, NULL);
     xTaskCreate(watchdog_task, "watchdog_task", 2048, NULL, 1, NULL);
     
@@ -0,0 +1,256 @@
+/**
+ * @file metrics_writer.c
+ * @brief Prometheus text exposition writer (host-testable)
+ */
+
+#include "metrics_writer.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+static void flush(metrics_writer_t *w)
+{
+    if (w->len == 0 || w->error) {
+        return;
+    }
+    if (w->sink(w->sink_ctx, w->buf, w->len) != 0) {
+        w->error = true;
+        return;
+    }
+    w->flushed += w->len;
+    w->len = 0;
+}
+
+static void put(metrics_writer_t *w, const char *data, size_t len)
+{
+    if (w->error) {
+        return;
+    }
+
+    if (w->sink == NULL) {
+        /* Fixed-buffer mode: keep one byte for the terminator */
+        if (w->len + len >= w->buf_size) {
+            w->error = true;
+            return;
+        }
+        memcpy(w->buf + w->len, data, len);
+        w->len += len;
+        return;
+    }
+
+    while (len > 0 && !w->error) {
+        size_t room = w->buf_size - w->len;
+        if (room == 0) {
+            flush(w);
+            continue;
+        }
+        size_t n = len < room ? len : room;
+        memcpy(w->buf + w->len, data, n);
+        w->len += n;
+        data += n;
+        len -= n;
+    }
+}
+
+static void put_str(metrics_writer_t *w, const char *str)
+{
+    put(w, str, strlen(str));
+}
+
+/**
+ * @brief Format an unsigned integer, returns length (buf needs 21 bytes)
+ */
+static size_t format_uint(char *buf, uint64_t value)
+{
+    char tmp[20];
+    size_t n = 0;
+    do {
+        tmp[n++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value > 0);
+    for (size_t i = 0; i < n; i++) {
+        buf[i] = tmp[n - 1 - i];
+    }
+    return n;
+}
+
+/**
+ * @brief Format a number with up to 4 decimals, trailing zeros trimmed
+ *
+ * DS18B20 readings are multiples of 1/16 °C, so 4 decimals are exact.
+ */
+static size_t format_double(char *buf, double value)
+{
+    if (isnan(value)) {
+        memcpy(buf, "NaN", 3);
+        return 3;
+    }
+    if (isinf(value)) {
+        memcpy(buf, value > 0 ? "+Inf" : "-Inf", 4);
+        return 4;
+    }
+    if (fabs(value) >= 1e14) {
+        return (size_t)snprintf(buf, 32, "%.6e", value);
+    }
+
+    size_t n = 0;
+    if (value < 0) {
+        buf[n++] = '-';
+        value = -value;
+    }
+    uint64_t scaled = (uint64_t)(value * 10000.0 + 0.5);
+    n += format_uint(buf + n, scaled / 10000);
+
+    uint32_t frac = (uint32_t)(scaled % 10000);
+    if (frac != 0) {
+        buf[n++] = '.';
+        for (uint32_t div = 1000; div > 0 && frac != 0; div /= 10) {
+            buf[n++] = (char)('0' + frac / div);
+            frac %= div;
+        }
+    }
+    return n;
+}
+
+void metrics_writer_init(metrics_writer_t *w, char *buf, size_t buf_size,
+                         metrics_writer_sink_t sink, void *sink_ctx)
+{
+    memset(w, 0, sizeof(*w));
+    w->buf = buf;
+    w->buf_size = buf_size;
+    w->sink = sink;
+    w->sink_ctx = sink_ctx;
+}
+
+void metrics_writer_family(metrics_writer_t *w, const char *name, const char *type, const char *help)
+{
+    put_str(w, "# HELP ");
+    put_str(w, name);
+    put(w, " ", 1);
+    put_str(w, help);
+    put_str(w, "\n# TYPE ");
+    put_str(w, name);
+    put(w, " ", 1);
+    put_str(w, type);
+    put(w, "\n", 1);
+}
+
+static void sample_head(metrics_writer_t *w, const char *name, const char *suffix, const char *labels)
+{
+    put_str(w, name);
+    if (suffix != NULL) {
+        put_str(w, suffix);
+    }
+    if (labels != NULL) {
+        put_str(w, labels);
+    }
+    put(w, " ", 1);
+}
+
+void metrics_writer_sample(metrics_writer_t *w, const char *name, const char *labels, double value)
+{
+    char num[32];
+    sample_head(w, name, NULL, labels);
+    put(w, num, format_double(num, value));
+    put(w, "\n", 1);
+}
+
+void metrics_writer_sample_uint(metrics_writer_t *w, const char *name, const char *labels, uint64_t value)
+{
+    char num[21];
+    sample_head(w, name, NULL, labels);
+    put(w, num, format_uint(num, value));
+    put(w, "\n", 1);
+}
+
+void metrics_writer_histogram(metrics_writer_t *w, const char *name, const metrics_histogram_t *h)
+{
+    char num[32];
+    uint64_t cumulative = 0;
+
+    for (size_t i = 0; i <= h->bucket_count; i++) {
+        cumulative += h->counts[i];
+        put_str(w, name);
+        put_str(w, "_bucket{le=\"");
+        if (i < h->bucket_count) {
+            put(w, num, format_double(num, h->bounds[i]));
+        } else {
+            put_str(w, "+Inf");
+        }
+        put_str(w, "\"} ");
+        put(w, num, format_uint(num, cumulative));
+        put(w, "\n", 1);
+    }
+
+    sample_head(w, name, "_sum", NULL);
+    put(w, num, format_double(num, h->sum));
+    put(w, "\n", 1);
+    sample_head(w, name, "_count", NULL);
+    put(w, num, format_uint(num, h->count));
+    put(w, "\n", 1);
+}
+
+int metrics_writer_finish(metrics_writer_t *w)
+{
+    if (w->sink != NULL) {
+        flush(w);
+    } else if (!w->error) {
+        w->buf[w->len] = '\0';
+    }
+    return w->error ? -1 : (int)(w->flushed + w->len);
+}
+
+void metrics_histogram_init(metrics_histogram_t *h, const double *bounds, size_t bucket_count)
+{
+    memset(h, 0, sizeof(*h));
+    h->bounds = bounds;
+    h->bucket_count = bucket_count < METRICS_HISTOGRAM_MAX_BUCKETS ?
+                      bucket_count : METRICS_HISTOGRAM_MAX_BUCKETS;
+}
+
+void metrics_histogram_observe(metrics_histogram_t *h, double value)
+{
+    size_t i = 0;
+    while (i < h->bucket_count && value > h->bounds[i]) {
+        i++;
+    }
+    h->counts[i]++;
+    h->count++;
+    h->sum += value;
+}
+
+/**
+ * @brief Append to a label buffer, escaping label value characters if asked
+ * @return false if the buffer is full
+ */
+static bool label_append(char *buf, size_t size, size_t *n, const char *str, bool escape)
+{
+    for (; *str != '\0'; str++) {
+        char c = *str;
+        bool special = escape && (c == '\\' || c == '"' || c == '\n');
+        if (*n + (special ? 2 : 1) >= size) {
+            return false;
+        }
+        if (special) {
+            buf[(*n)++] = '\\';
+            c = c == '\n' ? 'n' : c;
+        }
+        buf[(*n)++] = c;
+    }
+    return true;
+}
+
+int metrics_format_sensor_labels(char *buf, size_t size, const char *address, const char *name)
+{
+    size_t n = 0;
+    if (size == 0 ||
+        !label_append(buf, size, &n, "{address=\"", false) ||
+        !label_append(buf, size, &n, address, true) ||
+        !label_append(buf, size, &n, "\",name=\"", false) ||
+        !label_append(buf, size, &n, name, true) ||
+        !label_append(buf, size, &n, "\"}", false)) {
+        return -1;
+    }
+    buf[n] = '\0';
+    return (int)n;
+}
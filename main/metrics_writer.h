@@ -0,0 +1,100 @@
+/**
+ * @file metrics_writer.h
+ * @brief Prometheus text exposition writer (host-testable)
+ *
+ * Writes the Prometheus text format (0.0.4) into a fixed buffer or through
+ * a chunked sink, like json_writer. Numbers are formatted with integer
+ * arithmetic and nothing is allocated, so a scrape costs little more than
+ * copying bytes. Label sets are passed preformatted ("{a=\"b\"}") so they
+ * can be built once per sensor instead of on every scrape.
+ */
+
+#ifndef METRICS_WRITER_H
+#define METRICS_WRITER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/** @brief Room for {address="<16 hex>",name="<31 chars, escaped>"} */
+#define METRICS_LABELS_MAX 112
+
+/** @brief Buckets per histogram, excluding +Inf */
+#define METRICS_HISTOGRAM_MAX_BUCKETS 8
+
+/**
+ * @brief Output sink (same contract as json_writer_sink_t)
+ * @return 0 on success, non-zero to abort
+ */
+typedef int (*metrics_writer_sink_t)(void *ctx, const char *data, size_t len);
+
+/**
+ * @brief Writer state (stack-allocate, initialize with metrics_writer_init)
+ */
+typedef struct {
+    char *buf;                      /**< Output buffer */
+    size_t buf_size;                /**< Output buffer size */
+    size_t len;                     /**< Bytes pending in buffer */
+    size_t flushed;                 /**< Bytes already handed to the sink */
+    metrics_writer_sink_t sink;     /**< Sink, or NULL for fixed-buffer mode */
+    void *sink_ctx;                 /**< Sink context */
+    bool error;                     /**< Sticky error flag */
+} metrics_writer_t;
+
+/**
+ * @brief Histogram with fixed upper bounds
+ *
+ * Counts are per bucket (not cumulative); the writer accumulates them.
+ */
+typedef struct {
+    const double *bounds;           /**< Ascending upper bounds */
+    size_t bucket_count;            /**< Entries in bounds (<= MAX_BUCKETS) */
+    uint32_t counts[METRICS_HISTOGRAM_MAX_BUCKETS + 1];  /**< Last is +Inf */
+    uint32_t count;                 /**< Observations */
+    double sum;                     /**< Sum of observations */
+} metrics_histogram_t;
+
+void metrics_writer_init(metrics_writer_t *w, char *buf, size_t buf_size,
+                         metrics_writer_sink_t sink, void *sink_ctx);
+
+/**
+ * @brief Write the # HELP and # TYPE lines of a metric family
+ * @param type "gauge", "counter", "summary" or "histogram"
+ */
+void metrics_writer_family(metrics_writer_t *w, const char *name, const char *type, const char *help);
+
+/**
+ * @brief Write a sample line
+ * @param labels Preformatted label set, or NULL
+ * @param value Value; printed with up to 4 decimals
+ */
+void metrics_writer_sample(metrics_writer_t *w, const char *name, const char *labels, double value);
+
+void metrics_writer_sample_uint(metrics_writer_t *w, const char *name, const char *labels, uint64_t value);
+
+/**
+ * @brief Write the _bucket, _sum and _count samples of a histogram
+ *
+ * Must follow a "histogram" family line. Labels are not supported.
+ */
+void metrics_writer_histogram(metrics_writer_t *w, const char *name, const metrics_histogram_t *h);
+
+/**
+ * @brief Finish the output (flush or NUL-terminate)
+ * @return Total length, or -1 on error
+ */
+int metrics_writer_finish(metrics_writer_t *w);
+
+void metrics_histogram_init(metrics_histogram_t *h, const double *bounds, size_t bucket_count);
+void metrics_histogram_observe(metrics_histogram_t *h, double value);
+
+/**
+ * @brief Build the label set of a sensor: {address="...",name="..."}
+ *
+ * Backslashes, quotes and newlines in the name are escaped.
+ *
+ * @return Length, or -1 if it does not fit
+ */
+int metrics_format_sensor_labels(char *buf, size_t size, const char *address, const char *name);
+
+#endif /* METRICS_WRITER_H */
@@ -10,19 +10,312 @@
 #include "nvs_storage.h"
 #include "ethernet_manager.h"
 #include "wifi_manager.h"
+#include "json_writer.h"
+#include "store_forward.h"
+#include "mqtt_command.h"
+#include "ha_discovery.h"
+#include "telemetry_cbor.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
 #include "esp_log.h"
-#include "cJSON.h"
+#include "esp_timer.h"
 #include <string.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
 
 static const char *TAG = "mqtt_ha";
 
 static esp_mqtt_client_handle_t s_mqtt_client = NULL;
 static bool s_connected = false;
+static bool s_was_connected = false;   /* Broker reached at least once since boot */
+static uint32_t s_publish_ok = 0;
+static uint32_t s_publish_failed = 0;
 
 /* Forward declaration */
 extern const char *APP_VERSION;
 
+/* Runtime sensor settings (main.c) */
+extern uint32_t get_sensor_read_interval(void);
+extern uint32_t get_sensor_publish_interval(void);
+extern void set_sensor_read_interval(uint32_t ms);
+extern void set_sensor_publish_interval(uint32_t ms);
+extern void request_sensor_read_now(void);
+extern void request_sensor_rescan(void);
+
+#if CONFIG_MQTT_COMMANDS_ENABLED
+/* Command tree: base_topic/cmd/<command>, results on base_topic/cmd/result */
+static const char *s_cmd_prefix = CONFIG_MQTT_BASE_TOPIC "/cmd/";
+static const char *s_cmd_filter = CONFIG_MQTT_BASE_TOPIC "/cmd/#";
+static const char *s_cmd_result_topic = CONFIG_MQTT_BASE_TOPIC "/cmd/result";
+/* Optional shared tree so one publish reconfigures every node */
+static const char *s_fleet_cmd_prefix = CONFIG_MQTT_FLEET_TOPIC "/cmd/";
+static const char *s_fleet_cmd_filter = CONFIG_MQTT_FLEET_TOPIC "/cmd/#";
+#endif
+
+/**
+ * @brief esp_mqtt_client_publish() with success/failure accounting for /metrics
+ */
+static int mqtt_publish(const char *topic, const char *data, int len, int qos, int retain)
+{
+    int msg_id = esp_mqtt_client_publish(s_mqtt_client, topic, data, len, qos, retain);
+    if (msg_id < 0) {
+        s_publish_failed++;
+    } else {
+        s_publish_ok++;
+    }
+    return msg_id;
+}
+
+/* ===== Offline store-and-forward buffer ===== */
+
+/* Readings per flash segment (1280-byte NVS blob) */
+#define BUFFER_SEGMENT_RECORDS 64
+
+/* Wall clock is trusted once SNTP has moved it past this (2023-11-14) */
+#define VALID_EPOCH_MIN 1700000000
+
+static store_forward_record_t s_buffer_ram[CONFIG_MQTT_BUFFER_RAM_RECORDS];
+static store_forward_t s_buffer;
+static SemaphoreHandle_t s_buffer_mutex = NULL;
+static float s_replay_rate = 0;
+
+#if CONFIG_MQTT_BUFFER_FLASH_SEGMENTS > 0
+static store_forward_record_t s_buffer_spill[BUFFER_SEGMENT_RECORDS];
+static store_forward_record_t s_buffer_replay[BUFFER_SEGMENT_RECORDS];
+
+static int spill_load_range(void *ctx, uint32_t *head, uint32_t *tail)
+{
+    return nvs_storage_spill_load_range(head, tail) == ESP_OK ? 0 : -1;
+}
+
+static int spill_save_range(void *ctx, uint32_t head, uint32_t tail)
+{
+    return nvs_storage_spill_save_range(head, tail) == ESP_OK ? 0 : -1;
+}
+
+static int spill_write(void *ctx, uint32_t seq, const store_forward_record_t *records, size_t count)
+{
+    return nvs_storage_spill_write(seq, records, count * sizeof(*records)) == ESP_OK ? 0 : -1;
+}
+
+static int spill_read(void *ctx, uint32_t seq, store_forward_record_t *records, size_t max, size_t *count)
+{
+    size_t len = max * sizeof(*records);
+    if (nvs_storage_spill_read(seq, records, &len) != ESP_OK) {
+        return -1;
+    }
+    *count = len / sizeof(*records);
+    return 0;
+}
+
+static int spill_erase(void *ctx, uint32_t seq)
+{
+    return nvs_storage_spill_erase(seq) == ESP_OK ? 0 : -1;
+}
+
+static const store_forward_storage_t s_spill_storage = {
+    .load_range = spill_load_range,
+    .save_range = spill_save_range,
+    .write_segment = spill_write,
+    .read_segment = spill_read,
+    .erase_segment = spill_erase,
+    .ctx = NULL,
+};
+#endif
+
+#if CONFIG_HA_DISCOVERY_ENABLED
+/* Discovery payload buffer size - fits the largest single entity config */
+#define DISCOVERY_PAYLOAD_SIZE 640
+
+/* Discovery topic buffer size */
+#define DISCOVERY_TOPIC_SIZE 160
+
+/* Discovery format last published, persisted so retained configs migrate once */
+#define HA_DISCOVERY_MODE_ENTITY 0
+#define HA_DISCOVERY_MODE_DEVICE 1
+
+/* Payload telling HA to keep an entity while its discovery topic changes */
+#define MIGRATE_PAYLOAD "{\"migrate_discovery\": true}"
+
+/**
+ * @brief Identity of this node for discovery payloads
+ */
+static ha_node_t discovery_node(void)
+{
+    ha_node_t node = {
+        .discovery_prefix = CONFIG_HA_DISCOVERY_PREFIX,
+        .base_topic = CONFIG_MQTT_BASE_TOPIC,
+        .sw_version = APP_VERSION,
+    };
+    return node;
+}
+#endif
+
+#if CONFIG_MQTT_COMMANDS_ENABLED
+/**
+ * @brief Persist the current sensor settings (same as the web config page)
+ */
+static esp_err_t save_sensor_settings(void)
+{
+    return nvs_storage_save_sensor_settings(get_sensor_read_interval(),
+                                            get_sensor_publish_interval(),
+                                            (uint8_t)onewire_temp_get_resolution());
+}
+
+static uint32_t clamp_u32(uint32_t value, uint32_t min, uint32_t max)
+{
+    return value < min ? min : (value > max ? max : value);
+}
+
+/**
+ * @brief Publish the outcome of a command on the result topic
+ * @param error Error name, or NULL on success
+ * @param value Included on success if has_value is set
+ * @param address Sensor address the command applied to, or empty
+ */
+static void publish_command_result(mqtt_cmd_type_t type, const char *error,
+                                   bool has_value, uint32_t value, const char *address)
+{
+    char payload[160];
+    json_writer_t w;
+    json_writer_init(&w, payload, sizeof(payload), NULL, NULL);
+    json_writer_begin_object(&w);
+    json_writer_kv_string(&w, "command", mqtt_cmd_name(type));
+    json_writer_kv_bool(&w, "success", error == NULL);
+    if (error != NULL) {
+        json_writer_kv_string(&w, "error", error);
+    } else if (has_value) {
+        json_writer_kv_uint(&w, "value", value);
+    }
+    if (address[0] != '\0') {
+        json_writer_kv_string(&w, "address", address);
+    }
+    json_writer_end_object(&w);
+
+    int len = json_writer_finish(&w);
+    if (len > 0) {
+        mqtt_publish(s_cmd_result_topic, payload, len, 1, 0);
+    }
+}
+
+/**
+ * @brief Apply a parsed command
+ * @param cmd Command
+ * @param value Output: value applied or reported back, if any
+ * @param has_value Output: true if value should be included in the result
+ * @param deferred Output: true if the command finishes later and reports its own result
+ */
+static esp_err_t execute_command(const mqtt_cmd_t *cmd, uint32_t *value, bool *has_value,
+                                 bool *deferred)
+{
+    esp_err_t err = ESP_OK;
+    *has_value = false;
+    *deferred = false;
+
+    switch (cmd->type) {
+    case MQTT_CMD_READ_INTERVAL:
+        *value = clamp_u32(cmd->value, 1000, 300000);
+        *has_value = true;
+        set_sensor_read_interval(*value);
+        err = save_sensor_settings();
+        break;
+
+    case MQTT_CMD_PUBLISH_INTERVAL:
+        *value = clamp_u32(cmd->value, 5000, 600000);
+        *has_value = true;
+        set_sensor_publish_interval(*value);
+        err = save_sensor_settings();
+        break;
+
+    case MQTT_CMD_RESOLUTION:
+        err = onewire_temp_set_resolution((int)cmd->value);
+        if (err == ESP_OK) {
+            *value = cmd->value;
+            *has_value = true;
+            err = save_sensor_settings();
+        }
+        break;
+
+    case MQTT_CMD_RESCAN:
+        /* A bus search takes seconds; run it on the temperature task so this
+           (MQTT) task keeps servicing the connection. See mqtt_ha_rescan_done. */
+        request_sensor_rescan();
+        *deferred = true;
+        break;
+
+    case MQTT_CMD_RESET_ERROR_STATS:
+        if (cmd->address[0] == '\0') {
+            onewire_temp_reset_error_stats();
+            sensor_manager_reset_all_error_stats();
+        } else {
+            err = sensor_manager_reset_sensor_error_stats(cmd->address);
+        }
+        break;
+
+    case MQTT_CMD_READ_NOW:
+        request_sensor_read_now();
+        break;
+
+    default:
+        err = ESP_ERR_NOT_SUPPORTED;
+        break;
+    }
+
+    return err;
+}
+
+/**
+ * @brief Handle a message on the command tree and publish the result
+ */
+static void handle_command(const char *topic, int topic_len, const char *data, int data_len)
+{
+    mqtt_cmd_t cmd;
+    mqtt_cmd_status_t status = mqtt_cmd_parse(s_cmd_prefix, topic, topic_len, data, data_len, &cmd);
+    if (status == MQTT_CMD_ERR_NOT_COMMAND && CONFIG_MQTT_FLEET_TOPIC[0] != '\0') {
+        status = mqtt_cmd_parse(s_fleet_cmd_prefix, topic, topic_len, data, data_len, &cmd);
+    }
+    if (status == MQTT_CMD_ERR_NOT_COMMAND) {
+        return;
+    }
+
+    uint32_t value = 0;
+    bool has_value = false;
+    bool deferred = false;
+    const char *error = NULL;
+    if (status != MQTT_CMD_OK) {
+        error = mqtt_cmd_status_str(status);
+    } else {
+        esp_err_t err = execute_command(&cmd, &value, &has_value, &deferred);
+        if (err != ESP_OK) {
+            error = esp_err_to_name(err);
+        }
+    }
+
+    if (deferred) {
+        ESP_LOGI(TAG, "Command %.*s: started", topic_len, topic);
+        return;
+    }
+    ESP_LOGI(TAG, "Command %.*s: %s", topic_len, topic, error ? error : "OK");
+    publish_command_result(cmd.type, error, has_value, value, cmd.address);
+}
+#endif
+
+void mqtt_ha_rescan_done(esp_err_t err)
+{
+#if CONFIG_HA_DISCOVERY_ENABLED
+    if (err == ESP_OK) {
+        mqtt_ha_publish_discovery_all();
+    }
+#endif
+#if CONFIG_MQTT_COMMANDS_ENABLED
+    ESP_LOGI(TAG, "Command rescan: %s", err == ESP_OK ? "OK" : esp_err_to_name(err));
+    publish_command_result(MQTT_CMD_RESCAN, err == ESP_OK ? NULL : esp_err_to_name(err),
+                           true, (uint32_t)sensor_manager_get_count(), "");
+#endif
+}
+
 /**
  * @brief MQTT event handler
  */
@@ -35,9 +328,17 @@ static void mqtt_event_handler(void *handler_args, esp_event_base_t base,
     case MQTT_EVENT_CONNECTED:
         ESP_LOGI(TAG, "MQTT Connected to broker");
         s_connected = true;
+        s_was_connected = true;
         
         /* Publish online status */
         mqtt_ha_publish_status(true);
+
+#if CONFIG_MQTT_COMMANDS_ENABLED
+        esp_mqtt_client_subscribe(s_mqtt_client, s_cmd_filter, 1);
+        if (CONFIG_MQTT_FLEET_TOPIC[0] != '\0') {
+            esp_mqtt_client_subscribe(s_mqtt_client, s_fleet_cmd_filter, 1);
+        }
+#endif
         
         /* Register all sensors with Home Assistant */
 #if CONFIG_HA_DISCOVERY_ENABLED
@@ -60,6 +361,12 @@ static void mqtt_event_handler(void *handler_args, esp_event_base_t base,
     case MQTT_EVENT_DATA:
         ESP_LOGD(TAG, "MQTT Data received on topic %.*s", 
                  event->topic_len, event->topic);
+#if CONFIG_MQTT_COMMANDS_ENABLED
+        /* Commands are tiny - ignore anything split across events */
+        if (event->current_data_offset == 0 && event->data_len == event->total_data_len) {
+            handle_command(event->topic, event->topic_len, event->data, event->data_len);
+        }
+#endif
         break;
         
     default:
@@ -67,6 +374,199 @@ static void mqtt_event_handler(void *handler_args, esp_event_base_t base,
     }
 }
 
+/**
+ * @brief Sample time of a buffered reading as Unix time, 0 if unknown
+ */
+static uint32_t buffered_timestamp(const store_forward_record_t *rec)
+{
+    if (rec->timestamp != 0) {
+        return rec->timestamp;
+    }
+
+    /* Clock synced after the sample: derive it from uptime (same boot only) */
+    time_t now = time(NULL);
+    if (now < VALID_EPOCH_MIN || (rec->flags & STORE_FORWARD_FLAG_PREVIOUS_BOOT)) {
+        return 0;
+    }
+    uint32_t uptime_s = (uint32_t)(esp_timer_get_time() / 1000000);
+    return (uint32_t)now - (uptime_s - rec->uptime_s);
+}
+
+/**
+ * @brief Publish one buffered reading on its backfill topic
+ */
+static esp_err_t publish_buffered(const store_forward_record_t *rec)
+{
+    char address_str[17];
+    onewire_address_to_string(rec->address, address_str);
+
+    char topic[128];
+    snprintf(topic, sizeof(topic), "%s/sensor/%s/backfill", CONFIG_MQTT_BASE_TOPIC, address_str);
+
+    char payload[64];
+    json_writer_t w;
+    json_writer_init(&w, payload, sizeof(payload), NULL, NULL);
+    json_writer_begin_object(&w);
+    json_writer_kv_double(&w, "temperature", rec->temp_centi / 100.0);
+    uint32_t timestamp = buffered_timestamp(rec);
+    if (timestamp != 0) {
+        json_writer_kv_uint(&w, "timestamp", timestamp);
+    }
+    json_writer_end_object(&w);
+
+    int len = json_writer_finish(&w);
+    if (len < 0) {
+        return ESP_FAIL;
+    }
+
+    int msg_id = mqtt_publish(topic, payload, len, 1, 0);
+    return msg_id < 0 ? ESP_FAIL : ESP_OK;
+}
+
+/**
+ * @brief Replay buffered readings at CONFIG_MQTT_REPLAY_RATE while connected
+ */
+static void replay_task(void *pvParameters)
+{
+    int64_t session_start = 0;
+    uint32_t session_count = 0;
+
+    while (1) {
+        vTaskDelay(pdMS_TO_TICKS(1000));
+
+        int sent = 0;
+        bool drained = false;
+
+        while (s_connected && sent < CONFIG_MQTT_REPLAY_RATE) {
+            store_forward_record_t rec;
+            xSemaphoreTake(s_buffer_mutex, portMAX_DELAY);
+            int empty = store_forward_peek(&s_buffer, &rec);
+            xSemaphoreGive(s_buffer_mutex);
+            if (empty != 0) {
+                drained = true;
+                break;
+            }
+
+            /* Publish without the mutex: a slow broker must not hold up
+               readers buffering new readings or reporting stats */
+            if (publish_buffered(&rec) != ESP_OK) {
+                break;  /* Still queued - retried next round */
+            }
+
+            /* Pop only if the head is still this record; a concurrent
+               overflow may have dropped it while it was being sent */
+            xSemaphoreTake(s_buffer_mutex, portMAX_DELAY);
+            store_forward_record_t head;
+            if (store_forward_peek(&s_buffer, &head) == 0 &&
+                memcmp(&head, &rec, sizeof(rec)) == 0) {
+                store_forward_pop(&s_buffer);
+            }
+            xSemaphoreGive(s_buffer_mutex);
+            sent++;
+        }
+
+        if (sent > 0) {
+            if (session_start == 0) {
+                session_start = esp_timer_get_time();
+                session_count = 0;
+                ESP_LOGI(TAG, "Replaying buffered readings");
+            }
+            session_count += sent;
+            int64_t elapsed_us = esp_timer_get_time() - session_start + 1000000;
+            s_replay_rate = session_count * 1000000.0f / elapsed_us;
+        }
+
+        if (drained && session_start != 0) {
+            ESP_LOGI(TAG, "Replayed %lu buffered readings (%.1f/s)",
+                     (unsigned long)session_count, s_replay_rate);
+            session_start = 0;
+        }
+    }
+}
+
+/**
+ * @brief Set up the offline buffer, picking up readings spilled before reboot
+ */
+static void buffer_init(void)
+{
+    if (s_buffer_mutex != NULL) {
+        return;  /* Already running - MQTT was reconfigured */
+    }
+    s_buffer_mutex = xSemaphoreCreateMutex();
+
+    store_forward_config_t cfg = {
+        .ram = s_buffer_ram,
+        .ram_capacity = CONFIG_MQTT_BUFFER_RAM_RECORDS,
+    };
+#if CONFIG_MQTT_BUFFER_FLASH_SEGMENTS > 0
+    if (nvs_storage_spill_init() == ESP_OK) {
+        cfg.spill_buf = s_buffer_spill;
+        cfg.replay_buf = s_buffer_replay;
+        cfg.segment_records = BUFFER_SEGMENT_RECORDS;
+        cfg.max_segments = CONFIG_MQTT_BUFFER_FLASH_SEGMENTS;
+        cfg.storage = &s_spill_storage;
+    } else {
+        ESP_LOGW(TAG, "Offline buffer limited to RAM");
+    }
+#endif
+    store_forward_init(&s_buffer, &cfg);
+
+    uint32_t pending = store_forward_depth(&s_buffer);
+    if (pending > 0) {
+        ESP_LOGI(TAG, "%lu buffered readings pending from previous boot", (unsigned long)pending);
+    }
+
+    xTaskCreate(replay_task, "mqtt_replay", 3072, NULL, 3, NULL);
+}
+
+/**
+ * @brief Unix time of a reading taken at read_time_ms uptime (0 if clock not synced)
+ */
+static uint32_t sample_timestamp(int64_t read_time_ms)
+{
+    time_t now = time(NULL);
+    if (now < VALID_EPOCH_MIN) {
+        return 0;
+    }
+    int64_t age_s = (esp_timer_get_time() / 1000 - read_time_ms) / 1000;
+    return (uint32_t)(now - age_s);
+}
+
+esp_err_t mqtt_ha_buffer_temperature(const uint8_t *address, float temperature, int64_t read_time_ms)
+{
+    if (s_buffer_mutex == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    store_forward_record_t rec = {0};
+    memcpy(rec.address, address, sizeof(rec.address));
+    rec.temp_centi = (int16_t)telemetry_temp_to_centi(temperature);
+    rec.uptime_s = (uint32_t)(read_time_ms / 1000);
+    rec.timestamp = sample_timestamp(read_time_ms);
+
+    xSemaphoreTake(s_buffer_mutex, portMAX_DELAY);
+    store_forward_push(&s_buffer, &rec);
+    xSemaphoreGive(s_buffer_mutex);
+    return ESP_OK;
+}
+
+void mqtt_ha_get_buffer_stats(mqtt_buffer_stats_t *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+    if (s_buffer_mutex == NULL) {
+        return;
+    }
+
+    xSemaphoreTake(s_buffer_mutex, portMAX_DELAY);
+    stats->depth = store_forward_depth(&s_buffer);
+    stats->flash_depth = store_forward_flash_depth(&s_buffer);
+    stats->captured = s_buffer.captured;
+    stats->dropped = s_buffer.dropped;
+    stats->replayed = s_buffer.replayed;
+    xSemaphoreGive(s_buffer_mutex);
+    stats->replay_rate = s_replay_rate;
+}
+
 esp_err_t mqtt_ha_init(void)
 {
     ESP_LOGD(TAG, "Initializing MQTT client");
@@ -109,6 +609,8 @@ esp_err_t mqtt_ha_init(void)
     esp_mqtt_client_register_event(s_mqtt_client, ESP_EVENT_ANY_ID, 
                                    mqtt_event_handler, NULL);
 
+    buffer_init();
+
     ESP_LOGD(TAG, "Starting MQTT client, broker: %s", broker_uri);
     return esp_mqtt_client_start(s_mqtt_client);
 }
@@ -135,6 +637,17 @@ bool mqtt_ha_is_connected(void)
     return s_connected;
 }
 
+bool mqtt_ha_was_connected(void)
+{
+    return s_was_connected;
+}
+
+void mqtt_ha_get_publish_stats(uint32_t *published, uint32_t *failed)
+{
+    *published = s_publish_ok;
+    *failed = s_publish_failed;
+}
+
 esp_err_t mqtt_ha_publish_temperature(const char *sensor_id, const char *friendly_name, float temperature)
 {
     if (!s_connected || s_mqtt_client == NULL) {
@@ -149,7 +662,7 @@ esp_err_t mqtt_ha_publish_temperature(const char *sensor_id, const char *friendl
              CONFIG_MQTT_BASE_TOPIC, sensor_id);
     snprintf(payload, sizeof(payload), "%.2f", temperature);
 
-    int msg_id = esp_mqtt_client_publish(s_mqtt_client, topic, payload, 0, 1, 0);
+    int msg_id = mqtt_publish(topic, payload, 0, 1, 0);
     if (msg_id < 0) {
         ESP_LOGE(TAG, "Failed to publish temperature for %s", sensor_id);
         return ESP_FAIL;
@@ -159,72 +672,215 @@ esp_err_t mqtt_ha_publish_temperature(const char *sensor_id, const char *friendl
     return ESP_OK;
 }
 
-esp_err_t mqtt_ha_register_sensor(const char *sensor_id, const char *friendly_name)
-{
 #if CONFIG_HA_DISCOVERY_ENABLED
+/**
+ * @brief Publish a retained discovery payload (NULL clears the topic)
+ */
+static esp_err_t publish_discovery(const char *topic, const char *payload, int len)
+{
+    int msg_id = mqtt_publish(topic, payload ? payload : "", payload ? len : 0, 1, 1);
+    return msg_id < 0 ? ESP_FAIL : ESP_OK;
+}
+#endif
+
+#if CONFIG_HA_DISCOVERY_DEVICE
+/**
+ * @brief Publish the same payload to every legacy per-entity topic of this node
+ *
+ * Used to migrate between discovery formats.
+ */
+static void publish_legacy_topics(const ha_node_t *node, const char *payload)
+{
+    char topic[DISCOVERY_TOPIC_SIZE];
+    int count;
+    const managed_sensor_t *sensors = sensor_manager_get_sensors(&count);
+
+    for (int i = 0; i < count; i++) {
+        if (ha_discovery_entity_topic(topic, sizeof(topic), node, "sensor",
+                                      sensors[i].address_str) > 0) {
+            publish_discovery(topic, payload, payload ? strlen(payload) : 0);
+        }
+    }
+    for (size_t i = 0; i < ha_diag_entity_count; i++) {
+        const ha_diag_entity_t *e = &ha_diag_entities[i];
+        if (ha_discovery_entity_topic(topic, sizeof(topic), node, e->component, e->object_id) > 0) {
+            publish_discovery(topic, payload, payload ? strlen(payload) : 0);
+        }
+    }
+}
+
+static int count_sink(void *ctx, const char *data, size_t len)
+{
+    (void)data;
+    *(size_t *)ctx += len;
+    return 0;
+}
+
+/**
+ * @brief Publish the single device-based config for all sensors and diagnostics
+ *
+ * The payload grows with the sensor count, so it is sized with a counting
+ * pass through the writer and then rendered into an exact-size buffer.
+ */
+static esp_err_t publish_device_discovery(const ha_node_t *node)
+{
+    int count;
+    const managed_sensor_t *sensors = sensor_manager_get_sensors(&count);
+
+    ha_sensor_t *list = calloc(count > 0 ? count : 1, sizeof(ha_sensor_t));
+    if (list == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    for (int i = 0; i < count; i++) {
+        list[i].id = sensors[i].address_str;
+        list[i].name = sensors[i].has_friendly_name ?
+                       sensors[i].friendly_name : sensors[i].address_str;
+    }
+
+    char scratch[64];
+    size_t total = 0;
+    json_writer_t w;
+    json_writer_init(&w, scratch, sizeof(scratch), count_sink, &total);
+    ha_discovery_write_device_config(&w, node, list, count);
+    int len = json_writer_finish(&w);
+
+    char *payload = len > 0 ? malloc(len + 1) : NULL;
+    if (payload == NULL) {
+        free(list);
+        ESP_LOGE(TAG, "Failed to create device discovery payload");
+        return ESP_ERR_NO_MEM;
+    }
+    json_writer_init(&w, payload, len + 1, NULL, NULL);
+    ha_discovery_write_device_config(&w, node, list, count);
+    len = json_writer_finish(&w);
+    free(list);
+
+    char topic[DISCOVERY_TOPIC_SIZE];
+    esp_err_t err = ESP_FAIL;
+    if (len > 0 && ha_discovery_device_topic(topic, sizeof(topic), node) > 0) {
+        err = publish_discovery(topic, payload, len);
+    }
+    free(payload);
+
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to publish device discovery");
+        return err;
+    }
+    ESP_LOGD(TAG, "Published device discovery: %d sensors, %d bytes", count, len);
+    return ESP_OK;
+}
+#endif
+
+esp_err_t mqtt_ha_publish_telemetry(void)
+{
+#if CONFIG_MQTT_TELEMETRY_CBOR
     if (!s_connected || s_mqtt_client == NULL) {
         return ESP_ERR_INVALID_STATE;
     }
 
-    /* Discovery topic: homeassistant/sensor/esp32-poe-temp_sensor_id/config */
-    char discovery_topic[256];
-    snprintf(discovery_topic, sizeof(discovery_topic), 
-             "%s/sensor/%s_%s/config",
-             CONFIG_HA_DISCOVERY_PREFIX, CONFIG_MQTT_BASE_TOPIC, sensor_id);
+    int count;
+    const managed_sensor_t *sensors = sensor_manager_get_sensors(&count);
+    if (count <= 0) {
+        return ESP_OK;
+    }
 
-    /* Build discovery payload using cJSON */
-    cJSON *root = cJSON_CreateObject();
-    
-    /* Basic info */
-    cJSON_AddStringToObject(root, "name", friendly_name);
-    
-    /* Unique ID */
-    char unique_id[64];
-    snprintf(unique_id, sizeof(unique_id), "%s_%s", CONFIG_MQTT_BASE_TOPIC, sensor_id);
-    cJSON_AddStringToObject(root, "unique_id", unique_id);
-    
-    /* State topic */
-    char state_topic[128];
-    snprintf(state_topic, sizeof(state_topic), "%s/sensor/%s/state", 
-             CONFIG_MQTT_BASE_TOPIC, sensor_id);
-    cJSON_AddStringToObject(root, "state_topic", state_topic);
-    
-    /* Availability */
-    char availability_topic[128];
-    snprintf(availability_topic, sizeof(availability_topic), "%s/status", CONFIG_MQTT_BASE_TOPIC);
-    cJSON_AddStringToObject(root, "availability_topic", availability_topic);
-    
-    /* Device class and unit */
-    cJSON_AddStringToObject(root, "device_class", "temperature");
-    cJSON_AddStringToObject(root, "unit_of_measurement", "°C");
-    cJSON_AddStringToObject(root, "state_class", "measurement");
-    
-    /* Device info (groups all sensors under one device) */
-    cJSON *device = cJSON_CreateObject();
-    cJSON_AddStringToObject(device, "name", "Thermux");
-    cJSON_AddStringToObject(device, "manufacturer", "Custom");
-    cJSON_AddStringToObject(device, "model", "ESP32-POE-ISO");
-    cJSON_AddStringToObject(device, "sw_version", APP_VERSION);
-    
-    cJSON *identifiers = cJSON_CreateArray();
-    cJSON_AddItemToArray(identifiers, cJSON_CreateString(CONFIG_MQTT_BASE_TOPIC));
-    cJSON_AddItemToObject(device, "identifiers", identifiers);
-    
-    cJSON_AddItemToObject(root, "device", device);
+    /* The read task keeps updating the sensor array: take the valid readings
+       once, so the array header and its items agree */
+    telemetry_reading_t *readings = malloc(count * sizeof(telemetry_reading_t));
+    if (readings == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    int valid = 0;
+    for (int i = 0; i < count; i++) {
+        const onewire_sensor_t *hw = &sensors[i].hw_sensor;
+        if (!hw->valid) {
+            continue;
+        }
+        telemetry_reading_t *reading = &readings[valid++];
+        memcpy(reading->rom, hw->address, sizeof(reading->rom));
+        reading->temp_centi = telemetry_temp_to_centi(hw->temperature);
+        reading->timestamp = sample_timestamp(hw->last_read_time);
+    }
+    if (valid == 0) {
+        free(readings);
+        return ESP_OK;
+    }
 
-    char *payload = cJSON_PrintUnformatted(root);
-    cJSON_Delete(root);
-    
+    size_t size = TELEMETRY_CBOR_BATCH_SIZE(valid);
+    uint8_t *payload = malloc(size);
     if (payload == NULL) {
-        ESP_LOGE(TAG, "Failed to create discovery payload");
+        free(readings);
         return ESP_ERR_NO_MEM;
     }
 
-    int msg_id = esp_mqtt_client_publish(s_mqtt_client, discovery_topic, 
-                                          payload, 0, 1, 1);
+    cbor_writer_t w;
+    cbor_writer_init(&w, payload, size);
+    time_t now = time(NULL);
+    telemetry_cbor_begin(&w, now >= VALID_EPOCH_MIN ? (uint32_t)now : 0, valid);
+    for (int i = 0; i < valid; i++) {
+        telemetry_cbor_add(&w, &readings[i]);
+    }
+    free(readings);
+
+    int len = cbor_writer_finish(&w);
+    int msg_id = -1;
+    if (len > 0) {
+        char topic[128];
+        snprintf(topic, sizeof(topic), "%s/telemetry", CONFIG_MQTT_BASE_TOPIC);
+        msg_id = mqtt_publish(topic, (const char *)payload, len, 1, 0);
+    }
     free(payload);
 
     if (msg_id < 0) {
+        ESP_LOGE(TAG, "Failed to publish telemetry batch");
+        return ESP_FAIL;
+    }
+    ESP_LOGD(TAG, "Published telemetry batch: %d readings, %d bytes", valid, len);
+    return ESP_OK;
+#else
+    return ESP_OK;
+#endif
+}
+
+esp_err_t mqtt_ha_register_sensor(const char *sensor_id, const char *friendly_name)
+{
+#if CONFIG_HA_DISCOVERY_DEVICE
+    /* All components share one message, so re-render it */
+    (void)sensor_id;
+    (void)friendly_name;
+    if (!s_connected || s_mqtt_client == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    ha_node_t node = discovery_node();
+    return publish_device_discovery(&node);
+#elif CONFIG_HA_DISCOVERY_ENABLED
+    if (!s_connected || s_mqtt_client == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    ha_node_t node = discovery_node();
+    ha_sensor_t sensor = { .id = sensor_id, .name = friendly_name };
+
+    /* Discovery topic: homeassistant/sensor/esp32-poe-temp_sensor_id/config */
+    char discovery_topic[DISCOVERY_TOPIC_SIZE];
+    if (ha_discovery_entity_topic(discovery_topic, sizeof(discovery_topic),
+                                  &node, "sensor", sensor_id) < 0) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+
+    /* Build discovery payload straight into a stack buffer */
+    char payload[DISCOVERY_PAYLOAD_SIZE];
+    json_writer_t w;
+    json_writer_init(&w, payload, sizeof(payload), NULL, NULL);
+    ha_discovery_write_sensor_config(&w, &node, &sensor);
+
+    int len = json_writer_finish(&w);
+    if (len < 0) {
+        ESP_LOGE(TAG, "Failed to create discovery payload");
+        return ESP_ERR_NO_MEM;
+    }
+
+    if (publish_discovery(discovery_topic, payload, len) != ESP_OK) {
         ESP_LOGE(TAG, "Failed to publish discovery for %s", sensor_id);
         return ESP_FAIL;
     }
@@ -247,7 +903,7 @@ esp_err_t mqtt_ha_publish_status(bool online)
 
     const char *payload = online ? "online" : "offline";
     
-    int msg_id = esp_mqtt_client_publish(s_mqtt_client, topic, payload, 0, 1, 1);
+    int msg_id = mqtt_publish(topic, payload, 0, 1, 1);
     if (msg_id < 0) {
         ESP_LOGE(TAG, "Failed to publish status");
         return ESP_FAIL;
@@ -260,6 +916,38 @@ esp_err_t mqtt_ha_publish_status(bool online)
 esp_err_t mqtt_ha_publish_discovery_all(void)
 {
 #if CONFIG_HA_DISCOVERY_ENABLED
+    if (!s_connected || s_mqtt_client == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    ha_node_t node = discovery_node();
+    uint8_t published_mode = HA_DISCOVERY_MODE_ENTITY;
+    nvs_storage_load_ha_discovery_mode(&published_mode);
+
+#if CONFIG_HA_DISCOVERY_DEVICE
+    if (published_mode != HA_DISCOVERY_MODE_DEVICE) {
+        /* Move entities from per-entity topics to the device topic without
+         * HA dropping them, then clear the old retained configs */
+        ESP_LOGI(TAG, "Migrating HA discovery to device-based format");
+        publish_legacy_topics(&node, MIGRATE_PAYLOAD);
+        esp_err_t err = publish_device_discovery(&node);
+        if (err != ESP_OK) {
+            return err;
+        }
+        publish_legacy_topics(&node, NULL);
+        nvs_storage_save_ha_discovery_mode(HA_DISCOVERY_MODE_DEVICE);
+        return ESP_OK;
+    }
+    return publish_device_discovery(&node);
+#else
+    char device_topic[DISCOVERY_TOPIC_SIZE];
+    bool migrate = published_mode == HA_DISCOVERY_MODE_DEVICE &&
+                   ha_discovery_device_topic(device_topic, sizeof(device_topic), &node) > 0;
+    if (migrate) {
+        ESP_LOGI(TAG, "Migrating HA discovery to per-entity format");
+        publish_discovery(device_topic, MIGRATE_PAYLOAD, strlen(MIGRATE_PAYLOAD));
+    }
+
     int count;
     const managed_sensor_t *sensors = sensor_manager_get_sensors(&count);
     
@@ -271,266 +959,55 @@ esp_err_t mqtt_ha_publish_discovery_all(void)
     
     /* Register diagnostic entities */
     mqtt_ha_register_diagnostic_entities();
+
+    if (migrate) {
+        publish_discovery(device_topic, NULL, 0);
+        nvs_storage_save_ha_discovery_mode(HA_DISCOVERY_MODE_ENTITY);
+    }
     
     ESP_LOGD(TAG, "Published discovery for %d sensors + diagnostics", count);
     return ESP_OK;
+#endif
 #else
     return ESP_OK;
 #endif
 }
 
-/**
- * @brief Helper to create device info JSON object (shared between entities)
- */
-static cJSON* create_device_info(void)
-{
-    cJSON *device = cJSON_CreateObject();
-    cJSON_AddStringToObject(device, "name", "Thermux");
-    cJSON_AddStringToObject(device, "manufacturer", "Custom");
-    cJSON_AddStringToObject(device, "model", "ESP32-POE-ISO");
-    cJSON_AddStringToObject(device, "sw_version", APP_VERSION);
-    
-    cJSON *identifiers = cJSON_CreateArray();
-    cJSON_AddItemToArray(identifiers, cJSON_CreateString(CONFIG_MQTT_BASE_TOPIC));
-    cJSON_AddItemToObject(device, "identifiers", identifiers);
-    
-    return device;
-}
-
 esp_err_t mqtt_ha_register_diagnostic_entities(void)
 {
-#if CONFIG_HA_DISCOVERY_ENABLED
+#if CONFIG_HA_DISCOVERY_DEVICE
     if (!s_connected || s_mqtt_client == NULL) {
         return ESP_ERR_INVALID_STATE;
     }
-
-    /* Register Ethernet Status binary sensor */
-    {
-        char discovery_topic[256];
-        snprintf(discovery_topic, sizeof(discovery_topic), 
-                 "%s/binary_sensor/%s_ethernet/config",
-                 CONFIG_HA_DISCOVERY_PREFIX, CONFIG_MQTT_BASE_TOPIC);
-
-        cJSON *root = cJSON_CreateObject();
-        cJSON_AddStringToObject(root, "name", "Ethernet");
-        
-        char unique_id[64];
-        snprintf(unique_id, sizeof(unique_id), "%s_ethernet", CONFIG_MQTT_BASE_TOPIC);
-        cJSON_AddStringToObject(root, "unique_id", unique_id);
-        
-        char state_topic[128];
-        snprintf(state_topic, sizeof(state_topic), "%s/diagnostic/ethernet", CONFIG_MQTT_BASE_TOPIC);
-        cJSON_AddStringToObject(root, "state_topic", state_topic);
-        
-        char availability_topic[128];
-        snprintf(availability_topic, sizeof(availability_topic), "%s/status", CONFIG_MQTT_BASE_TOPIC);
-        cJSON_AddStringToObject(root, "availability_topic", availability_topic);
-        
-        cJSON_AddStringToObject(root, "device_class", "connectivity");
-        cJSON_AddStringToObject(root, "entity_category", "diagnostic");
-        cJSON_AddStringToObject(root, "payload_on", "ON");
-        cJSON_AddStringToObject(root, "payload_off", "OFF");
-        
-        cJSON_AddItemToObject(root, "device", create_device_info());
-
-        char *payload = cJSON_PrintUnformatted(root);
-        cJSON_Delete(root);
-        
-        if (payload) {
-            esp_mqtt_client_publish(s_mqtt_client, discovery_topic, payload, 0, 1, 1);
-            free(payload);
-            ESP_LOGD(TAG, "Registered diagnostic: Ethernet status");
-        }
-    }
-
-    /* Register WiFi Status binary sensor */
-    {
-        char discovery_topic[256];
-        snprintf(discovery_topic, sizeof(discovery_topic), 
-                 "%s/binary_sensor/%s_wifi/config",
-                 CONFIG_HA_DISCOVERY_PREFIX, CONFIG_MQTT_BASE_TOPIC);
-
-        cJSON *root = cJSON_CreateObject();
-        cJSON_AddStringToObject(root, "name", "WiFi");
-        
-        char unique_id[64];
-        snprintf(unique_id, sizeof(unique_id), "%s_wifi", CONFIG_MQTT_BASE_TOPIC);
-        cJSON_AddStringToObject(root, "unique_id", unique_id);
-        
-        char state_topic[128];
-        snprintf(state_topic, sizeof(state_topic), "%s/diagnostic/wifi", CONFIG_MQTT_BASE_TOPIC);
-        cJSON_AddStringToObject(root, "state_topic", state_topic);
-        
-        char availability_topic[128];
-        snprintf(availability_topic, sizeof(availability_topic), "%s/status", CONFIG_MQTT_BASE_TOPIC);
-        cJSON_AddStringToObject(root, "availability_topic", availability_topic);
-        
-        cJSON_AddStringToObject(root, "device_class", "connectivity");
-        cJSON_AddStringToObject(root, "entity_category", "diagnostic");
-        cJSON_AddStringToObject(root, "payload_on", "ON");
-        cJSON_AddStringToObject(root, "payload_off", "OFF");
-        
-        cJSON_AddItemToObject(root, "device", create_device_info());
-
-        char *payload = cJSON_PrintUnformatted(root);
-        cJSON_Delete(root);
-        
-        if (payload) {
-            esp_mqtt_client_publish(s_mqtt_client, discovery_topic, payload, 0, 1, 1);
-            free(payload);
-            ESP_LOGD(TAG, "Registered diagnostic: WiFi status");
-        }
-    }
-
-    /* Register IP Address sensor */
-    {
-        char discovery_topic[256];
-        snprintf(discovery_topic, sizeof(discovery_topic), 
-                 "%s/sensor/%s_ip_address/config",
-                 CONFIG_HA_DISCOVERY_PREFIX, CONFIG_MQTT_BASE_TOPIC);
-
-        cJSON *root = cJSON_CreateObject();
-        cJSON_AddStringToObject(root, "name", "IP Address");
-        
-        char unique_id[64];
-        snprintf(unique_id, sizeof(unique_id), "%s_ip_address", CONFIG_MQTT_BASE_TOPIC);
-        cJSON_AddStringToObject(root, "unique_id", unique_id);
-        
-        char state_topic[128];
-        snprintf(state_topic, sizeof(state_topic), "%s/diagnostic/ip", CONFIG_MQTT_BASE_TOPIC);
-        cJSON_AddStringToObject(root, "state_topic", state_topic);
-        
-        char availability_topic[128];
-        snprintf(availability_topic, sizeof(availability_topic), "%s/status", CONFIG_MQTT_BASE_TOPIC);
-        cJSON_AddStringToObject(root, "availability_topic", availability_topic);
-        
-        cJSON_AddStringToObject(root, "icon", "mdi:ip-network");
-        cJSON_AddStringToObject(root, "entity_category", "diagnostic");
-        
-        cJSON_AddItemToObject(root, "device", create_device_info());
-
-        char *payload = cJSON_PrintUnformatted(root);
-        cJSON_Delete(root);
-        
-        if (payload) {
-            esp_mqtt_client_publish(s_mqtt_client, discovery_topic, payload, 0, 1, 1);
-            free(payload);
-            ESP_LOGD(TAG, "Registered diagnostic: IP Address");
-        }
-    }
-
-    /* Register Bus Error Rate sensor */
-    {
-        char discovery_topic[256];
-        snprintf(discovery_topic, sizeof(discovery_topic), 
-                 "%s/sensor/%s_bus_error_rate/config",
-                 CONFIG_HA_DISCOVERY_PREFIX, CONFIG_MQTT_BASE_TOPIC);
-
-        cJSON *root = cJSON_CreateObject();
-        cJSON_AddStringToObject(root, "name", "Bus Error Rate");
-        
-        char unique_id[64];
-        snprintf(unique_id, sizeof(unique_id), "%s_bus_error_rate", CONFIG_MQTT_BASE_TOPIC);
-        cJSON_AddStringToObject(root, "unique_id", unique_id);
-        
-        char state_topic[128];
-        snprintf(state_topic, sizeof(state_topic), "%s/diagnostic/bus_error_rate", CONFIG_MQTT_BASE_TOPIC);
-        cJSON_AddStringToObject(root, "state_topic", state_topic);
-        
-        char availability_topic[128];
-        snprintf(availability_topic, sizeof(availability_topic), "%s/status", CONFIG_MQTT_BASE_TOPIC);
-        cJSON_AddStringToObject(root, "availability_topic", availability_topic);
-        
-        cJSON_AddStringToObject(root, "icon", "mdi:alert-circle-outline");
-        cJSON_AddStringToObject(root, "entity_category", "diagnostic");
-        cJSON_AddStringToObject(root, "unit_of_measurement", "%");
-        cJSON_AddStringToObject(root, "state_class", "measurement");
-        
-        cJSON_AddItemToObject(root, "device", create_device_info());
-
-        char *payload = cJSON_PrintUnformatted(root);
-        cJSON_Delete(root);
-        
-        if (payload) {
-            esp_mqtt_client_publish(s_mqtt_client, discovery_topic, payload, 0, 1, 1);
-            free(payload);
-            ESP_LOGD(TAG, "Registered diagnostic: Bus Error Rate");
-        }
+    ha_node_t node = discovery_node();
+    return publish_device_discovery(&node);
+#elif CONFIG_HA_DISCOVERY_ENABLED
+    if (!s_connected || s_mqtt_client == NULL) {
+        return ESP_ERR_INVALID_STATE;
     }
 
-    /* Register Bus Total Reads sensor */
-    {
-        char discovery_topic[256];
-        snprintf(discovery_topic, sizeof(discovery_topic), 
-                 "%s/sensor/%s_bus_total_reads/config",
-                 CONFIG_HA_DISCOVERY_PREFIX, CONFIG_MQTT_BASE_TOPIC);
+    ha_node_t node = discovery_node();
 
-        cJSON *root = cJSON_CreateObject();
-        cJSON_AddStringToObject(root, "name", "Bus Total Reads");
-        
-        char unique_id[64];
-        snprintf(unique_id, sizeof(unique_id), "%s_bus_total_reads", CONFIG_MQTT_BASE_TOPIC);
-        cJSON_AddStringToObject(root, "unique_id", unique_id);
-        
-        char state_topic[128];
-        snprintf(state_topic, sizeof(state_topic), "%s/diagnostic/bus_total_reads", CONFIG_MQTT_BASE_TOPIC);
-        cJSON_AddStringToObject(root, "state_topic", state_topic);
-        
-        char availability_topic[128];
-        snprintf(availability_topic, sizeof(availability_topic), "%s/status", CONFIG_MQTT_BASE_TOPIC);
-        cJSON_AddStringToObject(root, "availability_topic", availability_topic);
-        
-        cJSON_AddStringToObject(root, "icon", "mdi:counter");
-        cJSON_AddStringToObject(root, "entity_category", "diagnostic");
-        cJSON_AddStringToObject(root, "state_class", "total_increasing");
-        
-        cJSON_AddItemToObject(root, "device", create_device_info());
+    for (size_t i = 0; i < ha_diag_entity_count; i++) {
+        const ha_diag_entity_t *e = &ha_diag_entities[i];
 
-        char *payload = cJSON_PrintUnformatted(root);
-        cJSON_Delete(root);
-        
-        if (payload) {
-            esp_mqtt_client_publish(s_mqtt_client, discovery_topic, payload, 0, 1, 1);
-            free(payload);
-            ESP_LOGD(TAG, "Registered diagnostic: Bus Total Reads");
+        char discovery_topic[DISCOVERY_TOPIC_SIZE];
+        if (ha_discovery_entity_topic(discovery_topic, sizeof(discovery_topic),
+                                      &node, e->component, e->object_id) < 0) {
+            continue;
         }
-    }
 
-    /* Register Bus Failed Reads sensor */
-    {
-        char discovery_topic[256];
-        snprintf(discovery_topic, sizeof(discovery_topic), 
-                 "%s/sensor/%s_bus_failed_reads/config",
-                 CONFIG_HA_DISCOVERY_PREFIX, CONFIG_MQTT_BASE_TOPIC);
+        char payload[DISCOVERY_PAYLOAD_SIZE];
+        json_writer_t w;
+        json_writer_init(&w, payload, sizeof(payload), NULL, NULL);
+        ha_discovery_write_diag_config(&w, &node, e);
 
-        cJSON *root = cJSON_CreateObject();
-        cJSON_AddStringToObject(root, "name", "Bus Failed Reads");
-        
-        char unique_id[64];
-        snprintf(unique_id, sizeof(unique_id), "%s_bus_failed_reads", CONFIG_MQTT_BASE_TOPIC);
-        cJSON_AddStringToObject(root, "unique_id", unique_id);
-        
-        char state_topic[128];
-        snprintf(state_topic, sizeof(state_topic), "%s/diagnostic/bus_failed_reads", CONFIG_MQTT_BASE_TOPIC);
-        cJSON_AddStringToObject(root, "state_topic", state_topic);
-        
-        char availability_topic[128];
-        snprintf(availability_topic, sizeof(availability_topic), "%s/status", CONFIG_MQTT_BASE_TOPIC);
-        cJSON_AddStringToObject(root, "availability_topic", availability_topic);
-        
-        cJSON_AddStringToObject(root, "icon", "mdi:alert-circle");
-        cJSON_AddStringToObject(root, "entity_category", "diagnostic");
-        cJSON_AddStringToObject(root, "state_class", "total_increasing");
-        
-        cJSON_AddItemToObject(root, "device", create_device_info());
-
-        char *payload = cJSON_PrintUnformatted(root);
-        cJSON_Delete(root);
-        
-        if (payload) {
-            esp_mqtt_client_publish(s_mqtt_client, discovery_topic, payload, 0, 1, 1);
-            free(payload);
-            ESP_LOGD(TAG, "Registered diagnostic: Bus Failed Reads");
+        int len = json_writer_finish(&w);
+        if (len > 0) {
+            publish_discovery(discovery_topic, payload, len);
+            ESP_LOGD(TAG, "Registered diagnostic: %s", e->name);
+        } else {
+            ESP_LOGE(TAG, "Failed to create discovery payload for %s", e->name);
         }
     }
 
@@ -551,12 +1028,12 @@ esp_err_t mqtt_ha_publish_diagnostics(void)
     /* Publish Ethernet status */
     bool eth_connected = ethernet_manager_is_connected();
     snprintf(topic, sizeof(topic), "%s/diagnostic/ethernet", CONFIG_MQTT_BASE_TOPIC);
-    esp_mqtt_client_publish(s_mqtt_client, topic, eth_connected ? "ON" : "OFF", 0, 1, 0);
+    mqtt_publish(topic, eth_connected ? "ON" : "OFF", 0, 1, 0);
     
     /* Publish WiFi status */
     bool wifi_connected = wifi_manager_is_connected();
     snprintf(topic, sizeof(topic), "%s/diagnostic/wifi", CONFIG_MQTT_BASE_TOPIC);
-    esp_mqtt_client_publish(s_mqtt_client, topic, wifi_connected ? "ON" : "OFF", 0, 1, 0);
+    mqtt_publish(topic, wifi_connected ? "ON" : "OFF", 0, 1, 0);
     
     /* Publish IP Address (prefer Ethernet, fallback to WiFi) */
     const char *ip = "";
@@ -566,7 +1043,7 @@ esp_err_t mqtt_ha_publish_diagnostics(void)
         ip = wifi_manager_get_ip();
     }
     snprintf(topic, sizeof(topic), "%s/diagnostic/ip", CONFIG_MQTT_BASE_TOPIC);
-    esp_mqtt_client_publish(s_mqtt_client, topic, ip, 0, 1, 0);
+    mqtt_publish(topic, ip, 0, 1, 0);
     
     ESP_LOGD(TAG, "Published diagnostics: eth=%d, wifi=%d, ip=%s", eth_connected, wifi_connected, ip);
 
@@ -577,19 +1054,35 @@ esp_err_t mqtt_ha_publish_diagnostics(void)
     char value_buf[32];
     snprintf(topic, sizeof(topic), "%s/diagnostic/bus_error_rate", CONFIG_MQTT_BASE_TOPIC);
     snprintf(value_buf, sizeof(value_buf), "%.2f", total_reads > 0 ? (double)failed_reads / total_reads * 100.0 : 0.0);
-    esp_mqtt_client_publish(s_mqtt_client, topic, value_buf, 0, 1, 0);
+    mqtt_publish(topic, value_buf, 0, 1, 0);
     
     snprintf(topic, sizeof(topic), "%s/diagnostic/bus_total_reads", CONFIG_MQTT_BASE_TOPIC);
     snprintf(value_buf, sizeof(value_buf), "%lu", (unsigned long)total_reads);
-    esp_mqtt_client_publish(s_mqtt_client, topic, value_buf, 0, 1, 0);
+    mqtt_publish(topic, value_buf, 0, 1, 0);
     
     snprintf(topic, sizeof(topic), "%s/diagnostic/bus_failed_reads", CONFIG_MQTT_BASE_TOPIC);
     snprintf(value_buf, sizeof(value_buf), "%lu", (unsigned long)failed_reads);
-    esp_mqtt_client_publish(s_mqtt_client, topic, value_buf, 0, 1, 0);
+    mqtt_publish(topic, value_buf, 0, 1, 0);
     
     ESP_LOGD(TAG, "Published bus stats: total=%lu, failed=%lu, rate=%.2f%%", 
              (unsigned long)total_reads, (unsigned long)failed_reads,
              total_reads > 0 ? (double)failed_reads / total_reads * 100.0 : 0.0);
 
+    /* Publish offline buffer statistics */
+    mqtt_buffer_stats_t buffer;
+    mqtt_ha_get_buffer_stats(&buffer);
+
+    snprintf(topic, sizeof(topic), "%s/diagnostic/buffer_depth", CONFIG_MQTT_BASE_TOPIC);
+    snprintf(value_buf, sizeof(value_buf), "%lu", (unsigned long)buffer.depth);
+    mqtt_publish(topic, value_buf, 0, 1, 0);
+
+    snprintf(topic, sizeof(topic), "%s/diagnostic/buffer_dropped", CONFIG_MQTT_BASE_TOPIC);
+    snprintf(value_buf, sizeof(value_buf), "%lu", (unsigned long)buffer.dropped);
+    mqtt_publish(topic, value_buf, 0, 1, 0);
+
+    snprintf(topic, sizeof(topic), "%s/diagnostic/replay_rate", CONFIG_MQTT_BASE_TOPIC);
+    snprintf(value_buf, sizeof(value_buf), "%.1f", buffer.replay_rate);
+    mqtt_publish(topic, value_buf, 0, 1, 0);
+
     return ESP_OK;
 }
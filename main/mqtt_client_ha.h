@@ -8,6 +8,19 @@
 
 #include "esp_err.h"
 #include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief Offline (store-and-forward) buffer statistics
+ */
+typedef struct {
+    uint32_t depth;          /**< Readings waiting for replay */
+    uint32_t flash_depth;    /**< Readings spilled to flash (part of depth) */
+    uint32_t captured;       /**< Readings buffered since boot */
+    uint32_t dropped;        /**< Readings lost to buffer overflow since boot */
+    uint32_t replayed;       /**< Buffered readings republished since boot */
+    float replay_rate;       /**< Readings/s of the current or last replay */
+} mqtt_buffer_stats_t;
 
 /**
  * @brief Initialize MQTT client
@@ -29,6 +42,14 @@ esp_err_t mqtt_ha_stop(void);
  */
 bool mqtt_ha_is_connected(void);
 
+/**
+ * @brief Check if the broker has been reached at least once since boot
+ *
+ * Readings are only buffered for replay after this, so a node with no
+ * reachable (or no configured) broker does not fill the offline buffer.
+ */
+bool mqtt_ha_was_connected(void);
+
 /**
  * @brief Publish temperature reading
  * @param sensor_id Unique sensor ID (address string)
@@ -37,6 +58,38 @@ bool mqtt_ha_is_connected(void);
  */
 esp_err_t mqtt_ha_publish_temperature(const char *sensor_id, const char *friendly_name, float temperature);
 
+/**
+ * @brief Publish all valid readings as one CBOR batch on base_topic/telemetry
+ *
+ * No-op unless CONFIG_MQTT_TELEMETRY_CBOR is enabled. See telemetry_cbor.h
+ * for the schema.
+ */
+esp_err_t mqtt_ha_publish_telemetry(void);
+
+/**
+ * @brief Queue a reading for replay once the broker is reachable again
+ *
+ * Buffered readings are republished oldest-first at CONFIG_MQTT_REPLAY_RATE
+ * on base_topic/sensor/<id>/backfill with their original sample time.
+ *
+ * @param address 8-byte sensor ROM address
+ * @param temperature Temperature value in Celsius
+ * @param read_time_ms Uptime in milliseconds when the reading was taken
+ */
+esp_err_t mqtt_ha_buffer_temperature(const uint8_t *address, float temperature, int64_t read_time_ms);
+
+/**
+ * @brief Get offline buffer statistics
+ */
+void mqtt_ha_get_buffer_stats(mqtt_buffer_stats_t *stats);
+
+/**
+ * @brief Get publish counters since boot
+ * @param published Messages accepted by the client (queued or sent)
+ * @param failed Publishes rejected by the client
+ */
+void mqtt_ha_get_publish_stats(uint32_t *published, uint32_t *failed);
+
 /**
  * @brief Register sensor with Home Assistant discovery
  * @param sensor_id Unique sensor ID (address string)
@@ -55,6 +108,14 @@ esp_err_t mqtt_ha_publish_status(bool online);
  */
 esp_err_t mqtt_ha_publish_discovery_all(void);
 
+/**
+ * @brief Finish a rescan requested with the rescan command
+ *
+ * Called by the task that ran the bus search: refreshes discovery and
+ * publishes the command result with the new sensor count.
+ */
+void mqtt_ha_rescan_done(esp_err_t err);
+
 /**
  * @brief Register diagnostic entities with Home Assistant
  * (Ethernet status, WiFi status, IP address)
@@ -0,0 +1,149 @@
+/**
+ * @file mqtt_command.c
+ * @brief MQTT command topic parsing (host-testable)
+ */
+
+#include "mqtt_command.h"
+#include <string.h>
+#include <ctype.h>
+
+typedef enum {
+    ARG_NONE,       /* Payload ignored */
+    ARG_NUMBER,     /* Unsigned decimal */
+    ARG_ADDRESS,    /* Optional 16-digit hex sensor address */
+} arg_kind_t;
+
+static const struct {
+    mqtt_cmd_type_t type;
+    const char *name;
+    arg_kind_t arg;
+} s_commands[] = {
+    { MQTT_CMD_READ_INTERVAL,     "read_interval",     ARG_NUMBER },
+    { MQTT_CMD_PUBLISH_INTERVAL,  "publish_interval",  ARG_NUMBER },
+    { MQTT_CMD_RESOLUTION,        "resolution",        ARG_NUMBER },
+    { MQTT_CMD_RESCAN,            "rescan",            ARG_NONE },
+    { MQTT_CMD_RESET_ERROR_STATS, "reset_error_stats", ARG_ADDRESS },
+    { MQTT_CMD_READ_NOW,          "read_now",          ARG_NONE },
+};
+
+#define COMMAND_COUNT (sizeof(s_commands) / sizeof(s_commands[0]))
+
+/**
+ * @brief Strip leading/trailing whitespace from a payload slice
+ */
+static void trim(const char **data, size_t *len)
+{
+    while (*len > 0 && isspace((unsigned char)**data)) {
+        (*data)++;
+        (*len)--;
+    }
+    while (*len > 0 && isspace((unsigned char)(*data)[*len - 1])) {
+        (*len)--;
+    }
+}
+
+static int parse_uint(const char *data, size_t len, uint32_t *value)
+{
+    if (len == 0 || len > 10) {
+        return -1;
+    }
+    uint64_t v = 0;
+    for (size_t i = 0; i < len; i++) {
+        if (data[i] < '0' || data[i] > '9') {
+            return -1;
+        }
+        v = v * 10 + (uint64_t)(data[i] - '0');
+    }
+    if (v > UINT32_MAX) {
+        return -1;
+    }
+    *value = (uint32_t)v;
+    return 0;
+}
+
+mqtt_cmd_status_t mqtt_cmd_parse(const char *prefix, const char *topic, size_t topic_len,
+                                 const char *payload, size_t payload_len, mqtt_cmd_t *cmd)
+{
+    memset(cmd, 0, sizeof(*cmd));
+
+    size_t prefix_len = strlen(prefix);
+    if (topic_len <= prefix_len || strncmp(topic, prefix, prefix_len) != 0) {
+        return MQTT_CMD_ERR_NOT_COMMAND;
+    }
+    const char *name = topic + prefix_len;
+    size_t name_len = topic_len - prefix_len;
+
+    if (name_len == strlen("result") && strncmp(name, "result", name_len) == 0) {
+        return MQTT_CMD_ERR_NOT_COMMAND;
+    }
+
+    size_t i;
+    for (i = 0; i < COMMAND_COUNT; i++) {
+        if (strlen(s_commands[i].name) == name_len &&
+            strncmp(s_commands[i].name, name, name_len) == 0) {
+            break;
+        }
+    }
+    if (i == COMMAND_COUNT) {
+        return MQTT_CMD_ERR_UNKNOWN;
+    }
+    cmd->type = s_commands[i].type;
+
+    if (payload == NULL) {
+        payload_len = 0;
+    }
+    trim(&payload, &payload_len);
+
+    switch (s_commands[i].arg) {
+    case ARG_NONE:
+        break;
+
+    case ARG_NUMBER:
+        if (parse_uint(payload, payload_len, &cmd->value) != 0) {
+            return MQTT_CMD_ERR_INVALID_VALUE;
+        }
+        if (cmd->type == MQTT_CMD_RESOLUTION && (cmd->value < 9 || cmd->value > 12)) {
+            return MQTT_CMD_ERR_INVALID_VALUE;
+        }
+        break;
+
+    case ARG_ADDRESS:
+        if (payload_len == 0) {
+            break;  /* All sensors */
+        }
+        if (payload_len != sizeof(cmd->address) - 1) {
+            return MQTT_CMD_ERR_INVALID_VALUE;
+        }
+        for (size_t j = 0; j < payload_len; j++) {
+            if (!isxdigit((unsigned char)payload[j])) {
+                return MQTT_CMD_ERR_INVALID_VALUE;
+            }
+            cmd->address[j] = (char)toupper((unsigned char)payload[j]);
+        }
+        cmd->address[payload_len] = '\0';
+        break;
+    }
+
+    return MQTT_CMD_OK;
+}
+
+const char *mqtt_cmd_name(mqtt_cmd_type_t type)
+{
+    for (size_t i = 0; i < COMMAND_COUNT; i++) {
+        if (s_commands[i].type == type) {
+            return s_commands[i].name;
+        }
+    }
+    return "unknown";
+}
+
+const char *mqtt_cmd_status_str(mqtt_cmd_status_t status)
+{
+    switch (status) {
+    case MQTT_CMD_OK:                return "OK";
+    case MQTT_CMD_ERR_NOT_COMMAND:   return "Not a command topic";
+    case MQTT_CMD_ERR_UNKNOWN:       return "Unknown command";
+    case MQTT_CMD_ERR_INVALID_VALUE: return "Invalid value";
+    default:                         return "Unknown error";
+    }
+}
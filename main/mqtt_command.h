@@ -0,0 +1,80 @@
+/**
+ * @file mqtt_command.h
+ * @brief MQTT command topic parsing (host-testable)
+ *
+ * Commands are published to <base>/cmd/<name> with a plain-text argument:
+ *
+ *   read_interval       milliseconds
+ *   publish_interval    milliseconds
+ *   resolution          9-12 bits
+ *   rescan              (no argument)
+ *   reset_error_stats   optional sensor address, empty for all sensors
+ *   read_now            (no argument)
+ *
+ * Results are published by the caller on <base>/cmd/result, which is
+ * ignored by the parser so the node does not react to its own responses.
+ */
+
+#ifndef MQTT_COMMAND_H
+#define MQTT_COMMAND_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Command types
+ */
+typedef enum {
+    MQTT_CMD_NONE = 0,
+    MQTT_CMD_READ_INTERVAL,
+    MQTT_CMD_PUBLISH_INTERVAL,
+    MQTT_CMD_RESOLUTION,
+    MQTT_CMD_RESCAN,
+    MQTT_CMD_RESET_ERROR_STATS,
+    MQTT_CMD_READ_NOW,
+} mqtt_cmd_type_t;
+
+/**
+ * @brief Parse result
+ */
+typedef enum {
+    MQTT_CMD_OK = 0,
+    MQTT_CMD_ERR_NOT_COMMAND,    /**< Topic is outside the command tree (or is the result topic) */
+    MQTT_CMD_ERR_UNKNOWN,        /**< Unknown command name */
+    MQTT_CMD_ERR_INVALID_VALUE,  /**< Argument missing, malformed or out of range */
+} mqtt_cmd_status_t;
+
+/**
+ * @brief Parsed command
+ */
+typedef struct {
+    mqtt_cmd_type_t type;
+    uint32_t value;        /**< Numeric argument (intervals, resolution) */
+    char address[17];      /**< Sensor address for reset_error_stats, empty for all */
+} mqtt_cmd_t;
+
+/**
+ * @brief Parse a message received on the command tree
+ *
+ * @param prefix Command topic prefix including trailing slash ("<base>/cmd/")
+ * @param topic Received topic (not NUL-terminated)
+ * @param topic_len Topic length
+ * @param payload Received payload (not NUL-terminated, may be NULL if empty)
+ * @param payload_len Payload length
+ * @param cmd Output command (type is set whenever the name is recognized)
+ * @return MQTT_CMD_OK or an error code
+ */
+mqtt_cmd_status_t mqtt_cmd_parse(const char *prefix, const char *topic, size_t topic_len,
+                                 const char *payload, size_t payload_len, mqtt_cmd_t *cmd);
+
+/**
+ * @brief Command name as used in the topic ("unknown" for MQTT_CMD_NONE)
+ */
+const char *mqtt_cmd_name(mqtt_cmd_type_t type);
+
+/**
+ * @brief Human-readable parse error
+ */
+const char *mqtt_cmd_status_str(mqtt_cmd_status_t status);
+
+#endif /* MQTT_COMMAND_H */
@@ -314,3 +314,295 @@ esp_err_t nvs_storage_load_auth_config(bool *enabled, char *username, size_t use
     nvs_close(handle);
     return ESP_OK;
 }
+
+esp_err_t nvs_storage_save_ha_discovery_mode(uint8_t mode)
+{
+    nvs_handle_t handle;
+    esp_err_t err;
+
+    err = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to open NVS: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    nvs_set_u8(handle, "ha_disc_mode", mode);
+
+    err = nvs_commit(handle);
+    nvs_close(handle);
+    return err;
+}
+
+esp_err_t nvs_storage_load_ha_discovery_mode(uint8_t *mode)
+{
+    nvs_handle_t handle;
+    esp_err_t err;
+
+    err = nvs_open(NVS_NAMESPACE, NVS_READONLY, &handle);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    err = nvs_get_u8(handle, "ha_disc_mode", mode);
+    nvs_close(handle);
+    return err;
+}
+
+esp_err_t nvs_storage_save_ota_resume(const void *data, size_t len)
+{
+    nvs_handle_t handle;
+    esp_err_t err;
+
+    err = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to open NVS: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    err = nvs_set_blob(handle, "ota_resume", data, len);
+    if (err == ESP_OK) {
+        err = nvs_commit(handle);
+    }
+    nvs_close(handle);
+    return err;
+}
+
+esp_err_t nvs_storage_load_ota_resume(void *data, size_t len)
+{
+    nvs_handle_t handle;
+    esp_err_t err;
+
+    err = nvs_open(NVS_NAMESPACE, NVS_READONLY, &handle);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    size_t stored = 0;
+    err = nvs_get_blob(handle, "ota_resume", NULL, &stored);
+    if (err == ESP_OK && stored != len) {
+        err = ESP_ERR_NVS_INVALID_LENGTH;   /* Written by another firmware version */
+    }
+    if (err == ESP_OK) {
+        err = nvs_get_blob(handle, "ota_resume", data, &len);
+    }
+    nvs_close(handle);
+    return err;
+}
+
+esp_err_t nvs_storage_clear_ota_resume(void)
+{
+    nvs_handle_t handle;
+    esp_err_t err;
+
+    err = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    err = nvs_erase_key(handle, "ota_resume");
+    if (err == ESP_ERR_NVS_NOT_FOUND) {
+        err = ESP_OK;
+    }
+    if (err == ESP_OK) {
+        err = nvs_commit(handle);
+    }
+    nvs_close(handle);
+    return err;
+}
+
+esp_err_t nvs_storage_save_boot_metrics(const void *data, size_t len)
+{
+    nvs_handle_t handle;
+    esp_err_t err;
+
+    err = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to open NVS: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    err = nvs_set_blob(handle, "boot_metrics", data, len);
+    if (err == ESP_OK) {
+        err = nvs_commit(handle);
+    }
+    nvs_close(handle);
+    return err;
+}
+
+esp_err_t nvs_storage_load_boot_metrics(void *data, size_t len)
+{
+    nvs_handle_t handle;
+    esp_err_t err;
+
+    err = nvs_open(NVS_NAMESPACE, NVS_READONLY, &handle);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    size_t stored = 0;
+    err = nvs_get_blob(handle, "boot_metrics", NULL, &stored);
+    if (err == ESP_OK && stored != len) {
+        err = ESP_ERR_NVS_INVALID_LENGTH;
+    }
+    if (err == ESP_OK) {
+        err = nvs_get_blob(handle, "boot_metrics", data, &len);
+    }
+    nvs_close(handle);
+    return err;
+}
+
+esp_err_t nvs_storage_save_ota_source(const char *url)
+{
+    nvs_handle_t handle;
+    esp_err_t err;
+
+    err = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to open NVS: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    err = nvs_set_str(handle, "ota_source", url);
+    if (err == ESP_OK) {
+        err = nvs_commit(handle);
+    }
+    nvs_close(handle);
+
+    ESP_LOGD(TAG, "Saved OTA source: %s", url[0] ? url : "(GitHub)");
+    return err;
+}
+
+esp_err_t nvs_storage_load_ota_source(char *url, size_t max_len)
+{
+    nvs_handle_t handle;
+    esp_err_t err;
+
+    err = nvs_open(NVS_NAMESPACE, NVS_READONLY, &handle);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    size_t required_size = max_len;
+    err = nvs_get_str(handle, "ota_source", url, &required_size);
+    nvs_close(handle);
+
+    return err;
+}
+
+/* ===== Offline reading spill (dedicated "storage" partition) ===== */
+
+static const char *SPILL_PARTITION = "storage";
+static const char *SPILL_NAMESPACE = "mqtt_spill";
+
+esp_err_t nvs_storage_spill_init(void)
+{
+    esp_err_t err = nvs_flash_init_partition(SPILL_PARTITION);
+    if (err == ESP_ERR_NVS_NO_FREE_PAGES || err == ESP_ERR_NVS_NEW_VERSION_FOUND) {
+        ESP_LOGW(TAG, "Spill partition unusable, erasing");
+        nvs_flash_erase_partition(SPILL_PARTITION);
+        err = nvs_flash_init_partition(SPILL_PARTITION);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to init spill partition: %s", esp_err_to_name(err));
+    }
+    return err;
+}
+
+static esp_err_t spill_open(nvs_open_mode_t mode, nvs_handle_t *handle)
+{
+    return nvs_open_from_partition(SPILL_PARTITION, SPILL_NAMESPACE, mode, handle);
+}
+
+static void spill_key(uint32_t seq, char *key, size_t key_len)
+{
+    snprintf(key, key_len, "seg_%lu", (unsigned long)seq);
+}
+
+esp_err_t nvs_storage_spill_load_range(uint32_t *head, uint32_t *tail)
+{
+    nvs_handle_t handle;
+    esp_err_t err = spill_open(NVS_READONLY, &handle);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    err = nvs_get_u32(handle, "head", head);
+    if (err == ESP_OK) {
+        err = nvs_get_u32(handle, "tail", tail);
+    }
+
+    nvs_close(handle);
+    return err;
+}
+
+esp_err_t nvs_storage_spill_save_range(uint32_t head, uint32_t tail)
+{
+    nvs_handle_t handle;
+    esp_err_t err = spill_open(NVS_READWRITE, &handle);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    nvs_set_u32(handle, "head", head);
+    nvs_set_u32(handle, "tail", tail);
+    err = nvs_commit(handle);
+
+    nvs_close(handle);
+    return err;
+}
+
+esp_err_t nvs_storage_spill_write(uint32_t seq, const void *data, size_t len)
+{
+    nvs_handle_t handle;
+    char key[16];
+    esp_err_t err = spill_open(NVS_READWRITE, &handle);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    spill_key(seq, key, sizeof(key));
+    err = nvs_set_blob(handle, key, data, len);
+    if (err == ESP_OK) {
+        err = nvs_commit(handle);
+    } else {
+        ESP_LOGW(TAG, "Failed to spill segment %lu: %s", (unsigned long)seq, esp_err_to_name(err));
+    }
+
+    nvs_close(handle);
+    return err;
+}
+
+esp_err_t nvs_storage_spill_read(uint32_t seq, void *data, size_t *len)
+{
+    nvs_handle_t handle;
+    char key[16];
+    esp_err_t err = spill_open(NVS_READONLY, &handle);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    spill_key(seq, key, sizeof(key));
+    err = nvs_get_blob(handle, key, data, len);
+
+    nvs_close(handle);
+    return err;
+}
+
+esp_err_t nvs_storage_spill_erase(uint32_t seq)
+{
+    nvs_handle_t handle;
+    char key[16];
+    esp_err_t err = spill_open(NVS_READWRITE, &handle);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    spill_key(seq, key, sizeof(key));
+    err = nvs_erase_key(handle, key);
+    if (err == ESP_OK) {
+        err = nvs_commit(handle);
+    }
+
+    nvs_close(handle);
+    return err;
+}
@@ -9,6 +9,7 @@
 #include "esp_err.h"
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
 
 #define MAX_FRIENDLY_NAME_LEN 32
 #define SENSOR_ADDRESS_LEN 8
@@ -109,4 +110,97 @@ esp_err_t nvs_storage_load_auth_config(bool *enabled, char *username, size_t use
                                         char *password, size_t password_len,
                                         char *api_key, size_t api_key_len);
 
+/**
+ * @brief Save the Home Assistant discovery format last published
+ * @param mode Format identifier (owned by the MQTT client)
+ */
+esp_err_t nvs_storage_save_ha_discovery_mode(uint8_t mode);
+
+/**
+ * @brief Load the Home Assistant discovery format last published
+ * @param mode Output: format identifier, untouched if not stored
+ * @return ESP_OK if found, ESP_ERR_NVS_NOT_FOUND if never saved
+ */
+esp_err_t nvs_storage_load_ha_discovery_mode(uint8_t *mode);
+
+/**
+ * @brief Save the checkpoint of an interrupted OTA download
+ * @param data Checkpoint (layout owned by the OTA updater)
+ */
+esp_err_t nvs_storage_save_ota_resume(const void *data, size_t len);
+
+/**
+ * @brief Load the OTA download checkpoint
+ * @return ESP_OK if found, ESP_ERR_NVS_NOT_FOUND if none, ESP_ERR_NVS_INVALID_LENGTH if len differs
+ */
+esp_err_t nvs_storage_load_ota_resume(void *data, size_t len);
+
+/**
+ * @brief Forget the OTA download checkpoint
+ */
+esp_err_t nvs_storage_clear_ota_resume(void);
+
+/**
+ * @brief Save the OTA update source
+ * @param url Mirror manifest URL, "" for GitHub releases
+ */
+esp_err_t nvs_storage_save_ota_source(const char *url);
+
+/**
+ * @brief Load the OTA update source
+ * @return ESP_OK if found, ESP_ERR_NVS_NOT_FOUND if never saved
+ */
+esp_err_t nvs_storage_load_ota_source(char *url, size_t max_len);
+
+/**
+ * @brief Save the per-version boot metrics
+ * @param data Metrics table (layout owned by the boot monitor)
+ */
+esp_err_t nvs_storage_save_boot_metrics(const void *data, size_t len);
+
+/**
+ * @brief Load the per-version boot metrics
+ * @return ESP_OK if found, ESP_ERR_NVS_NOT_FOUND if none, ESP_ERR_NVS_INVALID_LENGTH if len differs
+ */
+esp_err_t nvs_storage_load_boot_metrics(void *data, size_t len);
+
+/**
+ * @brief Initialize the "storage" partition used for offline reading spill
+ *
+ * The partition is erased and re-initialized if its layout is unusable.
+ */
+esp_err_t nvs_storage_spill_init(void);
+
+/**
+ * @brief Load the persisted spill segment range [head, tail)
+ * @return ESP_OK if found, ESP_ERR_NVS_NOT_FOUND if nothing was spilled yet
+ */
+esp_err_t nvs_storage_spill_load_range(uint32_t *head, uint32_t *tail);
+
+/**
+ * @brief Persist the spill segment range [head, tail)
+ */
+esp_err_t nvs_storage_spill_save_range(uint32_t head, uint32_t tail);
+
+/**
+ * @brief Write one spill segment
+ * @param seq Segment sequence number
+ * @param data Segment contents
+ * @param len Segment size in bytes
+ */
+esp_err_t nvs_storage_spill_write(uint32_t seq, const void *data, size_t len);
+
+/**
+ * @brief Read one spill segment
+ * @param seq Segment sequence number
+ * @param data Output buffer
+ * @param len In: buffer size, out: segment size in bytes
+ */
+esp_err_t nvs_storage_spill_read(uint32_t seq, void *data, size_t *len);
+
+/**
+ * @brief Erase one spill segment
+ */
+esp_err_t nvs_storage_spill_erase(uint32_t seq);
+
 #endif /* NVS_STORAGE_H */
@@ -0,0 +1,118 @@
+/**
+ * @file ota_manifest.c
+ * @brief Update manifest of a local mirror, image digests and URL resolution (host-testable)
+ */
+
+#include "ota_manifest.h"
+#include <stdio.h>
+#include <string.h>
+
+/* A cut-short value is useless: treat it as missing */
+static void copy_value(char *dst, size_t size, const json_scan_t *s, const char *value, size_t len)
+{
+    if (s->truncated || len >= size) {
+        dst[0] = '\0';
+        return;
+    }
+    memcpy(dst, value, len + 1);
+}
+
+static const char *basename_of(const char *url)
+{
+    const char *slash = strrchr(url, '/');
+    return slash ? slash + 1 : url;
+}
+
+static void manifest_on_string(void *ctx, const json_scan_t *s, const char *value, size_t len)
+{
+    ota_manifest_t *m = ctx;
+    if (s->depth == 1 && strcmp(s->key, "version") == 0) {
+        copy_value(m->version, sizeof(m->version), s, value, len);
+    } else if (s->depth == 1 && strcmp(s->key, "image") == 0) {
+        copy_value(m->image, sizeof(m->image), s, value, len);
+    } else if (s->depth == 1 && strcmp(s->key, "sha256") == 0) {
+        copy_value(m->sha256_hex, sizeof(m->sha256_hex), s, value, len);
+    } else if (s->depth == 2 && strcmp(s->root_key, "deltas") == 0 && !s->truncated &&
+               strcmp(basename_of(value), m->delta_asset) == 0) {
+        copy_value(m->delta, sizeof(m->delta), s, value, len);
+    }
+}
+
+void ota_manifest_init(ota_manifest_t *m, const char *delta_asset)
+{
+    memset(m, 0, sizeof(*m));
+    json_scan_init(&m->scan, manifest_on_string, NULL, m);
+    snprintf(m->delta_asset, sizeof(m->delta_asset), "%s", delta_asset);
+}
+
+int ota_manifest_feed(ota_manifest_t *m, const char *data, size_t len)
+{
+    return json_scan_feed(&m->scan, data, len);
+}
+
+int ota_manifest_finish(ota_manifest_t *m)
+{
+    if (json_scan_finish(&m->scan) != JSON_SCAN_OK) {
+        return OTA_MANIFEST_ERR_JSON;
+    }
+    if (m->version[0] == '\0' || m->image[0] == '\0' || !ota_sha256_parse(m->sha256_hex, m->sha256)) {
+        return OTA_MANIFEST_ERR_FIELD;
+    }
+    return OTA_MANIFEST_OK;
+}
+
+static int hex_value(char c)
+{
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+bool ota_sha256_parse(const char *text, uint8_t digest[SHA256_DIGEST_SIZE])
+{
+    if (strncmp(text, "sha256:", 7) == 0) {
+        text += 7;
+    }
+    if (strlen(text) != SHA256_DIGEST_SIZE * 2) {
+        return false;
+    }
+    for (int i = 0; i < SHA256_DIGEST_SIZE; i++) {
+        int hi = hex_value(text[2 * i]);
+        int lo = hex_value(text[2 * i + 1]);
+        if (hi < 0 || lo < 0) {
+            return false;
+        }
+        digest[i] = (uint8_t)(hi << 4 | lo);
+    }
+    return true;
+}
+
+bool ota_url_resolve(const char *base, const char *ref, char *out, size_t size)
+{
+    if (strstr(ref, "://") != NULL) {
+        return (size_t)snprintf(out, size, "%s", ref) < size;
+    }
+    const char *scheme = strstr(base, "://");
+    if (scheme == NULL) {
+        return false;
+    }
+    const char *path = strchr(scheme + 3, '/');
+    size_t keep;
+    if (ref[0] == '/' || path == NULL) {
+        /* Relative to the host */
+        keep = path ? (size_t)(path - base) : strlen(base);
+        if (ref[0] != '/') {
+            return (size_t)snprintf(out, size, "%.*s/%s", (int)keep, base, ref) < size;
+        }
+    } else {
+        keep = (size_t)(strrchr(path, '/') - base) + 1;
+    }
+    return (size_t)snprintf(out, size, "%.*s%s", (int)keep, base, ref) < size;
+}
@@ -0,0 +1,79 @@
+/**
+ * @file ota_manifest.h
+ * @brief Update manifest of a local mirror, image digests and URL resolution (host-testable)
+ *
+ * A mirror is any plain HTTP server holding the release files next to a
+ * manifest.json (scripts/ota_mirror.py builds and serves one):
+ *
+ *   {"version": "2.8.0",
+ *    "image": "thermux.bin.gz",
+ *    "sha256": "<hex digest of thermux.bin>",
+ *    "deltas": ["thermux-from-2.7.0.delta"]}
+ *
+ * "image" and "deltas" entries are URLs relative to the manifest (or
+ * absolute). "sha256" is always the digest of the uncompressed image, the
+ * bytes that end up in the update partition, so it also verifies an image
+ * fetched from a peer.
+ */
+
+#ifndef OTA_MANIFEST_H
+#define OTA_MANIFEST_H
+
+#include "json_scan.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef SHA256_DIGEST_SIZE
+#define SHA256_DIGEST_SIZE 32
+#endif
+
+typedef enum {
+    OTA_MANIFEST_OK = 0,
+    OTA_MANIFEST_ERR_JSON = -1,     /**< Not a complete JSON document */
+    OTA_MANIFEST_ERR_FIELD = -2,    /**< version, image or sha256 missing or invalid */
+} ota_manifest_result_t;
+
+typedef struct {
+    json_scan_t scan;
+    char delta_asset[64];                   /**< Patch name for the running version */
+    char version[32];
+    char image[JSON_SCAN_VALUE_MAX];
+    char delta[JSON_SCAN_VALUE_MAX];        /**< Patch from the running version, "" if none */
+    char sha256_hex[72];                    /**< As given; parsed by ota_manifest_finish() */
+    uint8_t sha256[SHA256_DIGEST_SIZE];
+} ota_manifest_t;
+
+/**
+ * @param delta_asset File name of a patch from the running version
+ */
+void ota_manifest_init(ota_manifest_t *m, const char *delta_asset);
+
+/**
+ * @brief Scan the next piece of the manifest
+ * @return JSON_SCAN_OK or a negative json_scan_result_t
+ */
+int ota_manifest_feed(ota_manifest_t *m, const char *data, size_t len);
+
+/**
+ * @brief Check the manifest is complete and parse its digest into m->sha256
+ */
+int ota_manifest_finish(ota_manifest_t *m);
+
+/**
+ * @brief Parse a SHA-256 digest: 64 hex digits, optionally prefixed "sha256:" (as GitHub gives it)
+ */
+bool ota_sha256_parse(const char *text, uint8_t digest[SHA256_DIGEST_SIZE]);
+
+/**
+ * @brief Resolve a reference against the URL of the document it appeared in
+ *
+ * Absolute URLs are taken as they are, "/path" replaces the path and
+ * anything else replaces the last path segment. Queries and fragments of
+ * the base are not handled.
+ *
+ * @return false if base is not an absolute URL or the result does not fit
+ */
+bool ota_url_resolve(const char *base, const char *ref, char *out, size_t size);
+
+#endif /* OTA_MANIFEST_H */
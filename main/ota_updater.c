@@ -3,19 +3,40 @@
  * @brief OTA firmware updates from GitHub Releases
  * 
  * This module checks GitHub releases for new firmware versions and
- * downloads/installs updates using ESP-IDF's HTTPS OTA functionality.
+ * downloads updates straight into the update partition through ota_writer.
+ * When the release carries a gzip-compressed image (thermux.bin.gz) that
+ * is downloaded instead and inflated on the fly into the update partition.
+ * A delta patch made from the running version (thermux-from-<version>.delta)
+ * is preferred over both, falling back to the full image if it fails.
+ * A full image download that fails part way resumes where it stopped,
+ * across retries and reboots.
+ *
+ * Instead of GitHub the updater can use a local mirror (see ota_manifest.h),
+ * and with the peer cache enabled it first tries nodes already running the
+ * new version, found through their _thermux._tcp mDNS records. Whenever the
+ * image digest is known (the mirror manifest, GitHub's asset digest) the
+ * written image must match it before it is made bootable.
  */
 
 #include "ota_updater.h"
 #include "version_utils.h"
+#include "ota_writer.h"
+#include "gunzip.h"
+#include "delta_patch.h"
+#include "mbedtls/sha256.h"
+#include "nvs_storage.h"
 #include "esp_log.h"
 #include "esp_http_client.h"
-#include "esp_https_ota.h"
 #include "esp_ota_ops.h"
 #include "esp_crt_bundle.h"
-#include "cJSON.h"
+#include "json_scan.h"
+#include "ota_manifest.h"
+#include "esp_heap_caps.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#if CONFIG_OTA_PEER_CACHE
+#include "mdns.h"
+#endif
 #include <string.h>
 #include <stdlib.h>
 
@@ -26,10 +47,22 @@ extern const char *APP_VERSION;
 
 /* GitHub API URL for releases */
 #define GITHUB_API_URL "https://api.github.com/repos/%s/%s/releases/latest"
-#define GITHUB_API_BUFFER_SIZE 4096
 
 static char s_latest_version[32] = {0};
 static char s_download_url[512] = {0};
+static bool s_download_compressed = false;  /* s_download_url is a .bin.gz */
+static char s_delta_url[512] = {0};         /* Patch from the running version, if published */
+static uint8_t s_image_sha256[SHA256_DIGEST_SIZE];  /* Of the uncompressed image */
+static bool s_image_sha256_known = false;
+
+/* Manifest URL of a local mirror, "" = GitHub */
+static char s_source_url[OTA_SOURCE_URL_MAX] = {0};
+
+/* Release asset whose digest is that of the image itself */
+#define IMAGE_ASSET "thermux.bin"
+
+/* Release asset holding a patch from version %s to the release */
+#define DELTA_ASSET_FMT "thermux-from-%s.delta"
 static bool s_update_available = false;
 
 /* Async check state */
@@ -55,99 +88,215 @@ static volatile ota_update_state_t s_update_state = OTA_UPDATE_IDLE;
 static volatile int s_download_progress = 0;  /* 0-100 */
 static volatile int s_download_total = 0;
 static volatile int s_download_received = 0;
+static volatile int s_download_resumed = 0;   /* Skipped thanks to a checkpoint */
+static volatile int s_download_fetched = 0;   /* Actually transferred, all attempts */
 
 /**
- * @brief HTTP event handler for GitHub API request
- * 
- * Note: GitHub API uses chunked transfer encoding, so we must handle
- * both chunked and non-chunked responses.
+ * @brief Fields picked out of the release response as it streams in
+ *
+ * Asset members can come in any order, so each asset's name and URL are
+ * held until its object closes.
  */
-static esp_err_t http_event_handler(esp_http_client_event_t *evt)
+typedef struct {
+    json_scan_t scan;
+    char tag_name[32];
+    char delta_asset[64];       /* Patch name for the running version */
+    char asset_name[64];
+    char asset_url[JSON_SCAN_VALUE_MAX];
+    char asset_digest[72];      /* "sha256:<hex>" */
+    char image_url[JSON_SCAN_VALUE_MAX];
+    bool image_compressed;
+    char delta_url[JSON_SCAN_VALUE_MAX];
+    uint8_t image_sha256[SHA256_DIGEST_SIZE];
+    bool image_sha256_known;
+} release_scan_t;
+
+static bool ends_with(const char *s, const char *suffix)
 {
-    static char *output_buffer = NULL;
-    static int output_len = 0;
-    
-    switch (evt->event_id) {
-    case HTTP_EVENT_ON_DATA:
-        /* Handle both chunked and non-chunked responses */
-        if (output_buffer == NULL) {
-            output_buffer = (char *)malloc(GITHUB_API_BUFFER_SIZE);
-            output_len = 0;
-            if (output_buffer == NULL) {
-                ESP_LOGE(TAG, "Failed to allocate memory for output buffer");
-                return ESP_FAIL;
-            }
+    size_t len = strlen(s);
+    size_t suffix_len = strlen(suffix);
+    return len >= suffix_len && strcmp(s + len - suffix_len, suffix) == 0;
+}
+
+static void copy_field(char *dst, size_t size, const json_scan_t *s, const char *value, size_t len)
+{
+    /* A cut-short name or URL is useless: treat it as missing */
+    if (s->truncated || len >= size) {
+        dst[0] = '\0';
+        return;
+    }
+    memcpy(dst, value, len + 1);
+}
+
+static void release_on_string(void *ctx, const json_scan_t *s, const char *value, size_t len)
+{
+    release_scan_t *rel = ctx;
+    if (s->depth == 1 && strcmp(s->key, "tag_name") == 0) {
+        copy_field(rel->tag_name, sizeof(rel->tag_name), s, value, len);
+    } else if (s->depth == 3 && strcmp(s->root_key, "assets") == 0) {
+        if (strcmp(s->key, "name") == 0) {
+            copy_field(rel->asset_name, sizeof(rel->asset_name), s, value, len);
+        } else if (strcmp(s->key, "browser_download_url") == 0) {
+            copy_field(rel->asset_url, sizeof(rel->asset_url), s, value, len);
+        } else if (strcmp(s->key, "digest") == 0) {
+            copy_field(rel->asset_digest, sizeof(rel->asset_digest), s, value, len);
         }
-        /* Append data if there's room */
-        if (output_len + evt->data_len < GITHUB_API_BUFFER_SIZE) {
-            memcpy(output_buffer + output_len, evt->data, evt->data_len);
-            output_len += evt->data_len;
-        } else {
-            ESP_LOGW(TAG, "Response buffer full, truncating");
+    }
+}
+
+/**
+ * @brief End of an asset: keep its URL if it is an image, preferring the compressed one
+ */
+static void release_on_close(void *ctx, const json_scan_t *s)
+{
+    release_scan_t *rel = ctx;
+    if (s->depth != 3 || strcmp(s->root_key, "assets") != 0) {
+        return;
+    }
+    if (rel->asset_name[0] != '\0' && rel->asset_url[0] != '\0') {
+        bool gz = ends_with(rel->asset_name, ".bin.gz");
+        if (gz || (!rel->image_compressed && rel->image_url[0] == '\0' &&
+                   ends_with(rel->asset_name, ".bin"))) {
+            strcpy(rel->image_url, rel->asset_url);
+            rel->image_compressed = gz;
         }
-        break;
-        
-    case HTTP_EVENT_ON_FINISH:
-        if (output_buffer != NULL) {
-            output_buffer[output_len] = '\0';
-            /* Store the buffer pointer in user_data for later use */
-            if (evt->user_data) {
-                *((char **)evt->user_data) = output_buffer;
-            }
-            output_buffer = NULL;
-            output_len = 0;
+#ifdef CONFIG_OTA_DELTA_UPDATES
+        if (strcmp(rel->asset_name, rel->delta_asset) == 0) {
+            strcpy(rel->delta_url, rel->asset_url);
         }
-        break;
-        
-    case HTTP_EVENT_DISCONNECTED:
-    case HTTP_EVENT_ERROR:
-        /* Clean up on disconnect or error to prevent memory leaks */
-        if (output_buffer != NULL) {
-            free(output_buffer);
-            output_buffer = NULL;
-            output_len = 0;
-        }
-        break;
-        
-    default:
-        break;
+#endif
+    }
+    /* Releases uploaded before GitHub recorded digests have none */
+    if (strcmp(rel->asset_name, IMAGE_ASSET) == 0) {
+        rel->image_sha256_known = ota_sha256_parse(rel->asset_digest, rel->image_sha256);
+    }
+    rel->asset_name[0] = '\0';
+    rel->asset_url[0] = '\0';
+    rel->asset_digest[0] = '\0';
+}
+
+/**
+ * @brief HTTP event handler for GitHub API request
+ * 
+ * Note: GitHub API uses chunked transfer encoding, so the body arrives in
+ * pieces of any size; each goes straight to the scanner.
+ */
+static esp_err_t http_event_handler(esp_http_client_event_t *evt)
+{
+    if (evt->event_id == HTTP_EVENT_ON_DATA && evt->user_data != NULL) {
+        release_scan_t *rel = evt->user_data;
+        json_scan_feed(&rel->scan, evt->data, evt->data_len);
     }
     return ESP_OK;
 }
 
 esp_err_t ota_updater_init(void)
 {
+    if (nvs_storage_load_ota_source(s_source_url, sizeof(s_source_url)) != ESP_OK) {
+        snprintf(s_source_url, sizeof(s_source_url), "%s", CONFIG_OTA_SOURCE_URL);
+    }
+    
     ESP_LOGD(TAG, "OTA updater initialized");
     ESP_LOGD(TAG, "Current version: %s", APP_VERSION);
-    ESP_LOGD(TAG, "GitHub repo: %s/%s", CONFIG_GITHUB_OWNER, CONFIG_GITHUB_REPO);
+    if (s_source_url[0] != '\0') {
+        ESP_LOGI(TAG, "Update source: %s", s_source_url);
+    } else {
+        ESP_LOGD(TAG, "GitHub repo: %s/%s", CONFIG_GITHUB_OWNER, CONFIG_GITHUB_REPO);
+    }
     
     s_update_available = false;
     s_latest_version[0] = '\0';
     s_download_url[0] = '\0';
+    s_download_compressed = false;
+    s_delta_url[0] = '\0';
+    s_image_sha256_known = false;
     
     return ESP_OK;
 }
 
+esp_err_t ota_set_source_url(const char *url)
+{
+    if (url[0] != '\0' && strncmp(url, "http://", 7) != 0 && strncmp(url, "https://", 8) != 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (strlen(url) >= sizeof(s_source_url)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    esp_err_t err = nvs_storage_save_ota_source(url);
+    if (err != ESP_OK) {
+        return err;
+    }
+    snprintf(s_source_url, sizeof(s_source_url), "%s", url);
+    /* Whatever the old source offered is no longer what would be installed */
+    s_update_available = false;
+    ESP_LOGI(TAG, "Update source: %s", url[0] ? url : "GitHub releases");
+    return ESP_OK;
+}
+
+void ota_get_source_url(char *url, size_t max_len)
+{
+    snprintf(url, max_len, "%s", s_source_url);
+}
+
 /* Retry configuration */
 #define OTA_CHECK_MAX_RETRIES   3
 #define OTA_CHECK_RETRY_DELAY_MS 2000
 
 /**
- * @brief Internal function to perform single OTA check attempt
+ * @brief Record the latest release and, if it is newer, what to install
+ * @param sha256 Digest of the uncompressed image, NULL if unknown
  */
-static esp_err_t ota_check_for_update_internal(void)
+static void offer_update(const char *version, const char *image_url, bool compressed,
+                         const char *delta_url, const uint8_t *sha256)
+{
+    strncpy(s_latest_version, version, sizeof(s_latest_version) - 1);
+    s_latest_version[sizeof(s_latest_version) - 1] = '\0';  /* Ensure null termination */
+    ESP_LOGD(TAG, "Latest version: %s", s_latest_version);
+    
+    if (version_compare(s_latest_version, APP_VERSION) <= 0) {
+        ESP_LOGD(TAG, "Already up to date");
+        return;
+    }
+    s_update_available = true;
+    ESP_LOGI(TAG, "Update available: %s -> %s", APP_VERSION, s_latest_version);
+    
+    strncpy(s_download_url, image_url, sizeof(s_download_url) - 1);
+    s_download_url[sizeof(s_download_url) - 1] = '\0';
+    s_download_compressed = compressed;
+    strncpy(s_delta_url, delta_url, sizeof(s_delta_url) - 1);
+    s_delta_url[sizeof(s_delta_url) - 1] = '\0';
+    s_image_sha256_known = (sha256 != NULL);
+    if (sha256 != NULL) {
+        memcpy(s_image_sha256, sha256, SHA256_DIGEST_SIZE);
+    }
+    ESP_LOGD(TAG, "Firmware URL: %s", s_download_url);
+    if (s_delta_url[0] != '\0') {
+        ESP_LOGD(TAG, "Delta URL: %s", s_delta_url);
+    }
+}
+
+/**
+ * @brief Internal function to perform single OTA check attempt against GitHub
+ */
+static esp_err_t ota_check_github_internal(void)
 {
     /* Build GitHub API URL */
     char url[256];
     snprintf(url, sizeof(url), GITHUB_API_URL, CONFIG_GITHUB_OWNER, CONFIG_GITHUB_REPO);
     ESP_LOGD(TAG, "API URL: %s", url);
     
-    char *response_buffer = NULL;
+    release_scan_t *rel = calloc(1, sizeof(release_scan_t));
+    if (rel == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate release scanner");
+        return ESP_ERR_NO_MEM;
+    }
+    json_scan_init(&rel->scan, release_on_string, release_on_close, rel);
+    snprintf(rel->delta_asset, sizeof(rel->delta_asset), DELTA_ASSET_FMT, APP_VERSION);
     
     esp_http_client_config_t config = {
         .url = url,
         .event_handler = http_event_handler,
-        .user_data = &response_buffer,
+        .user_data = rel,
         .timeout_ms = 10000,
         .crt_bundle_attach = esp_crt_bundle_attach,
     };
@@ -156,6 +305,7 @@ static esp_err_t ota_check_for_update_internal(void)
     esp_http_client_handle_t client = esp_http_client_init(&config);
     if (client == NULL) {
         ESP_LOGE(TAG, "Failed to initialize HTTP client");
+        free(rel);
         return ESP_FAIL;
     }
     
@@ -170,52 +320,13 @@ static esp_err_t ota_check_for_update_internal(void)
         int content_len = esp_http_client_get_content_length(client);
         ESP_LOGD(TAG, "HTTP response: status=%d, content_length=%d", status, content_len);
         
-        if (status == 200 && response_buffer != NULL) {
-            /* Parse JSON response */
-            cJSON *root = cJSON_Parse(response_buffer);
-            if (root != NULL) {
-                cJSON *tag_name = cJSON_GetObjectItem(root, "tag_name");
-                cJSON *assets = cJSON_GetObjectItem(root, "assets");
-                
-                if (cJSON_IsString(tag_name)) {
-                    strncpy(s_latest_version, tag_name->valuestring, sizeof(s_latest_version) - 1);
-                    s_latest_version[sizeof(s_latest_version) - 1] = '\0';  /* Ensure null termination */
-                    ESP_LOGD(TAG, "Latest version: %s", s_latest_version);
-                    
-                    /* Compare versions */
-                    if (version_compare(s_latest_version, APP_VERSION) > 0) {
-                        s_update_available = true;
-                        ESP_LOGI(TAG, "Update available: %s -> %s", APP_VERSION, s_latest_version);
-                        
-                        /* Find firmware binary in assets */
-                        if (cJSON_IsArray(assets)) {
-                            int asset_count = cJSON_GetArraySize(assets);
-                            for (int i = 0; i < asset_count; i++) {
-                                cJSON *asset = cJSON_GetArrayItem(assets, i);
-                                cJSON *name = cJSON_GetObjectItem(asset, "name");
-                                cJSON *browser_url = cJSON_GetObjectItem(asset, "browser_download_url");
-                                
-                                if (cJSON_IsString(name) && cJSON_IsString(browser_url)) {
-                                    /* Look for .bin file */
-                                    if (strstr(name->valuestring, ".bin") != NULL) {
-                                        strncpy(s_download_url, browser_url->valuestring, 
-                                               sizeof(s_download_url) - 1);
-                                        ESP_LOGD(TAG, "Firmware URL: %s", s_download_url);
-                                        break;
-                                    }
-                                }
-                            }
-                        }
-                    } else {
-                        ESP_LOGD(TAG, "Already up to date");
-                    }
-                }
-                cJSON_Delete(root);
-            } else {
-                ESP_LOGE(TAG, "Failed to parse JSON response");
-            }
-        } else if (status == 200 && response_buffer == NULL) {
-            ESP_LOGE(TAG, "HTTP 200 but no response data received");
+        int scan_result = json_scan_finish(&rel->scan);
+        if (status == 200 && scan_result == JSON_SCAN_OK && rel->tag_name[0] != '\0') {
+            /* The digest is that of thermux.bin, so it also checks an inflated thermux.bin.gz */
+            offer_update(rel->tag_name, rel->image_url, rel->image_compressed, rel->delta_url,
+                         rel->image_sha256_known ? rel->image_sha256 : NULL);
+        } else if (status == 200) {
+            ESP_LOGE(TAG, "Failed to parse JSON response (%d)", scan_result);
             err = ESP_FAIL;
         } else {
             ESP_LOGE(TAG, "GitHub API returned status %d", status);
@@ -225,14 +336,98 @@ static esp_err_t ota_check_for_update_internal(void)
         ESP_LOGE(TAG, "HTTP request failed: %s", esp_err_to_name(err));
     }
     
-    if (response_buffer) {
-        free(response_buffer);
+    free(rel);
+    esp_http_client_cleanup(client);
+    return err;
+}
+
+typedef struct {
+    ota_manifest_t manifest;
+    char image_url[512];
+    char delta_url[512];
+} mirror_check_t;
+
+static esp_err_t mirror_event_handler(esp_http_client_event_t *evt)
+{
+    if (evt->event_id == HTTP_EVENT_ON_DATA && evt->user_data != NULL) {
+        mirror_check_t *check = evt->user_data;
+        ota_manifest_feed(&check->manifest, evt->data, evt->data_len);
     }
+    return ESP_OK;
+}
+
+/**
+ * @brief Internal function to perform single OTA check attempt against a mirror manifest
+ */
+static esp_err_t ota_check_mirror_internal(const char *url)
+{
+    mirror_check_t *check = calloc(1, sizeof(mirror_check_t));
+    if (check == NULL) {
+        ESP_LOGE(TAG, "Failed to allocate manifest scanner");
+        return ESP_ERR_NO_MEM;
+    }
+    char delta_asset[64];
+    snprintf(delta_asset, sizeof(delta_asset), DELTA_ASSET_FMT, APP_VERSION);
+    ota_manifest_init(&check->manifest, delta_asset);
     
+    esp_http_client_config_t config = {
+        .url = url,
+        .event_handler = mirror_event_handler,
+        .user_data = check,
+        .timeout_ms = 10000,
+        .crt_bundle_attach = esp_crt_bundle_attach,
+    };
+    esp_http_client_handle_t client = esp_http_client_init(&config);
+    if (client == NULL) {
+        ESP_LOGE(TAG, "Failed to initialize HTTP client");
+        free(check);
+        return ESP_FAIL;
+    }
+    
+    ESP_LOGD(TAG, "Fetching manifest %s", url);
+    esp_err_t err = esp_http_client_perform(client);
+    if (err == ESP_OK) {
+        int status = esp_http_client_get_status_code(client);
+        int result = ota_manifest_finish(&check->manifest);
+        ota_manifest_t *m = &check->manifest;
+        if (status != 200) {
+            ESP_LOGE(TAG, "Mirror returned status %d", status);
+            err = ESP_FAIL;
+        } else if (result != OTA_MANIFEST_OK) {
+            ESP_LOGE(TAG, "Invalid manifest (%d)", result);
+            err = ESP_FAIL;
+        } else if (!ota_url_resolve(url, m->image, check->image_url, sizeof(check->image_url))) {
+            ESP_LOGE(TAG, "Cannot resolve image URL %s", m->image);
+            err = ESP_FAIL;
+        } else {
+#ifdef CONFIG_OTA_DELTA_UPDATES
+            if (m->delta[0] != '\0' &&
+                !ota_url_resolve(url, m->delta, check->delta_url, sizeof(check->delta_url))) {
+                check->delta_url[0] = '\0';
+            }
+#endif
+            offer_update(m->version, check->image_url, ends_with(check->image_url, ".gz"),
+                         check->delta_url, m->sha256);
+        }
+    } else {
+        ESP_LOGE(TAG, "HTTP request failed: %s", esp_err_to_name(err));
+    }
+    
+    free(check);
     esp_http_client_cleanup(client);
     return err;
 }
 
+static esp_err_t ota_check_for_update_internal(void)
+{
+    char source[OTA_SOURCE_URL_MAX];
+    ota_get_source_url(source, sizeof(source));
+    if (source[0] != '\0') {
+        return ota_check_mirror_internal(source);
+    }
+    return ota_check_github_internal();
+}
+
 /**
  * @brief Check for firmware updates with retry
  */
@@ -242,6 +437,10 @@ esp_err_t ota_check_for_update(void)
     
     s_update_available = false;
     
+    /* Low-water mark of the heap across the check (TLS accounts for most of it) */
+    size_t heap_before = heap_caps_get_free_size(MALLOC_CAP_DEFAULT);
+    bool heap_monitor = heap_caps_monitor_local_minimum_free_size_start() == ESP_OK;
+    
     esp_err_t err = ESP_FAIL;
     int retry_delay_ms = OTA_CHECK_RETRY_DELAY_MS;
     
@@ -262,6 +461,14 @@ esp_err_t ota_check_for_update(void)
         }
     }
     
+    if (heap_monitor) {
+        size_t heap_lowest = heap_caps_get_minimum_free_size(MALLOC_CAP_DEFAULT);
+        heap_caps_monitor_local_minimum_free_size_stop();
+        ESP_LOGI(TAG, "Update check peak heap use: %u bytes (%u free before)",
+                 (unsigned)(heap_before > heap_lowest ? heap_before - heap_lowest : 0),
+                 (unsigned)heap_before);
+    }
+    
     ESP_LOGD(TAG, "OTA check complete");
     return err;
 }
@@ -342,93 +549,642 @@ esp_err_t ota_get_latest_version(char *version, size_t max_len)
 }
 
 /**
- * @brief OTA update task with progress tracking
+ * @brief Shared HTTP settings for firmware downloads
  */
-static void ota_update_task(void *pvParameters)
+static void download_http_config(esp_http_client_config_t *config, const char *url)
 {
-    ESP_LOGI(TAG, "Starting OTA update from: %s", s_download_url);
-    
-    s_update_state = OTA_UPDATE_DOWNLOADING;
-    s_download_progress = 0;
-    s_download_total = 0;
-    s_download_received = 0;
-    
-    esp_http_client_config_t config = {
-        .url = s_download_url,
+    *config = (esp_http_client_config_t) {
+        .url = url,
         .timeout_ms = 60000,
         .crt_bundle_attach = esp_crt_bundle_attach,
         .buffer_size = 8192,      /* 8KB receive buffer for efficient reads */
         .buffer_size_tx = 1024,
         .keep_alive_enable = true,
     };
+}
+
+static void update_download_progress(void)
+{
+    s_download_progress = (s_download_received * 100) / s_download_total;
+    if (s_download_progress > 99) s_download_progress = 99;  /* Cap at 99 until complete */
+}
+
+/* Downloads yield this often so status requests still get answered */
+#define OTA_YIELD_BYTES (64 * 1024)
+#define OTA_MAX_REDIRECTS 5
+
+/* Resumable downloads */
+#define OTA_DOWNLOAD_ATTEMPTS 3
+#define OTA_DOWNLOAD_RETRY_DELAY_MS 2000
+#define OTA_CHECKPOINT_BYTES (64 * 1024)    /* Raw images; compressed ones at their flush points */
+#define OTA_RESUME_VERSION 1
+
+typedef enum {
+    OTA_FORMAT_RAW,             /* thermux.bin */
+    OTA_FORMAT_GZIP,            /* thermux.bin.gz */
+    OTA_FORMAT_DELTA,           /* Gzipped patch against the running image */
+} ota_format_t;
+
+/**
+ * @brief Where an interrupted download can pick up again, kept in NVS
+ *
+ * Only written once the image bytes it covers are on flash, and checked
+ * against a hash of the partition before it is used.
+ */
+typedef struct {
+    uint32_t version;
+    uint8_t url_sha256[SHA256_DIGEST_SIZE];     /* Which download */
+    uint32_t partition_address;
+    uint32_t total;             /* Download size */
+    uint32_t in_offset;         /* Download bytes consumed: the Range to resume from */
+    uint32_t out_offset;        /* Image bytes on flash (erase-size multiple) */
+    uint32_t crc;               /* gzip CRC-32 of those bytes (0 for a raw image) */
+    uint8_t image_sha256[SHA256_DIGEST_SIZE];   /* Of those bytes */
+} ota_checkpoint_t;
+
+typedef struct {
+    esp_http_client_handle_t client;
+    const esp_partition_t *partition;
+    delta_patch_t *delta;       /* NULL for a full image */
+    bool checkpoints;           /* Record resume points */
+    mbedtls_sha256_context image_sha;   /* Image bytes written so far */
+    uint32_t out_total;
+    ota_checkpoint_t base;      /* Identity fields of new checkpoints */
+    ota_checkpoint_t pending;   /* Saved once the writer has flushed it */
+    bool has_pending;
+    bool own_checkpoint;        /* The saved resume point is this download's */
+} download_ctx_t;
+
+/**
+ * @brief Start a hash over (freeing first releases the SHA engine if the context holds it)
+ */
+static void sha_restart(mbedtls_sha256_context *sha)
+{
+    mbedtls_sha256_free(sha);
+    mbedtls_sha256_init(sha);
+    mbedtls_sha256_starts(sha, 0);
+}
+
+/**
+ * @brief Digest of the bytes hashed so far, leaving the hash open
+ */
+static void sha_peek(const mbedtls_sha256_context *sha, uint8_t digest[SHA256_DIGEST_SIZE])
+{
+    mbedtls_sha256_context prefix;
+    mbedtls_sha256_init(&prefix);
+    mbedtls_sha256_clone(&prefix, sha);
+    mbedtls_sha256_finish(&prefix, digest);
+    mbedtls_sha256_free(&prefix);
+}
+
+/**
+ * @brief Remember the current position as a resume point
+ */
+static void checkpoint_mark(download_ctx_t *dl, uint32_t in_offset, uint32_t crc)
+{
+    dl->pending = dl->base;
+    dl->pending.in_offset = in_offset;
+    dl->pending.out_offset = dl->out_total;
+    dl->pending.crc = crc;
+    sha_peek(&dl->image_sha, dl->pending.image_sha256);
+    dl->has_pending = true;
+}
+
+/**
+ * @brief Persist the pending resume point once its bytes are on flash
+ */
+static void checkpoint_commit(download_ctx_t *dl)
+{
+    if (!dl->has_pending || ota_writer_flushed() < dl->pending.out_offset) {
+        return;
+    }
+    dl->has_pending = false;
+    if (nvs_storage_save_ota_resume(&dl->pending, sizeof(dl->pending)) != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to save download checkpoint");
+    }
+    dl->own_checkpoint = true;
+}
+
+/**
+ * @brief Find the checkpoint for this download and check it against flash
+ *
+ * A checkpoint of another download (say the release URL, while a peer
+ * is tried first) is left alone: it is only cleared once the partition
+ * no longer holds its bytes.
+ *
+ * @param sha Output: hash state over the bytes kept, to continue from
+ */
+static bool checkpoint_load(const ota_checkpoint_t *base, ota_checkpoint_t *cp, mbedtls_sha256_context *sha)
+{
+    if (nvs_storage_load_ota_resume(cp, sizeof(*cp)) != ESP_OK) {
+        return false;
+    }
+    const esp_partition_t *partition = esp_ota_get_next_update_partition(NULL);
+    if (cp->version != OTA_RESUME_VERSION ||
+        cp->partition_address != base->partition_address ||
+        cp->out_offset == 0 || cp->out_offset > partition->size || cp->in_offset >= cp->total) {
+        ESP_LOGD(TAG, "Discarding unusable checkpoint");
+        nvs_storage_clear_ota_resume();
+        return false;
+    }
+    if (memcmp(cp->url_sha256, base->url_sha256, SHA256_DIGEST_SIZE) != 0) {
+        ESP_LOGD(TAG, "Keeping checkpoint of another download");
+        return false;
+    }
+
+    uint8_t *buf = malloc(OTA_WRITER_BUFFER_SIZE);
+    if (buf == NULL) {
+        return false;
+    }
+    sha_restart(sha);
+    esp_err_t err = ESP_OK;
+    for (uint32_t off = 0; off < cp->out_offset && err == ESP_OK; off += OTA_WRITER_BUFFER_SIZE) {
+        uint32_t n = cp->out_offset - off;
+        if (n > OTA_WRITER_BUFFER_SIZE) {
+            n = OTA_WRITER_BUFFER_SIZE;
+        }
+        err = esp_partition_read(partition, off, buf, n);
+        mbedtls_sha256_update(sha, buf, n);
+    }
+    free(buf);
+
+    uint8_t digest[SHA256_DIGEST_SIZE];
+    sha_peek(sha, digest);
+    if (err != ESP_OK || memcmp(digest, cp->image_sha256, SHA256_DIGEST_SIZE) != 0) {
+        ESP_LOGW(TAG, "Partition no longer holds the interrupted download, starting over");
+        nvs_storage_clear_ota_resume();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Read from the response body, counted for progress
+ */
+static int download_read(void *ctx, uint8_t *buf, size_t len)
+{
+    download_ctx_t *dl = ctx;
+    int n = esp_http_client_read(dl->client, (char *)buf, (int)len);
+    if (n > 0) {
+        int before = s_download_received;
+        s_download_received += n;
+        s_download_fetched += n;
+        update_download_progress();
+        if (before / OTA_YIELD_BYTES != s_download_received / OTA_YIELD_BYTES) {
+            ESP_LOGD(TAG, "Download: %d KB / %d KB (%d%%)",
+                     s_download_received / 1024, s_download_total / 1024, s_download_progress);
+            vTaskDelay(pdMS_TO_TICKS(10));
+        }
+    }
+    checkpoint_commit(dl);
+    return n;
+}
+
+static int image_write(download_ctx_t *dl, const uint8_t *data, size_t len)
+{
+    mbedtls_sha256_update(&dl->image_sha, data, len);
+    dl->out_total += (uint32_t)len;
+    return ota_writer_write(data, len) == ESP_OK ? 0 : -1;
+}
+
+/**
+ * @brief gunzip sink: the image itself, or a patch to apply to the running one
+ */
+static int download_write(void *ctx, const uint8_t *data, size_t len)
+{
+    download_ctx_t *dl = ctx;
+    if (dl->delta != NULL) {
+        return delta_patch_feed(dl->delta, data, len) == DELTA_OK ? 0 : -1;
+    }
+    return image_write(dl, data, len);
+}
+
+/**
+ * @brief gunzip flush point: resumable if it falls on a sector boundary
+ */
+static void download_sync(void *ctx, uint32_t in_offset, uint32_t out_offset, uint32_t crc)
+{
+    download_ctx_t *dl = ctx;
+    if (dl->checkpoints && out_offset == dl->out_total && out_offset % dl->partition->erase_size == 0) {
+        checkpoint_mark(dl, in_offset, crc);
+    }
+}
+
+/* delta_patch source and sink: running partition in, ota_writer out */
+static int running_image_read(void *ctx, uint32_t offset, void *buf, size_t len)
+{
+    return esp_partition_read(ctx, offset, buf, len) == ESP_OK ? 0 : -1;
+}
+
+static int patched_image_write(void *ctx, const void *data, size_t len)
+{
+    return ota_writer_write(data, len) == ESP_OK ? 0 : -1;
+}
+
+/**
+ * @brief Copy a raw image straight into writer buffers
+ */
+static esp_err_t download_raw(download_ctx_t *dl, uint32_t total)
+{
+    while (dl->out_total < total) {
+        char *buf = ota_writer_get_buffer();
+        if (buf == NULL) {
+            return ESP_FAIL;
+        }
+        size_t want = total - dl->out_total;
+        if (want > OTA_WRITER_BUFFER_SIZE) {
+            want = OTA_WRITER_BUFFER_SIZE;
+        }
+        size_t len = 0;
+        while (len < want) {
+            int n = download_read(dl, (uint8_t *)buf + len, want - len);
+            if (n <= 0) {
+                ESP_LOGE(TAG, "Connection lost at %lu of %lu bytes",
+                         (unsigned long)(dl->out_total + len), (unsigned long)total);
+                ota_writer_submit(buf, 0);
+                return ESP_FAIL;
+            }
+            len += n;
+        }
+        mbedtls_sha256_update(&dl->image_sha, (const uint8_t *)buf, len);
+        dl->out_total += (uint32_t)len;
+        if (ota_writer_submit(buf, len) != ESP_OK) {
+            return ESP_FAIL;
+        }
+        if (dl->checkpoints && dl->out_total % OTA_CHECKPOINT_BYTES == 0) {
+            checkpoint_mark(dl, dl->out_total, 0);
+        }
+    }
+    return ESP_OK;
+}
+
+/**
+ * @brief Send the GET, following redirects (release assets redirect to a CDN)
+ */
+static esp_err_t download_open(esp_http_client_handle_t client)
+{
+    for (int hop = 0; hop <= OTA_MAX_REDIRECTS; hop++) {
+        esp_err_t err = esp_http_client_open(client, 0);
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Connection failed: %s", esp_err_to_name(err));
+            return err;
+        }
+        if (esp_http_client_fetch_headers(client) < 0) {
+            ESP_LOGE(TAG, "Failed to read response headers");
+            return ESP_FAIL;
+        }
+        int status = esp_http_client_get_status_code(client);
+        if (status == 200 || status == 206) {
+            return ESP_OK;
+        }
+        if (status != 301 && status != 302 && status != 303 && status != 307 && status != 308) {
+            ESP_LOGE(TAG, "Download returned status %d", status);
+            return ESP_FAIL;
+        }
+        esp_http_client_flush_response(client, NULL);
+        esp_http_client_set_redirection(client);
+    }
+    ESP_LOGE(TAG, "Too many redirects");
+    return ESP_FAIL;
+}
+
+/**
+ * @brief Download an image and write it to the update partition
+ *
+ * A raw or gzip image that was interrupted before continues from its
+ * last checkpoint with a Range request, once the partition has been
+ * checked to still hold the bytes up to it. A delta patch is applied
+ * against the running partition as it arrives; it is small, so it is
+ * always fetched from the start. A patched image must match the patch's
+ * SHA-256 before it is made bootable, and any image expected_sha256:
+ * for a patch, its target digest must be the published one.
+ *
+ * @param expected_sha256 Digest of the image, NULL if unknown
+ * @param from_peer Authenticate with the peer secret
+ * @return ESP_ERR_INVALID_CRC if the image does not match its digest
+ */
+static esp_err_t ota_install(const char *url, ota_format_t format, const uint8_t *expected_sha256,
+                             bool from_peer)
+{
+    const esp_partition_t *partition = esp_ota_get_next_update_partition(NULL);
+    if (partition == NULL) {
+        ESP_LOGE(TAG, "No update partition found");
+        return ESP_FAIL;
+    }
     
-    esp_https_ota_config_t ota_config = {
-        .http_config = &config,
-        .partial_http_download = true,
-        .max_http_request_size = 64 * 1024,  /* 64KB chunks — balances speed with progress granularity */
+    download_ctx_t dl = {
+        .partition = partition,
+        .base = {
+            .version = OTA_RESUME_VERSION,
+            .partition_address = partition->address,
+        },
     };
+    mbedtls_sha256((const unsigned char *)url, strlen(url), dl.base.url_sha256, 0);
+    
+    mbedtls_sha256_init(&dl.image_sha);
+    ota_checkpoint_t cp;
+    bool resume = (format != OTA_FORMAT_DELTA) && checkpoint_load(&dl.base, &cp, &dl.image_sha);
+    dl.own_checkpoint = resume;
+    if (!resume) {
+        sha_restart(&dl.image_sha);
+    }
     
-    esp_https_ota_handle_t ota_handle = NULL;
-    ESP_LOGD(TAG, "Connecting to GitHub...");
-    esp_err_t err = esp_https_ota_begin(&ota_config, &ota_handle);
+    esp_http_client_config_t config;
+    download_http_config(&config, url);
+    esp_http_client_handle_t client = esp_http_client_init(&config);
+    if (client == NULL) {
+        ESP_LOGE(TAG, "Failed to initialize HTTP client");
+        mbedtls_sha256_free(&dl.image_sha);
+        return ESP_FAIL;
+    }
+    dl.client = client;
+#if CONFIG_OTA_PEER_CACHE
+    if (from_peer && CONFIG_OTA_PEER_SECRET[0] != '\0') {
+        esp_http_client_set_header(client, "X-Peer-Secret", CONFIG_OTA_PEER_SECRET);
+    }
+#else
+    (void)from_peer;
+#endif
+    if (resume) {
+        char range[32];
+        snprintf(range, sizeof(range), "bytes=%lu-", (unsigned long)cp.in_offset);
+        esp_http_client_set_header(client, "Range", range);
+    }
     
+    gunzip_t *gz = NULL;
+    ESP_LOGD(TAG, "Connecting to %s...", url);
+    esp_err_t err = download_open(client);
     if (err != ESP_OK) {
-        ESP_LOGE(TAG, "OTA begin failed: %s", esp_err_to_name(err));
-        s_update_state = OTA_UPDATE_FAILED;
-        vTaskDelete(NULL);
-        return;
+        goto done;
     }
     
-    /* Get total image size - may be 0 if server doesn't provide Content-Length */
-    int real_total = esp_https_ota_get_image_size(ota_handle);
-    ESP_LOGD(TAG, "Image size from server: %d bytes (0 means unknown)", real_total);
+    int64_t content_len = esp_http_client_get_content_length(client);
+    if (resume && esp_http_client_get_status_code(client) != 206) {
+        ESP_LOGW(TAG, "Server ignored the range request, downloading from the start");
+        resume = false;
+        sha_restart(&dl.image_sha);
+        nvs_storage_clear_ota_resume();
+    } else if (resume && content_len + cp.in_offset != cp.total) {
+        ESP_LOGW(TAG, "Download changed since it was interrupted, starting over");
+        nvs_storage_clear_ota_resume();
+        err = ESP_ERR_INVALID_RESPONSE;
+        goto done;
+    }
+    uint32_t start = resume ? cp.in_offset : 0;
+    dl.base.total = (content_len > 0) ? start + (uint32_t)content_len : 0;
+    dl.checkpoints = (format != OTA_FORMAT_DELTA) && dl.base.total > 0;
     
-    /* If image size unknown, estimate ~1.1MB based on typical firmware size */
-    s_download_total = (real_total > 0) ? real_total : (1100 * 1024);
+    /* If size unknown, estimate half of a typical ~1.1MB image (a patch is usually far smaller) */
+    s_download_total = (dl.base.total > 0) ? (int)dl.base.total : (550 * 1024);
+    s_download_received = (int)start;
+    s_download_resumed = (int)start;
+    update_download_progress();
+    if (resume) {
+        ESP_LOGI(TAG, "Resuming download at %lu of %lu bytes (%lu image bytes already written)",
+                 (unsigned long)start, (unsigned long)dl.base.total, (unsigned long)cp.out_offset);
+    }
+    ESP_LOGD(TAG, "Download size from server: %lld bytes", (long long)content_len);
     
-    /* Download and flash in chunks */
-    int last_logged_pct = -1;
-    while (1) {
-        err = esp_https_ota_perform(ota_handle);
-        if (err != ESP_ERR_HTTPS_OTA_IN_PROGRESS) {
-            break;
+    if (format == OTA_FORMAT_RAW && dl.base.total == 0) {
+        ESP_LOGE(TAG, "Server did not send the image size");
+        err = ESP_FAIL;
+        goto done;
+    }
+    if (format != OTA_FORMAT_RAW) {
+        gz = malloc(sizeof(gunzip_t));
+        if (gz == NULL) {
+            err = ESP_ERR_NO_MEM;
+            goto done;
         }
-        
-        /* Update progress */
-        s_download_received = esp_https_ota_get_image_len_read(ota_handle);
-        s_download_progress = (s_download_received * 100) / s_download_total;
-        if (s_download_progress > 99) s_download_progress = 99;  /* Cap at 99 until complete */
-        
-        /* Log every 5% change to avoid log spam */
-        if (s_download_progress / 5 != last_logged_pct / 5) {
-            ESP_LOGD(TAG, "Download: %d KB / %d KB (%d%%)", 
-                     s_download_received / 1024, s_download_total / 1024, s_download_progress);
-            last_logged_pct = s_download_progress;
+    }
+    if (format == OTA_FORMAT_DELTA) {
+        dl.delta = malloc(sizeof(delta_patch_t));
+        if (dl.delta == NULL) {
+            err = ESP_ERR_NO_MEM;
+            goto done;
         }
-        
-        /* Yield to allow HTTP server to respond to status requests */
-        vTaskDelay(pdMS_TO_TICKS(10));
+        const delta_io_t dio = {
+            .read_source = running_image_read,
+            .write = patched_image_write,
+            .ctx = (void *)esp_ota_get_running_partition(),
+        };
+        delta_patch_init(dl.delta, &dio);
     }
     
+    /* An inflated size is only known at the end: erase on demand */
+    dl.out_total = resume ? cp.out_offset : 0;
+    err = ota_writer_begin_at(partition, format == OTA_FORMAT_RAW ? dl.base.total : 0, dl.out_total);
     if (err != ESP_OK) {
-        ESP_LOGE(TAG, "OTA perform failed: %s", esp_err_to_name(err));
-        esp_https_ota_abort(ota_handle);
-        s_update_state = OTA_UPDATE_FAILED;
-        vTaskDelete(NULL);
-        return;
+        ESP_LOGE(TAG, "ota_writer_begin failed: %s", esp_err_to_name(err));
+        goto done;
     }
     
-    /* Verify and finish */
-    if (esp_https_ota_is_complete_data_received(ota_handle) != true) {
-        ESP_LOGE(TAG, "Complete data was not received");
-        esp_https_ota_abort(ota_handle);
-        s_update_state = OTA_UPDATE_FAILED;
-        vTaskDelete(NULL);
-        return;
+    bool ok;
+    bool keep_checkpoint = false;   /* The failure was the network, not the data */
+    if (format == OTA_FORMAT_RAW) {
+        ok = (download_raw(&dl, dl.base.total) == ESP_OK);
+        keep_checkpoint = true;
+    } else {
+        const gunzip_io_t io = {
+            .read = download_read,
+            .write = download_write,
+            .sync = download_sync,
+            .ctx = &dl,
+        };
+        gunzip_init(gz, &io);
+        if (resume) {
+            gunzip_resume(gz, cp.in_offset, cp.out_offset, cp.crc);
+        }
+        int result = gunzip_run(gz);
+        ok = (result == GUNZIP_OK);
+        keep_checkpoint = (result == GUNZIP_ERR_READ || result == GUNZIP_ERR_TRUNCATED);
+        if (ok && dl.delta != NULL) {
+            /* Target length and SHA-256 */
+            result = delta_patch_finish(dl.delta);
+            ok = (result == DELTA_OK);
+            if (!ok) {
+                ESP_LOGE(TAG, "Delta patch failed: %s", delta_patch_strerror(result));
+            }
+        } else if (!ok && dl.delta != NULL && dl.delta->error != DELTA_OK) {
+            ESP_LOGE(TAG, "Delta patch failed: %s", delta_patch_strerror(dl.delta->error));
+        } else if (!ok) {
+            ESP_LOGE(TAG, "Decompression failed after %lu bytes: %s",
+                     (unsigned long)gz->in_total, gunzip_strerror(result));
+        }
+    }
+    if (!ok) {
+        checkpoint_commit(&dl);
+        ota_writer_abort();
+        if (!keep_checkpoint && dl.own_checkpoint) {
+            nvs_storage_clear_ota_resume();
+        }
+        err = ESP_FAIL;
+        goto done;
     }
     
     s_download_progress = 100;
-    err = esp_https_ota_finish(ota_handle);
+    ota_writer_stats_t stats;
+    err = ota_writer_end(&stats);
+    if (dl.checkpoints) {
+        nvs_storage_clear_ota_resume();     /* Installed, or not worth resuming */
+    }
+    if (err == ESP_OK && expected_sha256 != NULL) {
+        uint8_t digest[SHA256_DIGEST_SIZE];
+        if (dl.delta != NULL) {
+            /* delta_patch_finish checked the patched bytes against this */
+            memcpy(digest, dl.delta->header.target_sha256, SHA256_DIGEST_SIZE);
+        } else {
+            mbedtls_sha256_finish(&dl.image_sha, digest);
+        }
+        if (memcmp(digest, expected_sha256, SHA256_DIGEST_SIZE) != 0) {
+            ESP_LOGE(TAG, "Image does not match the published SHA-256, not installing it");
+            err = ESP_ERR_INVALID_CRC;
+        }
+    }
+    if (err == ESP_OK) {
+        if (dl.delta != NULL) {
+            ESP_LOGI(TAG, "Patched %lu byte image from a %lu byte download, SHA-256 verified",
+                     (unsigned long)dl.delta->out_total, (unsigned long)gz->in_total);
+        } else if (gz != NULL) {
+            ESP_LOGI(TAG, "Inflated %lu -> %lu bytes (%d resumed, %d fetched)%s",
+                     (unsigned long)gz->in_total, (unsigned long)gz->out_total,
+                     s_download_resumed, s_download_fetched, expected_sha256 ? ", SHA-256 verified" : "");
+        } else {
+            ESP_LOGI(TAG, "Downloaded %lu bytes (%d resumed, %d fetched)%s",
+                     (unsigned long)dl.out_total, s_download_resumed, s_download_fetched,
+                     expected_sha256 ? ", SHA-256 verified" : "");
+        }
+        err = esp_ota_set_boot_partition(partition);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "OTA finish failed: %s", esp_err_to_name(err));
+    }
+    
+done:
+    if (dl.delta != NULL) {
+        delta_patch_free(dl.delta);
+        free(dl.delta);
+    }
+    mbedtls_sha256_free(&dl.image_sha);
+    free(gz);
+    esp_http_client_close(client);
+    esp_http_client_cleanup(client);
+    return err;
+}
+
+#if CONFIG_OTA_PEER_CACHE
+#define PEER_MAX 3
+#define PEER_QUERY_MS 3000
+#define PEER_URL_MAX 96
+
+/**
+ * @brief Find nodes that already run the new version and serve their image
+ * @return Number of image URLs found
+ */
+static int find_peers(char urls[][PEER_URL_MAX], int max)
+{
+    mdns_result_t *results = NULL;
+    if (mdns_query_ptr("_thermux", "_tcp", PEER_QUERY_MS, 20, &results) != ESP_OK) {
+        return 0;
+    }
+    int count = 0;
+    for (mdns_result_t *r = results; r != NULL && count < max; r = r->next) {
+        const char *version = NULL;
+        const char *path = NULL;
+        for (size_t i = 0; i < r->txt_count; i++) {
+            if (strcmp(r->txt[i].key, "version") == 0) {
+                version = r->txt[i].value;
+            } else if (strcmp(r->txt[i].key, "ota") == 0) {
+                path = r->txt[i].value;
+            }
+        }
+        if (version == NULL || path == NULL || version_compare(version, s_latest_version) != 0) {
+            continue;
+        }
+        for (mdns_ip_addr_t *a = r->addr; a != NULL; a = a->next) {
+            if (a->addr.type == ESP_IPADDR_TYPE_V4) {
+                snprintf(urls[count], PEER_URL_MAX, "http://" IPSTR ":%u%s",
+                         IP2STR(&a->addr.u_addr.ip4), r->port, path);
+                count++;
+                break;
+            }
+        }
+    }
+    mdns_query_results_free(results);
+    return count;
+}
+
+/**
+ * @brief Fetch the image from a node that already installed it
+ *
+ * Only with a known digest: a peer is not trusted for anything else.
+ */
+static esp_err_t install_from_peers(void)
+{
+    if (!s_image_sha256_known) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    char urls[PEER_MAX][PEER_URL_MAX];
+    int count = find_peers(urls, PEER_MAX);
+    ESP_LOGD(TAG, "%d peers with %s", count, s_latest_version);
+    
+    esp_err_t err = ESP_ERR_NOT_FOUND;
+    for (int i = 0; i < count && err != ESP_OK; i++) {
+        ESP_LOGI(TAG, "Starting OTA update from peer: %s", urls[i]);
+        err = ota_install(urls[i], OTA_FORMAT_RAW, s_image_sha256, true);
+        if (err != ESP_OK) {
+            ESP_LOGW(TAG, "Peer update failed: %s", esp_err_to_name(err));
+            s_download_progress = 0;
+            s_download_received = 0;
+        }
+    }
+    return err;
+}
+#endif
+
+/**
+ * @brief OTA update task with progress tracking
+ */
+static void ota_update_task(void *pvParameters)
+{
+    s_update_state = OTA_UPDATE_DOWNLOADING;
+    s_download_progress = 0;
+    s_download_total = 0;
+    s_download_received = 0;
+    s_download_resumed = 0;
+    s_download_fetched = 0;
+    
+    const uint8_t *sha256 = s_image_sha256_known ? s_image_sha256 : NULL;
+    esp_err_t err = ESP_FAIL;
+#if CONFIG_OTA_PEER_CACHE
+    err = install_from_peers();
+#endif
+    if (err != ESP_OK && s_delta_url[0] != '\0') {
+        ESP_LOGI(TAG, "Starting delta OTA update from: %s", s_delta_url);
+        err = ota_install(s_delta_url, OTA_FORMAT_DELTA, sha256, false);
+        if (err != ESP_OK) {
+            ESP_LOGW(TAG, "Delta update failed, falling back to the full image");
+            s_download_progress = 0;
+            s_download_received = 0;
+        }
+    }
+    if (err != ESP_OK) {
+        ESP_LOGI(TAG, "Starting OTA update from: %s", s_download_url);
+        ota_format_t format = s_download_compressed ? OTA_FORMAT_GZIP : OTA_FORMAT_RAW;
+        int retry_delay_ms = OTA_DOWNLOAD_RETRY_DELAY_MS;
+        for (int attempt = 1; attempt <= OTA_DOWNLOAD_ATTEMPTS; attempt++) {
+            err = ota_install(s_download_url, format, sha256, false);
+            if (err == ESP_OK || err == ESP_ERR_INVALID_CRC) {
+                break;  /* Downloading the same bytes again will not help */
+            }
+            if (attempt < OTA_DOWNLOAD_ATTEMPTS) {
+                ESP_LOGW(TAG, "Download attempt %d/%d failed, resuming in %d ms...",
+                         attempt, OTA_DOWNLOAD_ATTEMPTS, retry_delay_ms);
+                vTaskDelay(pdMS_TO_TICKS(retry_delay_ms));
+                retry_delay_ms *= 2;  /* Exponential backoff */
+            }
+        }
+    }
     
     if (err == ESP_OK) {
         ESP_LOGI(TAG, "OTA update successful, restarting...");
@@ -436,7 +1192,6 @@ static void ota_update_task(void *pvParameters)
         vTaskDelay(pdMS_TO_TICKS(1000));
         esp_restart();
     } else {
-        ESP_LOGE(TAG, "OTA finish failed: %s", esp_err_to_name(err));
         s_update_state = OTA_UPDATE_FAILED;
     }
     
@@ -455,6 +1210,8 @@ esp_err_t ota_start_update(void)
     s_download_progress = 0;
     s_download_total = 0;
     s_download_received = 0;
+    s_download_resumed = 0;
+    s_download_fetched = 0;
     
     /* Create OTA task with high priority */
     xTaskCreate(ota_update_task, "ota_update", 8192, NULL, 10, NULL);
@@ -494,3 +1251,9 @@ void ota_get_download_stats(int *received, int *total)
     if (received) *received = s_download_received;
     if (total) *total = s_download_total;
 }
+
+void ota_get_resume_stats(int *resumed, int *fetched)
+{
+    if (resumed) *resumed = s_download_resumed;
+    if (fetched) *fetched = s_download_fetched;
+}
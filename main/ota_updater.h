@@ -1,6 +1,6 @@
 /**
  * @file ota_updater.h
- * @brief OTA firmware updates from GitHub Releases
+ * @brief OTA firmware updates from GitHub Releases or a local mirror
  */
 
 #ifndef OTA_UPDATER_H
@@ -8,6 +8,10 @@
 
 #include "esp_err.h"
 #include <stdbool.h>
+#include <stddef.h>
+
+/* Longest manifest URL of an update source */
+#define OTA_SOURCE_URL_MAX 256
 
 /**
  * @brief Initialize OTA updater
@@ -15,7 +19,19 @@
 esp_err_t ota_updater_init(void);
 
 /**
- * @brief Check GitHub releases for available update (blocking)
+ * @brief Set where updates come from and save it
+ * @param url manifest.json of a local mirror (http:// or https://), "" for GitHub releases
+ * @return ESP_ERR_INVALID_ARG if url is neither
+ */
+esp_err_t ota_set_source_url(const char *url);
+
+/**
+ * @brief Get the update source, "" for GitHub releases
+ */
+void ota_get_source_url(char *url, size_t max_len);
+
+/**
+ * @brief Check the update source for available update (blocking)
  * @note Use ota_check_for_update_async() from HTTP handlers to avoid stack overflow
  */
 esp_err_t ota_check_for_update(void);
@@ -77,6 +93,13 @@ int ota_get_download_progress(void);
  */
 void ota_get_download_stats(int *received, int *total);
 
+/**
+ * @brief Get how much of the download came from an earlier, interrupted attempt
+ * @param resumed Bytes not downloaded again thanks to a checkpoint (can be NULL)
+ * @param fetched Bytes actually transferred by this update, retries included (can be NULL)
+ */
+void ota_get_resume_stats(int *resumed, int *fetched);
+
 /**
  * @brief Get current firmware version
  */
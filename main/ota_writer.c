@@ -0,0 +1,317 @@
+/**
+ * @file ota_writer.c
+ * @brief Pipelined firmware writer: receive into one buffer while another is flashed
+ */
+
+#include "ota_writer.h"
+#include "flash_stream.h"
+#include "esp_log.h"
+#include "esp_ota_ops.h"
+#include "esp_image_format.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char *TAG = "ota_writer";
+
+#define WRITER_STACK_SIZE 3072
+#define WRITER_PRIORITY 4       /* Same as the HTTP async workers */
+
+typedef struct {
+    char *buf;                  /* NULL stops the writer task */
+    size_t len;
+} ota_chunk_t;
+
+static bool s_active = false;
+static portMUX_TYPE s_active_lock = portMUX_INITIALIZER_UNLOCKED;  /* Claims s_active */
+static const esp_partition_t *s_partition = NULL;
+static flash_stream_t s_stream;
+static char *s_buffers[OTA_WRITER_BUFFERS];
+static QueueHandle_t s_free_queue = NULL;       /* Empty buffers */
+static QueueHandle_t s_filled_queue = NULL;     /* Buffers waiting for flash */
+static SemaphoreHandle_t s_done = NULL;         /* Given when the task exits */
+static volatile bool s_failed = false;
+static char *s_current = NULL;                  /* Partly filled by ota_writer_write() */
+static size_t s_current_len = 0;
+
+static int64_t s_start_us;
+static int64_t s_recv_stall_us;
+static int64_t s_flash_idle_us;
+static int64_t s_write_us;
+static int64_t s_erase_us;
+
+static int partition_erase(void *ctx, uint32_t offset, uint32_t len)
+{
+    int64_t start = esp_timer_get_time();
+    esp_err_t err = esp_partition_erase_range(ctx, offset, len);
+    s_erase_us += esp_timer_get_time() - start;
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Erase at 0x%lx failed: %s", (unsigned long)offset, esp_err_to_name(err));
+    }
+    return err == ESP_OK ? 0 : -1;
+}
+
+static int partition_write(void *ctx, uint32_t offset, const void *data, size_t len)
+{
+    int64_t start = esp_timer_get_time();
+    esp_err_t err = esp_partition_write(ctx, offset, data, len);
+    s_write_us += esp_timer_get_time() - start;
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Write at 0x%lx failed: %s", (unsigned long)offset, esp_err_to_name(err));
+    }
+    return err == ESP_OK ? 0 : -1;
+}
+
+static void writer_task(void *arg)
+{
+    bool erase_pending = true;
+    ota_chunk_t chunk;
+
+    for (;;) {
+        /* Poll while there are sectors to erase ahead, otherwise block */
+        TickType_t wait = (erase_pending && !s_failed) ? 0 : portMAX_DELAY;
+        int64_t start = esp_timer_get_time();
+        if (xQueueReceive(s_filled_queue, &chunk, wait) != pdTRUE) {
+            int erased = flash_stream_erase_ahead(&s_stream, 1);
+            if (erased < 0) {
+                s_failed = true;
+            }
+            erase_pending = erased > 0;
+            continue;
+        }
+        if (wait != 0) {
+            s_flash_idle_us += esp_timer_get_time() - start;
+        }
+        if (chunk.buf == NULL) {
+            break;
+        }
+
+        if (!s_failed && flash_stream_write(&s_stream, chunk.buf, chunk.len) != 0) {
+            s_failed = true;
+        }
+        xQueueSend(s_free_queue, &chunk.buf, portMAX_DELAY);
+    }
+
+    xSemaphoreGive(s_done);
+    vTaskDelete(NULL);
+}
+
+static void cleanup(void)
+{
+    for (int i = 0; i < OTA_WRITER_BUFFERS; i++) {
+        free(s_buffers[i]);
+        s_buffers[i] = NULL;
+    }
+    if (s_free_queue != NULL) {
+        vQueueDelete(s_free_queue);
+        s_free_queue = NULL;
+    }
+    if (s_filled_queue != NULL) {
+        vQueueDelete(s_filled_queue);
+        s_filled_queue = NULL;
+    }
+    if (s_done != NULL) {
+        vSemaphoreDelete(s_done);
+        s_done = NULL;
+    }
+    s_current = NULL;
+    s_current_len = 0;
+    s_active = false;
+}
+
+esp_err_t ota_writer_begin(const esp_partition_t *partition, size_t image_size)
+{
+    return ota_writer_begin_at(partition, image_size, 0);
+}
+
+esp_err_t ota_writer_begin_at(const esp_partition_t *partition, size_t image_size, uint32_t offset)
+{
+    if (offset % partition->erase_size != 0 || offset > partition->size) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    /* Until the running image is confirmed the other slot is what a rollback goes back to */
+    esp_ota_img_states_t state;
+    if (esp_ota_get_state_partition(esp_ota_get_running_partition(), &state) == ESP_OK &&
+        state == ESP_OTA_IMG_PENDING_VERIFY) {
+        ESP_LOGW(TAG, "Running image not confirmed yet, not starting an update");
+        return ESP_ERR_INVALID_STATE;
+    }
+    /* Uploads and the updater task can get here at the same time */
+    portENTER_CRITICAL(&s_active_lock);
+    bool busy = s_active;
+    s_active = true;
+    portEXIT_CRITICAL(&s_active_lock);
+    if (busy) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    s_failed = false;
+    s_partition = partition;
+    s_recv_stall_us = 0;
+    s_flash_idle_us = 0;
+    s_write_us = 0;
+    s_erase_us = 0;
+
+    s_free_queue = xQueueCreate(OTA_WRITER_BUFFERS, sizeof(char *));
+    s_filled_queue = xQueueCreate(OTA_WRITER_BUFFERS + 1, sizeof(ota_chunk_t));  /* + stop marker */
+    s_done = xSemaphoreCreateBinary();
+    if (s_free_queue == NULL || s_filled_queue == NULL || s_done == NULL) {
+        cleanup();
+        return ESP_ERR_NO_MEM;
+    }
+    for (int i = 0; i < OTA_WRITER_BUFFERS; i++) {
+        s_buffers[i] = malloc(OTA_WRITER_BUFFER_SIZE);
+        if (s_buffers[i] == NULL) {
+            cleanup();
+            return ESP_ERR_NO_MEM;
+        }
+        xQueueSend(s_free_queue, &s_buffers[i], 0);
+    }
+
+    const flash_stream_ops_t ops = {
+        .erase = partition_erase,
+        .write = partition_write,
+        .ctx = (void *)partition,
+    };
+    flash_stream_init(&s_stream, &ops, partition->erase_size, partition->size, image_size);
+    flash_stream_resume(&s_stream, offset);     /* Checked above */
+
+    s_start_us = esp_timer_get_time();
+    if (xTaskCreate(writer_task, "ota_writer", WRITER_STACK_SIZE, NULL, WRITER_PRIORITY, NULL) != pdPASS) {
+        cleanup();
+        return ESP_ERR_NO_MEM;
+    }
+
+    ESP_LOGD(TAG, "Writing %u bytes to %s at 0x%lx from offset %lu", (unsigned)image_size,
+             partition->label, (unsigned long)partition->address, (unsigned long)offset);
+    return ESP_OK;
+}
+
+char *ota_writer_get_buffer(void)
+{
+    char *buf = NULL;
+    if (!s_active || s_failed) {
+        return NULL;
+    }
+    int64_t start = esp_timer_get_time();
+    xQueueReceive(s_free_queue, &buf, portMAX_DELAY);
+    s_recv_stall_us += esp_timer_get_time() - start;
+    return buf;
+}
+
+esp_err_t ota_writer_submit(char *buf, size_t len)
+{
+    if (s_failed) {
+        xQueueSend(s_free_queue, &buf, 0);
+        return ESP_FAIL;
+    }
+    ota_chunk_t chunk = { .buf = buf, .len = len };
+    xQueueSend(s_filled_queue, &chunk, portMAX_DELAY);
+    return ESP_OK;
+}
+
+esp_err_t ota_writer_write(const void *data, size_t len)
+{
+    const char *p = data;
+    while (len > 0) {
+        if (s_current == NULL) {
+            s_current = ota_writer_get_buffer();
+            if (s_current == NULL) {
+                return ESP_FAIL;
+            }
+        }
+        size_t take = OTA_WRITER_BUFFER_SIZE - s_current_len;
+        if (take > len) {
+            take = len;
+        }
+        memcpy(s_current + s_current_len, p, take);
+        s_current_len += take;
+        p += take;
+        len -= take;
+
+        if (s_current_len == OTA_WRITER_BUFFER_SIZE) {
+            char *full = s_current;
+            s_current = NULL;
+            s_current_len = 0;
+            if (ota_writer_submit(full, OTA_WRITER_BUFFER_SIZE) != ESP_OK) {
+                return ESP_FAIL;
+            }
+        }
+    }
+    return ESP_OK;
+}
+
+uint32_t ota_writer_flushed(void)
+{
+    /* Only the writer task updates it, a single aligned word */
+    return s_active ? *(volatile uint32_t *)&s_stream.written : 0;
+}
+
+/**
+ * @brief Let the writer finish queued buffers and exit
+ */
+static void stop_writer(void)
+{
+    ota_chunk_t stop = { .buf = NULL, .len = 0 };
+    xQueueSend(s_filled_queue, &stop, portMAX_DELAY);
+    xSemaphoreTake(s_done, portMAX_DELAY);
+}
+
+esp_err_t ota_writer_end(ota_writer_stats_t *stats)
+{
+    if (!s_active) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (s_current != NULL && s_current_len > 0) {
+        ota_writer_submit(s_current, s_current_len);
+        s_current = NULL;
+    }
+    stop_writer();
+
+    ota_writer_stats_t st = {
+        .bytes = s_stream.written,
+        .elapsed_ms = (uint32_t)((esp_timer_get_time() - s_start_us) / 1000),
+        .recv_stall_ms = (uint32_t)(s_recv_stall_us / 1000),
+        .flash_idle_ms = (uint32_t)(s_flash_idle_us / 1000),
+        .write_ms = (uint32_t)(s_write_us / 1000),
+        .erase_ms = (uint32_t)(s_erase_us / 1000),
+        .erased_ahead = s_stream.erased_ahead,
+    };
+    if (stats != NULL) {
+        *stats = st;
+    }
+
+    esp_err_t err = s_failed ? ESP_FAIL : ESP_OK;
+    if (err == ESP_OK) {
+        const esp_partition_pos_t pos = {
+            .offset = s_partition->address,
+            .size = s_partition->size,
+        };
+        esp_image_metadata_t data;
+        if (esp_image_verify(ESP_IMAGE_VERIFY, &pos, &data) != ESP_OK) {
+            err = ESP_ERR_OTA_VALIDATE_FAILED;
+        }
+    }
+    cleanup();
+
+    ESP_LOGI(TAG, "Wrote %lu bytes in %lu ms: erase %lu ms (%lu KB ahead), write %lu ms, "
+             "receive stalled %lu ms, flash idle %lu ms",
+             (unsigned long)st.bytes, (unsigned long)st.elapsed_ms, (unsigned long)st.erase_ms,
+             (unsigned long)(st.erased_ahead / 1024), (unsigned long)st.write_ms,
+             (unsigned long)st.recv_stall_ms, (unsigned long)st.flash_idle_ms);
+    return err;
+}
+
+void ota_writer_abort(void)
+{
+    if (!s_active) {
+        return;
+    }
+    s_failed = true;
+    stop_writer();
+    cleanup();
+    ESP_LOGW(TAG, "Update aborted");
+}
@@ -0,0 +1,101 @@
+/**
+ * @file ota_writer.h
+ * @brief Pipelined firmware writer: receive into one buffer while another is flashed
+ *
+ * A writer task drains filled buffers to the update partition while the
+ * caller keeps receiving into free ones. Whenever the task has nothing to
+ * write it erases upcoming sectors of the image, so most erases overlap
+ * with network time instead of stalling it. One update at a time.
+ */
+
+#ifndef OTA_WRITER_H
+#define OTA_WRITER_H
+
+#include "esp_err.h"
+#include "esp_partition.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#define OTA_WRITER_BUFFERS 3
+#define OTA_WRITER_BUFFER_SIZE 4096
+
+/**
+ * @brief Timing of one update
+ */
+typedef struct {
+    uint32_t bytes;             /**< Bytes written to flash */
+    uint32_t elapsed_ms;        /**< From begin to end */
+    uint32_t recv_stall_ms;     /**< Caller waited for a free buffer (flash was behind) */
+    uint32_t flash_idle_ms;     /**< Writer waited for data with nothing left to erase */
+    uint32_t write_ms;          /**< Time in flash writes */
+    uint32_t erase_ms;          /**< Time in flash erases */
+    uint32_t erased_ahead;      /**< Bytes erased ahead of the write position */
+} ota_writer_stats_t;
+
+/**
+ * @brief Start writing an image to a partition
+ * @param partition Update partition
+ * @param image_size Expected size, bounds erase-ahead (0 if unknown)
+ * @return ESP_ERR_INVALID_STATE if an update is running or the running image
+ *         is still on trial (see boot_monitor.h), ESP_ERR_NO_MEM
+ */
+esp_err_t ota_writer_begin(const esp_partition_t *partition, size_t image_size);
+
+/**
+ * @brief Like ota_writer_begin(), continuing an image already written up to offset
+ *
+ * The caller is responsible for checking that the partition really holds
+ * the first offset bytes of this image.
+ *
+ * @param offset Bytes to keep (a multiple of the partition's erase size)
+ * @return ESP_ERR_INVALID_ARG for a misaligned offset, or as ota_writer_begin()
+ */
+esp_err_t ota_writer_begin_at(const esp_partition_t *partition, size_t image_size, uint32_t offset);
+
+/**
+ * @brief Get an empty buffer of OTA_WRITER_BUFFER_SIZE bytes, waiting if all are in flight
+ * @return Buffer, or NULL if the writer has failed
+ */
+char *ota_writer_get_buffer(void);
+
+/**
+ * @brief Queue a buffer from ota_writer_get_buffer() for writing
+ * @param len Bytes filled (may be less than the buffer size)
+ * @return ESP_FAIL if an earlier write failed
+ */
+esp_err_t ota_writer_submit(char *buf, size_t len);
+
+/**
+ * @brief Copy data into writer buffers, queueing each one as it fills
+ *
+ * For sources that produce arbitrary-sized pieces (a decompressor, say).
+ * Don't mix with ota_writer_get_buffer() in the same update.
+ *
+ * @return ESP_FAIL if the writer has failed
+ */
+esp_err_t ota_writer_write(const void *data, size_t len);
+
+/**
+ * @brief Bytes of the image that have reached flash
+ *
+ * Lags what was submitted by the buffers still in flight. Safe to poll
+ * from the receiving task.
+ */
+uint32_t ota_writer_flushed(void);
+
+/**
+ * @brief Flush, stop the writer and validate the image
+ *
+ * Does not change the boot partition.
+ *
+ * @param stats Output: timing (can be NULL)
+ * @return ESP_OK, ESP_FAIL on a flash error, ESP_ERR_OTA_VALIDATE_FAILED for a bad image
+ */
+esp_err_t ota_writer_end(ota_writer_stats_t *stats);
+
+/**
+ * @brief Stop the writer and discard the image
+ */
+void ota_writer_abort(void);
+
+#endif /* OTA_WRITER_H */
@@ -0,0 +1,92 @@
+/**
+ * @file rate_limit.c
+ * @brief Per-client token buckets by endpoint class (host-testable)
+ */
+
+#include "rate_limit.h"
+#include <string.h>
+
+/* One request in bucket units: a rate of n per minute refills n units per ms,
+   so refills are exact integers */
+#define TOKEN 60000u
+
+static const char *const s_class_names[RATE_CLASS_COUNT] = { "read", "write", "scan" };
+
+void rate_limit_init(rate_limiter_t *rl, const rate_limit_rule_t rules[RATE_CLASS_COUNT])
+{
+    memset(rl, 0, sizeof(*rl));
+    memcpy(rl->rules, rules, sizeof(rl->rules));
+}
+
+/**
+ * @brief Find the client's slot, claiming the least recently seen one if new
+ */
+static rate_limit_client_t *find_client(rate_limiter_t *rl, uint32_t key, uint32_t now_ms)
+{
+    rate_limit_client_t *oldest = &rl->clients[0];
+    for (int i = 0; i < RATE_LIMIT_CLIENTS; i++) {
+        rate_limit_client_t *c = &rl->clients[i];
+        if (c->used && c->key == key) {
+            return c;
+        }
+        if (!c->used) {
+            oldest = c;
+        } else if (oldest->used && now_ms - c->last_ms > now_ms - oldest->last_ms) {
+            oldest = c;
+        }
+    }
+
+    /* New clients start with full buckets */
+    oldest->key = key;
+    oldest->last_ms = now_ms;
+    oldest->used = true;
+    for (int i = 0; i < RATE_CLASS_COUNT; i++) {
+        oldest->tokens[i] = rl->rules[i].burst * TOKEN;
+    }
+    return oldest;
+}
+
+static void refill(const rate_limiter_t *rl, rate_limit_client_t *c, uint32_t now_ms)
+{
+    uint32_t elapsed = now_ms - c->last_ms;
+    if (elapsed == 0) {
+        return;
+    }
+    c->last_ms = now_ms;
+
+    for (int i = 0; i < RATE_CLASS_COUNT; i++) {
+        uint32_t cap = rl->rules[i].burst * TOKEN;
+        uint64_t tokens = c->tokens[i] + (uint64_t)elapsed * rl->rules[i].per_minute;
+        c->tokens[i] = tokens > cap ? cap : (uint32_t)tokens;
+    }
+}
+
+bool rate_limit_allow(rate_limiter_t *rl, uint32_t key, rate_class_t cls, uint32_t now_ms,
+                      uint32_t *retry_after)
+{
+    const rate_limit_rule_t *rule = &rl->rules[cls];
+    if (rule->per_minute == 0) {
+        return true;
+    }
+
+    rate_limit_client_t *c = find_client(rl, key, now_ms);
+    refill(rl, c, now_ms);
+
+    if (c->tokens[cls] >= TOKEN) {
+        c->tokens[cls] -= TOKEN;
+        return true;
+    }
+
+    rl->rejected[cls]++;
+    if (retry_after != NULL) {
+        /* Time for the missing fraction of a request, rounded up to a second */
+        uint32_t wait_ms = (TOKEN - c->tokens[cls] + rule->per_minute - 1) / rule->per_minute;
+        *retry_after = (wait_ms + 999) / 1000;
+    }
+    return false;
+}
+
+const char *rate_limit_class_name(rate_class_t cls)
+{
+    return cls < RATE_CLASS_COUNT ? s_class_names[cls] : "unknown";
+}
@@ -0,0 +1,65 @@
+/**
+ * @file rate_limit.h
+ * @brief Per-client token buckets by endpoint class (host-testable)
+ *
+ * Each tracked client has one bucket per class, refilled continuously at
+ * the class rate up to its burst size. The table is small and fixed; when
+ * it is full the least recently seen client is forgotten. Not thread-safe.
+ */
+
+#ifndef RATE_LIMIT_H
+#define RATE_LIMIT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define RATE_LIMIT_CLIENTS 8
+
+typedef enum {
+    RATE_CLASS_READ = 0,    /**< GET requests */
+    RATE_CLASS_WRITE,       /**< Requests that change state */
+    RATE_CLASS_SCAN,        /**< Bus and WiFi scans */
+    RATE_CLASS_COUNT
+} rate_class_t;
+
+typedef struct {
+    uint32_t per_minute;    /**< Refill rate, 0 = unlimited */
+    uint32_t burst;         /**< Bucket size (up to 71582) */
+} rate_limit_rule_t;
+
+typedef struct {
+    uint32_t key;           /**< Client address (or hash of it) */
+    uint32_t last_ms;       /**< Last refill */
+    bool used;
+    uint32_t tokens[RATE_CLASS_COUNT];  /**< In 1/60000 of a request */
+} rate_limit_client_t;
+
+typedef struct {
+    rate_limit_rule_t rules[RATE_CLASS_COUNT];
+    rate_limit_client_t clients[RATE_LIMIT_CLIENTS];
+    uint32_t rejected[RATE_CLASS_COUNT];
+} rate_limiter_t;
+
+/**
+ * @brief Reset all buckets and counters
+ */
+void rate_limit_init(rate_limiter_t *rl, const rate_limit_rule_t rules[RATE_CLASS_COUNT]);
+
+/**
+ * @brief Take one token for a request
+ *
+ * @param key Client key
+ * @param cls Endpoint class
+ * @param now_ms Monotonic milliseconds (may wrap)
+ * @param retry_after Output: whole seconds until a token is available, set when rejected
+ * @return true if the request may proceed
+ */
+bool rate_limit_allow(rate_limiter_t *rl, uint32_t key, rate_class_t cls, uint32_t now_ms,
+                      uint32_t *retry_after);
+
+/**
+ * @brief Name of a class as reported by the API ("read", "write", "scan")
+ */
+const char *rate_limit_class_name(rate_class_t cls);
+
+#endif /* RATE_LIMIT_H */
@@ -6,14 +6,47 @@
 #include "sensor_manager.h"
 #include "nvs_storage.h"
 #include "mqtt_client_ha.h"
+#include "telemetry_cbor.h"
+#include "boot_monitor.h"
 #include "esp_log.h"
 #include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
 #include <string.h>
+#include <time.h>
 
 static const char *TAG = "sensor_mgr";
 
 static managed_sensor_t s_sensors[CONFIG_MAX_SENSORS];
 static int s_sensor_count = 0;
+static uint32_t s_sequence = 0;  /* Bumped on every change visible via the API */
+
+/* Rescans are serialized; s_rescan_count tells waiters a search finished meanwhile */
+static SemaphoreHandle_t s_rescan_lock = NULL;
+static uint32_t s_rescan_count = 0;
+static esp_err_t s_rescan_result = ESP_OK;
+static uint32_t s_rescans_coalesced = 0;
+
+/* Unix times before this mean the clock has not been set yet */
+#define VALID_EPOCH_MIN 1700000000
+
+static history_record_t s_history_buf[CONFIG_HISTORY_RECORDS];
+static history_t s_history;
+static SemaphoreHandle_t s_history_lock = NULL;
+static int64_t s_history_last_ms = 0;
+
+/* Bus conversion alone takes 94-750 ms depending on resolution */
+static const double s_cycle_bounds[] = { 0.1, 0.25, 0.5, 0.75, 1, 1.5, 2, 5 };
+static metrics_histogram_t s_cycle_hist = {
+    .bounds = s_cycle_bounds,
+    .bucket_count = sizeof(s_cycle_bounds) / sizeof(s_cycle_bounds[0]),
+};
+
+static void update_metric_labels(managed_sensor_t *sensor)
+{
+    metrics_format_sensor_labels(sensor->metric_labels, sizeof(sensor->metric_labels),
+                                 sensor->address_str, sensor->friendly_name);
+}
 
 /**
  * @brief Load friendly name from NVS for a sensor
@@ -32,12 +65,18 @@ static void load_friendly_name(managed_sensor_t *sensor)
         sensor->friendly_name[0] = '\0';
         sensor->has_friendly_name = false;
     }
+    update_metric_labels(sensor);
 }
 
 esp_err_t sensor_manager_init(void)
 {
     ESP_LOGD(TAG, "Initializing sensor manager");
     
+    if (s_rescan_lock == NULL) {
+        s_rescan_lock = xSemaphoreCreateMutex();
+        s_history_lock = xSemaphoreCreateMutex();
+        history_init(&s_history, s_history_buf, CONFIG_HISTORY_RECORDS);
+    }
     memset(s_sensors, 0, sizeof(s_sensors));
     s_sensor_count = 0;
 
@@ -59,12 +98,13 @@ esp_err_t sensor_manager_init(void)
     }
     
     s_sensor_count = found;
+    s_sequence++;
     ESP_LOGD(TAG, "Sensor manager initialized with %d sensors", s_sensor_count);
     
     return ESP_OK;
 }
 
-esp_err_t sensor_manager_rescan(void)
+static esp_err_t rescan_bus(void)
 {
     ESP_LOGD(TAG, "Rescanning for sensors...");
     
@@ -98,14 +138,68 @@ esp_err_t sensor_manager_rescan(void)
     }
     
     s_sensor_count = found;
+    s_sequence++;
     
     ESP_LOGD(TAG, "Rescan complete: %d sensors found", s_sensor_count);
     return ESP_OK;
 }
 
+esp_err_t sensor_manager_rescan(void)
+{
+    uint32_t seen = s_rescan_count;
+    xSemaphoreTake(s_rescan_lock, portMAX_DELAY);
+
+    esp_err_t err;
+    if (s_rescan_count != seen) {
+        /* The search in flight when we arrived has finished: share its result */
+        err = s_rescan_result;
+        s_rescans_coalesced++;
+        ESP_LOGD(TAG, "Rescan coalesced with the one in flight");
+    } else {
+        err = rescan_bus();
+        s_rescan_result = err;
+        s_rescan_count++;
+    }
+
+    xSemaphoreGive(s_rescan_lock);
+    return err;
+}
+
+/**
+ * @brief Record the current readings if the history interval has passed
+ */
+static void record_history(void)
+{
+    int64_t now_ms = esp_timer_get_time() / 1000;
+    if (s_history_last_ms != 0 && now_ms - s_history_last_ms < CONFIG_HISTORY_INTERVAL_S * 1000LL) {
+        return;
+    }
+    s_history_last_ms = now_ms;
+    time_t now = time(NULL);
+
+    xSemaphoreTake(s_history_lock, portMAX_DELAY);
+    for (int i = 0; i < s_sensor_count; i++) {
+        const onewire_sensor_t *hw = &s_sensors[i].hw_sensor;
+        if (!hw->valid) {
+            continue;
+        }
+        history_record_t rec = {
+            .uptime_s = (uint32_t)(hw->last_read_time / 1000),
+            .temp_centi = (int16_t)telemetry_temp_to_centi(hw->temperature),
+        };
+        if (now >= VALID_EPOCH_MIN) {
+            rec.timestamp = (uint32_t)(now - (now_ms - hw->last_read_time) / 1000);
+        }
+        memcpy(rec.address, hw->address, sizeof(rec.address));
+        history_push(&s_history, &rec);
+    }
+    xSemaphoreGive(s_history_lock);
+}
+
 esp_err_t sensor_manager_read_all(void)
 {
     if (s_sensor_count == 0) {
+        boot_monitor_cycle_done(0);
         return ESP_OK;
     }
 
@@ -121,8 +215,10 @@ esp_err_t sensor_manager_read_all(void)
     int64_t elapsed_ms = (esp_timer_get_time() - start) / 1000;
     
     ESP_LOGI(TAG, "Read %d sensors in %lld ms", s_sensor_count, elapsed_ms);
+    metrics_histogram_observe(&s_cycle_hist, elapsed_ms / 1000.0);
     
     /* Copy back results */
+    int valid = 0;
     for (int i = 0; i < s_sensor_count; i++) {
         s_sensors[i].hw_sensor.temperature = hw_sensors[i].temperature;
         s_sensors[i].hw_sensor.valid = hw_sensors[i].valid;
@@ -134,8 +230,12 @@ esp_err_t sensor_manager_read_all(void)
             const char *name = s_sensors[i].has_friendly_name ? 
                                s_sensors[i].friendly_name : s_sensors[i].address_str;
             ESP_LOGD(TAG, "%s: %.2f°C", name, hw_sensors[i].temperature);
+            valid++;
         }
     }
+    s_sequence++;
+    record_history();
+    boot_monitor_cycle_done(valid);
 
     return err;
 }
@@ -144,6 +244,7 @@ esp_err_t sensor_manager_publish_all(void)
 {
     int64_t start = esp_timer_get_time();
     int published = 0;
+    int buffered = 0;
     
     for (int i = 0; i < s_sensor_count; i++) {
         if (s_sensors[i].hw_sensor.valid) {
@@ -154,10 +255,26 @@ esp_err_t sensor_manager_publish_all(void)
                                             name,
                                             s_sensors[i].hw_sensor.temperature) == ESP_OK) {
                 published++;
+            } else if (mqtt_ha_buffer_temperature(s_sensors[i].hw_sensor.address,
+                                                  s_sensors[i].hw_sensor.temperature,
+                                                  s_sensors[i].hw_sensor.last_read_time) == ESP_OK) {
+                /* Broker unreachable: keep the reading for replay */
+                buffered++;
             }
         }
     }
     
+    if (published > 0) {
+        boot_monitor_published();
+    }
+    if (buffered > 0) {
+        ESP_LOGI(TAG, "Buffered %d readings while MQTT is offline", buffered);
+        return ESP_OK;
+    }
+
+    /* Compact batch for non-HA collectors (when enabled) */
+    mqtt_ha_publish_telemetry();
+
     /* Also publish diagnostic data (network status) */
     mqtt_ha_publish_diagnostics();
     
@@ -188,6 +305,8 @@ esp_err_t sensor_manager_set_friendly_name(const char *address_str, const char *
             strncpy(s_sensors[i].friendly_name, friendly_name, MAX_FRIENDLY_NAME_LEN - 1);
             s_sensors[i].friendly_name[MAX_FRIENDLY_NAME_LEN - 1] = '\0';
             s_sensors[i].has_friendly_name = (strlen(friendly_name) > 0);
+            update_metric_labels(&s_sensors[i]);
+            s_sequence++;
             
             ESP_LOGI(TAG, "Set friendly name for %s: %s", address_str, friendly_name);
             
@@ -227,6 +346,43 @@ const managed_sensor_t* sensor_manager_get_sensor(const char *address_str)
     return NULL;
 }
 
+void sensor_manager_get_cycle_histogram(metrics_histogram_t *out)
+{
+    *out = s_cycle_hist;
+}
+
+uint32_t sensor_manager_get_rescans_coalesced(void)
+{
+    return s_rescans_coalesced;
+}
+
+size_t sensor_manager_history_read(uint32_t *cursor, history_record_t *out, size_t max)
+{
+    if (s_history_lock == NULL) {
+        return 0;
+    }
+    xSemaphoreTake(s_history_lock, portMAX_DELAY);
+    size_t n = history_read(&s_history, cursor, out, max);
+    xSemaphoreGive(s_history_lock);
+
+    /* History is RAM-only, so every record is from this boot */
+    time_t now = time(NULL);
+    if (now >= VALID_EPOCH_MIN) {
+        uint32_t uptime_s = (uint32_t)(esp_timer_get_time() / 1000000);
+        for (size_t i = 0; i < n; i++) {
+            if (out[i].timestamp == 0) {
+                out[i].timestamp = (uint32_t)now - (uptime_s - out[i].uptime_s);
+            }
+        }
+    }
+    return n;
+}
+
+uint32_t sensor_manager_get_sequence(void)
+{
+    return s_sequence;
+}
+
 int sensor_manager_get_count(void)
 {
     return s_sensor_count;
@@ -238,6 +394,7 @@ void sensor_manager_reset_all_error_stats(void)
         s_sensors[i].hw_sensor.total_reads = 0;
         s_sensors[i].hw_sensor.failed_reads = 0;
     }
+    s_sequence++;
     ESP_LOGI(TAG, "All per-sensor error stats reset");
 }
 
@@ -247,6 +404,7 @@ esp_err_t sensor_manager_reset_sensor_error_stats(const char *address_str)
         if (strcmp(s_sensors[i].address_str, address_str) == 0) {
             s_sensors[i].hw_sensor.total_reads = 0;
             s_sensors[i].hw_sensor.failed_reads = 0;
+            s_sequence++;
             ESP_LOGI(TAG, "Error stats reset for %s", address_str);
             return ESP_OK;
         }
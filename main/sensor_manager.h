@@ -8,7 +8,10 @@
 
 #include "esp_err.h"
 #include "onewire_temp.h"
+#include "metrics_writer.h"
+#include "history.h"
 #include <stdbool.h>
+#include <stdint.h>
 
 #define MAX_FRIENDLY_NAME_LEN 32
 
@@ -20,6 +23,7 @@ typedef struct {
     char friendly_name[MAX_FRIENDLY_NAME_LEN]; /**< User-assigned friendly name */
     bool has_friendly_name;                    /**< True if friendly name is set */
     char address_str[17];                      /**< Address as hex string */
+    char metric_labels[METRICS_LABELS_MAX];    /**< Prometheus label set, rebuilt on rename */
 } managed_sensor_t;
 
 /**
@@ -29,6 +33,9 @@ esp_err_t sensor_manager_init(void);
 
 /**
  * @brief Re-scan for sensors (hot-plug support)
+ *
+ * Callers arriving while a search is running wait for it and return its
+ * result instead of starting another one.
  */
 esp_err_t sensor_manager_rescan(void);
 
@@ -39,6 +46,9 @@ esp_err_t sensor_manager_read_all(void);
 
 /**
  * @brief Publish all sensor readings via MQTT
+ *
+ * Readings that cannot be published (broker unreachable) are queued in the
+ * MQTT offline buffer for later replay.
  */
 esp_err_t sensor_manager_publish_all(void);
 
@@ -68,6 +78,35 @@ const char* sensor_manager_get_display_name(const char *address_str);
  */
 const managed_sensor_t* sensor_manager_get_sensor(const char *address_str);
 
+/**
+ * @brief Sequence number of the sensor data
+ *
+ * Incremented after every acquisition cycle and whenever the sensor list,
+ * a friendly name or error stats change. Starts at 0 on every boot.
+ */
+uint32_t sensor_manager_get_sequence(void);
+
+/**
+ * @brief Copy the acquisition cycle duration histogram (seconds)
+ */
+void sensor_manager_get_cycle_histogram(metrics_histogram_t *out);
+
+/**
+ * @brief Number of rescan calls answered by a search already in flight
+ */
+uint32_t sensor_manager_get_rescans_coalesced(void);
+
+/**
+ * @brief Copy recorded history from a cursor position, oldest first
+ *
+ * One reading per sensor is recorded every CONFIG_HISTORY_INTERVAL_S.
+ * Readings taken before the clock was set get their Unix time derived
+ * from uptime once it is. See history_read() for the cursor semantics.
+ *
+ * @return Number of records copied
+ */
+size_t sensor_manager_history_read(uint32_t *cursor, history_record_t *out, size_t max);
+
 /**
  * @brief Get number of sensors
  */
@@ -0,0 +1,192 @@
+/**
+ * @file store_forward.c
+ * @brief Bounded store-and-forward queue for readings (host-testable)
+ */
+
+#include "store_forward.h"
+#include <string.h>
+
+static uint32_t segment_count(const store_forward_t *q)
+{
+    return q->seg_tail - q->seg_head;
+}
+
+static void save_range(store_forward_t *q)
+{
+    const store_forward_storage_t *s = q->cfg.storage;
+    s->save_range(s->ctx, q->seg_head, q->seg_tail);
+}
+
+/**
+ * @brief Discard the oldest flash segment (fully consumed or dropped)
+ */
+static void release_head_segment(store_forward_t *q)
+{
+    const store_forward_storage_t *s = q->cfg.storage;
+    s->erase_segment(s->ctx, q->seg_head);
+    q->seg_head++;
+    q->replay_loaded = false;
+    q->replay_pos = 0;
+    q->replay_count = 0;
+    save_range(q);
+}
+
+/**
+ * @brief Make room in flash by dropping the oldest segment
+ */
+static void drop_head_segment(store_forward_t *q)
+{
+    if (q->replay_loaded) {
+        q->dropped += q->replay_count - q->replay_pos;
+    } else {
+        q->dropped += q->cfg.segment_records;
+    }
+    release_head_segment(q);
+}
+
+/**
+ * @brief Move the oldest segment_records RAM records to a new flash segment
+ */
+static void spill_oldest(store_forward_t *q)
+{
+    const store_forward_storage_t *s = q->cfg.storage;
+    size_t n = q->cfg.segment_records;
+
+    for (size_t i = 0; i < n; i++) {
+        q->cfg.spill_buf[i] = q->cfg.ram[(q->ram_head + i) % q->cfg.ram_capacity];
+    }
+    q->ram_head = (q->ram_head + n) % q->cfg.ram_capacity;
+    q->ram_count -= n;
+
+    if (segment_count(q) >= q->cfg.max_segments) {
+        drop_head_segment(q);
+    }
+
+    if (s->write_segment(s->ctx, q->seg_tail, q->cfg.spill_buf, n) != 0) {
+        q->dropped += n;
+        return;
+    }
+    q->seg_tail++;
+    save_range(q);
+}
+
+int store_forward_init(store_forward_t *q, const store_forward_config_t *cfg)
+{
+    memset(q, 0, sizeof(*q));
+
+    if (cfg->ram == NULL || cfg->ram_capacity == 0) {
+        return -1;
+    }
+    if (cfg->storage != NULL &&
+        (cfg->spill_buf == NULL || cfg->replay_buf == NULL || cfg->segment_records == 0 ||
+         cfg->segment_records > cfg->ram_capacity || cfg->max_segments == 0)) {
+        return -1;
+    }
+    q->cfg = *cfg;
+
+    if (cfg->storage != NULL) {
+        uint32_t head = 0, tail = 0;
+        if (cfg->storage->load_range(cfg->storage->ctx, &head, &tail) == 0 &&
+            tail - head <= cfg->max_segments) {
+            q->seg_head = head;
+            q->seg_tail = tail;
+        }
+        q->boot_seq = q->seg_tail;
+    }
+    return 0;
+}
+
+void store_forward_push(store_forward_t *q, const store_forward_record_t *record)
+{
+    q->captured++;
+
+    if (q->ram_count == q->cfg.ram_capacity) {
+        if (q->cfg.storage != NULL) {
+            spill_oldest(q);
+        } else {
+            /* RAM only: overwrite the oldest record */
+            q->ram_head = (q->ram_head + 1) % q->cfg.ram_capacity;
+            q->ram_count--;
+            q->dropped++;
+        }
+    }
+
+    store_forward_record_t *slot = &q->cfg.ram[(q->ram_head + q->ram_count) % q->cfg.ram_capacity];
+    *slot = *record;
+    slot->flags &= ~STORE_FORWARD_FLAG_PREVIOUS_BOOT;
+    q->ram_count++;
+}
+
+int store_forward_peek(store_forward_t *q, store_forward_record_t *record)
+{
+    const store_forward_storage_t *s = q->cfg.storage;
+
+    /* Flash segments hold the oldest records */
+    while (segment_count(q) > 0 && !q->replay_loaded) {
+        size_t count = 0;
+        if (s->read_segment(s->ctx, q->seg_head, q->cfg.replay_buf,
+                            q->cfg.segment_records, &count) != 0 || count == 0) {
+            q->dropped += q->cfg.segment_records;
+            release_head_segment(q);
+            continue;
+        }
+        if ((int32_t)(q->boot_seq - q->seg_head) > 0) {
+            for (size_t i = 0; i < count; i++) {
+                q->cfg.replay_buf[i].flags |= STORE_FORWARD_FLAG_PREVIOUS_BOOT;
+            }
+        }
+        q->replay_loaded = true;
+        q->replay_pos = 0;
+        q->replay_count = count;
+    }
+
+    if (q->replay_loaded) {
+        *record = q->cfg.replay_buf[q->replay_pos];
+        return 0;
+    }
+
+    if (q->ram_count > 0) {
+        *record = q->cfg.ram[q->ram_head];
+        return 0;
+    }
+    return -1;
+}
+
+void store_forward_pop(store_forward_t *q)
+{
+    if (segment_count(q) > 0 && !q->replay_loaded) {
+        store_forward_record_t unused;
+        store_forward_peek(q, &unused);
+    }
+
+    if (q->replay_loaded) {
+        q->replayed++;
+        if (++q->replay_pos >= q->replay_count) {
+            release_head_segment(q);
+        }
+        return;
+    }
+
+    if (q->ram_count > 0) {
+        q->replayed++;
+        q->ram_head = (q->ram_head + 1) % q->cfg.ram_capacity;
+        q->ram_count--;
+    }
+}
+
+uint32_t store_forward_flash_depth(const store_forward_t *q)
+{
+    uint32_t segments = segment_count(q);
+    if (segments == 0) {
+        return 0;
+    }
+    if (q->replay_loaded) {
+        return (segments - 1) * q->cfg.segment_records + (q->replay_count - q->replay_pos);
+    }
+    return segments * q->cfg.segment_records;
+}
+
+uint32_t store_forward_depth(const store_forward_t *q)
+{
+    return q->ram_count + store_forward_flash_depth(q);
+}
@@ -0,0 +1,114 @@
+/**
+ * @file store_forward.h
+ * @brief Bounded store-and-forward queue for readings (host-testable)
+ *
+ * Readings captured while the broker is unreachable are queued in a RAM ring.
+ * When the ring fills, its oldest records are spilled to flash in fixed-size
+ * segments through a storage backend. Replay is oldest-first: flash segments
+ * are drained before the RAM ring. When flash is full too, the oldest segment
+ * is dropped so the newest readings always survive.
+ *
+ * The queue itself is not thread-safe; callers serialize access.
+ */
+
+#ifndef STORE_FORWARD_H
+#define STORE_FORWARD_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/** @brief Record was stored before the current boot (uptime_s is not comparable) */
+#define STORE_FORWARD_FLAG_PREVIOUS_BOOT 0x0001
+
+/**
+ * @brief Buffered reading (fixed size, stored verbatim in flash)
+ */
+typedef struct {
+    uint32_t timestamp;     /**< Unix time in seconds, 0 if the clock was not set */
+    uint32_t uptime_s;      /**< Seconds since boot when sampled */
+    uint8_t address[8];     /**< Sensor ROM address */
+    int16_t temp_centi;     /**< Temperature in 1/100 °C */
+    uint16_t flags;         /**< STORE_FORWARD_FLAG_* */
+} store_forward_record_t;
+
+/**
+ * @brief Flash backend for spilled segments
+ *
+ * Segments are addressed by a monotonically increasing sequence number; the
+ * live range [head, tail) is persisted with save_range. All callbacks return
+ * 0 on success.
+ */
+typedef struct {
+    int (*load_range)(void *ctx, uint32_t *head, uint32_t *tail);
+    int (*save_range)(void *ctx, uint32_t head, uint32_t tail);
+    int (*write_segment)(void *ctx, uint32_t seq, const store_forward_record_t *records, size_t count);
+    int (*read_segment)(void *ctx, uint32_t seq, store_forward_record_t *records, size_t max, size_t *count);
+    int (*erase_segment)(void *ctx, uint32_t seq);
+    void *ctx;
+} store_forward_storage_t;
+
+/**
+ * @brief Queue configuration (all buffers are caller-owned)
+ */
+typedef struct {
+    store_forward_record_t *ram;         /**< RAM ring storage */
+    size_t ram_capacity;                 /**< Records in RAM ring (>= segment_records) */
+    store_forward_record_t *spill_buf;   /**< segment_records scratch for spilling */
+    store_forward_record_t *replay_buf;  /**< segment_records buffer for flash replay */
+    size_t segment_records;              /**< Records per flash segment */
+    uint32_t max_segments;               /**< Flash segments kept before dropping oldest */
+    const store_forward_storage_t *storage;  /**< Flash backend, or NULL for RAM only */
+} store_forward_config_t;
+
+/**
+ * @brief Queue state
+ */
+typedef struct {
+    store_forward_config_t cfg;
+    size_t ram_head;         /**< Index of oldest RAM record */
+    size_t ram_count;        /**< Records in RAM */
+    uint32_t seg_head;       /**< Oldest flash segment */
+    uint32_t seg_tail;       /**< Next flash segment to write */
+    uint32_t boot_seq;       /**< Segments below this predate the current boot */
+    size_t replay_pos;       /**< Next record in replay_buf */
+    size_t replay_count;     /**< Records loaded in replay_buf */
+    bool replay_loaded;      /**< replay_buf holds segment seg_head */
+    uint32_t captured;       /**< Records pushed */
+    uint32_t dropped;        /**< Records lost to overflow or flash errors */
+    uint32_t replayed;       /**< Records popped */
+} store_forward_t;
+
+/**
+ * @brief Initialize the queue and pick up segments left in flash
+ * @return 0 on success, -1 on invalid configuration
+ */
+int store_forward_init(store_forward_t *q, const store_forward_config_t *cfg);
+
+/**
+ * @brief Queue a record, spilling or dropping the oldest records when full
+ */
+void store_forward_push(store_forward_t *q, const store_forward_record_t *record);
+
+/**
+ * @brief Copy the oldest record without removing it
+ * @return 0 if a record was returned, -1 if the queue is empty
+ */
+int store_forward_peek(store_forward_t *q, store_forward_record_t *record);
+
+/**
+ * @brief Remove the record returned by the last store_forward_peek()
+ */
+void store_forward_pop(store_forward_t *q);
+
+/**
+ * @brief Records waiting for replay (RAM + flash)
+ */
+uint32_t store_forward_depth(const store_forward_t *q);
+
+/**
+ * @brief Records currently held in flash segments
+ */
+uint32_t store_forward_flash_depth(const store_forward_t *q);
+
+#endif /* STORE_FORWARD_H */
@@ -0,0 +1,75 @@
+/**
+ * @file telemetry_cbor.c
+ * @brief Compact CBOR telemetry batch schema (host-testable)
+ */
+
+#include "telemetry_cbor.h"
+
+uint64_t telemetry_rom_to_id(const uint8_t rom[8])
+{
+    uint64_t id = 0;
+    for (int i = 0; i < 8; i++) {
+        id = (id << 8) | rom[i];
+    }
+    return id;
+}
+
+void telemetry_id_to_rom(uint64_t id, uint8_t rom[8])
+{
+    for (int i = 7; i >= 0; i--) {
+        rom[i] = (uint8_t)id;
+        id >>= 8;
+    }
+}
+
+int32_t telemetry_temp_to_centi(float temperature)
+{
+    return (int32_t)(temperature * 100.0f + (temperature < 0 ? -0.5f : 0.5f));
+}
+
+static void begin_header(cbor_writer_t *w, uint32_t timestamp)
+{
+    cbor_writer_map(w, 3);
+    cbor_writer_uint(w, TELEMETRY_CBOR_KEY_VERSION);
+    cbor_writer_uint(w, TELEMETRY_CBOR_VERSION);
+    cbor_writer_uint(w, TELEMETRY_CBOR_KEY_TIME);
+    cbor_writer_uint(w, timestamp);
+    cbor_writer_uint(w, TELEMETRY_CBOR_KEY_READINGS);
+}
+
+void telemetry_cbor_begin(cbor_writer_t *w, uint32_t timestamp, size_t count)
+{
+    begin_header(w, timestamp);
+    cbor_writer_array(w, count);
+}
+
+void telemetry_cbor_begin_stream(cbor_writer_t *w, uint32_t timestamp)
+{
+    begin_header(w, timestamp);
+    cbor_writer_array_indefinite(w);
+}
+
+void telemetry_cbor_end_stream(cbor_writer_t *w)
+{
+    cbor_writer_break(w);
+}
+
+void telemetry_cbor_add(cbor_writer_t *w, const telemetry_reading_t *reading)
+{
+    cbor_writer_array(w, 3);
+    cbor_writer_uint(w, telemetry_rom_to_id(reading->rom));
+    cbor_writer_int(w, reading->temp_centi);
+    cbor_writer_uint(w, reading->timestamp);
+}
+
+int telemetry_cbor_encode(uint8_t *buf, size_t size, uint32_t timestamp,
+                          const telemetry_reading_t *readings, size_t count)
+{
+    cbor_writer_t w;
+    cbor_writer_init(&w, buf, size);
+    telemetry_cbor_begin(&w, timestamp, count);
+    for (size_t i = 0; i < count; i++) {
+        telemetry_cbor_add(&w, &readings[i]);
+    }
+    return cbor_writer_finish(&w);
+}
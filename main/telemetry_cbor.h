@@ -0,0 +1,97 @@
+/**
+ * @file telemetry_cbor.h
+ * @brief Compact CBOR telemetry batch schema (host-testable)
+ *
+ * One batch carries every reading of a publish cycle:
+ *
+ *   {
+ *     0: 1,                           ; schema version
+ *     1: uint,                        ; batch time, Unix seconds (0 = clock not synced)
+ *     2: [ [rom, temp, time], ... ]   ; readings
+ *   }
+ *
+ * A streamed batch (history export) has an indefinite-length readings
+ * array, since the count is not known when the header goes out.
+ *
+ * rom  - 64-bit sensor ROM id as an unsigned integer; its big-endian bytes
+ *        are the 1-Wire address in bus order (hex equals the address string)
+ * temp - temperature in hundredths of a degree Celsius (signed)
+ * time - sample time, Unix seconds (0 = unknown)
+ */
+
+#ifndef TELEMETRY_CBOR_H
+#define TELEMETRY_CBOR_H
+
+#include "cbor_writer.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#define TELEMETRY_CBOR_VERSION 1
+
+/** @brief Map keys */
+#define TELEMETRY_CBOR_KEY_VERSION  0
+#define TELEMETRY_CBOR_KEY_TIME     1
+#define TELEMETRY_CBOR_KEY_READINGS 2
+
+/** @brief Batch header and per-reading worst-case sizes, for sizing buffers */
+#define TELEMETRY_CBOR_HEADER_MAX  (1 + 1 + 1 + 1 + 5 + 1 + CBOR_MAX_HEAD_SIZE)
+#define TELEMETRY_CBOR_READING_MAX (1 + 9 + 5 + 5)
+
+/** @brief Header of a streamed batch (indefinite-length readings array) */
+#define TELEMETRY_CBOR_STREAM_HEADER_MAX (1 + 1 + 1 + 1 + 5 + 1 + 1)
+
+/** @brief Buffer size for a batch of n readings */
+#define TELEMETRY_CBOR_BATCH_SIZE(n) (TELEMETRY_CBOR_HEADER_MAX + (n) * TELEMETRY_CBOR_READING_MAX)
+
+/**
+ * @brief One reading
+ */
+typedef struct {
+    uint8_t rom[8];         /**< 1-Wire ROM address */
+    int32_t temp_centi;     /**< Temperature in 0.01 °C */
+    uint32_t timestamp;     /**< Unix seconds, 0 if unknown */
+} telemetry_reading_t;
+
+/**
+ * @brief Convert a ROM address to its 64-bit id
+ */
+uint64_t telemetry_rom_to_id(const uint8_t rom[8]);
+
+/**
+ * @brief Convert a 64-bit id back to a ROM address
+ */
+void telemetry_id_to_rom(uint64_t id, uint8_t rom[8]);
+
+/**
+ * @brief Round a temperature to fixed point (0.01 °C)
+ */
+int32_t telemetry_temp_to_centi(float temperature);
+
+/**
+ * @brief Start a batch; exactly count readings must follow
+ */
+void telemetry_cbor_begin(cbor_writer_t *w, uint32_t timestamp, size_t count);
+
+/**
+ * @brief Start a batch of a count not known yet; end it with telemetry_cbor_end_stream()
+ */
+void telemetry_cbor_begin_stream(cbor_writer_t *w, uint32_t timestamp);
+
+/**
+ * @brief Close the readings array of a streamed batch
+ */
+void telemetry_cbor_end_stream(cbor_writer_t *w);
+
+/**
+ * @brief Append one reading to the batch
+ */
+void telemetry_cbor_add(cbor_writer_t *w, const telemetry_reading_t *reading);
+
+/**
+ * @brief Encode a complete batch
+ * @return Encoded length, or -1 if the buffer is too small
+ */
+int telemetry_cbor_encode(uint8_t *buf, size_t size, uint32_t timestamp,
+                          const telemetry_reading_t *readings, size_t count);
+
+#endif /* TELEMETRY_CBOR_H */
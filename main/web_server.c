@@ -11,16 +11,36 @@
 #include "wifi_manager.h"
 #include "ethernet_manager.h"
 #include "log_buffer.h"
+#include "log_filter.h"
+#include "mqtt_client_ha.h"
+#include "json_writer.h"
+#include "ws_protocol.h"
+#include "http_etag.h"
+#include "dashboard.h"
+#include "metrics_writer.h"
+#include "auth_session.h"
+#include "rate_limit.h"
+#include "history_export.h"
+#include "ota_writer.h"
+#include "boot_monitor.h"
+#include "gunzip.h"
+#include "telemetry_cbor.h"
 #include "esp_http_server.h"
 #include "esp_log.h"
 #include "esp_system.h"
 #include "esp_ota_ops.h"
+#include "esp_image_format.h"
 #include "esp_wifi.h"
 #include "cJSON.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "lwip/sockets.h"
 #include <string.h>
 #include <stdlib.h>
+#include <errno.h>
+#include <time.h>
 #include "esp_random.h"
 #include "esp_timer.h"
 
@@ -31,21 +51,25 @@
 static const char *TAG = "web_server";
 static httpd_handle_t s_server = NULL;
 
+#define MAX_URI_HANDLERS 44
+
 /* Auth credentials cache (loaded from NVS at startup) */
 static bool s_auth_enabled = false;
 static char s_auth_username[33] = "";
 static char s_auth_password[65] = "";
 
-/* Session management - supports multiple concurrent sessions */
-#define MAX_SESSIONS 4
+/* Session management - random tokens in a hashed table, or signed tokens
+   that need no table (CONFIG_WEB_AUTH_SIGNED_SESSIONS) */
 #define SESSION_TIMEOUT_MS (7LL * 24 * 60 * 60 * 1000)  /* 7 days */
 
-typedef struct {
-    char token[33];      /* Random hex token */
-    int64_t expiry;      /* Expiry time (ms since boot) */
-} session_t;
-
-static session_t s_sessions[MAX_SESSIONS] = {0};
+#if CONFIG_WEB_AUTH_SIGNED_SESSIONS
+static uint8_t s_session_key[AUTH_SIGNING_KEY_SIZE];  /* Per boot, set in web_server_start */
+#else
+/* Checked from the httpd task and the async workers; lookups also drop
+   expired entries, so every access takes the lock */
+static auth_sessions_t s_sessions;
+static portMUX_TYPE s_sessions_lock = portMUX_INITIALIZER_UNLOCKED;
+#endif
 
 /* API key for stateless API access */
 static char s_api_key[65] = "";  /* 32 hex chars (128-bit key) */
@@ -100,300 +124,1489 @@ static void load_auth_config(void)
 }
 
 /**
- * @brief Generate a random session token and store in an available slot
- * @return Pointer to the token string (valid until session expires/replaced)
+ * @brief Create a session
+ * @param token Output: cookie value, AUTH_TOKEN_BUF_SIZE bytes
+ */
+static void create_session(char *token)
+{
+    int64_t now = esp_timer_get_time() / 1000;
+
+#if CONFIG_WEB_AUTH_SIGNED_SESSIONS
+    /* Expiry in seconds since boot; the key changes on every boot */
+    auth_token_sign(s_session_key, (uint32_t)((now + SESSION_TIMEOUT_MS) / 1000), token);
+#else
+    uint32_t rnd[4];
+    for (int i = 0; i < 4; i++) {
+        rnd[i] = esp_random();
+    }
+    snprintf(token, AUTH_TOKEN_BUF_SIZE, "%08lx%08lx%08lx%08lx",
+             (unsigned long)rnd[0], (unsigned long)rnd[1],
+             (unsigned long)rnd[2], (unsigned long)rnd[3]);
+    portENTER_CRITICAL(&s_sessions_lock);
+    auth_sessions_add(&s_sessions, token, now + SESSION_TIMEOUT_MS, now);
+    portEXIT_CRITICAL(&s_sessions_lock);
+#endif
+    ESP_LOGD(TAG, "Created session");
+}
+
+/**
+ * @brief Generate a random API key (256-bit)
+ */
+static void generate_api_key(void)
+{
+    uint32_t rnd[8];
+    for (int i = 0; i < 8; i++) {
+        rnd[i] = esp_random();
+    }
+    snprintf(s_api_key, sizeof(s_api_key), 
+             "%08lx%08lx%08lx%08lx%08lx%08lx%08lx%08lx",
+             (unsigned long)rnd[0], (unsigned long)rnd[1], 
+             (unsigned long)rnd[2], (unsigned long)rnd[3],
+             (unsigned long)rnd[4], (unsigned long)rnd[5],
+             (unsigned long)rnd[6], (unsigned long)rnd[7]);
+}
+
+/**
+ * @brief Read the session cookie into token (AUTH_TOKEN_BUF_SIZE bytes)
+ *
+ * Kept out of line so the header buffer is only on the stack while the
+ * cookie is parsed, not for the rest of the calling handler.
+ */
+static __attribute__((noinline)) bool get_session_cookie(httpd_req_t *req, char *token)
+{
+    /* The whole header, since other cookies can put the session one
+       anywhere in it. httpd never accepts a header line longer than
+       this; a truncated copy is rejected rather than parsed. */
+    char cookie[CONFIG_HTTPD_MAX_REQ_HDR_LEN + 1];
+    return httpd_req_get_hdr_value_str(req, "Cookie", cookie, sizeof(cookie)) == ESP_OK &&
+           auth_cookie_value(cookie, "session", token, AUTH_TOKEN_BUF_SIZE) > 0;
+}
+
+/**
+ * @brief Check if session token from cookie is valid
+ */
+static bool is_session_valid(httpd_req_t *req)
+{
+    char token[AUTH_TOKEN_BUF_SIZE];
+    if (!get_session_cookie(req, token)) {
+        return false;
+    }
+
+    int64_t now = esp_timer_get_time() / 1000;
+#if CONFIG_WEB_AUTH_SIGNED_SESSIONS
+    return auth_token_verify(s_session_key, token, (uint32_t)(now / 1000));
+#else
+    portENTER_CRITICAL(&s_sessions_lock);
+    bool valid = auth_sessions_check(&s_sessions, token, now);
+    portEXIT_CRITICAL(&s_sessions_lock);
+    return valid;
+#endif
+}
+
+/**
+ * @brief Redirect to login page
+ */
+static void redirect_to_login(httpd_req_t *req)
+{
+    httpd_resp_set_status(req, "302 Found");
+    httpd_resp_set_hdr(req, "Location", "/login");
+    httpd_resp_send(req, NULL, 0);
+}
+
+/**
+ * @brief Check session auth - redirects to login if unauthorized
+ * @return true if authorized (or auth disabled), false if redirect sent
+ */
+static bool check_session_auth(httpd_req_t *req)
+{
+    if (!s_auth_enabled) {
+        return true;  /* Auth disabled, allow all */
+    }
+
+    if (is_session_valid(req)) {
+        return true;  /* Valid session */
+    }
+
+    redirect_to_login(req);
+    return false;
+}
+
+/**
+ * @brief Check if API key from header is valid
+ */
+static bool is_api_key_valid(httpd_req_t *req)
+{
+    /* One spare byte: a longer header comes back truncated and is rejected */
+    char key[sizeof(s_api_key) + 1];
+    if (httpd_req_get_hdr_value_str(req, "X-API-Key", key, sizeof(key)) != ESP_OK) {
+        return false;
+    }
+    return auth_secret_equal(key, s_api_key);
+}
+
+/**
+ * @brief Check API key or session cookie without sending a response
+ * @return true if authorized (or auth disabled)
+ */
+static bool is_request_authorized(httpd_req_t *req)
+{
+    if (!s_auth_enabled) {
+        return true;
+    }
+
+    /* Check API key first (stateless auth), then fall back to session cookie */
+    return is_api_key_valid(req) || is_session_valid(req);
+}
+
+/**
+ * @brief Check session auth for API calls - returns 401 JSON instead of redirect
+ * Checks both session cookie and X-API-Key header
+ * @return true if authorized (or auth disabled), false if 401 sent
+ */
+static bool check_api_auth(httpd_req_t *req)
+{
+    if (is_request_authorized(req)) {
+        return true;
+    }
+
+    httpd_resp_set_status(req, "401 Unauthorized");
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_sendstr(req, "{\"error\":\"Unauthorized\",\"login_required\":true}");
+    return false;
+}
+
+/* Macro to check auth at start of handler - returns ESP_OK if unauthorized (response already sent) */
+#define CHECK_AUTH(req) do { if (!check_api_auth(req)) return ESP_OK; } while(0)
+#define CHECK_PAGE_AUTH(req) do { if (!check_session_auth(req)) return ESP_OK; } while(0)
+
+/* Streamed JSON responses: documents that fit in the buffer are sent with
+   Content-Length, larger ones fall back to chunked transfer encoding.
+   Only used from the httpd task, so a single static buffer is sufficient. */
+#define JSON_RESP_BUF_SIZE 1024
+static char s_json_resp_buf[JSON_RESP_BUF_SIZE];
+
+static int json_resp_sink(void *ctx, const char *data, size_t len)
+{
+    return httpd_resp_send_chunk((httpd_req_t *)ctx, data, len) == ESP_OK ? 0 : -1;
+}
+
+/**
+ * @brief Start a streamed JSON response
+ */
+static void json_resp_begin(json_writer_t *w, httpd_req_t *req)
+{
+    httpd_resp_set_type(req, "application/json");
+    json_writer_init(w, s_json_resp_buf, sizeof(s_json_resp_buf), json_resp_sink, req);
+}
+
+/**
+ * @brief Complete a streamed JSON response
+ */
+static esp_err_t json_resp_end(json_writer_t *w, httpd_req_t *req)
+{
+    if (!w->error && w->flushed == 0 && w->depth == 0) {
+        /* Whole document is still buffered - send it in one piece */
+        return httpd_resp_send(req, w->buf, w->len);
+    }
+
+    if (json_writer_finish(w) < 0) {
+        ESP_LOGE(TAG, "Failed to stream JSON response for %s", req->uri);
+        if (w->flushed == 0) {
+            httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Response too large");
+        }
+        return ESP_FAIL;  /* Closes the connection if a partial body went out */
+    }
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+/* ===== Async request workers ===== */
+
+/* Handlers that block for seconds (WiFi scan, rescan, firmware upload) run
+   on these tasks so the server task keeps answering other requests.
+   Handlers run here must not use s_json_resp_buf. */
+#define ASYNC_WORKERS 2
+#define ASYNC_WORKER_STACK_SIZE 6144
+#define ASYNC_WORKER_PRIORITY 4    /* Below the server task (5) */
+
+typedef esp_err_t (*async_handler_t)(httpd_req_t *req);
+
+typedef struct {
+    httpd_req_t *req;           /* Copy from httpd_req_async_handler_begin */
+    async_handler_t handler;
+} async_job_t;
+
+static QueueHandle_t s_async_queue = NULL;
+static SemaphoreHandle_t s_async_idle = NULL;   /* Counts idle workers */
+static TaskHandle_t s_async_workers[ASYNC_WORKERS];
+
+static bool on_async_worker(void)
+{
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    for (int i = 0; i < ASYNC_WORKERS; i++) {
+        if (s_async_workers[i] == self) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void async_worker_task(void *arg)
+{
+    async_job_t job;
+    for (;;) {
+        if (xQueueReceive(s_async_queue, &job, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+        job.handler(job.req);
+        httpd_req_async_handler_complete(job.req);
+        xSemaphoreGive(s_async_idle);
+    }
+}
+
+static void async_workers_init(void)
+{
+    if (s_async_queue != NULL) {
+        return;  /* Workers outlive server restarts */
+    }
+    s_async_queue = xQueueCreate(ASYNC_WORKERS, sizeof(async_job_t));
+    s_async_idle = xSemaphoreCreateCounting(ASYNC_WORKERS, ASYNC_WORKERS);
+    for (int i = 0; i < ASYNC_WORKERS; i++) {
+        xTaskCreate(async_worker_task, "httpd_async", ASYNC_WORKER_STACK_SIZE,
+                    NULL, ASYNC_WORKER_PRIORITY, &s_async_workers[i]);
+    }
+}
+
+/**
+ * @brief Hand a request to an idle worker
+ * @return ESP_OK if queued, ESP_FAIL if every worker is busy
+ */
+static esp_err_t async_submit(httpd_req_t *req, async_handler_t handler)
+{
+    if (s_async_idle == NULL || xSemaphoreTake(s_async_idle, 0) != pdTRUE) {
+        return ESP_FAIL;
+    }
+
+    async_job_t job = { .handler = handler };
+    if (httpd_req_async_handler_begin(req, &job.req) != ESP_OK) {
+        xSemaphoreGive(s_async_idle);
+        return ESP_FAIL;
+    }
+    /* Cannot be full: a worker was reserved above */
+    xQueueSend(s_async_queue, &job, 0);
+    return ESP_OK;
+}
+
+static esp_err_t timed_handler(httpd_req_t *req);
+
+/* Re-run the calling handler on a worker (unless already on one); answers
+   503 when all workers are busy. Use after CHECK_AUTH. */
+#define RUN_ASYNC(req) do { \
+        if (!on_async_worker()) { \
+            if (async_submit(req, timed_handler) != ESP_OK) { \
+                httpd_resp_set_status(req, "503 Service Unavailable"); \
+                httpd_resp_set_hdr(req, "Retry-After", "5"); \
+                httpd_resp_sendstr(req, "Server busy"); \
+            } \
+            return ESP_OK; \
+        } \
+    } while (0)
+
+/* ===== Per-client rate limiting ===== */
+
+/* Bucket sizes; the sustained rates come from Kconfig */
+#define RATE_BURST_READ 30
+#define RATE_BURST_WRITE 10
+#define RATE_BURST_SCAN 2
+
+/* Only used from the server task */
+static rate_limiter_t s_rate_limiter;
+
+static void rate_limit_setup(void)
+{
+    const rate_limit_rule_t rules[RATE_CLASS_COUNT] = {
+        [RATE_CLASS_READ]  = { CONFIG_WEB_RATE_LIMIT_READ_PER_MIN, RATE_BURST_READ },
+        [RATE_CLASS_WRITE] = { CONFIG_WEB_RATE_LIMIT_WRITE_PER_MIN, RATE_BURST_WRITE },
+        [RATE_CLASS_SCAN]  = { CONFIG_WEB_RATE_LIMIT_SCAN_PER_MIN, RATE_BURST_SCAN },
+    };
+    rate_limit_init(&s_rate_limiter, rules);
+}
+
+/**
+ * @brief Rate class of a URI; RATE_CLASS_COUNT for unlimited ones
+ */
+static rate_class_t endpoint_rate_class(const httpd_uri_t *uri)
+{
+    if (uri->is_websocket) {
+        return RATE_CLASS_COUNT;  /* Frames come through the handler too */
+    }
+    if (strcmp(uri->uri, "/api/sensors/rescan") == 0 || strcmp(uri->uri, "/api/wifi/scan") == 0) {
+        return RATE_CLASS_SCAN;
+    }
+    return uri->method == HTTP_GET ? RATE_CLASS_READ : RATE_CLASS_WRITE;
+}
+
+/**
+ * @brief Key identifying the peer of a request (its address)
+ */
+static uint32_t client_key(httpd_req_t *req)
+{
+    struct sockaddr_storage addr;
+    socklen_t len = sizeof(addr);
+    if (getpeername(httpd_req_to_sockfd(req), (struct sockaddr *)&addr, &len) != 0) {
+        return 0;
+    }
+#if CONFIG_LWIP_IPV6
+    if (addr.ss_family == AF_INET6) {
+        const struct sockaddr_in6 *in6 = (const struct sockaddr_in6 *)&addr;
+        return http_etag_hash(HTTP_ETAG_HASH_INIT, &in6->sin6_addr, sizeof(in6->sin6_addr));
+    }
+#endif
+    return ((const struct sockaddr_in *)&addr)->sin_addr.s_addr;
+}
+
+/**
+ * @brief Take a token for the request or answer 429
+ * @return true if the request may proceed, false if 429 sent
+ */
+static bool check_rate_limit(httpd_req_t *req, rate_class_t cls)
+{
+    uint32_t retry_after;
+    uint32_t now_ms = (uint32_t)(esp_timer_get_time() / 1000);
+    if (rate_limit_allow(&s_rate_limiter, client_key(req), cls, now_ms, &retry_after)) {
+        return true;
+    }
+
+    char retry[12];
+    snprintf(retry, sizeof(retry), "%lu", (unsigned long)retry_after);
+    httpd_resp_set_status(req, "429 Too Many Requests");
+    httpd_resp_set_hdr(req, "Retry-After", retry);
+    httpd_resp_sendstr(req, "Too many requests");
+    return false;
+}
+
+/* ===== Per-endpoint latency ===== */
+
+typedef struct {
+    uint32_t count;
+    uint32_t max_us;
+    uint64_t total_us;
+} latency_t;
+
+typedef struct {
+    async_handler_t handler;    /* Handler registered for the URI */
+    const char *uri;
+    httpd_method_t method;
+    latency_t server;           /* Time on the server task - blocks every other request */
+    latency_t worker;           /* Time on an async worker */
+    rate_class_t rate_class;
+} endpoint_t;
+
+static endpoint_t s_endpoints[MAX_URI_HANDLERS];
+static int s_endpoint_count = 0;
+static portMUX_TYPE s_latency_lock = portMUX_INITIALIZER_UNLOCKED;
+
+/**
+ * @brief Entry point of every URI: rate-limits and times the registered handler
+ *
+ * The endpoint travels in user_ctx, which async request copies keep, so
+ * work handed to a worker is timed there separately (and not charged twice).
+ */
+static esp_err_t timed_handler(httpd_req_t *req)
+{
+    endpoint_t *ep = req->user_ctx;
+    bool worker = on_async_worker();
+    latency_t *lat = worker ? &ep->worker : &ep->server;
+
+    if (!worker && ep->rate_class < RATE_CLASS_COUNT && !check_rate_limit(req, ep->rate_class)) {
+        return ESP_OK;
+    }
+
+    int64_t start = esp_timer_get_time();
+    esp_err_t ret = ep->handler(req);
+    uint32_t elapsed_us = (uint32_t)(esp_timer_get_time() - start);
+
+    portENTER_CRITICAL(&s_latency_lock);
+    lat->count++;
+    lat->total_us += elapsed_us;
+    if (elapsed_us > lat->max_us) {
+        lat->max_us = elapsed_us;
+    }
+    portEXIT_CRITICAL(&s_latency_lock);
+    return ret;
+}
+
+/**
+ * @brief Route a URI through timed_handler before registering it
+ */
+static void track_endpoint(httpd_uri_t *uri)
+{
+    if (s_endpoint_count >= MAX_URI_HANDLERS) {
+        return;
+    }
+    endpoint_t *ep = &s_endpoints[s_endpoint_count++];
+    memset(ep, 0, sizeof(*ep));
+    ep->handler = uri->handler;
+    ep->uri = uri->uri;
+    ep->method = uri->method;
+    ep->rate_class = endpoint_rate_class(uri);
+    uri->handler = timed_handler;
+    uri->user_ctx = ep;
+}
+
+/* ===== Conditional requests ===== */
+
+/* Distinguishes sequence numbers of different boots (set in web_server_start) */
+static char s_boot_tag[9] = "0";
+
+/**
+ * @brief Send the ETag and answer 304 if the client's copy is current
+ *
+ * Responses are private (auth-gated) and must be revalidated on every use,
+ * so polling clients get header-only replies while nothing changed.
+ *
+ * @param etag Entity tag; must stay valid until the response is sent
+ * @return true if a 304 was sent and the handler is done
+ */
+static bool send_not_modified(httpd_req_t *req, const char *etag)
+{
+    httpd_resp_set_hdr(req, "ETag", etag);
+    httpd_resp_set_hdr(req, "Cache-Control", "private, no-cache");
+
+    char inm[128];
+    size_t len = httpd_req_get_hdr_value_len(req, "If-None-Match");
+    if (len == 0 || len >= sizeof(inm) ||
+        httpd_req_get_hdr_value_str(req, "If-None-Match", inm, sizeof(inm)) != ESP_OK ||
+        !http_etag_match(inm, etag)) {
+        return false;
+    }
+
+    httpd_resp_set_status(req, "304 Not Modified");
+    httpd_resp_send(req, NULL, 0);
+    return true;
+}
+
+/**
+ * @brief Serve an embedded gzipped page, revalidated by firmware version
+ */
+static esp_err_t send_gz_page(httpd_req_t *req, const uint8_t *start, const uint8_t *end)
+{
+    /* Size guards against stale caches on development builds of one version */
+    char etag[HTTP_ETAG_MAX_LEN];
+    if (http_etag_format(etag, sizeof(etag), false, APP_VERSION, (uint32_t)(end - start)) > 0 &&
+        send_not_modified(req, etag)) {
+        return ESP_OK;
+    }
+
+    httpd_resp_set_type(req, "text/html");
+    httpd_resp_set_hdr(req, "Content-Encoding", "gzip");
+    httpd_resp_send(req, (const char *)start, end - start);
+    return ESP_OK;
+}
+
+/**
+ * @brief Handler for GET /
+ */
+static esp_err_t index_get_handler(httpd_req_t *req)
+{
+    CHECK_PAGE_AUTH(req);
+    return send_gz_page(req, index_html_gz_start, index_html_gz_end);
+}
+
+/* Note: HTML content moved to external files in main/html/ directory */
+
+/**
+ * @brief Collect the state reported by /api/status
+ *
+ * Uptime and free heap are left at 0 so the snapshot can be hashed for
+ * the ETag first; callers fill them in before writing the document.
+ */
+static void status_snapshot(dashboard_status_t *st)
+{
+    /* Zeroed so padding and unused IP bytes hash consistently */
+    memset(st, 0, sizeof(*st));
+    st->version = APP_VERSION;
+    st->sensor_count = sensor_manager_get_count();
+    st->max_sensors = CONFIG_MAX_SENSORS;
+    st->mqtt_connected = mqtt_ha_is_connected();
+    st->eth_connected = ethernet_manager_is_connected();
+    st->wifi_connected = wifi_manager_is_connected();
+    if (st->eth_connected) {
+        strlcpy(st->ethernet_ip, ethernet_manager_get_ip(), sizeof(st->ethernet_ip));
+    }
+    if (st->wifi_connected) {
+        strlcpy(st->wifi_ip, wifi_manager_get_ip(), sizeof(st->wifi_ip));
+    }
+    onewire_temp_get_error_stats(&st->total_reads, &st->failed_reads);
+
+    mqtt_buffer_stats_t buffer;
+    mqtt_ha_get_buffer_stats(&buffer);
+    st->buffer.depth = buffer.depth;
+    st->buffer.flash_depth = buffer.flash_depth;
+    st->buffer.captured = buffer.captured;
+    st->buffer.dropped = buffer.dropped;
+    st->buffer.replayed = buffer.replayed;
+    st->buffer.replay_rate = buffer.replay_rate;
+
+    st->rate_limit.rejected_read = s_rate_limiter.rejected[RATE_CLASS_READ];
+    st->rate_limit.rejected_write = s_rate_limiter.rejected[RATE_CLASS_WRITE];
+    st->rate_limit.rejected_scan = s_rate_limiter.rejected[RATE_CLASS_SCAN];
+    st->rate_limit.rescans_coalesced = sensor_manager_get_rescans_coalesced();
+}
+
+/**
+ * @brief Weak ETag over the sensor sequence, status snapshot and field mask
+ *
+ * Weak because uptime and free heap change on every request; the tag
+ * covers everything else as of the current acquisition cycle.
+ */
+static void status_etag(char *etag, size_t size, const dashboard_status_t *st, uint32_t mask)
+{
+    uint32_t sequence = sensor_manager_get_sequence();
+    uint32_t hash = http_etag_hash(HTTP_ETAG_HASH_INIT, &sequence, sizeof(sequence));
+    hash = http_etag_hash(hash, st, sizeof(*st));
+    hash = http_etag_hash(hash, &mask, sizeof(mask));
+    http_etag_format(etag, size, true, s_boot_tag, hash);
+}
+
+static void status_fill_runtime(dashboard_status_t *st)
+{
+    st->uptime_seconds = esp_log_timestamp() / 1000;
+    st->free_heap = esp_get_free_heap_size();
+}
+
+static void write_sensors(json_writer_t *w, uint32_t mask)
+{
+    int count;
+    const managed_sensor_t *sensors = sensor_manager_get_sensors(&count);
+
+    json_writer_begin_array(w);
+    for (int i = 0; i < count; i++) {
+        dashboard_sensor_t sensor = {
+            .address = sensors[i].address_str,
+            .temperature = sensors[i].hw_sensor.temperature,
+            .valid = sensors[i].hw_sensor.valid,
+            .friendly_name = sensors[i].has_friendly_name ? sensors[i].friendly_name : NULL,
+            .total_reads = sensors[i].hw_sensor.total_reads,
+            .failed_reads = sensors[i].hw_sensor.failed_reads,
+        };
+        dashboard_write_sensor(w, &sensor, mask);
+    }
+    json_writer_end_array(w);
+}
+
+/**
+ * @brief Handler for GET /api/status
+ */
+static esp_err_t api_status_handler(httpd_req_t *req)
+{
+    CHECK_AUTH(req);
+
+    dashboard_status_t st;
+    status_snapshot(&st);
+    char etag[HTTP_ETAG_MAX_LEN];
+    status_etag(etag, sizeof(etag), &st, DASHBOARD_STATUS_FIELDS);
+    if (send_not_modified(req, etag)) {
+        return ESP_OK;
+    }
+    status_fill_runtime(&st);
+
+    json_writer_t w;
+    json_resp_begin(&w, req);
+    dashboard_write_status(&w, &st, DASHBOARD_STATUS_FIELDS);
+    return json_resp_end(&w, req);
+}
+
+/**
+ * @brief Handler for GET /api/sensors
+ */
+static esp_err_t api_sensors_get_handler(httpd_req_t *req)
+{
+    CHECK_AUTH(req);
+
+    /* Taken before the body: a cycle finishing meanwhile only costs a refetch */
+    char etag[HTTP_ETAG_MAX_LEN];
+    http_etag_format(etag, sizeof(etag), false, s_boot_tag, sensor_manager_get_sequence());
+    if (send_not_modified(req, etag)) {
+        return ESP_OK;
+    }
+
+    json_writer_t w;
+    json_resp_begin(&w, req);
+    write_sensors(&w, DASHBOARD_SENSOR_FIELDS);
+    return json_resp_end(&w, req);
+}
+
+/**
+ * @brief Handler for GET /api/dashboard?fields=...
+ *
+ * Sensors and status in one document. Groups without selected fields are
+ * left out entirely.
+ */
+static esp_err_t api_dashboard_handler(httpd_req_t *req)
+{
+    CHECK_AUTH(req);
+
+    uint32_t mask = DASHBOARD_ALL_FIELDS;
+    char query[256];
+    char fields[192];
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+        esp_err_t err = httpd_query_key_value(query, "fields", fields, sizeof(fields));
+        if (err != ESP_ERR_NOT_FOUND &&
+            (err != ESP_OK || dashboard_parse_fields(fields, &mask) != 0)) {
+            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid fields list");
+            return ESP_OK;
+        }
+    }
+
+    dashboard_status_t st;
+    status_snapshot(&st);
+    char etag[HTTP_ETAG_MAX_LEN];
+    status_etag(etag, sizeof(etag), &st, mask);
+    if (send_not_modified(req, etag)) {
+        return ESP_OK;
+    }
+    status_fill_runtime(&st);
+
+    json_writer_t w;
+    json_resp_begin(&w, req);
+    json_writer_begin_object(&w);
+    if (mask & DASHBOARD_SENSOR_FIELDS) {
+        json_writer_key(&w, "sensors");
+        write_sensors(&w, mask);
+    }
+    if (mask & DASHBOARD_STATUS_FIELDS) {
+        json_writer_key(&w, "status");
+        dashboard_write_status(&w, &st, mask);
+    }
+    json_writer_end_object(&w);
+    return json_resp_end(&w, req);
+}
+
+/* ===== History export ===== */
+
+/* Response buffer on the worker stack; rows are flushed as chunks */
+#define EXPORT_BUF_SIZE 1024
+#define EXPORT_READ_RECORDS 16
+
+/* Clock is treated as set (SNTP synced) past this Unix time */
+#define VALID_EPOCH_MIN 1700000000
+
+/**
+ * @brief Parse an optional numeric query parameter
+ * @return 0 if absent or valid, -1 if malformed
+ */
+static int query_uint32(const char *query, const char *key, uint32_t *out)
+{
+    char value[16];
+    esp_err_t err = httpd_query_key_value(query, key, value, sizeof(value));
+    if (err == ESP_ERR_NOT_FOUND) {
+        return 0;
+    }
+    char *end;
+    unsigned long v = strtoul(value, &end, 10);
+    if (err != ESP_OK || end == value || *end != '\0' || v > UINT32_MAX) {
+        return -1;
+    }
+    *out = (uint32_t)v;
+    return 0;
+}
+
+/**
+ * @brief Handler for GET /api/export?format=csv|ndjson|cbor&sensors=&from=&to=
+ *
+ * Streams the reading history one row at a time through a fixed buffer.
+ * A CBOR export is a single telemetry batch whose readings array has an
+ * indefinite length, since the filtered row count is not known up front.
+ * History is copied out in small pieces so the sensor manager's lock is
+ * never held while a send blocks.
+ */
+static esp_err_t api_export_handler(httpd_req_t *req)
+{
+    CHECK_AUTH(req);
+    RUN_ASYNC(req);
+
+    history_export_format_t format = HISTORY_EXPORT_CSV;
+    history_export_filter_t filter = {0};
+    char query[384];
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+        char value[320];
+        esp_err_t err = httpd_query_key_value(query, "format", value, sizeof(value));
+        if (err != ESP_ERR_NOT_FOUND &&
+            (err != ESP_OK || history_export_parse_format(value, &format) != 0)) {
+            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid format");
+            return ESP_OK;
+        }
+        err = httpd_query_key_value(query, "sensors", value, sizeof(value));
+        if (err != ESP_ERR_NOT_FOUND &&
+            (err != ESP_OK || history_export_parse_sensors(value, &filter) != 0)) {
+            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid sensors list");
+            return ESP_OK;
+        }
+        if (query_uint32(query, "from", &filter.from) != 0 ||
+            query_uint32(query, "to", &filter.to) != 0) {
+            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid time range");
+            return ESP_OK;
+        }
+    }
+
+    httpd_resp_set_type(req, history_export_content_type(format));
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+    char disposition[64];
+    snprintf(disposition, sizeof(disposition), "attachment; filename=\"thermux-history.%s\"",
+             history_export_extension(format));
+    httpd_resp_set_hdr(req, "Content-Disposition", disposition);
+
+    int64_t start = esp_timer_get_time();
+    time_t now = time(NULL);
+    char buf[EXPORT_BUF_SIZE];
+    history_record_t records[EXPORT_READ_RECORDS];
+    size_t len = history_export_header(format, now >= VALID_EPOCH_MIN ? (uint32_t)now : 0,
+                                       buf, sizeof(buf));
+    size_t total = 0;
+    uint32_t rows = 0;
+    uint32_t cursor = 0;
+    size_t n;
+
+    while ((n = sensor_manager_history_read(&cursor, records, EXPORT_READ_RECORDS)) > 0) {
+        for (size_t i = 0; i < n; i++) {
+            if (!history_export_match(&filter, &records[i])) {
+                continue;
+            }
+            if (sizeof(buf) - len < HISTORY_EXPORT_ROW_MAX) {
+                if (httpd_resp_send_chunk(req, buf, len) != ESP_OK) {
+                    return ESP_FAIL;
+                }
+                total += len;
+                len = 0;
+            }
+            len += history_export_row(format, &records[i], buf + len, sizeof(buf) - len);
+            rows++;
+        }
+    }
+
+    if (sizeof(buf) - len < HISTORY_EXPORT_FOOTER_MAX) {
+        if (httpd_resp_send_chunk(req, buf, len) != ESP_OK) {
+            return ESP_FAIL;
+        }
+        total += len;
+        len = 0;
+    }
+    len += history_export_footer(format, buf + len, sizeof(buf) - len);
+
+    if (len > 0 && httpd_resp_send_chunk(req, buf, len) != ESP_OK) {
+        return ESP_FAIL;
+    }
+    total += len;
+
+    ESP_LOGI(TAG, "Exported %lu rows (%u bytes) in %lld ms", (unsigned long)rows, (unsigned)total,
+             (esp_timer_get_time() - start) / 1000);
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+/* ===== Prometheus metrics ===== */
+
+/**
+ * @brief Write one per-sensor family (valid_only skips sensors without a reading)
+ */
+#define METRICS_SENSOR_FAMILY(w, name, type, help, field, valid_only, sample_fn) do { \
+        metrics_writer_family(w, name, type, help); \
+        for (int i = 0; i < count; i++) { \
+            if (!(valid_only) || sensors[i].hw_sensor.valid) { \
+                sample_fn(w, name, sensors[i].metric_labels, sensors[i].hw_sensor.field); \
+            } \
+        } \
+    } while (0)
+
+/**
+ * @brief Handler for GET /metrics (Prometheus text format 0.0.4)
+ *
+ * Streamed from the shared response buffer with per-sensor label sets
+ * prepared by the sensor manager, so a scrape allocates nothing.
+ */
+static esp_err_t metrics_handler(httpd_req_t *req)
+{
+    CHECK_AUTH(req);
+
+    int count;
+    const managed_sensor_t *sensors = sensor_manager_get_sensors(&count);
+    uint32_t bus_reads, bus_failed, published, publish_failed;
+    onewire_temp_get_error_stats(&bus_reads, &bus_failed);
+    mqtt_ha_get_publish_stats(&published, &publish_failed);
+    metrics_histogram_t cycle;
+    sensor_manager_get_cycle_histogram(&cycle);
+
+    char version_labels[48];
+    snprintf(version_labels, sizeof(version_labels), "{version=\"%s\"}", APP_VERSION);
+
+    httpd_resp_set_type(req, "text/plain; version=0.0.4");
+    metrics_writer_t w;
+    metrics_writer_init(&w, s_json_resp_buf, sizeof(s_json_resp_buf), json_resp_sink, req);
+
+    metrics_writer_family(&w, "thermux_info", "gauge", "Firmware information");
+    metrics_writer_sample_uint(&w, "thermux_info", version_labels, 1);
+
+    METRICS_SENSOR_FAMILY(&w, "thermux_sensor_temperature_celsius", "gauge",
+                          "Last valid temperature reading", temperature, true,
+                          metrics_writer_sample);
+    METRICS_SENSOR_FAMILY(&w, "thermux_sensor_valid", "gauge",
+                          "1 if the last read succeeded", valid, false,
+                          metrics_writer_sample_uint);
+    METRICS_SENSOR_FAMILY(&w, "thermux_sensor_reads_total", "counter",
+                          "Read attempts per sensor", total_reads, false,
+                          metrics_writer_sample_uint);
+    METRICS_SENSOR_FAMILY(&w, "thermux_sensor_read_failures_total", "counter",
+                          "Failed reads per sensor", failed_reads, false,
+                          metrics_writer_sample_uint);
+
+    metrics_writer_family(&w, "thermux_bus_reads_total", "counter", "1-Wire read attempts");
+    metrics_writer_sample_uint(&w, "thermux_bus_reads_total", NULL, bus_reads);
+    metrics_writer_family(&w, "thermux_bus_read_failures_total", "counter", "Failed 1-Wire reads");
+    metrics_writer_sample_uint(&w, "thermux_bus_read_failures_total", NULL, bus_failed);
+
+    metrics_writer_family(&w, "thermux_read_cycle_duration_seconds", "histogram",
+                          "Time to read all sensors");
+    metrics_writer_histogram(&w, "thermux_read_cycle_duration_seconds", &cycle);
+
+    metrics_writer_family(&w, "thermux_mqtt_connected", "gauge", "1 if connected to the broker");
+    metrics_writer_sample_uint(&w, "thermux_mqtt_connected", NULL, mqtt_ha_is_connected());
+    metrics_writer_family(&w, "thermux_mqtt_publish_total", "counter", "Messages handed to the MQTT client");
+    metrics_writer_sample_uint(&w, "thermux_mqtt_publish_total", NULL, published);
+    metrics_writer_family(&w, "thermux_mqtt_publish_failures_total", "counter", "Publishes rejected by the MQTT client");
+    metrics_writer_sample_uint(&w, "thermux_mqtt_publish_failures_total", NULL, publish_failed);
+
+    metrics_writer_family(&w, "thermux_http_request_duration_seconds", "summary",
+                          "Handler time per endpoint, on the server task or an async worker");
+    for (int i = 0; i < s_endpoint_count; i++) {
+        const endpoint_t *ep = &s_endpoints[i];
+        const latency_t *lats[] = { &ep->server, &ep->worker };
+        for (int c = 0; c < 2; c++) {
+            portENTER_CRITICAL(&s_latency_lock);
+            latency_t lat = *lats[c];
+            portEXIT_CRITICAL(&s_latency_lock);
+            if (lat.count == 0) {
+                continue;
+            }
+            char labels[96];
+            snprintf(labels, sizeof(labels), "{path=\"%s\",method=\"%s\",context=\"%s\"}",
+                     ep->uri, ep->method == HTTP_POST ? "POST" : "GET", c == 0 ? "server" : "worker");
+            metrics_writer_sample(&w, "thermux_http_request_duration_seconds_sum", labels,
+                                  lat.total_us / 1e6);
+            metrics_writer_sample_uint(&w, "thermux_http_request_duration_seconds_count", labels,
+                                       lat.count);
+        }
+    }
+
+    metrics_writer_family(&w, "thermux_heap_free_bytes", "gauge", "Free heap");
+    metrics_writer_sample_uint(&w, "thermux_heap_free_bytes", NULL, esp_get_free_heap_size());
+    metrics_writer_family(&w, "thermux_uptime_seconds", "gauge", "Time since boot");
+    metrics_writer_sample_uint(&w, "thermux_uptime_seconds", NULL, esp_log_timestamp() / 1000);
+
+    if (!w.error && w.flushed == 0) {
+        /* Whole scrape still buffered - send it with Content-Length */
+        return httpd_resp_send(req, w.buf, w.len);
+    }
+    if (metrics_writer_finish(&w) < 0) {
+        ESP_LOGE(TAG, "Failed to stream metrics");
+        return ESP_FAIL;
+    }
+    return httpd_resp_send_chunk(req, NULL, 0);
+}
+
+/* ===== Server-Sent Events ===== */
+
+/* Concurrent /api/events streams; each holds one of the server's sockets */
+#define SSE_MAX_CLIENTS 3
+
+/* Event buffer - fits a delta for every sensor at the default sensor limit */
+#define SSE_EVENT_BUF_SIZE 2560
+
+#define SSE_EVENT_PREFIX "event: update\ndata: "
+
+/* Events a client may miss (socket full) before it is dropped */
+#define SSE_MAX_MISSED 3
+
+typedef struct {
+    int fd;             /* Socket, -1 when the slot is free */
+    bool closing;       /* Dropped, waiting for the session to close */
+    uint8_t missed;     /* Consecutive events skipped */
+} sse_client_t;
+
+/* Last values pushed, used to send only sensors that changed */
+typedef struct {
+    char address[17];
+    float temperature;
+    bool valid;
+} sse_sensor_state_t;
+
+/* Only touched from the httpd task (handlers, queued work, session close) */
+static sse_client_t s_sse_clients[SSE_MAX_CLIENTS];
+static int s_sse_client_count = 0;
+static sse_sensor_state_t s_sse_last[CONFIG_MAX_SENSORS];
+static int s_sse_last_count = 0;
+static char s_sse_event_buf[SSE_EVENT_BUF_SIZE];
+
+/**
+ * @brief Session close callback: release the client slot
+ */
+static void sse_client_closed(void *ctx)
+{
+    sse_client_t *client = ctx;
+    client->fd = -1;
+    client->closing = false;
+    s_sse_client_count--;
+}
+
+static bool sse_sensor_changed(int index, const managed_sensor_t *sensor)
+{
+    if (index >= s_sse_last_count) {
+        return true;
+    }
+    const sse_sensor_state_t *last = &s_sse_last[index];
+    return strcmp(last->address, sensor->address_str) != 0 ||
+           last->valid != sensor->hw_sensor.valid ||
+           (sensor->hw_sensor.valid && last->temperature != sensor->hw_sensor.temperature);
+}
+
+/**
+ * @brief Build the update event: status summary plus sensors that changed
+ * @return Event length, or -1 if it does not fit
+ */
+static int sse_build_update(bool resync)
+{
+    int count;
+    const managed_sensor_t *sensors = sensor_manager_get_sensors(&count);
+    size_t prefix_len = strlen(SSE_EVENT_PREFIX);
+    memcpy(s_sse_event_buf, SSE_EVENT_PREFIX, prefix_len);
+
+    /* Leave room for the blank line that terminates the event */
+    json_writer_t w;
+    json_writer_init(&w, s_sse_event_buf + prefix_len,
+                     sizeof(s_sse_event_buf) - prefix_len - 2, NULL, NULL);
+
+    json_writer_begin_object(&w);
+    json_writer_kv_int(&w, "sensor_count", count);
+    json_writer_kv_bool(&w, "mqtt_connected", mqtt_ha_is_connected());
+
+    uint32_t total_reads, failed_reads;
+    onewire_temp_get_error_stats(&total_reads, &failed_reads);
+    json_writer_key(&w, "bus_stats");
+    json_writer_begin_object(&w);
+    json_writer_kv_uint(&w, "total_reads", total_reads);
+    json_writer_kv_uint(&w, "failed_reads", failed_reads);
+    json_writer_kv_double(&w, "error_rate", total_reads > 0 ? (double)failed_reads / total_reads * 100.0 : 0.0);
+    json_writer_end_object(&w);
+
+    if (resync) {
+        /* Too many changes for one event - clients refetch /api/sensors */
+        json_writer_kv_bool(&w, "resync", true);
+    } else {
+        json_writer_key(&w, "sensors");
+        json_writer_begin_array(&w);
+        for (int i = 0; i < count; i++) {
+            if (!sse_sensor_changed(i, &sensors[i])) {
+                continue;
+            }
+            json_writer_begin_object(&w);
+            json_writer_kv_string(&w, "address", sensors[i].address_str);
+            json_writer_kv_double(&w, "temperature", sensors[i].hw_sensor.temperature);
+            json_writer_kv_bool(&w, "valid", sensors[i].hw_sensor.valid);
+            json_writer_kv_uint(&w, "total_reads", sensors[i].hw_sensor.total_reads);
+            json_writer_kv_uint(&w, "failed_reads", sensors[i].hw_sensor.failed_reads);
+            json_writer_end_object(&w);
+        }
+        json_writer_end_array(&w);
+    }
+    json_writer_end_object(&w);
+
+    int len = json_writer_finish(&w);
+    if (len < 0) {
+        return -1;
+    }
+    len += prefix_len;
+    s_sse_event_buf[len++] = '\n';
+    s_sse_event_buf[len++] = '\n';
+
+    /* Remember what clients have now seen */
+    for (int i = 0; i < count && i < CONFIG_MAX_SENSORS; i++) {
+        strlcpy(s_sse_last[i].address, sensors[i].address_str, sizeof(s_sse_last[i].address));
+        s_sse_last[i].temperature = sensors[i].hw_sensor.temperature;
+        s_sse_last[i].valid = sensors[i].hw_sensor.valid;
+    }
+    s_sse_last_count = count;
+    return len;
+}
+
+/**
+ * @brief Send an event only if the socket can take it right now
+ *
+ * A blocking send to a stalled client would hold up the server task for
+ * the send timeout, so events go out with MSG_DONTWAIT like WebSocket
+ * frames. An event the socket has no room for is skipped; a client that
+ * skips SSE_MAX_MISSED events in a row, or whose event only partly went
+ * out, is dropped.
  */
-static const char* generate_session_token(void)
+static void sse_send(sse_client_t *client, const char *data, size_t len)
 {
-    int64_t now = esp_timer_get_time() / 1000;
-    int slot = -1;
-    int64_t oldest_expiry = INT64_MAX;
-    int oldest_slot = 0;
-    
-    /* Find empty/expired slot, or track oldest for replacement */
-    for (int i = 0; i < MAX_SESSIONS; i++) {
-        if (s_sessions[i].token[0] == '\0' || now > s_sessions[i].expiry) {
-            slot = i;
-            break;
-        }
-        if (s_sessions[i].expiry < oldest_expiry) {
-            oldest_expiry = s_sessions[i].expiry;
-            oldest_slot = i;
-        }
-    }
-    
-    /* Use oldest slot if no empty/expired found */
-    if (slot < 0) {
-        slot = oldest_slot;
-        ESP_LOGD(TAG, "Replacing oldest session in slot %d", slot);
-    }
-    
-    /* Generate random token */
-    uint32_t rnd[4];
-    for (int i = 0; i < 4; i++) {
-        rnd[i] = esp_random();
-    }
-    snprintf(s_sessions[slot].token, sizeof(s_sessions[slot].token), "%08lx%08lx%08lx%08lx",
-             (unsigned long)rnd[0], (unsigned long)rnd[1], 
-             (unsigned long)rnd[2], (unsigned long)rnd[3]);
-    s_sessions[slot].expiry = now + SESSION_TIMEOUT_MS;
-    
-    ESP_LOGD(TAG, "Created session in slot %d", slot);
-    return s_sessions[slot].token;
+    ssize_t sent = send(client->fd, data, len, MSG_DONTWAIT);
+    if (sent == (ssize_t)len) {
+        client->missed = 0;
+        return;
+    }
+    if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK) &&
+        ++client->missed <= SSE_MAX_MISSED) {
+        return;
+    }
+    /* Slot is released by sse_client_closed once the session is gone */
+    client->closing = true;
+    httpd_sess_trigger_close(s_server, client->fd);
 }
 
 /**
- * @brief Generate a random API key (256-bit)
+ * @brief Send to every stream that has (resync) or has not (delta) missed an event
  */
-static void generate_api_key(void)
+static void sse_send_all(bool resync, const char *data, size_t len)
 {
-    uint32_t rnd[8];
-    for (int i = 0; i < 8; i++) {
-        rnd[i] = esp_random();
+    for (int i = 0; i < SSE_MAX_CLIENTS; i++) {
+        sse_client_t *client = &s_sse_clients[i];
+        if (client->fd < 0 || client->closing || (client->missed > 0) != resync) {
+            continue;
+        }
+        sse_send(client, data, len);
     }
-    snprintf(s_api_key, sizeof(s_api_key), 
-             "%08lx%08lx%08lx%08lx%08lx%08lx%08lx%08lx",
-             (unsigned long)rnd[0], (unsigned long)rnd[1], 
-             (unsigned long)rnd[2], (unsigned long)rnd[3],
-             (unsigned long)rnd[4], (unsigned long)rnd[5],
-             (unsigned long)rnd[6], (unsigned long)rnd[7]);
 }
 
 /**
- * @brief Check if session token from cookie is valid
+ * @brief Push the update event to every SSE stream (httpd task)
+ *
+ * Clients that skipped an event lost the deltas in it, so they get a
+ * resync event instead and refetch the full sensor list.
  */
-static bool is_session_valid(httpd_req_t *req)
+static void sse_push_update(void)
 {
-    /* Get Cookie header */
-    size_t cookie_len = httpd_req_get_hdr_value_len(req, "Cookie");
-    if (cookie_len == 0) {
-        return false;
-    }
-
-    char *cookie = malloc(cookie_len + 1);
-    if (!cookie) {
-        return false;
+    if (s_sse_client_count == 0) {
+        return;
     }
 
-    if (httpd_req_get_hdr_value_str(req, "Cookie", cookie, cookie_len + 1) != ESP_OK) {
-        free(cookie);
-        return false;
+    bool lagging = false;
+    for (int i = 0; i < SSE_MAX_CLIENTS; i++) {
+        if (s_sse_clients[i].fd >= 0 && !s_sse_clients[i].closing && s_sse_clients[i].missed > 0) {
+            lagging = true;
+        }
     }
 
-    /* Look for session=TOKEN in cookie */
-    char *session_start = strstr(cookie, "session=");
-    if (!session_start) {
-        free(cookie);
-        return false;
+    int len = sse_build_update(false);
+    bool resync = len < 0;
+    if (resync) {
+        len = sse_build_update(true);
     }
-
-    session_start += 8;  /* Skip "session=" */
-    char token[33] = {0};
-    int i = 0;
-    while (session_start[i] && session_start[i] != ';' && i < 32) {
-        token[i] = session_start[i];
-        i++;
+    if (len < 0) {
+        ESP_LOGE(TAG, "Failed to build SSE update");
+        return;
     }
-    token[i] = '\0';
-    free(cookie);
+    sse_send_all(false, s_sse_event_buf, len);
 
-    /* Check token against all sessions */
-    int64_t now = esp_timer_get_time() / 1000;
-    for (int j = 0; j < MAX_SESSIONS; j++) {
-        if (s_sessions[j].token[0] != '\0' && strcmp(token, s_sessions[j].token) == 0) {
-            if (now > s_sessions[j].expiry) {
-                s_sessions[j].token[0] = '\0';  /* Clear expired session */
-                return false;
-            }
-            return true;
+    if (lagging) {
+        if (!resync) {
+            len = sse_build_update(true);
+        }
+        if (len >= 0) {
+            sse_send_all(true, s_sse_event_buf, len);
         }
     }
-    return false;
 }
 
 /**
- * @brief Redirect to login page
+ * @brief Handler for GET /api/events
+ *
+ * Writes the response head directly and keeps the socket open. Events are
+ * then pushed from readings_push_work; the session close callback frees the slot.
  */
-static void redirect_to_login(httpd_req_t *req)
+static esp_err_t api_events_handler(httpd_req_t *req)
 {
-    httpd_resp_set_status(req, "302 Found");
-    httpd_resp_set_hdr(req, "Location", "/login");
-    httpd_resp_send(req, NULL, 0);
+    CHECK_AUTH(req);
+
+    sse_client_t *client = NULL;
+    for (int i = 0; i < SSE_MAX_CLIENTS; i++) {
+        if (s_sse_clients[i].fd < 0) {
+            client = &s_sse_clients[i];
+            break;
+        }
+    }
+    if (client == NULL) {
+        httpd_resp_set_status(req, "503 Service Unavailable");
+        httpd_resp_set_hdr(req, "Retry-After", "30");
+        httpd_resp_sendstr(req, "Too many event streams");
+        return ESP_OK;
+    }
+
+    static const char head[] =
+        "HTTP/1.1 200 OK\r\n"
+        "Content-Type: text/event-stream\r\n"
+        "Cache-Control: no-cache\r\n"
+        "Connection: keep-alive\r\n"
+        "\r\n"
+        "retry: 5000\n\n";
+
+    int fd = httpd_req_to_sockfd(req);
+    if (httpd_socket_send(req->handle, fd, head, sizeof(head) - 1, 0) < 0) {
+        return ESP_FAIL;
+    }
+
+    client->fd = fd;
+    client->closing = false;
+    client->missed = 0;
+    s_sse_client_count++;
+    req->sess_ctx = client;
+    req->free_ctx = sse_client_closed;
+
+    ESP_LOGD(TAG, "SSE client connected (fd %d, %d active)", fd, s_sse_client_count);
+    return ESP_OK;
 }
 
-/**
- * @brief Check session auth - redirects to login if unauthorized
- * @return true if authorized (or auth disabled), false if redirect sent
- */
-static bool check_session_auth(httpd_req_t *req)
+#if CONFIG_HTTPD_WS_SUPPORT
+/* ===== WebSocket streams ===== */
+
+/* Concurrent /ws clients; together with SSE this leaves sockets for requests */
+#define WS_MAX_CLIENTS 2
+
+/* Pushes a client may miss (socket full) before it is dropped */
+#define WS_MAX_MISSED 3
+
+/* Log output is batched into frames at most this often */
+#define WS_LOG_FLUSH_MS 250
+
+/* Raw log bytes per frame; escaped JSON can grow to 6x */
+#define WS_LOG_CHUNK_SIZE 384
+#define WS_LOG_FRAMES_PER_FLUSH 4
+
+typedef struct {
+    int fd;                 /* Socket, -1 when the slot is free */
+    bool closing;           /* Dropped, waiting for the session to close */
+    uint8_t missed;         /* Consecutive pushes skipped */
+    uint32_t log_cursor;    /* Next log byte to send */
+    ws_subscription_t sub;
+} ws_client_t;
+
+/* Only touched from the httpd task (handlers, queued work, session close) */
+static ws_client_t s_ws_clients[WS_MAX_CLIENTS];
+static int s_ws_client_count = 0;
+static volatile bool s_ws_logs_wanted = false;
+static esp_timer_handle_t s_ws_log_timer = NULL;
+static char s_ws_log_chunk[WS_LOG_CHUNK_SIZE + 1];
+static char s_ws_frame_buf[WS_LOG_CHUNK_SIZE * 6 + 32];
+
+static void ws_update_log_interest(void)
 {
-    if (!s_auth_enabled) {
-        return true;  /* Auth disabled, allow all */
+    bool wanted = false;
+    for (int i = 0; i < WS_MAX_CLIENTS; i++) {
+        if (s_ws_clients[i].fd >= 0 && !s_ws_clients[i].closing && s_ws_clients[i].sub.logs) {
+            wanted = true;
+        }
     }
+    s_ws_logs_wanted = wanted;
+}
 
-    if (is_session_valid(req)) {
-        return true;  /* Valid session */
-    }
+/**
+ * @brief Session close callback: release the client slot
+ */
+static void ws_client_closed(void *ctx)
+{
+    ws_client_t *client = ctx;
+    client->fd = -1;
+    client->closing = false;
+    s_ws_client_count--;
+    ws_update_log_interest();
+}
 
-    redirect_to_login(req);
-    return false;
+static void ws_drop(ws_client_t *client)
+{
+    /* Slot is released by ws_client_closed once the session is gone */
+    client->closing = true;
+    httpd_sess_trigger_close(s_server, client->fd);
+    ws_update_log_interest();
 }
 
 /**
- * @brief Check if API key from header is valid
+ * @brief Send a frame only if the socket can take it right now
+ *
+ * httpd_ws_send_frame_async() blocks until a slow client has read enough,
+ * stalling the server, so frames go straight to the socket with
+ * MSG_DONTWAIT. A frame the socket has no room for is skipped. A client
+ * that skips WS_MAX_MISSED pushes in a row, or whose frame only partly
+ * went out, is dropped instead of holding up every other client.
+ *
+ * @return true if the frame was sent
  */
-static bool is_api_key_valid(httpd_req_t *req)
+static bool ws_send(ws_client_t *client, httpd_ws_type_t type, const void *data, size_t len)
 {
-    if (strlen(s_api_key) == 0) {
-        return false;  /* No API key configured */
-    }
-    
-    /* Check X-API-Key header */
-    size_t key_len = httpd_req_get_hdr_value_len(req, "X-API-Key");
-    if (key_len == 0) {
+    if (client->fd < 0 || client->closing) {
         return false;
     }
-    
-    char *key = malloc(key_len + 1);
-    if (key == NULL) {
+    uint8_t header[WS_FRAME_HEADER_MAX];
+    size_t header_len = ws_frame_header(header, (uint8_t)type, len);
+    if (header_len == 0) {
         return false;
     }
-    
-    if (httpd_req_get_hdr_value_str(req, "X-API-Key", key, key_len + 1) == ESP_OK) {
-        bool valid = (strcmp(key, s_api_key) == 0);
-        free(key);
-        return valid;
+
+    struct iovec iov[2] = {
+        { .iov_base = header, .iov_len = header_len },
+        { .iov_base = (void *)data, .iov_len = len },
+    };
+    struct msghdr msg = { .msg_iov = iov, .msg_iovlen = 2 };
+    ssize_t sent = sendmsg(client->fd, &msg, MSG_DONTWAIT);
+    if (sent == (ssize_t)(header_len + len)) {
+        client->missed = 0;
+        return true;
     }
-    
-    free(key);
+    if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        if (++client->missed > WS_MAX_MISSED) {
+            ws_drop(client);
+        }
+        return false;
+    }
+    /* Socket error, or a frame cut short: the stream cannot go on */
+    ws_drop(client);
     return false;
 }
 
 /**
- * @brief Check session auth for API calls - returns 401 JSON instead of redirect
- * Checks both session cookie and X-API-Key header
- * @return true if authorized (or auth disabled), false if 401 sent
+ * @brief Push this cycle's readings to subscribed clients (httpd task)
+ *
+ * Each reading is encoded at most once per format and the same frame is
+ * sent to every client that wants it.
  */
-static bool check_api_auth(httpd_req_t *req)
+static void ws_push_readings(void)
 {
-    if (!s_auth_enabled) {
-        return true;
+    if (s_ws_client_count == 0) {
+        return;
     }
 
-    /* Check API key first (stateless auth) */
-    if (is_api_key_valid(req)) {
-        return true;
+    int count;
+    const managed_sensor_t *sensors = sensor_manager_get_sensors(&count);
+    char json_frame[128];
+    uint8_t cbor_frame[TELEMETRY_CBOR_BATCH_SIZE(1)];
+
+    for (int i = 0; i < count; i++) {
+        uint64_t id = telemetry_rom_to_id(sensors[i].hw_sensor.address);
+        ws_reading_t reading = {
+            .address = sensors[i].address_str,
+            .temperature = sensors[i].hw_sensor.temperature,
+            .valid = sensors[i].hw_sensor.valid,
+        };
+        int json_len = 0;   /* 0: not encoded yet, -1: no frame */
+        int cbor_len = 0;
+
+        for (int c = 0; c < WS_MAX_CLIENTS; c++) {
+            ws_client_t *client = &s_ws_clients[c];
+            if (client->fd < 0 || client->closing || !ws_subscription_wants(&client->sub, id)) {
+                continue;
+            }
+
+            if (client->sub.format == WS_FORMAT_BINARY) {
+                if (cbor_len == 0) {
+                    cbor_writer_t cw;
+                    cbor_writer_init(&cw, cbor_frame, sizeof(cbor_frame));
+                    cbor_len = ws_write_reading_cbor(&cw, &reading) ? cbor_writer_finish(&cw) : -1;
+                }
+                if (cbor_len > 0) {
+                    ws_send(client, HTTPD_WS_TYPE_BINARY, cbor_frame, cbor_len);
+                }
+            } else {
+                if (json_len == 0) {
+                    json_writer_t w;
+                    json_writer_init(&w, json_frame, sizeof(json_frame), NULL, NULL);
+                    ws_write_reading_json(&w, &reading);
+                    json_len = json_writer_finish(&w);
+                }
+                if (json_len > 0) {
+                    ws_send(client, HTTPD_WS_TYPE_TEXT, json_frame, json_len);
+                }
+            }
+        }
     }
+}
 
-    /* Fall back to session cookie */
-    if (is_session_valid(req)) {
-        return true;
+/**
+ * @brief Queued work: send new log output to log subscribers (httpd task)
+ *
+ * Must not log: output produced here would schedule the next flush.
+ */
+static void ws_log_flush_work(void *arg)
+{
+    bool behind = false;
+    for (int c = 0; c < WS_MAX_CLIENTS; c++) {
+        ws_client_t *client = &s_ws_clients[c];
+        if (client->fd < 0 || client->closing || !client->sub.logs) {
+            continue;
+        }
+
+        for (int frames = 0; frames < WS_LOG_FRAMES_PER_FLUSH && !client->closing; frames++) {
+            if (client->log_cursor == log_buffer_cursor()) {
+                break;
+            }
+
+            uint32_t start = client->log_cursor;
+            uint32_t lost = 0;
+            size_t n = log_buffer_read(&client->log_cursor, s_ws_log_chunk, WS_LOG_CHUNK_SIZE, &lost);
+            size_t whole = ws_utf8_boundary(s_ws_log_chunk, n);
+#if !CONFIG_LOG_BUFFER_BINARY
+            /* A character cut at the end of the chunk starts the next one
+               (records only come cut when a line alone overflows the chunk,
+               and the rest of that line is skipped anyway) */
+            client->log_cursor -= (uint32_t)(n - whole);
+#endif
+            s_ws_log_chunk[whole] = '\0';
+
+            json_writer_t w;
+            json_writer_init(&w, s_ws_frame_buf, sizeof(s_ws_frame_buf), NULL, NULL);
+            json_writer_begin_object(&w);
+            json_writer_kv_string(&w, "logs", s_ws_log_chunk);
+            if (lost > 0) {
+                json_writer_kv_uint(&w, "lost", lost);
+            }
+            json_writer_end_object(&w);
+            int len = json_writer_finish(&w);
+            if (len > 0 && !ws_send(client, HTTPD_WS_TYPE_TEXT, s_ws_frame_buf, len)) {
+                client->log_cursor = start;     /* Not sent: read it again next time */
+                break;
+            }
+        }
+        if (!client->closing && client->log_cursor != log_buffer_cursor()) {
+            behind = true;
+        }
     }
 
-    httpd_resp_set_status(req, "401 Unauthorized");
-    httpd_resp_set_type(req, "application/json");
-    httpd_resp_sendstr(req, "{\"error\":\"Unauthorized\",\"login_required\":true}");
-    return false;
+    /* More output than fits this flush - continue on the next tick */
+    if (behind && !esp_timer_is_active(s_ws_log_timer)) {
+        esp_timer_start_once(s_ws_log_timer, WS_LOG_FLUSH_MS * 1000);
+    }
 }
 
-/* Macro to check auth at start of handler - returns ESP_OK if unauthorized (response already sent) */
-#define CHECK_AUTH(req) do { if (!check_api_auth(req)) return ESP_OK; } while(0)
-#define CHECK_PAGE_AUTH(req) do { if (!check_session_auth(req)) return ESP_OK; } while(0)
+static void ws_log_timer_cb(void *arg)
+{
+    if (s_server != NULL) {
+        httpd_queue_work(s_server, ws_log_flush_work, NULL);
+    }
+}
 
 /**
- * @brief Handler for GET /
+ * @brief Log buffer listener: schedule a flush (runs in the logging task)
  */
-static esp_err_t index_get_handler(httpd_req_t *req)
+static void ws_log_listener(void)
 {
-    CHECK_PAGE_AUTH(req);
-    httpd_resp_set_type(req, "text/html");
-    httpd_resp_set_hdr(req, "Content-Encoding", "gzip");
-    httpd_resp_send(req, (const char *)index_html_gz_start, index_html_gz_end - index_html_gz_start);
-    return ESP_OK;
+    if (s_ws_logs_wanted && s_ws_log_timer != NULL && !esp_timer_is_active(s_ws_log_timer)) {
+        esp_timer_start_once(s_ws_log_timer, WS_LOG_FLUSH_MS * 1000);
+    }
 }
 
-/* Note: HTML content moved to external files in main/html/ directory */
+static esp_err_t ws_send_reply(httpd_req_t *req, ws_cmd_status_t status)
+{
+    const char *reply = status == WS_CMD_OK ? "{\"result\":\"ok\"}" : NULL;
+    char buf[64];
+    if (reply == NULL) {
+        snprintf(buf, sizeof(buf), "{\"error\":\"%s\"}", ws_cmd_status_str(status));
+        reply = buf;
+    }
+    httpd_ws_frame_t frame = {
+        .final = true,
+        .type = HTTPD_WS_TYPE_TEXT,
+        .payload = (uint8_t *)reply,
+        .len = strlen(reply),
+    };
+    return httpd_ws_send_frame(req, &frame);
+}
 
 /**
- * @brief Handler for GET /api/status
+ * @brief Handler for /ws
+ *
+ * Called once after the handshake (GET) and then for every data frame.
+ * Returning an error closes the connection.
  */
-static esp_err_t api_status_handler(httpd_req_t *req)
+static esp_err_t ws_handler(httpd_req_t *req)
 {
-    CHECK_AUTH(req);
-    cJSON *root = cJSON_CreateObject();
-    cJSON_AddStringToObject(root, "version", APP_VERSION);
-    cJSON_AddNumberToObject(root, "sensor_count", sensor_manager_get_count());
-    cJSON_AddNumberToObject(root, "max_sensors", CONFIG_MAX_SENSORS);
-    cJSON_AddNumberToObject(root, "uptime_seconds", esp_log_timestamp() / 1000);
-    cJSON_AddNumberToObject(root, "free_heap", esp_get_free_heap_size());
-    
-    extern bool mqtt_ha_is_connected(void);
-    cJSON_AddBoolToObject(root, "mqtt_connected", mqtt_ha_is_connected());
-    
-    /* Network connection status */
-    bool eth_connected = ethernet_manager_is_connected();
-    bool wifi_connected = wifi_manager_is_connected();
-    cJSON_AddBoolToObject(root, "ethernet_connected", eth_connected);
-    cJSON_AddBoolToObject(root, "wifi_connected", wifi_connected);
-    cJSON_AddStringToObject(root, "ethernet_ip", eth_connected ? ethernet_manager_get_ip() : "");
-    cJSON_AddStringToObject(root, "wifi_ip", wifi_connected ? wifi_manager_get_ip() : "");
-
-    /* Bus error statistics */
-    uint32_t total_reads, failed_reads;
-    onewire_temp_get_error_stats(&total_reads, &failed_reads);
-    cJSON *bus_stats = cJSON_CreateObject();
-    cJSON_AddNumberToObject(bus_stats, "total_reads", total_reads);
-    cJSON_AddNumberToObject(bus_stats, "failed_reads", failed_reads);
-    cJSON_AddNumberToObject(bus_stats, "error_rate", total_reads > 0 ? (double)failed_reads / total_reads * 100.0 : 0.0);
-    cJSON_AddItemToObject(root, "bus_stats", bus_stats);
+    if (req->method == HTTP_GET) {
+        if (!is_request_authorized(req)) {
+            return ESP_FAIL;
+        }
+        ws_client_t *client = NULL;
+        for (int i = 0; i < WS_MAX_CLIENTS; i++) {
+            if (s_ws_clients[i].fd < 0) {
+                client = &s_ws_clients[i];
+                break;
+            }
+        }
+        if (client == NULL) {
+            ESP_LOGW(TAG, "WebSocket client limit reached");
+            return ESP_FAIL;
+        }
 
-    char *json = cJSON_PrintUnformatted(root);
-    cJSON_Delete(root);
+        client->fd = httpd_req_to_sockfd(req);
+        client->closing = false;
+        client->missed = 0;
+        client->log_cursor = log_buffer_cursor();
+        ws_subscription_init(&client->sub);
+        s_ws_client_count++;
+        req->sess_ctx = client;
+        req->free_ctx = ws_client_closed;
+        ESP_LOGD(TAG, "WebSocket client connected (fd %d, %d active)", client->fd, s_ws_client_count);
+        return ESP_OK;
+    }
 
-    httpd_resp_set_type(req, "application/json");
-    httpd_resp_send(req, json, strlen(json));
-    free(json);
-    
-    return ESP_OK;
+    ws_client_t *client = req->sess_ctx;
+    if (client == NULL) {
+        return ESP_FAIL;
+    }
+
+    char msg[WS_MAX_COMMAND_LEN];
+    httpd_ws_frame_t frame = { .payload = (uint8_t *)msg };
+    esp_err_t err = httpd_ws_recv_frame(req, &frame, 0);
+    if (err != ESP_OK) {
+        return err;
+    }
+    if (frame.len > sizeof(msg)) {
+        return ESP_FAIL;
+    }
+    if (frame.len > 0) {
+        err = httpd_ws_recv_frame(req, &frame, frame.len);
+        if (err != ESP_OK) {
+            return err;
+        }
+    }
+    if (frame.type != HTTPD_WS_TYPE_TEXT) {
+        return ESP_OK;
+    }
+
+    bool had_logs = client->sub.logs;
+    ws_cmd_status_t status = ws_subscription_apply(&client->sub, msg, frame.len);
+    if (client->sub.logs && !had_logs) {
+        client->log_cursor = log_buffer_cursor();
+    }
+    ws_update_log_interest();
+    return ws_send_reply(req, status);
 }
+#endif /* CONFIG_HTTPD_WS_SUPPORT */
 
 /**
- * @brief Handler for GET /api/sensors
+ * @brief Queued work: push the cycle's readings to every stream (httpd task)
  */
-static esp_err_t api_sensors_get_handler(httpd_req_t *req)
+static void readings_push_work(void *arg)
 {
-    CHECK_AUTH(req);
-    int count;
-    const managed_sensor_t *sensors = sensor_manager_get_sensors(&count);
+    sse_push_update();
+#if CONFIG_HTTPD_WS_SUPPORT
+    ws_push_readings();
+#endif
+}
 
-    cJSON *root = cJSON_CreateArray();
-    
-    for (int i = 0; i < count; i++) {
-        cJSON *sensor = cJSON_CreateObject();
-        cJSON_AddStringToObject(sensor, "address", sensors[i].address_str);
-        cJSON_AddNumberToObject(sensor, "temperature", sensors[i].hw_sensor.temperature);
-        cJSON_AddBoolToObject(sensor, "valid", sensors[i].hw_sensor.valid);
-        
-        if (sensors[i].has_friendly_name) {
-            cJSON_AddStringToObject(sensor, "friendly_name", sensors[i].friendly_name);
-        } else {
-            cJSON_AddNullToObject(sensor, "friendly_name");
-        }
-        
-        cJSON_AddNumberToObject(sensor, "total_reads", sensors[i].hw_sensor.total_reads);
-        cJSON_AddNumberToObject(sensor, "failed_reads", sensors[i].hw_sensor.failed_reads);
-        
-        cJSON_AddItemToArray(root, sensor);
+void web_server_notify_readings(void)
+{
+    /* Unsynchronized reads are fine: a stale count only skips or queues one push */
+    int streams = s_sse_client_count;
+#if CONFIG_HTTPD_WS_SUPPORT
+    streams += s_ws_client_count;
+#endif
+    if (s_server != NULL && streams > 0) {
+        httpd_queue_work(s_server, readings_push_work, NULL);
     }
-
-    char *json = cJSON_PrintUnformatted(root);
-    cJSON_Delete(root);
-
-    httpd_resp_set_type(req, "application/json");
-    httpd_resp_send(req, json, strlen(json));
-    free(json);
-    
-    return ESP_OK;
 }
 
 /**
@@ -402,6 +1615,7 @@ static esp_err_t api_sensors_get_handler(httpd_req_t *req)
 static esp_err_t api_sensors_rescan_handler(httpd_req_t *req)
 {
     CHECK_AUTH(req);
+    RUN_ASYNC(req);
     esp_err_t err = sensor_manager_rescan();
     
     cJSON *root = cJSON_CreateObject();
@@ -574,10 +1788,7 @@ static esp_err_t api_sensor_name_handler(httpd_req_t *req)
 static esp_err_t config_get_handler(httpd_req_t *req)
 {
     CHECK_PAGE_AUTH(req);
-    httpd_resp_set_type(req, "text/html");
-    httpd_resp_set_hdr(req, "Content-Encoding", "gzip");
-    httpd_resp_send(req, (const char *)config_html_gz_start, config_html_gz_end - config_html_gz_start);
-    return ESP_OK;
+    return send_gz_page(req, config_html_gz_start, config_html_gz_end);
 }
 
 /**
@@ -640,6 +1851,8 @@ static esp_err_t api_ota_status_handler(httpd_req_t *req)
     int download_progress = ota_get_download_progress();
     int received = 0, total = 0;
     ota_get_download_stats(&received, &total);
+    int resumed = 0, fetched = 0;
+    ota_get_resume_stats(&resumed, &fetched);
     
     ESP_LOGD(TAG, "OTA status: checking=%d, result=%d, update=%d, version=%s, update_state=%d, progress=%d%%",
              checking, result, update_available, latest_version, update_state, download_progress);
@@ -656,6 +1869,10 @@ static esp_err_t api_ota_status_handler(httpd_req_t *req)
     cJSON_AddNumberToObject(root, "download_progress", download_progress);
     cJSON_AddNumberToObject(root, "download_received", received);
     cJSON_AddNumberToObject(root, "download_total", total);
+    /* received = resumed + newly downloaded; fetched also counts bytes retried */
+    cJSON_AddNumberToObject(root, "download_resumed", resumed);
+    cJSON_AddNumberToObject(root, "download_new", received - resumed);
+    cJSON_AddNumberToObject(root, "download_fetched", fetched);
 #else
     cJSON_AddBoolToObject(root, "checking", false);
     cJSON_AddIntToObject(root, "result", -1);
@@ -666,6 +1883,46 @@ static esp_err_t api_ota_status_handler(httpd_req_t *req)
     cJSON_AddStringToObject(root, "error", "OTA disabled");
 #endif
 
+    /* Boot health check of the running image and boot timing per version */
+    static const char *const verdicts[] = { "checking", "healthy", "failed" };
+    boot_monitor_status_t boot;
+    boot_monitor_get_status(&boot);
+    const char *missing = boot_health_missing(&boot.health);
+    cJSON *health = cJSON_CreateObject();
+    cJSON_AddStringToObject(health, "state", verdicts[boot.verdict]);
+    cJSON_AddBoolToObject(health, "on_trial", boot.on_trial);
+    if (missing != NULL) {
+        cJSON_AddStringToObject(health, "missing", missing);
+    }
+    cJSON_AddNumberToObject(health, "budget_s", boot.health.budget_ms / 1000);
+    cJSON_AddNumberToObject(health, "expected_sensors", boot.health.expected_sensors);
+    cJSON_AddNumberToObject(health, "required_sensors", boot_health_required_sensors(&boot.health));
+    cJSON_AddNumberToObject(health, "sensors_found", boot.health.sensors_found);
+    cJSON_AddNumberToObject(health, "first_reading_ms", boot.health.first_cycle_ms);
+    cJSON_AddNumberToObject(health, "network_ms", boot.health.network_ms);
+    cJSON_AddNumberToObject(health, "mqtt_ms", boot.health.mqtt_ms);
+    cJSON_AddNumberToObject(health, "first_publish_ms", boot.health.first_publish_ms);
+    cJSON_AddStringToObject(health, "rolled_back_from", boot.rolled_back_from);
+    cJSON_AddItemToObject(root, "boot", health);
+
+    boot_metrics_t metrics;
+    boot_monitor_get_metrics(&metrics);
+    cJSON *versions = cJSON_CreateArray();
+    for (int i = 0; i < BOOT_METRICS_VERSIONS && metrics.entries[i].boots > 0; i++) {
+        const boot_metrics_entry_t *e = &metrics.entries[i];
+        cJSON *item = cJSON_CreateObject();
+        cJSON_AddStringToObject(item, "version", e->version);
+        cJSON_AddNumberToObject(item, "boots", e->boots);
+        cJSON_AddNumberToObject(item, "failed_boots", e->failed);
+        cJSON_AddNumberToObject(item, "sensors", e->sensors);
+        cJSON_AddNumberToObject(item, "avg_first_reading_ms", e->reading_avg_ms);
+        cJSON_AddNumberToObject(item, "avg_first_publish_ms", e->publish_avg_ms);
+        cJSON_AddNumberToObject(item, "last_first_reading_ms", e->last_reading_ms);
+        cJSON_AddNumberToObject(item, "last_first_publish_ms", e->last_publish_ms);
+        cJSON_AddItemToArray(versions, item);
+    }
+    cJSON_AddItemToObject(root, "boot_metrics", versions);
+
     char *json = cJSON_PrintUnformatted(root);
     cJSON_Delete(root);
 
@@ -709,126 +1966,225 @@ static esp_err_t api_ota_update_handler(httpd_req_t *req)
         httpd_resp_send(req, json, strlen(json));
         free(json);
     }
-#else
-    cJSON_AddBoolToObject(root, "started", false);
-    cJSON_AddStringToObject(root, "error", "OTA disabled");
-    
-    char *json = cJSON_PrintUnformatted(root);
-    cJSON_Delete(root);
-    
-    httpd_resp_set_type(req, "application/json");
-    httpd_resp_send(req, json, strlen(json));
-    free(json);
-#endif
-    
-    return ESP_OK;
+#else
+    cJSON_AddBoolToObject(root, "started", false);
+    cJSON_AddStringToObject(root, "error", "OTA disabled");
+    
+    char *json = cJSON_PrintUnformatted(root);
+    cJSON_Delete(root);
+    
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_send(req, json, strlen(json));
+    free(json);
+#endif
+    
+    return ESP_OK;
+}
+
+/**
+ * @brief Request body source for firmware uploads
+ *
+ * The first two bytes are peeked to tell a gzip image from a raw one and
+ * replayed to whichever path consumes the body.
+ */
+typedef struct {
+    httpd_req_t *req;
+    int remaining;              /* Bytes still to receive from the socket */
+    uint8_t head[2];
+    int head_len;
+    int head_pos;
+    uint32_t image_bytes;       /* Decompressed bytes passed to ota_writer */
+    bool bad_magic;
+} ota_upload_t;
+
+/**
+ * @brief Receive body bytes from the socket
+ * @return Bytes received, 0 at the end of the body, -1 on error
+ */
+static int ota_upload_recv(ota_upload_t *up, uint8_t *buf, size_t len)
+{
+    if (up->remaining <= 0) {
+        return 0;
+    }
+    for (;;) {
+        int recv_len = httpd_req_recv(up->req, (char *)buf, MIN((int)len, up->remaining));
+        if (recv_len == HTTPD_SOCK_ERR_TIMEOUT) {
+            continue;
+        }
+        if (recv_len <= 0) {
+            ESP_LOGE(TAG, "Receive error: %d", recv_len);
+            return -1;
+        }
+        up->remaining -= recv_len;
+        return recv_len;
+    }
+}
+
+static int ota_upload_read(void *ctx, uint8_t *buf, size_t len)
+{
+    ota_upload_t *up = ctx;
+    if (up->head_pos < up->head_len) {
+        int n = MIN((int)len, up->head_len - up->head_pos);
+        memcpy(buf, up->head + up->head_pos, n);
+        up->head_pos += n;
+        return n;
+    }
+    return ota_upload_recv(up, buf, len);
+}
+
+/**
+ * @brief gunzip sink: check the image magic, then hand the data to ota_writer
+ */
+static int ota_upload_write(void *ctx, const uint8_t *data, size_t len)
+{
+    ota_upload_t *up = ctx;
+    if (up->image_bytes == 0 && len > 0 && data[0] != 0xE9) {
+        up->bad_magic = true;
+        return -1;
+    }
+    up->image_bytes += len;
+    return ota_writer_write(data, len) == ESP_OK ? 0 : -1;
 }
 
 /**
  * @brief Handler for POST /api/ota/upload - Manual firmware upload
  * 
- * Expects raw binary firmware data (not multipart form)
+ * Expects raw binary firmware data (not multipart form), either the plain
+ * image or the gzip-compressed one from the build (thermux.bin.gz), told
+ * apart by the gzip magic. Receiving and flashing overlap: ota_writer
+ * flashes one buffer while the next is filled.
  */
 static esp_err_t api_ota_upload_handler(httpd_req_t *req)
 {
     CHECK_AUTH(req);
+    RUN_ASYNC(req);
     esp_err_t err;
-    esp_ota_handle_t ota_handle = 0;
     const esp_partition_t *update_partition = NULL;
-    char *buf = NULL;
-    const int buf_size = 4096;
-    int received = 0;
-    int remaining = req->content_len;
-    bool ota_started = false;
-    bool first_chunk = true;
+    ota_upload_t up = { .req = req, .remaining = req->content_len };
     
     ESP_LOGI(TAG, "Starting manual firmware upload, size: %d bytes", req->content_len);
     
     /* Validate content length */
-    if (req->content_len == 0 || req->content_len > 1500000) {
+    if (req->content_len < sizeof(up.head) || req->content_len > 1500000) {
         httpd_resp_set_status(req, "400 Bad Request");
         httpd_resp_set_type(req, "application/json");
         httpd_resp_sendstr(req, "{\"success\":false,\"message\":\"Invalid firmware size\"}");
         return ESP_FAIL;
     }
     
-    /* Allocate receive buffer */
-    buf = malloc(buf_size);
-    if (!buf) {
-        httpd_resp_set_status(req, "500 Internal Server Error");
-        httpd_resp_set_type(req, "application/json");
-        httpd_resp_sendstr(req, "{\"success\":false,\"message\":\"Memory allocation failed\"}");
-        return ESP_FAIL;
-    }
-    
     /* Get update partition */
     update_partition = esp_ota_get_next_update_partition(NULL);
     if (!update_partition) {
         ESP_LOGE(TAG, "No update partition found");
-        free(buf);
         httpd_resp_set_status(req, "500 Internal Server Error");
         httpd_resp_set_type(req, "application/json");
         httpd_resp_sendstr(req, "{\"success\":false,\"message\":\"No update partition available\"}");
         return ESP_FAIL;
     }
     
-    ESP_LOGD(TAG, "Writing to partition: %s at 0x%lx", update_partition->label, update_partition->address);
+    /* Peek at the format, straight from the socket: the head is only
+       replayed once it is complete */
+    while (up.head_len < (int)sizeof(up.head)) {
+        int n = ota_upload_recv(&up, up.head + up.head_len, sizeof(up.head) - up.head_len);
+        if (n <= 0) {
+            httpd_resp_set_status(req, "500 Internal Server Error");
+            httpd_resp_set_type(req, "application/json");
+            httpd_resp_sendstr(req, "{\"success\":false,\"message\":\"Upload failed\"}");
+            return ESP_FAIL;
+        }
+        up.head_len += n;
+    }
+    bool compressed = gunzip_is_gzip(up.head, sizeof(up.head));
     
-    /* Receive and write firmware data */
-    while (remaining > 0) {
-        int recv_len = httpd_req_recv(req, buf, MIN(remaining, buf_size));
-        if (recv_len < 0) {
-            if (recv_len == HTTPD_SOCK_ERR_TIMEOUT) {
-                continue;
-            }
-            ESP_LOGE(TAG, "Receive error: %d", recv_len);
+    /* A compressed image's size is only known at the end: erase on demand */
+    err = ota_writer_begin(update_partition, compressed ? 0 : req->content_len);
+    if (err == ESP_ERR_INVALID_STATE) {
+        httpd_resp_set_status(req, "409 Conflict");
+        httpd_resp_set_type(req, "application/json");
+        httpd_resp_sendstr(req, "{\"success\":false,\"message\":\"Update or boot health check in progress\"}");
+        return ESP_FAIL;
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "ota_writer_begin failed: %s", esp_err_to_name(err));
+        httpd_resp_set_status(req, "500 Internal Server Error");
+        httpd_resp_set_type(req, "application/json");
+        httpd_resp_sendstr(req, "{\"success\":false,\"message\":\"Failed to start OTA\"}");
+        return ESP_FAIL;
+    }
+    
+    if (compressed) {
+        gunzip_t *gz = malloc(sizeof(gunzip_t));
+        if (!gz) {
             goto upload_error;
         }
+        const gunzip_io_t io = {
+            .read = ota_upload_read,
+            .write = ota_upload_write,
+            .ctx = &up,
+        };
+        gunzip_init(gz, &io);
+        int result = gunzip_run(gz);
+        free(gz);
         
-        /* Validate first chunk contains valid ESP32 firmware */
-        if (first_chunk) {
-            if ((uint8_t)buf[0] != 0xE9) {
+        if (up.bad_magic) {
+            ESP_LOGE(TAG, "Compressed upload is not an ESP32 image");
+            goto invalid_image;
+        }
+        if (result != GUNZIP_OK) {
+            ESP_LOGE(TAG, "Decompression failed: %s", gunzip_strerror(result));
+            if (result == GUNZIP_ERR_TRUNCATED || result == GUNZIP_ERR_READ || result == GUNZIP_ERR_WRITE) {
+                goto upload_error;
+            }
+            ota_writer_abort();
+            httpd_resp_set_status(req, "400 Bad Request");
+            httpd_resp_set_type(req, "application/json");
+            httpd_resp_sendstr(req, "{\"success\":false,\"message\":\"Invalid compressed firmware file\"}");
+            return ESP_FAIL;
+        }
+        ESP_LOGD(TAG, "Decompressed %d -> %lu bytes", req->content_len, (unsigned long)up.image_bytes);
+    } else {
+        /* Receive firmware data; full buffers keep flash writes sector-sized */
+        int received = 0;
+        int remaining = req->content_len;
+        while (remaining > 0) {
+            char *buf = ota_writer_get_buffer();
+            if (!buf) {
+                goto upload_error;
+            }
+            int want = MIN(remaining, OTA_WRITER_BUFFER_SIZE);
+            int filled = 0;
+            while (filled < want) {
+                int recv_len = ota_upload_read(&up, (uint8_t *)buf + filled, want - filled);
+                if (recv_len <= 0) {
+                    goto upload_error;
+                }
+                filled += recv_len;
+            }
+            
+            /* Validate first chunk contains valid ESP32 firmware */
+            if (received == 0 && (uint8_t)buf[0] != 0xE9) {
                 ESP_LOGE(TAG, "Invalid firmware magic byte: 0x%02x (expected 0xE9)", (uint8_t)buf[0]);
-                free(buf);
-                httpd_resp_set_status(req, "400 Bad Request");
-                httpd_resp_set_type(req, "application/json");
-                httpd_resp_sendstr(req, "{\"success\":false,\"message\":\"Invalid firmware file - not an ESP32 binary\"}");
-                return ESP_FAIL;
+                goto invalid_image;
             }
             
-            /* Begin OTA now that we've validated the firmware */
-            err = esp_ota_begin(update_partition, OTA_WITH_SEQUENTIAL_WRITES, &ota_handle);
-            if (err != ESP_OK) {
-                ESP_LOGE(TAG, "esp_ota_begin failed: %s", esp_err_to_name(err));
-                free(buf);
-                httpd_resp_set_status(req, "500 Internal Server Error");
-                httpd_resp_set_type(req, "application/json");
-                httpd_resp_sendstr(req, "{\"success\":false,\"message\":\"Failed to start OTA\"}");
-                return ESP_FAIL;
+            if (ota_writer_submit(buf, filled) != ESP_OK) {
+                goto upload_error;
+            }
+            
+            received += filled;
+            remaining -= filled;
+            
+            if (received % 102400 == 0) {
+                ESP_LOGD(TAG, "Upload progress: %d/%d bytes", received, req->content_len);
             }
-            ota_started = true;
-            first_chunk = false;
-        }
-        
-        err = esp_ota_write(ota_handle, buf, recv_len);
-        if (err != ESP_OK) {
-            ESP_LOGE(TAG, "esp_ota_write failed: %s", esp_err_to_name(err));
-            goto upload_error;
-        }
-        
-        received += recv_len;
-        remaining -= recv_len;
-        
-        if (received % 102400 == 0) {
-            ESP_LOGD(TAG, "Upload progress: %d/%d bytes", received, req->content_len);
         }
     }
     
-    /* Finish OTA */
-    err = esp_ota_end(ota_handle);
+    /* Flush and validate */
+    ota_writer_stats_t stats;
+    err = ota_writer_end(&stats);
     if (err != ESP_OK) {
-        ESP_LOGE(TAG, "esp_ota_end failed: %s", esp_err_to_name(err));
-        free(buf);
+        ESP_LOGE(TAG, "ota_writer_end failed: %s", esp_err_to_name(err));
         httpd_resp_set_status(req, "500 Internal Server Error");
         httpd_resp_set_type(req, "application/json");
         httpd_resp_sendstr(req, "{\"success\":false,\"message\":\"Firmware validation failed - file may be corrupted\"}");
@@ -839,19 +2195,27 @@ static esp_err_t api_ota_upload_handler(httpd_req_t *req)
     err = esp_ota_set_boot_partition(update_partition);
     if (err != ESP_OK) {
         ESP_LOGE(TAG, "esp_ota_set_boot_partition failed: %s", esp_err_to_name(err));
-        free(buf);
         httpd_resp_set_status(req, "500 Internal Server Error");
         httpd_resp_set_type(req, "application/json");
         httpd_resp_sendstr(req, "{\"success\":false,\"message\":\"Failed to set boot partition\"}");
         return ESP_FAIL;
     }
     
-    free(buf);
-    
-    ESP_LOGI(TAG, "Manual firmware upload complete, restarting...");
+    uint32_t kbps = stats.elapsed_ms > 0 ? (uint32_t)((uint64_t)stats.bytes * 1000 / 1024 / stats.elapsed_ms) : 0;
+    ESP_LOGI(TAG, "Manual firmware upload complete (%lu KB/s, receive stalled %lu ms), restarting...",
+             (unsigned long)kbps, (unsigned long)stats.recv_stall_ms);
     
+    char resp[320];
+    snprintf(resp, sizeof(resp),
+             "{\"success\":true,\"message\":\"Firmware uploaded successfully, restarting...\","
+             "\"compressed\":%s,\"transfer_bytes\":%d,"
+             "\"bytes\":%lu,\"duration_ms\":%lu,\"throughput_kbps\":%lu,"
+             "\"recv_stall_ms\":%lu,\"flash_idle_ms\":%lu}",
+             compressed ? "true" : "false", req->content_len,
+             (unsigned long)stats.bytes, (unsigned long)stats.elapsed_ms, (unsigned long)kbps,
+             (unsigned long)stats.recv_stall_ms, (unsigned long)stats.flash_idle_ms);
     httpd_resp_set_type(req, "application/json");
-    httpd_resp_sendstr(req, "{\"success\":true,\"message\":\"Firmware uploaded successfully, restarting...\"}");
+    httpd_resp_sendstr(req, resp);
     
     /* Restart after short delay to allow response to be sent */
     vTaskDelay(pdMS_TO_TICKS(1000));
@@ -859,11 +2223,15 @@ static esp_err_t api_ota_upload_handler(httpd_req_t *req)
     
     return ESP_OK;
 
+invalid_image:
+    ota_writer_abort();
+    httpd_resp_set_status(req, "400 Bad Request");
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_sendstr(req, "{\"success\":false,\"message\":\"Invalid firmware file - not an ESP32 binary\"}");
+    return ESP_FAIL;
+
 upload_error:
-    if (ota_started) {
-        esp_ota_abort(ota_handle);
-    }
-    free(buf);
+    ota_writer_abort();
     httpd_resp_set_status(req, "500 Internal Server Error");
     httpd_resp_set_type(req, "application/json");
     httpd_resp_sendstr(req, "{\"success\":false,\"message\":\"Upload failed\"}");
@@ -876,6 +2244,7 @@ upload_error:
 static esp_err_t api_wifi_scan_handler(httpd_req_t *req)
 {
     CHECK_AUTH(req);
+    RUN_ASYNC(req);
     wifi_ap_record_t ap_records[20];
     uint16_t ap_count = 0;
     
@@ -927,25 +2296,67 @@ static esp_err_t api_wifi_scan_handler(httpd_req_t *req)
 }
 
 /**
- * @brief Handler for GET /api/logs - returns recent log buffer contents
+ * @brief Handler for GET /api/logs[?since=cursor] - streams buffered log output
+ *
+ * X-Log-Cursor is the position after the returned text, to pass as since=
+ * on the next poll. X-Log-Lost counts bytes overwritten before the client
+ * asked for them, X-Log-Dropped lines never captured since boot.
  */
 static esp_err_t api_logs_get_handler(httpd_req_t *req)
 {
     CHECK_AUTH(req);
-    /* Allocate buffer for logs (same size as ring buffer) */
-    char *log_data = malloc(LOG_BUFFER_SIZE);
-    if (!log_data) {
-        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Out of memory");
-        return ESP_FAIL;
+
+    /* ?since=<cursor> returns only output written after that position */
+    uint32_t cursor = 0;
+    char query[48];
+    char value[16];
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK &&
+        httpd_query_key_value(query, "since", value, sizeof(value)) == ESP_OK) {
+        char *end;
+        unsigned long since = strtoul(value, &end, 10);
+        if (end == value || *end != '\0' || since > UINT32_MAX) {
+            httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid cursor");
+            return ESP_OK;
+        }
+        cursor = since;
     }
-    
-    size_t len = log_buffer_get(log_data, LOG_BUFFER_SIZE);
-    
+
+    /* Stop at the current end so busy logging cannot keep the response open.
+       The ring is copied out in buffer-sized pieces between socket sends. */
+    uint32_t end = log_buffer_cursor();
+    uint32_t lost = 0;
+    size_t len = log_buffer_read_to(&cursor, end, s_json_resp_buf, sizeof(s_json_resp_buf), &lost);
+    if ((int32_t)(end - cursor) < 0) {
+        /* Reread after a cursor from the future caught up with new output */
+        end = cursor;
+    }
+
+    char cursor_hdr[12];
+    char lost_hdr[12];
+    char dropped_hdr[12];
+    snprintf(cursor_hdr, sizeof(cursor_hdr), "%lu", (unsigned long)end);
+    snprintf(lost_hdr, sizeof(lost_hdr), "%lu", (unsigned long)lost);
+    snprintf(dropped_hdr, sizeof(dropped_hdr), "%lu", (unsigned long)log_buffer_dropped());
     httpd_resp_set_type(req, "text/plain");
-    httpd_resp_send(req, log_data, len);
-    
-    free(log_data);
-    return ESP_OK;
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store");
+    httpd_resp_set_hdr(req, "X-Log-Cursor", cursor_hdr);
+    httpd_resp_set_hdr(req, "X-Log-Lost", lost_hdr);
+    httpd_resp_set_hdr(req, "X-Log-Dropped", dropped_hdr);
+
+    if (cursor == end) {
+        return httpd_resp_send(req, s_json_resp_buf, len);
+    }
+
+    while (len > 0) {
+        if (httpd_resp_send_chunk(req, s_json_resp_buf, len) != ESP_OK) {
+            return ESP_FAIL;
+        }
+        if ((int32_t)(end - cursor) <= 0) {
+            break;
+        }
+        len = log_buffer_read_to(&cursor, end, s_json_resp_buf, sizeof(s_json_resp_buf), NULL);
+    }
+    return httpd_resp_send_chunk(req, NULL, 0);
 }
 
 /**
@@ -961,21 +2372,34 @@ static esp_err_t api_logs_clear_handler(httpd_req_t *req)
     return ESP_OK;
 }
 
+static const char *const LOG_LEVEL_NAMES[] = {"none", "error", "warn", "info", "debug", "verbose"};
+
 /**
- * @brief Handler for GET /api/logs/level - returns current log level
+ * @brief Handler for GET /api/logs/level - returns current log levels
+ *
+ * "level" is the serial level; "capture" the level up to which lines go to
+ * the web log, with "tags" overriding it for single tags.
  */
 static esp_err_t api_logs_level_get_handler(httpd_req_t *req)
 {
     CHECK_AUTH(req);
-    /* Get current log level for "main" tag (representative of app) */
-    esp_log_level_t level = esp_log_level_get("main");
+    esp_log_level_t level = log_buffer_get_serial_level();
     
     cJSON *root = cJSON_CreateObject();
     cJSON_AddNumberToObject(root, "level", (int)level);
     
     /* Also provide human-readable name */
-    const char *level_names[] = {"none", "error", "warn", "info", "debug", "verbose"};
-    cJSON_AddStringToObject(root, "level_name", level_names[level]);
+    cJSON_AddStringToObject(root, "level_name", LOG_LEVEL_NAMES[level]);
+    cJSON_AddNumberToObject(root, "capture", (int)log_buffer_get_capture_level());
+    
+    cJSON *tags = cJSON_CreateObject();
+    const char *tag;
+    esp_log_level_t tag_level;
+    for (int i = log_buffer_next_tag_level(0, &tag, &tag_level); i >= 0;
+         i = log_buffer_next_tag_level(i, &tag, &tag_level)) {
+        cJSON_AddNumberToObject(tags, tag, (int)tag_level);
+    }
+    cJSON_AddItemToObject(root, "tags", tags);
     
     char *json = cJSON_PrintUnformatted(root);
     cJSON_Delete(root);
@@ -986,14 +2410,26 @@ static esp_err_t api_logs_level_get_handler(httpd_req_t *req)
     return ESP_OK;
 }
 
+static bool valid_log_level(const cJSON *item)
+{
+    return cJSON_IsNumber(item) && item->valueint >= ESP_LOG_NONE && item->valueint <= ESP_LOG_VERBOSE;
+}
+
 /**
- * @brief Handler for POST /api/logs/level - sets log level
+ * @brief Handler for POST /api/logs/level - sets log levels
  * Body: {"level": 3} where 0=none, 1=error, 2=warn, 3=info, 4=debug, 5=verbose
+ * sets serial and capture level together. Any of {"serial": 2, "capture": 4,
+ * "tags": {"wifi": 2, "httpd_uri": null}} sets them separately; null returns
+ * a tag to the capture level.
  */
 static esp_err_t api_logs_level_post_handler(httpd_req_t *req)
 {
     CHECK_AUTH(req);
-    char content[64];
+    char content[256];
+    if (req->content_len >= sizeof(content)) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Content too long");
+        return ESP_FAIL;
+    }
     int received = httpd_req_recv(req, content, sizeof(content) - 1);
     if (received <= 0) {
         httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "No content");
@@ -1008,30 +2444,304 @@ static esp_err_t api_logs_level_post_handler(httpd_req_t *req)
     }
     
     cJSON *level_json = cJSON_GetObjectItem(root, "level");
-    if (!level_json || !cJSON_IsNumber(level_json)) {
+    cJSON *serial_json = cJSON_GetObjectItem(root, "serial");
+    cJSON *capture_json = cJSON_GetObjectItem(root, "capture");
+    cJSON *tags_json = cJSON_GetObjectItem(root, "tags");
+    if (!level_json && !serial_json && !capture_json && !tags_json) {
         cJSON_Delete(root);
         httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Missing level");
         return ESP_FAIL;
     }
     
-    int level = level_json->valueint;
-    cJSON_Delete(root);
-    
-    if (level < 0 || level > 5) {
+    /* Check everything before changing anything */
+    bool valid = (!level_json || valid_log_level(level_json)) &&
+                 (!serial_json || valid_log_level(serial_json)) &&
+                 (!capture_json || valid_log_level(capture_json)) &&
+                 (!tags_json || cJSON_IsObject(tags_json));
+    cJSON *item;
+    if (valid && tags_json) {
+        cJSON_ArrayForEach(item, tags_json) {
+            if ((!cJSON_IsNull(item) && !valid_log_level(item)) ||
+                item->string[0] == '\0' || strlen(item->string) >= LOG_FILTER_TAG_MAX) {
+                valid = false;
+            }
+        }
+    }
+    if (!valid) {
+        cJSON_Delete(root);
         httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid level (0-5)");
         return ESP_FAIL;
     }
     
-    /* Set log level for all components */
-    esp_log_level_set("*", (esp_log_level_t)level);
+    if (level_json) {
+        log_buffer_set_level((esp_log_level_t)level_json->valueint);
+        ESP_LOGI(TAG, "Log level changed to %d", level_json->valueint);
+    }
+    if (serial_json) {
+        log_buffer_set_serial_level((esp_log_level_t)serial_json->valueint);
+    }
+    if (capture_json) {
+        log_buffer_set_capture_level((esp_log_level_t)capture_json->valueint);
+    }
+    esp_err_t err = ESP_OK;
+    if (tags_json) {
+        cJSON_ArrayForEach(item, tags_json) {
+            if (cJSON_IsNull(item)) {
+                log_buffer_clear_tag_level(item->string);
+            } else if (err == ESP_OK) {
+                err = log_buffer_set_tag_level(item->string, (esp_log_level_t)item->valueint);
+            }
+        }
+    }
+    cJSON_Delete(root);
     
-    ESP_LOGI(TAG, "Log level changed to %d", level);
+    if (err != ESP_OK) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Too many tags with their own level");
+        return ESP_FAIL;
+    }
     
     httpd_resp_set_type(req, "application/json");
     httpd_resp_sendstr(req, "{\"success\":true}");
     return ESP_OK;
 }
 
+#if CONFIG_OTA_PEER_CACHE
+#define OTA_IMAGE_CHUNK 4096
+
+/* One peer download at a time, so the other worker stays free for the UI */
+static portMUX_TYPE s_ota_image_lock = portMUX_INITIALIZER_UNLOCKED;
+static bool s_ota_image_busy = false;
+static uint32_t s_ota_image_len = 0;   /* Length of the running image, once measured */
+
+static void send_ota_image_unavailable(httpd_req_t *req, const char *why)
+{
+    httpd_resp_set_status(req, "503 Service Unavailable");
+    httpd_resp_set_hdr(req, "Retry-After", "60");
+    httpd_resp_sendstr(req, why);
+}
+
+/**
+ * @brief Stream the running image from offset start with raw headers
+ *
+ * httpd only sends a body of known length in one piece, so the status line
+ * and headers are written by hand and the partition follows 4 KB at a time.
+ */
+static esp_err_t send_ota_image(httpd_req_t *req, const esp_partition_t *running, uint32_t start)
+{
+    char *buf = malloc(OTA_IMAGE_CHUNK);
+    if (buf == NULL) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Out of memory");
+        return ESP_FAIL;
+    }
+
+    char range[64] = "";
+    if (start > 0) {
+        snprintf(range, sizeof(range), "Content-Range: bytes %lu-%lu/%lu\r\n",
+                 (unsigned long)start, (unsigned long)(s_ota_image_len - 1), (unsigned long)s_ota_image_len);
+    }
+    int len = snprintf(buf, OTA_IMAGE_CHUNK,
+                       "HTTP/1.1 %s\r\n"
+                       "Content-Type: application/octet-stream\r\n"
+                       "Content-Length: %lu\r\n"
+                       "%s"
+                       "X-Thermux-Version: %s\r\n"
+                       "Connection: close\r\n\r\n",
+                       start > 0 ? "206 Partial Content" : "200 OK",
+                       (unsigned long)(s_ota_image_len - start), range, APP_VERSION);
+    esp_err_t err = httpd_send(req, buf, len) == len ? ESP_OK : ESP_FAIL;
+
+    for (uint32_t off = start; off < s_ota_image_len && err == ESP_OK; off += OTA_IMAGE_CHUNK) {
+        uint32_t n = s_ota_image_len - off;
+        if (n > OTA_IMAGE_CHUNK) {
+            n = OTA_IMAGE_CHUNK;
+        }
+        err = esp_partition_read(running, off, buf, n);
+        for (uint32_t sent = 0; sent < n && err == ESP_OK; ) {
+            int ret = httpd_send(req, buf + sent, n - sent);
+            if (ret <= 0) {
+                err = ESP_FAIL;
+            } else {
+                sent += ret;
+            }
+        }
+    }
+    free(buf);
+
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Image transfer to a peer stopped: %s", esp_err_to_name(err));
+        return ESP_FAIL;  /* Closes the connection */
+    }
+    ESP_LOGI(TAG, "Served %lu image bytes to a peer", (unsigned long)(s_ota_image_len - start));
+    return ESP_OK;
+}
+
+/**
+ * @brief Check the X-Peer-Secret header against the fleet's shared secret
+ * @return false if no peer secret is configured
+ */
+static bool is_peer_secret_valid(httpd_req_t *req)
+{
+    static const char secret[] = CONFIG_OTA_PEER_SECRET;
+    if (secret[0] == '\0') {
+        return false;
+    }
+    /* One spare byte: a longer header comes back truncated and is rejected */
+    char value[sizeof(secret) + 1];
+    if (httpd_req_get_hdr_value_str(req, "X-Peer-Secret", value, sizeof(value)) != ESP_OK) {
+        return false;
+    }
+    return auth_secret_equal(value, secret);
+}
+
+/**
+ * @brief Handler for GET /api/ota/image - the running image, for peers updating to this version
+ *
+ * The image holds the credentials compiled into the firmware, so it needs
+ * the API key, a session or the peer secret. Only served once this image
+ * has passed the boot health check, and resumable with "Range: bytes=N-".
+ */
+static esp_err_t api_ota_image_handler(httpd_req_t *req)
+{
+    if (!is_peer_secret_valid(req)) {
+        CHECK_AUTH(req);
+    }
+    boot_monitor_status_t boot;
+    boot_monitor_get_status(&boot);
+    if (boot.verdict != BOOT_HEALTH_PASSED) {
+        send_ota_image_unavailable(req, "Image not confirmed yet");
+        return ESP_OK;
+    }
+    RUN_ASYNC(req);
+
+    portENTER_CRITICAL(&s_ota_image_lock);
+    bool busy = s_ota_image_busy;
+    s_ota_image_busy = true;
+    portEXIT_CRITICAL(&s_ota_image_lock);
+    if (busy) {
+        send_ota_image_unavailable(req, "Already serving the image");
+        return ESP_OK;
+    }
+
+    const esp_partition_t *running = esp_ota_get_running_partition();
+    if (s_ota_image_len == 0) {
+        const esp_partition_pos_t pos = {
+            .offset = running->address,
+            .size = running->size,
+        };
+        esp_image_metadata_t meta;
+        if (esp_image_verify(ESP_IMAGE_VERIFY_SILENT, &pos, &meta) == ESP_OK) {
+            s_ota_image_len = meta.image_len;
+        }
+    }
+
+    esp_err_t err;
+    char range[32];
+    uint32_t start = 0;
+    if (s_ota_image_len == 0) {
+        httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Cannot read the running image");
+        err = ESP_FAIL;
+    } else if (httpd_req_get_hdr_value_str(req, "Range", range, sizeof(range)) == ESP_OK &&
+               strncmp(range, "bytes=", 6) == 0 && (start = strtoul(range + 6, NULL, 10)) >= s_ota_image_len) {
+        httpd_resp_set_status(req, "416 Range Not Satisfiable");
+        httpd_resp_sendstr(req, "Range outside the image");
+        err = ESP_OK;
+    } else {
+        err = send_ota_image(req, running, start);
+    }
+
+    portENTER_CRITICAL(&s_ota_image_lock);
+    s_ota_image_busy = false;
+    portEXIT_CRITICAL(&s_ota_image_lock);
+    return err;
+}
+#endif
+
+/**
+ * @brief Handler for GET /api/config/ota
+ */
+static esp_err_t api_config_ota_get_handler(httpd_req_t *req)
+{
+    CHECK_AUTH(req);
+    cJSON *root = cJSON_CreateObject();
+    
+#if CONFIG_OTA_ENABLED
+    char source_url[OTA_SOURCE_URL_MAX];
+    ota_get_source_url(source_url, sizeof(source_url));
+    cJSON_AddStringToObject(root, "source_url", source_url);
+#else
+    cJSON_AddStringToObject(root, "error", "OTA disabled");
+#endif
+#if CONFIG_OTA_PEER_CACHE
+    cJSON_AddBoolToObject(root, "peer_cache", true);
+#else
+    cJSON_AddBoolToObject(root, "peer_cache", false);
+#endif
+    
+    char *json = cJSON_PrintUnformatted(root);
+    cJSON_Delete(root);
+    
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_send(req, json, strlen(json));
+    free(json);
+    
+    return ESP_OK;
+}
+
+/**
+ * @brief Handler for POST /api/config/ota
+ */
+static esp_err_t api_config_ota_post_handler(httpd_req_t *req)
+{
+    CHECK_AUTH(req);
+#if CONFIG_OTA_ENABLED
+    char content[OTA_SOURCE_URL_MAX + 64];
+    int ret = httpd_req_recv(req, content, sizeof(content) - 1);
+    if (ret <= 0) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "No body");
+        return ESP_FAIL;
+    }
+    content[ret] = '\0';
+    
+    cJSON *root = cJSON_Parse(content);
+    if (root == NULL) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Invalid JSON");
+        return ESP_FAIL;
+    }
+    
+    cJSON *source_item = cJSON_GetObjectItem(root, "source_url");
+    if (!cJSON_IsString(source_item)) {
+        cJSON_Delete(root);
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "Missing source_url");
+        return ESP_FAIL;
+    }
+    
+    esp_err_t err = ota_set_source_url(source_item->valuestring);
+    cJSON_Delete(root);
+    if (err == ESP_ERR_INVALID_ARG || err == ESP_ERR_INVALID_SIZE) {
+        httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "source_url must be an http(s) URL or empty");
+        return ESP_FAIL;
+    }
+    
+    cJSON *response = cJSON_CreateObject();
+    cJSON_AddBoolToObject(response, "success", err == ESP_OK);
+    if (err == ESP_OK) {
+        cJSON_AddStringToObject(response, "message", "Update source saved");
+    }
+    
+    char *json = cJSON_PrintUnformatted(response);
+    cJSON_Delete(response);
+    
+    httpd_resp_set_type(req, "application/json");
+    httpd_resp_send(req, json, strlen(json));
+    free(json);
+    
+    return ESP_OK;
+#else
+    httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "OTA disabled");
+    return ESP_FAIL;
+#endif
+}
+
 /**
  * @brief Handler for GET /api/config/wifi
  */
@@ -1495,12 +3205,14 @@ static esp_err_t api_auth_login_handler(httpd_req_t *req)
     cJSON *password = cJSON_GetObjectItem(root, "password");
 
     bool success = false;
-    const char *session_token = NULL;
+    char session_token[AUTH_TOKEN_BUF_SIZE];
     if (cJSON_IsString(username) && cJSON_IsString(password)) {
-        if (strcmp(username->valuestring, s_auth_username) == 0 &&
-            strcmp(password->valuestring, s_auth_password) == 0) {
+        /* Both compared in full so timing does not reveal which was wrong */
+        bool user_ok = auth_secret_equal(username->valuestring, s_auth_username);
+        bool password_ok = auth_secret_equal(password->valuestring, s_auth_password);
+        if (user_ok && password_ok) {
             success = true;
-            session_token = generate_session_token();
+            create_session(session_token);
             ESP_LOGI(TAG, "User '%s' logged in", s_auth_username);
         } else {
             ESP_LOGW(TAG, "Failed login attempt for user '%s'", 
@@ -1512,9 +3224,9 @@ static esp_err_t api_auth_login_handler(httpd_req_t *req)
     cJSON *response = cJSON_CreateObject();
     cJSON_AddBoolToObject(response, "success", success);
 
-    if (success && session_token) {
+    if (success) {
         /* Set session cookie */
-        char cookie[80];
+        char cookie[96];
         snprintf(cookie, sizeof(cookie), "session=%s; Path=/; HttpOnly; SameSite=Strict", session_token);
         httpd_resp_set_hdr(req, "Set-Cookie", cookie);
     }
@@ -1534,32 +3246,16 @@ static esp_err_t api_auth_login_handler(httpd_req_t *req)
  */
 static esp_err_t api_auth_logout_handler(httpd_req_t *req)
 {
-    /* Get the session token from cookie and clear that specific session */
-    size_t cookie_len = httpd_req_get_hdr_value_len(req, "Cookie");
-    if (cookie_len > 0) {
-        char *cookie = malloc(cookie_len + 1);
-        if (cookie && httpd_req_get_hdr_value_str(req, "Cookie", cookie, cookie_len + 1) == ESP_OK) {
-            char *session_start = strstr(cookie, "session=");
-            if (session_start) {
-                session_start += 8;
-                char token[33] = {0};
-                int i = 0;
-                while (session_start[i] && session_start[i] != ';' && i < 32) {
-                    token[i] = session_start[i];
-                    i++;
-                }
-                /* Find and clear matching session */
-                for (int j = 0; j < MAX_SESSIONS; j++) {
-                    if (strcmp(token, s_sessions[j].token) == 0) {
-                        s_sessions[j].token[0] = '\0';
-                        s_sessions[j].expiry = 0;
-                        break;
-                    }
-                }
-            }
-        }
-        free(cookie);
+    /* Forget the session (signed tokens cannot be revoked; they lapse at
+       their expiry or on reboot) */
+#if !CONFIG_WEB_AUTH_SIGNED_SESSIONS
+    char token[AUTH_TOKEN_BUF_SIZE];
+    if (get_session_cookie(req, token)) {
+        portENTER_CRITICAL(&s_sessions_lock);
+        auth_sessions_remove(&s_sessions, token);
+        portEXIT_CRITICAL(&s_sessions_lock);
     }
+#endif
     ESP_LOGI(TAG, "User logged out");
 
     /* Clear cookie */
@@ -1730,13 +3426,43 @@ esp_err_t web_server_start(void)
 {
     /* Load auth config from NVS */
     load_auth_config();
+
+    for (int i = 0; i < SSE_MAX_CLIENTS; i++) {
+        s_sse_clients[i].fd = -1;
+        s_sse_clients[i].closing = false;
+        s_sse_clients[i].missed = 0;
+    }
+    s_sse_client_count = 0;
+    s_endpoint_count = 0;
+    async_workers_init();
+    rate_limit_setup();
+#if CONFIG_WEB_AUTH_SIGNED_SESSIONS
+    esp_fill_random(s_session_key, sizeof(s_session_key));
+#endif
+    snprintf(s_boot_tag, sizeof(s_boot_tag), "%08lx", (unsigned long)esp_random());
+#if CONFIG_HTTPD_WS_SUPPORT
+    for (int i = 0; i < WS_MAX_CLIENTS; i++) {
+        s_ws_clients[i].fd = -1;
+        s_ws_clients[i].closing = false;
+    }
+    s_ws_client_count = 0;
+    s_ws_logs_wanted = false;
+    if (s_ws_log_timer == NULL) {
+        const esp_timer_create_args_t timer_args = {
+            .callback = ws_log_timer_cb,
+            .name = "ws_logs",
+        };
+        esp_timer_create(&timer_args, &s_ws_log_timer);
+    }
+    log_buffer_set_listener(ws_log_listener);
+#endif
     
     ESP_LOGD(TAG, "Starting web server on port %d", CONFIG_WEB_SERVER_PORT);
 
     httpd_config_t config = HTTPD_DEFAULT_CONFIG();
     config.server_port = CONFIG_WEB_SERVER_PORT;
     config.uri_match_fn = httpd_uri_match_wildcard;
-    config.max_uri_handlers = 32;  /* 28 endpoints + room for future */
+    config.max_uri_handlers = MAX_URI_HANDLERS;  /* 40 endpoints + room for future */
 
     esp_err_t err = httpd_start(&s_server, &config);
     if (err != ESP_OK) {
@@ -1746,6 +3472,7 @@ esp_err_t web_server_start(void)
 
     /* Helper macro to register URI handler with error checking */
     #define REGISTER_URI(uri_cfg) do { \
+        track_endpoint(&uri_cfg); \
         esp_err_t ret = httpd_register_uri_handler(s_server, &uri_cfg); \
         if (ret != ESP_OK) { \
             ESP_LOGE(TAG, "ERROR: Failed to register %s - increase max_uri_handlers!", uri_cfg.uri); \
@@ -1803,6 +3530,44 @@ esp_err_t web_server_start(void)
     };
     REGISTER_URI(sensors_uri);
 
+    httpd_uri_t events_uri = {
+        .uri = "/api/events",
+        .method = HTTP_GET,
+        .handler = api_events_handler,
+    };
+    REGISTER_URI(events_uri);
+
+    httpd_uri_t dashboard_uri = {
+        .uri = "/api/dashboard",
+        .method = HTTP_GET,
+        .handler = api_dashboard_handler,
+    };
+    REGISTER_URI(dashboard_uri);
+
+    httpd_uri_t export_uri = {
+        .uri = "/api/export",
+        .method = HTTP_GET,
+        .handler = api_export_handler,
+    };
+    REGISTER_URI(export_uri);
+
+    httpd_uri_t metrics_uri = {
+        .uri = "/metrics",
+        .method = HTTP_GET,
+        .handler = metrics_handler,
+    };
+    REGISTER_URI(metrics_uri);
+
+#if CONFIG_HTTPD_WS_SUPPORT
+    httpd_uri_t ws_uri = {
+        .uri = "/ws",
+        .method = HTTP_GET,
+        .handler = ws_handler,
+        .is_websocket = true,
+    };
+    REGISTER_URI(ws_uri);
+#endif
+
     httpd_uri_t rescan_uri = {
         .uri = "/api/sensors/rescan",
         .method = HTTP_POST,
@@ -1852,6 +3617,15 @@ esp_err_t web_server_start(void)
     };
     REGISTER_URI(ota_upload_uri);
 
+#if CONFIG_OTA_PEER_CACHE
+    httpd_uri_t ota_image_uri = {
+        .uri = "/api/ota/image",
+        .method = HTTP_GET,
+        .handler = api_ota_image_handler,
+    };
+    REGISTER_URI(ota_image_uri);
+#endif
+
     /* Configuration page */
     httpd_uri_t config_uri = {
         .uri = "/config",
@@ -1927,6 +3701,21 @@ esp_err_t web_server_start(void)
     };
     REGISTER_URI(mqtt_config_post_uri);
 
+    /* Update source endpoints */
+    httpd_uri_t ota_config_get_uri = {
+        .uri = "/api/config/ota",
+        .method = HTTP_GET,
+        .handler = api_config_ota_get_handler,
+    };
+    REGISTER_URI(ota_config_get_uri);
+
+    httpd_uri_t ota_config_post_uri = {
+        .uri = "/api/config/ota",
+        .method = HTTP_POST,
+        .handler = api_config_ota_post_handler,
+    };
+    REGISTER_URI(ota_config_post_uri);
+
     httpd_uri_t mqtt_reconnect_uri = {
         .uri = "/api/mqtt/reconnect",
         .method = HTTP_POST,
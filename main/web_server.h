@@ -18,4 +18,12 @@ esp_err_t web_server_start(void);
  */
 esp_err_t web_server_stop(void);
 
+/**
+ * @brief Push new readings to /api/events and /ws subscribers
+ *
+ * Call after each acquisition cycle. Safe from any task; the event is
+ * built and sent on the web server task.
+ */
+void web_server_notify_readings(void);
+
 #endif /* WEB_SERVER_H */
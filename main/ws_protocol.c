@@ -0,0 +1,221 @@
+/**
+ * @file ws_protocol.c
+ * @brief WebSocket subscription commands and reading frames (host-testable)
+ */
+
+#include "ws_protocol.h"
+#include "telemetry_cbor.h"
+#include <ctype.h>
+#include <string.h>
+
+void ws_subscription_init(ws_subscription_t *sub)
+{
+    memset(sub, 0, sizeof(*sub));
+    sub->format = WS_FORMAT_JSON;
+}
+
+/**
+ * @brief Next whitespace-separated token
+ * @return Token length, 0 at end of input
+ */
+static size_t next_token(const char **pos, const char *end, const char **token)
+{
+    while (*pos < end && isspace((unsigned char)**pos)) {
+        (*pos)++;
+    }
+    *token = *pos;
+    while (*pos < end && !isspace((unsigned char)**pos)) {
+        (*pos)++;
+    }
+    return (size_t)(*pos - *token);
+}
+
+static bool token_is(const char *token, size_t len, const char *word)
+{
+    return strlen(word) == len && strncmp(token, word, len) == 0;
+}
+
+static bool parse_address(const char *token, size_t len, uint64_t *id)
+{
+    if (len != 16) {
+        return false;
+    }
+    *id = 0;
+    for (size_t i = 0; i < len; i++) {
+        char c = token[i];
+        int digit;
+        if (c >= '0' && c <= '9') {
+            digit = c - '0';
+        } else if (c >= 'a' && c <= 'f') {
+            digit = c - 'a' + 10;
+        } else if (c >= 'A' && c <= 'F') {
+            digit = c - 'A' + 10;
+        } else {
+            return false;
+        }
+        *id = (*id << 4) | (uint64_t)digit;
+    }
+    return true;
+}
+
+static int find_id(const ws_subscription_t *sub, uint64_t id)
+{
+    for (int i = 0; i < sub->count; i++) {
+        if (sub->ids[i] == id) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static ws_cmd_status_t apply_target(ws_subscription_t *sub, bool subscribe,
+                                    const char *token, size_t len)
+{
+    if (token_is(token, len, "logs")) {
+        sub->logs = subscribe;
+        return WS_CMD_OK;
+    }
+    if (token_is(token, len, "*")) {
+        sub->all_sensors = subscribe;
+        if (!subscribe) {
+            sub->count = 0;
+        }
+        return WS_CMD_OK;
+    }
+
+    uint64_t id;
+    if (!parse_address(token, len, &id)) {
+        return WS_CMD_ERR_TARGET;
+    }
+
+    int index = find_id(sub, id);
+    if (subscribe) {
+        if (index >= 0) {
+            return WS_CMD_OK;
+        }
+        if (sub->count >= WS_MAX_SENSOR_SUBSCRIPTIONS) {
+            return WS_CMD_ERR_FULL;
+        }
+        sub->ids[sub->count++] = id;
+    } else if (index >= 0) {
+        sub->ids[index] = sub->ids[--sub->count];
+    }
+    return WS_CMD_OK;
+}
+
+ws_cmd_status_t ws_subscription_apply(ws_subscription_t *sub, const char *msg, size_t len)
+{
+    const char *pos = msg;
+    const char *end = msg + len;
+    const char *token;
+    size_t token_len = next_token(&pos, end, &token);
+
+    if (token_is(token, token_len, "format")) {
+        token_len = next_token(&pos, end, &token);
+        if (token_is(token, token_len, "json")) {
+            sub->format = WS_FORMAT_JSON;
+        } else if (token_is(token, token_len, "binary")) {
+            sub->format = WS_FORMAT_BINARY;
+        } else {
+            return WS_CMD_ERR_SYNTAX;
+        }
+        return WS_CMD_OK;
+    }
+
+    bool subscribe;
+    if (token_is(token, token_len, "subscribe")) {
+        subscribe = true;
+    } else if (token_is(token, token_len, "unsubscribe")) {
+        subscribe = false;
+    } else {
+        return WS_CMD_ERR_SYNTAX;
+    }
+
+    int targets = 0;
+    while ((token_len = next_token(&pos, end, &token)) > 0) {
+        ws_cmd_status_t status = apply_target(sub, subscribe, token, token_len);
+        if (status != WS_CMD_OK) {
+            return status;
+        }
+        targets++;
+    }
+    return targets > 0 ? WS_CMD_OK : WS_CMD_ERR_SYNTAX;
+}
+
+bool ws_subscription_wants(const ws_subscription_t *sub, uint64_t id)
+{
+    return sub->all_sensors || find_id(sub, id) >= 0;
+}
+
+bool ws_subscription_has_sensors(const ws_subscription_t *sub)
+{
+    return sub->all_sensors || sub->count > 0;
+}
+
+const char *ws_cmd_status_str(ws_cmd_status_t status)
+{
+    switch (status) {
+    case WS_CMD_OK:         return "OK";
+    case WS_CMD_ERR_SYNTAX: return "Unknown command";
+    case WS_CMD_ERR_TARGET: return "Invalid target";
+    case WS_CMD_ERR_FULL:   return "Too many subscriptions";
+    default:                return "Unknown error";
+    }
+}
+
+void ws_write_reading_json(json_writer_t *w, const ws_reading_t *reading)
+{
+    json_writer_begin_object(w);
+    json_writer_kv_string(w, "address", reading->address);
+    json_writer_kv_double(w, "temperature", reading->temperature);
+    json_writer_kv_bool(w, "valid", reading->valid);
+    json_writer_end_object(w);
+}
+
+bool ws_write_reading_cbor(cbor_writer_t *w, const ws_reading_t *reading)
+{
+    telemetry_reading_t entry;
+    uint64_t id;
+
+    if (!reading->valid || !parse_address(reading->address, strlen(reading->address), &id)) {
+        return false;
+    }
+    telemetry_id_to_rom(id, entry.rom);
+    entry.temp_centi = telemetry_temp_to_centi(reading->temperature);
+    entry.timestamp = 0;
+
+    telemetry_cbor_begin(w, 0, 1);
+    telemetry_cbor_add(w, &entry);
+    return true;
+}
+
+size_t ws_frame_header(uint8_t out[WS_FRAME_HEADER_MAX], uint8_t opcode, size_t len)
+{
+    out[0] = 0x80 | (opcode & 0x0F);    /* FIN */
+    if (len < 126) {
+        out[1] = (uint8_t)len;
+        return 2;
+    }
+    if (len > 0xFFFF) {
+        return 0;
+    }
+    out[1] = 126;
+    out[2] = (uint8_t)(len >> 8);
+    out[3] = (uint8_t)len;
+    return 4;
+}
+
+size_t ws_utf8_boundary(const char *text, size_t len)
+{
+    /* Back over continuation bytes to the last lead byte */
+    size_t i = len;
+    while (i > 0 && len - i < 3 && ((uint8_t)text[i - 1] & 0xC0) == 0x80) {
+        i--;
+    }
+    if (i == 0) {
+        return len;
+    }
+    uint8_t lead = (uint8_t)text[i - 1];
+    size_t need = lead >= 0xF0 ? 4 : lead >= 0xE0 ? 3 : lead >= 0xC0 ? 2 : 1;
+    return len - (i - 1) < need ? i - 1 : len;
+}
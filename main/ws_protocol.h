@@ -0,0 +1,123 @@
+/**
+ * @file ws_protocol.h
+ * @brief WebSocket subscription commands and reading frames (host-testable)
+ *
+ * Clients send text frames with whitespace-separated commands:
+ *
+ *   subscribe <target>...     target: 16-digit sensor address, "*" or "logs"
+ *   unsubscribe <target>...
+ *   format json|binary
+ *
+ * Readings of subscribed sensors are pushed after every acquisition cycle,
+ * as JSON text frames or as binary frames holding a one-reading CBOR
+ * telemetry batch (see telemetry_cbor.h). Log output is pushed as text.
+ */
+
+#ifndef WS_PROTOCOL_H
+#define WS_PROTOCOL_H
+
+#include "json_writer.h"
+#include "cbor_writer.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/** @brief Individual sensors a client can follow */
+#define WS_MAX_SENSOR_SUBSCRIPTIONS 8
+
+/** @brief Largest accepted command frame */
+#define WS_MAX_COMMAND_LEN 256
+
+typedef enum {
+    WS_FORMAT_JSON = 0,
+    WS_FORMAT_BINARY,
+} ws_format_t;
+
+/**
+ * @brief Per-client subscription state
+ */
+typedef struct {
+    uint64_t ids[WS_MAX_SENSOR_SUBSCRIPTIONS];  /**< Sensor ROM ids */
+    uint8_t count;                              /**< Entries used in ids */
+    bool all_sensors;                           /**< Subscribed with "*" */
+    bool logs;                                  /**< Log stream */
+    ws_format_t format;                         /**< Reading frame format */
+} ws_subscription_t;
+
+typedef enum {
+    WS_CMD_OK = 0,
+    WS_CMD_ERR_SYNTAX,       /**< Unknown command or missing argument */
+    WS_CMD_ERR_TARGET,       /**< Malformed address or unknown target */
+    WS_CMD_ERR_FULL,         /**< Too many sensor subscriptions */
+} ws_cmd_status_t;
+
+void ws_subscription_init(ws_subscription_t *sub);
+
+/**
+ * @brief Apply one command frame
+ *
+ * Targets are applied in order; on error the targets before the failing
+ * one stay applied.
+ *
+ * @param sub Subscription to update
+ * @param msg Command text (not NUL-terminated)
+ * @param len Command length
+ */
+ws_cmd_status_t ws_subscription_apply(ws_subscription_t *sub, const char *msg, size_t len);
+
+/**
+ * @brief Whether readings of a sensor should be sent to this client
+ */
+bool ws_subscription_wants(const ws_subscription_t *sub, uint64_t id);
+
+/**
+ * @brief Whether the client follows any sensor
+ */
+bool ws_subscription_has_sensors(const ws_subscription_t *sub);
+
+const char *ws_cmd_status_str(ws_cmd_status_t status);
+
+/**
+ * @brief Reading as pushed to subscribers
+ */
+typedef struct {
+    const char *address;    /**< Address string */
+    float temperature;      /**< Celsius */
+    bool valid;             /**< Last read succeeded */
+} ws_reading_t;
+
+/**
+ * @brief Write a JSON reading frame
+ */
+void ws_write_reading_json(json_writer_t *w, const ws_reading_t *reading);
+
+/**
+ * @brief Write a binary reading frame (CBOR telemetry batch of one)
+ *
+ * Frames are pushed as soon as a reading is taken, so the batch carries no
+ * timestamps (0, "unknown" in the telemetry schema). Invalid readings
+ * are not representable in the schema and produce no frame.
+ *
+ * @return false if the reading was skipped
+ */
+bool ws_write_reading_cbor(cbor_writer_t *w, const ws_reading_t *reading);
+
+/** @brief Largest server frame header (payloads up to 64 KB) */
+#define WS_FRAME_HEADER_MAX 4
+
+/**
+ * @brief Header of a final, unmasked server frame (RFC 6455 section 5.2)
+ * @param opcode 0x1 text, 0x2 binary
+ * @return Header length, 0 if len does not fit a 16-bit length
+ */
+size_t ws_frame_header(uint8_t out[WS_FRAME_HEADER_MAX], uint8_t opcode, size_t len);
+
+/**
+ * @brief Length of text without a UTF-8 character cut off at its end
+ *
+ * Text frames must be valid UTF-8, so a chunk of log output that stops
+ * inside a character ends before it.
+ */
+size_t ws_utf8_boundary(const char *text, size_t len);
+
+#endif /* WS_PROTOCOL_H */
@@ -0,0 +1,49 @@
+#!/usr/bin/env python3
+"""
+Compress the application image for OTA (thermux.bin -> thermux.bin.gz).
+Usage: compress_firmware.py <input.bin> <output.bin.gz>
+
+The device inflates with a 4 KB window (GUNZIP_WINDOW_BITS in
+main/gunzip.h), so the stream must not reference further back than that.
+A full flush every FLUSH_INTERVAL bytes of image gives the device points
+to resume an interrupted download from; each costs a few bytes.
+"""
+import sys
+import zlib
+
+WINDOW_BITS = 12  # Must match GUNZIP_WINDOW_BITS
+FLUSH_INTERVAL = 64 * 1024  # Multiple of the flash sector size
+
+
+def compress(data):
+    """gzip stream the device can inflate and resume."""
+    # 16 + wbits selects the gzip wrapper (header, CRC-32, length)
+    compressor = zlib.compressobj(9, zlib.DEFLATED, 16 + WINDOW_BITS, 9)
+    compressed = b''
+    for pos in range(0, len(data), FLUSH_INTERVAL):
+        compressed += compressor.compress(data[pos:pos + FLUSH_INTERVAL])
+        if pos + FLUSH_INTERVAL < len(data):
+            compressed += compressor.flush(zlib.Z_FULL_FLUSH)
+    compressed += compressor.flush()
+    return compressed
+
+
+def main():
+    if len(sys.argv) < 3:
+        print(f"Usage: {sys.argv[0]} <input.bin> <output.bin.gz>")
+        sys.exit(1)
+
+    with open(sys.argv[1], 'rb') as f_in:
+        data = f_in.read()
+
+    compressed = compress(data)
+
+    with open(sys.argv[2], 'wb') as f_out:
+        f_out.write(compressed)
+
+    ratio = (1 - len(compressed) / len(data)) * 100
+    print(f"-- OTA image: {len(data)} -> {len(compressed)} bytes ({ratio:.1f}% reduction)")
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,149 @@
+#!/usr/bin/env python3
+"""
+Make a delta OTA patch that rebuilds a new image from an old one.
+Usage: make_delta.py <old.bin> <new.bin> <output.delta>
+       make_delta.py --apply <old.bin> <patch.delta> <output.bin>
+
+The patch format is described in main/delta_patch.h. Matching is
+bsdiff-like: 8-byte seeds from a hash index are extended while at least
+half the bytes agree, so code that only moved (and whose addresses
+changed) still becomes a mostly-zero diff. The patch is gzip-compressed
+with the device's 4 KB window (see compress_firmware.py).
+"""
+import gzip
+import hashlib
+import struct
+import sys
+import zlib
+
+MAGIC = b'TXD1'
+SEED = 8
+WINDOW_BITS = 12    # Must match GUNZIP_WINDOW_BITS
+GIVE_UP = 64        # Stop extending a match this far past its best point
+
+
+def extend(old, new, o, n):
+    """Length of the approximate match at (o, n), bsdiff's forward score."""
+    limit = min(len(old) - o, len(new) - n)
+    matched = best = best_len = 0
+    k = 0
+    while k < limit:
+        if old[o + k] == new[n + k]:
+            matched += 1
+        k += 1
+        if matched * 2 - k > best * 2 - best_len:
+            best, best_len = matched, k
+        elif k - best_len > GIVE_UP:
+            break
+    return best_len
+
+
+def find_matches(old, new):
+    """Return [(old_start, new_start, length)] in new order."""
+    index = {}
+    for i in range(len(old) - SEED + 1):
+        index.setdefault(old[i:i + SEED], i)
+
+    matches = []
+    n = 0
+    next_old = 0    # Where the previous match would continue
+    while n + SEED <= len(new):
+        seed = new[n:n + SEED]
+        if old[next_old:next_old + SEED] == seed:
+            o = next_old
+        else:
+            o = index.get(seed)
+            if o is None:
+                n += 1
+                continue
+        length = extend(old, new, o, n)
+        if length < SEED:
+            n += 1
+            continue
+        matches.append((o, n, length))
+        n += length
+        next_old = o + length
+    return matches
+
+
+def make_patch(old, new):
+    out = bytearray(MAGIC)
+    out += struct.pack('<III', len(old), len(new), 0)
+    out += hashlib.sha256(old).digest() + hashlib.sha256(new).digest()
+
+    matches = find_matches(old, new)
+    # Leading literal bytes before the first match
+    first_old, first_new = (matches[0][0], matches[0][1]) if matches else (0, len(new))
+    out += struct.pack('<IIi', 0, first_new, first_old)
+    out += new[:first_new]
+
+    for i, (o, n, length) in enumerate(matches):
+        if i + 1 < len(matches):
+            next_o, next_n = matches[i + 1][0], matches[i + 1][1]
+        else:
+            next_o, next_n = o + length, len(new)
+        diff = bytes((new[n + k] - old[o + k]) & 0xFF for k in range(length))
+        out += struct.pack('<IIi', length, next_n - (n + length), next_o - (o + length))
+        out += diff
+        out += new[n + length:next_n]
+
+    compressor = zlib.compressobj(9, zlib.DEFLATED, 16 + WINDOW_BITS, 9)
+    return compressor.compress(bytes(out)) + compressor.flush()
+
+
+def apply_patch(old, patch):
+    """Reference applier, used to check a patch before it is published."""
+    data = gzip.decompress(patch)
+    if data[:4] != MAGIC:
+        raise ValueError('not a delta patch')
+    old_size, new_size, _ = struct.unpack_from('<III', data, 4)
+    if len(old) != old_size or hashlib.sha256(old).digest() != data[16:48]:
+        raise ValueError('patch is for a different image')
+    pos, old_pos, new = 80, 0, bytearray()
+    while len(new) < new_size:
+        diff_len, extra_len, seek = struct.unpack_from('<IIi', data, pos)
+        pos += 12
+        new += bytes((data[pos + k] + old[old_pos + k]) & 0xFF for k in range(diff_len))
+        pos += diff_len
+        old_pos += diff_len
+        new += data[pos:pos + extra_len]
+        pos += extra_len
+        old_pos += seek
+    if hashlib.sha256(new).digest() != data[48:80]:
+        raise ValueError('result hash mismatch')
+    return bytes(new)
+
+
+def main():
+    if len(sys.argv) == 5 and sys.argv[1] == '--apply':
+        with open(sys.argv[2], 'rb') as f:
+            old = f.read()
+        with open(sys.argv[3], 'rb') as f:
+            patch = f.read()
+        with open(sys.argv[4], 'wb') as f:
+            f.write(apply_patch(old, patch))
+        return
+    if len(sys.argv) != 4:
+        print(f"Usage: {sys.argv[0]} <old.bin> <new.bin> <output.delta>")
+        print(f"       {sys.argv[0]} --apply <old.bin> <patch.delta> <output.bin>")
+        sys.exit(1)
+
+    with open(sys.argv[1], 'rb') as f:
+        old = f.read()
+    with open(sys.argv[2], 'rb') as f:
+        new = f.read()
+
+    patch = make_patch(old, new)
+    if apply_patch(old, patch) != new:
+        print("Patch does not reproduce the new image")
+        sys.exit(1)
+
+    with open(sys.argv[3], 'wb') as f:
+        f.write(patch)
+
+    full = len(zlib.compress(new, 9))
+    print(f"-- Delta: {len(new)} bytes as a {len(patch)} byte patch (compressed full image: {full})")
+
+
+if __name__ == '__main__':
+    main()
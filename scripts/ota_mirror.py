@@ -0,0 +1,212 @@
+#!/usr/bin/env python3
+"""
+Local OTA mirror: build one, serve it, and check it the way a device does.
+Usage: ota_mirror.py prepare <thermux.bin> <dir> [--version V] [--delta FILE]...
+       ota_mirror.py serve <dir> [--port 8070]
+       ota_mirror.py check <manifest-url> [--peer URL [--peer-secret S | --api-key K]]
+
+prepare copies the image, writes thermux.bin.gz (see compress_firmware.py)
+and manifest.json (format in main/ota_manifest.h) with the SHA-256 of the
+uncompressed image. Patches from make_delta.py are copied and listed; name
+them thermux-from-<old version>.delta. The version is read from the image
+unless given.
+
+serve is a plain HTTP file server that honours "Range: bytes=N-", so
+interrupted downloads resume as they do from GitHub. Point devices at it
+with CONFIG_OTA_SOURCE_URL or POST /api/config/ota
+{"source_url": "http://<host>:8070/manifest.json"}.
+
+check fetches the manifest and image, inflates it, verifies the digest and
+a resumed (Range) fetch of the second half. With --peer it checks
+http://<node>/api/ota/image of a node running the new version instead;
+when the node has web authentication enabled, pass its peer secret
+(CONFIG_OTA_PEER_SECRET, sent as X-Peer-Secret like a node does) or its
+API key.
+"""
+import argparse
+import hashlib
+import http.server
+import json
+import os
+import shutil
+import struct
+import sys
+import urllib.error
+import urllib.parse
+import urllib.request
+import zlib
+
+from compress_firmware import WINDOW_BITS, compress
+
+IMAGE = 'thermux.bin'
+APP_DESC_OFFSET = 32            # Image header + first segment header
+APP_DESC_MAGIC = 0xABCD5432
+
+
+def image_version(data):
+    """Version from the esp_app_desc_t at the start of an app image."""
+    magic, = struct.unpack_from('<I', data, APP_DESC_OFFSET)
+    if magic != APP_DESC_MAGIC:
+        return None
+    raw = data[APP_DESC_OFFSET + 16:APP_DESC_OFFSET + 48]
+    return raw.split(b'\0', 1)[0].decode('ascii', 'replace')
+
+
+def prepare(args):
+    with open(args.image, 'rb') as f:
+        data = f.read()
+    version = args.version or image_version(data)
+    if not version:
+        sys.exit("No app description in the image, pass --version")
+
+    os.makedirs(args.dir, exist_ok=True)
+    with open(os.path.join(args.dir, IMAGE), 'wb') as f:
+        f.write(data)
+    compressed = compress(data)
+    with open(os.path.join(args.dir, IMAGE + '.gz'), 'wb') as f:
+        f.write(compressed)
+
+    deltas = []
+    for path in args.delta:
+        name = os.path.basename(path)
+        shutil.copyfile(path, os.path.join(args.dir, name))
+        deltas.append(name)
+
+    manifest = {
+        'version': version,
+        'image': IMAGE + '.gz',
+        'sha256': hashlib.sha256(data).hexdigest(),
+        'deltas': deltas,
+    }
+    with open(os.path.join(args.dir, 'manifest.json'), 'w') as f:
+        json.dump(manifest, f, indent=2)
+        f.write('\n')
+    print(f"-- Mirror {args.dir}: {version}, {len(data)} bytes ({len(compressed)} gzipped), "
+          f"{len(deltas)} patches")
+
+
+class RangeHandler(http.server.SimpleHTTPRequestHandler):
+    """Static files, with open-ended byte ranges."""
+
+    def send_head(self):
+        start = self.range_start()
+        path = self.translate_path(self.path)
+        if start is None or not os.path.isfile(path):
+            return super().send_head()
+        size = os.path.getsize(path)
+        if start >= size:
+            self.send_error(416, "Range Not Satisfiable")
+            return None
+        f = open(path, 'rb')
+        f.seek(start)
+        self.send_response(206)
+        self.send_header('Content-Type', self.guess_type(path))
+        self.send_header('Content-Length', str(size - start))
+        self.send_header('Content-Range', f'bytes {start}-{size - 1}/{size}')
+        self.end_headers()
+        return f
+
+    def range_start(self):
+        value = self.headers.get('Range', '')
+        if not value.startswith('bytes=') or not value.endswith('-'):
+            return None
+        try:
+            return int(value[6:-1])
+        except ValueError:
+            return None
+
+
+def serve(args):
+    handler = lambda *a, **kw: RangeHandler(*a, directory=args.dir, **kw)
+    server = http.server.ThreadingHTTPServer(('', args.port), handler)
+    print(f"-- Serving {args.dir} on port {args.port} (manifest: http://<host>:{args.port}/manifest.json)")
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+
+
+def fetch(url, start=0, headers=None):
+    req = urllib.request.Request(url, headers=headers or {})
+    if start:
+        req.add_header('Range', f'bytes={start}-')
+    try:
+        with urllib.request.urlopen(req, timeout=30) as resp:
+            return resp.status, resp.read()
+    except urllib.error.HTTPError as e:
+        hint = " (pass --peer-secret or --api-key)" if e.code == 401 else ""
+        sys.exit(f"FAIL: {url} returned {e.code} {e.reason}{hint}")
+
+
+def inflate(data):
+    """Inflate with the device's window: fails if the stream reaches further back."""
+    return zlib.decompressobj(16 + WINDOW_BITS).decompress(data)
+
+
+def check(args):
+    status, body = fetch(args.manifest)
+    manifest = json.loads(body)
+    for field in ('version', 'image', 'sha256'):
+        if not manifest.get(field):
+            sys.exit(f"Manifest has no {field}")
+    print(f"-- Manifest: {manifest['version']}, image {manifest['image']}, "
+          f"{len(manifest.get('deltas', []))} patches")
+
+    headers = {}
+    if args.peer:
+        url, compressed = args.peer, False
+        if args.peer_secret:
+            headers['X-Peer-Secret'] = args.peer_secret
+        if args.api_key:
+            headers['X-API-Key'] = args.api_key
+    else:
+        url = urllib.parse.urljoin(args.manifest, manifest['image'])
+        compressed = url.endswith('.gz')
+    status, download = fetch(url, headers=headers)
+    image = inflate(download) if compressed else download
+    digest = hashlib.sha256(image).hexdigest()
+    if digest != manifest['sha256'].lower():
+        sys.exit(f"FAIL: {url} has SHA-256 {digest}, manifest says {manifest['sha256']}")
+    print(f"-- {url}: {len(download)} bytes -> {len(image)} byte image, SHA-256 OK")
+
+    half = len(download) // 2
+    status, tail = fetch(url, half, headers)
+    if status != 206 or tail != download[half:]:
+        sys.exit(f"FAIL: range request from {half} returned status {status}, {len(tail)} bytes")
+    print(f"-- Resume from byte {half}: OK")
+
+    for name in manifest.get('deltas', []):
+        delta_url = urllib.parse.urljoin(args.manifest, name)
+        status, patch = fetch(delta_url)
+        print(f"-- {delta_url}: {len(patch)} bytes")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Local OTA mirror for Thermux")
+    sub = parser.add_subparsers(dest='command', required=True)
+
+    p = sub.add_parser('prepare', help="Build a mirror directory")
+    p.add_argument('image')
+    p.add_argument('dir')
+    p.add_argument('--version')
+    p.add_argument('--delta', action='append', default=[])
+    p.set_defaults(func=prepare)
+
+    p = sub.add_parser('serve', help="Serve a mirror directory")
+    p.add_argument('dir')
+    p.add_argument('--port', type=int, default=8070)
+    p.set_defaults(func=serve)
+
+    p = sub.add_parser('check', help="Verify a mirror or peer like a device would")
+    p.add_argument('manifest')
+    p.add_argument('--peer', help="Image URL of a node, e.g. http://thermux-1a2b3c.local/api/ota/image")
+    p.add_argument('--peer-secret', help="Peer secret of the node (sent as X-Peer-Secret)")
+    p.add_argument('--api-key', help="API key of the node (sent as X-API-Key)")
+    p.set_defaults(func=check)
+
+    args = parser.parse_args()
+    args.func(args)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,46 @@
+/**
+ * @file bench.h
+ * @brief Minimal timing helpers for host benchmarks
+ */
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <time.h>
+
+/** @brief Default iteration count per benchmark case */
+#define BENCH_ITERATIONS 20000
+
+/**
+ * @brief Monotonic time in nanoseconds
+ */
+static inline uint64_t bench_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * @brief Print one result row
+ * @param name Case name
+ * @param iterations Number of documents/operations measured
+ * @param elapsed_ns Total elapsed time
+ * @param bytes Output size of one document/operation
+ * @param allocs Heap allocations per document/operation (-1 if not measured)
+ */
+static inline void bench_report(const char *name, int iterations, uint64_t elapsed_ns,
+                                size_t bytes, long allocs)
+{
+    double per_op_us = (double)elapsed_ns / iterations / 1000.0;
+    if (allocs >= 0) {
+        printf("  %-36s %9.3f us/op  %6zu bytes  %4ld allocs/op\n", name, per_op_us, bytes, allocs);
+    } else {
+        printf("  %-36s %9.3f us/op  %6zu bytes\n", name, per_op_us, bytes);
+    }
+}
+
+#endif /* BENCH_H */
@@ -0,0 +1,146 @@
+/**
+ * @file bench_auth.c
+ * @brief Per-request auth cost: previous malloc/strcmp checks vs the stack-buffer paths
+ */
+
+#include "bench.h"
+#include "auth_session.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define OLD_MAX_SESSIONS 4
+
+/* CONFIG_HTTPD_MAX_REQ_HDR_LEN in the shipped sdkconfig */
+#define MAX_REQ_HDR_LEN 1024
+
+static char s_api_key[65];
+static char s_api_key_header[65];
+static char s_cookie_header[128];
+static char s_signed_cookie_header[128];
+static char s_old_sessions[OLD_MAX_SESSIONS][33];
+static auth_sessions_t s_table;
+static uint8_t s_key[AUTH_SIGNING_KEY_SIZE];
+static volatile int s_sink;
+
+/* Stand-in for httpd_req_get_hdr_value_str: copy the header out */
+static int get_header(const char *header, char *out, size_t size)
+{
+    size_t len = strlen(header);
+    if (len >= size) {
+        return -1;
+    }
+    memcpy(out, header, len + 1);
+    return 0;
+}
+
+static void init_auth(void)
+{
+    for (int i = 0; i < 64; i++) {
+        s_api_key[i] = "0123456789abcdef"[(i * 7) % 16];
+    }
+    strcpy(s_api_key_header, s_api_key);
+
+    auth_sessions_clear(&s_table);
+    char token[AUTH_TOKEN_BUF_SIZE];
+    for (int i = 0; i < OLD_MAX_SESSIONS; i++) {
+        snprintf(s_old_sessions[i], sizeof(s_old_sessions[i]), "%08x%08x%08x%08x", i, i * 3, i * 5, i * 7);
+        auth_sessions_add(&s_table, s_old_sessions[i], 1000000, 0);
+    }
+    snprintf(s_cookie_header, sizeof(s_cookie_header), "theme=dark; session=%s",
+             s_old_sessions[OLD_MAX_SESSIONS - 1]);
+
+    for (int i = 0; i < AUTH_SIGNING_KEY_SIZE; i++) {
+        s_key[i] = (uint8_t)(i * 13 + 5);
+    }
+    auth_token_sign(s_key, 604800, token);
+    snprintf(s_signed_cookie_header, sizeof(s_signed_cookie_header), "theme=dark; session=%s", token);
+}
+
+/* ===== Previous implementation ===== */
+
+static int api_key_malloc(void)
+{
+    size_t len = strlen(s_api_key_header);
+    char *key = malloc(len + 1);
+    get_header(s_api_key_header, key, len + 1);
+    int valid = strcmp(key, s_api_key) == 0;
+    free(key);
+    return valid;
+}
+
+static int session_malloc(void)
+{
+    size_t len = strlen(s_cookie_header);
+    char *cookie = malloc(len + 1);
+    get_header(s_cookie_header, cookie, len + 1);
+    char *start = strstr(cookie, "session=");
+    char token[33] = {0};
+    if (start) {
+        start += 8;
+        int i = 0;
+        while (start[i] && start[i] != ';' && i < 32) {
+            token[i] = start[i];
+            i++;
+        }
+    }
+    free(cookie);
+    for (int j = 0; j < OLD_MAX_SESSIONS; j++) {
+        if (s_old_sessions[j][0] != '\0' && strcmp(token, s_old_sessions[j]) == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* ===== Current implementation ===== */
+
+static int api_key_stack(void)
+{
+    char key[sizeof(s_api_key) + 1];
+    return get_header(s_api_key_header, key, sizeof(key)) == 0 && auth_secret_equal(key, s_api_key);
+}
+
+static int session_table(void)
+{
+    char cookie[MAX_REQ_HDR_LEN + 1];
+    char token[AUTH_TOKEN_BUF_SIZE];
+    return get_header(s_cookie_header, cookie, sizeof(cookie)) == 0 &&
+           auth_cookie_value(cookie, "session", token, sizeof(token)) > 0 &&
+           auth_sessions_check(&s_table, token, 0);
+}
+
+static int session_signed(void)
+{
+    char cookie[MAX_REQ_HDR_LEN + 1];
+    char token[AUTH_TOKEN_BUF_SIZE];
+    return get_header(s_signed_cookie_header, cookie, sizeof(cookie)) == 0 &&
+           auth_cookie_value(cookie, "session", token, sizeof(token)) > 0 &&
+           auth_token_verify(s_key, token, 0);
+}
+
+static void bench_case(const char *name, int (*check)(void), long allocs)
+{
+    int valid = 0;
+    uint64_t start = bench_now_ns();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        valid += check();
+    }
+    uint64_t elapsed = bench_now_ns() - start;
+    s_sink = valid;
+    if (valid != BENCH_ITERATIONS) {
+        printf("  %s: check failed\n", name);
+        return;
+    }
+    bench_report(name, BENCH_ITERATIONS, elapsed, 0, allocs);
+}
+
+void run_auth_bench(void)
+{
+    init_auth();
+
+    bench_case("api key: malloc + strcmp (old)", api_key_malloc, 1);
+    bench_case("api key: stack + constant-time", api_key_stack, 0);
+    bench_case("session: malloc + scan of 4 (old)", session_malloc, 1);
+    bench_case("session: hashed table", session_table, 0);
+    bench_case("session: signed token (HMAC)", session_signed, 0);
+}
@@ -0,0 +1,130 @@
+/**
+ * @file bench_export.c
+ * @brief /api/export: history_export rows vs snprintf, through a 1 KB chunk buffer
+ */
+
+#include "bench.h"
+#include "history_export.h"
+#include <string.h>
+
+#define BENCH_SENSOR_COUNT 8
+#define BENCH_HISTORY_RECORDS 4096
+#define BENCH_EXPORTS 200
+#define BENCH_CHUNK_SIZE 1024
+#define BENCH_READ_RECORDS 16
+
+static history_record_t s_storage[BENCH_HISTORY_RECORDS];
+static history_t s_history;
+static char s_chunk[BENCH_CHUNK_SIZE];
+static volatile size_t s_sink;
+
+typedef size_t (*row_fn_t)(history_export_format_t format, const history_record_t *rec,
+                           char *buf, size_t size);
+
+static void init_history(void)
+{
+    history_init(&s_history, s_storage, BENCH_HISTORY_RECORDS);
+    for (int i = 0; i < BENCH_HISTORY_RECORDS; i++) {
+        int sensor = i % BENCH_SENSOR_COUNT;
+        history_record_t rec = {
+            .timestamp = 1700000000u + (i / BENCH_SENSOR_COUNT) * 60u,
+            .uptime_s = 120u + (i / BENCH_SENSOR_COUNT) * 60u,
+            .address = { 0x28, 0xFF, 0x00, 0x00, 0x01, 0x23, 0x45, (uint8_t)(0x60 + sensor) },
+            .temp_centi = (int16_t)(1800 + sensor * 25 + i % 7),
+        };
+        history_push(&s_history, &rec);
+    }
+}
+
+/* ===== Baseline: snprintf per row ===== */
+
+static size_t snprintf_row(history_export_format_t format, const history_record_t *rec,
+                           char *buf, size_t size)
+{
+    const uint8_t *a = rec->address;
+    int n;
+    if (format == HISTORY_EXPORT_CSV) {
+        n = snprintf(buf, size, "%lu,%lu,%02X%02X%02X%02X%02X%02X%02X%02X,%.2f\n",
+                     (unsigned long)rec->timestamp, (unsigned long)rec->uptime_s,
+                     a[0], a[1], a[2], a[3], a[4], a[5], a[6], a[7], rec->temp_centi / 100.0);
+    } else {
+        n = snprintf(buf, size, "{\"timestamp\":%lu,\"uptime_s\":%lu,"
+                     "\"address\":\"%02X%02X%02X%02X%02X%02X%02X%02X\",\"temperature\":%.2f}\n",
+                     (unsigned long)rec->timestamp, (unsigned long)rec->uptime_s,
+                     a[0], a[1], a[2], a[3], a[4], a[5], a[6], a[7], rec->temp_centi / 100.0);
+    }
+    return n > 0 && (size_t)n < size ? (size_t)n : 0;
+}
+
+/**
+ * @brief One full export as the handler does it, chunks discarded
+ */
+static size_t export_once(history_export_format_t format, const history_export_filter_t *filter,
+                          row_fn_t row, uint32_t *rows)
+{
+    history_record_t records[BENCH_READ_RECORDS];
+    size_t len = history_export_header(format, 1700000000u, s_chunk, sizeof(s_chunk));
+    size_t total = 0;
+    uint32_t cursor = 0;
+    size_t n;
+
+    while ((n = history_read(&s_history, &cursor, records, BENCH_READ_RECORDS)) > 0) {
+        for (size_t i = 0; i < n; i++) {
+            if (!history_export_match(filter, &records[i])) {
+                continue;
+            }
+            if (sizeof(s_chunk) - len < HISTORY_EXPORT_ROW_MAX) {
+                s_sink += s_chunk[0];
+                total += len;
+                len = 0;
+            }
+            len += row(format, &records[i], s_chunk + len, sizeof(s_chunk) - len);
+            (*rows)++;
+        }
+    }
+    if (sizeof(s_chunk) - len < HISTORY_EXPORT_FOOTER_MAX) {
+        s_sink += s_chunk[0];
+        total += len;
+        len = 0;
+    }
+    len += history_export_footer(format, s_chunk + len, sizeof(s_chunk) - len);
+    return total + len;
+}
+
+static void bench_case(const char *name, history_export_format_t format,
+                       const history_export_filter_t *filter, row_fn_t row)
+{
+    uint32_t rows = 0;
+    size_t bytes = 0;
+    uint64_t start = bench_now_ns();
+    for (int i = 0; i < BENCH_EXPORTS; i++) {
+        rows = 0;
+        bytes = export_once(format, filter, row, &rows);
+    }
+    uint64_t elapsed = bench_now_ns() - start;
+
+    bench_report(name, BENCH_EXPORTS, elapsed, bytes, 0);
+    double seconds = (double)elapsed / 1e9;
+    printf("  %-36s %9.2f Mrows/s  %6.1f MB/s\n", "",
+           (double)rows * BENCH_EXPORTS / seconds / 1e6,
+           (double)bytes * BENCH_EXPORTS / seconds / 1e6);
+}
+
+void run_export_bench(void)
+{
+    init_history();
+
+    history_export_filter_t all = {0};
+    history_export_filter_t two = {0};
+    history_export_parse_sensors("28FF000001234560,28FF000001234563", &two);
+    two.from = 1700000000u + 3600u;
+
+    printf("  %d records, %d sensors, %d-byte chunks\n",
+           BENCH_HISTORY_RECORDS, BENCH_SENSOR_COUNT, BENCH_CHUNK_SIZE);
+    bench_case("csv: snprintf rows", HISTORY_EXPORT_CSV, &all, snprintf_row);
+    bench_case("csv: history_export rows", HISTORY_EXPORT_CSV, &all, history_export_row);
+    bench_case("ndjson: snprintf rows", HISTORY_EXPORT_NDJSON, &all, snprintf_row);
+    bench_case("ndjson: history_export rows", HISTORY_EXPORT_NDJSON, &all, history_export_row);
+    bench_case("cbor: history_export rows", HISTORY_EXPORT_CBOR, &all, history_export_row);
+    bench_case("csv: 2 sensors, from= filter", HISTORY_EXPORT_CSV, &two, history_export_row);
+}
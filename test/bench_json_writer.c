@@ -0,0 +1,198 @@
+/**
+ * @file bench_json_writer.c
+ * @brief Streaming JSON writer vs cJSON tree + print (time and allocations)
+ */
+
+#include "bench.h"
+#include "json_writer.h"
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef BENCH_HAVE_CJSON
+#include "cJSON.h"
+#endif
+
+#define BENCH_SENSOR_COUNT 20
+
+typedef struct {
+    char address[17];
+    float temperature;
+    bool valid;
+    const char *friendly_name;
+    uint32_t total_reads;
+    uint32_t failed_reads;
+} bench_sensor_t;
+
+static bench_sensor_t s_sensors[BENCH_SENSOR_COUNT];
+
+static void init_sensors(void)
+{
+    for (int i = 0; i < BENCH_SENSOR_COUNT; i++) {
+        snprintf(s_sensors[i].address, sizeof(s_sensors[i].address), "28FF%012X", 0x1234560 + i);
+        s_sensors[i].temperature = 18.0f + i * 0.0625f;
+        s_sensors[i].valid = (i % 7) != 0;
+        s_sensors[i].friendly_name = (i % 2) ? "Living Room" : NULL;
+        s_sensors[i].total_reads = 100000 + i;
+        s_sensors[i].failed_reads = i;
+    }
+}
+
+/* ===== Streaming writer ===== */
+
+static int writer_sensors(char *buf, size_t size)
+{
+    json_writer_t w;
+    json_writer_init(&w, buf, size, NULL, NULL);
+    json_writer_begin_array(&w);
+    for (int i = 0; i < BENCH_SENSOR_COUNT; i++) {
+        json_writer_begin_object(&w);
+        json_writer_kv_string(&w, "address", s_sensors[i].address);
+        json_writer_kv_double(&w, "temperature", s_sensors[i].temperature);
+        json_writer_kv_bool(&w, "valid", s_sensors[i].valid);
+        json_writer_kv_string(&w, "friendly_name", s_sensors[i].friendly_name);
+        json_writer_kv_uint(&w, "total_reads", s_sensors[i].total_reads);
+        json_writer_kv_uint(&w, "failed_reads", s_sensors[i].failed_reads);
+        json_writer_end_object(&w);
+    }
+    json_writer_end_array(&w);
+    return json_writer_finish(&w);
+}
+
+static int writer_discovery(char *buf, size_t size)
+{
+    json_writer_t w;
+    json_writer_init(&w, buf, size, NULL, NULL);
+    json_writer_begin_object(&w);
+    json_writer_kv_string(&w, "name", "Living Room");
+    json_writer_kv_string(&w, "unique_id", "thermux_28FF000001234560");
+    json_writer_kv_string(&w, "state_topic", "thermux/sensor/28FF000001234560/state");
+    json_writer_kv_string(&w, "availability_topic", "thermux/status");
+    json_writer_kv_string(&w, "device_class", "temperature");
+    json_writer_kv_string(&w, "unit_of_measurement", "°C");
+    json_writer_kv_string(&w, "state_class", "measurement");
+    json_writer_key(&w, "device");
+    json_writer_begin_object(&w);
+    json_writer_kv_string(&w, "name", "Thermux");
+    json_writer_kv_string(&w, "manufacturer", "Custom");
+    json_writer_kv_string(&w, "model", "ESP32-POE-ISO");
+    json_writer_kv_string(&w, "sw_version", "2.7.0");
+    json_writer_key(&w, "identifiers");
+    json_writer_begin_array(&w);
+    json_writer_string(&w, "thermux");
+    json_writer_end_array(&w);
+    json_writer_end_object(&w);
+    json_writer_end_object(&w);
+    return json_writer_finish(&w);
+}
+
+/* ===== cJSON baseline ===== */
+
+#ifdef BENCH_HAVE_CJSON
+static long s_allocs;
+
+static void *counting_malloc(size_t size)
+{
+    s_allocs++;
+    return malloc(size);
+}
+
+static char *cjson_sensors(void)
+{
+    cJSON *root = cJSON_CreateArray();
+    for (int i = 0; i < BENCH_SENSOR_COUNT; i++) {
+        cJSON *sensor = cJSON_CreateObject();
+        cJSON_AddStringToObject(sensor, "address", s_sensors[i].address);
+        cJSON_AddNumberToObject(sensor, "temperature", s_sensors[i].temperature);
+        cJSON_AddBoolToObject(sensor, "valid", s_sensors[i].valid);
+        if (s_sensors[i].friendly_name) {
+            cJSON_AddStringToObject(sensor, "friendly_name", s_sensors[i].friendly_name);
+        } else {
+            cJSON_AddNullToObject(sensor, "friendly_name");
+        }
+        cJSON_AddNumberToObject(sensor, "total_reads", s_sensors[i].total_reads);
+        cJSON_AddNumberToObject(sensor, "failed_reads", s_sensors[i].failed_reads);
+        cJSON_AddItemToArray(root, sensor);
+    }
+    char *json = cJSON_PrintUnformatted(root);
+    cJSON_Delete(root);
+    return json;
+}
+
+static char *cjson_discovery(void)
+{
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddStringToObject(root, "name", "Living Room");
+    cJSON_AddStringToObject(root, "unique_id", "thermux_28FF000001234560");
+    cJSON_AddStringToObject(root, "state_topic", "thermux/sensor/28FF000001234560/state");
+    cJSON_AddStringToObject(root, "availability_topic", "thermux/status");
+    cJSON_AddStringToObject(root, "device_class", "temperature");
+    cJSON_AddStringToObject(root, "unit_of_measurement", "°C");
+    cJSON_AddStringToObject(root, "state_class", "measurement");
+    cJSON *device = cJSON_CreateObject();
+    cJSON_AddStringToObject(device, "name", "Thermux");
+    cJSON_AddStringToObject(device, "manufacturer", "Custom");
+    cJSON_AddStringToObject(device, "model", "ESP32-POE-ISO");
+    cJSON_AddStringToObject(device, "sw_version", "2.7.0");
+    cJSON *identifiers = cJSON_CreateArray();
+    cJSON_AddItemToArray(identifiers, cJSON_CreateString("thermux"));
+    cJSON_AddItemToObject(device, "identifiers", identifiers);
+    cJSON_AddItemToObject(root, "device", device);
+    char *json = cJSON_PrintUnformatted(root);
+    cJSON_Delete(root);
+    return json;
+}
+
+static void bench_cjson(const char *name, char *(*build)(void), const char *expected)
+{
+    cJSON_Hooks hooks = { .malloc_fn = counting_malloc, .free_fn = free };
+    cJSON_InitHooks(&hooks);
+
+    char *json = build();
+    if (json == NULL || strcmp(json, expected) != 0) {
+        printf("  %-36s OUTPUT MISMATCH\n", name);
+    }
+    size_t bytes = json ? strlen(json) : 0;
+    free(json);
+
+    s_allocs = 0;
+    uint64_t start = bench_now_ns();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        json = build();
+        free(json);
+    }
+    uint64_t elapsed = bench_now_ns() - start;
+    bench_report(name, BENCH_ITERATIONS, elapsed, bytes, s_allocs / BENCH_ITERATIONS);
+
+    cJSON_InitHooks(NULL);
+}
+#endif
+
+static void bench_writer(const char *name, int (*build)(char *, size_t), char *buf, size_t size)
+{
+    int len = 0;
+    uint64_t start = bench_now_ns();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        len = build(buf, size);
+    }
+    uint64_t elapsed = bench_now_ns() - start;
+    bench_report(name, BENCH_ITERATIONS, elapsed, len > 0 ? (size_t)len : 0, 0);
+}
+
+void run_json_writer_bench(void)
+{
+    static char sensors_buf[4096];
+    static char discovery_buf[768];
+
+    init_sensors();
+
+    bench_writer("json_writer /api/sensors (20)", writer_sensors, sensors_buf, sizeof(sensors_buf));
+    bench_writer("json_writer HA discovery", writer_discovery, discovery_buf, sizeof(discovery_buf));
+
+#ifdef BENCH_HAVE_CJSON
+    bench_cjson("cJSON /api/sensors (20)", cjson_sensors, sensors_buf);
+    bench_cjson("cJSON HA discovery", cjson_discovery, discovery_buf);
+#else
+    printf("  (cJSON baseline skipped - configure with -DCJSON_DIR=<path to cJSON sources>)\n");
+#endif
+}
@@ -0,0 +1,123 @@
+/**
+ * @file bench_metrics.c
+ * @brief /metrics scrape: metrics_writer with cached labels vs snprintf per line
+ */
+
+#include "bench.h"
+#include "metrics_writer.h"
+#include <string.h>
+
+#define BENCH_SENSOR_COUNT 20
+
+typedef struct {
+    char address[17];
+    char name[32];
+    char labels[METRICS_LABELS_MAX];
+    float temperature;
+    bool valid;
+    uint32_t total_reads;
+    uint32_t failed_reads;
+} bench_sensor_t;
+
+static bench_sensor_t s_sensors[BENCH_SENSOR_COUNT];
+static metrics_histogram_t s_cycle;
+static const double s_cycle_bounds[] = { 0.25, 0.5, 0.75, 1, 1.5, 2, 5 };
+
+static int discard_sink(void *ctx, const char *data, size_t len)
+{
+    (void)data;
+    *(size_t *)ctx += len;
+    return 0;
+}
+
+static void init_sensors(void)
+{
+    for (int i = 0; i < BENCH_SENSOR_COUNT; i++) {
+        bench_sensor_t *s = &s_sensors[i];
+        snprintf(s->address, sizeof(s->address), "%016llX", 0x28FF000001234560ull + i);
+        snprintf(s->name, sizeof(s->name), "Zone %d supply", i + 1);
+        metrics_format_sensor_labels(s->labels, sizeof(s->labels), s->address, s->name);
+        s->temperature = 18.0f + i * 0.0625f;
+        s->valid = true;
+        s->total_reads = 86400 + i;
+        s->failed_reads = i;
+    }
+    metrics_histogram_init(&s_cycle, s_cycle_bounds, 7);
+    for (int i = 0; i < 1000; i++) {
+        metrics_histogram_observe(&s_cycle, 0.45 + (i % 10) * 0.07);
+    }
+}
+
+/* Same families and layout as the firmware's /metrics handler */
+static size_t scrape_writer(void)
+{
+    static char chunk[1024];
+    size_t total = 0;
+    metrics_writer_t w;
+    metrics_writer_init(&w, chunk, sizeof(chunk), discard_sink, &total);
+
+    metrics_writer_family(&w, "thermux_sensor_temperature_celsius", "gauge", "Last valid temperature reading");
+    for (int i = 0; i < BENCH_SENSOR_COUNT; i++) {
+        metrics_writer_sample(&w, "thermux_sensor_temperature_celsius", s_sensors[i].labels, s_sensors[i].temperature);
+    }
+    metrics_writer_family(&w, "thermux_sensor_valid", "gauge", "1 if the last read succeeded");
+    for (int i = 0; i < BENCH_SENSOR_COUNT; i++) {
+        metrics_writer_sample_uint(&w, "thermux_sensor_valid", s_sensors[i].labels, s_sensors[i].valid);
+    }
+    metrics_writer_family(&w, "thermux_sensor_reads_total", "counter", "Read attempts");
+    for (int i = 0; i < BENCH_SENSOR_COUNT; i++) {
+        metrics_writer_sample_uint(&w, "thermux_sensor_reads_total", s_sensors[i].labels, s_sensors[i].total_reads);
+    }
+    metrics_writer_family(&w, "thermux_sensor_read_failures_total", "counter", "Failed reads");
+    for (int i = 0; i < BENCH_SENSOR_COUNT; i++) {
+        metrics_writer_sample_uint(&w, "thermux_sensor_read_failures_total", s_sensors[i].labels, s_sensors[i].failed_reads);
+    }
+    metrics_writer_family(&w, "thermux_read_cycle_duration_seconds", "histogram", "Acquisition cycle duration");
+    metrics_writer_histogram(&w, "thermux_read_cycle_duration_seconds", &s_cycle);
+    metrics_writer_finish(&w);
+    return total;
+}
+
+/* Baseline: labels formatted and every line printed with snprintf */
+static size_t scrape_snprintf(void)
+{
+    static char line[256];
+    size_t total = 0;
+    static const char *families[] = {
+        "thermux_sensor_temperature_celsius", "thermux_sensor_valid",
+        "thermux_sensor_reads_total", "thermux_sensor_read_failures_total",
+    };
+    for (int f = 0; f < 4; f++) {
+        total += (size_t)snprintf(line, sizeof(line), "# HELP %s help\n# TYPE %s gauge\n", families[f], families[f]);
+        for (int i = 0; i < BENCH_SENSOR_COUNT; i++) {
+            const bench_sensor_t *s = &s_sensors[i];
+            double value = f == 0 ? s->temperature : f == 1 ? s->valid : f == 2 ? s->total_reads : s->failed_reads;
+            total += (size_t)snprintf(line, sizeof(line), "%s{address=\"%s\",name=\"%s\"} %g\n",
+                                      families[f], s->address, s->name, value);
+        }
+    }
+    for (size_t b = 0; b <= s_cycle.bucket_count; b++) {
+        total += (size_t)snprintf(line, sizeof(line), "thermux_read_cycle_duration_seconds_bucket{le=\"%g\"} %u\n",
+                                  b < s_cycle.bucket_count ? s_cycle.bounds[b] : 1e9, (unsigned)s_cycle.counts[b]);
+    }
+    return total;
+}
+
+static void bench_case(const char *name, size_t (*scrape)(void))
+{
+    size_t bytes = 0;
+    uint64_t start = bench_now_ns();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        bytes = scrape();
+    }
+    uint64_t elapsed = bench_now_ns() - start;
+    bench_report(name, BENCH_ITERATIONS, elapsed, bytes, 0);
+}
+
+void run_metrics_bench(void)
+{
+    init_sensors();
+
+    bench_case("metrics_writer, cached labels (20)", scrape_writer);
+    bench_case("snprintf per line (20)", scrape_snprintf);
+}
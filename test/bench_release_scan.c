@@ -0,0 +1,201 @@
+/**
+ * @file bench_release_scan.c
+ * @brief Update check: json_scan over the streamed response vs buffer + cJSON tree (time and peak heap)
+ *
+ * The bytes column is the peak heap held by the parse, not output size.
+ */
+
+#include "bench.h"
+#include "json_scan.h"
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef BENCH_HAVE_CJSON
+#include "cJSON.h"
+#endif
+
+#define BENCH_ASSETS 24
+#define BENCH_BODY_BYTES 3000
+#define BENCH_PIECE 512         /* Typical HTTP_EVENT_ON_DATA size */
+#define BENCH_CHECKS 2000
+
+static char s_release[BENCH_ASSETS * 1100 + BENCH_BODY_BYTES + 1024];
+static size_t s_release_len;
+
+/* Release shaped like GitHub's: assets with uploader objects, long release notes */
+static void init_release(void)
+{
+    char *p = s_release;
+    p += sprintf(p, "{\"url\":\"https://api.github.com/repos/owner/thermux/releases/1\","
+                    "\"id\":1,\"tag_name\":\"v2.8.0\",\"name\":\"v2.8.0\",\"draft\":false,"
+                    "\"prerelease\":false,\"assets\":[");
+    for (int i = 0; i < BENCH_ASSETS; i++) {
+        const char *name = (i == BENCH_ASSETS - 2) ? "thermux.bin" :
+                           (i == BENCH_ASSETS - 1) ? "thermux.bin.gz" : "thermux-from-2.%d.0.delta";
+        char asset[64];
+        snprintf(asset, sizeof(asset), name, i);
+        p += sprintf(p, "%s{\"url\":\"https://api.github.com/repos/owner/thermux/releases/assets/%d\","
+                        "\"id\":%d,\"node_id\":\"RA_kwDOABCDEF4AAAAB%08d\",\"name\":\"%s\",\"label\":\"\","
+                        "\"uploader\":{\"login\":\"github-actions[bot]\",\"id\":41898282,"
+                        "\"node_id\":\"MDM6Qm90NDE4OTgyODI=\",\"avatar_url\":\"https://avatars.githubusercontent.com/in/15368?v=4\","
+                        "\"url\":\"https://api.github.com/users/github-actions%%5Bbot%%5D\","
+                        "\"html_url\":\"https://github.com/apps/github-actions\",\"type\":\"Bot\",\"site_admin\":false},"
+                        "\"content_type\":\"application/octet-stream\",\"state\":\"uploaded\",\"size\":%d,"
+                        "\"download_count\":%d,\"created_at\":\"2026-01-01T00:00:00Z\","
+                        "\"updated_at\":\"2026-01-01T00:00:00Z\","
+                        "\"browser_download_url\":\"https://github.com/owner/thermux/releases/download/v2.8.0/%s\"}",
+                     i ? "," : "", i, i, i, asset, 40000 + i, i * 3, asset);
+    }
+    p += sprintf(p, "],\"body\":\"");
+    for (int i = 0; i < BENCH_BODY_BYTES; i++) {
+        *p++ = (i % 64 == 63) ? ' ' : (char)('a' + i % 26);
+    }
+    p += sprintf(p, "\"}");
+    s_release_len = (size_t)(p - s_release);
+}
+
+/* ===== Streaming scan ===== */
+
+typedef struct {
+    json_scan_t scan;
+    char tag_name[32];
+    char asset_name[64];
+    char asset_url[JSON_SCAN_VALUE_MAX];
+    char image_url[JSON_SCAN_VALUE_MAX];
+} bench_scan_t;
+
+static void on_string(void *ctx, const json_scan_t *s, const char *value, size_t len)
+{
+    bench_scan_t *b = ctx;
+    if (s->truncated) {
+        return;
+    }
+    if (s->depth == 1 && strcmp(s->key, "tag_name") == 0 && len < sizeof(b->tag_name)) {
+        memcpy(b->tag_name, value, len + 1);
+    } else if (s->depth == 3 && strcmp(s->root_key, "assets") == 0) {
+        if (strcmp(s->key, "name") == 0 && len < sizeof(b->asset_name)) {
+            memcpy(b->asset_name, value, len + 1);
+        } else if (strcmp(s->key, "browser_download_url") == 0) {
+            memcpy(b->asset_url, value, len + 1);
+        }
+    }
+}
+
+static void on_close(void *ctx, const json_scan_t *s)
+{
+    bench_scan_t *b = ctx;
+    if (s->depth == 3 && strcmp(b->asset_name, "thermux.bin.gz") == 0) {
+        strcpy(b->image_url, b->asset_url);
+    }
+}
+
+static bool scan_release(void)
+{
+    bench_scan_t *b = calloc(1, sizeof(*b));
+    json_scan_init(&b->scan, on_string, on_close, b);
+    for (size_t off = 0; off < s_release_len; off += BENCH_PIECE) {
+        size_t n = s_release_len - off < BENCH_PIECE ? s_release_len - off : BENCH_PIECE;
+        json_scan_feed(&b->scan, s_release + off, n);
+    }
+    bool ok = json_scan_finish(&b->scan) == JSON_SCAN_OK && strcmp(b->tag_name, "v2.8.0") == 0 &&
+              strstr(b->image_url, "/thermux.bin.gz") != NULL;
+    free(b);
+    return ok;
+}
+
+/* ===== cJSON baseline: whole response buffered, then parsed ===== */
+
+#ifdef BENCH_HAVE_CJSON
+static size_t s_heap;
+static size_t s_heap_peak;
+static long s_allocs;
+
+/* Size prefix so frees can be subtracted */
+static void *tracking_malloc(size_t size)
+{
+    size_t *p = malloc(sizeof(size_t) * 2 + size);
+    p[0] = size;
+    s_heap += size;
+    if (s_heap > s_heap_peak) {
+        s_heap_peak = s_heap;
+    }
+    s_allocs++;
+    return p + 2;
+}
+
+static void tracking_free(void *ptr)
+{
+    if (ptr != NULL) {
+        size_t *p = (size_t *)ptr - 2;
+        s_heap -= p[0];
+        free(p);
+    }
+}
+
+static bool cjson_release(void)
+{
+    char *buf = tracking_malloc(s_release_len + 1);
+    size_t len = 0;
+    for (size_t off = 0; off < s_release_len; off += BENCH_PIECE) {
+        size_t n = s_release_len - off < BENCH_PIECE ? s_release_len - off : BENCH_PIECE;
+        memcpy(buf + len, s_release + off, n);
+        len += n;
+    }
+    buf[len] = '\0';
+
+    bool ok = false;
+    cJSON *root = cJSON_Parse(buf);
+    cJSON *tag = cJSON_GetObjectItem(root, "tag_name");
+    cJSON *assets = cJSON_GetObjectItem(root, "assets");
+    cJSON *asset;
+    cJSON_ArrayForEach(asset, assets) {
+        cJSON *name = cJSON_GetObjectItem(asset, "name");
+        if (cJSON_IsString(name) && strcmp(name->valuestring, "thermux.bin.gz") == 0) {
+            ok = cJSON_IsString(tag) && strcmp(tag->valuestring, "v2.8.0") == 0;
+        }
+    }
+    cJSON_Delete(root);
+    tracking_free(buf);
+    return ok;
+}
+#endif
+
+/* ===== Runner ===== */
+
+static void bench_case(const char *name, bool (*check)(void), size_t peak, long allocs)
+{
+    if (!check()) {
+        printf("  %-36s WRONG RESULT\n", name);
+        return;
+    }
+    uint64_t start = bench_now_ns();
+    for (int i = 0; i < BENCH_CHECKS; i++) {
+        check();
+    }
+    uint64_t elapsed = bench_now_ns() - start;
+    bench_report(name, BENCH_CHECKS, elapsed, peak, allocs);
+}
+
+void run_release_scan_bench(void)
+{
+    init_release();
+    printf("  (%zu byte response, %d assets; bytes = peak heap of the parse)\n", s_release_len, BENCH_ASSETS);
+
+    bench_case("json_scan, 512 B pieces", scan_release, sizeof(bench_scan_t), 1);
+
+#ifdef BENCH_HAVE_CJSON
+    cJSON_Hooks hooks = { .malloc_fn = tracking_malloc, .free_fn = tracking_free };
+    cJSON_InitHooks(&hooks);
+    s_heap_peak = 0;
+    s_allocs = 0;
+    cjson_release();
+    size_t peak = s_heap_peak;
+    long allocs = s_allocs;
+    bench_case("buffer + cJSON_Parse", cjson_release, peak, allocs);
+    cJSON_InitHooks(NULL);
+#else
+    printf("  %-36s %22s %6zu bytes  (buffer alone; cJSON tree skipped)\n",
+           "buffer + cJSON_Parse", "", s_release_len + 1);
+#endif
+}
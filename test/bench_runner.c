@@ -0,0 +1,44 @@
+/**
+ * @file bench_runner.c
+ * @brief Host benchmark runner
+ *
+ * Run: ./build/bench_runner
+ */
+
+#include <stdio.h>
+
+/* Benchmark suites */
+extern void run_json_writer_bench(void);
+extern void run_telemetry_bench(void);
+extern void run_metrics_bench(void);
+extern void run_auth_bench(void);
+extern void run_export_bench(void);
+extern void run_release_scan_bench(void);
+
+int main(void)
+{
+    printf("\n-----------------------\n");
+    printf("Running Host Benchmarks\n");
+    printf("-----------------------\n");
+
+    printf("\n[JSON Writer vs cJSON]\n");
+    run_json_writer_bench();
+
+    printf("\n[Telemetry Encoding]\n");
+    run_telemetry_bench();
+
+    printf("\n[Metrics Scrape]\n");
+    run_metrics_bench();
+
+    printf("\n[Auth Check per Request]\n");
+    run_auth_bench();
+
+    printf("\n[History Export]\n");
+    run_export_bench();
+
+    printf("\n[Update Check Parse]\n");
+    run_release_scan_bench();
+
+    printf("\n");
+    return 0;
+}
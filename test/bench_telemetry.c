@@ -0,0 +1,88 @@
+/**
+ * @file bench_telemetry.c
+ * @brief CBOR telemetry batch vs JSON batch vs per-sensor text state topics
+ */
+
+#include "bench.h"
+#include "json_writer.h"
+#include "telemetry_cbor.h"
+#include <string.h>
+
+#define BENCH_SENSOR_COUNT 20
+#define BENCH_BASE_TOPIC "thermux"
+#define BENCH_TIMESTAMP 1760000000u
+
+static telemetry_reading_t s_readings[BENCH_SENSOR_COUNT];
+static float s_temperatures[BENCH_SENSOR_COUNT];
+static char s_ids[BENCH_SENSOR_COUNT][17];
+
+static void init_readings(void)
+{
+    for (int i = 0; i < BENCH_SENSOR_COUNT; i++) {
+        uint64_t id = 0x28FF000001234560ull + i;
+        telemetry_id_to_rom(id, s_readings[i].rom);
+        snprintf(s_ids[i], sizeof(s_ids[i]), "%016llX", (unsigned long long)id);
+        s_temperatures[i] = 18.0f + i * 0.0625f;
+        s_readings[i].temp_centi = telemetry_temp_to_centi(s_temperatures[i]);
+        s_readings[i].timestamp = BENCH_TIMESTAMP - i;
+    }
+}
+
+static int cbor_batch(void *buf, size_t size)
+{
+    return telemetry_cbor_encode(buf, size, BENCH_TIMESTAMP, s_readings, BENCH_SENSOR_COUNT);
+}
+
+/* Same content with JSON keys a collector would otherwise get */
+static int json_batch(void *buf, size_t size)
+{
+    json_writer_t w;
+    json_writer_init(&w, buf, size, NULL, NULL);
+    json_writer_begin_object(&w);
+    json_writer_kv_uint(&w, "timestamp", BENCH_TIMESTAMP);
+    json_writer_key(&w, "readings");
+    json_writer_begin_array(&w);
+    for (int i = 0; i < BENCH_SENSOR_COUNT; i++) {
+        json_writer_begin_object(&w);
+        json_writer_kv_string(&w, "id", s_ids[i]);
+        json_writer_kv_double(&w, "temperature", s_readings[i].temp_centi / 100.0);
+        json_writer_kv_uint(&w, "timestamp", s_readings[i].timestamp);
+        json_writer_end_object(&w);
+    }
+    json_writer_end_array(&w);
+    json_writer_end_object(&w);
+    return json_writer_finish(&w);
+}
+
+/* Current state topics: one message per sensor, counting topic + payload */
+static int text_topics(void *buf, size_t size)
+{
+    int total = 0;
+    for (int i = 0; i < BENCH_SENSOR_COUNT; i++) {
+        char topic[64];
+        total += snprintf(topic, sizeof(topic), "%s/sensor/%s/state", BENCH_BASE_TOPIC, s_ids[i]);
+        total += snprintf(buf, size, "%.2f", s_temperatures[i]);
+    }
+    return total;
+}
+
+static void bench_case(const char *name, int (*build)(void *, size_t))
+{
+    static uint8_t buf[4096];
+    int len = 0;
+    uint64_t start = bench_now_ns();
+    for (int i = 0; i < BENCH_ITERATIONS; i++) {
+        len = build(buf, sizeof(buf));
+    }
+    uint64_t elapsed = bench_now_ns() - start;
+    bench_report(name, BENCH_ITERATIONS, elapsed, len > 0 ? (size_t)len : 0, 0);
+}
+
+void run_telemetry_bench(void)
+{
+    init_readings();
+
+    bench_case("CBOR batch (20)", cbor_batch);
+    bench_case("JSON batch (20)", json_batch);
+    bench_case("text state topics (20, incl. topics)", text_topics);
+}
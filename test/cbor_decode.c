@@ -0,0 +1,245 @@
+/**
+ * @file cbor_decode.c
+ * @brief Minimal CBOR decoder for verifying telemetry payloads (host-side)
+ */
+
+#include "cbor_decode.h"
+
+#define CBOR_MAJOR_UINT   0
+#define CBOR_MAJOR_NINT   1
+#define CBOR_MAJOR_BYTES  2
+#define CBOR_MAJOR_TEXT   3
+#define CBOR_MAJOR_ARRAY  4
+#define CBOR_MAJOR_MAP    5
+
+#define CBOR_BREAK 0xFF
+
+void cbor_reader_init(cbor_reader_t *r, const uint8_t *buf, size_t len)
+{
+    r->buf = buf;
+    r->len = len;
+    r->pos = 0;
+}
+
+int cbor_read_head(cbor_reader_t *r, uint8_t *major, uint64_t *arg)
+{
+    if (r->pos >= r->len) {
+        return -1;
+    }
+    uint8_t initial = r->buf[r->pos++];
+    uint8_t info = initial & 0x1F;
+    *major = initial >> 5;
+
+    size_t n;
+    if (info < 24) {
+        *arg = info;
+        return 0;
+    } else if (info == 24) {
+        n = 1;
+    } else if (info == 25) {
+        n = 2;
+    } else if (info == 26) {
+        n = 4;
+    } else if (info == 27) {
+        n = 8;
+    } else if (info == 31 && (*major == CBOR_MAJOR_ARRAY || *major == CBOR_MAJOR_MAP)) {
+        *arg = CBOR_DECODE_INDEFINITE;
+        return 0;
+    } else {
+        return -1;  /* Indefinite strings, break and reserved values */
+    }
+
+    if (r->len - r->pos < n) {
+        return -1;
+    }
+    *arg = 0;
+    for (size_t i = 0; i < n; i++) {
+        *arg = (*arg << 8) | r->buf[r->pos++];
+    }
+    return 0;
+}
+
+int cbor_read_int(cbor_reader_t *r, int64_t *value)
+{
+    uint8_t major;
+    uint64_t arg;
+    if (cbor_read_head(r, &major, &arg) != 0 || arg > INT64_MAX) {
+        return -1;
+    }
+    if (major == CBOR_MAJOR_UINT) {
+        *value = (int64_t)arg;
+    } else if (major == CBOR_MAJOR_NINT) {
+        *value = -1 - (int64_t)arg;
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+int cbor_read_container(cbor_reader_t *r, uint8_t major, uint64_t *count)
+{
+    uint8_t actual;
+    if (cbor_read_head(r, &actual, count) != 0 || actual != major) {
+        return -1;
+    }
+    return 0;
+}
+
+bool cbor_read_break(cbor_reader_t *r)
+{
+    if (r->pos < r->len && r->buf[r->pos] == CBOR_BREAK) {
+        r->pos++;
+        return true;
+    }
+    return false;
+}
+
+int cbor_skip(cbor_reader_t *r)
+{
+    uint8_t major;
+    uint64_t arg;
+    if (cbor_read_head(r, &major, &arg) != 0) {
+        return -1;
+    }
+
+    switch (major) {
+    case CBOR_MAJOR_UINT:
+    case CBOR_MAJOR_NINT:
+        return 0;
+    case CBOR_MAJOR_BYTES:
+    case CBOR_MAJOR_TEXT:
+        if (r->len - r->pos < arg) {
+            return -1;
+        }
+        r->pos += arg;
+        return 0;
+    case CBOR_MAJOR_ARRAY:
+    case CBOR_MAJOR_MAP: {
+        if (arg == CBOR_DECODE_INDEFINITE) {
+            while (!cbor_read_break(r)) {
+                if (cbor_skip(r) != 0 || (major == CBOR_MAJOR_MAP && cbor_skip(r) != 0)) {
+                    return -1;
+                }
+            }
+            return 0;
+        }
+        uint64_t items = major == CBOR_MAJOR_MAP ? arg * 2 : arg;
+        for (uint64_t i = 0; i < items; i++) {
+            if (cbor_skip(r) != 0) {
+                return -1;
+            }
+        }
+        return 0;
+    }
+    default:
+        return -1;
+    }
+}
+
+static int read_reading(cbor_reader_t *r, telemetry_reading_t *reading)
+{
+    uint64_t fields;
+    uint8_t major;
+    uint64_t id;
+    int64_t temp;
+    int64_t timestamp;
+
+    if (cbor_read_container(r, CBOR_MAJOR_ARRAY, &fields) != 0 || fields != 3) {
+        return -1;
+    }
+    if (cbor_read_head(r, &major, &id) != 0 || major != CBOR_MAJOR_UINT) {
+        return -1;
+    }
+    if (cbor_read_int(r, &temp) != 0 || temp < INT32_MIN || temp > INT32_MAX) {
+        return -1;
+    }
+    if (cbor_read_int(r, &timestamp) != 0 || timestamp < 0 || timestamp > UINT32_MAX) {
+        return -1;
+    }
+
+    telemetry_id_to_rom(id, reading->rom);
+    reading->temp_centi = (int32_t)temp;
+    reading->timestamp = (uint32_t)timestamp;
+    return 0;
+}
+
+int telemetry_cbor_decode(const uint8_t *buf, size_t len, uint32_t *timestamp,
+                          telemetry_reading_t *readings, size_t max, size_t *count)
+{
+    cbor_reader_t r;
+    uint64_t pairs;
+    bool have_version = false;
+    bool have_readings = false;
+
+    cbor_reader_init(&r, buf, len);
+    *timestamp = 0;
+    *count = 0;
+
+    if (cbor_read_container(&r, CBOR_MAJOR_MAP, &pairs) != 0) {
+        return -1;
+    }
+
+    for (uint64_t i = 0; i < pairs; i++) {
+        int64_t key;
+        int64_t value;
+        if (cbor_read_int(&r, &key) != 0) {
+            return -1;
+        }
+
+        switch (key) {
+        case TELEMETRY_CBOR_KEY_VERSION:
+            if (cbor_read_int(&r, &value) != 0 || value != TELEMETRY_CBOR_VERSION) {
+                return -1;
+            }
+            have_version = true;
+            break;
+
+        case TELEMETRY_CBOR_KEY_TIME:
+            if (cbor_read_int(&r, &value) != 0 || value < 0 || value > UINT32_MAX) {
+                return -1;
+            }
+            *timestamp = (uint32_t)value;
+            break;
+
+        case TELEMETRY_CBOR_KEY_READINGS: {
+            uint64_t n;
+            if (cbor_read_container(&r, CBOR_MAJOR_ARRAY, &n) != 0) {
+                return -1;
+            }
+            if (n == CBOR_DECODE_INDEFINITE) {
+                /* Streamed batch: readings run up to the break */
+                for (n = 0; !cbor_read_break(&r); n++) {
+                    if (n == max || read_reading(&r, &readings[n]) != 0) {
+                        return -1;
+                    }
+                }
+            } else {
+                if (n > max) {
+                    return -1;
+                }
+                for (uint64_t j = 0; j < n; j++) {
+                    if (read_reading(&r, &readings[j]) != 0) {
+                        return -1;
+                    }
+                }
+            }
+            *count = (size_t)n;
+            have_readings = true;
+            break;
+        }
+
+        default:
+            /* Fields added by later schema revisions */
+            if (cbor_skip(&r) != 0) {
+                return -1;
+            }
+            break;
+        }
+    }
+
+    /* Trailing bytes mean the length prefix or framing is wrong */
+    if (!have_version || !have_readings || r.pos != r.len) {
+        return -1;
+    }
+    return 0;
+}
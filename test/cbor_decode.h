@@ -0,0 +1,75 @@
+/**
+ * @file cbor_decode.h
+ * @brief Minimal CBOR decoder for verifying telemetry payloads (host-side)
+ *
+ * Mirrors what a collector does with a telemetry batch. Only the items
+ * produced by cbor_writer are supported: definite-length items plus
+ * indefinite-length arrays and maps.
+ */
+
+#ifndef CBOR_DECODE_H
+#define CBOR_DECODE_H
+
+#include "telemetry_cbor.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Reader state
+ */
+typedef struct {
+    const uint8_t *buf;
+    size_t len;
+    size_t pos;
+} cbor_reader_t;
+
+/** @brief Count reported for an indefinite-length array or map */
+#define CBOR_DECODE_INDEFINITE UINT64_MAX
+
+void cbor_reader_init(cbor_reader_t *r, const uint8_t *buf, size_t len);
+
+/**
+ * @brief Read an item head
+ * @param major Output: major type (0-7)
+ * @param arg Output: argument (value, length or count; CBOR_DECODE_INDEFINITE
+ *            for an indefinite-length array or map)
+ * @return 0 on success, -1 on truncated or unsupported input
+ */
+int cbor_read_head(cbor_reader_t *r, uint8_t *major, uint64_t *arg);
+
+/**
+ * @brief Read an integer (major type 0 or 1)
+ */
+int cbor_read_int(cbor_reader_t *r, int64_t *value);
+
+/**
+ * @brief Read a container head of the given major type
+ */
+int cbor_read_container(cbor_reader_t *r, uint8_t major, uint64_t *count);
+
+/**
+ * @brief Consume the break that ends an indefinite-length container
+ * @return true if the next byte was a break
+ */
+bool cbor_read_break(cbor_reader_t *r);
+
+/**
+ * @brief Skip one complete item (including nested items)
+ */
+int cbor_skip(cbor_reader_t *r);
+
+/**
+ * @brief Decode a telemetry batch
+ * @param buf Encoded batch
+ * @param len Encoded length
+ * @param timestamp Output: batch time
+ * @param readings Output array
+ * @param max Capacity of readings
+ * @param count Output: number of readings decoded
+ * @return 0 on success, -1 on malformed input, unknown version or overflow
+ */
+int telemetry_cbor_decode(const uint8_t *buf, size_t len, uint32_t *timestamp,
+                          telemetry_reading_t *readings, size_t max, size_t *count);
+
+#endif /* CBOR_DECODE_H */
@@ -0,0 +1,32 @@
+/**
+ * @file sha256.h
+ * @brief Host stand-in for the mbedtls SHA-256 calls the firmware makes
+ *
+ * Same names and signatures as mbedtls, so the modules under test build
+ * unchanged; on the device they come from ESP-IDF's mbedtls, which uses
+ * the SHA accelerator. SHA-224 is not supported.
+ */
+
+#ifndef MBEDTLS_SHA256_H
+#define MBEDTLS_SHA256_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define MBEDTLS_ERR_SHA256_BAD_INPUT_DATA -0x0074
+
+typedef struct {
+    uint32_t state[8];
+    uint64_t length;            /* Bytes hashed so far */
+    uint8_t block[64];          /* Pending partial block */
+} mbedtls_sha256_context;
+
+void mbedtls_sha256_init(mbedtls_sha256_context *ctx);
+void mbedtls_sha256_free(mbedtls_sha256_context *ctx);
+void mbedtls_sha256_clone(mbedtls_sha256_context *dst, const mbedtls_sha256_context *src);
+int mbedtls_sha256_starts(mbedtls_sha256_context *ctx, int is224);
+int mbedtls_sha256_update(mbedtls_sha256_context *ctx, const unsigned char *input, size_t ilen);
+int mbedtls_sha256_finish(mbedtls_sha256_context *ctx, unsigned char *output);
+int mbedtls_sha256(const unsigned char *input, size_t ilen, unsigned char *output, int is224);
+
+#endif /* MBEDTLS_SHA256_H */
@@ -0,0 +1,203 @@
+/**
+ * @file test_auth_session.c
+ * @brief Unit tests for session tokens, cookie parsing and secret checks
+ */
+
+#include "unity.h"
+#include "auth_session.h"
+#include <stdio.h>
+#include <string.h>
+
+static auth_sessions_t s_table;
+
+static void make_token(char *out, unsigned n)
+{
+    snprintf(out, AUTH_TOKEN_LEN + 1, "%032x", n * 2654435761u);
+}
+
+/* ===== Secret Comparison Tests ===== */
+
+void test_auth_secret_equal(void)
+{
+    TEST_ASSERT_TRUE(auth_secret_equal("0123abcd", "0123abcd"));
+    TEST_ASSERT_FALSE(auth_secret_equal("0123abce", "0123abcd"));
+    TEST_ASSERT_FALSE(auth_secret_equal("0123abc", "0123abcd"));
+    TEST_ASSERT_FALSE(auth_secret_equal("0123abcde", "0123abcd"));
+    TEST_ASSERT_FALSE(auth_secret_equal("", "0123abcd"));
+
+    /* Nothing matches an unset secret */
+    TEST_ASSERT_FALSE(auth_secret_equal("", ""));
+}
+
+/* ===== Cookie Tests ===== */
+
+void test_auth_cookie_value(void)
+{
+    char value[AUTH_TOKEN_BUF_SIZE];
+    TEST_ASSERT_EQUAL_INT(3, auth_cookie_value("session=abc", "session", value, sizeof(value)));
+    TEST_ASSERT_EQUAL_STRING("abc", value);
+
+    TEST_ASSERT_EQUAL_INT(4, auth_cookie_value("theme=dark; session=wxyz; lang=en", "session",
+                                               value, sizeof(value)));
+    TEST_ASSERT_EQUAL_STRING("wxyz", value);
+
+    TEST_ASSERT_EQUAL_INT(0, auth_cookie_value("session=", "session", value, sizeof(value)));
+}
+
+void test_auth_cookie_value_exact_name(void)
+{
+    char value[AUTH_TOKEN_BUF_SIZE];
+
+    /* A cookie whose name merely ends in "session" is not the session */
+    TEST_ASSERT_EQUAL_INT(-1, auth_cookie_value("oldsession=abc", "session", value, sizeof(value)));
+    TEST_ASSERT_EQUAL_INT(2, auth_cookie_value("oldsession=abc; session=ok", "session",
+                                               value, sizeof(value)));
+    TEST_ASSERT_EQUAL_STRING("ok", value);
+    TEST_ASSERT_EQUAL_INT(-1, auth_cookie_value("", "session", value, sizeof(value)));
+}
+
+void test_auth_cookie_value_too_long(void)
+{
+    char value[8];
+    TEST_ASSERT_EQUAL_INT(-1, auth_cookie_value("session=0123456789", "session", value, sizeof(value)));
+}
+
+/* ===== Session Table Tests ===== */
+
+void test_auth_sessions_add_check_remove(void)
+{
+    char token[AUTH_TOKEN_LEN + 1];
+    auth_sessions_clear(&s_table);
+    make_token(token, 1);
+
+    TEST_ASSERT_FALSE(auth_sessions_check(&s_table, token, 0));
+    auth_sessions_add(&s_table, token, 1000, 0);
+    TEST_ASSERT_TRUE(auth_sessions_check(&s_table, token, 500));
+
+    TEST_ASSERT_TRUE(auth_sessions_remove(&s_table, token));
+    TEST_ASSERT_FALSE(auth_sessions_check(&s_table, token, 500));
+    TEST_ASSERT_FALSE(auth_sessions_remove(&s_table, token));
+}
+
+void test_auth_sessions_lazy_expiry(void)
+{
+    char token[AUTH_TOKEN_LEN + 1];
+    auth_sessions_clear(&s_table);
+    make_token(token, 2);
+    auth_sessions_add(&s_table, token, 1000, 0);
+
+    TEST_ASSERT_TRUE(auth_sessions_check(&s_table, token, 1000));
+    TEST_ASSERT_FALSE(auth_sessions_check(&s_table, token, 1001));
+
+    /* The expired entry was dropped on lookup */
+    TEST_ASSERT_FALSE(auth_sessions_remove(&s_table, token));
+}
+
+void test_auth_sessions_rejects_malformed(void)
+{
+    auth_sessions_clear(&s_table);
+    TEST_ASSERT_FALSE(auth_sessions_check(&s_table, "", 0));
+    TEST_ASSERT_FALSE(auth_sessions_check(&s_table, "abc", 0));
+
+    /* A well-formed token matches nothing in an empty table */
+    char zeros[AUTH_TOKEN_LEN + 1];
+    memset(zeros, '0', AUTH_TOKEN_LEN);
+    zeros[AUTH_TOKEN_LEN] = '\0';
+    TEST_ASSERT_FALSE(auth_sessions_check(&s_table, zeros, 0));
+}
+
+void test_auth_sessions_capacity(void)
+{
+    /* Far more sessions than the old fixed table of 4 */
+    char token[AUTH_TOKEN_LEN + 1];
+    int kept = 0;
+    auth_sessions_clear(&s_table);
+    for (unsigned i = 0; i < 16; i++) {
+        make_token(token, 100 + i);
+        auth_sessions_add(&s_table, token, 1000 + i, 0);
+    }
+    for (unsigned i = 0; i < 16; i++) {
+        make_token(token, 100 + i);
+        kept += auth_sessions_check(&s_table, token, 0);
+    }
+    TEST_ASSERT_GREATER_THAN(12, kept);
+}
+
+void test_auth_sessions_evicts_soonest_expiry(void)
+{
+    /* Twice as many sessions as ways: full buckets replace the session
+       that expires first, so the latest logins survive */
+    char tokens[64][AUTH_TOKEN_LEN + 1];
+    auth_sessions_clear(&s_table);
+    for (unsigned i = 0; i < 64; i++) {
+        make_token(tokens[i], 500 + i);
+        auth_sessions_add(&s_table, tokens[i], 1000 + i, 0);
+    }
+
+    int kept = 0;
+    for (unsigned i = 0; i < 64; i++) {
+        kept += auth_sessions_check(&s_table, tokens[i], 0);
+    }
+    TEST_ASSERT_EQUAL_INT(AUTH_SESSION_BUCKETS * AUTH_SESSION_WAYS, kept);
+    TEST_ASSERT_FALSE(auth_sessions_check(&s_table, tokens[0], 0));
+    TEST_ASSERT_TRUE(auth_sessions_check(&s_table, tokens[63], 0));
+}
+
+/* ===== Signed Token Tests ===== */
+
+void test_auth_token_sign_verify(void)
+{
+    uint8_t key[AUTH_SIGNING_KEY_SIZE];
+    for (int i = 0; i < AUTH_SIGNING_KEY_SIZE; i++) {
+        key[i] = (uint8_t)(i * 7 + 1);
+    }
+
+    char token[AUTH_TOKEN_BUF_SIZE];
+    auth_token_sign(key, 0x00093a80, token);
+    TEST_ASSERT_EQUAL_INT(AUTH_SIGNED_TOKEN_LEN, strlen(token));
+    TEST_ASSERT_TRUE(strncmp(token, "00093a80", 8) == 0);
+
+    TEST_ASSERT_TRUE(auth_token_verify(key, token, 0));
+    TEST_ASSERT_TRUE(auth_token_verify(key, token, 0x00093a80));
+    TEST_ASSERT_FALSE(auth_token_verify(key, token, 0x00093a81));
+}
+
+void test_auth_token_tampering(void)
+{
+    uint8_t key[AUTH_SIGNING_KEY_SIZE] = { 1, 2, 3 };
+    uint8_t other_key[AUTH_SIGNING_KEY_SIZE] = { 1, 2, 4 };
+    char token[AUTH_TOKEN_BUF_SIZE];
+    auth_token_sign(key, 1000, token);
+
+    TEST_ASSERT_FALSE(auth_token_verify(other_key, token, 0));
+
+    /* Extending the expiry invalidates the tag */
+    char forged[AUTH_TOKEN_BUF_SIZE];
+    strcpy(forged, token);
+    forged[0] = 'f';
+    TEST_ASSERT_FALSE(auth_token_verify(key, forged, 0));
+
+    strcpy(forged, token);
+    forged[AUTH_SIGNED_TOKEN_LEN - 1] ^= 1;
+    TEST_ASSERT_FALSE(auth_token_verify(key, forged, 0));
+
+    TEST_ASSERT_FALSE(auth_token_verify(key, "", 0));
+    TEST_ASSERT_FALSE(auth_token_verify(key, "0000ffffXYZ", 0));
+}
+
+/* ===== Test Runner ===== */
+
+void run_auth_session_tests(void)
+{
+    RUN_TEST(test_auth_secret_equal);
+    RUN_TEST(test_auth_cookie_value);
+    RUN_TEST(test_auth_cookie_value_exact_name);
+    RUN_TEST(test_auth_cookie_value_too_long);
+    RUN_TEST(test_auth_sessions_add_check_remove);
+    RUN_TEST(test_auth_sessions_lazy_expiry);
+    RUN_TEST(test_auth_sessions_rejects_malformed);
+    RUN_TEST(test_auth_sessions_capacity);
+    RUN_TEST(test_auth_sessions_evicts_soonest_expiry);
+    RUN_TEST(test_auth_token_sign_verify);
+    RUN_TEST(test_auth_token_tampering);
+}
@@ -0,0 +1,214 @@
+/**
+ * @file test_boot_health.c
+ * @brief Unit tests for the boot health check and per-version boot metrics
+ */
+
+#include "unity.h"
+#include "boot_health.h"
+#include <string.h>
+
+static boot_health_t s_health;
+static boot_metrics_t s_metrics;
+
+/* Budget of 60 s, previous boot found 2 sensors */
+static void healthy_boot(boot_health_t *h, bool require_mqtt)
+{
+    boot_health_init(h, 60000, 2, 0, require_mqtt);
+    boot_health_scanned(h, 900, 2);
+    boot_health_cycle(h, 1800, 2);
+    boot_health_network_up(h, 4000);
+    boot_health_mqtt_connected(h, 5200);
+}
+
+/* ===== Health Check Tests ===== */
+
+void test_boot_health_passes_when_all_milestones_met(void)
+{
+    boot_health_init(&s_health, 60000, 2, 0, true);
+    TEST_ASSERT_EQUAL_INT(BOOT_HEALTH_PENDING, boot_health_evaluate(&s_health, 100));
+    boot_health_scanned(&s_health, 900, 2);
+    boot_health_cycle(&s_health, 1800, 2);
+    boot_health_network_up(&s_health, 4000);
+    TEST_ASSERT_EQUAL_STRING("mqtt", boot_health_missing(&s_health));
+    TEST_ASSERT_EQUAL_INT(BOOT_HEALTH_PENDING, boot_health_evaluate(&s_health, 4000));
+    boot_health_mqtt_connected(&s_health, 5200);
+    TEST_ASSERT_NULL(boot_health_missing(&s_health));
+    TEST_ASSERT_EQUAL_INT(BOOT_HEALTH_PASSED, boot_health_evaluate(&s_health, 5200));
+}
+
+void test_boot_health_fails_at_budget(void)
+{
+    healthy_boot(&s_health, true);
+    s_health.mqtt_ms = 0;
+    TEST_ASSERT_EQUAL_INT(BOOT_HEALTH_PENDING, boot_health_evaluate(&s_health, 59999));
+    TEST_ASSERT_EQUAL_INT(BOOT_HEALTH_FAILED, boot_health_evaluate(&s_health, 60000));
+
+    /* Without the MQTT requirement the same boot is healthy */
+    healthy_boot(&s_health, false);
+    s_health.mqtt_ms = 0;
+    TEST_ASSERT_EQUAL_INT(BOOT_HEALTH_PASSED, boot_health_evaluate(&s_health, 60000));
+}
+
+void test_boot_health_tolerates_missing_sensors(void)
+{
+    /* By default one sensor out of the previous three is enough */
+    boot_health_init(&s_health, 60000, 3, 0, false);
+    TEST_ASSERT_EQUAL_INT(1, boot_health_required_sensors(&s_health));
+    boot_health_scanned(&s_health, 900, 2);
+    boot_health_cycle(&s_health, 1800, 2);
+    boot_health_network_up(&s_health, 4000);
+    TEST_ASSERT_EQUAL_INT(BOOT_HEALTH_PASSED, boot_health_evaluate(&s_health, 4000));
+
+    /* Finding none fails */
+    boot_health_init(&s_health, 60000, 3, 0, false);
+    boot_health_scanned(&s_health, 900, 0);
+    boot_health_cycle(&s_health, 1800, 0);
+    boot_health_network_up(&s_health, 4000);
+    TEST_ASSERT_EQUAL_STRING("sensors", boot_health_missing(&s_health));
+    TEST_ASSERT_EQUAL_INT(BOOT_HEALTH_FAILED, boot_health_evaluate(&s_health, 60000));
+}
+
+void test_boot_health_requires_share_of_sensors(void)
+{
+    /* 75% of 3 rounds up to all three */
+    boot_health_init(&s_health, 60000, 3, 75, false);
+    TEST_ASSERT_EQUAL_INT(3, boot_health_required_sensors(&s_health));
+    boot_health_scanned(&s_health, 900, 2);
+    boot_health_cycle(&s_health, 1800, 2);
+    boot_health_network_up(&s_health, 4000);
+    TEST_ASSERT_EQUAL_STRING("sensors", boot_health_missing(&s_health));
+    TEST_ASSERT_EQUAL_INT(BOOT_HEALTH_FAILED, boot_health_evaluate(&s_health, 60000));
+
+    boot_health_init(&s_health, 60000, 4, 50, false);
+    TEST_ASSERT_EQUAL_INT(2, boot_health_required_sensors(&s_health));
+    boot_health_init(&s_health, 60000, 0, 100, false);
+    TEST_ASSERT_EQUAL_INT(0, boot_health_required_sensors(&s_health));
+}
+
+void test_boot_health_cycle_needs_a_valid_reading(void)
+{
+    boot_health_init(&s_health, 60000, 1, 0, false);
+    boot_health_scanned(&s_health, 900, 1);
+    boot_health_cycle(&s_health, 1800, 0);
+    TEST_ASSERT_EQUAL_STRING("reading", boot_health_missing(&s_health));
+    boot_health_cycle(&s_health, 11800, 1);
+    TEST_ASSERT_EQUAL_INT(11800, s_health.first_cycle_ms);
+
+    /* With no sensors on the bus any completed cycle counts */
+    boot_health_init(&s_health, 60000, 0, 0, false);
+    boot_health_scanned(&s_health, 900, 0);
+    boot_health_cycle(&s_health, 1000, 0);
+    TEST_ASSERT_EQUAL_INT(1000, s_health.first_cycle_ms);
+}
+
+void test_boot_health_keeps_first_milestone(void)
+{
+    healthy_boot(&s_health, true);
+    boot_health_scanned(&s_health, 7000, 5);
+    boot_health_network_up(&s_health, 9000);
+    boot_health_published(&s_health, 0);
+    boot_health_published(&s_health, 30000);
+    TEST_ASSERT_EQUAL_INT(900, s_health.scan_ms);
+    TEST_ASSERT_EQUAL_INT(2, s_health.sensors_found);
+    TEST_ASSERT_EQUAL_INT(4000, s_health.network_ms);
+    TEST_ASSERT_EQUAL_INT(1, s_health.first_publish_ms);    /* 0 means "not reached" */
+}
+
+/* ===== Metrics Tests ===== */
+
+void test_boot_metrics_averages_per_version(void)
+{
+    memset(&s_metrics, 0, sizeof(s_metrics));
+    TEST_ASSERT_EQUAL_INT(0, boot_metrics_expected_sensors(&s_metrics));
+
+    healthy_boot(&s_health, true);
+    boot_health_published(&s_health, 8000);
+    boot_metrics_record(&s_metrics, "2.7.0", &s_health, true);
+    healthy_boot(&s_health, true);
+    s_health.first_cycle_ms = 2800;
+    boot_metrics_record(&s_metrics, "2.7.0", &s_health, true);
+
+    const boot_metrics_entry_t *e = boot_metrics_find(&s_metrics, "2.7.0");
+    TEST_ASSERT_NOT_NULL(e);
+    TEST_ASSERT_EQUAL_INT(2, e->boots);
+    TEST_ASSERT_EQUAL_INT(0, e->failed);
+    TEST_ASSERT_EQUAL_INT(2, e->sensors);
+    TEST_ASSERT_EQUAL_INT(2300, e->reading_avg_ms);
+    TEST_ASSERT_EQUAL_INT(2800, e->last_reading_ms);
+    /* The second boot never published: last is cleared, the mean keeps one sample */
+    TEST_ASSERT_EQUAL_INT(1, e->publish_count);
+    TEST_ASSERT_EQUAL_INT(8000, e->publish_avg_ms);
+    TEST_ASSERT_EQUAL_INT(0, e->last_publish_ms);
+    TEST_ASSERT_EQUAL_INT(2, boot_metrics_expected_sensors(&s_metrics));
+}
+
+void test_boot_metrics_newest_first_and_evicts_oldest(void)
+{
+    static const char *const versions[] = { "2.4.0", "2.5.0", "2.6.0", "2.7.0", "2.8.0" };
+    memset(&s_metrics, 0, sizeof(s_metrics));
+    healthy_boot(&s_health, true);
+    for (int i = 0; i < 5; i++) {
+        boot_metrics_record(&s_metrics, versions[i], &s_health, true);
+    }
+    TEST_ASSERT_NULL(boot_metrics_find(&s_metrics, "2.4.0"));
+    TEST_ASSERT_EQUAL_STRING("2.8.0", s_metrics.entries[0].version);
+    TEST_ASSERT_EQUAL_STRING("2.5.0", s_metrics.entries[3].version);
+
+    /* Booting an older version again (a rollback) moves it to the front */
+    boot_metrics_record(&s_metrics, "2.6.0", &s_health, true);
+    TEST_ASSERT_EQUAL_STRING("2.6.0", s_metrics.entries[0].version);
+    TEST_ASSERT_EQUAL_STRING("2.8.0", s_metrics.entries[1].version);
+    TEST_ASSERT_EQUAL_STRING("2.7.0", s_metrics.entries[2].version);
+    TEST_ASSERT_EQUAL_INT(2, s_metrics.entries[0].boots);
+}
+
+void test_boot_metrics_counts_failed_boots(void)
+{
+    memset(&s_metrics, 0, sizeof(s_metrics));
+    healthy_boot(&s_health, true);
+    boot_metrics_record(&s_metrics, "2.7.0", &s_health, true);
+
+    /* The update lost a sensor and never reached the broker */
+    healthy_boot(&s_health, true);
+    s_health.sensors_found = 1;
+    s_health.mqtt_ms = 0;
+    boot_metrics_record(&s_metrics, "2.8.0", &s_health, false);
+
+    const boot_metrics_entry_t *e = boot_metrics_find(&s_metrics, "2.8.0");
+    TEST_ASSERT_EQUAL_INT(1, e->boots);
+    TEST_ASSERT_EQUAL_INT(1, e->failed);
+    TEST_ASSERT_EQUAL_INT(1, boot_metrics_expected_sensors(&s_metrics));
+
+    /* After the rollback the old image is the reference again */
+    healthy_boot(&s_health, true);
+    boot_metrics_record(&s_metrics, "2.7.0", &s_health, true);
+    TEST_ASSERT_EQUAL_INT(2, boot_metrics_expected_sensors(&s_metrics));
+    TEST_ASSERT_EQUAL_INT(2, s_metrics.entries[0].boots);
+}
+
+void test_boot_metrics_truncates_long_version(void)
+{
+    memset(&s_metrics, 0, sizeof(s_metrics));
+    healthy_boot(&s_health, true);
+    boot_metrics_record(&s_metrics, "2.8.0-beta.1+build.12345", &s_health, true);
+    TEST_ASSERT_EQUAL_INT(BOOT_METRICS_VERSION_MAX - 1, strlen(s_metrics.entries[0].version));
+    boot_metrics_record(&s_metrics, "2.8.0-beta.1+build.12345", &s_health, true);
+    TEST_ASSERT_EQUAL_INT(2, s_metrics.entries[0].boots);
+    TEST_ASSERT_EQUAL_INT(0, s_metrics.entries[1].boots);
+}
+
+/* ===== Test Runner ===== */
+
+void run_boot_health_tests(void)
+{
+    RUN_TEST(test_boot_health_passes_when_all_milestones_met);
+    RUN_TEST(test_boot_health_fails_at_budget);
+    RUN_TEST(test_boot_health_tolerates_missing_sensors);
+    RUN_TEST(test_boot_health_requires_share_of_sensors);
+    RUN_TEST(test_boot_health_cycle_needs_a_valid_reading);
+    RUN_TEST(test_boot_health_keeps_first_milestone);
+    RUN_TEST(test_boot_metrics_averages_per_version);
+    RUN_TEST(test_boot_metrics_newest_first_and_evicts_oldest);
+    RUN_TEST(test_boot_metrics_counts_failed_boots);
+    RUN_TEST(test_boot_metrics_truncates_long_version);
+}
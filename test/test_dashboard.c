@@ -0,0 +1,147 @@
+/**
+ * @file test_dashboard.c
+ * @brief Unit tests for field-projected sensor and status documents
+ */
+
+#include "unity.h"
+#include "dashboard.h"
+#include <string.h>
+
+static char s_buf[1024];
+
+static const dashboard_sensor_t s_sensor = {
+    .address = "28FF1234567890AB",
+    .temperature = 22.5f,
+    .valid = true,
+    .friendly_name = NULL,
+    .total_reads = 100,
+    .failed_reads = 2,
+};
+
+static const char *write_sensor(uint32_t mask)
+{
+    json_writer_t w;
+    json_writer_init(&w, s_buf, sizeof(s_buf), NULL, NULL);
+    dashboard_write_sensor(&w, &s_sensor, mask);
+    return json_writer_finish(&w) < 0 ? NULL : s_buf;
+}
+
+static void make_status(dashboard_status_t *st)
+{
+    memset(st, 0, sizeof(*st));
+    st->version = "2.7.0";
+    st->sensor_count = 1;
+    st->max_sensors = 20;
+    st->uptime_seconds = 3600;
+    st->free_heap = 123456;
+    st->mqtt_connected = true;
+    st->eth_connected = true;
+    strcpy(st->ethernet_ip, "192.168.1.50");
+    st->total_reads = 200;
+    st->failed_reads = 1;
+    st->rate_limit.rejected_scan = 4;
+    st->rate_limit.rescans_coalesced = 2;
+}
+
+/* ===== Field List Tests ===== */
+
+void test_dashboard_parse_fields(void)
+{
+    uint32_t mask;
+    TEST_ASSERT_EQUAL_INT(0, dashboard_parse_fields("address,temperature", &mask));
+    TEST_ASSERT_TRUE(mask == (DASHBOARD_F_ADDRESS | DASHBOARD_F_TEMPERATURE));
+
+    TEST_ASSERT_EQUAL_INT(0, dashboard_parse_fields("uptime_seconds", &mask));
+    TEST_ASSERT_TRUE(mask == DASHBOARD_F_UPTIME);
+}
+
+void test_dashboard_parse_fields_encoded_comma(void)
+{
+    uint32_t mask;
+    TEST_ASSERT_EQUAL_INT(0, dashboard_parse_fields("address%2Ctemperature%2cvalid", &mask));
+    TEST_ASSERT_TRUE(mask == (DASHBOARD_F_ADDRESS | DASHBOARD_F_TEMPERATURE | DASHBOARD_F_VALID));
+}
+
+void test_dashboard_parse_fields_groups(void)
+{
+    uint32_t mask;
+    TEST_ASSERT_EQUAL_INT(0, dashboard_parse_fields("sensors,version", &mask));
+    TEST_ASSERT_TRUE(mask == (DASHBOARD_SENSOR_FIELDS | DASHBOARD_F_VERSION));
+    TEST_ASSERT_EQUAL_INT(0, dashboard_parse_fields("status", &mask));
+    TEST_ASSERT_TRUE(mask == DASHBOARD_STATUS_FIELDS);
+}
+
+void test_dashboard_parse_fields_errors(void)
+{
+    uint32_t mask;
+    TEST_ASSERT_EQUAL_INT(-1, dashboard_parse_fields("address,humidity", &mask));
+    TEST_ASSERT_EQUAL_INT(-1, dashboard_parse_fields("", &mask));
+    TEST_ASSERT_EQUAL_INT(-1, dashboard_parse_fields(",,", &mask));
+    TEST_ASSERT_EQUAL_INT(-1, dashboard_parse_fields("addr", &mask));
+    /* Empty items are skipped */
+    TEST_ASSERT_EQUAL_INT(0, dashboard_parse_fields(",address,", &mask));
+}
+
+/* ===== Projection Tests ===== */
+
+void test_dashboard_sensor_all_fields(void)
+{
+    TEST_ASSERT_EQUAL_STRING("{\"address\":\"28FF1234567890AB\",\"temperature\":22.5,\"valid\":true,"
+                             "\"friendly_name\":null,\"total_reads\":100,\"failed_reads\":2}",
+                             write_sensor(DASHBOARD_ALL_FIELDS));
+}
+
+void test_dashboard_sensor_projection(void)
+{
+    TEST_ASSERT_EQUAL_STRING("{\"address\":\"28FF1234567890AB\",\"temperature\":22.5}",
+                             write_sensor(DASHBOARD_F_ADDRESS | DASHBOARD_F_TEMPERATURE));
+    /* Status-only masks leave sensors empty */
+    TEST_ASSERT_EQUAL_STRING("{}", write_sensor(DASHBOARD_F_VERSION));
+}
+
+void test_dashboard_status_all_fields(void)
+{
+    dashboard_status_t st;
+    make_status(&st);
+    json_writer_t w;
+    json_writer_init(&w, s_buf, sizeof(s_buf), NULL, NULL);
+    dashboard_write_status(&w, &st, DASHBOARD_ALL_FIELDS);
+    TEST_ASSERT_GREATER_THAN(0, json_writer_finish(&w));
+    TEST_ASSERT_EQUAL_STRING("{\"version\":\"2.7.0\",\"sensor_count\":1,\"max_sensors\":20,"
+                             "\"uptime_seconds\":3600,\"free_heap\":123456,\"mqtt_connected\":true,"
+                             "\"ethernet_connected\":true,\"wifi_connected\":false,"
+                             "\"ethernet_ip\":\"192.168.1.50\",\"wifi_ip\":\"\","
+                             "\"bus_stats\":{\"total_reads\":200,\"failed_reads\":1,\"error_rate\":0.5},"
+                             "\"mqtt_buffer\":{\"depth\":0,\"flash_depth\":0,\"captured\":0,"
+                             "\"dropped\":0,\"replayed\":0,\"replay_rate\":0},"
+                             "\"rate_limit\":{\"rejected\":{\"read\":0,\"write\":0,\"scan\":4},"
+                             "\"rescans_coalesced\":2}}",
+                             s_buf);
+}
+
+void test_dashboard_status_projection(void)
+{
+    dashboard_status_t st;
+    make_status(&st);
+    json_writer_t w;
+    json_writer_init(&w, s_buf, sizeof(s_buf), NULL, NULL);
+    dashboard_write_status(&w, &st, DASHBOARD_F_VERSION | DASHBOARD_F_BUS_STATS | DASHBOARD_F_ADDRESS);
+    TEST_ASSERT_GREATER_THAN(0, json_writer_finish(&w));
+    TEST_ASSERT_EQUAL_STRING("{\"version\":\"2.7.0\","
+                             "\"bus_stats\":{\"total_reads\":200,\"failed_reads\":1,\"error_rate\":0.5}}",
+                             s_buf);
+}
+
+/* ===== Test Runner ===== */
+
+void run_dashboard_tests(void)
+{
+    RUN_TEST(test_dashboard_parse_fields);
+    RUN_TEST(test_dashboard_parse_fields_encoded_comma);
+    RUN_TEST(test_dashboard_parse_fields_groups);
+    RUN_TEST(test_dashboard_parse_fields_errors);
+    RUN_TEST(test_dashboard_sensor_all_fields);
+    RUN_TEST(test_dashboard_sensor_projection);
+    RUN_TEST(test_dashboard_status_all_fields);
+    RUN_TEST(test_dashboard_status_projection);
+}
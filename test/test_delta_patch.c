@@ -0,0 +1,325 @@
+/**
+ * @file test_delta_patch.c
+ * @brief Unit tests for the delta OTA patch applier
+ *
+ * Most patches are assembled here, with hashes from mbedtls_sha256(); one comes
+ * from scripts/make_delta.py to keep the script and the applier in step.
+ */
+
+#include "unity.h"
+#include "delta_patch.h"
+#include "gunzip.h"
+#include <stdio.h>
+#include <string.h>
+
+/*
+ * make_delta.py for the OLD/NEW pair built by make_images():
+ * two approximate matches, the second one seeking back into OLD.
+ */
+static const uint8_t DELTA_GZ[153] = {
+    0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x0b, 0x89,
+    0x70, 0x31, 0x74, 0x60, 0x62, 0x60, 0x78, 0xcb, 0xc8, 0x00, 0x06, 0x3c,
+    0x7a, 0xec, 0xd3, 0xce, 0x64, 0xbe, 0xf9, 0xbb, 0x54, 0x74, 0xf3, 0xa9,
+    0xad, 0xcc, 0x17, 0xcf, 0x70, 0x65, 0x5c, 0xb7, 0x5b, 0xf7, 0x59, 0xe6,
+    0xdc, 0x84, 0x25, 0x97, 0x3d, 0x3c, 0xa7, 0xfb, 0x6f, 0xfc, 0x11, 0xf6,
+    0x9d, 0xe9, 0xe0, 0xa2, 0x62, 0x1d, 0xd7, 0x25, 0xdc, 0x0e, 0x42, 0x67,
+    0x72, 0x3c, 0xee, 0x1a, 0xca, 0x36, 0xdc, 0x5d, 0xbd, 0xf9, 0xaf, 0x71,
+    0x48, 0x4e, 0xf9, 0x87, 0xe4, 0xb0, 0x8b, 0x0c, 0x48, 0x40, 0x07, 0x6a,
+    0x66, 0xc9, 0xff, 0xff, 0xff, 0x19, 0xe8, 0x00, 0x1e, 0x9e, 0x37, 0x11,
+    0x16, 0x51, 0xbd, 0xb4, 0x87, 0x61, 0x88, 0x83, 0x0d, 0x40, 0x2c, 0x88,
+    0x5d, 0x8a, 0x91, 0x61, 0x90, 0x8b, 0x2b, 0x94, 0x24, 0x66, 0xe6, 0x28,
+    0x24, 0xa6, 0xa4, 0xa4, 0xa6, 0x28, 0x64, 0xe6, 0x29, 0x94, 0x19, 0x01,
+    0x00, 0xbf, 0xd0, 0x92, 0x1f, 0x61, 0x02, 0x00, 0x00,
+};
+
+static uint8_t s_old[1024];
+static size_t s_old_len;
+static uint8_t s_new[1024];
+static size_t s_new_len;
+
+static uint8_t s_patch[2048];
+static size_t s_patch_len;
+
+static uint8_t s_out[1024];
+static size_t s_out_len;
+static int s_fail_write;
+static delta_patch_t s_delta;
+
+/**
+ * @brief OLD: 24 fake readings. NEW: an edit, a dropped range, a new tail.
+ */
+static void make_images(void)
+{
+    s_old_len = 0;
+    for (int i = 0; i < 24; i++) {
+        s_old_len += sprintf((char *)s_old + s_old_len, "sensor %02d reads %d.%d C; ", i, 20 + i % 5, i % 10);
+    }
+    s_new_len = 0;
+    memcpy(s_new, s_old, 100);
+    memcpy(s_new + 100, "PATCHED!", 8);
+    memcpy(s_new + 108, s_old + 108, 300 - 108);
+    memcpy(s_new + 300, s_old + 400, s_old_len - 400);
+    s_new_len = 300 + s_old_len - 400;
+    memcpy(s_new + s_new_len, " tail added in v2", 17);
+    s_new_len += 17;
+}
+
+static void put_le32(uint8_t *p, uint32_t v)
+{
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static void patch_header(void)
+{
+    memcpy(s_patch, DELTA_MAGIC, 4);
+    put_le32(s_patch + 4, (uint32_t)s_old_len);
+    put_le32(s_patch + 8, (uint32_t)s_new_len);
+    put_le32(s_patch + 12, 0);
+    mbedtls_sha256(s_old, s_old_len, s_patch + 16, 0);
+    mbedtls_sha256(s_new, s_new_len, s_patch + 48, 0);
+    s_patch_len = DELTA_HEADER_SIZE;
+}
+
+/**
+ * @brief Append a record: new[new_pos..] from old[old_pos..] (diff), then literals
+ */
+static void patch_record(uint32_t old_pos, uint32_t new_pos, uint32_t diff_len,
+                         uint32_t extra_len, int32_t seek)
+{
+    uint8_t *p = s_patch + s_patch_len;
+    put_le32(p, diff_len);
+    put_le32(p + 4, extra_len);
+    put_le32(p + 8, (uint32_t)seek);
+    p += DELTA_RECORD_SIZE;
+    for (uint32_t i = 0; i < diff_len; i++) {
+        *p++ = (uint8_t)(s_new[new_pos + i] - s_old[old_pos + i]);
+    }
+    memcpy(p, s_new + new_pos + diff_len, extra_len);
+    s_patch_len += DELTA_RECORD_SIZE + diff_len + extra_len;
+}
+
+/**
+ * @brief Hand-made patch for NEW: diff 0..300, seek to old 400, diff the rest, tail literal
+ */
+static void make_patch(void)
+{
+    make_images();
+    patch_header();
+    patch_record(0, 0, 300, 0, 100);
+    patch_record(400, 300, (uint32_t)(s_old_len - 400), 17, 0);
+}
+
+static int mem_read_source(void *ctx, uint32_t offset, void *buf, size_t len)
+{
+    (void)ctx;
+    if (offset + len > s_old_len) {
+        return -1;
+    }
+    memcpy(buf, s_old + offset, len);
+    return 0;
+}
+
+static int mem_write(void *ctx, const void *data, size_t len)
+{
+    (void)ctx;
+    if (s_fail_write || s_out_len + len > sizeof(s_out)) {
+        return -1;
+    }
+    memcpy(s_out + s_out_len, data, len);
+    s_out_len += len;
+    return 0;
+}
+
+static void delta_reset(void)
+{
+    s_out_len = 0;
+    s_fail_write = 0;
+    const delta_io_t io = { mem_read_source, mem_write, NULL };
+    delta_patch_init(&s_delta, &io);
+}
+
+/* ===== Apply Tests ===== */
+
+void test_delta_apply_whole_patch(void)
+{
+    make_patch();
+    delta_reset();
+    TEST_ASSERT_EQUAL_INT(DELTA_OK, delta_patch_feed(&s_delta, s_patch, s_patch_len));
+    TEST_ASSERT_EQUAL_INT(DELTA_OK, delta_patch_finish(&s_delta));
+    TEST_ASSERT_EQUAL_INT(s_new_len, s_out_len);
+    TEST_ASSERT_TRUE(memcmp(s_out, s_new, s_new_len) == 0);
+    TEST_ASSERT_EQUAL_INT(s_old_len, s_delta.header.source_size);
+}
+
+void test_delta_apply_byte_at_a_time(void)
+{
+    make_patch();
+    delta_reset();
+    for (size_t i = 0; i < s_patch_len; i++) {
+        TEST_ASSERT_EQUAL_INT(DELTA_OK, delta_patch_feed(&s_delta, s_patch + i, 1));
+        if (i < DELTA_HEADER_SIZE - 1) {
+            TEST_ASSERT_FALSE(delta_patch_has_header(&s_delta));
+        }
+    }
+    TEST_ASSERT_TRUE(delta_patch_has_header(&s_delta));
+    TEST_ASSERT_EQUAL_INT(DELTA_OK, delta_patch_finish(&s_delta));
+    TEST_ASSERT_TRUE(memcmp(s_out, s_new, s_new_len) == 0);
+}
+
+/* make_delta.py output, inflated and applied in one pass */
+typedef struct {
+    const uint8_t *src;
+    size_t len;
+    size_t pos;
+} gz_source_t;
+
+static int gz_read(void *ctx, uint8_t *buf, size_t len)
+{
+    gz_source_t *s = ctx;
+    size_t n = s->len - s->pos < len ? s->len - s->pos : len;
+    memcpy(buf, s->src + s->pos, n);
+    s->pos += n;
+    return (int)n;
+}
+
+static int gz_write(void *ctx, const uint8_t *data, size_t len)
+{
+    (void)ctx;
+    return delta_patch_feed(&s_delta, data, len) == DELTA_OK ? 0 : -1;
+}
+
+void test_delta_apply_script_patch(void)
+{
+    static gunzip_t gz;
+    gz_source_t src = { DELTA_GZ, sizeof(DELTA_GZ), 0 };
+    const gunzip_io_t io = { .read = gz_read, .write = gz_write, .ctx = &src };
+
+    make_images();
+    delta_reset();
+    gunzip_init(&gz, &io);
+    TEST_ASSERT_EQUAL_INT(GUNZIP_OK, gunzip_run(&gz));
+    TEST_ASSERT_EQUAL_INT(DELTA_OK, delta_patch_finish(&s_delta));
+    TEST_ASSERT_EQUAL_INT(s_new_len, s_out_len);
+    TEST_ASSERT_TRUE(memcmp(s_out, s_new, s_new_len) == 0);
+}
+
+/* Source and target as files, the way a patch would be tried out on a PC */
+static int file_read_source(void *ctx, uint32_t offset, void *buf, size_t len)
+{
+    FILE *f = ctx;
+    if (fseek(f, (long)offset, SEEK_SET) != 0 || fread(buf, 1, len, f) != len) {
+        return -1;
+    }
+    return 0;
+}
+
+static int file_write(void *ctx, const void *data, size_t len)
+{
+    (void)ctx;
+    return mem_write(NULL, data, len);
+}
+
+void test_delta_apply_from_file(void)
+{
+    make_patch();
+    FILE *old_file = tmpfile();
+    TEST_ASSERT_NOT_NULL(old_file);
+    fwrite(s_old, 1, s_old_len, old_file);
+
+    s_out_len = 0;
+    s_fail_write = 0;
+    const delta_io_t io = { file_read_source, file_write, old_file };
+    delta_patch_init(&s_delta, &io);
+    TEST_ASSERT_EQUAL_INT(DELTA_OK, delta_patch_feed(&s_delta, s_patch, s_patch_len));
+    TEST_ASSERT_EQUAL_INT(DELTA_OK, delta_patch_finish(&s_delta));
+    TEST_ASSERT_TRUE(memcmp(s_out, s_new, s_new_len) == 0);
+    fclose(old_file);
+}
+
+/* ===== Verification Tests ===== */
+
+void test_delta_rejects_other_source(void)
+{
+    make_patch();
+    s_old[5] ^= 0x20;   /* Running image differs from the patch base */
+    delta_reset();
+    TEST_ASSERT_EQUAL_INT(DELTA_ERR_SOURCE, delta_patch_feed(&s_delta, s_patch, s_patch_len));
+    TEST_ASSERT_EQUAL_INT(0, s_out_len);
+    TEST_ASSERT_EQUAL_INT(DELTA_ERR_SOURCE, delta_patch_finish(&s_delta));
+}
+
+void test_delta_detects_bad_result(void)
+{
+    make_patch();
+    s_patch[DELTA_HEADER_SIZE + DELTA_RECORD_SIZE + 10] ^= 0x01;   /* A diff byte */
+    delta_reset();
+    TEST_ASSERT_EQUAL_INT(DELTA_OK, delta_patch_feed(&s_delta, s_patch, s_patch_len));
+    TEST_ASSERT_EQUAL_INT(DELTA_ERR_HASH, delta_patch_finish(&s_delta));
+}
+
+void test_delta_detects_truncation(void)
+{
+    make_patch();
+    delta_reset();
+    TEST_ASSERT_EQUAL_INT(DELTA_OK, delta_patch_feed(&s_delta, s_patch, s_patch_len - 5));
+    TEST_ASSERT_EQUAL_INT(DELTA_ERR_TRUNCATED, delta_patch_finish(&s_delta));
+}
+
+void test_delta_rejects_bad_records(void)
+{
+    /* Diff reaching past the end of the source */
+    make_images();
+    patch_header();
+    patch_record(0, 0, 300, 0, (int32_t)s_old_len);
+    patch_record(0, 300, 10, 0, 0);
+    delta_reset();
+    TEST_ASSERT_EQUAL_INT(DELTA_ERR_DATA, delta_patch_feed(&s_delta, s_patch, s_patch_len));
+
+    /* Seek before the start */
+    make_images();
+    patch_header();
+    patch_record(0, 0, 300, 0, -301);
+    delta_reset();
+    TEST_ASSERT_EQUAL_INT(DELTA_ERR_DATA, delta_patch_feed(&s_delta, s_patch, s_patch_len));
+
+    /* Data after the target is complete */
+    make_patch();
+    s_patch[s_patch_len++] = 0;
+    delta_reset();
+    TEST_ASSERT_EQUAL_INT(DELTA_ERR_DATA, delta_patch_feed(&s_delta, s_patch, s_patch_len));
+}
+
+void test_delta_rejects_bad_header(void)
+{
+    make_patch();
+    s_patch[0] = 'X';
+    delta_reset();
+    TEST_ASSERT_EQUAL_INT(DELTA_ERR_HEADER, delta_patch_feed(&s_delta, s_patch, s_patch_len));
+}
+
+void test_delta_propagates_write_error(void)
+{
+    make_patch();
+    delta_reset();
+    s_fail_write = 1;
+    TEST_ASSERT_EQUAL_INT(DELTA_ERR_IO, delta_patch_feed(&s_delta, s_patch, s_patch_len));
+}
+
+/* ===== Test Runner ===== */
+
+void run_delta_patch_tests(void)
+{
+    RUN_TEST(test_delta_apply_whole_patch);
+    RUN_TEST(test_delta_apply_byte_at_a_time);
+    RUN_TEST(test_delta_apply_script_patch);
+    RUN_TEST(test_delta_apply_from_file);
+    RUN_TEST(test_delta_rejects_other_source);
+    RUN_TEST(test_delta_detects_bad_result);
+    RUN_TEST(test_delta_detects_truncation);
+    RUN_TEST(test_delta_rejects_bad_records);
+    RUN_TEST(test_delta_rejects_bad_header);
+    RUN_TEST(test_delta_propagates_write_error);
+}
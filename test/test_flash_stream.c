@@ -0,0 +1,193 @@
+/**
+ * @file test_flash_stream.c
+ * @brief Unit tests for the sequential flash writer and erase-ahead
+ */
+
+#include "unity.h"
+#include "flash_stream.h"
+#include <string.h>
+
+#define FAKE_SECTOR 16
+#define FAKE_SECTORS 8
+#define FAKE_SIZE (FAKE_SECTOR * FAKE_SECTORS)
+
+typedef struct {
+    uint8_t data[FAKE_SIZE];
+    int erase_count[FAKE_SECTORS];
+    int erase_calls;
+    int write_errors;       /* Writes to bytes that were not erased */
+    int fail_erase;
+} fake_flash_t;
+
+static fake_flash_t s_flash;
+static flash_stream_t s_fs;
+
+static int fake_erase(void *ctx, uint32_t offset, uint32_t len)
+{
+    fake_flash_t *f = ctx;
+    if (f->fail_erase) {
+        return -1;
+    }
+    if (offset % FAKE_SECTOR != 0 || len % FAKE_SECTOR != 0 || offset + len > FAKE_SIZE) {
+        return -1;  /* Misaligned erases fail the write under test */
+    }
+    memset(f->data + offset, 0xFF, len);
+    for (uint32_t s = offset / FAKE_SECTOR; s < (offset + len) / FAKE_SECTOR; s++) {
+        f->erase_count[s]++;
+    }
+    f->erase_calls++;
+    return 0;
+}
+
+static int fake_write(void *ctx, uint32_t offset, const void *data, size_t len)
+{
+    fake_flash_t *f = ctx;
+    for (size_t i = 0; i < len; i++) {
+        if (f->data[offset + i] != 0xFF) {
+            f->write_errors++;
+        }
+    }
+    memcpy(f->data + offset, data, len);
+    return 0;
+}
+
+static void stream_reset(uint32_t expected)
+{
+    memset(&s_flash, 0, sizeof(s_flash));
+    const flash_stream_ops_t ops = { fake_erase, fake_write, &s_flash };
+    flash_stream_init(&s_fs, &ops, FAKE_SECTOR, FAKE_SIZE, expected);
+}
+
+static void write_pattern(uint32_t start, size_t len)
+{
+    uint8_t buf[FAKE_SIZE];
+    for (size_t i = 0; i < len; i++) {
+        buf[i] = (uint8_t)(start + i);
+    }
+    TEST_ASSERT_EQUAL_INT(0, flash_stream_write(&s_fs, buf, len));
+}
+
+/* ===== Write Tests ===== */
+
+void test_flash_stream_erases_on_demand(void)
+{
+    stream_reset(0);
+    write_pattern(0, 10);
+    TEST_ASSERT_EQUAL_INT(1, s_flash.erase_count[0]);
+    TEST_ASSERT_EQUAL_INT(0, s_flash.erase_count[1]);
+
+    /* Crosses into sectors 1 and 2 */
+    write_pattern(10, 30);
+    TEST_ASSERT_EQUAL_INT(1, s_flash.erase_count[0]);
+    TEST_ASSERT_EQUAL_INT(1, s_flash.erase_count[1]);
+    TEST_ASSERT_EQUAL_INT(1, s_flash.erase_count[2]);
+    TEST_ASSERT_EQUAL_INT(0, s_flash.write_errors);
+    TEST_ASSERT_EQUAL_INT(40, s_fs.written);
+    TEST_ASSERT_EQUAL_INT(39, s_flash.data[39]);
+}
+
+void test_flash_stream_rejects_overflow(void)
+{
+    stream_reset(0);
+    write_pattern(0, FAKE_SIZE - 4);
+    uint8_t extra[8] = {0};
+    TEST_ASSERT_EQUAL_INT(-1, flash_stream_write(&s_fs, extra, sizeof(extra)));
+    TEST_ASSERT_EQUAL_INT(0, flash_stream_write(&s_fs, extra, 4));
+    TEST_ASSERT_EQUAL_INT(FAKE_SIZE, s_fs.written);
+}
+
+void test_flash_stream_erase_error(void)
+{
+    stream_reset(0);
+    s_flash.fail_erase = 1;
+    uint8_t data[4] = {0};
+    TEST_ASSERT_EQUAL_INT(-1, flash_stream_write(&s_fs, data, sizeof(data)));
+    TEST_ASSERT_EQUAL_INT(0, s_fs.written);
+}
+
+/* ===== Erase-Ahead Tests ===== */
+
+void test_flash_stream_erase_ahead_stops_at_image(void)
+{
+    stream_reset(3 * FAKE_SECTOR + 5);  /* Needs 4 sectors */
+    TEST_ASSERT_EQUAL_INT(3, flash_stream_erase_ahead(&s_fs, 3));
+    TEST_ASSERT_EQUAL_INT(1, flash_stream_erase_ahead(&s_fs, 3));
+    TEST_ASSERT_EQUAL_INT(0, flash_stream_erase_ahead(&s_fs, 3));
+    TEST_ASSERT_EQUAL_INT(4 * FAKE_SECTOR, s_fs.erased_ahead);
+    TEST_ASSERT_EQUAL_INT(0, s_flash.erase_count[4]);
+}
+
+void test_flash_stream_no_double_erase(void)
+{
+    stream_reset(FAKE_SIZE);
+    flash_stream_erase_ahead(&s_fs, 2);
+    write_pattern(0, 40);           /* Sector 2 erased on demand */
+    flash_stream_erase_ahead(&s_fs, 1);
+    write_pattern(40, 30);
+    for (int s = 0; s < 5; s++) {
+        TEST_ASSERT_EQUAL_INT(1, s_flash.erase_count[s]);
+    }
+    TEST_ASSERT_EQUAL_INT(0, s_flash.erase_count[5]);
+    TEST_ASSERT_EQUAL_INT(0, s_flash.write_errors);
+    TEST_ASSERT_EQUAL_INT(3 * FAKE_SECTOR, s_fs.erased_ahead);
+}
+
+void test_flash_stream_unknown_size_no_erase_ahead(void)
+{
+    stream_reset(0);
+    TEST_ASSERT_EQUAL_INT(0, flash_stream_erase_ahead(&s_fs, 4));
+    TEST_ASSERT_EQUAL_INT(0, s_flash.erase_calls);
+}
+
+void test_flash_stream_expected_clamped_to_region(void)
+{
+    stream_reset(FAKE_SIZE * 2);
+    TEST_ASSERT_EQUAL_INT(FAKE_SECTORS, flash_stream_erase_ahead(&s_fs, 100));
+    TEST_ASSERT_EQUAL_INT(0, flash_stream_erase_ahead(&s_fs, 100));
+}
+
+/* ===== Resume Tests ===== */
+
+void test_flash_stream_resume_keeps_written_sectors(void)
+{
+    stream_reset(FAKE_SIZE);
+    write_pattern(0, 2 * FAKE_SECTOR + 5);
+
+    /* Restart at the last whole sector, as after a reboot */
+    const flash_stream_ops_t ops = { fake_erase, fake_write, &s_flash };
+    flash_stream_init(&s_fs, &ops, FAKE_SECTOR, FAKE_SIZE, 4 * FAKE_SECTOR);
+    TEST_ASSERT_EQUAL_INT(0, flash_stream_resume(&s_fs, 2 * FAKE_SECTOR));
+    TEST_ASSERT_EQUAL_INT(1, flash_stream_erase_ahead(&s_fs, 1));
+    write_pattern(2 * FAKE_SECTOR, 2 * FAKE_SECTOR);
+
+    TEST_ASSERT_EQUAL_INT(1, s_flash.erase_count[0]);
+    TEST_ASSERT_EQUAL_INT(1, s_flash.erase_count[1]);
+    TEST_ASSERT_EQUAL_INT(2, s_flash.erase_count[2]);   /* Partly written before, erased again */
+    TEST_ASSERT_EQUAL_INT(0, s_flash.erase_count[4]);
+    TEST_ASSERT_EQUAL_INT(0, s_flash.write_errors);
+    TEST_ASSERT_EQUAL_INT(4 * FAKE_SECTOR, s_fs.written);
+    TEST_ASSERT_EQUAL_INT(FAKE_SECTOR + 1, s_flash.data[FAKE_SECTOR + 1]);
+}
+
+void test_flash_stream_resume_rejects_misaligned(void)
+{
+    stream_reset(0);
+    TEST_ASSERT_EQUAL_INT(-1, flash_stream_resume(&s_fs, FAKE_SECTOR + 1));
+    TEST_ASSERT_EQUAL_INT(-1, flash_stream_resume(&s_fs, FAKE_SIZE + FAKE_SECTOR));
+    TEST_ASSERT_EQUAL_INT(0, s_fs.written);
+}
+
+/* ===== Test Runner ===== */
+
+void run_flash_stream_tests(void)
+{
+    RUN_TEST(test_flash_stream_erases_on_demand);
+    RUN_TEST(test_flash_stream_rejects_overflow);
+    RUN_TEST(test_flash_stream_erase_error);
+    RUN_TEST(test_flash_stream_erase_ahead_stops_at_image);
+    RUN_TEST(test_flash_stream_no_double_erase);
+    RUN_TEST(test_flash_stream_unknown_size_no_erase_ahead);
+    RUN_TEST(test_flash_stream_expected_clamped_to_region);
+    RUN_TEST(test_flash_stream_resume_keeps_written_sectors);
+    RUN_TEST(test_flash_stream_resume_rejects_misaligned);
+}
@@ -0,0 +1,303 @@
+/**
+ * @file test_gunzip.c
+ * @brief Unit tests for the streaming gzip decoder
+ *
+ * Vectors were made with Python's zlib at wbits 16+12 (the firmware
+ * setting) unless noted.
+ */
+
+#include "unity.h"
+#include "gunzip.h"
+#include <string.h>
+
+/* "hello hello hello\n" - fixed Huffman block */
+static const uint8_t GZ_HELLO[29] = {
+    0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0xcb, 0x48,
+    0xcd, 0xc9, 0xc9, 0x57, 0xc8, 0x40, 0x90, 0x5c, 0x00, 0x3b, 0x7c, 0x8a,
+    0xdf, 0x12, 0x00, 0x00, 0x00,
+};
+
+/* "named" x 20 with FNAME "thermux.bin" */
+static const uint8_t GZ_NAMED[40] = {
+    0x1f, 0x8b, 0x08, 0x08, 0x00, 0x00, 0x00, 0x00, 0x02, 0xff, 0x74, 0x68,
+    0x65, 0x72, 0x6d, 0x75, 0x78, 0x2e, 0x62, 0x69, 0x6e, 0x00, 0xcb, 0x4b,
+    0xcc, 0x4d, 0x4d, 0xc9, 0xa3, 0x2d, 0x01, 0x00, 0x4e, 0xa4, 0xfe, 0xcf,
+    0x64, 0x00, 0x00, 0x00,
+};
+
+/* "abc" x 3000 - dynamic Huffman block, output spans three windows */
+static const uint8_t GZ_ABC_X3000[47] = {
+    0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0xed, 0xc2,
+    0x01, 0x0d, 0x00, 0x00, 0x0c, 0x02, 0xa0, 0xac, 0x6a, 0xff, 0x0e, 0xef,
+    0xf1, 0xc1, 0x48, 0x17, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55,
+    0xfd, 0xfe, 0x00, 0x25, 0xae, 0xa6, 0xe2, 0x28, 0x23, 0x00, 0x00,
+};
+
+/* 32 bytes, 5000 zeros, the same 32 bytes: wbits 16+15, matches 5032 back */
+static const uint8_t GZ_FAR_MATCH[80] = {
+    0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0xed, 0xd8,
+    0xdb, 0x01, 0x40, 0x20, 0x00, 0x40, 0x51, 0xab, 0x45, 0x21, 0x22, 0x45,
+    0x42, 0x79, 0xec, 0x3f, 0x85, 0x11, 0x7c, 0xf9, 0xbb, 0x67, 0x8c, 0x23,
+    0xca, 0x4a, 0xaa, 0xba, 0x69, 0x75, 0xd7, 0x9b, 0x61, 0xb4, 0x93, 0xf3,
+    0xf3, 0x12, 0xd6, 0xb8, 0xed, 0x47, 0xca, 0xe7, 0x75, 0x3f, 0x05, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x80, 0xdf, 0x89, 0x8f, 0xa7, 0x7b, 0x01,
+    0x71, 0xb1, 0xed, 0x25, 0xc8, 0x13, 0x00, 0x00,
+};
+
+/* "hello" in a stored block, built by hand */
+static const uint8_t GZ_STORED[28] = {
+    0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff,
+    0x01, 0x05, 0x00, 0xfa, 0xff, 'h', 'e', 'l', 'l', 'o',
+    0x86, 0xa6, 0x10, 0x36, 0x05, 0x00, 0x00, 0x00,
+};
+
+/* "abc" x 3000 with a full flush after 5000 bytes: the flush point ends at byte 40 */
+static const uint8_t GZ_FLUSHED[72] = {
+    0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0xec, 0xc2,
+    0x41, 0x11, 0x00, 0x00, 0x0c, 0x02, 0xa0, 0xac, 0x6a, 0xff, 0x0e, 0x4b,
+    0xb1, 0x1f, 0x1c, 0xe9, 0xa2, 0xaa, 0xaa, 0xaa, 0xaa, 0xfe, 0x3e, 0x00,
+    0x00, 0x00, 0xff, 0xff, 0xed, 0xc2, 0x41, 0x11, 0x00, 0x00, 0x0c, 0x02,
+    0xa0, 0xac, 0x6a, 0xff, 0x0e, 0x8b, 0xb1, 0x0f, 0x1c, 0x4b, 0xa7, 0xaa,
+    0xaa, 0xaa, 0xfe, 0x3e, 0x25, 0xae, 0xa6, 0xe2, 0x28, 0x23, 0x00, 0x00,
+};
+#define GZ_FLUSHED_SYNC_IN 40
+#define GZ_FLUSHED_SYNC_OUT 5000
+#define GZ_FLUSHED_SYNC_CRC 0x8d3d47bbu
+
+/* The same stream after a sync flush instead, from byte 40: refers back past the flush */
+static const uint8_t GZ_SYNC_TAIL[28] = {
+    0xed, 0xc2, 0x31, 0x0d, 0x00, 0x00, 0x00, 0x80, 0xa0, 0xfe, 0xad, 0x8d,
+    0xe1, 0x03, 0x43, 0x55, 0x55, 0x55, 0xfd, 0x07, 0x25, 0xae, 0xa6, 0xe2,
+    0x28, 0x23, 0x00, 0x00,
+};
+
+typedef struct {
+    const uint8_t *src;
+    size_t src_len;
+    size_t src_pos;
+    size_t chunk;           /* Max bytes per read */
+    int fail_read;
+    uint8_t out[10000];
+    size_t out_len;
+    int writes;
+    int fail_write;
+    int syncs;
+    uint32_t sync_in;
+    uint32_t sync_out;
+    uint32_t sync_crc;
+} fake_io_t;
+
+static fake_io_t s_io;
+static gunzip_t s_gz;
+
+static int fake_read(void *ctx, uint8_t *buf, size_t len)
+{
+    fake_io_t *f = ctx;
+    if (f->fail_read) {
+        return -1;
+    }
+    size_t n = f->src_len - f->src_pos;
+    if (n > len) {
+        n = len;
+    }
+    if (n > f->chunk) {
+        n = f->chunk;
+    }
+    memcpy(buf, f->src + f->src_pos, n);
+    f->src_pos += n;
+    return (int)n;
+}
+
+static int fake_write(void *ctx, const uint8_t *data, size_t len)
+{
+    fake_io_t *f = ctx;
+    if (f->fail_write || f->out_len + len > sizeof(f->out)) {
+        return -1;
+    }
+    memcpy(f->out + f->out_len, data, len);
+    f->out_len += len;
+    f->writes++;
+    return 0;
+}
+
+static void fake_sync(void *ctx, uint32_t in_offset, uint32_t out_offset, uint32_t crc)
+{
+    fake_io_t *f = ctx;
+    f->syncs++;
+    f->sync_in = in_offset;
+    f->sync_out = out_offset;
+    f->sync_crc = crc;
+}
+
+static const gunzip_io_t s_fake = {
+    .read = fake_read,
+    .write = fake_write,
+    .sync = fake_sync,
+    .ctx = &s_io,
+};
+
+static void source_reset(const uint8_t *src, size_t len, size_t chunk)
+{
+    memset(&s_io, 0, sizeof(s_io));
+    s_io.src = src;
+    s_io.src_len = len;
+    s_io.chunk = chunk;
+    gunzip_init(&s_gz, &s_fake);
+}
+
+static int inflate(const uint8_t *src, size_t len, size_t chunk)
+{
+    source_reset(src, len, chunk);
+    return gunzip_run(&s_gz);
+}
+
+static int is_abc(const uint8_t *p, size_t len, size_t start)
+{
+    for (size_t i = 0; i < len; i++) {
+        if (p[i] != "abc"[(start + i) % 3]) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* ===== Decode Tests ===== */
+
+void test_gunzip_fixed_block(void)
+{
+    TEST_ASSERT_EQUAL_INT(GUNZIP_OK, inflate(GZ_HELLO, sizeof(GZ_HELLO), 512));
+    TEST_ASSERT_EQUAL_INT(18, s_io.out_len);
+    TEST_ASSERT_TRUE(memcmp(s_io.out, "hello hello hello\n", 18) == 0);
+    TEST_ASSERT_EQUAL_INT(sizeof(GZ_HELLO), s_gz.in_total);
+}
+
+void test_gunzip_stored_block(void)
+{
+    TEST_ASSERT_EQUAL_INT(GUNZIP_OK, inflate(GZ_STORED, sizeof(GZ_STORED), 512));
+    TEST_ASSERT_EQUAL_INT(5, s_io.out_len);
+    TEST_ASSERT_TRUE(memcmp(s_io.out, "hello", 5) == 0);
+}
+
+void test_gunzip_dynamic_block_across_windows(void)
+{
+    TEST_ASSERT_EQUAL_INT(GUNZIP_OK, inflate(GZ_ABC_X3000, sizeof(GZ_ABC_X3000), 512));
+    TEST_ASSERT_EQUAL_INT(9000, s_io.out_len);
+    TEST_ASSERT_TRUE(is_abc(s_io.out, 9000, 0));
+    /* Two full windows, then the remainder */
+    TEST_ASSERT_EQUAL_INT(3, s_io.writes);
+}
+
+void test_gunzip_skips_file_name(void)
+{
+    TEST_ASSERT_EQUAL_INT(GUNZIP_OK, inflate(GZ_NAMED, sizeof(GZ_NAMED), 512));
+    TEST_ASSERT_EQUAL_INT(100, s_io.out_len);
+    TEST_ASSERT_TRUE(memcmp(s_io.out, "namednamed", 10) == 0);
+}
+
+void test_gunzip_one_byte_reads(void)
+{
+    TEST_ASSERT_EQUAL_INT(GUNZIP_OK, inflate(GZ_ABC_X3000, sizeof(GZ_ABC_X3000), 1));
+    TEST_ASSERT_EQUAL_INT(9000, s_io.out_len);
+    TEST_ASSERT_TRUE(memcmp(s_io.out + 8997, "abc", 3) == 0);
+}
+
+/* ===== Resume Tests ===== */
+
+void test_gunzip_reports_flush_point(void)
+{
+    TEST_ASSERT_EQUAL_INT(GUNZIP_OK, inflate(GZ_FLUSHED, sizeof(GZ_FLUSHED), 16));
+    TEST_ASSERT_EQUAL_INT(1, s_io.syncs);
+    TEST_ASSERT_EQUAL_INT(GZ_FLUSHED_SYNC_IN, s_io.sync_in);
+    TEST_ASSERT_EQUAL_INT(GZ_FLUSHED_SYNC_OUT, s_io.sync_out);
+    TEST_ASSERT_TRUE(s_io.sync_crc == GZ_FLUSHED_SYNC_CRC);
+    /* Window, flush point (mid-window), window, remainder */
+    TEST_ASSERT_EQUAL_INT(4, s_io.writes);
+    TEST_ASSERT_EQUAL_INT(9000, s_io.out_len);
+    TEST_ASSERT_TRUE(is_abc(s_io.out, 9000, 0));
+}
+
+void test_gunzip_resumes_at_flush_point(void)
+{
+    source_reset(GZ_FLUSHED + GZ_FLUSHED_SYNC_IN, sizeof(GZ_FLUSHED) - GZ_FLUSHED_SYNC_IN, 512);
+    gunzip_resume(&s_gz, GZ_FLUSHED_SYNC_IN, GZ_FLUSHED_SYNC_OUT, GZ_FLUSHED_SYNC_CRC);
+    /* Trailer CRC and length cover the whole image */
+    TEST_ASSERT_EQUAL_INT(GUNZIP_OK, gunzip_run(&s_gz));
+    TEST_ASSERT_EQUAL_INT(9000 - GZ_FLUSHED_SYNC_OUT, s_io.out_len);
+    TEST_ASSERT_TRUE(is_abc(s_io.out, s_io.out_len, GZ_FLUSHED_SYNC_OUT));
+    TEST_ASSERT_EQUAL_INT(sizeof(GZ_FLUSHED), s_gz.in_total);
+}
+
+void test_gunzip_resume_rejects_reference_before_point(void)
+{
+    source_reset(GZ_SYNC_TAIL, sizeof(GZ_SYNC_TAIL), 512);
+    gunzip_resume(&s_gz, GZ_FLUSHED_SYNC_IN, GZ_FLUSHED_SYNC_OUT, GZ_FLUSHED_SYNC_CRC);
+    TEST_ASSERT_EQUAL_INT(GUNZIP_ERR_DATA, gunzip_run(&s_gz));
+}
+
+void test_gunzip_resume_detects_wrong_crc(void)
+{
+    source_reset(GZ_FLUSHED + GZ_FLUSHED_SYNC_IN, sizeof(GZ_FLUSHED) - GZ_FLUSHED_SYNC_IN, 512);
+    gunzip_resume(&s_gz, GZ_FLUSHED_SYNC_IN, GZ_FLUSHED_SYNC_OUT, GZ_FLUSHED_SYNC_CRC ^ 1);
+    TEST_ASSERT_EQUAL_INT(GUNZIP_ERR_CHECK, gunzip_run(&s_gz));
+}
+
+/* ===== Error Tests ===== */
+
+void test_gunzip_rejects_far_match(void)
+{
+    TEST_ASSERT_EQUAL_INT(GUNZIP_ERR_WINDOW, inflate(GZ_FAR_MATCH, sizeof(GZ_FAR_MATCH), 512));
+}
+
+void test_gunzip_rejects_raw_image(void)
+{
+    static const uint8_t image[16] = { 0xE9, 0x06, 0x02, 0x20 };
+    TEST_ASSERT_EQUAL_INT(GUNZIP_ERR_HEADER, inflate(image, sizeof(image), 512));
+    TEST_ASSERT_FALSE(gunzip_is_gzip(image, sizeof(image)));
+    TEST_ASSERT_TRUE(gunzip_is_gzip(GZ_HELLO, sizeof(GZ_HELLO)));
+}
+
+void test_gunzip_detects_bad_crc(void)
+{
+    uint8_t bad[sizeof(GZ_HELLO)];
+    memcpy(bad, GZ_HELLO, sizeof(bad));
+    bad[sizeof(bad) - 8] ^= 0x01;
+    TEST_ASSERT_EQUAL_INT(GUNZIP_ERR_CHECK, inflate(bad, sizeof(bad), 512));
+}
+
+void test_gunzip_detects_truncation(void)
+{
+    TEST_ASSERT_EQUAL_INT(GUNZIP_ERR_TRUNCATED, inflate(GZ_ABC_X3000, sizeof(GZ_ABC_X3000) - 3, 512));
+    TEST_ASSERT_EQUAL_INT(GUNZIP_ERR_TRUNCATED, inflate(GZ_HELLO, 5, 512));
+}
+
+void test_gunzip_propagates_io_errors(void)
+{
+    source_reset(GZ_HELLO, sizeof(GZ_HELLO), 512);
+    s_io.fail_read = 1;
+    TEST_ASSERT_EQUAL_INT(GUNZIP_ERR_READ, gunzip_run(&s_gz));
+
+    s_io.fail_read = 0;
+    s_io.fail_write = 1;
+    gunzip_init(&s_gz, &s_fake);
+    TEST_ASSERT_EQUAL_INT(GUNZIP_ERR_WRITE, gunzip_run(&s_gz));
+}
+
+/* ===== Test Runner ===== */
+
+void run_gunzip_tests(void)
+{
+    RUN_TEST(test_gunzip_fixed_block);
+    RUN_TEST(test_gunzip_stored_block);
+    RUN_TEST(test_gunzip_dynamic_block_across_windows);
+    RUN_TEST(test_gunzip_skips_file_name);
+    RUN_TEST(test_gunzip_one_byte_reads);
+    RUN_TEST(test_gunzip_reports_flush_point);
+    RUN_TEST(test_gunzip_resumes_at_flush_point);
+    RUN_TEST(test_gunzip_resume_rejects_reference_before_point);
+    RUN_TEST(test_gunzip_resume_detects_wrong_crc);
+    RUN_TEST(test_gunzip_rejects_far_match);
+    RUN_TEST(test_gunzip_rejects_raw_image);
+    RUN_TEST(test_gunzip_detects_bad_crc);
+    RUN_TEST(test_gunzip_detects_truncation);
+    RUN_TEST(test_gunzip_propagates_io_errors);
+}
@@ -0,0 +1,188 @@
+/**
+ * @file test_ha_discovery.c
+ * @brief Unit tests for Home Assistant discovery payloads
+ */
+
+#include "unity.h"
+#include "ha_discovery.h"
+#include <stdio.h>
+#include <string.h>
+
+static const ha_node_t s_node = { "homeassistant", "thermux", "2.7.0" };
+
+static char s_buf[8192];
+
+static int render_device(const ha_sensor_t *sensors, size_t count)
+{
+    json_writer_t w;
+    json_writer_init(&w, s_buf, sizeof(s_buf), NULL, NULL);
+    ha_discovery_write_device_config(&w, &s_node, sensors, count);
+    return json_writer_finish(&w);
+}
+
+/* ===== Topic Tests ===== */
+
+void test_ha_discovery_entity_topic(void)
+{
+    char topic[64];
+    TEST_ASSERT_EQUAL_INT(52, ha_discovery_entity_topic(topic, sizeof(topic), &s_node,
+                                                        "sensor", "28FF1234567890AB"));
+    TEST_ASSERT_EQUAL_STRING("homeassistant/sensor/thermux_28FF1234567890AB/config", topic);
+}
+
+void test_ha_discovery_device_topic(void)
+{
+    char topic[64];
+    TEST_ASSERT_GREATER_THAN(0, ha_discovery_device_topic(topic, sizeof(topic), &s_node));
+    TEST_ASSERT_EQUAL_STRING("homeassistant/device/thermux/config", topic);
+}
+
+void test_ha_discovery_topic_overflow(void)
+{
+    char topic[16];
+    TEST_ASSERT_EQUAL_INT(-1, ha_discovery_device_topic(topic, sizeof(topic), &s_node));
+    TEST_ASSERT_EQUAL_INT(-1, ha_discovery_entity_topic(topic, sizeof(topic), &s_node,
+                                                        "binary_sensor", "wifi"));
+}
+
+/* ===== Per-Entity Payload Tests ===== */
+
+void test_ha_discovery_sensor_config(void)
+{
+    ha_sensor_t sensor = { "28FF1234567890AB", "Boiler" };
+    json_writer_t w;
+    json_writer_init(&w, s_buf, sizeof(s_buf), NULL, NULL);
+    ha_discovery_write_sensor_config(&w, &s_node, &sensor);
+    TEST_ASSERT_GREATER_THAN(0, json_writer_finish(&w));
+    TEST_ASSERT_EQUAL_STRING(
+        "{\"name\":\"Boiler\",\"unique_id\":\"thermux_28FF1234567890AB\","
+        "\"state_topic\":\"thermux/sensor/28FF1234567890AB/state\","
+        "\"availability_topic\":\"thermux/status\",\"device_class\":\"temperature\","
+        "\"unit_of_measurement\":\"°C\",\"state_class\":\"measurement\","
+        "\"device\":{\"name\":\"Thermux\",\"manufacturer\":\"Custom\",\"model\":\"ESP32-POE-ISO\","
+        "\"sw_version\":\"2.7.0\",\"identifiers\":[\"thermux\"]}}", s_buf);
+}
+
+void test_ha_discovery_diag_config(void)
+{
+    json_writer_t w;
+    json_writer_init(&w, s_buf, sizeof(s_buf), NULL, NULL);
+    ha_discovery_write_diag_config(&w, &s_node, &ha_diag_entities[1]);
+    TEST_ASSERT_GREATER_THAN(0, json_writer_finish(&w));
+    TEST_ASSERT_EQUAL_STRING(
+        "{\"name\":\"WiFi\",\"unique_id\":\"thermux_wifi\","
+        "\"state_topic\":\"thermux/diagnostic/wifi\","
+        "\"availability_topic\":\"thermux/status\",\"device_class\":\"connectivity\","
+        "\"entity_category\":\"diagnostic\",\"payload_on\":\"ON\",\"payload_off\":\"OFF\","
+        "\"device\":{\"name\":\"Thermux\",\"manufacturer\":\"Custom\",\"model\":\"ESP32-POE-ISO\","
+        "\"sw_version\":\"2.7.0\",\"identifiers\":[\"thermux\"]}}", s_buf);
+}
+
+/* ===== Device Payload Tests ===== */
+
+void test_ha_discovery_device_header(void)
+{
+    TEST_ASSERT_GREATER_THAN(0, render_device(NULL, 0));
+    TEST_ASSERT_NOT_NULL(strstr(s_buf,
+        "{\"dev\":{\"ids\":[\"thermux\"],\"name\":\"Thermux\",\"mf\":\"Custom\","
+        "\"mdl\":\"ESP32-POE-ISO\",\"sw\":\"2.7.0\"},"
+        "\"o\":{\"name\":\"Thermux\",\"sw\":\"2.7.0\",\"url\":\"https://github.com/sslivins/thermux\"},"
+        "\"avty_t\":\"thermux/status\",\"cmps\":{"));
+}
+
+void test_ha_discovery_device_sensor_component(void)
+{
+    ha_sensor_t sensors[] = {
+        { "28FF1234567890AB", "Boiler" },
+        { "28FF000000000001", "28FF000000000001" },
+    };
+    TEST_ASSERT_GREATER_THAN(0, render_device(sensors, 2));
+    TEST_ASSERT_NOT_NULL(strstr(s_buf,
+        "\"28FF1234567890AB\":{\"p\":\"sensor\",\"name\":\"Boiler\","
+        "\"uniq_id\":\"thermux_28FF1234567890AB\","
+        "\"stat_t\":\"thermux/sensor/28FF1234567890AB/state\","
+        "\"dev_cla\":\"temperature\",\"unit_of_meas\":\"°C\",\"stat_cla\":\"measurement\"}"));
+    TEST_ASSERT_NOT_NULL(strstr(s_buf, "\"uniq_id\":\"thermux_28FF000000000001\""));
+}
+
+void test_ha_discovery_device_diag_components(void)
+{
+    TEST_ASSERT_GREATER_THAN(0, render_device(NULL, 0));
+    TEST_ASSERT_NOT_NULL(strstr(s_buf,
+        "\"ethernet\":{\"p\":\"binary_sensor\",\"name\":\"Ethernet\","
+        "\"uniq_id\":\"thermux_ethernet\",\"stat_t\":\"thermux/diagnostic/ethernet\","
+        "\"dev_cla\":\"connectivity\",\"ent_cat\":\"diagnostic\",\"pl_on\":\"ON\",\"pl_off\":\"OFF\"}"));
+    TEST_ASSERT_NOT_NULL(strstr(s_buf,
+        "\"ip_address\":{\"p\":\"sensor\",\"name\":\"IP Address\","
+        "\"uniq_id\":\"thermux_ip_address\",\"stat_t\":\"thermux/diagnostic/ip\","
+        "\"ic\":\"mdi:ip-network\",\"ent_cat\":\"diagnostic\"}"));
+
+    /* Every diagnostic entity keeps its legacy unique_id */
+    for (size_t i = 0; i < ha_diag_entity_count; i++) {
+        char uid[64];
+        snprintf(uid, sizeof(uid), "\"uniq_id\":\"thermux_%s\"", ha_diag_entities[i].object_id);
+        TEST_ASSERT_NOT_NULL(strstr(s_buf, uid));
+    }
+    TEST_ASSERT_EQUAL_STRING("}}", s_buf + strlen(s_buf) - 2);
+}
+
+void test_ha_discovery_device_escapes_names(void)
+{
+    ha_sensor_t sensor = { "28FF1234567890AB", "Tank \"A\"" };
+    TEST_ASSERT_GREATER_THAN(0, render_device(&sensor, 1));
+    TEST_ASSERT_NOT_NULL(strstr(s_buf, "\"name\":\"Tank \\\"A\\\"\""));
+}
+
+void test_ha_discovery_device_smaller_than_entities(void)
+{
+    /* One device message replaces sensors + diagnostics retained messages */
+    ha_sensor_t sensors[16];
+    char ids[16][17];
+    size_t legacy_total = 0;
+    json_writer_t w;
+    char entity[640];
+
+    for (int i = 0; i < 16; i++) {
+        snprintf(ids[i], sizeof(ids[i]), "28FF%012X", i);
+        sensors[i].id = ids[i];
+        sensors[i].name = ids[i];
+        json_writer_init(&w, entity, sizeof(entity), NULL, NULL);
+        ha_discovery_write_sensor_config(&w, &s_node, &sensors[i]);
+        legacy_total += (size_t)json_writer_finish(&w);
+    }
+    for (size_t i = 0; i < ha_diag_entity_count; i++) {
+        json_writer_init(&w, entity, sizeof(entity), NULL, NULL);
+        ha_discovery_write_diag_config(&w, &s_node, &ha_diag_entities[i]);
+        legacy_total += (size_t)json_writer_finish(&w);
+    }
+
+    int device_len = render_device(sensors, 16);
+    TEST_ASSERT_GREATER_THAN(0, device_len);
+    TEST_ASSERT_LESS_THAN((int)(legacy_total * 2 / 3), device_len);
+}
+
+void test_ha_discovery_device_overflow(void)
+{
+    char small[128];
+    json_writer_t w;
+    json_writer_init(&w, small, sizeof(small), NULL, NULL);
+    ha_discovery_write_device_config(&w, &s_node, NULL, 0);
+    TEST_ASSERT_EQUAL_INT(-1, json_writer_finish(&w));
+}
+
+/* ===== Test Runner ===== */
+
+void run_ha_discovery_tests(void)
+{
+    RUN_TEST(test_ha_discovery_entity_topic);
+    RUN_TEST(test_ha_discovery_device_topic);
+    RUN_TEST(test_ha_discovery_topic_overflow);
+    RUN_TEST(test_ha_discovery_sensor_config);
+    RUN_TEST(test_ha_discovery_diag_config);
+    RUN_TEST(test_ha_discovery_device_header);
+    RUN_TEST(test_ha_discovery_device_sensor_component);
+    RUN_TEST(test_ha_discovery_device_diag_components);
+    RUN_TEST(test_ha_discovery_device_escapes_names);
+    RUN_TEST(test_ha_discovery_device_smaller_than_entities);
+    RUN_TEST(test_ha_discovery_device_overflow);
+}
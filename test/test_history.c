@@ -0,0 +1,127 @@
+/**
+ * @file test_history.c
+ * @brief Unit tests for the reading history ring and its cursors
+ */
+
+#include "unity.h"
+#include "history.h"
+#include <string.h>
+
+static history_record_t s_storage[4];
+static history_t s_history;
+
+static void history_reset(void)
+{
+    memset(s_storage, 0, sizeof(s_storage));
+    history_init(&s_history, s_storage, 4);
+}
+
+static void push_uptime(uint32_t uptime_s)
+{
+    history_record_t rec = { .uptime_s = uptime_s, .temp_centi = 2150 };
+    history_push(&s_history, &rec);
+}
+
+/* ===== Push/Read Tests ===== */
+
+void test_history_read_in_order(void)
+{
+    history_reset();
+    push_uptime(10);
+    push_uptime(20);
+    push_uptime(30);
+
+    history_record_t out[8];
+    uint32_t cursor = 0;
+    TEST_ASSERT_EQUAL_INT(3, history_read(&s_history, &cursor, out, 8));
+    TEST_ASSERT_EQUAL_INT(10, out[0].uptime_s);
+    TEST_ASSERT_EQUAL_INT(30, out[2].uptime_s);
+    TEST_ASSERT_EQUAL_INT(3, cursor);
+    TEST_ASSERT_EQUAL_INT(0, history_read(&s_history, &cursor, out, 8));
+}
+
+void test_history_read_in_pieces(void)
+{
+    history_reset();
+    for (uint32_t i = 1; i <= 4; i++) {
+        push_uptime(i);
+    }
+
+    history_record_t out[8];
+    uint32_t cursor = 0;
+    TEST_ASSERT_EQUAL_INT(3, history_read(&s_history, &cursor, out, 3));
+    TEST_ASSERT_EQUAL_INT(1, out[0].uptime_s);
+    TEST_ASSERT_EQUAL_INT(1, history_read(&s_history, &cursor, out, 3));
+    TEST_ASSERT_EQUAL_INT(4, out[0].uptime_s);
+}
+
+void test_history_overwrites_oldest(void)
+{
+    history_reset();
+    for (uint32_t i = 1; i <= 6; i++) {
+        push_uptime(i);
+    }
+    TEST_ASSERT_EQUAL_INT(4, s_history.count);
+
+    /* Wrapped: records 3..6 span the end of the storage */
+    history_record_t out[8];
+    uint32_t cursor = 0;
+    TEST_ASSERT_EQUAL_INT(4, history_read(&s_history, &cursor, out, 8));
+    TEST_ASSERT_EQUAL_INT(3, out[0].uptime_s);
+    TEST_ASSERT_EQUAL_INT(4, out[1].uptime_s);
+    TEST_ASSERT_EQUAL_INT(5, out[2].uptime_s);
+    TEST_ASSERT_EQUAL_INT(6, out[3].uptime_s);
+    TEST_ASSERT_EQUAL_INT(6, cursor);
+}
+
+/* ===== Cursor Edge Case Tests ===== */
+
+void test_history_stale_cursor_skips_ahead(void)
+{
+    history_reset();
+    push_uptime(1);
+    push_uptime(2);
+    uint32_t cursor = 1;
+    for (uint32_t i = 3; i <= 8; i++) {
+        push_uptime(i);
+    }
+
+    history_record_t out[8];
+    TEST_ASSERT_EQUAL_INT(4, history_read(&s_history, &cursor, out, 8));
+    TEST_ASSERT_EQUAL_INT(5, out[0].uptime_s);
+    TEST_ASSERT_EQUAL_INT(8, cursor);
+}
+
+void test_history_future_cursor_restarts(void)
+{
+    history_reset();
+    push_uptime(1);
+    push_uptime(2);
+
+    history_record_t out[8];
+    uint32_t cursor = 500;
+    TEST_ASSERT_EQUAL_INT(2, history_read(&s_history, &cursor, out, 8));
+    TEST_ASSERT_EQUAL_INT(1, out[0].uptime_s);
+    TEST_ASSERT_EQUAL_INT(2, cursor);
+}
+
+void test_history_empty(void)
+{
+    history_reset();
+    history_record_t out[2];
+    uint32_t cursor = 0;
+    TEST_ASSERT_EQUAL_INT(0, history_read(&s_history, &cursor, out, 2));
+    TEST_ASSERT_EQUAL_INT(0, cursor);
+}
+
+/* ===== Test Runner ===== */
+
+void run_history_tests(void)
+{
+    RUN_TEST(test_history_read_in_order);
+    RUN_TEST(test_history_read_in_pieces);
+    RUN_TEST(test_history_overwrites_oldest);
+    RUN_TEST(test_history_stale_cursor_skips_ahead);
+    RUN_TEST(test_history_future_cursor_restarts);
+    RUN_TEST(test_history_empty);
+}
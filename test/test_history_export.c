@@ -0,0 +1,176 @@
+/**
+ * @file test_history_export.c
+ * @brief Unit tests for CSV/NDJSON/CBOR export rows and filters
+ */
+
+#include "unity.h"
+#include "history_export.h"
+#include "cbor_decode.h"
+#include <string.h>
+
+static char s_buf[HISTORY_EXPORT_ROW_MAX + 1];
+
+static const history_record_t s_rec = {
+    .timestamp = 1700000000,
+    .uptime_s = 3600,
+    .address = { 0x28, 0xFF, 0x12, 0x34, 0x56, 0x78, 0x90, 0xAB },
+    .temp_centi = 2150,
+};
+
+static const char *row(history_export_format_t format, const history_record_t *rec)
+{
+    size_t n = history_export_row(format, rec, s_buf, sizeof(s_buf));
+    s_buf[n] = '\0';
+    return s_buf;
+}
+
+/* ===== Row Format Tests ===== */
+
+void test_history_export_csv_row(void)
+{
+    TEST_ASSERT_EQUAL_STRING("1700000000,3600,28FF1234567890AB,21.5\n", row(HISTORY_EXPORT_CSV, &s_rec));
+
+    size_t n = history_export_header(HISTORY_EXPORT_CSV, 0, s_buf, sizeof(s_buf));
+    s_buf[n] = '\0';
+    TEST_ASSERT_EQUAL_STRING("timestamp,uptime_s,address,temperature\n", s_buf);
+}
+
+void test_history_export_ndjson_row(void)
+{
+    TEST_ASSERT_EQUAL_STRING("{\"timestamp\":1700000000,\"uptime_s\":3600,"
+                             "\"address\":\"28FF1234567890AB\",\"temperature\":21.5}\n",
+                             row(HISTORY_EXPORT_NDJSON, &s_rec));
+    TEST_ASSERT_EQUAL_INT(0, history_export_header(HISTORY_EXPORT_NDJSON, 0, s_buf, sizeof(s_buf)));
+    TEST_ASSERT_EQUAL_INT(0, history_export_footer(HISTORY_EXPORT_NDJSON, s_buf, sizeof(s_buf)));
+}
+
+void test_history_export_cbor_document(void)
+{
+    uint8_t doc[TELEMETRY_CBOR_STREAM_HEADER_MAX + 2 * HISTORY_EXPORT_ROW_MAX];
+    size_t len = 0;
+    history_record_t rec = s_rec;
+    rec.timestamp = 0;
+
+    len += history_export_header(HISTORY_EXPORT_CBOR, 1760000000, (char *)doc, sizeof(doc));
+    TEST_ASSERT_GREATER_THAN(0, len);
+    len += history_export_row(HISTORY_EXPORT_CBOR, &s_rec, (char *)doc + len, sizeof(doc) - len);
+    len += history_export_row(HISTORY_EXPORT_CBOR, &rec, (char *)doc + len, sizeof(doc) - len);
+    size_t footer = history_export_footer(HISTORY_EXPORT_CBOR, (char *)doc + len, sizeof(doc) - len);
+    TEST_ASSERT_EQUAL_INT(HISTORY_EXPORT_FOOTER_MAX, footer);
+    len += footer;
+
+    telemetry_reading_t out[2];
+    uint32_t timestamp;
+    size_t count;
+    TEST_ASSERT_EQUAL_INT(0, telemetry_cbor_decode(doc, len, &timestamp, out, 2, &count));
+    TEST_ASSERT_EQUAL_INT(1760000000, (int)timestamp);
+    TEST_ASSERT_EQUAL_INT(2, (int)count);
+    TEST_ASSERT_TRUE(memcmp(out[0].rom, s_rec.address, 8) == 0);
+    TEST_ASSERT_EQUAL_INT(2150, out[0].temp_centi);
+    TEST_ASSERT_EQUAL_INT(1700000000, (int)out[0].timestamp);
+    TEST_ASSERT_EQUAL_INT(0, (int)out[1].timestamp);
+}
+
+void test_history_export_unknown_time(void)
+{
+    history_record_t rec = s_rec;
+    rec.timestamp = 0;
+    TEST_ASSERT_EQUAL_STRING(",3600,28FF1234567890AB,21.5\n", row(HISTORY_EXPORT_CSV, &rec));
+    TEST_ASSERT_EQUAL_STRING("{\"uptime_s\":3600,\"address\":\"28FF1234567890AB\",\"temperature\":21.5}\n",
+                             row(HISTORY_EXPORT_NDJSON, &rec));
+}
+
+void test_history_export_temperatures(void)
+{
+    history_record_t rec = s_rec;
+    rec.temp_centi = -6;
+    TEST_ASSERT_EQUAL_STRING("1700000000,3600,28FF1234567890AB,-0.06\n", row(HISTORY_EXPORT_CSV, &rec));
+    rec.temp_centi = 2000;
+    TEST_ASSERT_EQUAL_STRING("1700000000,3600,28FF1234567890AB,20\n", row(HISTORY_EXPORT_CSV, &rec));
+    rec.temp_centi = -1025;
+    TEST_ASSERT_EQUAL_STRING("1700000000,3600,28FF1234567890AB,-10.25\n", row(HISTORY_EXPORT_CSV, &rec));
+}
+
+void test_history_export_row_needs_room(void)
+{
+    TEST_ASSERT_EQUAL_INT(0, history_export_row(HISTORY_EXPORT_CSV, &s_rec, s_buf, 40));
+
+    /* Widest NDJSON row still fits */
+    history_record_t rec = s_rec;
+    rec.timestamp = UINT32_MAX;
+    rec.uptime_s = UINT32_MAX;
+    rec.temp_centi = INT16_MIN;
+    size_t n = history_export_row(HISTORY_EXPORT_NDJSON, &rec, s_buf, sizeof(s_buf));
+    TEST_ASSERT_GREATER_THAN(0, n);
+    TEST_ASSERT_LESS_THAN(HISTORY_EXPORT_ROW_MAX + 1, n);
+}
+
+/* ===== Parsing/Filter Tests ===== */
+
+void test_history_export_parse_format(void)
+{
+    history_export_format_t format;
+    TEST_ASSERT_EQUAL_INT(0, history_export_parse_format("ndjson", &format));
+    TEST_ASSERT_EQUAL_INT(HISTORY_EXPORT_NDJSON, format);
+    TEST_ASSERT_EQUAL_INT(0, history_export_parse_format("csv", &format));
+    TEST_ASSERT_EQUAL_INT(HISTORY_EXPORT_CSV, format);
+    TEST_ASSERT_EQUAL_INT(0, history_export_parse_format("cbor", &format));
+    TEST_ASSERT_EQUAL_INT(HISTORY_EXPORT_CBOR, format);
+    TEST_ASSERT_EQUAL_STRING("cbor", history_export_extension(format));
+    TEST_ASSERT_EQUAL_STRING("application/cbor", history_export_content_type(format));
+    TEST_ASSERT_EQUAL_INT(-1, history_export_parse_format("xml", &format));
+}
+
+void test_history_export_parse_sensors(void)
+{
+    history_export_filter_t filter = {0};
+    TEST_ASSERT_EQUAL_INT(0, history_export_parse_sensors("28ff1234567890ab%2C28AA000000000001", &filter));
+    TEST_ASSERT_EQUAL_INT(2, filter.address_count);
+    TEST_ASSERT_TRUE(memcmp(filter.addresses[0], s_rec.address, 8) == 0);
+    TEST_ASSERT_EQUAL_INT(0x01, filter.addresses[1][7]);
+
+    TEST_ASSERT_EQUAL_INT(-1, history_export_parse_sensors("", &filter));
+    TEST_ASSERT_EQUAL_INT(-1, history_export_parse_sensors("28FF", &filter));
+    TEST_ASSERT_EQUAL_INT(-1, history_export_parse_sensors("28FF1234567890AB,", &filter));
+    TEST_ASSERT_EQUAL_INT(-1, history_export_parse_sensors("28FF1234567890ABCD", &filter));
+    TEST_ASSERT_EQUAL_INT(-1, history_export_parse_sensors("28FF1234567890AG", &filter));
+}
+
+void test_history_export_filter(void)
+{
+    history_export_filter_t filter = {0};
+    TEST_ASSERT_TRUE(history_export_match(&filter, &s_rec));
+
+    filter.from = 1700000000;
+    filter.to = 1700000100;
+    TEST_ASSERT_TRUE(history_export_match(&filter, &s_rec));
+    filter.from = 1700000001;
+    TEST_ASSERT_FALSE(history_export_match(&filter, &s_rec));
+
+    /* Unknown time never matches a time range */
+    history_record_t rec = s_rec;
+    rec.timestamp = 0;
+    filter.from = 0;
+    TEST_ASSERT_FALSE(history_export_match(&filter, &rec));
+
+    filter.to = 0;
+    TEST_ASSERT_EQUAL_INT(0, history_export_parse_sensors("28AA000000000001", &filter));
+    TEST_ASSERT_FALSE(history_export_match(&filter, &s_rec));
+    TEST_ASSERT_EQUAL_INT(0, history_export_parse_sensors("28AA000000000001,28FF1234567890AB", &filter));
+    TEST_ASSERT_TRUE(history_export_match(&filter, &s_rec));
+}
+
+/* ===== Test Runner ===== */
+
+void run_history_export_tests(void)
+{
+    RUN_TEST(test_history_export_csv_row);
+    RUN_TEST(test_history_export_ndjson_row);
+    RUN_TEST(test_history_export_cbor_document);
+    RUN_TEST(test_history_export_unknown_time);
+    RUN_TEST(test_history_export_temperatures);
+    RUN_TEST(test_history_export_row_needs_room);
+    RUN_TEST(test_history_export_parse_format);
+    RUN_TEST(test_history_export_parse_sensors);
+    RUN_TEST(test_history_export_filter);
+}
@@ -0,0 +1,98 @@
+/**
+ * @file test_http_etag.c
+ * @brief Unit tests for ETag formatting and If-None-Match matching
+ */
+
+#include "unity.h"
+#include "http_etag.h"
+#include <string.h>
+
+/* ===== Format Tests ===== */
+
+void test_etag_format_strong(void)
+{
+    char buf[HTTP_ETAG_MAX_LEN];
+    TEST_ASSERT_EQUAL_INT(12, http_etag_format(buf, sizeof(buf), false, "1a2b", 0x3c4d5));
+    TEST_ASSERT_EQUAL_STRING("\"1a2b-3c4d5\"", buf);
+}
+
+void test_etag_format_weak(void)
+{
+    char buf[HTTP_ETAG_MAX_LEN];
+    TEST_ASSERT_GREATER_THAN(0, http_etag_format(buf, sizeof(buf), true, "2.7.0", 0));
+    TEST_ASSERT_EQUAL_STRING("W/\"2.7.0-0\"", buf);
+}
+
+void test_etag_format_too_small(void)
+{
+    char buf[8];
+    TEST_ASSERT_EQUAL_INT(-1, http_etag_format(buf, sizeof(buf), false, "deadbeef", 1));
+}
+
+/* ===== Match Tests ===== */
+
+void test_etag_match_exact(void)
+{
+    TEST_ASSERT_TRUE(http_etag_match("\"abc-1\"", "\"abc-1\""));
+    TEST_ASSERT_FALSE(http_etag_match("\"abc-2\"", "\"abc-1\""));
+    TEST_ASSERT_FALSE(http_etag_match("\"abc-1\"", "\"abc-10\""));
+    TEST_ASSERT_FALSE(http_etag_match("", "\"abc-1\""));
+}
+
+void test_etag_match_weak_comparison(void)
+{
+    TEST_ASSERT_TRUE(http_etag_match("W/\"abc-1\"", "\"abc-1\""));
+    TEST_ASSERT_TRUE(http_etag_match("\"abc-1\"", "W/\"abc-1\""));
+    TEST_ASSERT_TRUE(http_etag_match("W/\"abc-1\"", "W/\"abc-1\""));
+}
+
+void test_etag_match_list(void)
+{
+    TEST_ASSERT_TRUE(http_etag_match("\"x-1\", \"abc-1\"", "\"abc-1\""));
+    TEST_ASSERT_TRUE(http_etag_match("\"x-1\",W/\"abc-1\" ", "\"abc-1\""));
+    TEST_ASSERT_FALSE(http_etag_match("\"x-1\", \"y-2\"", "\"abc-1\""));
+    /* Commas inside a quoted tag do not split it */
+    TEST_ASSERT_TRUE(http_etag_match("\"a,b\", \"c\"", "\"a,b\""));
+    TEST_ASSERT_FALSE(http_etag_match("\"a,b\"", "\"b\""));
+}
+
+void test_etag_match_any(void)
+{
+    TEST_ASSERT_TRUE(http_etag_match("*", "\"abc-1\""));
+}
+
+void test_etag_match_malformed(void)
+{
+    TEST_ASSERT_FALSE(http_etag_match("\"abc-1", "\"abc-1\""));
+    TEST_ASSERT_FALSE(http_etag_match("abc-1", "\"abc-1\""));
+    TEST_ASSERT_FALSE(http_etag_match(" , ,", "\"abc-1\""));
+}
+
+/* ===== Hash Tests ===== */
+
+void test_etag_hash(void)
+{
+    /* FNV-1a reference values */
+    TEST_ASSERT_TRUE(http_etag_hash(HTTP_ETAG_HASH_INIT, "", 0) == 0x811c9dc5u);
+    TEST_ASSERT_TRUE(http_etag_hash(HTTP_ETAG_HASH_INIT, "a", 1) == 0xe40c292cu);
+
+    /* Chained calls hash the concatenation */
+    uint32_t h = http_etag_hash(HTTP_ETAG_HASH_INIT, "foo", 3);
+    h = http_etag_hash(h, "bar", 3);
+    TEST_ASSERT_TRUE(h == http_etag_hash(HTTP_ETAG_HASH_INIT, "foobar", 6));
+}
+
+/* ===== Test Runner ===== */
+
+void run_http_etag_tests(void)
+{
+    RUN_TEST(test_etag_format_strong);
+    RUN_TEST(test_etag_format_weak);
+    RUN_TEST(test_etag_format_too_small);
+    RUN_TEST(test_etag_match_exact);
+    RUN_TEST(test_etag_match_weak_comparison);
+    RUN_TEST(test_etag_match_list);
+    RUN_TEST(test_etag_match_any);
+    RUN_TEST(test_etag_match_malformed);
+    RUN_TEST(test_etag_hash);
+}
@@ -0,0 +1,195 @@
+/**
+ * @file test_json_scan.c
+ * @brief Unit tests for the incremental JSON scanner
+ */
+
+#include "unity.h"
+#include "json_scan.h"
+#include <stdio.h>
+#include <string.h>
+
+/* Shaped like a GitHub release: nested uploader objects, a long body, mixed literals */
+static const char RELEASE[] =
+    "{\"url\":\"https://api.github.com/repos/o/r/releases/1\",\"id\":123,"
+    "\"tag_name\":\"v2.8.0\",\"draft\":false,\"prerelease\":false,\"published_at\":null,"
+    "\"assets\":[{\"id\":1,\"name\":\"thermux.bin\",\"size\":1100000,"
+    "\"uploader\":{\"login\":\"bot\",\"site_admin\":false},"
+    "\"browser_download_url\":\"https://example.com/thermux.bin\"},"
+    "{\"id\":2,\"name\":\"thermux.bin.gz\",\"size\":-1.5e3,"
+    "\"browser_download_url\":\"https://example.com/thermux.bin.gz\"}],"
+    "\"body\":\"Fixes \\\"quoted\\\" things\\nand more\"}";
+
+/* ===== Recorder ===== */
+
+typedef struct {
+    char log[1024];
+    int strings;
+    int closes;
+    int truncated;
+} recorder_t;
+
+static recorder_t s_rec;
+static json_scan_t s_scan;
+
+/* Logs root_key/depth/key=value; */
+static void record_string(void *ctx, const json_scan_t *s, const char *value, size_t len)
+{
+    recorder_t *r = ctx;
+    size_t used = strlen(r->log);
+    snprintf(r->log + used, sizeof(r->log) - used, "%s/%d/%s=%s;", s->root_key, s->depth, s->key, value);
+    r->strings++;
+    r->truncated += s->truncated;
+    (void)len;
+}
+
+static void record_close(void *ctx, const json_scan_t *s)
+{
+    recorder_t *r = ctx;
+    if (s->depth == 3 && strcmp(s->root_key, "assets") == 0) {
+        size_t used = strlen(r->log);
+        snprintf(r->log + used, sizeof(r->log) - used, "|");
+    }
+    r->closes++;
+}
+
+static void scan_reset(void)
+{
+    memset(&s_rec, 0, sizeof(s_rec));
+    json_scan_init(&s_scan, record_string, record_close, &s_rec);
+}
+
+/* Feed in pieces of the given size */
+static int scan(const char *doc, size_t piece)
+{
+    scan_reset();
+    size_t len = strlen(doc);
+    for (size_t off = 0; off < len; off += piece) {
+        size_t n = len - off < piece ? len - off : piece;
+        json_scan_feed(&s_scan, doc + off, n);
+    }
+    return json_scan_finish(&s_scan);
+}
+
+static const char RELEASE_LOG[] =
+    "url/1/url=https://api.github.com/repos/o/r/releases/1;"
+    "tag_name/1/tag_name=v2.8.0;"
+    "assets/3/name=thermux.bin;"
+    "assets/4/login=bot;"
+    "assets/3/browser_download_url=https://example.com/thermux.bin;|"
+    "assets/3/name=thermux.bin.gz;"
+    "assets/3/browser_download_url=https://example.com/thermux.bin.gz;|"
+    "body/1/body=Fixes \"quoted\" things\nand more;";
+
+/* ===== Scan Tests ===== */
+
+void test_json_scan_reports_strings_with_path(void)
+{
+    TEST_ASSERT_EQUAL_INT(JSON_SCAN_OK, scan(RELEASE, sizeof(RELEASE)));
+    TEST_ASSERT_EQUAL_STRING(RELEASE_LOG, s_rec.log);
+    TEST_ASSERT_EQUAL_INT(8, s_rec.strings);
+    /* uploader, two assets, the assets array, the root */
+    TEST_ASSERT_EQUAL_INT(5, s_rec.closes);
+}
+
+void test_json_scan_byte_at_a_time(void)
+{
+    TEST_ASSERT_EQUAL_INT(JSON_SCAN_OK, scan(RELEASE, 1));
+    TEST_ASSERT_EQUAL_STRING(RELEASE_LOG, s_rec.log);
+}
+
+void test_json_scan_array_elements_have_no_key(void)
+{
+    TEST_ASSERT_EQUAL_INT(JSON_SCAN_OK, scan("{\"a\":[\"x\",[1,\"y\"],{\"k\":\"z\"}],\"b\":\"w\"}", 7));
+    TEST_ASSERT_EQUAL_STRING("a/2/=x;a/3/=y;a/3/k=z;b/1/b=w;", s_rec.log);
+}
+
+void test_json_scan_unicode_escapes(void)
+{
+    TEST_ASSERT_EQUAL_INT(JSON_SCAN_OK, scan("[\"caf\\u00e9 \\u20AC\\/\\t\"]", 3));
+    TEST_ASSERT_EQUAL_STRING("/1/=caf\xc3\xa9 \xe2\x82\xac/\t;", s_rec.log);
+}
+
+void test_json_scan_truncates_long_values(void)
+{
+    static char doc[600];
+    char *p = doc;
+    p += sprintf(p, "{\"long\":\"");
+    for (int i = 0; i < 500; i++) {
+        *p++ = (char)('a' + i % 26);
+    }
+    sprintf(p, "\",\"after\":\"ok\"}");
+
+    TEST_ASSERT_EQUAL_INT(JSON_SCAN_OK, scan(doc, 64));
+    TEST_ASSERT_EQUAL_INT(1, s_rec.truncated);
+    TEST_ASSERT_EQUAL_INT(2, s_rec.strings);
+    /* Cut at JSON_SCAN_VALUE_MAX - 1 bytes, and the next member is unaffected */
+    TEST_ASSERT_TRUE(strstr(s_rec.log, "after/1/after=ok;") != NULL);
+    TEST_ASSERT_EQUAL_INT(strlen("long/1/long=") + JSON_SCAN_VALUE_MAX - 1 + 1,
+                          strchr(s_rec.log, ';') - s_rec.log + 1);
+}
+
+void test_json_scan_root_literals(void)
+{
+    TEST_ASSERT_EQUAL_INT(JSON_SCAN_OK, scan("42", 1));
+    TEST_ASSERT_EQUAL_INT(JSON_SCAN_OK, scan(" \"s\" \n", 1));
+    TEST_ASSERT_EQUAL_STRING("/0/=s;", s_rec.log);
+    TEST_ASSERT_EQUAL_INT(JSON_SCAN_OK, scan("{}", 1));
+    TEST_ASSERT_EQUAL_INT(JSON_SCAN_OK, scan("[ ]", 1));
+}
+
+/* ===== Error Tests ===== */
+
+void test_json_scan_rejects_bad_structure(void)
+{
+    TEST_ASSERT_EQUAL_INT(JSON_SCAN_ERR_SYNTAX, scan("{\"a\":1]", 4));
+    TEST_ASSERT_EQUAL_INT(JSON_SCAN_ERR_SYNTAX, scan("{\"a\" 1}", 4));
+    TEST_ASSERT_EQUAL_INT(JSON_SCAN_ERR_SYNTAX, scan("{\"a\":1,}", 4));
+    TEST_ASSERT_EQUAL_INT(JSON_SCAN_ERR_SYNTAX, scan("[1,2]x", 4));
+    TEST_ASSERT_EQUAL_INT(JSON_SCAN_ERR_SYNTAX, scan("{a:1}", 4));
+    TEST_ASSERT_EQUAL_INT(JSON_SCAN_ERR_SYNTAX, scan("[\"\\q\"]", 4));
+    TEST_ASSERT_EQUAL_INT(JSON_SCAN_ERR_SYNTAX, scan("[\"\\u12g4\"]", 4));
+}
+
+void test_json_scan_error_is_sticky(void)
+{
+    scan_reset();
+    TEST_ASSERT_EQUAL_INT(JSON_SCAN_ERR_SYNTAX, json_scan_feed(&s_scan, "}", 1));
+    TEST_ASSERT_EQUAL_INT(JSON_SCAN_ERR_SYNTAX, json_scan_feed(&s_scan, "[\"x\"]", 5));
+    TEST_ASSERT_EQUAL_INT(0, s_rec.strings);
+}
+
+void test_json_scan_detects_incomplete(void)
+{
+    TEST_ASSERT_EQUAL_INT(JSON_SCAN_ERR_INCOMPLETE, scan("{\"tag_name\":\"v2", 4));
+    TEST_ASSERT_EQUAL_INT(JSON_SCAN_ERR_INCOMPLETE, scan("[[]", 4));
+    TEST_ASSERT_EQUAL_INT(JSON_SCAN_ERR_INCOMPLETE, scan("", 4));
+}
+
+void test_json_scan_depth_limit(void)
+{
+    char doc[JSON_SCAN_MAX_DEPTH * 2 + 3];
+    memset(doc, '[', JSON_SCAN_MAX_DEPTH);
+    memset(doc + JSON_SCAN_MAX_DEPTH, ']', JSON_SCAN_MAX_DEPTH);
+    doc[JSON_SCAN_MAX_DEPTH * 2] = '\0';
+    TEST_ASSERT_EQUAL_INT(JSON_SCAN_OK, scan(doc, 16));
+
+    memset(doc, '[', JSON_SCAN_MAX_DEPTH + 1);
+    doc[JSON_SCAN_MAX_DEPTH + 1] = '\0';
+    TEST_ASSERT_EQUAL_INT(JSON_SCAN_ERR_DEPTH, scan(doc, 16));
+}
+
+/* ===== Test Runner ===== */
+
+void run_json_scan_tests(void)
+{
+    RUN_TEST(test_json_scan_reports_strings_with_path);
+    RUN_TEST(test_json_scan_byte_at_a_time);
+    RUN_TEST(test_json_scan_array_elements_have_no_key);
+    RUN_TEST(test_json_scan_unicode_escapes);
+    RUN_TEST(test_json_scan_truncates_long_values);
+    RUN_TEST(test_json_scan_root_literals);
+    RUN_TEST(test_json_scan_rejects_bad_structure);
+    RUN_TEST(test_json_scan_error_is_sticky);
+    RUN_TEST(test_json_scan_detects_incomplete);
+    RUN_TEST(test_json_scan_depth_limit);
+}
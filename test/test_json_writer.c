@@ -0,0 +1,308 @@
+/**
+ * @file test_json_writer.c
+ * @brief Unit tests for the streaming JSON writer
+ */
+
+#include "unity.h"
+#include "json_writer.h"
+#include <string.h>
+#include <math.h>
+
+/* ===== Sink helpers ===== */
+
+typedef struct {
+    char data[1024];
+    size_t len;
+    int calls;
+    int fail_after;  /* Fail on this call number (0 = never) */
+} capture_sink_t;
+
+static int capture_sink(void *ctx, const char *data, size_t len)
+{
+    capture_sink_t *c = ctx;
+    c->calls++;
+    if (c->fail_after && c->calls >= c->fail_after) {
+        return -1;
+    }
+    memcpy(c->data + c->len, data, len);
+    c->len += len;
+    c->data[c->len] = '\0';
+    return 0;
+}
+
+/* ===== Structure Tests ===== */
+
+void test_json_writer_empty_object(void)
+{
+    char buf[16];
+    json_writer_t w;
+    json_writer_init(&w, buf, sizeof(buf), NULL, NULL);
+    json_writer_begin_object(&w);
+    json_writer_end_object(&w);
+
+    TEST_ASSERT_EQUAL_INT(2, json_writer_finish(&w));
+    TEST_ASSERT_EQUAL_STRING("{}", buf);
+}
+
+void test_json_writer_object_members(void)
+{
+    char buf[128];
+    json_writer_t w;
+    json_writer_init(&w, buf, sizeof(buf), NULL, NULL);
+    json_writer_begin_object(&w);
+    json_writer_kv_string(&w, "address", "28FF123456789ABC");
+    json_writer_kv_bool(&w, "valid", true);
+    json_writer_kv_null(&w, "friendly_name");
+    json_writer_kv_uint(&w, "total_reads", 42);
+    json_writer_end_object(&w);
+
+    TEST_ASSERT_GREATER_THAN(0, json_writer_finish(&w));
+    TEST_ASSERT_EQUAL_STRING(
+        "{\"address\":\"28FF123456789ABC\",\"valid\":true,"
+        "\"friendly_name\":null,\"total_reads\":42}", buf);
+}
+
+void test_json_writer_nested(void)
+{
+    char buf[128];
+    json_writer_t w;
+    json_writer_init(&w, buf, sizeof(buf), NULL, NULL);
+    json_writer_begin_array(&w);
+    json_writer_begin_object(&w);
+    json_writer_key(&w, "ids");
+    json_writer_begin_array(&w);
+    json_writer_int(&w, 1);
+    json_writer_int(&w, -2);
+    json_writer_end_array(&w);
+    json_writer_end_object(&w);
+    json_writer_begin_object(&w);
+    json_writer_end_object(&w);
+    json_writer_end_array(&w);
+
+    TEST_ASSERT_GREATER_THAN(0, json_writer_finish(&w));
+    TEST_ASSERT_EQUAL_STRING("[{\"ids\":[1,-2]},{}]", buf);
+}
+
+void test_json_writer_unbalanced_fails(void)
+{
+    char buf[32];
+    json_writer_t w;
+    json_writer_init(&w, buf, sizeof(buf), NULL, NULL);
+    json_writer_begin_object(&w);
+
+    TEST_ASSERT_EQUAL_INT(-1, json_writer_finish(&w));
+}
+
+void test_json_writer_dangling_key_fails(void)
+{
+    char buf[32];
+    json_writer_t w;
+    json_writer_init(&w, buf, sizeof(buf), NULL, NULL);
+    json_writer_begin_object(&w);
+    json_writer_key(&w, "a");
+    json_writer_end_object(&w);
+
+    TEST_ASSERT_EQUAL_INT(-1, json_writer_finish(&w));
+}
+
+void test_json_writer_depth_limit(void)
+{
+    char buf[128];
+    json_writer_t w;
+    json_writer_init(&w, buf, sizeof(buf), NULL, NULL);
+    for (int i = 0; i < JSON_WRITER_MAX_DEPTH + 1; i++) {
+        json_writer_begin_array(&w);
+    }
+    TEST_ASSERT_TRUE(w.error);
+}
+
+/* ===== Escaping Tests ===== */
+
+void test_json_writer_escapes_quotes_and_backslash(void)
+{
+    char buf[64];
+    json_writer_t w;
+    json_writer_init(&w, buf, sizeof(buf), NULL, NULL);
+    json_writer_string(&w, "a\"b\\c");
+
+    TEST_ASSERT_GREATER_THAN(0, json_writer_finish(&w));
+    TEST_ASSERT_EQUAL_STRING("\"a\\\"b\\\\c\"", buf);
+}
+
+void test_json_writer_escapes_control_chars(void)
+{
+    char buf[64];
+    json_writer_t w;
+    json_writer_init(&w, buf, sizeof(buf), NULL, NULL);
+    json_writer_string(&w, "\n\t\r\b\f\x01\x1f");
+
+    TEST_ASSERT_GREATER_THAN(0, json_writer_finish(&w));
+    TEST_ASSERT_EQUAL_STRING("\"\\n\\t\\r\\b\\f\\u0001\\u001f\"", buf);
+}
+
+void test_json_writer_passes_utf8(void)
+{
+    char buf[64];
+    json_writer_t w;
+    json_writer_init(&w, buf, sizeof(buf), NULL, NULL);
+    json_writer_string(&w, "°C");
+
+    TEST_ASSERT_GREATER_THAN(0, json_writer_finish(&w));
+    TEST_ASSERT_EQUAL_STRING("\"°C\"", buf);
+}
+
+void test_json_writer_escapes_keys(void)
+{
+    char buf[64];
+    json_writer_t w;
+    json_writer_init(&w, buf, sizeof(buf), NULL, NULL);
+    json_writer_begin_object(&w);
+    json_writer_kv_int(&w, "a\"b", 1);
+    json_writer_end_object(&w);
+
+    TEST_ASSERT_GREATER_THAN(0, json_writer_finish(&w));
+    TEST_ASSERT_EQUAL_STRING("{\"a\\\"b\":1}", buf);
+}
+
+/* ===== Number Tests ===== */
+
+void test_json_writer_int_limits(void)
+{
+    char buf[64];
+    json_writer_t w;
+    json_writer_init(&w, buf, sizeof(buf), NULL, NULL);
+    json_writer_begin_array(&w);
+    json_writer_int(&w, INT64_MIN);
+    json_writer_uint(&w, UINT64_MAX);
+    json_writer_int(&w, 0);
+    json_writer_end_array(&w);
+
+    TEST_ASSERT_GREATER_THAN(0, json_writer_finish(&w));
+    TEST_ASSERT_EQUAL_STRING("[-9223372036854775808,18446744073709551615,0]", buf);
+}
+
+void test_json_writer_double_formats(void)
+{
+    char buf[128];
+    json_writer_t w;
+    json_writer_init(&w, buf, sizeof(buf), NULL, NULL);
+    json_writer_begin_array(&w);
+    json_writer_double(&w, 22.5);
+    json_writer_double(&w, -5.0);
+    json_writer_double(&w, 0.1);
+    json_writer_double(&w, (double)23.45f);  /* Float readings keep full precision */
+    json_writer_double(&w, 1e300);
+    json_writer_double(&w, -1e20);
+    json_writer_end_array(&w);
+
+    TEST_ASSERT_GREATER_THAN(0, json_writer_finish(&w));
+    TEST_ASSERT_EQUAL_STRING("[22.5,-5,0.1,23.450000762939453,1e+300,-1e+20]", buf);
+}
+
+void test_json_writer_double_non_finite(void)
+{
+    char buf[32];
+    json_writer_t w;
+    json_writer_init(&w, buf, sizeof(buf), NULL, NULL);
+    json_writer_begin_array(&w);
+    json_writer_double(&w, NAN);
+    json_writer_double(&w, INFINITY);
+    json_writer_end_array(&w);
+
+    TEST_ASSERT_GREATER_THAN(0, json_writer_finish(&w));
+    TEST_ASSERT_EQUAL_STRING("[null,null]", buf);
+}
+
+/* ===== Buffer / Sink Tests ===== */
+
+void test_json_writer_overflow_fixed_buffer(void)
+{
+    char buf[8];
+    json_writer_t w;
+    json_writer_init(&w, buf, sizeof(buf), NULL, NULL);
+    json_writer_string(&w, "too long for buffer");
+
+    TEST_ASSERT_EQUAL_INT(-1, json_writer_finish(&w));
+}
+
+void test_json_writer_exact_fit(void)
+{
+    char buf[3];  /* "{}" plus terminator */
+    json_writer_t w;
+    json_writer_init(&w, buf, sizeof(buf), NULL, NULL);
+    json_writer_begin_object(&w);
+    json_writer_end_object(&w);
+
+    TEST_ASSERT_EQUAL_INT(2, json_writer_finish(&w));
+    TEST_ASSERT_EQUAL_STRING("{}", buf);
+}
+
+void test_json_writer_sink_streams_small_buffer(void)
+{
+    char buf[7];
+    capture_sink_t cap = {0};
+    json_writer_t w;
+    json_writer_init(&w, buf, sizeof(buf), capture_sink, &cap);
+    json_writer_begin_object(&w);
+    json_writer_kv_string(&w, "message", "streamed through a tiny buffer");
+    json_writer_kv_int(&w, "count", 12345);
+    json_writer_end_object(&w);
+
+    int len = json_writer_finish(&w);
+    const char *expected = "{\"message\":\"streamed through a tiny buffer\",\"count\":12345}";
+    TEST_ASSERT_EQUAL_INT((int)strlen(expected), len);
+    TEST_ASSERT_EQUAL_STRING(expected, cap.data);
+    TEST_ASSERT_GREATER_THAN(1, cap.calls);
+}
+
+void test_json_writer_sink_error_propagates(void)
+{
+    char buf[4];
+    capture_sink_t cap = {0};
+    cap.fail_after = 2;
+    json_writer_t w;
+    json_writer_init(&w, buf, sizeof(buf), capture_sink, &cap);
+    json_writer_string(&w, "abcdefghijklmnop");
+
+    TEST_ASSERT_EQUAL_INT(-1, json_writer_finish(&w));
+    TEST_ASSERT_EQUAL_INT(2, cap.calls);  /* Stops calling sink after failure */
+}
+
+void test_json_writer_raw_value(void)
+{
+    char buf[64];
+    json_writer_t w;
+    json_writer_init(&w, buf, sizeof(buf), NULL, NULL);
+    json_writer_begin_object(&w);
+    json_writer_key(&w, "pre");
+    json_writer_raw(&w, "[1,2]", 5);
+    json_writer_kv_int(&w, "n", 3);
+    json_writer_end_object(&w);
+
+    TEST_ASSERT_GREATER_THAN(0, json_writer_finish(&w));
+    TEST_ASSERT_EQUAL_STRING("{\"pre\":[1,2],\"n\":3}", buf);
+}
+
+/* ===== Test Runner ===== */
+
+void run_json_writer_tests(void)
+{
+    RUN_TEST(test_json_writer_empty_object);
+    RUN_TEST(test_json_writer_object_members);
+    RUN_TEST(test_json_writer_nested);
+    RUN_TEST(test_json_writer_unbalanced_fails);
+    RUN_TEST(test_json_writer_dangling_key_fails);
+    RUN_TEST(test_json_writer_depth_limit);
+    RUN_TEST(test_json_writer_escapes_quotes_and_backslash);
+    RUN_TEST(test_json_writer_escapes_control_chars);
+    RUN_TEST(test_json_writer_passes_utf8);
+    RUN_TEST(test_json_writer_escapes_keys);
+    RUN_TEST(test_json_writer_int_limits);
+    RUN_TEST(test_json_writer_double_formats);
+    RUN_TEST(test_json_writer_double_non_finite);
+    RUN_TEST(test_json_writer_overflow_fixed_buffer);
+    RUN_TEST(test_json_writer_exact_fit);
+    RUN_TEST(test_json_writer_sink_streams_small_buffer);
+    RUN_TEST(test_json_writer_sink_error_propagates);
+    RUN_TEST(test_json_writer_raw_value);
+}
@@ -0,0 +1,123 @@
+/**
+ * @file test_log_filter.c
+ * @brief Unit tests for per-tag log capture levels
+ */
+
+#include "unity.h"
+#include "log_filter.h"
+#include <stdio.h>
+#include <string.h>
+
+static log_filter_t s_filter;
+
+/* ===== Level Tests ===== */
+
+void test_log_filter_default_level(void)
+{
+    log_filter_init(&s_filter, 3);
+    TEST_ASSERT_EQUAL_INT(3, log_filter_level(&s_filter, "main"));
+    TEST_ASSERT_EQUAL_INT(3, log_filter_max(&s_filter));
+
+    log_filter_set_default(&s_filter, 4);
+    TEST_ASSERT_EQUAL_INT(4, log_filter_get_default(&s_filter));
+    TEST_ASSERT_EQUAL_INT(4, log_filter_level(&s_filter, "main"));
+}
+
+void test_log_filter_tag_levels(void)
+{
+    log_filter_init(&s_filter, 3);
+    TEST_ASSERT_TRUE(log_filter_set(&s_filter, "httpd_uri", 0));
+    TEST_ASSERT_TRUE(log_filter_set(&s_filter, "sensors", 5));
+    TEST_ASSERT_EQUAL_INT(0, log_filter_level(&s_filter, "httpd_uri"));
+    TEST_ASSERT_EQUAL_INT(5, log_filter_level(&s_filter, "sensors"));
+    TEST_ASSERT_EQUAL_INT(3, log_filter_level(&s_filter, "httpd"));
+    TEST_ASSERT_EQUAL_INT(5, log_filter_max(&s_filter));
+
+    /* Changing a level keeps one entry */
+    TEST_ASSERT_TRUE(log_filter_set(&s_filter, "sensors", 2));
+    TEST_ASSERT_EQUAL_INT(2, log_filter_level(&s_filter, "sensors"));
+    TEST_ASSERT_EQUAL_INT(2, s_filter.count);
+
+    log_filter_remove(&s_filter, "sensors");
+    TEST_ASSERT_EQUAL_INT(3, log_filter_level(&s_filter, "sensors"));
+    TEST_ASSERT_EQUAL_INT(0, log_filter_level(&s_filter, "httpd_uri"));
+    TEST_ASSERT_EQUAL_INT(1, s_filter.count);
+
+    /* Removing an unknown tag is harmless */
+    log_filter_remove(&s_filter, "unknown");
+    TEST_ASSERT_EQUAL_INT(1, s_filter.count);
+}
+
+void test_log_filter_limits(void)
+{
+    log_filter_init(&s_filter, 3);
+    TEST_ASSERT_FALSE(log_filter_set(&s_filter, "a_tag_that_is_too_long", 1));
+
+    char tag[16];
+    for (int i = 0; i < LOG_FILTER_TAGS; i++) {
+        snprintf(tag, sizeof(tag), "tag%d", i);
+        TEST_ASSERT_TRUE(log_filter_set(&s_filter, tag, i % 6));
+    }
+    TEST_ASSERT_FALSE(log_filter_set(&s_filter, "one_more", 1));
+    for (int i = 0; i < LOG_FILTER_TAGS; i++) {
+        snprintf(tag, sizeof(tag), "tag%d", i);
+        TEST_ASSERT_EQUAL_INT(i % 6, log_filter_level(&s_filter, tag));
+    }
+
+    /* Removed slots are reused and do not hide the tags after them */
+    for (int round = 0; round < 100; round++) {
+        snprintf(tag, sizeof(tag), "tag%d", round % LOG_FILTER_TAGS);
+        log_filter_remove(&s_filter, tag);
+        TEST_ASSERT_TRUE(log_filter_set(&s_filter, "spare", 1));
+        log_filter_remove(&s_filter, "spare");
+        TEST_ASSERT_TRUE(log_filter_set(&s_filter, tag, 4));
+    }
+    for (int i = 0; i < LOG_FILTER_TAGS; i++) {
+        snprintf(tag, sizeof(tag), "tag%d", i);
+        TEST_ASSERT_EQUAL_INT(4, log_filter_level(&s_filter, tag));
+    }
+    TEST_ASSERT_EQUAL_INT(3, log_filter_level(&s_filter, "spare"));
+}
+
+void test_log_filter_lists_tags(void)
+{
+    log_filter_init(&s_filter, 3);
+    log_filter_set(&s_filter, "wifi", 2);
+    log_filter_set(&s_filter, "mqtt", 4);
+    log_filter_set(&s_filter, "gone", 1);
+    log_filter_remove(&s_filter, "gone");
+
+    const char *tag;
+    int level;
+    int seen = 0;
+    int sum = 0;
+    for (int i = log_filter_next(&s_filter, 0, &tag, &level); i >= 0;
+         i = log_filter_next(&s_filter, i, &tag, &level)) {
+        TEST_ASSERT_TRUE(strcmp(tag, "wifi") == 0 || strcmp(tag, "mqtt") == 0);
+        seen++;
+        sum += level;
+    }
+    TEST_ASSERT_EQUAL_INT(2, seen);
+    TEST_ASSERT_EQUAL_INT(6, sum);
+}
+
+void test_log_filter_level_letters(void)
+{
+    TEST_ASSERT_EQUAL_INT(1, log_filter_level_of('E'));
+    TEST_ASSERT_EQUAL_INT(2, log_filter_level_of('W'));
+    TEST_ASSERT_EQUAL_INT(3, log_filter_level_of('I'));
+    TEST_ASSERT_EQUAL_INT(4, log_filter_level_of('D'));
+    TEST_ASSERT_EQUAL_INT(5, log_filter_level_of('V'));
+    TEST_ASSERT_EQUAL_INT(-1, log_filter_level_of('X'));
+}
+
+/* ===== Test Runner ===== */
+
+void run_log_filter_tests(void)
+{
+    RUN_TEST(test_log_filter_default_level);
+    RUN_TEST(test_log_filter_tag_levels);
+    RUN_TEST(test_log_filter_limits);
+    RUN_TEST(test_log_filter_lists_tags);
+    RUN_TEST(test_log_filter_level_letters);
+}
@@ -0,0 +1,271 @@
+/**
+ * @file test_log_record.c
+ * @brief Unit tests for binary log records and reading them from a ring
+ */
+
+#include "unity.h"
+#include "log_record.h"
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+/* Stands in for RAM: everything else counts as constant data */
+static char s_ram[64];
+
+static uint32_t s_rec[LOG_RECORD_MAX / 4];
+static char s_line[300];
+
+static bool is_static(const void *ptr)
+{
+    return !((const char *)ptr >= s_ram && (const char *)ptr < s_ram + sizeof(s_ram));
+}
+
+static size_t encode(const char *fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    size_t len = log_record_encode(s_rec, sizeof(s_rec), fmt, args, is_static);
+    va_end(args);
+    return len;
+}
+
+/* Record a line and check it reads back as printf would have printed it */
+static void check_line(const char *fmt, ...)
+{
+    char expected[300];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(expected, sizeof(expected), fmt, args);
+    va_end(args);
+
+    va_start(args, fmt);
+    size_t len = log_record_encode(s_rec, sizeof(s_rec), fmt, args, is_static);
+    va_end(args);
+
+    TEST_ASSERT_GREATER_THAN(0, (int)len);
+    TEST_ASSERT_EQUAL_INT(0, (int)(len % 4));
+    TEST_ASSERT_EQUAL_INT((int)len, (int)log_record_size(s_rec));
+    TEST_ASSERT_EQUAL_INT((int)strlen(expected), log_record_format(s_rec, len, s_line, sizeof(s_line), is_static));
+    TEST_ASSERT_EQUAL_STRING(expected, s_line);
+}
+
+/* ===== Record Tests ===== */
+
+void test_log_record_formats_like_printf(void)
+{
+    check_line("I (%lu) %s: Sensor %d: %.2f C\n", 123456UL, "sensors", 3, 21.5);
+    check_line("[%5s|%-5s|%.3s]", "ab", "cd", "truncated");
+    check_line("%*d|%-*.*f|%.*s", 6, -42, 9, 3, 3.14159, 2, "xyz");
+    check_line("%llx %zu %jd %td %p %c %%", 0x123456789abcULL, (size_t)77, (intmax_t)-5, (ptrdiff_t)9,
+               (void *)s_rec, 'Q');
+    check_line("%08lX %hhd %hu %o %+i %e %g", 0xBEEFUL, 300, 70000, 8, 5, 1e-7, 0.5);
+    check_line("no conversions\n");
+}
+
+void test_log_record_copies_ram_strings(void)
+{
+    strcpy(s_ram, "28-0316a2794a1f");
+    size_t len = encode("%s: %s", "sensors", s_ram);
+    TEST_ASSERT_GREATER_THAN(0, (int)len);
+    memset(s_ram, 'x', sizeof(s_ram) - 1);
+
+    TEST_ASSERT_EQUAL_INT(24, log_record_format(s_rec, len, s_line, sizeof(s_line), is_static));
+    TEST_ASSERT_EQUAL_STRING("sensors: 28-0316a2794a1f", s_line);
+
+    /* Only as much as the precision allows is read or kept */
+    memcpy(s_ram, "abcdef", 6);
+    len = encode("%.4s", s_ram);
+    TEST_ASSERT_EQUAL_INT(4, log_record_format(s_rec, len, s_line, sizeof(s_line), is_static));
+    TEST_ASSERT_EQUAL_STRING("abcd", s_line);
+
+    len = encode("%s", (const char *)NULL);
+    TEST_ASSERT_GREATER_THAN(0, log_record_format(s_rec, len, s_line, sizeof(s_line), is_static));
+}
+
+void test_log_record_smaller_than_text(void)
+{
+    const char *fmt = "I (%lu) %s: Connected to access point, waiting for an address\n";
+    size_t len = encode(fmt, 1234567UL, "wifi_manager");
+    int text = snprintf(s_line, sizeof(s_line), fmt, 1234567UL, "wifi_manager");
+    TEST_ASSERT_LESS_THAN(text / 2, (int)len);
+}
+
+void test_log_record_falls_back_to_text(void)
+{
+    strcpy(s_ram, "%d in RAM");
+    TEST_ASSERT_EQUAL_INT(0, (int)encode(s_ram, 1));
+    int count;
+    TEST_ASSERT_EQUAL_INT(0, (int)encode("abc%n", &count));
+    TEST_ASSERT_EQUAL_INT(0, (int)encode("%Lf", (long double)1.0));
+    TEST_ASSERT_EQUAL_INT(0, (int)encode("%ls", L"wide"));
+
+    size_t len = log_record_text(s_rec, sizeof(s_rec), "formatted line\n", 15);
+    TEST_ASSERT_EQUAL_INT(24, (int)len);
+    TEST_ASSERT_EQUAL_INT(24, (int)log_record_size(s_rec));
+    TEST_ASSERT_EQUAL_INT(15, log_record_format(s_rec, len, s_line, sizeof(s_line), is_static));
+    TEST_ASSERT_EQUAL_STRING("formatted line\n", s_line);
+
+    TEST_ASSERT_EQUAL_INT(0, (int)log_record_text(s_rec, LOG_RECORD_MAX, s_line, LOG_RECORD_MAX));
+}
+
+void test_log_record_truncates_output(void)
+{
+    size_t len = encode("value=%d and more", 12345);
+    char small[8];
+    TEST_ASSERT_EQUAL_INT(20, log_record_format(s_rec, len, small, sizeof(small), is_static));
+    TEST_ASSERT_EQUAL_STRING("value=1", small);
+}
+
+void test_log_record_rejects_damaged_headers(void)
+{
+    memset(s_rec, 0, sizeof(s_rec));
+    TEST_ASSERT_EQUAL_INT(0, (int)log_record_size(s_rec));
+
+    size_t len = encode("I (%lu) %s: ok\n", 1UL, "tag");
+    for (int i = 0; i < LOG_RECORD_HEADER; i++) {
+        ((uint8_t *)s_rec)[i] ^= 0x10;
+        TEST_ASSERT_EQUAL_INT(0, (int)log_record_size(s_rec));
+        TEST_ASSERT_EQUAL_INT(-1, log_record_format(s_rec, len, s_line, sizeof(s_line), is_static));
+        ((uint8_t *)s_rec)[i] ^= 0x10;
+    }
+    TEST_ASSERT_EQUAL_INT((int)len, (int)log_record_size(s_rec));
+}
+
+static const char *tag_of(char *level, const char **msg, const char *fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    const char *tag = log_record_tag(fmt, args, level, msg);
+    va_end(args);
+    return tag;
+}
+
+void test_log_record_tag(void)
+{
+    char level = 0;
+    const char *msg = NULL;
+    TEST_ASSERT_EQUAL_STRING("httpd_uri", tag_of(&level, &msg, "D (%" PRIu32 ") %s: Found URI %s\n",
+                                                 (uint32_t)1234, "httpd_uri", "/api/logs"));
+    TEST_ASSERT_EQUAL_INT('D', level);
+    TEST_ASSERT_EQUAL_STRING("Found URI %s\n", msg);
+
+    TEST_ASSERT_EQUAL_STRING("wifi", tag_of(&level, NULL, "\033[0;33mW (%s) %s: retry\033[0m\n",
+                                            "12:00:01.123", "wifi"));
+    TEST_ASSERT_EQUAL_INT('W', level);
+
+    TEST_ASSERT_NULL(tag_of(NULL, NULL, "plain printf %d\n", 1));
+    TEST_ASSERT_NULL(tag_of(NULL, NULL, "X (%" PRIu32 ") %s: x", (uint32_t)1, "tag"));
+    TEST_ASSERT_NULL(tag_of(NULL, NULL, ""));
+}
+
+/* ===== Ring Tests ===== */
+
+static char s_ring_buf[256];
+static log_ring_t s_ring;
+
+static size_t put_line(int n)
+{
+    size_t len = encode("I (%lu) %s: line %d\n", (unsigned long)n * 10, "test", n);
+    log_ring_write(&s_ring, (const char *)s_rec, len);
+    return len;
+}
+
+void test_log_record_read_from_ring(void)
+{
+    log_ring_init(&s_ring, s_ring_buf, sizeof(s_ring_buf));
+    for (int i = 0; i < 3; i++) {
+        put_line(i);
+    }
+
+    char out[256];
+    uint32_t lost = 1;
+    uint32_t cursor = 0;
+    uint32_t end = log_ring_cursor(&s_ring);
+    size_t n = log_record_read(&s_ring, &cursor, end, out, sizeof(out), &lost, is_static);
+    out[n] = '\0';
+    TEST_ASSERT_EQUAL_STRING("I (0) test: line 0\nI (10) test: line 1\nI (20) test: line 2\n", out);
+    TEST_ASSERT_EQUAL_INT(0, (int)lost);
+    TEST_ASSERT_EQUAL_INT((int)end, (int)cursor);
+
+    /* Nothing new */
+    TEST_ASSERT_EQUAL_INT(0, (int)log_record_read(&s_ring, &cursor, end, out, sizeof(out), &lost, is_static));
+}
+
+void test_log_record_read_whole_lines_only(void)
+{
+    log_ring_init(&s_ring, s_ring_buf, sizeof(s_ring_buf));
+    size_t first = put_line(1);
+    put_line(2);
+
+    char out[24];
+    uint32_t cursor = 0;
+    uint32_t end = log_ring_cursor(&s_ring);
+    size_t n = log_record_read(&s_ring, &cursor, end, out, sizeof(out), NULL, is_static);
+    out[n] = '\0';
+    TEST_ASSERT_EQUAL_STRING("I (10) test: line 1\n", out);
+    TEST_ASSERT_EQUAL_INT((int)first, (int)cursor);
+
+    n = log_record_read(&s_ring, &cursor, end, out, sizeof(out), NULL, is_static);
+    out[n] = '\0';
+    TEST_ASSERT_EQUAL_STRING("I (20) test: line 2\n", out);
+
+    /* A line longer than the buffer comes out cut rather than never */
+    char tiny[8];
+    cursor = 0;
+    n = log_record_read(&s_ring, &cursor, end, tiny, sizeof(tiny), NULL, is_static);
+    TEST_ASSERT_EQUAL_INT(7, (int)n);
+    TEST_ASSERT_EQUAL_INT((int)first, (int)cursor);
+}
+
+void test_log_record_read_resyncs_after_overwrite(void)
+{
+    log_ring_init(&s_ring, s_ring_buf, sizeof(s_ring_buf));
+    size_t len = 0;
+    for (int i = 0; i < 40; i++) {
+        len = put_line(i);
+    }
+
+    char out[512];
+    uint32_t lost = 0;
+    uint32_t cursor = 0;
+    uint32_t end = log_ring_cursor(&s_ring);
+    size_t n = log_record_read(&s_ring, &cursor, end, out, sizeof(out), &lost, is_static);
+    out[n] = '\0';
+
+    /* Held data starts mid-record: the partial record counts as lost */
+    uint32_t oldest = end - sizeof(s_ring_buf);
+    uint32_t first = (oldest + (uint32_t)len - 1) / (uint32_t)len;
+    TEST_ASSERT_EQUAL_INT((int)(first * len), (int)lost);
+    TEST_ASSERT_EQUAL_INT((int)end, (int)cursor);
+
+    char expected[512];
+    size_t e = 0;
+    for (uint32_t i = first; i < 40; i++) {
+        e += (size_t)snprintf(expected + e, sizeof(expected) - e, "I (%lu) test: line %lu\n",
+                              (unsigned long)i * 10, (unsigned long)i);
+    }
+    TEST_ASSERT_EQUAL_STRING(expected, out);
+
+    /* A cursor into the middle of a record skips to the next one */
+    cursor = (uint32_t)(first * len + 5);
+    n = log_record_read(&s_ring, &cursor, end, out, sizeof(out), &lost, is_static);
+    TEST_ASSERT_EQUAL_INT((int)(len - 5), (int)lost);
+    TEST_ASSERT_EQUAL_INT(0, memcmp(out, "I (", 3));
+}
+
+/* ===== Test Runner ===== */
+
+void run_log_record_tests(void)
+{
+    RUN_TEST(test_log_record_formats_like_printf);
+    RUN_TEST(test_log_record_copies_ram_strings);
+    RUN_TEST(test_log_record_smaller_than_text);
+    RUN_TEST(test_log_record_falls_back_to_text);
+    RUN_TEST(test_log_record_truncates_output);
+    RUN_TEST(test_log_record_rejects_damaged_headers);
+    RUN_TEST(test_log_record_tag);
+    RUN_TEST(test_log_record_read_from_ring);
+    RUN_TEST(test_log_record_read_whole_lines_only);
+    RUN_TEST(test_log_record_read_resyncs_after_overwrite);
+}
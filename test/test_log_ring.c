@@ -0,0 +1,320 @@
+/**
+ * @file test_log_ring.c
+ * @brief Unit tests for the log ring and its read cursors
+ */
+
+#include "unity.h"
+#include "log_ring.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+
+static char s_storage[16];
+static log_ring_t s_ring;
+
+static void ring_reset(void)
+{
+    memset(s_storage, 0, sizeof(s_storage));
+    log_ring_init(&s_ring, s_storage, sizeof(s_storage));
+}
+
+/* ===== Write/Read Tests ===== */
+
+void test_log_ring_read_from_start(void)
+{
+    ring_reset();
+    log_ring_write(&s_ring, "hello ", 6);
+    log_ring_write(&s_ring, "world", 5);
+
+    char out[32];
+    uint32_t cursor = 0;
+    uint32_t lost = 99;
+    size_t n = log_ring_read(&s_ring, &cursor, out, sizeof(out), &lost);
+    TEST_ASSERT_EQUAL_INT(11, n);
+    TEST_ASSERT_TRUE(memcmp(out, "hello world", 11) == 0);
+    TEST_ASSERT_EQUAL_INT(11, cursor);
+    TEST_ASSERT_EQUAL_INT(0, lost);
+
+    /* Nothing new */
+    TEST_ASSERT_EQUAL_INT(0, log_ring_read(&s_ring, &cursor, out, sizeof(out), &lost));
+    TEST_ASSERT_EQUAL_INT(11, cursor);
+}
+
+void test_log_ring_incremental_reads(void)
+{
+    ring_reset();
+    log_ring_write(&s_ring, "abcdef", 6);
+
+    char out[32];
+    uint32_t cursor = 0;
+    TEST_ASSERT_EQUAL_INT(4, log_ring_read(&s_ring, &cursor, out, 4, NULL));
+    TEST_ASSERT_TRUE(memcmp(out, "abcd", 4) == 0);
+    TEST_ASSERT_EQUAL_INT(4, cursor);
+
+    log_ring_write(&s_ring, "gh", 2);
+    TEST_ASSERT_EQUAL_INT(4, log_ring_read(&s_ring, &cursor, out, sizeof(out), NULL));
+    TEST_ASSERT_TRUE(memcmp(out, "efgh", 4) == 0);
+    TEST_ASSERT_EQUAL_INT(8, cursor);
+}
+
+void test_log_ring_wraps(void)
+{
+    ring_reset();
+    log_ring_write(&s_ring, "0123456789", 10);
+    uint32_t cursor = 10;
+    log_ring_write(&s_ring, "ABCDEFGHIJ", 10);  /* Wraps at index 16 */
+
+    char out[32];
+    uint32_t lost = 99;
+    TEST_ASSERT_EQUAL_INT(10, log_ring_read(&s_ring, &cursor, out, sizeof(out), &lost));
+    TEST_ASSERT_TRUE(memcmp(out, "ABCDEFGHIJ", 10) == 0);
+    TEST_ASSERT_EQUAL_INT(0, lost);
+    TEST_ASSERT_EQUAL_INT(16, log_ring_used(&s_ring));
+}
+
+void test_log_ring_reports_lost(void)
+{
+    ring_reset();
+    log_ring_write(&s_ring, "0123456789", 10);
+    log_ring_write(&s_ring, "ABCDEFGHIJ", 10);
+
+    /* 20 written, 16 held: the first 4 bytes are gone */
+    char out[32];
+    uint32_t cursor = 0;
+    uint32_t lost = 0;
+    TEST_ASSERT_EQUAL_INT(16, log_ring_read(&s_ring, &cursor, out, sizeof(out), &lost));
+    TEST_ASSERT_EQUAL_INT(4, lost);
+    TEST_ASSERT_TRUE(memcmp(out, "456789ABCDEFGHIJ", 16) == 0);
+    TEST_ASSERT_EQUAL_INT(20, cursor);
+}
+
+void test_log_ring_oversized_write(void)
+{
+    ring_reset();
+    log_ring_write(&s_ring, "abc", 3);
+    log_ring_write(&s_ring, "0123456789ABCDEFGHIJ", 20);
+    TEST_ASSERT_EQUAL_INT(23, s_ring.written);
+
+    char out[32];
+    uint32_t cursor = 3;
+    uint32_t lost = 0;
+    TEST_ASSERT_EQUAL_INT(16, log_ring_read(&s_ring, &cursor, out, sizeof(out), &lost));
+    TEST_ASSERT_EQUAL_INT(4, lost);
+    TEST_ASSERT_TRUE(memcmp(out, "456789ABCDEFGHIJ", 16) == 0);
+}
+
+/* ===== Cursor Edge Case Tests ===== */
+
+void test_log_ring_future_cursor_restarts(void)
+{
+    ring_reset();
+    log_ring_write(&s_ring, "new boot", 8);
+
+    /* Cursor saved before a reboot, past the current write position */
+    char out[32];
+    uint32_t cursor = 5000;
+    uint32_t lost = 99;
+    TEST_ASSERT_EQUAL_INT(8, log_ring_read(&s_ring, &cursor, out, sizeof(out), &lost));
+    TEST_ASSERT_TRUE(memcmp(out, "new boot", 8) == 0);
+    TEST_ASSERT_EQUAL_INT(8, cursor);
+    TEST_ASSERT_EQUAL_INT(0, lost);
+}
+
+void test_log_ring_clear_keeps_cursor_space(void)
+{
+    ring_reset();
+    log_ring_write(&s_ring, "abcdef", 6);
+    uint32_t cursor = 2;
+    log_ring_clear(&s_ring);
+    log_ring_write(&s_ring, "xy", 2);
+
+    char out[32];
+    uint32_t lost = 0;
+    TEST_ASSERT_EQUAL_INT(2, log_ring_read(&s_ring, &cursor, out, sizeof(out), &lost));
+    TEST_ASSERT_TRUE(memcmp(out, "xy", 2) == 0);
+    TEST_ASSERT_EQUAL_INT(4, lost);
+    TEST_ASSERT_EQUAL_INT(8, cursor);
+}
+
+void test_log_ring_cursor_wraparound(void)
+{
+    ring_reset();
+    s_ring.written = 0xFFFFFFFCu;  /* 4 bytes before the counter wraps */
+    s_ring.cleared = s_ring.written;
+    uint32_t cursor = s_ring.written;
+    log_ring_write(&s_ring, "abcdefgh", 8);
+    TEST_ASSERT_EQUAL_INT(4, s_ring.written);
+
+    char out[32];
+    uint32_t lost = 99;
+    TEST_ASSERT_EQUAL_INT(8, log_ring_read(&s_ring, &cursor, out, sizeof(out), &lost));
+    TEST_ASSERT_TRUE(memcmp(out, "abcdefgh", 8) == 0);
+    TEST_ASSERT_EQUAL_INT(4, cursor);
+    TEST_ASSERT_EQUAL_INT(0, lost);
+}
+
+/* ===== Concurrency Tests ===== */
+
+void test_log_ring_in_flight_line_holds_readers(void)
+{
+    ring_reset();
+    int slow = log_ring_begin(&s_ring);
+    TEST_ASSERT_TRUE(slow >= 0);
+    TEST_ASSERT_TRUE(log_ring_write(&s_ring, "fast", 4));
+
+    /* The slow line will land after "fast", but nothing past its claim is readable yet */
+    char out[32];
+    uint32_t cursor = 0;
+    TEST_ASSERT_EQUAL_INT(0, log_ring_cursor(&s_ring));
+    TEST_ASSERT_EQUAL_INT(0, log_ring_read(&s_ring, &cursor, out, sizeof(out), NULL));
+
+    log_ring_commit(&s_ring, slow, "slow", 4);
+    TEST_ASSERT_EQUAL_INT(8, log_ring_cursor(&s_ring));
+    TEST_ASSERT_EQUAL_INT(8, log_ring_read(&s_ring, &cursor, out, sizeof(out), NULL));
+    TEST_ASSERT_TRUE(memcmp(out, "fastslow", 8) == 0);
+}
+
+void test_log_ring_abandoned_writer_stops_holding_readers(void)
+{
+    ring_reset();
+    int stuck = log_ring_begin(&s_ring);
+    TEST_ASSERT_TRUE(stuck >= 0);
+    TEST_ASSERT_TRUE(log_ring_write(&s_ring, "0123456789", 10));
+    TEST_ASSERT_EQUAL_INT(0, log_ring_cursor(&s_ring));
+
+    /* A whole ring of output past its claim: readers stop waiting */
+    TEST_ASSERT_TRUE(log_ring_write(&s_ring, "abcdef", 6));
+    TEST_ASSERT_EQUAL_INT(16, log_ring_cursor(&s_ring));
+
+    char out[32];
+    uint32_t cursor = 0;
+    uint32_t lost = 1;
+    TEST_ASSERT_EQUAL_INT(16, log_ring_read(&s_ring, &cursor, out, sizeof(out), &lost));
+    TEST_ASSERT_TRUE(memcmp(out, "0123456789abcdef", 16) == 0);
+    TEST_ASSERT_EQUAL_INT(0, lost);
+
+    /* If it does finish, its line is readable like any other */
+    log_ring_commit(&s_ring, stuck, "late", 4);
+    TEST_ASSERT_EQUAL_INT(4, log_ring_read(&s_ring, &cursor, out, sizeof(out), &lost));
+    TEST_ASSERT_TRUE(memcmp(out, "late", 4) == 0);
+}
+
+void test_log_ring_drops_when_all_writers_busy(void)
+{
+    ring_reset();
+    int slots[LOG_RING_WRITERS];
+    for (int i = 0; i < LOG_RING_WRITERS; i++) {
+        slots[i] = log_ring_begin(&s_ring);
+        TEST_ASSERT_TRUE(slots[i] >= 0);
+    }
+    TEST_ASSERT_FALSE(log_ring_write(&s_ring, "lost", 4));
+    TEST_ASSERT_EQUAL_INT(1, s_ring.dropped);
+
+    log_ring_cancel(&s_ring, slots[3]);
+    TEST_ASSERT_TRUE(log_ring_write(&s_ring, "kept", 4));
+    for (int i = 0; i < LOG_RING_WRITERS; i++) {
+        if (i != 3) {
+            log_ring_cancel(&s_ring, slots[i]);
+        }
+    }
+
+    char out[32];
+    uint32_t cursor = 0;
+    TEST_ASSERT_EQUAL_INT(4, log_ring_read(&s_ring, &cursor, out, sizeof(out), NULL));
+    TEST_ASSERT_TRUE(memcmp(out, "kept", 4) == 0);
+}
+
+#define STRESS_WRITERS 4
+#define STRESS_LINES 5000
+#define STRESS_LINE_LEN 10      /* "w1 00042\n" and its NUL, so lines start at multiples of 10 */
+
+static char s_stress_storage[1024];
+static log_ring_t s_stress_ring;
+static atomic_int s_stress_done;
+
+static void *stress_writer(void *arg)
+{
+    int id = (int)(intptr_t)arg;
+    char line[STRESS_LINE_LEN + 1];
+    for (int seq = 0; seq < STRESS_LINES; seq++) {
+        snprintf(line, sizeof(line), "w%d %05d\n", id, seq);
+        log_ring_write(&s_stress_ring, line, STRESS_LINE_LEN);
+    }
+    atomic_fetch_add(&s_stress_done, 1);
+    return NULL;
+}
+
+/**
+ * @brief Check the whole lines in a chunk that starts at stream position pos
+ *
+ * Lines cut by the start or end of the chunk are skipped.
+ *
+ * @return Lines checked, -1 on a torn line or one out of order for its writer
+ */
+static int stress_check(const char *buf, size_t len, uint32_t pos, int last_seq[])
+{
+    int lines = 0;
+    size_t skip = (STRESS_LINE_LEN - pos % STRESS_LINE_LEN) % STRESS_LINE_LEN;
+    for (size_t off = skip; off + STRESS_LINE_LEN <= len; off += STRESS_LINE_LEN) {
+        int id, seq;
+        char nl;
+        if (sscanf(buf + off, "w%1d %5d%c", &id, &seq, &nl) != 3 || nl != '\n' ||
+            id < 0 || id >= STRESS_WRITERS || seq <= last_seq[id]) {
+            return -1;
+        }
+        last_seq[id] = seq;
+        lines++;
+    }
+    return lines;
+}
+
+void test_log_ring_concurrent_writers(void)
+{
+    log_ring_init(&s_stress_ring, s_stress_storage, sizeof(s_stress_storage));
+    atomic_store(&s_stress_done, 0);
+    pthread_t threads[STRESS_WRITERS];
+    for (int i = 0; i < STRESS_WRITERS; i++) {
+        pthread_create(&threads[i], NULL, stress_writer, (void *)(intptr_t)i);
+    }
+
+    /* Read alongside the writers: every line seen must be whole and in order */
+    static char out[sizeof(s_stress_storage) + STRESS_LINE_LEN];
+    int last_seq[STRESS_WRITERS] = { -1, -1, -1, -1 };
+    uint32_t cursor = 0;
+    bool ok = true;
+    int lines = 0;
+    bool finished = false;
+    while (!finished && ok) {
+        finished = (atomic_load(&s_stress_done) == STRESS_WRITERS);  /* Then one last read */
+        size_t n = log_ring_read(&s_stress_ring, &cursor, out, sizeof(out), NULL);
+        int got = stress_check(out, n, cursor - (uint32_t)n, last_seq);
+        ok = (got >= 0);
+        lines += got;
+    }
+    for (int i = 0; i < STRESS_WRITERS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    TEST_ASSERT_TRUE(ok);
+    TEST_ASSERT_EQUAL_INT(0, s_stress_ring.dropped);
+    TEST_ASSERT_EQUAL_INT(STRESS_WRITERS * STRESS_LINES * STRESS_LINE_LEN, s_stress_ring.written);
+    TEST_ASSERT_GREATER_THAN(0, lines);
+}
+
+/* ===== Test Runner ===== */
+
+void run_log_ring_tests(void)
+{
+    RUN_TEST(test_log_ring_read_from_start);
+    RUN_TEST(test_log_ring_incremental_reads);
+    RUN_TEST(test_log_ring_wraps);
+    RUN_TEST(test_log_ring_reports_lost);
+    RUN_TEST(test_log_ring_oversized_write);
+    RUN_TEST(test_log_ring_future_cursor_restarts);
+    RUN_TEST(test_log_ring_clear_keeps_cursor_space);
+    RUN_TEST(test_log_ring_cursor_wraparound);
+    RUN_TEST(test_log_ring_in_flight_line_holds_readers);
+    RUN_TEST(test_log_ring_abandoned_writer_stops_holding_readers);
+    RUN_TEST(test_log_ring_drops_when_all_writers_busy);
+    RUN_TEST(test_log_ring_concurrent_writers);
+}
@@ -0,0 +1,172 @@
+/**
+ * @file test_metrics_writer.c
+ * @brief Unit tests for the Prometheus text exposition writer
+ */
+
+#include "unity.h"
+#include "metrics_writer.h"
+#include <math.h>
+#include <string.h>
+
+static char s_buf[1024];
+static char s_sink_out[2048];
+static size_t s_sink_len;
+static int s_sink_calls;
+
+static int capture_sink(void *ctx, const char *data, size_t len)
+{
+    (void)ctx;
+    memcpy(s_sink_out + s_sink_len, data, len);
+    s_sink_len += len;
+    s_sink_calls++;
+    return 0;
+}
+
+static const char *sample(double value)
+{
+    metrics_writer_t w;
+    metrics_writer_init(&w, s_buf, sizeof(s_buf), NULL, NULL);
+    metrics_writer_sample(&w, "m", NULL, value);
+    return metrics_writer_finish(&w) < 0 ? NULL : s_buf;
+}
+
+/* ===== Sample Tests ===== */
+
+void test_metrics_family_and_samples(void)
+{
+    metrics_writer_t w;
+    metrics_writer_init(&w, s_buf, sizeof(s_buf), NULL, NULL);
+    metrics_writer_family(&w, "thermux_uptime_seconds", "gauge", "Time since boot");
+    metrics_writer_sample_uint(&w, "thermux_uptime_seconds", NULL, 3600);
+    metrics_writer_sample(&w, "thermux_temp", "{address=\"28FF\"}", 22.5625);
+    TEST_ASSERT_GREATER_THAN(0, metrics_writer_finish(&w));
+    TEST_ASSERT_EQUAL_STRING("# HELP thermux_uptime_seconds Time since boot\n"
+                             "# TYPE thermux_uptime_seconds gauge\n"
+                             "thermux_uptime_seconds 3600\n"
+                             "thermux_temp{address=\"28FF\"} 22.5625\n",
+                             s_buf);
+}
+
+void test_metrics_number_format(void)
+{
+    TEST_ASSERT_EQUAL_STRING("m 0\n", sample(0.0));
+    TEST_ASSERT_EQUAL_STRING("m 21.5\n", sample(21.5));
+    TEST_ASSERT_EQUAL_STRING("m -10.125\n", sample(-10.125));
+    TEST_ASSERT_EQUAL_STRING("m 0.0625\n", sample(0.0625));
+    TEST_ASSERT_EQUAL_STRING("m 125\n", sample(125.0));
+    TEST_ASSERT_EQUAL_STRING("m 1.2346\n", sample(1.23456));
+    TEST_ASSERT_EQUAL_STRING("m NaN\n", sample(NAN));
+    TEST_ASSERT_EQUAL_STRING("m +Inf\n", sample(INFINITY));
+}
+
+void test_metrics_uint_max(void)
+{
+    metrics_writer_t w;
+    metrics_writer_init(&w, s_buf, sizeof(s_buf), NULL, NULL);
+    metrics_writer_sample_uint(&w, "m", NULL, UINT64_MAX);
+    metrics_writer_finish(&w);
+    TEST_ASSERT_EQUAL_STRING("m 18446744073709551615\n", s_buf);
+}
+
+/* ===== Histogram Tests ===== */
+
+void test_metrics_histogram(void)
+{
+    static const double bounds[] = { 0.5, 1, 2 };
+    metrics_histogram_t h;
+    metrics_histogram_init(&h, bounds, 3);
+    metrics_histogram_observe(&h, 0.25);
+    metrics_histogram_observe(&h, 1.0);     /* le is inclusive */
+    metrics_histogram_observe(&h, 1.5);
+    metrics_histogram_observe(&h, 7.0);
+
+    metrics_writer_t w;
+    metrics_writer_init(&w, s_buf, sizeof(s_buf), NULL, NULL);
+    metrics_writer_histogram(&w, "cycle_seconds", &h);
+    TEST_ASSERT_GREATER_THAN(0, metrics_writer_finish(&w));
+    TEST_ASSERT_EQUAL_STRING("cycle_seconds_bucket{le=\"0.5\"} 1\n"
+                             "cycle_seconds_bucket{le=\"1\"} 2\n"
+                             "cycle_seconds_bucket{le=\"2\"} 3\n"
+                             "cycle_seconds_bucket{le=\"+Inf\"} 4\n"
+                             "cycle_seconds_sum 9.75\n"
+                             "cycle_seconds_count 4\n",
+                             s_buf);
+}
+
+/* ===== Label Tests ===== */
+
+void test_metrics_sensor_labels(void)
+{
+    char labels[METRICS_LABELS_MAX];
+    TEST_ASSERT_GREATER_THAN(0, metrics_format_sensor_labels(labels, sizeof(labels),
+                                                            "28FF1234567890AB", "Living Room"));
+    TEST_ASSERT_EQUAL_STRING("{address=\"28FF1234567890AB\",name=\"Living Room\"}", labels);
+}
+
+void test_metrics_sensor_labels_escaped(void)
+{
+    char labels[METRICS_LABELS_MAX];
+    metrics_format_sensor_labels(labels, sizeof(labels), "28FF1234567890AB", "Tank \"A\"\\\n");
+    TEST_ASSERT_EQUAL_STRING("{address=\"28FF1234567890AB\",name=\"Tank \\\"A\\\"\\\\\\n\"}", labels);
+}
+
+void test_metrics_sensor_labels_worst_case_fits(void)
+{
+    /* Longest friendly name made only of characters that need escaping */
+    char name[32];
+    memset(name, '"', 31);
+    name[31] = '\0';
+    char labels[METRICS_LABELS_MAX];
+    TEST_ASSERT_GREATER_THAN(0, metrics_format_sensor_labels(labels, sizeof(labels),
+                                                            "28FF1234567890AB", name));
+    char small[24];
+    TEST_ASSERT_EQUAL_INT(-1, metrics_format_sensor_labels(small, sizeof(small),
+                                                          "28FF1234567890AB", "x"));
+}
+
+/* ===== Output Mode Tests ===== */
+
+void test_metrics_overflow_fixed_buffer(void)
+{
+    char small[16];
+    metrics_writer_t w;
+    metrics_writer_init(&w, small, sizeof(small), NULL, NULL);
+    metrics_writer_sample_uint(&w, "a_long_metric_name", NULL, 1);
+    TEST_ASSERT_EQUAL_INT(-1, metrics_writer_finish(&w));
+}
+
+void test_metrics_chunked_sink(void)
+{
+    char small[16];
+    s_sink_len = 0;
+    s_sink_calls = 0;
+
+    metrics_writer_t w;
+    metrics_writer_init(&w, small, sizeof(small), capture_sink, NULL);
+    metrics_writer_family(&w, "thermux_free_heap_bytes", "gauge", "Free heap");
+    metrics_writer_sample_uint(&w, "thermux_free_heap_bytes", NULL, 123456);
+    int len = metrics_writer_finish(&w);
+
+    const char *expected = "# HELP thermux_free_heap_bytes Free heap\n"
+                           "# TYPE thermux_free_heap_bytes gauge\n"
+                           "thermux_free_heap_bytes 123456\n";
+    TEST_ASSERT_EQUAL_INT((int)strlen(expected), len);
+    TEST_ASSERT_GREATER_THAN(1, s_sink_calls);
+    s_sink_out[s_sink_len] = '\0';
+    TEST_ASSERT_EQUAL_STRING(expected, s_sink_out);
+}
+
+/* ===== Test Runner ===== */
+
+void run_metrics_writer_tests(void)
+{
+    RUN_TEST(test_metrics_family_and_samples);
+    RUN_TEST(test_metrics_number_format);
+    RUN_TEST(test_metrics_uint_max);
+    RUN_TEST(test_metrics_histogram);
+    RUN_TEST(test_metrics_sensor_labels);
+    RUN_TEST(test_metrics_sensor_labels_escaped);
+    RUN_TEST(test_metrics_sensor_labels_worst_case_fits);
+    RUN_TEST(test_metrics_overflow_fixed_buffer);
+    RUN_TEST(test_metrics_chunked_sink);
+}
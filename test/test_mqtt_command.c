@@ -0,0 +1,138 @@
+/**
+ * @file test_mqtt_command.c
+ * @brief Unit tests for MQTT command topic parsing
+ */
+
+#include "unity.h"
+#include "mqtt_command.h"
+#include <string.h>
+
+#define PREFIX "thermux/cmd/"
+
+static mqtt_cmd_status_t parse(const char *topic, const char *payload, mqtt_cmd_t *cmd)
+{
+    return mqtt_cmd_parse(PREFIX, topic, strlen(topic),
+                          payload, payload ? strlen(payload) : 0, cmd);
+}
+
+/* ===== Topic Tests ===== */
+
+void test_mqtt_cmd_interval_commands(void)
+{
+    mqtt_cmd_t cmd;
+    TEST_ASSERT_EQUAL_INT(MQTT_CMD_OK, parse(PREFIX "read_interval", "5000", &cmd));
+    TEST_ASSERT_EQUAL_INT(MQTT_CMD_READ_INTERVAL, cmd.type);
+    TEST_ASSERT_EQUAL_INT(5000, cmd.value);
+
+    TEST_ASSERT_EQUAL_INT(MQTT_CMD_OK, parse(PREFIX "publish_interval", " 60000\n", &cmd));
+    TEST_ASSERT_EQUAL_INT(MQTT_CMD_PUBLISH_INTERVAL, cmd.type);
+    TEST_ASSERT_EQUAL_INT(60000, cmd.value);
+}
+
+void test_mqtt_cmd_ignores_other_topics(void)
+{
+    mqtt_cmd_t cmd;
+    TEST_ASSERT_EQUAL_INT(MQTT_CMD_ERR_NOT_COMMAND, parse("thermux/status", "online", &cmd));
+    TEST_ASSERT_EQUAL_INT(MQTT_CMD_ERR_NOT_COMMAND, parse(PREFIX, "", &cmd));
+    TEST_ASSERT_EQUAL_INT(MQTT_CMD_ERR_NOT_COMMAND, parse("other/cmd/rescan", "", &cmd));
+}
+
+void test_mqtt_cmd_ignores_result_topic(void)
+{
+    mqtt_cmd_t cmd;
+    TEST_ASSERT_EQUAL_INT(MQTT_CMD_ERR_NOT_COMMAND,
+                          parse(PREFIX "result", "{\"command\":\"rescan\"}", &cmd));
+}
+
+void test_mqtt_cmd_unknown_command(void)
+{
+    mqtt_cmd_t cmd;
+    TEST_ASSERT_EQUAL_INT(MQTT_CMD_ERR_UNKNOWN, parse(PREFIX "reboot", "", &cmd));
+    TEST_ASSERT_EQUAL_INT(MQTT_CMD_ERR_UNKNOWN, parse(PREFIX "read_now/extra", "", &cmd));
+    TEST_ASSERT_EQUAL_INT(MQTT_CMD_ERR_UNKNOWN, parse(PREFIX "read", "", &cmd));
+}
+
+void test_mqtt_cmd_topic_not_terminated(void)
+{
+    /* Topics from the MQTT client are length-delimited, not NUL-terminated */
+    const char *topic = PREFIX "rescanXYZ";
+    mqtt_cmd_t cmd;
+    TEST_ASSERT_EQUAL_INT(MQTT_CMD_OK,
+                          mqtt_cmd_parse(PREFIX, topic, strlen(PREFIX "rescan"), NULL, 0, &cmd));
+    TEST_ASSERT_EQUAL_INT(MQTT_CMD_RESCAN, cmd.type);
+}
+
+/* ===== Argument Tests ===== */
+
+void test_mqtt_cmd_rejects_bad_numbers(void)
+{
+    mqtt_cmd_t cmd;
+    TEST_ASSERT_EQUAL_INT(MQTT_CMD_ERR_INVALID_VALUE, parse(PREFIX "read_interval", "", &cmd));
+    TEST_ASSERT_EQUAL_INT(MQTT_CMD_READ_INTERVAL, cmd.type);
+    TEST_ASSERT_EQUAL_INT(MQTT_CMD_ERR_INVALID_VALUE, parse(PREFIX "read_interval", "-5", &cmd));
+    TEST_ASSERT_EQUAL_INT(MQTT_CMD_ERR_INVALID_VALUE, parse(PREFIX "read_interval", "10s", &cmd));
+    TEST_ASSERT_EQUAL_INT(MQTT_CMD_ERR_INVALID_VALUE, parse(PREFIX "read_interval", "99999999999", &cmd));
+}
+
+void test_mqtt_cmd_resolution_range(void)
+{
+    mqtt_cmd_t cmd;
+    TEST_ASSERT_EQUAL_INT(MQTT_CMD_OK, parse(PREFIX "resolution", "9", &cmd));
+    TEST_ASSERT_EQUAL_INT(9, cmd.value);
+    TEST_ASSERT_EQUAL_INT(MQTT_CMD_OK, parse(PREFIX "resolution", "12", &cmd));
+    TEST_ASSERT_EQUAL_INT(MQTT_CMD_ERR_INVALID_VALUE, parse(PREFIX "resolution", "8", &cmd));
+    TEST_ASSERT_EQUAL_INT(MQTT_CMD_ERR_INVALID_VALUE, parse(PREFIX "resolution", "13", &cmd));
+}
+
+void test_mqtt_cmd_actions_ignore_payload(void)
+{
+    mqtt_cmd_t cmd;
+    TEST_ASSERT_EQUAL_INT(MQTT_CMD_OK, parse(PREFIX "read_now", NULL, &cmd));
+    TEST_ASSERT_EQUAL_INT(MQTT_CMD_READ_NOW, cmd.type);
+    TEST_ASSERT_EQUAL_INT(MQTT_CMD_OK, parse(PREFIX "rescan", "anything", &cmd));
+    TEST_ASSERT_EQUAL_INT(MQTT_CMD_RESCAN, cmd.type);
+}
+
+void test_mqtt_cmd_reset_error_stats_all(void)
+{
+    mqtt_cmd_t cmd;
+    TEST_ASSERT_EQUAL_INT(MQTT_CMD_OK, parse(PREFIX "reset_error_stats", "", &cmd));
+    TEST_ASSERT_EQUAL_INT(MQTT_CMD_RESET_ERROR_STATS, cmd.type);
+    TEST_ASSERT_EQUAL_STRING("", cmd.address);
+}
+
+void test_mqtt_cmd_reset_error_stats_sensor(void)
+{
+    mqtt_cmd_t cmd;
+    TEST_ASSERT_EQUAL_INT(MQTT_CMD_OK, parse(PREFIX "reset_error_stats", "28ff1234567890ab", &cmd));
+    TEST_ASSERT_EQUAL_STRING("28FF1234567890AB", cmd.address);
+
+    TEST_ASSERT_EQUAL_INT(MQTT_CMD_ERR_INVALID_VALUE,
+                          parse(PREFIX "reset_error_stats", "28FF12345678", &cmd));
+    TEST_ASSERT_EQUAL_INT(MQTT_CMD_ERR_INVALID_VALUE,
+                          parse(PREFIX "reset_error_stats", "28FF1234567890AZ", &cmd));
+}
+
+void test_mqtt_cmd_names(void)
+{
+    TEST_ASSERT_EQUAL_STRING("read_interval", mqtt_cmd_name(MQTT_CMD_READ_INTERVAL));
+    TEST_ASSERT_EQUAL_STRING("read_now", mqtt_cmd_name(MQTT_CMD_READ_NOW));
+    TEST_ASSERT_EQUAL_STRING("unknown", mqtt_cmd_name(MQTT_CMD_NONE));
+}
+
+/* ===== Test Runner ===== */
+
+void run_mqtt_command_tests(void)
+{
+    RUN_TEST(test_mqtt_cmd_interval_commands);
+    RUN_TEST(test_mqtt_cmd_ignores_other_topics);
+    RUN_TEST(test_mqtt_cmd_ignores_result_topic);
+    RUN_TEST(test_mqtt_cmd_unknown_command);
+    RUN_TEST(test_mqtt_cmd_topic_not_terminated);
+    RUN_TEST(test_mqtt_cmd_rejects_bad_numbers);
+    RUN_TEST(test_mqtt_cmd_resolution_range);
+    RUN_TEST(test_mqtt_cmd_actions_ignore_payload);
+    RUN_TEST(test_mqtt_cmd_reset_error_stats_all);
+    RUN_TEST(test_mqtt_cmd_reset_error_stats_sensor);
+    RUN_TEST(test_mqtt_cmd_names);
+}
@@ -0,0 +1,117 @@
+/**
+ * @file test_ota_manifest.c
+ * @brief Unit tests for the mirror manifest, digest parsing and URL resolution
+ */
+
+#include "unity.h"
+#include "ota_manifest.h"
+#include <string.h>
+
+#define DIGEST_HEX "9f86d081884c7d659a2feaa0c55ad015a3bf4f1b2b0b822cd15d6c15b0f00a08"
+
+static const uint8_t DIGEST[SHA256_DIGEST_SIZE] = {
+    0x9f, 0x86, 0xd0, 0x81, 0x88, 0x4c, 0x7d, 0x65, 0x9a, 0x2f, 0xea, 0xa0, 0xc5, 0x5a, 0xd0, 0x15,
+    0xa3, 0xbf, 0x4f, 0x1b, 0x2b, 0x0b, 0x82, 0x2c, 0xd1, 0x5d, 0x6c, 0x15, 0xb0, 0xf0, 0x0a, 0x08,
+};
+
+static const char MANIFEST[] =
+    "{\"version\": \"2.8.0\", \"image\": \"thermux.bin.gz\", \"size\": 1146880,\n"
+    " \"sha256\": \"" DIGEST_HEX "\",\n"
+    " \"deltas\": [\"thermux-from-2.6.0.delta\", \"old/thermux-from-2.7.0.delta\"]}\n";
+
+static ota_manifest_t s_manifest;
+
+static int parse(const char *doc, size_t piece)
+{
+    ota_manifest_init(&s_manifest, "thermux-from-2.7.0.delta");
+    size_t len = strlen(doc);
+    for (size_t off = 0; off < len; off += piece) {
+        size_t n = len - off < piece ? len - off : piece;
+        ota_manifest_feed(&s_manifest, doc + off, n);
+    }
+    return ota_manifest_finish(&s_manifest);
+}
+
+/* ===== Manifest Tests ===== */
+
+void test_ota_manifest_parses_fields(void)
+{
+    TEST_ASSERT_EQUAL_INT(OTA_MANIFEST_OK, parse(MANIFEST, 13));
+    TEST_ASSERT_EQUAL_STRING("2.8.0", s_manifest.version);
+    TEST_ASSERT_EQUAL_STRING("thermux.bin.gz", s_manifest.image);
+    TEST_ASSERT_EQUAL_STRING("old/thermux-from-2.7.0.delta", s_manifest.delta);
+    TEST_ASSERT_TRUE(memcmp(DIGEST, s_manifest.sha256, SHA256_DIGEST_SIZE) == 0);
+}
+
+void test_ota_manifest_without_matching_delta(void)
+{
+    TEST_ASSERT_EQUAL_INT(OTA_MANIFEST_OK,
+                          parse("{\"version\":\"2.8.0\",\"image\":\"a.bin\",\"sha256\":\"" DIGEST_HEX "\","
+                                "\"deltas\":[\"thermux-from-2.7.1.delta\"]}", 64));
+    TEST_ASSERT_EQUAL_STRING("", s_manifest.delta);
+}
+
+void test_ota_manifest_requires_digest(void)
+{
+    TEST_ASSERT_EQUAL_INT(OTA_MANIFEST_ERR_FIELD, parse("{\"version\":\"2.8.0\",\"image\":\"a.bin\"}", 64));
+    TEST_ASSERT_EQUAL_INT(OTA_MANIFEST_ERR_FIELD,
+                          parse("{\"version\":\"2.8.0\",\"image\":\"a.bin\",\"sha256\":\"9f86\"}", 64));
+    TEST_ASSERT_EQUAL_INT(OTA_MANIFEST_ERR_FIELD, parse("{\"image\":\"a.bin\",\"sha256\":\"" DIGEST_HEX "\"}", 64));
+    TEST_ASSERT_EQUAL_INT(OTA_MANIFEST_ERR_JSON, parse("{\"version\":\"2.8.0\",\"image\":", 64));
+    TEST_ASSERT_EQUAL_INT(OTA_MANIFEST_ERR_JSON, parse("<html>404</html>", 64));
+}
+
+/* ===== Digest Tests ===== */
+
+void test_ota_sha256_parse(void)
+{
+    uint8_t digest[SHA256_DIGEST_SIZE];
+    TEST_ASSERT_TRUE(ota_sha256_parse(DIGEST_HEX, digest));
+    TEST_ASSERT_TRUE(memcmp(DIGEST, digest, SHA256_DIGEST_SIZE) == 0);
+
+    memset(digest, 0, sizeof(digest));
+    TEST_ASSERT_TRUE(ota_sha256_parse("sha256:9F86D081884C7D659A2FEAA0C55AD015A3BF4F1B2B0B822CD15D6C15B0F00A08",
+                                      digest));
+    TEST_ASSERT_TRUE(memcmp(DIGEST, digest, SHA256_DIGEST_SIZE) == 0);
+
+    TEST_ASSERT_FALSE(ota_sha256_parse("", digest));
+    TEST_ASSERT_FALSE(ota_sha256_parse("sha1:" DIGEST_HEX, digest));
+    TEST_ASSERT_FALSE(ota_sha256_parse(DIGEST_HEX "00", digest));
+    TEST_ASSERT_FALSE(ota_sha256_parse("zz86d081884c7d659a2feaa0c55ad015a3bf4f1b2b0b822cd15d6c15b0f00a08", digest));
+}
+
+/* ===== URL Tests ===== */
+
+void test_ota_url_resolve(void)
+{
+    char url[96];
+    TEST_ASSERT_TRUE(ota_url_resolve("http://10.0.0.5:8070/fw/manifest.json", "thermux.bin.gz", url, sizeof(url)));
+    TEST_ASSERT_EQUAL_STRING("http://10.0.0.5:8070/fw/thermux.bin.gz", url);
+    TEST_ASSERT_TRUE(ota_url_resolve("http://10.0.0.5:8070/fw/manifest.json", "old/a.delta", url, sizeof(url)));
+    TEST_ASSERT_EQUAL_STRING("http://10.0.0.5:8070/fw/old/a.delta", url);
+    TEST_ASSERT_TRUE(ota_url_resolve("http://10.0.0.5:8070/fw/manifest.json", "/other/a.bin", url, sizeof(url)));
+    TEST_ASSERT_EQUAL_STRING("http://10.0.0.5:8070/other/a.bin", url);
+    TEST_ASSERT_TRUE(ota_url_resolve("http://mirror", "a.bin", url, sizeof(url)));
+    TEST_ASSERT_EQUAL_STRING("http://mirror/a.bin", url);
+    TEST_ASSERT_TRUE(ota_url_resolve("http://mirror/fw/m.json", "https://cdn.example.com/a.bin", url, sizeof(url)));
+    TEST_ASSERT_EQUAL_STRING("https://cdn.example.com/a.bin", url);
+}
+
+void test_ota_url_resolve_rejects(void)
+{
+    char url[24];
+    TEST_ASSERT_FALSE(ota_url_resolve("manifest.json", "a.bin", url, sizeof(url)));
+    TEST_ASSERT_FALSE(ota_url_resolve("http://10.0.0.5/fw/m.json", "thermux.bin.gz", url, sizeof(url)));
+}
+
+/* ===== Test Runner ===== */
+
+void run_ota_manifest_tests(void)
+{
+    RUN_TEST(test_ota_manifest_parses_fields);
+    RUN_TEST(test_ota_manifest_without_matching_delta);
+    RUN_TEST(test_ota_manifest_requires_digest);
+    RUN_TEST(test_ota_sha256_parse);
+    RUN_TEST(test_ota_url_resolve);
+    RUN_TEST(test_ota_url_resolve_rejects);
+}
@@ -0,0 +1,140 @@
+/**
+ * @file test_rate_limit.c
+ * @brief Unit tests for per-client token buckets
+ */
+
+#include "unity.h"
+#include "rate_limit.h"
+
+static rate_limiter_t s_rl;
+
+static void limiter_reset(void)
+{
+    static const rate_limit_rule_t rules[RATE_CLASS_COUNT] = {
+        [RATE_CLASS_READ]  = { .per_minute = 60, .burst = 3 },
+        [RATE_CLASS_WRITE] = { .per_minute = 0,  .burst = 0 },
+        [RATE_CLASS_SCAN]  = { .per_minute = 2,  .burst = 1 },
+    };
+    rate_limit_init(&s_rl, rules);
+}
+
+/* ===== Token Bucket Tests ===== */
+
+void test_rate_limit_burst_then_reject(void)
+{
+    limiter_reset();
+    uint32_t retry = 0;
+    TEST_ASSERT_TRUE(rate_limit_allow(&s_rl, 1, RATE_CLASS_READ, 1000, &retry));
+    TEST_ASSERT_TRUE(rate_limit_allow(&s_rl, 1, RATE_CLASS_READ, 1000, &retry));
+    TEST_ASSERT_TRUE(rate_limit_allow(&s_rl, 1, RATE_CLASS_READ, 1000, &retry));
+    TEST_ASSERT_FALSE(rate_limit_allow(&s_rl, 1, RATE_CLASS_READ, 1000, &retry));
+    TEST_ASSERT_EQUAL_INT(1, retry);
+    TEST_ASSERT_EQUAL_INT(1, s_rl.rejected[RATE_CLASS_READ]);
+}
+
+void test_rate_limit_refills_over_time(void)
+{
+    limiter_reset();
+    for (int i = 0; i < 3; i++) {
+        rate_limit_allow(&s_rl, 1, RATE_CLASS_READ, 0, NULL);
+    }
+    /* One per second: half a second is not enough */
+    TEST_ASSERT_FALSE(rate_limit_allow(&s_rl, 1, RATE_CLASS_READ, 500, NULL));
+    TEST_ASSERT_TRUE(rate_limit_allow(&s_rl, 1, RATE_CLASS_READ, 1000, NULL));
+    TEST_ASSERT_FALSE(rate_limit_allow(&s_rl, 1, RATE_CLASS_READ, 1000, NULL));
+
+    /* A long pause refills only up to the burst */
+    for (int i = 0; i < 3; i++) {
+        TEST_ASSERT_TRUE(rate_limit_allow(&s_rl, 1, RATE_CLASS_READ, 600000, NULL));
+    }
+    TEST_ASSERT_FALSE(rate_limit_allow(&s_rl, 1, RATE_CLASS_READ, 600000, NULL));
+}
+
+void test_rate_limit_retry_after(void)
+{
+    limiter_reset();
+    uint32_t retry = 0;
+    TEST_ASSERT_TRUE(rate_limit_allow(&s_rl, 1, RATE_CLASS_SCAN, 0, &retry));
+    TEST_ASSERT_FALSE(rate_limit_allow(&s_rl, 1, RATE_CLASS_SCAN, 0, &retry));
+    TEST_ASSERT_EQUAL_INT(30, retry);
+    TEST_ASSERT_FALSE(rate_limit_allow(&s_rl, 1, RATE_CLASS_SCAN, 20500, &retry));
+    TEST_ASSERT_EQUAL_INT(10, retry);
+    TEST_ASSERT_TRUE(rate_limit_allow(&s_rl, 1, RATE_CLASS_SCAN, 30000, &retry));
+}
+
+void test_rate_limit_unlimited_class(void)
+{
+    limiter_reset();
+    for (int i = 0; i < 100; i++) {
+        TEST_ASSERT_TRUE(rate_limit_allow(&s_rl, 1, RATE_CLASS_WRITE, 0, NULL));
+    }
+    TEST_ASSERT_EQUAL_INT(0, s_rl.rejected[RATE_CLASS_WRITE]);
+}
+
+/* ===== Client Table Tests ===== */
+
+void test_rate_limit_classes_are_independent(void)
+{
+    limiter_reset();
+    TEST_ASSERT_TRUE(rate_limit_allow(&s_rl, 1, RATE_CLASS_SCAN, 0, NULL));
+    TEST_ASSERT_FALSE(rate_limit_allow(&s_rl, 1, RATE_CLASS_SCAN, 0, NULL));
+    TEST_ASSERT_TRUE(rate_limit_allow(&s_rl, 1, RATE_CLASS_READ, 0, NULL));
+}
+
+void test_rate_limit_clients_are_independent(void)
+{
+    limiter_reset();
+    TEST_ASSERT_TRUE(rate_limit_allow(&s_rl, 1, RATE_CLASS_SCAN, 0, NULL));
+    TEST_ASSERT_FALSE(rate_limit_allow(&s_rl, 1, RATE_CLASS_SCAN, 0, NULL));
+    TEST_ASSERT_TRUE(rate_limit_allow(&s_rl, 2, RATE_CLASS_SCAN, 0, NULL));
+}
+
+void test_rate_limit_evicts_least_recent(void)
+{
+    limiter_reset();
+    /* Client 1 spends its scan token, then RATE_LIMIT_CLIENTS newer clients arrive */
+    rate_limit_allow(&s_rl, 1, RATE_CLASS_SCAN, 0, NULL);
+    for (uint32_t i = 0; i < RATE_LIMIT_CLIENTS - 1; i++) {
+        rate_limit_allow(&s_rl, 100 + i, RATE_CLASS_READ, 10 + i, NULL);
+    }
+    /* Table full, client 1 still tracked */
+    TEST_ASSERT_FALSE(rate_limit_allow(&s_rl, 1, RATE_CLASS_SCAN, 100, NULL));
+
+    /* Client 100 is now the least recent and gets replaced, client 1 stays */
+    rate_limit_allow(&s_rl, 200, RATE_CLASS_READ, 200, NULL);
+    TEST_ASSERT_FALSE(rate_limit_allow(&s_rl, 1, RATE_CLASS_SCAN, 300, NULL));
+    for (int i = 0; i < RATE_LIMIT_CLIENTS; i++) {
+        TEST_ASSERT_TRUE(!s_rl.clients[i].used || s_rl.clients[i].key != 100);
+    }
+}
+
+void test_rate_limit_clock_wrap(void)
+{
+    limiter_reset();
+    rate_limit_allow(&s_rl, 1, RATE_CLASS_SCAN, 0xFFFFF000u, NULL);
+    TEST_ASSERT_FALSE(rate_limit_allow(&s_rl, 1, RATE_CLASS_SCAN, 0xFFFFF000u, NULL));
+    /* 30 s later, across the wrap */
+    TEST_ASSERT_TRUE(rate_limit_allow(&s_rl, 1, RATE_CLASS_SCAN, 0xFFFFF000u + 30000u, NULL));
+}
+
+void test_rate_limit_class_names(void)
+{
+    TEST_ASSERT_EQUAL_STRING("read", rate_limit_class_name(RATE_CLASS_READ));
+    TEST_ASSERT_EQUAL_STRING("write", rate_limit_class_name(RATE_CLASS_WRITE));
+    TEST_ASSERT_EQUAL_STRING("scan", rate_limit_class_name(RATE_CLASS_SCAN));
+}
+
+/* ===== Test Runner ===== */
+
+void run_rate_limit_tests(void)
+{
+    RUN_TEST(test_rate_limit_burst_then_reject);
+    RUN_TEST(test_rate_limit_refills_over_time);
+    RUN_TEST(test_rate_limit_retry_after);
+    RUN_TEST(test_rate_limit_unlimited_class);
+    RUN_TEST(test_rate_limit_classes_are_independent);
+    RUN_TEST(test_rate_limit_clients_are_independent);
+    RUN_TEST(test_rate_limit_evicts_least_recent);
+    RUN_TEST(test_rate_limit_clock_wrap);
+    RUN_TEST(test_rate_limit_class_names);
+}
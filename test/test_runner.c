@@ -11,6 +11,29 @@ extern void run_address_tests(void);
 extern void run_mqtt_tests(void);
 extern void run_config_tests(void);
 extern void run_nvs_tests(void);
+extern void run_json_writer_tests(void);
+extern void run_store_forward_tests(void);
+extern void run_mqtt_command_tests(void);
+extern void run_ha_discovery_tests(void);
+extern void run_telemetry_cbor_tests(void);
+extern void run_ws_protocol_tests(void);
+extern void run_http_etag_tests(void);
+extern void run_dashboard_tests(void);
+extern void run_metrics_writer_tests(void);
+extern void run_log_ring_tests(void);
+extern void run_log_record_tests(void);
+extern void run_log_filter_tests(void);
+extern void run_sha256_tests(void);
+extern void run_auth_session_tests(void);
+extern void run_rate_limit_tests(void);
+extern void run_history_tests(void);
+extern void run_history_export_tests(void);
+extern void run_flash_stream_tests(void);
+extern void run_gunzip_tests(void);
+extern void run_delta_patch_tests(void);
+extern void run_json_scan_tests(void);
+extern void run_boot_health_tests(void);
+extern void run_ota_manifest_tests(void);
 
 int main(void)
 {
@@ -31,6 +54,75 @@ int main(void)
     printf("\n[NVS Utilities Tests]\n");
     run_nvs_tests();
     
+    printf("\n[JSON Writer Tests]\n");
+    run_json_writer_tests();
+    
+    printf("\n[Store-and-Forward Tests]\n");
+    run_store_forward_tests();
+    
+    printf("\n[MQTT Command Tests]\n");
+    run_mqtt_command_tests();
+    
+    printf("\n[HA Discovery Tests]\n");
+    run_ha_discovery_tests();
+    
+    printf("\n[CBOR Telemetry Tests]\n");
+    run_telemetry_cbor_tests();
+    
+    printf("\n[WebSocket Protocol Tests]\n");
+    run_ws_protocol_tests();
+    
+    printf("\n[HTTP ETag Tests]\n");
+    run_http_etag_tests();
+    
+    printf("\n[Dashboard Tests]\n");
+    run_dashboard_tests();
+    
+    printf("\n[Metrics Writer Tests]\n");
+    run_metrics_writer_tests();
+    
+    printf("\n[Log Ring Tests]\n");
+    run_log_ring_tests();
+    
+    printf("\n[Log Record Tests]\n");
+    run_log_record_tests();
+    
+    printf("\n[Log Filter Tests]\n");
+    run_log_filter_tests();
+    
+    printf("\n[SHA-256 Tests]\n");
+    run_sha256_tests();
+    
+    printf("\n[Auth Session Tests]\n");
+    run_auth_session_tests();
+    
+    printf("\n[Rate Limit Tests]\n");
+    run_rate_limit_tests();
+    
+    printf("\n[History Tests]\n");
+    run_history_tests();
+    
+    printf("\n[History Export Tests]\n");
+    run_history_export_tests();
+    
+    printf("\n[Flash Stream Tests]\n");
+    run_flash_stream_tests();
+    
+    printf("\n[Gunzip Tests]\n");
+    run_gunzip_tests();
+    
+    printf("\n[Delta Patch Tests]\n");
+    run_delta_patch_tests();
+    
+    printf("\n[JSON Scan Tests]\n");
+    run_json_scan_tests();
+    
+    printf("\n[Boot Health Tests]\n");
+    run_boot_health_tests();
+    
+    printf("\n[OTA Manifest Tests]\n");
+    run_ota_manifest_tests();
+    
     UNITY_END();
     
     return unity_tests_failed > 0 ? 1 : 0;
@@ -0,0 +1,139 @@
+/**
+ * @file test_sha256.c
+ * @brief Unit tests for SHA-256 and HMAC-SHA256 (FIPS 180-4 / RFC 4231 vectors)
+ *
+ * Checks the host stand-in for mbedtls that the other host tests hash with.
+ */
+
+#include "unity.h"
+#include "mbedtls/sha256.h"
+#include "mbedtls/md.h"
+#include <stdio.h>
+#include <string.h>
+
+#define SHA256_DIGEST_SIZE 32
+
+static void to_hex(const uint8_t *digest, char *out)
+{
+    for (int i = 0; i < SHA256_DIGEST_SIZE; i++) {
+        sprintf(out + i * 2, "%02x", digest[i]);
+    }
+}
+
+static void check_sha256(const void *data, size_t len, const char *expected)
+{
+    uint8_t digest[SHA256_DIGEST_SIZE];
+    char hex[SHA256_DIGEST_SIZE * 2 + 1];
+
+    TEST_ASSERT_EQUAL_INT(0, mbedtls_sha256(data, len, digest, 0));
+    to_hex(digest, hex);
+    TEST_ASSERT_EQUAL_STRING(expected, hex);
+}
+
+/* ===== SHA-256 Tests ===== */
+
+void test_sha256_empty(void)
+{
+    check_sha256("", 0, "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+}
+
+void test_sha256_abc(void)
+{
+    check_sha256("abc", 3, "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+}
+
+void test_sha256_two_blocks(void)
+{
+    /* 56 bytes: the length no longer fits in the first padded block */
+    const char *msg = "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq";
+    check_sha256(msg, strlen(msg), "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1");
+}
+
+void test_sha256_split_updates(void)
+{
+    uint8_t data[1024];
+    for (size_t i = 0; i < sizeof(data); i++) {
+        data[i] = (uint8_t)i;
+    }
+
+    /* Uneven pieces straddling block boundaries give the one-shot result */
+    mbedtls_sha256_context ctx;
+    uint8_t digest[SHA256_DIGEST_SIZE];
+    char hex[SHA256_DIGEST_SIZE * 2 + 1];
+    static const size_t pieces[] = { 1, 63, 64, 65, 7, 300, 524 };
+    size_t offset = 0;
+    mbedtls_sha256_init(&ctx);
+    mbedtls_sha256_starts(&ctx, 0);
+    for (size_t i = 0; i < sizeof(pieces) / sizeof(pieces[0]); i++) {
+        mbedtls_sha256_update(&ctx, data + offset, pieces[i]);
+        offset += pieces[i];
+    }
+    TEST_ASSERT_EQUAL_INT(1024, offset);
+
+    /* A clone finishes on its own, leaving the original open */
+    mbedtls_sha256_context prefix;
+    mbedtls_sha256_init(&prefix);
+    mbedtls_sha256_clone(&prefix, &ctx);
+    mbedtls_sha256_finish(&prefix, digest);
+    mbedtls_sha256_free(&prefix);
+    to_hex(digest, hex);
+    TEST_ASSERT_EQUAL_STRING("785b0751fc2c53dc14a4ce3d800e69ef9ce1009eb327ccf458afe09c242c26c9", hex);
+
+    mbedtls_sha256_finish(&ctx, digest);
+    mbedtls_sha256_free(&ctx);
+    to_hex(digest, hex);
+    TEST_ASSERT_EQUAL_STRING("785b0751fc2c53dc14a4ce3d800e69ef9ce1009eb327ccf458afe09c242c26c9", hex);
+
+    check_sha256(data, sizeof(data), "785b0751fc2c53dc14a4ce3d800e69ef9ce1009eb327ccf458afe09c242c26c9");
+}
+
+/* ===== HMAC Tests ===== */
+
+static void hmac_sha256(const uint8_t *key, size_t key_len, const void *data, size_t len,
+                        uint8_t mac[SHA256_DIGEST_SIZE])
+{
+    TEST_ASSERT_EQUAL_INT(0, mbedtls_md_hmac(mbedtls_md_info_from_type(MBEDTLS_MD_SHA256),
+                                             key, key_len, data, len, mac));
+}
+
+void test_hmac_sha256_rfc4231(void)
+{
+    uint8_t mac[SHA256_DIGEST_SIZE];
+    char hex[SHA256_DIGEST_SIZE * 2 + 1];
+
+    uint8_t key1[20];
+    memset(key1, 0x0b, sizeof(key1));
+    hmac_sha256(key1, sizeof(key1), "Hi There", 8, mac);
+    to_hex(mac, hex);
+    TEST_ASSERT_EQUAL_STRING("b0344c61d8db38535ca8afceaf0bf12b881dc200c9833da726e9376c2e32cff7", hex);
+
+    const char *data2 = "what do ya want for nothing?";
+    hmac_sha256((const uint8_t *)"Jefe", 4, data2, strlen(data2), mac);
+    to_hex(mac, hex);
+    TEST_ASSERT_EQUAL_STRING("5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec3843", hex);
+}
+
+void test_hmac_sha256_long_key(void)
+{
+    uint8_t key[131];
+    memset(key, 0xaa, sizeof(key));
+    const char *data = "Test Using Larger Than Block-Size Key - Hash Key First";
+    uint8_t mac[SHA256_DIGEST_SIZE];
+    char hex[SHA256_DIGEST_SIZE * 2 + 1];
+
+    hmac_sha256(key, sizeof(key), data, strlen(data), mac);
+    to_hex(mac, hex);
+    TEST_ASSERT_EQUAL_STRING("60e431591ee0b67f0d8a26aacbf5b77f8e0bc6213728c5140546040f0ee37f54", hex);
+}
+
+/* ===== Test Runner ===== */
+
+void run_sha256_tests(void)
+{
+    RUN_TEST(test_sha256_empty);
+    RUN_TEST(test_sha256_abc);
+    RUN_TEST(test_sha256_two_blocks);
+    RUN_TEST(test_sha256_split_updates);
+    RUN_TEST(test_hmac_sha256_rfc4231);
+    RUN_TEST(test_hmac_sha256_long_key);
+}
@@ -0,0 +1,307 @@
+/**
+ * @file test_store_forward.c
+ * @brief Unit tests for the store-and-forward reading queue
+ */
+
+#include "unity.h"
+#include "store_forward.h"
+#include <string.h>
+
+#define TEST_RAM 8
+#define TEST_SEG 4
+#define TEST_MAX_SEGMENTS 3
+
+/* ===== In-memory flash backend ===== */
+
+typedef struct {
+    store_forward_record_t segments[16][TEST_SEG];
+    size_t counts[16];
+    bool present[16];
+    uint32_t head, tail;
+    bool has_range;
+    bool fail_writes;
+    int writes;
+} mem_flash_t;
+
+static int mem_load_range(void *ctx, uint32_t *head, uint32_t *tail)
+{
+    mem_flash_t *f = ctx;
+    if (!f->has_range) {
+        return -1;
+    }
+    *head = f->head;
+    *tail = f->tail;
+    return 0;
+}
+
+static int mem_save_range(void *ctx, uint32_t head, uint32_t tail)
+{
+    mem_flash_t *f = ctx;
+    f->head = head;
+    f->tail = tail;
+    f->has_range = true;
+    return 0;
+}
+
+static int mem_write(void *ctx, uint32_t seq, const store_forward_record_t *records, size_t count)
+{
+    mem_flash_t *f = ctx;
+    if (f->fail_writes) {
+        return -1;
+    }
+    memcpy(f->segments[seq % 16], records, count * sizeof(*records));
+    f->counts[seq % 16] = count;
+    f->present[seq % 16] = true;
+    f->writes++;
+    return 0;
+}
+
+static int mem_read(void *ctx, uint32_t seq, store_forward_record_t *records, size_t max, size_t *count)
+{
+    mem_flash_t *f = ctx;
+    if (!f->present[seq % 16]) {
+        return -1;
+    }
+    *count = f->counts[seq % 16] < max ? f->counts[seq % 16] : max;
+    memcpy(records, f->segments[seq % 16], *count * sizeof(*records));
+    return 0;
+}
+
+static int mem_erase(void *ctx, uint32_t seq)
+{
+    mem_flash_t *f = ctx;
+    f->present[seq % 16] = false;
+    return 0;
+}
+
+static mem_flash_t s_flash;
+static store_forward_storage_t s_storage = {
+    mem_load_range, mem_save_range, mem_write, mem_read, mem_erase, &s_flash
+};
+static store_forward_record_t s_ram[TEST_RAM];
+static store_forward_record_t s_spill[TEST_SEG];
+static store_forward_record_t s_replay[TEST_SEG];
+
+static void init_queue(store_forward_t *q, bool with_flash)
+{
+    store_forward_config_t cfg = {
+        .ram = s_ram,
+        .ram_capacity = TEST_RAM,
+        .spill_buf = s_spill,
+        .replay_buf = s_replay,
+        .segment_records = TEST_SEG,
+        .max_segments = TEST_MAX_SEGMENTS,
+        .storage = with_flash ? &s_storage : NULL,
+    };
+    TEST_ASSERT_EQUAL_INT(0, store_forward_init(q, &cfg));
+}
+
+static void push_n(store_forward_t *q, int first, int count)
+{
+    for (int i = first; i < first + count; i++) {
+        store_forward_record_t r = {0};
+        r.timestamp = 1000 + i;
+        r.temp_centi = (int16_t)i;
+        store_forward_push(q, &r);
+    }
+}
+
+/* Pop everything, returning the sequence of temp_centi values */
+static int drain(store_forward_t *q, int *out, int max)
+{
+    int n = 0;
+    store_forward_record_t r;
+    while (n < max && store_forward_peek(q, &r) == 0) {
+        out[n++] = r.temp_centi;
+        store_forward_pop(q);
+    }
+    return n;
+}
+
+/* ===== RAM Tests ===== */
+
+void test_store_forward_empty(void)
+{
+    store_forward_t q;
+    store_forward_record_t r;
+    init_queue(&q, false);
+
+    TEST_ASSERT_EQUAL_INT(-1, store_forward_peek(&q, &r));
+    TEST_ASSERT_EQUAL_INT(0, store_forward_depth(&q));
+}
+
+void test_store_forward_fifo_order(void)
+{
+    store_forward_t q;
+    int out[16];
+    init_queue(&q, false);
+    push_n(&q, 0, 5);
+
+    TEST_ASSERT_EQUAL_INT(5, store_forward_depth(&q));
+    TEST_ASSERT_EQUAL_INT(5, drain(&q, out, 16));
+    for (int i = 0; i < 5; i++) {
+        TEST_ASSERT_EQUAL_INT(i, out[i]);
+    }
+    TEST_ASSERT_EQUAL_INT(5, q.replayed);
+}
+
+void test_store_forward_ram_only_drops_oldest(void)
+{
+    store_forward_t q;
+    int out[16];
+    init_queue(&q, false);
+    push_n(&q, 0, TEST_RAM + 3);
+
+    TEST_ASSERT_EQUAL_INT(TEST_RAM, store_forward_depth(&q));
+    TEST_ASSERT_EQUAL_INT(3, q.dropped);
+    TEST_ASSERT_EQUAL_INT(TEST_RAM, drain(&q, out, 16));
+    TEST_ASSERT_EQUAL_INT(3, out[0]);
+    TEST_ASSERT_EQUAL_INT(TEST_RAM + 2, out[TEST_RAM - 1]);
+}
+
+void test_store_forward_rejects_bad_config(void)
+{
+    store_forward_t q;
+    store_forward_config_t cfg = {
+        .ram = s_ram,
+        .ram_capacity = 2,
+        .spill_buf = s_spill,
+        .replay_buf = s_replay,
+        .segment_records = TEST_SEG,  /* Larger than the RAM ring */
+        .max_segments = 1,
+        .storage = &s_storage,
+    };
+    TEST_ASSERT_EQUAL_INT(-1, store_forward_init(&q, &cfg));
+}
+
+/* ===== Flash Spill Tests ===== */
+
+void test_store_forward_spills_to_flash(void)
+{
+    store_forward_t q;
+    int out[32];
+    memset(&s_flash, 0, sizeof(s_flash));
+    init_queue(&q, true);
+    push_n(&q, 0, TEST_RAM + 1);
+
+    TEST_ASSERT_EQUAL_INT(1, s_flash.writes);
+    TEST_ASSERT_EQUAL_INT(TEST_SEG, store_forward_flash_depth(&q));
+    TEST_ASSERT_EQUAL_INT(TEST_RAM + 1, store_forward_depth(&q));
+    TEST_ASSERT_EQUAL_INT(0, q.dropped);
+
+    /* Flash records come out first, then RAM, in push order */
+    TEST_ASSERT_EQUAL_INT(TEST_RAM + 1, drain(&q, out, 32));
+    for (int i = 0; i < TEST_RAM + 1; i++) {
+        TEST_ASSERT_EQUAL_INT(i, out[i]);
+    }
+    TEST_ASSERT_EQUAL_INT(1, s_flash.head);
+    TEST_ASSERT_EQUAL_INT(1, s_flash.tail);
+    TEST_ASSERT_FALSE(s_flash.present[0]);
+}
+
+void test_store_forward_flash_full_drops_oldest_segment(void)
+{
+    store_forward_t q;
+    int out[32];
+    memset(&s_flash, 0, sizeof(s_flash));
+    init_queue(&q, true);
+
+    /* RAM + max segments, plus one more segment's worth */
+    int total = TEST_RAM + (TEST_MAX_SEGMENTS + 1) * TEST_SEG;
+    push_n(&q, 0, total);
+
+    TEST_ASSERT_EQUAL_INT(TEST_SEG, q.dropped);
+    TEST_ASSERT_EQUAL_INT(total - TEST_SEG, store_forward_depth(&q));
+    TEST_ASSERT_EQUAL_INT(total - TEST_SEG, drain(&q, out, 32));
+    TEST_ASSERT_EQUAL_INT(TEST_SEG, out[0]);
+    TEST_ASSERT_EQUAL_INT(total - 1, out[total - TEST_SEG - 1]);
+}
+
+void test_store_forward_write_failure_counts_dropped(void)
+{
+    store_forward_t q;
+    memset(&s_flash, 0, sizeof(s_flash));
+    s_flash.fail_writes = true;
+    init_queue(&q, true);
+    push_n(&q, 0, TEST_RAM + 1);
+
+    TEST_ASSERT_EQUAL_INT(TEST_SEG, q.dropped);
+    TEST_ASSERT_EQUAL_INT(TEST_RAM + 1 - TEST_SEG, store_forward_depth(&q));
+}
+
+void test_store_forward_push_during_flash_replay(void)
+{
+    store_forward_t q;
+    int out[32];
+    memset(&s_flash, 0, sizeof(s_flash));
+    init_queue(&q, true);
+    push_n(&q, 0, TEST_RAM + TEST_SEG);  /* One segment in flash, RAM full */
+
+    /* Consume part of the flash segment, then overflow RAM again */
+    store_forward_record_t r;
+    TEST_ASSERT_EQUAL_INT(0, store_forward_peek(&q, &r));
+    store_forward_pop(&q);
+    push_n(&q, 100, 1);
+
+    TEST_ASSERT_EQUAL_INT(TEST_RAM + TEST_SEG, store_forward_depth(&q));
+    int n = drain(&q, out, 32);
+    TEST_ASSERT_EQUAL_INT(TEST_RAM + TEST_SEG, n);
+    TEST_ASSERT_EQUAL_INT(1, out[0]);
+    TEST_ASSERT_EQUAL_INT(100, out[n - 1]);
+}
+
+void test_store_forward_resumes_after_reboot(void)
+{
+    store_forward_t q;
+    memset(&s_flash, 0, sizeof(s_flash));
+    init_queue(&q, true);
+    push_n(&q, 0, TEST_RAM + TEST_SEG);
+
+    /* Reboot: RAM contents are lost, flash segments survive */
+    init_queue(&q, true);
+    TEST_ASSERT_EQUAL_INT(TEST_SEG, store_forward_depth(&q));
+
+    store_forward_record_t r;
+    TEST_ASSERT_EQUAL_INT(0, store_forward_peek(&q, &r));
+    TEST_ASSERT_EQUAL_INT(0, r.temp_centi);
+    TEST_ASSERT_TRUE(r.flags & STORE_FORWARD_FLAG_PREVIOUS_BOOT);
+
+    /* Records spilled after boot are not flagged */
+    int out[32];
+    drain(&q, out, 32);
+    push_n(&q, 50, TEST_RAM + 1);
+    TEST_ASSERT_EQUAL_INT(0, store_forward_peek(&q, &r));
+    TEST_ASSERT_EQUAL_INT(50, r.temp_centi);
+    TEST_ASSERT_FALSE(r.flags & STORE_FORWARD_FLAG_PREVIOUS_BOOT);
+}
+
+void test_store_forward_unreadable_segment_skipped(void)
+{
+    store_forward_t q;
+    int out[32];
+    memset(&s_flash, 0, sizeof(s_flash));
+    init_queue(&q, true);
+    push_n(&q, 0, TEST_RAM + 2 * TEST_SEG);  /* Two segments in flash */
+    s_flash.present[0] = false;              /* First segment corrupted */
+
+    int n = drain(&q, out, 32);
+    TEST_ASSERT_EQUAL_INT(TEST_RAM + TEST_SEG, n);
+    TEST_ASSERT_EQUAL_INT(TEST_SEG, out[0]);
+    TEST_ASSERT_EQUAL_INT(TEST_SEG, q.dropped);
+}
+
+/* ===== Test Runner ===== */
+
+void run_store_forward_tests(void)
+{
+    RUN_TEST(test_store_forward_empty);
+    RUN_TEST(test_store_forward_fifo_order);
+    RUN_TEST(test_store_forward_ram_only_drops_oldest);
+    RUN_TEST(test_store_forward_rejects_bad_config);
+    RUN_TEST(test_store_forward_spills_to_flash);
+    RUN_TEST(test_store_forward_flash_full_drops_oldest_segment);
+    RUN_TEST(test_store_forward_write_failure_counts_dropped);
+    RUN_TEST(test_store_forward_push_during_flash_replay);
+    RUN_TEST(test_store_forward_resumes_after_reboot);
+    RUN_TEST(test_store_forward_unreadable_segment_skipped);
+}
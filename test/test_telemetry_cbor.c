@@ -0,0 +1,239 @@
+/**
+ * @file test_telemetry_cbor.c
+ * @brief Unit tests for the CBOR writer and telemetry batch schema
+ */
+
+#include "unity.h"
+#include "cbor_writer.h"
+#include "telemetry_cbor.h"
+#include "cbor_decode.h"
+#include <string.h>
+
+static uint8_t s_buf[1024];
+
+static int encode_uint(uint64_t value)
+{
+    cbor_writer_t w;
+    cbor_writer_init(&w, s_buf, sizeof(s_buf));
+    cbor_writer_uint(&w, value);
+    return cbor_writer_finish(&w);
+}
+
+static int encode_int(int64_t value)
+{
+    cbor_writer_t w;
+    cbor_writer_init(&w, s_buf, sizeof(s_buf));
+    cbor_writer_int(&w, value);
+    return cbor_writer_finish(&w);
+}
+
+/* ===== CBOR Writer Tests ===== */
+
+void test_cbor_uint_encodings(void)
+{
+    /* RFC 8949 Appendix A vectors */
+    TEST_ASSERT_EQUAL_INT(1, encode_uint(23));
+    TEST_ASSERT_EQUAL_INT(0x17, s_buf[0]);
+    TEST_ASSERT_EQUAL_INT(2, encode_uint(24));
+    TEST_ASSERT_EQUAL_INT(0x18, s_buf[0]);
+    TEST_ASSERT_EQUAL_INT(3, encode_uint(1000));
+    TEST_ASSERT_TRUE(memcmp(s_buf, "\x19\x03\xe8", 3) == 0);
+    TEST_ASSERT_EQUAL_INT(5, encode_uint(1000000));
+    TEST_ASSERT_TRUE(memcmp(s_buf, "\x1a\x00\x0f\x42\x40", 5) == 0);
+    TEST_ASSERT_EQUAL_INT(9, encode_uint(1000000000000ull));
+    TEST_ASSERT_TRUE(memcmp(s_buf, "\x1b\x00\x00\x00\xe8\xd4\xa5\x10\x00", 9) == 0);
+}
+
+void test_cbor_negative_encodings(void)
+{
+    TEST_ASSERT_EQUAL_INT(1, encode_int(-1));
+    TEST_ASSERT_EQUAL_INT(0x20, s_buf[0]);
+    TEST_ASSERT_EQUAL_INT(2, encode_int(-100));
+    TEST_ASSERT_TRUE(memcmp(s_buf, "\x38\x63", 2) == 0);
+    TEST_ASSERT_EQUAL_INT(3, encode_int(-1000));
+    TEST_ASSERT_TRUE(memcmp(s_buf, "\x39\x03\xe7", 3) == 0);
+    TEST_ASSERT_EQUAL_INT(9, encode_int(INT64_MIN));
+    TEST_ASSERT_TRUE(memcmp(s_buf, "\x3b\x7f\xff\xff\xff\xff\xff\xff\xff", 9) == 0);
+}
+
+void test_cbor_strings_and_containers(void)
+{
+    cbor_writer_t w;
+    cbor_writer_init(&w, s_buf, sizeof(s_buf));
+    cbor_writer_map(&w, 1);
+    cbor_writer_text(&w, "a");
+    cbor_writer_array(&w, 2);
+    cbor_writer_uint(&w, 1);
+    cbor_writer_bytes(&w, (const uint8_t *)"\x01\x02", 2);
+    TEST_ASSERT_EQUAL_INT(8, cbor_writer_finish(&w));
+    TEST_ASSERT_TRUE(memcmp(s_buf, "\xa1\x61\x61\x82\x01\x42\x01\x02", 8) == 0);
+}
+
+void test_cbor_indefinite_array(void)
+{
+    cbor_writer_t w;
+    cbor_writer_init(&w, s_buf, sizeof(s_buf));
+    cbor_writer_array_indefinite(&w);
+    cbor_writer_uint(&w, 1);
+    cbor_writer_uint(&w, 2);
+    cbor_writer_break(&w);
+    TEST_ASSERT_EQUAL_INT(4, cbor_writer_finish(&w));
+    TEST_ASSERT_TRUE(memcmp(s_buf, "\x9f\x01\x02\xff", 4) == 0);
+}
+
+void test_cbor_overflow_is_sticky(void)
+{
+    cbor_writer_t w;
+    cbor_writer_init(&w, s_buf, 4);
+    cbor_writer_uint(&w, 1000000);
+    cbor_writer_uint(&w, 1);
+    TEST_ASSERT_EQUAL_INT(-1, cbor_writer_finish(&w));
+}
+
+/* ===== Telemetry Schema Tests ===== */
+
+void test_telemetry_rom_id(void)
+{
+    const uint8_t rom[8] = { 0x28, 0xFF, 0x12, 0x34, 0x56, 0x78, 0x90, 0xAB };
+    uint8_t back[8];
+    TEST_ASSERT_TRUE(telemetry_rom_to_id(rom) == 0x28FF1234567890ABull);
+    telemetry_id_to_rom(0x28FF1234567890ABull, back);
+    TEST_ASSERT_TRUE(memcmp(rom, back, 8) == 0);
+}
+
+void test_telemetry_temp_rounding(void)
+{
+    TEST_ASSERT_EQUAL_INT(2150, telemetry_temp_to_centi(21.5f));
+    TEST_ASSERT_EQUAL_INT(2106, telemetry_temp_to_centi(21.0625f));
+    TEST_ASSERT_EQUAL_INT(-1006, telemetry_temp_to_centi(-10.0625f));
+    TEST_ASSERT_EQUAL_INT(0, telemetry_temp_to_centi(0.0f));
+}
+
+void test_telemetry_round_trip(void)
+{
+    telemetry_reading_t in[3] = {
+        { { 0x28, 0xFF, 0x12, 0x34, 0x56, 0x78, 0x90, 0xAB }, 2150, 1760000000 },
+        { { 0x28, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01 }, -5500, 1760000001 },
+        { { 0x28, 0xAA, 0xBB, 0xCC, 0xDD, 0xEE, 0xFF, 0x00 }, 12500, 0 },
+    };
+    telemetry_reading_t out[3];
+    uint32_t timestamp;
+    size_t count;
+
+    int len = telemetry_cbor_encode(s_buf, sizeof(s_buf), 1760000005, in, 3);
+    TEST_ASSERT_GREATER_THAN(0, len);
+    TEST_ASSERT_EQUAL_INT(0, telemetry_cbor_decode(s_buf, len, &timestamp, out, 3, &count));
+    TEST_ASSERT_EQUAL_INT(1760000005, (int)timestamp);
+    TEST_ASSERT_EQUAL_INT(3, (int)count);
+    for (int i = 0; i < 3; i++) {
+        TEST_ASSERT_TRUE(memcmp(in[i].rom, out[i].rom, 8) == 0);
+        TEST_ASSERT_EQUAL_INT(in[i].temp_centi, out[i].temp_centi);
+        TEST_ASSERT_EQUAL_INT((int)in[i].timestamp, (int)out[i].timestamp);
+    }
+}
+
+void test_telemetry_empty_batch(void)
+{
+    uint32_t timestamp;
+    size_t count = 99;
+    int len = telemetry_cbor_encode(s_buf, sizeof(s_buf), 0, NULL, 0);
+    TEST_ASSERT_EQUAL_INT(7, len);
+    TEST_ASSERT_EQUAL_INT(0, telemetry_cbor_decode(s_buf, len, &timestamp, NULL, 0, &count));
+    TEST_ASSERT_EQUAL_INT(0, (int)count);
+}
+
+void test_telemetry_stream_round_trip(void)
+{
+    const telemetry_reading_t in = { { 0x28, 0xFF, 0x12, 0x34, 0x56, 0x78, 0x90, 0xAB }, -5500, 1760000001 };
+    telemetry_reading_t out[2];
+    uint32_t timestamp;
+    size_t count;
+
+    cbor_writer_t w;
+    cbor_writer_init(&w, s_buf, sizeof(s_buf));
+    telemetry_cbor_begin_stream(&w, 1760000005);
+    TEST_ASSERT_TRUE(w.len <= TELEMETRY_CBOR_STREAM_HEADER_MAX);
+    telemetry_cbor_add(&w, &in);
+    telemetry_cbor_add(&w, &in);
+    telemetry_cbor_end_stream(&w);
+    int len = cbor_writer_finish(&w);
+    TEST_ASSERT_GREATER_THAN(0, len);
+    TEST_ASSERT_EQUAL_INT(0, telemetry_cbor_decode(s_buf, len, &timestamp, out, 2, &count));
+    TEST_ASSERT_EQUAL_INT(1760000005, (int)timestamp);
+    TEST_ASSERT_EQUAL_INT(2, (int)count);
+    TEST_ASSERT_TRUE(memcmp(in.rom, out[1].rom, 8) == 0);
+    TEST_ASSERT_EQUAL_INT(-5500, out[1].temp_centi);
+
+    /* More readings than the caller can hold, and a missing break */
+    TEST_ASSERT_EQUAL_INT(-1, telemetry_cbor_decode(s_buf, len, &timestamp, out, 1, &count));
+    TEST_ASSERT_EQUAL_INT(-1, telemetry_cbor_decode(s_buf, len - 1, &timestamp, out, 2, &count));
+}
+
+void test_telemetry_batch_size_bound(void)
+{
+    /* Worst case: large ids, negative temps beyond int16, full timestamps */
+    telemetry_reading_t in[20];
+    for (int i = 0; i < 20; i++) {
+        memset(in[i].rom, 0xFF, 8);
+        in[i].temp_centi = INT32_MIN;
+        in[i].timestamp = UINT32_MAX;
+    }
+    int len = telemetry_cbor_encode(s_buf, TELEMETRY_CBOR_BATCH_SIZE(20), UINT32_MAX, in, 20);
+    TEST_ASSERT_GREATER_THAN(0, len);
+    TEST_ASSERT_TRUE(len <= TELEMETRY_CBOR_BATCH_SIZE(20));
+}
+
+void test_telemetry_decode_rejects_bad_input(void)
+{
+    telemetry_reading_t in = { { 0x28, 1, 2, 3, 4, 5, 6, 7 }, 2000, 1760000000 };
+    telemetry_reading_t out[1];
+    uint32_t timestamp;
+    size_t count;
+    int len = telemetry_cbor_encode(s_buf, sizeof(s_buf), 1760000000, &in, 1);
+
+    /* Truncated */
+    TEST_ASSERT_EQUAL_INT(-1, telemetry_cbor_decode(s_buf, len - 1, &timestamp, out, 1, &count));
+    /* Too many readings for the output */
+    TEST_ASSERT_EQUAL_INT(-1, telemetry_cbor_decode(s_buf, len, &timestamp, out, 0, &count));
+    /* Unknown schema version */
+    s_buf[2] = TELEMETRY_CBOR_VERSION + 1;
+    TEST_ASSERT_EQUAL_INT(-1, telemetry_cbor_decode(s_buf, len, &timestamp, out, 1, &count));
+}
+
+void test_telemetry_decode_skips_unknown_keys(void)
+{
+    telemetry_reading_t out[1];
+    uint32_t timestamp;
+    size_t count;
+    cbor_writer_t w;
+    cbor_writer_init(&w, s_buf, sizeof(s_buf));
+    cbor_writer_map(&w, 3);
+    cbor_writer_uint(&w, 9);
+    cbor_writer_text(&w, "future");
+    cbor_writer_uint(&w, TELEMETRY_CBOR_KEY_VERSION);
+    cbor_writer_uint(&w, TELEMETRY_CBOR_VERSION);
+    cbor_writer_uint(&w, TELEMETRY_CBOR_KEY_READINGS);
+    cbor_writer_array(&w, 0);
+    int len = cbor_writer_finish(&w);
+    TEST_ASSERT_EQUAL_INT(0, telemetry_cbor_decode(s_buf, len, &timestamp, out, 1, &count));
+    TEST_ASSERT_EQUAL_INT(0, (int)timestamp);
+}
+
+/* ===== Test Runner ===== */
+
+void run_telemetry_cbor_tests(void)
+{
+    RUN_TEST(test_cbor_uint_encodings);
+    RUN_TEST(test_cbor_negative_encodings);
+    RUN_TEST(test_cbor_strings_and_containers);
+    RUN_TEST(test_cbor_indefinite_array);
+    RUN_TEST(test_cbor_overflow_is_sticky);
+    RUN_TEST(test_telemetry_rom_id);
+    RUN_TEST(test_telemetry_temp_rounding);
+    RUN_TEST(test_telemetry_round_trip);
+    RUN_TEST(test_telemetry_empty_batch);
+    RUN_TEST(test_telemetry_stream_round_trip);
+    RUN_TEST(test_telemetry_batch_size_bound);
+    RUN_TEST(test_telemetry_decode_rejects_bad_input);
+    RUN_TEST(test_telemetry_decode_skips_unknown_keys);
+}
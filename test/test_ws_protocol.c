@@ -0,0 +1,245 @@
+/**
+ * @file test_ws_protocol.c
+ * @brief Unit tests for WebSocket subscription commands and reading frames
+ */
+
+#include "unity.h"
+#include "ws_protocol.h"
+#include "cbor_decode.h"
+#include <stdio.h>
+#include <string.h>
+
+#define ADDR_A "28FF1234567890AB"
+#define ADDR_B "28AA000000000001"
+
+static ws_cmd_status_t apply(ws_subscription_t *sub, const char *msg)
+{
+    return ws_subscription_apply(sub, msg, strlen(msg));
+}
+
+/* ===== Subscription Tests ===== */
+
+void test_ws_subscribe_sensors(void)
+{
+    ws_subscription_t sub;
+    ws_subscription_init(&sub);
+    TEST_ASSERT_FALSE(ws_subscription_has_sensors(&sub));
+
+    TEST_ASSERT_EQUAL_INT(WS_CMD_OK, apply(&sub, "subscribe " ADDR_A " " ADDR_B));
+    TEST_ASSERT_EQUAL_INT(2, sub.count);
+    TEST_ASSERT_TRUE(ws_subscription_wants(&sub, 0x28FF1234567890ABULL));
+    TEST_ASSERT_TRUE(ws_subscription_wants(&sub, 0x28AA000000000001ULL));
+    TEST_ASSERT_FALSE(ws_subscription_wants(&sub, 0x2800000000000000ULL));
+
+    /* Subscribing twice does not use another slot */
+    TEST_ASSERT_EQUAL_INT(WS_CMD_OK, apply(&sub, "subscribe " ADDR_A));
+    TEST_ASSERT_EQUAL_INT(2, sub.count);
+}
+
+void test_ws_unsubscribe_sensor(void)
+{
+    ws_subscription_t sub;
+    ws_subscription_init(&sub);
+    apply(&sub, "subscribe " ADDR_A " " ADDR_B);
+
+    TEST_ASSERT_EQUAL_INT(WS_CMD_OK, apply(&sub, "unsubscribe " ADDR_A));
+    TEST_ASSERT_EQUAL_INT(1, sub.count);
+    TEST_ASSERT_FALSE(ws_subscription_wants(&sub, 0x28FF1234567890ABULL));
+    TEST_ASSERT_TRUE(ws_subscription_wants(&sub, 0x28AA000000000001ULL));
+
+    /* Unknown sensors are ignored */
+    TEST_ASSERT_EQUAL_INT(WS_CMD_OK, apply(&sub, "unsubscribe " ADDR_A));
+    TEST_ASSERT_EQUAL_INT(1, sub.count);
+}
+
+void test_ws_lowercase_address(void)
+{
+    ws_subscription_t sub;
+    ws_subscription_init(&sub);
+    TEST_ASSERT_EQUAL_INT(WS_CMD_OK, apply(&sub, "subscribe 28ff1234567890ab"));
+    TEST_ASSERT_TRUE(ws_subscription_wants(&sub, 0x28FF1234567890ABULL));
+}
+
+void test_ws_subscribe_all_and_logs(void)
+{
+    ws_subscription_t sub;
+    ws_subscription_init(&sub);
+    TEST_ASSERT_EQUAL_INT(WS_CMD_OK, apply(&sub, "  subscribe * logs\n"));
+    TEST_ASSERT_TRUE(sub.all_sensors);
+    TEST_ASSERT_TRUE(sub.logs);
+    TEST_ASSERT_TRUE(ws_subscription_wants(&sub, 0x2800000000000000ULL));
+
+    TEST_ASSERT_EQUAL_INT(WS_CMD_OK, apply(&sub, "unsubscribe logs"));
+    TEST_ASSERT_FALSE(sub.logs);
+    TEST_ASSERT_TRUE(sub.all_sensors);
+
+    /* "*" also clears individual subscriptions */
+    apply(&sub, "subscribe " ADDR_A);
+    TEST_ASSERT_EQUAL_INT(WS_CMD_OK, apply(&sub, "unsubscribe *"));
+    TEST_ASSERT_FALSE(ws_subscription_has_sensors(&sub));
+}
+
+void test_ws_subscription_limit(void)
+{
+    ws_subscription_t sub;
+    ws_subscription_init(&sub);
+    char msg[64];
+    for (int i = 0; i < WS_MAX_SENSOR_SUBSCRIPTIONS; i++) {
+        snprintf(msg, sizeof(msg), "subscribe 28000000000000%02X", i);
+        TEST_ASSERT_EQUAL_INT(WS_CMD_OK, apply(&sub, msg));
+    }
+    TEST_ASSERT_EQUAL_INT(WS_CMD_ERR_FULL, apply(&sub, "subscribe " ADDR_A));
+    TEST_ASSERT_EQUAL_INT(WS_MAX_SENSOR_SUBSCRIPTIONS, sub.count);
+
+    /* "*" needs no slot */
+    TEST_ASSERT_EQUAL_INT(WS_CMD_OK, apply(&sub, "subscribe *"));
+}
+
+/* ===== Command Error Tests ===== */
+
+void test_ws_command_errors(void)
+{
+    ws_subscription_t sub;
+    ws_subscription_init(&sub);
+    TEST_ASSERT_EQUAL_INT(WS_CMD_ERR_SYNTAX, apply(&sub, ""));
+    TEST_ASSERT_EQUAL_INT(WS_CMD_ERR_SYNTAX, apply(&sub, "subscribe"));
+    TEST_ASSERT_EQUAL_INT(WS_CMD_ERR_SYNTAX, apply(&sub, "listen " ADDR_A));
+    TEST_ASSERT_EQUAL_INT(WS_CMD_ERR_TARGET, apply(&sub, "subscribe 28FF12345678"));
+    TEST_ASSERT_EQUAL_INT(WS_CMD_ERR_TARGET, apply(&sub, "subscribe 28FF1234567890AZ"));
+    TEST_ASSERT_EQUAL_INT(WS_CMD_ERR_TARGET, apply(&sub, "subscribe events"));
+}
+
+void test_ws_partial_apply_on_error(void)
+{
+    ws_subscription_t sub;
+    ws_subscription_init(&sub);
+    TEST_ASSERT_EQUAL_INT(WS_CMD_ERR_TARGET, apply(&sub, "subscribe logs bogus " ADDR_A));
+    TEST_ASSERT_TRUE(sub.logs);
+    TEST_ASSERT_EQUAL_INT(0, sub.count);
+}
+
+void test_ws_command_not_terminated(void)
+{
+    /* Frame payloads are length-delimited */
+    ws_subscription_t sub;
+    ws_subscription_init(&sub);
+    const char *msg = "subscribe logsXYZ";
+    TEST_ASSERT_EQUAL_INT(WS_CMD_OK, ws_subscription_apply(&sub, msg, strlen("subscribe logs")));
+    TEST_ASSERT_TRUE(sub.logs);
+}
+
+void test_ws_format(void)
+{
+    ws_subscription_t sub;
+    ws_subscription_init(&sub);
+    TEST_ASSERT_EQUAL_INT(WS_FORMAT_JSON, sub.format);
+    TEST_ASSERT_EQUAL_INT(WS_CMD_OK, apply(&sub, "format binary"));
+    TEST_ASSERT_EQUAL_INT(WS_FORMAT_BINARY, sub.format);
+    TEST_ASSERT_EQUAL_INT(WS_CMD_ERR_SYNTAX, apply(&sub, "format xml"));
+    TEST_ASSERT_EQUAL_INT(WS_FORMAT_BINARY, sub.format);
+    TEST_ASSERT_EQUAL_INT(WS_CMD_OK, apply(&sub, "format json"));
+    TEST_ASSERT_EQUAL_INT(WS_FORMAT_JSON, sub.format);
+}
+
+void test_ws_status_strings(void)
+{
+    TEST_ASSERT_EQUAL_STRING("OK", ws_cmd_status_str(WS_CMD_OK));
+    TEST_ASSERT_EQUAL_STRING("Too many subscriptions", ws_cmd_status_str(WS_CMD_ERR_FULL));
+}
+
+/* ===== Frame Tests ===== */
+
+void test_ws_reading_json(void)
+{
+    char buf[128];
+    json_writer_t w;
+    json_writer_init(&w, buf, sizeof(buf), NULL, NULL);
+    ws_reading_t reading = { ADDR_A, 21.5f, true };
+    ws_write_reading_json(&w, &reading);
+    TEST_ASSERT_GREATER_THAN(0, json_writer_finish(&w));
+    TEST_ASSERT_EQUAL_STRING("{\"address\":\"" ADDR_A "\",\"temperature\":21.5,\"valid\":true}", buf);
+}
+
+void test_ws_reading_cbor(void)
+{
+    uint8_t buf[TELEMETRY_CBOR_BATCH_SIZE(1)];
+    cbor_writer_t w;
+    cbor_writer_init(&w, buf, sizeof(buf));
+    ws_reading_t reading = { ADDR_A, -3.25f, true };
+    TEST_ASSERT_TRUE(ws_write_reading_cbor(&w, &reading));
+    int len = cbor_writer_finish(&w);
+    TEST_ASSERT_GREATER_THAN(0, len);
+
+    uint32_t timestamp;
+    telemetry_reading_t decoded[2];
+    size_t count;
+    TEST_ASSERT_EQUAL_INT(0, telemetry_cbor_decode(buf, len, &timestamp, decoded, 2, &count));
+    TEST_ASSERT_EQUAL_INT(1, count);
+    TEST_ASSERT_EQUAL_INT(0, timestamp);
+    TEST_ASSERT_TRUE(telemetry_rom_to_id(decoded[0].rom) == 0x28FF1234567890ABULL);
+    TEST_ASSERT_EQUAL_INT(-325, decoded[0].temp_centi);
+}
+
+void test_ws_reading_cbor_skips_invalid(void)
+{
+    uint8_t buf[TELEMETRY_CBOR_BATCH_SIZE(1)];
+    cbor_writer_t w;
+    cbor_writer_init(&w, buf, sizeof(buf));
+    ws_reading_t reading = { ADDR_A, 0.0f, false };
+    TEST_ASSERT_FALSE(ws_write_reading_cbor(&w, &reading));
+}
+
+void test_ws_frame_header(void)
+{
+    uint8_t h[WS_FRAME_HEADER_MAX];
+    TEST_ASSERT_EQUAL_INT(2, (int)ws_frame_header(h, 0x1, 125));
+    TEST_ASSERT_EQUAL_INT(0x81, h[0]);
+    TEST_ASSERT_EQUAL_INT(125, h[1]);
+
+    TEST_ASSERT_EQUAL_INT(4, (int)ws_frame_header(h, 0x2, 2336));
+    TEST_ASSERT_EQUAL_INT(0x82, h[0]);
+    TEST_ASSERT_EQUAL_INT(126, h[1]);
+    TEST_ASSERT_EQUAL_INT(2336, (h[2] << 8) | h[3]);
+
+    TEST_ASSERT_EQUAL_INT(0, (int)ws_frame_header(h, 0x1, 70000));
+}
+
+void test_ws_utf8_boundary(void)
+{
+    /* "a", then e-acute (2 bytes), euro sign (3), emoji (4) */
+    const char *text = "a\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80";
+    TEST_ASSERT_EQUAL_INT(10, (int)ws_utf8_boundary(text, 10));
+    TEST_ASSERT_EQUAL_INT(6, (int)ws_utf8_boundary(text, 9));
+    TEST_ASSERT_EQUAL_INT(6, (int)ws_utf8_boundary(text, 8));
+    TEST_ASSERT_EQUAL_INT(6, (int)ws_utf8_boundary(text, 7));
+    TEST_ASSERT_EQUAL_INT(6, (int)ws_utf8_boundary(text, 6));
+    TEST_ASSERT_EQUAL_INT(3, (int)ws_utf8_boundary(text, 5));
+    TEST_ASSERT_EQUAL_INT(3, (int)ws_utf8_boundary(text, 4));
+    TEST_ASSERT_EQUAL_INT(1, (int)ws_utf8_boundary(text, 2));
+    TEST_ASSERT_EQUAL_INT(0, (int)ws_utf8_boundary("", 0));
+
+    /* Stray continuation bytes are not held back */
+    TEST_ASSERT_EQUAL_INT(5, (int)ws_utf8_boundary("\x80\x80\x80\x80\x80", 5));
+    TEST_ASSERT_EQUAL_INT(2, (int)ws_utf8_boundary("a\x80", 2));
+}
+
+/* ===== Test Runner ===== */
+
+void run_ws_protocol_tests(void)
+{
+    RUN_TEST(test_ws_subscribe_sensors);
+    RUN_TEST(test_ws_unsubscribe_sensor);
+    RUN_TEST(test_ws_lowercase_address);
+    RUN_TEST(test_ws_subscribe_all_and_logs);
+    RUN_TEST(test_ws_subscription_limit);
+    RUN_TEST(test_ws_command_errors);
+    RUN_TEST(test_ws_partial_apply_on_error);
+    RUN_TEST(test_ws_command_not_terminated);
+    RUN_TEST(test_ws_format);
+    RUN_TEST(test_ws_status_strings);
+    RUN_TEST(test_ws_reading_json);
+    RUN_TEST(test_ws_reading_cbor);
+    RUN_TEST(test_ws_reading_cbor_skips_invalid);
+    RUN_TEST(test_ws_frame_header);
+    RUN_TEST(test_ws_utf8_boundary);
+}